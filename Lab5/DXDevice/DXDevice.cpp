@@ -36,6 +36,7 @@ DXDevice::DXDevice() {
 	if (!found) {
 		throw std::runtime_error("Failed to find suitable device");
 	}
+	stateCache = new DXStateCache(deviceContext);
 	initializeDxgi();
 }
 
@@ -96,11 +97,16 @@ ID3D11DeviceContext* DXDevice::getDeviceContext() {
 	return deviceContext;
 }
 
+DXStateCache* DXDevice::getStateCache() {
+	return stateCache;
+}
+
 
 DXDevice::~DXDevice() {
 	dxgiDevice->Release();
 	dxgiAdapter->Release();
 	dxgiFactory->Release();
+	delete stateCache;
 	deviceContext->Flush();
 	deviceContext->Release();
 	device->Release();
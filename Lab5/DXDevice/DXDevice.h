@@ -4,6 +4,7 @@
 #include <cstdint>
 #include <stdexcept>
 #include "DXSwapChain.h"
+#include "DXStateCache.h"
 #include "../Window/Window.h"
 #include <map>
 
@@ -15,6 +16,7 @@ private:
 	ID3D11Device* device = nullptr;
 	D3D_FEATURE_LEVEL featureLevel;
 	ID3D11DeviceContext* deviceContext = nullptr;
+	DXStateCache* stateCache = nullptr;
 	IDXGIDevice* dxgiDevice = nullptr;
 	IDXGIAdapter* dxgiAdapter = nullptr;
 	IDXGIFactory* dxgiFactory = nullptr;
@@ -22,6 +24,7 @@ private:
 public:
 	DXSwapChain* getSwapChain(Window* window, const char* possibleName = nullptr);
 	ID3D11DeviceContext* getDeviceContext();
+	DXStateCache* getStateCache();
 	ID3D11Device* getDevice();
 	static void unBindRenderTargets(ID3D11DeviceContext* context);
 private:
@@ -2,6 +2,9 @@
 #include <sstream>
 #include <stdexcept>
 
+#include "../Engine/RenderDevice/D3D11RenderDevice.h"
+#include "../Utils/MemoryAccounting.h"
+
 D3D11_TEXTURE2D_DESC depthTextureDesc{
     800, 600, 1, 1, DXGI_FORMAT_D24_UNORM_S8_UINT, {1, 0}, D3D11_USAGE_DEFAULT, D3D11_BIND_DEPTH_STENCIL, 0, 0
 };
@@ -19,6 +22,7 @@ DXRenderTargetView::DXRenderTargetView(ID3D11Device* device, uint32_t colorAttac
                                                                             }), depthCreatedInside(true),
                                                                             colorCreatedInside(true)
 {
+    memoryCategory = name ? name : memoryCategory;
     createColorAttachment(colorAttachmentCount, width, height);
     createDepthAttachment(width, height);
     createRenderTarget(name);
@@ -31,6 +35,7 @@ DXRenderTargetView::DXRenderTargetView(ID3D11Device* device, std::vector<ID3D11T
     colorAttachments(colorAttachment), vp(D3D11_VIEWPORT{(FLOAT)width, (FLOAT)height, 0.0, 1.0f}),
     depthCreatedInside(true)
 {
+    memoryCategory = name ? name : memoryCategory;
     createDepthAttachment(width, height);
     createRenderTarget(name);
     createDepthStencilView(name);
@@ -50,6 +55,7 @@ DXRenderTargetView::DXRenderTargetView(ID3D11Device* device, ID3D11Texture2D* te
                                                            vp(D3D11_VIEWPORT{800.0f, 600.0f, 0.0, 1.0f}),
                                                            depthCreatedInside(true)
 {
+    memoryCategory = name ? name : memoryCategory;
     colorAttachments.push_back(textureArray);
     createDepthAttachment(width, height);
     createRenderTargetForTextureArray(elementAmount, name);
@@ -213,6 +219,9 @@ void DXRenderTargetView::createColorAttachment(uint32_t colorAttachmentCount, ui
         {
             throw std::runtime_error("Failed to create color attachment");
         }
+        uint64_t bytes = RenderDevice::getTextureBytes(D3D11RenderDevice::describeTexture(colorTextureDesc));
+        allocatedBytes += bytes;
+        MemoryAccounting::allocate(memoryCategory, bytes);
     }
 }
 
@@ -224,6 +233,9 @@ void DXRenderTargetView::createDepthAttachment(uint32_t width, uint32_t height)
     {
         throw std::runtime_error("Failed to create depth attachment");
     }
+    uint64_t bytes = RenderDevice::getTextureBytes(D3D11RenderDevice::describeTexture(depthTextureDesc));
+    allocatedBytes += bytes;
+    MemoryAccounting::allocate(memoryCategory, bytes);
 }
 
 void DXRenderTargetView::createDepthStencilView(const char* name)
@@ -304,4 +316,6 @@ void DXRenderTargetView::destroy()
         depthAttachment->Release();
     }
     resourceViews.clear();
+    MemoryAccounting::release(memoryCategory, allocatedBytes);
+    allocatedBytes = 0;
 }
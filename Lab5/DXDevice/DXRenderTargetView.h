@@ -2,6 +2,7 @@
 
 #include <d3d11.h>
 #include <cstdint>
+#include <string>
 #include <vector>
 
 class DXRenderTargetView
@@ -22,6 +23,8 @@ private:
 
 	bool colorCreatedInside = false;
 	bool depthCreatedInside = false;
+	std::string memoryCategory = "Render targets";
+	uint64_t allocatedBytes = 0;
 public:
 	void bind(ID3D11DeviceContext* context, uint32_t width, uint32_t height, int curImage, bool bindDepthImages = true);
 	void clearColorAttachments(ID3D11DeviceContext* context, float r, float g, float b, float a, int currentImage);
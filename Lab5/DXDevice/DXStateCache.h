@@ -0,0 +1,6 @@
+#pragma once
+
+#include <d3d11.h>
+#include "StateCache.h"
+
+using DXStateCache = StateCache<ID3D11DeviceContext>;
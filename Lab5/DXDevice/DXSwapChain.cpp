@@ -45,6 +45,11 @@ uint32_t DXSwapChain::getCurrentImage() const
 	return curImageCounter;
 }
 
+ID3D11Texture2D* DXSwapChain::getBackBuffer() const
+{
+	return swapChainTextures[0];
+}
+
 DXSwapChain::~DXSwapChain() {
 	destroy();
 }
@@ -25,6 +25,7 @@ public:
 	void clearRenderTargets(ID3D11DeviceContext* context, float r, float g, float b, float a);
 	void present(bool vsync);
 	uint32_t getCurrentImage() const;
+	ID3D11Texture2D* getBackBuffer() const;
 
 	~DXSwapChain();
 private:
@@ -0,0 +1,261 @@
+#pragma once
+
+#include <cstdint>
+
+struct StateCacheStats
+{
+    uint32_t issued = 0;
+    uint32_t skipped = 0;
+};
+
+// Shadows the pipeline state last set on a D3D11-style context and drops calls that would not change it. The context
+// is a template parameter so the filtering can be exercised against a recording mock. Shader resources are not
+// tracked: the runtime unbinds them by itself when their resource is bound as a render target. Code that changes
+// tracked state behind the cache's back must call invalidate().
+template <typename Context>
+class StateCache
+{
+public:
+    static const uint32_t SAMPLER_SLOT_COUNT = 16;
+
+    explicit StateCache(Context* context) : context(context)
+    {
+        invalidate();
+    }
+
+private:
+    enum TrackedState
+    {
+        VERTEX_SHADER,
+        PIXEL_SHADER,
+        COMPUTE_SHADER,
+        INPUT_LAYOUT,
+        PRIMITIVE_TOPOLOGY,
+        DEPTH_STENCIL_STATE,
+        RASTERIZER_STATE,
+        BLEND_STATE,
+        TRACKED_STATE_COUNT
+    };
+
+    enum SamplerStage
+    {
+        VERTEX_STAGE,
+        PIXEL_STAGE,
+        COMPUTE_STAGE,
+        SAMPLER_STAGE_COUNT
+    };
+
+    struct Shadow
+    {
+        uintptr_t value = 0;
+        bool known = false;
+    };
+
+    Context* context;
+    Shadow states[TRACKED_STATE_COUNT];
+    uint32_t stencilRef = 0;
+    float blendFactor[4] = {};
+    uint32_t sampleMask = 0;
+    Shadow samplers[SAMPLER_STAGE_COUNT][SAMPLER_SLOT_COUNT];
+    StateCacheStats frameStats;
+    StateCacheStats lastFrameStats;
+
+public:
+    template <typename Shader>
+    void setVertexShader(Shader* shader)
+    {
+        if (update(VERTEX_SHADER, (uintptr_t)shader))
+        {
+            context->VSSetShader(shader, nullptr, 0);
+        }
+    }
+
+    template <typename Shader>
+    void setPixelShader(Shader* shader)
+    {
+        if (update(PIXEL_SHADER, (uintptr_t)shader))
+        {
+            context->PSSetShader(shader, nullptr, 0);
+        }
+    }
+
+    template <typename Shader>
+    void setComputeShader(Shader* shader)
+    {
+        if (update(COMPUTE_SHADER, (uintptr_t)shader))
+        {
+            context->CSSetShader(shader, nullptr, 0);
+        }
+    }
+
+    template <typename InputLayout>
+    void setInputLayout(InputLayout* inputLayout)
+    {
+        if (update(INPUT_LAYOUT, (uintptr_t)inputLayout))
+        {
+            context->IASetInputLayout(inputLayout);
+        }
+    }
+
+    template <typename Topology>
+    void setPrimitiveTopology(Topology topology)
+    {
+        if (update(PRIMITIVE_TOPOLOGY, (uintptr_t)topology))
+        {
+            context->IASetPrimitiveTopology(topology);
+        }
+    }
+
+    template <typename DepthStencilState>
+    void setDepthStencilState(DepthStencilState* state, uint32_t newStencilRef)
+    {
+        bool changed = newStencilRef != stencilRef || !states[DEPTH_STENCIL_STATE].known;
+        if (update(DEPTH_STENCIL_STATE, (uintptr_t)state, changed))
+        {
+            stencilRef = newStencilRef;
+            context->OMSetDepthStencilState(state, newStencilRef);
+        }
+    }
+
+    template <typename RasterizerState>
+    void setRasterizerState(RasterizerState* state)
+    {
+        if (update(RASTERIZER_STATE, (uintptr_t)state))
+        {
+            context->RSSetState(state);
+        }
+    }
+
+    // A null blend factor means {1, 1, 1, 1}, as in OMSetBlendState.
+    template <typename BlendState>
+    void setBlendState(BlendState* state, const float* newBlendFactor, uint32_t newSampleMask)
+    {
+        const float defaultFactor[4] = {1.0f, 1.0f, 1.0f, 1.0f};
+        const float* factor = newBlendFactor ? newBlendFactor : defaultFactor;
+        bool changed = newSampleMask != sampleMask || !states[BLEND_STATE].known;
+        for (uint32_t i = 0; i < 4; i++)
+        {
+            changed |= factor[i] != blendFactor[i];
+        }
+        if (update(BLEND_STATE, (uintptr_t)state, changed))
+        {
+            for (uint32_t i = 0; i < 4; i++)
+            {
+                blendFactor[i] = factor[i];
+            }
+            sampleMask = newSampleMask;
+            context->OMSetBlendState(state, newBlendFactor, newSampleMask);
+        }
+    }
+
+    template <typename SamplerState>
+    void setVertexSamplers(uint32_t startSlot, uint32_t count, SamplerState* const* pSamplers)
+    {
+        uint32_t first;
+        uint32_t changedCount;
+        if (updateSamplers(VERTEX_STAGE, startSlot, count, (const void* const*)pSamplers, &first, &changedCount))
+        {
+            context->VSSetSamplers(startSlot + first, changedCount, pSamplers + first);
+        }
+    }
+
+    template <typename SamplerState>
+    void setPixelSamplers(uint32_t startSlot, uint32_t count, SamplerState* const* pSamplers)
+    {
+        uint32_t first;
+        uint32_t changedCount;
+        if (updateSamplers(PIXEL_STAGE, startSlot, count, (const void* const*)pSamplers, &first, &changedCount))
+        {
+            context->PSSetSamplers(startSlot + first, changedCount, pSamplers + first);
+        }
+    }
+
+    template <typename SamplerState>
+    void setComputeSamplers(uint32_t startSlot, uint32_t count, SamplerState* const* pSamplers)
+    {
+        uint32_t first;
+        uint32_t changedCount;
+        if (updateSamplers(COMPUTE_STAGE, startSlot, count, (const void* const*)pSamplers, &first, &changedCount))
+        {
+            context->CSSetSamplers(startSlot + first, changedCount, pSamplers + first);
+        }
+    }
+
+    void invalidate()
+    {
+        for (Shadow& state : states)
+        {
+            state.known = false;
+        }
+        for (auto& stage : samplers)
+        {
+            for (Shadow& sampler : stage)
+            {
+                sampler.known = false;
+            }
+        }
+    }
+
+    void beginFrame()
+    {
+        lastFrameStats = frameStats;
+        frameStats = {};
+    }
+
+    // Counts of the last completed frame; every set call counts once.
+    StateCacheStats getFrameStats() const
+    {
+        return lastFrameStats;
+    }
+
+    Context* getContext() const
+    {
+        return context;
+    }
+
+private:
+    bool update(TrackedState state, uintptr_t value, bool forceChange = false)
+    {
+        Shadow& shadow = states[state];
+        if (!forceChange && shadow.known && shadow.value == value)
+        {
+            frameStats.skipped++;
+            return false;
+        }
+        shadow.value = value;
+        shadow.known = true;
+        frameStats.issued++;
+        return true;
+    }
+
+    // Narrows the call to the smallest slot range that actually changes.
+    bool updateSamplers(SamplerStage stage, uint32_t startSlot, uint32_t count, const void* const* pSamplers,
+                        uint32_t* pFirst, uint32_t* pCount)
+    {
+        uint32_t first = count;
+        uint32_t last = 0;
+        for (uint32_t i = 0; i < count; i++)
+        {
+            Shadow& shadow = samplers[stage][startSlot + i];
+            if (!shadow.known || shadow.value != (uintptr_t)pSamplers[i])
+            {
+                if (first == count)
+                {
+                    first = i;
+                }
+                last = i;
+                shadow.value = (uintptr_t)pSamplers[i];
+                shadow.known = true;
+            }
+        }
+        if (first == count)
+        {
+            frameStats.skipped++;
+            return false;
+        }
+        *pFirst = first;
+        *pCount = last - first + 1;
+        frameStats.issued++;
+        return true;
+    }
+};
@@ -1,23 +1,28 @@
 #include "ConstantBuffer.h"
+#include <cstring>
 #include <stdexcept>
 
-ConstantBuffer::ConstantBuffer(ID3D11Device* device, void* initData, size_t initDataSize, const char* bufferName)
+ConstantBuffer::ConstantBuffer(ConstantRing* ring, void* initData, size_t initDataSize, const char* bufferName)
+    : ring(ring),
+      dataSize(initDataSize)
 {
     size_t cBufferSize;
     for (cBufferSize = initDataSize; cBufferSize % 16 != 0; cBufferSize++);
+    data.resize(cBufferSize);
+    memcpy(data.data(), initData, initDataSize);
 
+    if (ring->isOffsetBindingSupported()) {
+        return;
+    }
 
 	D3D11_BUFFER_DESC bufferDesc = {};
-	bufferDesc.Usage = D3D11_USAGE_DEFAULT;
+	bufferDesc.Usage = D3D11_USAGE_DYNAMIC;
 	bufferDesc.ByteWidth = (UINT)cBufferSize;
 	bufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-	bufferDesc.CPUAccessFlags = 0;
+	bufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
 	bufferDesc.MiscFlags = 0;
 
-	D3D11_SUBRESOURCE_DATA init_data = {};
-	init_data.pSysMem = initData;
-
-    if (FAILED(device->CreateBuffer(&bufferDesc, &init_data, &buffer))) {
+    if (FAILED(ring->getDevice()->CreateBuffer(&bufferDesc, nullptr, &buffer))) {
         throw std::runtime_error("Failed to create constant buffer");
     }
     
@@ -30,16 +35,75 @@ ConstantBuffer::ConstantBuffer(ID3D11Device* device, void* initData, size_t init
 
 void ConstantBuffer::updateData(ID3D11DeviceContext* context, void* newData)
 {
-    context->UpdateSubresource(buffer, NULL, nullptr, newData, NULL, NULL);
+    if (memcmp(data.data(), newData, dataSize) != 0) {
+        memcpy(data.data(), newData, dataSize);
+        dirty = true;
+    }
+}
+
+void ConstantBuffer::upload(ID3D11DeviceContext* context)
+{
+    if (!buffer) {
+        // A ring reset drops everything written before it, changed or not.
+        if (!dirty && allocationGeneration == ring->getGeneration()) {
+            ring->countSkippedUpload();
+            return;
+        }
+        allocation = ring->upload(data.data(), (uint32_t)data.size());
+        allocationGeneration = ring->getGeneration();
+    }
+    else {
+        if (!dirty) {
+            ring->countSkippedUpload();
+            return;
+        }
+        D3D11_MAPPED_SUBRESOURCE mapped;
+        if (FAILED(context->Map(buffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped))) {
+            throw std::runtime_error("Failed to map constant buffer");
+        }
+        memcpy(mapped.pData, data.data(), data.size());
+        context->Unmap(buffer, 0);
+        ring->countUpload((uint32_t)data.size());
+    }
+    dirty = false;
 }
 
 void ConstantBuffer::bindToVertexShader(ID3D11DeviceContext* context, uint32_t slot) {
-    context->VSSetConstantBuffers(slot, 1, &buffer);
+    upload(context);
+    if (buffer) {
+        context->VSSetConstantBuffers(slot, 1, &buffer);
+        return;
+    }
+    ID3D11Buffer* ringBuffer = ring->getBuffer();
+    UINT firstConstant = allocation.offset / 16;
+    UINT constantCount = allocation.size / 16;
+    ring->getDeviceContext()->VSSetConstantBuffers1(slot, 1, &ringBuffer, &firstConstant, &constantCount);
 }
 void ConstantBuffer::bindToPixelShader(ID3D11DeviceContext* context, uint32_t slot) {
-    context->PSSetConstantBuffers(slot, 1, &buffer);
+    upload(context);
+    if (buffer) {
+        context->PSSetConstantBuffers(slot, 1, &buffer);
+        return;
+    }
+    ID3D11Buffer* ringBuffer = ring->getBuffer();
+    UINT firstConstant = allocation.offset / 16;
+    UINT constantCount = allocation.size / 16;
+    ring->getDeviceContext()->PSSetConstantBuffers1(slot, 1, &ringBuffer, &firstConstant, &constantCount);
+}
+void ConstantBuffer::bindToComputeShader(ID3D11DeviceContext* context, uint32_t slot) {
+    upload(context);
+    if (buffer) {
+        context->CSSetConstantBuffers(slot, 1, &buffer);
+        return;
+    }
+    ID3D11Buffer* ringBuffer = ring->getBuffer();
+    UINT firstConstant = allocation.offset / 16;
+    UINT constantCount = allocation.size / 16;
+    ring->getDeviceContext()->CSSetConstantBuffers1(slot, 1, &ringBuffer, &firstConstant, &constantCount);
 }
 
 ConstantBuffer::~ConstantBuffer() {
-	buffer->Release();
-}
\ No newline at end of file
+    if (buffer) {
+	    buffer->Release();
+    }
+}
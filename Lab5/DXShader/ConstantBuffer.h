@@ -1,18 +1,30 @@
 #pragma once
 
 #include <cstdint>
+#include <vector>
 #include <d3d11.h>
+#include "ConstantRing.h"
 
 class ConstantBuffer
 {
 public:
-	ConstantBuffer(ID3D11Device* device, void* initData, size_t initDataSize, const char* bufferName = nullptr);
+	ConstantBuffer(ConstantRing* ring, void* initData, size_t initDataSize, const char* bufferName = nullptr);
 private:
-	ID3D11Buffer* buffer;
+	ConstantRing* ring;
+	// Only used when the device cannot bind ring offsets.
+	ID3D11Buffer* buffer = nullptr;
+	std::vector<uint8_t> data;
+	size_t dataSize;
+	RingAllocation allocation;
+	uint64_t allocationGeneration = 0;
+	bool dirty = true;
 public:
+	// Keeps a copy of the data; it is uploaded at the next bind, and only if it changed since the last upload.
 	void updateData(ID3D11DeviceContext* context, void* newData);
 	void bindToVertexShader(ID3D11DeviceContext* context, uint32_t slot = 0);
 	void bindToPixelShader(ID3D11DeviceContext* context, uint32_t slot = 0);
+	void bindToComputeShader(ID3D11DeviceContext* context, uint32_t slot = 0);
 	~ConstantBuffer();
+private:
+	void upload(ID3D11DeviceContext* context);
 };
-
@@ -0,0 +1,129 @@
+#include "ConstantRing.h"
+
+#include <cstring>
+#include <stdexcept>
+
+#include "../Utils/MemoryAccounting.h"
+
+ConstantRing::ConstantRing(ID3D11Device* device, ID3D11DeviceContext* deviceContext, uint32_t capacity)
+    : device(device),
+      allocator(capacity, ALIGNMENT)
+{
+    D3D11_FEATURE_DATA_D3D11_OPTIONS options = {};
+    if (SUCCEEDED(device->CheckFeatureSupport(D3D11_FEATURE_D3D11_OPTIONS, &options, sizeof(options))) &&
+        options.ConstantBufferOffsetting && options.MapNoOverwriteOnDynamicConstantBuffer &&
+        SUCCEEDED(deviceContext->QueryInterface(IID_PPV_ARGS(&this->deviceContext))))
+    {
+        offsetsSupported = true;
+        createBuffer(capacity);
+    }
+}
+
+void ConstantRing::createBuffer(uint32_t capacity)
+{
+    D3D11_BUFFER_DESC bufferDesc = {};
+    bufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+    bufferDesc.ByteWidth = capacity;
+    bufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+    bufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+    if (FAILED(device->CreateBuffer(&bufferDesc, nullptr, &buffer)))
+    {
+        throw std::runtime_error("Failed to create constant ring buffer");
+    }
+    MemoryAccounting::allocate("Constant ring", capacity);
+#if defined(_DEBUG)
+    const char bufferName[] = "Constant ring";
+    buffer->SetPrivateData(WKPDID_D3DDebugObjectName, sizeof(bufferName) - 1, bufferName);
+#endif
+}
+
+void ConstantRing::beginFrame()
+{
+    allocator.beginFrame();
+}
+
+RingAllocation ConstantRing::upload(const void* data, uint32_t size)
+{
+    RingAllocation allocation;
+    if (!allocator.allocate(size, &allocation))
+    {
+        // Ranges already bound this frame still point at the old buffer, which the context keeps alive, so the
+        // ring moves to a fresh buffer instead of discarding under them. It doubles once a frame needs half of it.
+        uint32_t capacity = allocator.getCapacity();
+        while (allocator.getFrameSize() + size > capacity / 2)
+        {
+            capacity *= 2;
+        }
+        buffer->Release();
+        MemoryAccounting::release("Constant ring", allocator.getCapacity());
+        createBuffer(capacity);
+        allocator.reset(capacity);
+        stats.bufferResets++;
+        allocator.allocate(size, &allocation);
+    }
+
+    D3D11_MAPPED_SUBRESOURCE mapped;
+    D3D11_MAP mapType = allocation.discard ? D3D11_MAP_WRITE_DISCARD : D3D11_MAP_WRITE_NO_OVERWRITE;
+    if (FAILED(deviceContext->Map(buffer, 0, mapType, 0, &mapped)))
+    {
+        throw std::runtime_error("Failed to map constant ring buffer");
+    }
+    memcpy((uint8_t*)mapped.pData + allocation.offset, data, size);
+    deviceContext->Unmap(buffer, 0);
+    countUpload(size);
+    return allocation;
+}
+
+bool ConstantRing::isOffsetBindingSupported() const
+{
+    return offsetsSupported;
+}
+
+uint64_t ConstantRing::getGeneration() const
+{
+    return allocator.getGeneration();
+}
+
+ID3D11Buffer* ConstantRing::getBuffer() const
+{
+    return buffer;
+}
+
+ID3D11Device* ConstantRing::getDevice() const
+{
+    return device;
+}
+
+ID3D11DeviceContext1* ConstantRing::getDeviceContext() const
+{
+    return deviceContext;
+}
+
+ConstantRingStats ConstantRing::getStats() const
+{
+    return stats;
+}
+
+void ConstantRing::countUpload(uint32_t size)
+{
+    stats.uploads++;
+    stats.uploadedBytes += size;
+}
+
+void ConstantRing::countSkippedUpload()
+{
+    stats.skippedUploads++;
+}
+
+ConstantRing::~ConstantRing()
+{
+    if (buffer)
+    {
+        buffer->Release();
+        MemoryAccounting::release("Constant ring", allocator.getCapacity());
+    }
+    if (deviceContext)
+    {
+        deviceContext->Release();
+    }
+}
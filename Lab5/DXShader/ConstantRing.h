@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <d3d11_1.h>
+#include "../Utils/RingAllocator.h"
+
+struct ConstantRingStats
+{
+    uint64_t uploads = 0;
+    uint64_t skippedUploads = 0;
+    uint64_t uploadedBytes = 0;
+    uint64_t bufferResets = 0;
+};
+
+// One large DYNAMIC constant buffer shared by every ConstantBuffer. Data is appended with NO_OVERWRITE maps and bound
+// through the D3D11.1 constant offsets; devices without offset binding get a small DYNAMIC buffer per ConstantBuffer.
+class ConstantRing
+{
+public:
+    static const uint32_t DEFAULT_CAPACITY = 64 * 1024;
+    // D3D11.1 binds constant ranges in units of 16 constants of 16 bytes.
+    static const uint32_t ALIGNMENT = 256;
+
+    ConstantRing(ID3D11Device* device, ID3D11DeviceContext* deviceContext, uint32_t capacity = DEFAULT_CAPACITY);
+
+private:
+    ID3D11Device* device;
+    ID3D11DeviceContext1* deviceContext = nullptr;
+    ID3D11Buffer* buffer = nullptr;
+    RingAllocator allocator;
+    bool offsetsSupported = false;
+    ConstantRingStats stats;
+
+public:
+    void beginFrame();
+    // Copies the data into the current buffer. The range stays valid while getGeneration() is unchanged.
+    RingAllocation upload(const void* data, uint32_t size);
+
+    bool isOffsetBindingSupported() const;
+    uint64_t getGeneration() const;
+    ID3D11Buffer* getBuffer() const;
+    ID3D11Device* getDevice() const;
+    ID3D11DeviceContext1* getDeviceContext() const;
+    ConstantRingStats getStats() const;
+    void countUpload(uint32_t size);
+    void countSkippedUpload();
+    ~ConstantRing();
+
+private:
+    void createBuffer(uint32_t capacity);
+};
@@ -1,8 +1,22 @@
 #include "D3DInclude.h"
 
+#include <filesystem>
+#include "../Utils/HashUtils.h"
+
+D3DInclude::D3DInclude(const std::string& rootDirectory) : rootDirectory(rootDirectory) {
+}
+
 HRESULT D3DInclude::Open(D3D_INCLUDE_TYPE IncludeType, LPCSTR pFileName, LPCVOID pParentData, LPCVOID* ppData, UINT* pBytes) {
+    auto parent = openDirectories.find(pParentData);
+    std::filesystem::path directory = parent != openDirectories.end() ? parent->second : rootDirectory;
+    std::filesystem::path path = directory / pFileName;
+
     FILE* pFile = nullptr;
-    fopen_s(&pFile, pFileName, "rb");
+    fopen_s(&pFile, path.string().c_str(), "rb");
+    if (pFile == nullptr) {
+        path = pFileName;
+        fopen_s(&pFile, pFileName, "rb");
+    }
     if (pFile == nullptr) {
         return E_FAIL;
     }
@@ -15,6 +29,9 @@ HRESULT D3DInclude::Open(D3D_INCLUDE_TYPE IncludeType, LPCSTR pFileName, LPCVOID
     fread(buffer, 1, size, pFile);
     fclose(pFile);
 
+    openDirectories[buffer] = path.parent_path().string();
+    dependencies.push_back({path.generic_string(), HashUtils::hashBytes(buffer, size)});
+
     *ppData = buffer;
     *pBytes = size;
 
@@ -22,6 +39,11 @@ HRESULT D3DInclude::Open(D3D_INCLUDE_TYPE IncludeType, LPCSTR pFileName, LPCVOID
 }
 
 HRESULT D3DInclude::Close(LPCVOID pData) {
-    free(const_cast<void*>(pData));
+    openDirectories.erase(pData);
+    delete[] static_cast<const char*>(pData);
     return S_OK;
-}
\ No newline at end of file
+}
+
+const std::vector<ShaderDependency>& D3DInclude::getDependencies() const {
+    return dependencies;
+}
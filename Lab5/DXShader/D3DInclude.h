@@ -1,11 +1,26 @@
 #pragma once
 
 #include <fstream>
+#include <map>
+#include <string>
+#include <vector>
 #include <d3dcompiler.h>
+#include "ShaderCache.h"
 
+// Resolves #include "..." relative to the including file (falling back to the working directory) and records every
+// file it opens with its content hash, so compiled shaders can be cached against all of their sources.
 class D3DInclude : public ID3DInclude {
 public:
+    explicit D3DInclude(const std::string& rootDirectory = std::string());
+
     HRESULT __stdcall Open(D3D_INCLUDE_TYPE IncludeType, LPCSTR pFileName, LPCVOID pParentData, LPCVOID* ppData, UINT* pBytes);
 
     HRESULT __stdcall Close(LPCVOID pData);
+
+    const std::vector<ShaderDependency>& getDependencies() const;
+
+private:
+    std::string rootDirectory;
+    std::map<LPCVOID, std::string> openDirectories;
+    std::vector<ShaderDependency> dependencies;
 };
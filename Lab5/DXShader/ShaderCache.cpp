@@ -0,0 +1,160 @@
+#include "ShaderCache.h"
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include "../Utils/HashUtils.h"
+
+namespace
+{
+    // Bounds for a sane entry; anything larger is treated as corruption instead of being allocated.
+    const uint32_t MAX_STRING_LENGTH = 4096;
+    const uint32_t MAX_DEPENDENCIES = 1024;
+    const uint64_t MAX_BYTECODE_SIZE = 64ull << 20;
+
+    void writeString(std::ostream& stream, const std::string& value)
+    {
+        uint32_t length = (uint32_t)value.size();
+        stream.write(reinterpret_cast<const char*>(&length), sizeof(length));
+        stream.write(value.data(), length);
+    }
+
+    bool readString(std::istream& stream, std::string* pValue)
+    {
+        uint32_t length = 0;
+        stream.read(reinterpret_cast<char*>(&length), sizeof(length));
+        if (!stream || length > MAX_STRING_LENGTH)
+        {
+            return false;
+        }
+        pValue->resize(length);
+        stream.read(&(*pValue)[0], length);
+        return (bool)stream;
+    }
+}
+
+ShaderCache::ShaderCache(const std::string& directory) : directory(directory)
+{
+}
+
+std::string ShaderCache::getEntryPath(const ShaderCacheKey& key) const
+{
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.cso", (unsigned long long)hashKey(key));
+    return (std::filesystem::path(directory) / name).string();
+}
+
+bool ShaderCache::load(const ShaderCacheKey& key, std::vector<char>* pBytecode) const
+{
+    ShaderCacheKey storedKey;
+    std::vector<ShaderDependency> dependencies;
+    if (!readEntry(getEntryPath(key), &storedKey, &dependencies, pBytecode))
+    {
+        return false;
+    }
+    // The name is only a hash, so the stored request is compared in full before the dependencies are rehashed.
+    return storedKey.sourcePath == key.sourcePath && storedKey.entryPoint == key.entryPoint &&
+        storedKey.profile == key.profile && storedKey.flags == key.flags && isUpToDate(dependencies);
+}
+
+bool ShaderCache::store(const ShaderCacheKey& key, const std::vector<ShaderDependency>& dependencies,
+                        const void* bytecode, size_t bytecodeSize) const
+{
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    std::string entryPath = getEntryPath(key);
+    std::string temporaryPath = entryPath + ".tmp";
+    {
+        std::ofstream file(temporaryPath, std::ios::binary);
+        if (!file)
+        {
+            return false;
+        }
+        ShaderCacheHeader header = {};
+        header.magic = MAGIC;
+        header.version = VERSION;
+        header.flags = key.flags;
+        header.dependencyCount = (uint32_t)dependencies.size();
+        header.keyHash = hashKey(key);
+        header.bytecodeSize = bytecodeSize;
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        writeString(file, key.sourcePath);
+        writeString(file, key.entryPoint);
+        writeString(file, key.profile);
+        for (const auto& dependency : dependencies)
+        {
+            writeString(file, dependency.path);
+            file.write(reinterpret_cast<const char*>(&dependency.hash), sizeof(dependency.hash));
+        }
+        file.write(static_cast<const char*>(bytecode), (std::streamsize)bytecodeSize);
+        if (!file)
+        {
+            return false;
+        }
+    }
+    // Written aside and renamed so a crash mid-write never leaves a truncated entry behind.
+    std::filesystem::rename(temporaryPath, entryPath, error);
+    return !error;
+}
+
+uint64_t ShaderCache::hashKey(const ShaderCacheKey& key)
+{
+    uint64_t hash = HashUtils::hashBytes(key.sourcePath.data(), key.sourcePath.size());
+    hash = HashUtils::hashBytes("", 1, hash);
+    hash = HashUtils::hashBytes(key.entryPoint.data(), key.entryPoint.size(), hash);
+    hash = HashUtils::hashBytes("", 1, hash);
+    hash = HashUtils::hashBytes(key.profile.data(), key.profile.size(), hash);
+    hash = HashUtils::hashBytes("", 1, hash);
+    hash = HashUtils::hashBytes(&key.flags, sizeof(key.flags), hash);
+    uint32_t version = VERSION;
+    return HashUtils::hashBytes(&version, sizeof(version), hash);
+}
+
+bool ShaderCache::readEntry(const std::string& entryPath, ShaderCacheKey* pKey,
+                            std::vector<ShaderDependency>* pDependencies, std::vector<char>* pBytecode)
+{
+    std::ifstream file(entryPath, std::ios::binary);
+    if (!file)
+    {
+        return false;
+    }
+    ShaderCacheHeader header = {};
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!file || header.magic != MAGIC || header.version != VERSION || header.dependencyCount > MAX_DEPENDENCIES ||
+        header.bytecodeSize > MAX_BYTECODE_SIZE)
+    {
+        return false;
+    }
+    pKey->flags = header.flags;
+    if (!readString(file, &pKey->sourcePath) || !readString(file, &pKey->entryPoint) ||
+        !readString(file, &pKey->profile) || hashKey(*pKey) != header.keyHash)
+    {
+        return false;
+    }
+    pDependencies->resize(header.dependencyCount);
+    for (auto& dependency : *pDependencies)
+    {
+        if (!readString(file, &dependency.path))
+        {
+            return false;
+        }
+        file.read(reinterpret_cast<char*>(&dependency.hash), sizeof(dependency.hash));
+    }
+    pBytecode->resize((size_t)header.bytecodeSize);
+    file.read(pBytecode->data(), (std::streamsize)header.bytecodeSize);
+    // A complete entry ends exactly after the bytecode.
+    return file && file.peek() == std::char_traits<char>::eof();
+}
+
+bool ShaderCache::isUpToDate(const std::vector<ShaderDependency>& dependencies)
+{
+    for (const auto& dependency : dependencies)
+    {
+        uint64_t hash = 0;
+        if (!HashUtils::hashFile(dependency.path, &hash) || hash != dependency.hash)
+        {
+            return false;
+        }
+    }
+    return !dependencies.empty();
+}
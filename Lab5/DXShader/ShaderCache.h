@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct ShaderCacheKey
+{
+    std::string sourcePath;
+    std::string entryPoint;
+    std::string profile;
+    uint32_t flags = 0;
+};
+
+struct ShaderDependency
+{
+    std::string path;
+    uint64_t hash = 0;
+};
+
+struct ShaderCacheHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t flags;
+    uint32_t dependencyCount;
+    uint64_t keyHash;
+    uint64_t bytecodeSize;
+};
+
+// On-disk bytecode cache. Entries are named after the compile request (source, entry point, profile, flags) and
+// record every file the compiler read with its content hash; an entry is only used while all of them still match.
+// Kept free of D3D so the manifest logic can be checked by Tools/ShaderCacheTool on any platform.
+class ShaderCache
+{
+public:
+    static const uint32_t MAGIC = 0x43524853; // "SHRC"
+    static const uint32_t VERSION = 1;
+
+    explicit ShaderCache(const std::string& directory);
+
+    std::string getEntryPath(const ShaderCacheKey& key) const;
+    bool load(const ShaderCacheKey& key, std::vector<char>* pBytecode) const;
+    bool store(const ShaderCacheKey& key, const std::vector<ShaderDependency>& dependencies, const void* bytecode,
+               size_t bytecodeSize) const;
+
+    static uint64_t hashKey(const ShaderCacheKey& key);
+    static bool readEntry(const std::string& entryPath, ShaderCacheKey* pKey,
+                          std::vector<ShaderDependency>* pDependencies, std::vector<char>* pBytecode);
+    static bool isUpToDate(const std::vector<ShaderDependency>& dependencies);
+
+private:
+    std::string directory;
+};
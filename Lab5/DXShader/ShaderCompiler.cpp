@@ -0,0 +1,83 @@
+#include "ShaderCompiler.h"
+
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <stdexcept>
+#include "D3DInclude.h"
+#include "ShaderCache.h"
+#include "../Utils/HashUtils.h"
+
+namespace
+{
+    const char* SHADER_CACHE_DIRECTORY = "ShaderCache";
+
+    ShaderCache shaderCache(SHADER_CACHE_DIRECTORY);
+    std::atomic<uint32_t> cacheHits{0};
+    std::atomic<uint32_t> compiled{0};
+}
+
+ID3DBlob* ShaderCompiler::compile(const wchar_t* path, const char* profile, const char* entryPoint)
+{
+    std::filesystem::path sourcePath(path);
+    ShaderCacheKey key;
+    key.sourcePath = sourcePath.generic_string();
+    key.entryPoint = entryPoint;
+    key.profile = profile;
+    key.flags = getDefaultFlags();
+
+    ID3DBlob* bytecode = nullptr;
+    std::vector<char> cachedBytecode;
+    if (shaderCache.load(key, &cachedBytecode) && SUCCEEDED(D3DCreateBlob(cachedBytecode.size(), &bytecode)))
+    {
+        memcpy(bytecode->GetBufferPointer(), cachedBytecode.data(), cachedBytecode.size());
+        cacheHits++;
+        return bytecode;
+    }
+
+    D3DInclude includeObj(sourcePath.parent_path().string());
+    ID3DBlob* errorBlob = nullptr;
+    HRESULT result = D3DCompileFromFile(path, nullptr, &includeObj, entryPoint, profile, key.flags, 0, &bytecode,
+                                        &errorBlob);
+    if (errorBlob != nullptr)
+    {
+        std::cerr << static_cast<const char*>(errorBlob->GetBufferPointer()) << std::endl;
+        errorBlob->Release();
+    }
+    if (FAILED(result) || bytecode == nullptr)
+    {
+        throw std::runtime_error("Failed to compile shader " + key.sourcePath);
+    }
+    compiled++;
+
+    std::vector<ShaderDependency> dependencies;
+    ShaderDependency source;
+    source.path = key.sourcePath;
+    if (HashUtils::hashFile(source.path, &source.hash))
+    {
+        dependencies.push_back(source);
+        dependencies.insert(dependencies.end(), includeObj.getDependencies().begin(),
+                            includeObj.getDependencies().end());
+        // A failed store only costs a recompile next launch.
+        shaderCache.store(key, dependencies, bytecode->GetBufferPointer(), bytecode->GetBufferSize());
+    }
+    return bytecode;
+}
+
+uint32_t ShaderCompiler::getDefaultFlags()
+{
+#if defined(_DEBUG)
+    return D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION;
+#else
+    return 0;
+#endif
+}
+
+ShaderCompilerStats ShaderCompiler::getStats()
+{
+    ShaderCompilerStats stats;
+    stats.cacheHits = cacheHits.load();
+    stats.compiled = compiled.load();
+    return stats;
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstdint>
+#include <d3dcompiler.h>
+
+struct ShaderCompilerStats
+{
+    uint32_t cacheHits = 0;
+    uint32_t compiled = 0;
+};
+
+// Compiles HLSL through the on-disk ShaderCache: a warm cache returns the stored bytecode without invoking the
+// compiler at all. Safe to call from several threads; throws std::runtime_error when compilation fails.
+class ShaderCompiler
+{
+public:
+    static ID3DBlob* compile(const wchar_t* path, const char* profile, const char* entryPoint = "main");
+    static uint32_t getDefaultFlags();
+    static ShaderCompilerStats getStats();
+};
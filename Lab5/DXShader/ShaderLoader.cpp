@@ -0,0 +1,38 @@
+#include "ShaderLoader.h"
+
+#include <stdexcept>
+#include "ShaderCompiler.h"
+
+ShaderLoader::ShaderLoader(ThreadPool* threadPool)
+    : batch(threadPool, [](const ShaderCompileRequest& request)
+    {
+        return ShaderCompiler::compile(request.path.c_str(), request.profile.c_str());
+    })
+{
+}
+
+ShaderLoader::Handle ShaderLoader::request(const wchar_t* path, const char* profile)
+{
+    return batch.enqueue({path, profile});
+}
+
+ID3DBlob* ShaderLoader::getBytecode(const wchar_t* path, const char* profile)
+{
+    return batch.get(request(path, profile));
+}
+
+ShaderLoader::~ShaderLoader()
+{
+    batch.wait();
+    for (Handle handle = 0; handle < batch.getTaskCount(); handle++)
+    {
+        try
+        {
+            batch.get(handle)->Release();
+        }
+        catch (const std::exception&)
+        {
+            // Already reported to whoever asked for this shader.
+        }
+    }
+}
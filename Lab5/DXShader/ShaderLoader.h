@@ -0,0 +1,35 @@
+#pragma once
+
+#include <d3d11.h>
+#include <string>
+#include "../Utils/TaskBatch.h"
+
+struct ShaderCompileRequest
+{
+    std::wstring path;
+    std::string profile;
+
+    bool operator==(const ShaderCompileRequest& other) const
+    {
+        return path == other.path && profile == other.profile;
+    }
+};
+
+// Batched front end for ShaderCompiler: every stage is requested up front and compiled on the thread pool while the
+// caller keeps loading other assets; the device creates its shader objects once the bytecode is collected.
+class ShaderLoader
+{
+public:
+    using Handle = TaskBatch<ShaderCompileRequest, ID3DBlob*>::Handle;
+
+    explicit ShaderLoader(ThreadPool* threadPool);
+
+    Handle request(const wchar_t* path, const char* profile);
+    // Borrowed: the loader keeps ownership of the blob.
+    ID3DBlob* getBytecode(const wchar_t* path, const char* profile);
+
+    ~ShaderLoader();
+
+private:
+    TaskBatch<ShaderCompileRequest, ID3DBlob*> batch;
+};
@@ -1,492 +1,397 @@
 ﻿#pragma once
 
-#include "../DXShader/Shader.h"
-#include "../DXDevice/DXDevice.h"
-#include "../Utils/FileSystemUtils.h"
-#include "../STB/stb_image.h"
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../Utils/HashUtils.h"
+#include "../Utils/ThreadPool.h"
+#include "IBL/BRDFLut.h"
+#include "IBL/HDRContainer.h"
+#include "IBL/HDRDecoder.h"
+#include "IBL/IBLCache.h"
+#include "IBL/SphericalHarmonics.h"
+#include "RenderDevice/RenderDevice.h"
+#include "RenderDevice/RenderMath.h"
 
 struct HDRCubemap
 {
-    ID3D11Texture2D* sourceTexture;
-    ID3D11ShaderResourceView* sourceResourceView;
-    ID3D11Texture2D* cubemapTexture;
-    ID3D11ShaderResourceView* cubemapSRV;
-
-    ID3D11Texture2D* irradianceTexture;
-    ID3D11ShaderResourceView* irradianceSRV;
-
-    ID3D11Texture2D* prefilteredTexture;
-    ID3D11ShaderResourceView* prefilteredSRV;
-    
-    ID3D11Texture2D* brdfTexture;
-    ID3D11ShaderResourceView* brdfSRV;
+    RenderTexture cubemapTexture = RENDER_NULL_HANDLE;
+    RenderTexture irradianceTexture = RENDER_NULL_HANDLE;
+    RenderTexture prefilteredTexture = RENDER_NULL_HANDLE;
+    RenderTexture brdfTexture = RENDER_NULL_HANDLE;
+
+    SHIrradiance irradianceSH;
+};
+
+struct HDRImage
+{
+    std::vector<float> pixels;
+    uint32_t width = 0;
+    uint32_t height = 0;
 };
 
 struct Quad
 {
-    VertexBuffer* quadMeshVertex;
-    IndexBuffer* quadMeshIndex;
+    RenderBuffer quadMeshVertex;
+    RenderBuffer quadMeshIndex;
 };
 
 struct ViewMat
 {
-    XMMATRIX viewProjMatrix;
+    Float4x4 viewProjMatrix;
 };
 
 struct RoughnessBufferData
 {
-    XMFLOAT4 roughness;
+    Float4 roughness;
 };
 
 class CubemapGenerator
 {
 public:
-    CubemapGenerator(DXDevice* device)
+    static const uint32_t IRRADIANCE_SIDE_SIZE = 32;
+    static const uint32_t PREFILTERED_SIDE_SIZE = 128;
+
+    explicit CubemapGenerator(RenderDevice* device)
         : device(device)
     {
-        loadShaders();
         loadQuad();
+        Float3 origin = RenderMath::makeFloat3(0.0f, 0.0f, 0.0f);
         viewMatrices = {
-            DirectX::XMMatrixLookToLH(
-                DirectX::XMVectorSet(0.0f, 0.0f, 0.0f, 0.0f),
-                DirectX::XMVectorSet(1.0f, 0.0f, 0.0f, 0.0f),
-                DirectX::XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f)
-            ),
-            DirectX::XMMatrixLookToLH(
-                DirectX::XMVectorSet(0.0f, 0.0f, 0.0f, 0.0f),
-                DirectX::XMVectorSet(-1.0f, 0.0f, 0.0f, 0.0f),
-                DirectX::XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f)
-            ),
-            DirectX::XMMatrixLookToLH(
-                DirectX::XMVectorSet(0.0f, 0.0f, 0.0f, 0.0f),
-                DirectX::XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f),
-                DirectX::XMVectorSet(0.0f, 0.0f, -1.0f, 0.0f)
-            ),
-            DirectX::XMMatrixLookToLH(
-                DirectX::XMVectorSet(0.0f, 0.0f, 0.0f, 0.0f),
-                DirectX::XMVectorSet(0.0f, -1.0f, 0.0f, 0.0f),
-                DirectX::XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f)
-            ),
-            DirectX::XMMatrixLookToLH(
-                DirectX::XMVectorSet(0.0f, 0.0f, 0.0f, 0.0f),
-                DirectX::XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f),
-                DirectX::XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f)
-            ),
-            DirectX::XMMatrixLookToLH(
-                DirectX::XMVectorSet(0.0f, 0.0f, 0.0f, 0.0f),
-                DirectX::XMVectorSet(0.0f, 0.0f, -1.0f, 0.0f),
-                DirectX::XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f)
-            ),
+            RenderMath::lookTo(origin, RenderMath::makeFloat3(1.0f, 0.0f, 0.0f),
+                               RenderMath::makeFloat3(0.0f, 1.0f, 0.0f)),
+            RenderMath::lookTo(origin, RenderMath::makeFloat3(-1.0f, 0.0f, 0.0f),
+                               RenderMath::makeFloat3(0.0f, 1.0f, 0.0f)),
+            RenderMath::lookTo(origin, RenderMath::makeFloat3(0.0f, 1.0f, 0.0f),
+                               RenderMath::makeFloat3(0.0f, 0.0f, -1.0f)),
+            RenderMath::lookTo(origin, RenderMath::makeFloat3(0.0f, -1.0f, 0.0f),
+                               RenderMath::makeFloat3(0.0f, 0.0f, 1.0f)),
+            RenderMath::lookTo(origin, RenderMath::makeFloat3(0.0f, 0.0f, 1.0f),
+                               RenderMath::makeFloat3(0.0f, 1.0f, 0.0f)),
+            RenderMath::lookTo(origin, RenderMath::makeFloat3(0.0f, 0.0f, -1.0f),
+                               RenderMath::makeFloat3(0.0f, 1.0f, 0.0f)),
         };
-        viewProjMatrixBuff = new ConstantBuffer(device->getDevice(), &data, sizeof(ViewMat));
-        roughnessBuffer = new ConstantBuffer(device->getDevice(), &buffData, sizeof(RoughnessBufferData));
-        D3D11_SAMPLER_DESC desc = {};
-        desc.Filter = D3D11_FILTER_ANISOTROPIC;
-        desc.AddressU = D3D11_TEXTURE_ADDRESS_WRAP;
-        desc.AddressV = D3D11_TEXTURE_ADDRESS_WRAP;
-        desc.AddressW = D3D11_TEXTURE_ADDRESS_WRAP;
-        desc.MinLOD = -FLT_MAX;
-        desc.MaxLOD = FLT_MAX;
-        desc.MipLODBias = 0.0f;
-        desc.MaxAnisotropy = 16;
-        desc.ComparisonFunc = D3D11_COMPARISON_NEVER;
-        desc.BorderColor[0] = desc.BorderColor[1] = desc.BorderColor[2] = desc.BorderColor[3] = 1.0f;
-        if (FAILED(device->getDevice()->CreateSamplerState(&desc, &sampler)))
-        {
-            throw std::runtime_error("Failed to load sampler");
-        }
+        RenderBufferDesc constantDesc;
+        constantDesc.type = RENDER_BUFFER_CONSTANT;
+        constantDesc.size = sizeof(ViewMat);
+        constantDesc.name = "Cube face view projection";
+        viewProjMatrixBuff = device->createBuffer(constantDesc, &data);
+        constantDesc.size = sizeof(RoughnessBufferData);
+        constantDesc.name = "Prefilter roughness";
+        roughnessBuffer = device->createBuffer(constantDesc, &buffData);
+        sampler = device->createSampler(RENDER_FILTER_ANISOTROPIC, RENDER_ADDRESS_WRAP);
     }
 
 private:
-    Shader* cubemapConvertShader = nullptr;
-    Shader* irradianceGenerator = nullptr;
-    Shader* prefilterShader = nullptr;
-    Shader* brdfShader = nullptr;
-    DXDevice* device;
+    RenderShader cubeSideVS = RENDER_NULL_HANDLE;
+    RenderShader convertPS = RENDER_NULL_HANDLE;
+    RenderShader prefilterPS = RENDER_NULL_HANDLE;
+    RenderDevice* device;
 
 
     std::vector<Quad> quads;
 
-    ID3D11SamplerState* sampler;
-    std::vector<XMMATRIX> viewMatrices;
-    ConstantBuffer* viewProjMatrixBuff = nullptr;
-    ConstantBuffer* roughnessBuffer = nullptr;
+    RenderSampler sampler;
+    std::vector<Float4x4> viewMatrices;
+    RenderBuffer viewProjMatrixBuff = RENDER_NULL_HANDLE;
+    RenderBuffer roughnessBuffer = RENDER_NULL_HANDLE;
     ViewMat data{};
     RoughnessBufferData buffData{};
-    XMMATRIX projectionMatrix = XMMatrixPerspectiveFovLH(XM_PI / 2, 1.0f, 0.1f, 10.0f);
+    Float4x4 projectionMatrix = RenderMath::perspectiveFov(RenderMath::PI / 2, 1.0f, 0.1f, 10.0f);
     std::vector<float> prefilteredRoughness = { 0.0f, 0.25f, 0.5f, 0.75f, 1.0f };
 public:
-    void loadHDRCubemap(std::string name, HDRCubemap* pOutput)
-    {
-        uint32_t sideSize = 0;
-        loadHDRMap(name, &sideSize, &pOutput->sourceTexture, &pOutput->sourceResourceView);
-        uint32_t irradianceSideSize = 32;
-        uint32_t prefilteredSideSize = 128;
-        ID3D11RenderTargetView* brdfRTV;
-        createCubemap(pOutput,  &brdfRTV, sideSize, irradianceSideSize, prefilteredSideSize);
-        DXRenderTargetView* rtv = new DXRenderTargetView(device->getDevice(), pOutput->cubemapTexture, sideSize,
-                                                         sideSize, 6, "Cube rendertarget view");
-        DXRenderTargetView* irradianceRTV = new DXRenderTargetView(device->getDevice(), pOutput->irradianceTexture,
-                                                                   sideSize,
-                                                                   sideSize, 6, "Cube rendertarget view");
-        renderCube(rtv, pOutput->sourceResourceView, sideSize);
-        renderIrradianceCube(irradianceRTV, pOutput->cubemapSRV, irradianceSideSize);
-        renderPrefilterMap(pOutput->prefilteredTexture, pOutput->cubemapSRV, prefilteredSideSize);
-        renderBRDF(brdfRTV, prefilteredSideSize);
-        rtv->destroy();
-        irradianceRTV->destroy();
-        brdfRTV->Release();
-    }
-
-private:
-    void renderCube(DXRenderTargetView* cubeRenderTargetView, ID3D11ShaderResourceView* pSourceResourceView,
-                    uint32_t sideSize)
+    // Looks for the IBLBaker cache next to the HDR file in directory before rendering the cubemaps on the GPU. The
+    // source of those is the HDRConverter container when there is one, which maps instead of decoding.
+    void loadHDRCubemap(const std::string& directory, const std::string& name, HDRCubemap* pOutput)
     {
-        for (uint32_t i = 0; i < 6; i++)
+        loadBRDFLut(directory, pOutput);
+        uint64_t sourceHash = 0;
+        bool hashed = HashUtils::hashFile(directory + name, &sourceHash);
+        if (hashed && loadBakedCubemap(directory, name, sourceHash, pOutput))
         {
-            cubeRenderTargetView->clearColorAttachments(device->getDeviceContext(), 0.25, 0.25, 0.25, 1.0, i);
-            cubeRenderTargetView->bind(device->getDeviceContext(), sideSize, sideSize, i, false);
-            cubemapConvertShader->bind(device->getDeviceContext());
-            device->getDeviceContext()->PSSetShaderResources(0, 1, &pSourceResourceView);
-            device->getDeviceContext()->PSSetSamplers(0, 1, &sampler);
-            device->getDeviceContext()->OMSetDepthStencilState(nullptr, 0);
-            device->getDeviceContext()->RSSetState(nullptr);
-            device->getDeviceContext()->OMSetBlendState(nullptr, nullptr, 0xFFFFFFFF);
-            data.viewProjMatrix = XMMatrixMultiply(viewMatrices[i], projectionMatrix);
-            viewProjMatrixBuff->updateData(device->getDeviceContext(), &data);
-            viewProjMatrixBuff->bindToVertexShader(device->getDeviceContext());
-            cubemapConvertShader->draw(device->getDeviceContext(), quads[i].quadMeshIndex, quads[i].quadMeshVertex);
+            return;
         }
-        DXDevice::unBindRenderTargets(device->getDeviceContext());
-    }
-
-    void renderIrradianceCube(DXRenderTargetView* cubeRenderTargetView, ID3D11ShaderResourceView* pSourceResourceView,
-                              uint32_t sideSize)
-    {
-        for (uint32_t i = 0; i < 6; i++)
+        std::cout << "No baked IBL cache for " << name << ", rendering cubemaps on GPU" << std::endl;
+        // The generator's shaders are only needed here, so they compile while the HDR decodes.
+        requestShaders();
+        HDRContainer container;
+        if (container.open(directory + HDRContainer::getContainerPath(name), hashed ? &sourceHash : nullptr))
         {
-            cubeRenderTargetView->clearColorAttachments(device->getDeviceContext(), 0.25, 0.25, 0.25, 1.0, i);
-            cubeRenderTargetView->bind(device->getDeviceContext(), sideSize, sideSize, i, false);
-            irradianceGenerator->bind(device->getDeviceContext());
-            device->getDeviceContext()->PSSetShaderResources(0, 1, &pSourceResourceView);
-            device->getDeviceContext()->PSSetSamplers(0, 1, &sampler);
-            device->getDeviceContext()->OMSetDepthStencilState(nullptr, 0);
-            device->getDeviceContext()->RSSetState(nullptr);
-            device->getDeviceContext()->OMSetBlendState(nullptr, nullptr, 0xFFFFFFFF);
-            data.viewProjMatrix = XMMatrixMultiply(viewMatrices[i], projectionMatrix);
-            viewProjMatrixBuff->updateData(device->getDeviceContext(), &data);
-            viewProjMatrixBuff->bindToVertexShader(device->getDeviceContext());
-            irradianceGenerator->draw(device->getDeviceContext(), quads[i].quadMeshIndex, quads[i].quadMeshVertex);
+            renderHDRCubemap(container, pOutput);
+            return;
         }
-        DXDevice::unBindRenderTargets(device->getDeviceContext());
+        ThreadPool threadPool;
+        HDRImage image;
+        loadHDRMap(directory + name, &threadPool, &image);
+        renderHDRCubemap(image, &threadPool, pOutput);
     }
 
-    void renderPrefilterMap(ID3D11Texture2D* cubemap, ID3D11ShaderResourceView* pSourceResourceView,
-                            uint32_t sideSize)
+    // Everything but the BRDF LUT, rendered from an image already in memory.
+    void renderHDRCubemap(const HDRImage& image, ThreadPool* threadPool, HDRCubemap* pOutput)
     {
-        
-        for (uint32_t i = 0; i < 6; i++)
-        {
-            size_t mipSize = sideSize;
-            for(uint32_t j = 0; j<prefilteredRoughness.size(); j++)
-            {
-
-                auto rtv = createPrefilteredRTV(cubemap, i, j);
-                device->getDeviceContext()->OMSetRenderTargets(1, &rtv, nullptr);
-                D3D11_VIEWPORT viewport;
-                viewport.TopLeftX = 0;
-                viewport.TopLeftY = 0;
-                viewport.Width = mipSize;
-                viewport.Height = mipSize;
-                viewport.MinDepth = 0.0f;
-                viewport.MaxDepth = 1.0f;
-                device->getDeviceContext()->RSSetViewports(1, &viewport);
-                prefilterShader->bind(device->getDeviceContext());
-                device->getDeviceContext()->PSSetShaderResources(0, 1, &pSourceResourceView);
-                device->getDeviceContext()->PSSetSamplers(0, 1, &sampler);
-                device->getDeviceContext()->OMSetDepthStencilState(nullptr, 0);
-                device->getDeviceContext()->RSSetState(nullptr);
-                buffData.roughness =  XMFLOAT4(prefilteredRoughness[j], prefilteredRoughness[j], prefilteredRoughness[j], prefilteredRoughness[j]);
-                roughnessBuffer->updateData(device->getDeviceContext(), &buffData);
-                roughnessBuffer->bindToPixelShader(device->getDeviceContext());
-                device->getDeviceContext()->OMSetBlendState(nullptr, nullptr, 0xFFFFFFFF);
-                data.viewProjMatrix = XMMatrixMultiply(viewMatrices[i], projectionMatrix);
-                viewProjMatrixBuff->updateData(device->getDeviceContext(), &data);
-                viewProjMatrixBuff->bindToVertexShader(device->getDeviceContext());
-                prefilterShader->draw(device->getDeviceContext(), quads[i].quadMeshIndex, quads[i].quadMeshVertex);
-                rtv->Release();
-                mipSize>>=1;
-            }
-            
-        }
-        DXDevice::unBindRenderTargets(device->getDeviceContext());
+        pOutput->irradianceSH = SphericalHarmonics::projectEquirectangular(image.pixels.data(), image.width,
+                                                                           image.height, threadPool);
+        renderEquirectangular(image.width, image.height, RENDER_FORMAT_R32G32B32A32_FLOAT, image.pixels.data(),
+                              pOutput);
     }
 
-    void renderBRDF(ID3D11RenderTargetView* brdfRTV, uint32_t prefilteredSideSize)
+    // The texels go to the device straight from the mapped file and the SH irradiance comes from its header.
+    void renderHDRCubemap(const HDRContainer& container, HDRCubemap* pOutput)
     {
-        device->getDeviceContext()->OMSetRenderTargets(1, &brdfRTV, nullptr);
-        
-        D3D11_VIEWPORT viewport;
-        viewport.TopLeftX = 0;
-        viewport.TopLeftY = 0;
-        viewport.Width = prefilteredSideSize;
-        viewport.Height = prefilteredSideSize;
-        viewport.MinDepth = 0.0f;
-        viewport.MaxDepth = 1.0f;
-        device->getDeviceContext()->RSSetViewports(1, &viewport);
-
-        device->getDeviceContext()->OMSetDepthStencilState(nullptr, 0);
-        device->getDeviceContext()->RSSetState(nullptr);
-        device->getDeviceContext()->OMSetBlendState(nullptr, nullptr, 0xFFFFFFFF);
-        device->getDeviceContext()->IASetInputLayout(nullptr);
-        device->getDeviceContext()->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-        brdfShader->bind(device->getDeviceContext());
-        device->getDeviceContext()->Draw(6, 0);
-
+        const HDRContainerHeader& header = container.getHeader();
+        pOutput->irradianceSH = header.irradianceSH;
+        renderEquirectangular(header.width, header.height, container.getFormat(), container.getTexels(), pOutput);
     }
 
-    ID3D11RenderTargetView* createPrefilteredRTV(ID3D11Texture2D* texture, uint32_t sideNum, int mipSlice)
+    void loadBRDFLut(const std::string& directory, HDRCubemap* pOutput)
     {
-        ID3D11RenderTargetView* res;
-        D3D11_RENDER_TARGET_VIEW_DESC rtvDesc;
-        rtvDesc.Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
-        rtvDesc.ViewDimension = D3D11_RTV_DIMENSION_TEXTURE2DARRAY;
-        rtvDesc.Texture2DArray.MipSlice = mipSlice;
-        rtvDesc.Texture2DArray.ArraySize = 1;
-
-
-        rtvDesc.Texture2DArray.FirstArraySlice = sideNum;
-        if(FAILED(device->getDevice()->CreateRenderTargetView(texture, &rtvDesc, &res)))
+        std::string path = directory + "brdf.lut";
+        uint32_t size = 0;
+        std::vector<uint16_t> texels;
+        if (!BRDFLut::read(path, &size, &texels))
         {
-            throw std::runtime_error("Failed to create prefiltered rtv");
+            std::cout << "No baked BRDF LUT at " << path << ", using the analytic fit" << std::endl;
+            size = BRDFLut::DEFAULT_SIZE;
+            BRDFLut::generateAnalytic(size, &texels);
         }
 
-        return res;
+        RenderTextureDesc desc;
+        desc.width = size;
+        desc.height = size;
+        desc.format = RENDER_FORMAT_R16G16_FLOAT;
+        desc.bindFlags = RENDER_BIND_SHADER_RESOURCE;
+        desc.name = "BRDF LUT";
+        desc.memoryCategory = MEMORY_CATEGORY;
+        const void* initialData[] = {texels.data()};
+        pOutput->brdfTexture = device->createTexture(desc, initialData);
     }
 
-    void createCubemap(HDRCubemap* pOutput, ID3D11RenderTargetView** brdfRTV, uint32_t size, uint32_t irradianceSideSize, uint32_t prefilteredSideSize)
+    static void destroyCubemap(RenderDevice* device, HDRCubemap* cubemap)
     {
-        D3D11_TEXTURE2D_DESC textureDesc = {};
-
-        textureDesc.Width = size;
-        textureDesc.Height = size;
-        textureDesc.MipLevels = 0;
-        textureDesc.ArraySize = 6;
-        textureDesc.SampleDesc.Count = 1;
-        textureDesc.SampleDesc.Quality = 0;
-        textureDesc.Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
-        textureDesc.Usage = D3D11_USAGE_DEFAULT;
-        textureDesc.BindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE;
-        textureDesc.CPUAccessFlags = 0;
-        textureDesc.MiscFlags = D3D11_RESOURCE_MISC_GENERATE_MIPS | D3D11_RESOURCE_MISC_TEXTURECUBE;
-        if (FAILED(device->getDevice()->CreateTexture2D(&textureDesc, 0, &pOutput->cubemapTexture)))
+        RenderTexture textures[] = {
+            cubemap->cubemapTexture, cubemap->irradianceTexture, cubemap->prefilteredTexture, cubemap->brdfTexture
+        };
+        for (RenderTexture texture : textures)
         {
-            throw std::runtime_error("Failed to create resulting cubemap texture");
+            if (texture)
+            {
+                device->destroyTexture(texture);
+            }
         }
+        *cubemap = HDRCubemap();
+    }
 
-        D3D11_SHADER_RESOURCE_VIEW_DESC shaderResourceViewDesc;
-        shaderResourceViewDesc.Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
-        shaderResourceViewDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURECUBE;
-        shaderResourceViewDesc.Texture2D.MostDetailedMip = 0;
-        shaderResourceViewDesc.Texture2D.MipLevels = 1;
+private:
+    static inline const char* MEMORY_CATEGORY = "Environment maps";
 
-        if (FAILED(device->getDevice()->CreateShaderResourceView(pOutput->cubemapTexture, &shaderResourceViewDesc,
-            &pOutput->cubemapSRV)))
+    bool loadBakedCubemap(const std::string& directory, const std::string& name, uint64_t sourceHash,
+                          HDRCubemap* pOutput)
+    {
+        IBLCacheData data;
+        if (!IBLCache::read(directory + IBLCache::getCachePath(name), sourceHash, &data))
         {
-            throw std::runtime_error("Failed to create shader resource view cubemap");
+            return false;
         }
-        textureDesc.Width = irradianceSideSize;
-        textureDesc.Height = irradianceSideSize;
+        pOutput->cubemapTexture = uploadCubemap(data.cubemap, "Environment cubemap");
+        pOutput->irradianceTexture = uploadCubemap(data.irradiance, "Irradiance cubemap");
+        pOutput->irradianceSH = data.irradianceSH;
+        pOutput->prefilteredTexture = uploadCubemap(data.prefiltered, "Prefiltered cubemap");
+        return true;
+    }
 
-        if (FAILED(device->getDevice()->CreateTexture2D(&textureDesc, 0, &pOutput->irradianceTexture)))
-        {
-            throw std::runtime_error("Failed to create resulting cubemap texture");
-        }
-        if (FAILED(device->getDevice()->CreateShaderResourceView(pOutput->irradianceTexture, &shaderResourceViewDesc,
-            &pOutput->irradianceSRV)))
-        {
-            throw std::runtime_error("Failed to create shader resource view cubemap");
-        }
-        textureDesc.Width = prefilteredSideSize;
-        textureDesc.Height = prefilteredSideSize;
-        textureDesc.MipLevels = prefilteredRoughness.size();
-        shaderResourceViewDesc.Texture2D.MipLevels = prefilteredRoughness.size();
-        if (FAILED(device->getDevice()->CreateTexture2D(&textureDesc, 0, &pOutput->prefilteredTexture)))
-        {
-            throw std::runtime_error("Failed to create resulting cubemap texture");
-        }
-        if (FAILED(device->getDevice()->CreateShaderResourceView(pOutput->prefilteredTexture, &shaderResourceViewDesc,
-            &pOutput->prefilteredSRV)))
+    RenderTexture uploadCubemap(const PackedCubemap& cubemap, const char* name)
+    {
+        RenderTextureDesc desc;
+        desc.width = cubemap.size;
+        desc.height = cubemap.size;
+        desc.mipLevels = cubemap.mipLevels;
+        desc.arraySize = 6;
+        desc.format = cubemap.format;
+        desc.bindFlags = RENDER_BIND_SHADER_RESOURCE;
+        desc.cube = true;
+        desc.name = name;
+        desc.memoryCategory = MEMORY_CATEGORY;
+
+        std::vector<const void*> initialData(6 * cubemap.mipLevels);
+        for (uint32_t face = 0; face < 6; face++)
         {
-            throw std::runtime_error("Failed to create shader resource view cubemap");
+            for (uint32_t mip = 0; mip < cubemap.mipLevels; mip++)
+            {
+                initialData[face * cubemap.mipLevels + mip] = cubemap.getSubresource(face, mip);
+            }
         }
-        
-        D3D11_TEXTURE2D_DESC brdftextureDesc = {};
-
-        brdftextureDesc.Width = prefilteredSideSize;
-        brdftextureDesc.Height = prefilteredSideSize;
-        brdftextureDesc.MipLevels = 1;
-        brdftextureDesc.ArraySize = 1;
-        brdftextureDesc.Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
-        brdftextureDesc.SampleDesc.Count = 1;
-        brdftextureDesc.Usage = D3D11_USAGE_DEFAULT;
-        brdftextureDesc.BindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE;
-        brdftextureDesc.CPUAccessFlags = 0;
-        brdftextureDesc.MiscFlags = 0;
-
-        if (FAILED(device->getDevice()->CreateTexture2D(&brdftextureDesc, nullptr, &pOutput->brdfTexture)))
+        return device->createTexture(desc, initialData.data());
+    }
+
+    void renderEquirectangular(uint32_t width, uint32_t height, RenderFormat format, const void* texels,
+                               HDRCubemap* pOutput)
+    {
+        loadShaders();
+        createCubemap(pOutput, std::min(width, height), PREFILTERED_SIDE_SIZE);
+        RenderTexture sourceTexture = uploadHDRMap(width, height, format, texels);
+        renderCube(pOutput->cubemapTexture, sourceTexture);
+        renderIrradiance(pOutput->irradianceSH, IRRADIANCE_SIDE_SIZE, pOutput);
+        renderPrefilterMap(pOutput->prefilteredTexture, pOutput->cubemapTexture);
+        device->destroyTexture(sourceTexture);
+    }
+
+    void renderCube(RenderTexture cubemap, RenderTexture sourceTexture)
+    {
+        for (uint32_t i = 0; i < 6; i++)
         {
-            throw std::runtime_error("Failed to create resulting brdf texture");
+            RenderPassDesc pass;
+            pass.name = "Cubemap face";
+            pass.colorCount = 1;
+            pass.colors[0].texture = cubemap;
+            pass.colors[0].slice = i;
+            pass.clearColor = true;
+            pass.clearValue[0] = pass.clearValue[1] = pass.clearValue[2] = 0.25f;
+            pass.clearValue[3] = 1.0f;
+            device->beginPass(pass);
+            RenderPipelineDesc pipeline;
+            pipeline.vertexShader = cubeSideVS;
+            pipeline.pixelShader = convertPS;
+            device->setPipeline(pipeline);
+            device->setTextures(RENDER_STAGE_PIXEL, 0, 1, &sourceTexture);
+            device->setSamplers(RENDER_STAGE_PIXEL, 0, 1, &sampler);
+            data.viewProjMatrix = RenderMath::multiply(viewMatrices[i], projectionMatrix);
+            device->updateBuffer(viewProjMatrixBuff, &data, sizeof(ViewMat));
+            device->setConstantBuffer(RENDER_STAGE_VERTEX, 0, viewProjMatrixBuff);
+            device->drawIndexed(quads[i].quadMeshVertex, quads[i].quadMeshIndex, 6);
+            device->endPass();
         }
-    
+    }
 
-    
-        D3D11_RENDER_TARGET_VIEW_DESC renderTargetViewDesc;
-        renderTargetViewDesc.Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
-        renderTargetViewDesc.ViewDimension = D3D11_RTV_DIMENSION_TEXTURE2D;
-        renderTargetViewDesc.Texture2D.MipSlice = 0;
+    void renderIrradiance(const SHIrradiance& irradianceSH, uint32_t sideSize, HDRCubemap* pOutput)
+    {
+        CpuCubemap irradiance;
+        SphericalHarmonics::renderIrradiance(irradianceSH, sideSize, &irradiance);
+        PackedCubemap packed;
+        IBLCache::packCubemap(irradiance, irradiance.mipLevels, RENDER_FORMAT_R32G32B32A32_FLOAT, BC6H_QUALITY_FAST,
+                              nullptr, &packed);
+        pOutput->irradianceTexture = uploadCubemap(packed, "Irradiance cubemap");
+    }
 
-        if (FAILED(device->getDevice()->CreateRenderTargetView(pOutput->brdfTexture, &renderTargetViewDesc, brdfRTV)))
+    void renderPrefilterMap(RenderTexture cubemap, RenderTexture sourceTexture)
+    {
+        
+        for (uint32_t i = 0; i < 6; i++)
         {
-            throw std::runtime_error("Failed to create resulting brdf rtv");
+            for(uint32_t j = 0; j<prefilteredRoughness.size(); j++)
+            {
+                RenderPassDesc pass;
+                pass.name = "Prefiltered face";
+                pass.colorCount = 1;
+                pass.colors[0].texture = cubemap;
+                pass.colors[0].mip = j;
+                pass.colors[0].slice = i;
+                device->beginPass(pass);
+                RenderPipelineDesc pipeline;
+                pipeline.vertexShader = cubeSideVS;
+                pipeline.pixelShader = prefilterPS;
+                device->setPipeline(pipeline);
+                device->setTextures(RENDER_STAGE_PIXEL, 0, 1, &sourceTexture);
+                device->setSamplers(RENDER_STAGE_PIXEL, 0, 1, &sampler);
+                float roughness = prefilteredRoughness[j];
+                buffData.roughness = RenderMath::makeFloat4(roughness, roughness, roughness, roughness);
+                device->updateBuffer(roughnessBuffer, &buffData, sizeof(RoughnessBufferData));
+                device->setConstantBuffer(RENDER_STAGE_PIXEL, 0, roughnessBuffer);
+                data.viewProjMatrix = RenderMath::multiply(viewMatrices[i], projectionMatrix);
+                device->updateBuffer(viewProjMatrixBuff, &data, sizeof(ViewMat));
+                device->setConstantBuffer(RENDER_STAGE_VERTEX, 0, viewProjMatrixBuff);
+                device->drawIndexed(quads[i].quadMeshVertex, quads[i].quadMeshIndex, 6);
+                device->endPass();
+            }
+            
         }
-   
-        D3D11_SHADER_RESOURCE_VIEW_DESC brdfshaderResourceViewDesc;
-        brdfshaderResourceViewDesc.Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
-        brdfshaderResourceViewDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
-        brdfshaderResourceViewDesc.Texture2D.MostDetailedMip = 0;
-        brdfshaderResourceViewDesc.Texture2D.MipLevels = 1;
-
-       if (FAILED(device->getDevice()->CreateShaderResourceView(pOutput->brdfTexture, &brdfshaderResourceViewDesc, &pOutput->brdfSRV)))
-       {
-           throw std::runtime_error("Failed to create resulting brdf srv");
-       }
     }
 
-    void loadHDRMap(std::string name, uint32_t* pSizeOutput, ID3D11Texture2D** ppTextureResult,
-                    ID3D11ShaderResourceView** ppResourceViewRes)
+    void createCubemap(HDRCubemap* pOutput, uint32_t size, uint32_t prefilteredSideSize)
     {
-        auto workDir = FileSystemUtils::getCurrentDirectoryPath();
-
-        std::string filePath(workDir.begin(), workDir.end());
-        filePath += name;
-        int width, height, nrComponents;
-        float* data = stbi_loadf(filePath.c_str(), &width, &height, &nrComponents, 4);
+        RenderTextureDesc desc;
+        desc.width = size;
+        desc.height = size;
+        desc.arraySize = 6;
+        desc.format = RENDER_FORMAT_R32G32B32A32_FLOAT;
+        desc.bindFlags = RENDER_BIND_RENDER_TARGET | RENDER_BIND_SHADER_RESOURCE;
+        desc.cube = true;
+        desc.name = "Environment cubemap";
+        desc.memoryCategory = MEMORY_CATEGORY;
+        pOutput->cubemapTexture = device->createTexture(desc);
+
+        desc.width = prefilteredSideSize;
+        desc.height = prefilteredSideSize;
+        desc.mipLevels = (uint32_t)prefilteredRoughness.size();
+        desc.name = "Prefiltered cubemap";
+        pOutput->prefilteredTexture = device->createTexture(desc);
+    }
 
-        if (!data)
+    void loadHDRMap(const std::string& filePath, ThreadPool* threadPool, HDRImage* pImageOutput)
+    {
+        if (!HDRDecoder::load(filePath, threadPool, &pImageOutput->pixels, &pImageOutput->width,
+                              &pImageOutput->height))
         {
             throw std::runtime_error("Failed to load hdr");
         }
+    }
 
-        *pSizeOutput = min(width, height);
-        D3D11_TEXTURE2D_DESC textureDesc = {};
-
-        textureDesc.Width = width;
-        textureDesc.Height = height;
-        textureDesc.MipLevels = 1;
-        textureDesc.ArraySize = 1;
-        textureDesc.Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
-        textureDesc.SampleDesc.Count = 1;
-        textureDesc.Usage = D3D11_USAGE_DEFAULT;
-        textureDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
-        textureDesc.CPUAccessFlags = 0;
-        textureDesc.MiscFlags = 0;
-
-        D3D11_SUBRESOURCE_DATA initData;
-        initData.pSysMem = data;
-        initData.SysMemPitch = width * sizeof(float) * 4;
-        initData.SysMemSlicePitch = width * height * sizeof(float) * 4;
-
-        HRESULT result = device->getDevice()->CreateTexture2D(&textureDesc, &initData, ppTextureResult);
+    RenderTexture uploadHDRMap(uint32_t width, uint32_t height, RenderFormat format, const void* texels)
+    {
+        RenderTextureDesc desc;
+        desc.width = width;
+        desc.height = height;
+        desc.format = format;
+        desc.bindFlags = RENDER_BIND_SHADER_RESOURCE;
+        desc.name = "Equirectangular HDR";
+        desc.memoryCategory = MEMORY_CATEGORY;
+        const void* initialData[] = {texels};
+        return device->createTexture(desc, initialData);
+    }
 
-        if (SUCCEEDED(result))
-        {
-            D3D11_SHADER_RESOURCE_VIEW_DESC descSRV = {};
-            descSRV.Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
-            descSRV.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
-            descSRV.Texture2D.MipLevels = 1;
-            descSRV.Texture2D.MostDetailedMip = 0;
-            result = device->getDevice()->CreateShaderResourceView(*ppTextureResult, &descSRV, ppResourceViewRes);
-        }
-        else
-        {
-            throw std::runtime_error("Failed to create cubemap texture");
-        }
-        stbi_image_free(data);
+    void requestShaders()
+    {
+        device->requestShader(cubeSideShaderDesc());
+        device->requestShader(convertShaderDesc);
+        device->requestShader(prefilterShaderDesc);
     }
 
     void loadShaders()
     {
-        ShaderCreateInfo createInfos[2];
-        createInfos[0].shaderName = "CubeSideVS";
-        createInfos[0].pathToShader = L"Shaders/CubemapGen/CubeSideVS.hlsl";
-        createInfos[0].shaderType = ShaderType::VERTEX_SHADER;
-
-        createInfos[1].shaderName = "HDRToCube";
-        createInfos[1].pathToShader = L"Shaders/CubemapGen/HDRToCubePS.hlsl";
-        createInfos[1].shaderType = ShaderType::PIXEL_SHADER;
-        cubemapConvertShader = Shader::loadShader(device->getDevice(), createInfos, 2);
-        ShaderVertexInput vertexInputs[1];
-        vertexInputs[0].inputFormat = DXGI_FORMAT_R32G32B32_FLOAT;
-        vertexInputs[0].variableIndex = 0;
-        vertexInputs[0].vertexSize = sizeof(float) * 3;
-        vertexInputs[0].shaderVariableName = "POSITION";
-        cubemapConvertShader->makeInputLayout(device->getDevice(), vertexInputs, 1);
-        createInfos[1].shaderName = "irradianceCube";
-        createInfos[1].pathToShader = L"Shaders/CubemapGen/irradianceCube.hlsl";
-        irradianceGenerator = Shader::loadShader(device->getDevice(), createInfos, 2);
-        irradianceGenerator->makeInputLayout(device->getDevice(), vertexInputs, 1);
-        createInfos[1].shaderName = "prefilterer";
-        createInfos[1].pathToShader = L"Shaders/CubemapGen/prefilterCube.hlsl";
-        prefilterShader = Shader::loadShader(device->getDevice(), createInfos, 2);
-        prefilterShader->makeInputLayout(device->getDevice(), vertexInputs, 1);
-
-        createInfos[0].shaderName = "brdfVS";
-        createInfos[0].pathToShader = L"Shaders/CubemapGen/brdfVS.hlsl";
-
-        createInfos[1].shaderName = "brdfPS";
-        createInfos[1].pathToShader = L"Shaders/CubemapGen/brdfPS.hlsl";
-        brdfShader = Shader::loadShader(device->getDevice(), createInfos, 2);
+        cubeSideVS = device->createShader(cubeSideShaderDesc());
+        convertPS = device->createShader(convertShaderDesc);
+        prefilterPS = device->createShader(prefilterShaderDesc);
     }
 
     void loadQuad()
     {
-        quads.push_back({
-            new VertexBuffer(device->getDevice(), sizeof(quadVerticesXPos),
-                             sizeof(float) * 3, quadVerticesXPos),
-            new IndexBuffer(device->getDevice(), quadIndicesXPos, 6)
-        });
-
-        quads.push_back({
-            new VertexBuffer(device->getDevice(), sizeof(quadVerticesXNeg),
-                             sizeof(float) * 3, quadVerticesXNeg),
-            new IndexBuffer(device->getDevice(), quadIndicesXNeg, 6)
-        });
-
-        quads.push_back({
-            new VertexBuffer(device->getDevice(), sizeof(quadVerticesYPos),
-                             sizeof(float) * 3, quadVerticesYPos),
-            new IndexBuffer(device->getDevice(), quadIndicesYPos, 6),
-
-        });
-
-        quads.push_back({
-            new VertexBuffer(device->getDevice(), sizeof(quadVerticesYNeg),
-                             sizeof(float) * 3, quadVerticesYNeg),
-            new IndexBuffer(device->getDevice(), quadIndicesYNeg, 6)
-        });
-
-        quads.push_back({
-            new VertexBuffer(device->getDevice(), sizeof(quadVerticesZPos),
-                             sizeof(float) * 3, quadVerticesZPos),
-            new IndexBuffer(device->getDevice(), quadIndicesZPos, 6),
-        });
-
-        quads.push_back({
-            new VertexBuffer(device->getDevice(), sizeof(quadVerticesZNeg),
-                             sizeof(float) * 3, quadVerticesZNeg),
-            new IndexBuffer(device->getDevice(), quadIndicesZNeg, 6)
-        });
+        float* vertices[] = {
+            quadVerticesXPos, quadVerticesXNeg, quadVerticesYPos, quadVerticesYNeg, quadVerticesZPos,
+            quadVerticesZNeg
+        };
+        uint32_t* indices[] = {
+            quadIndicesXPos, quadIndicesXNeg, quadIndicesYPos, quadIndicesYNeg, quadIndicesZPos, quadIndicesZNeg
+        };
+        for (uint32_t i = 0; i < 6; i++)
+        {
+            RenderBufferDesc vertexDesc;
+            vertexDesc.type = RENDER_BUFFER_VERTEX;
+            vertexDesc.size = sizeof(float) * 3 * 4;
+            vertexDesc.stride = sizeof(float) * 3;
+            vertexDesc.name = "Cube side vertices";
+            vertexDesc.memoryCategory = MEMORY_CATEGORY;
+            RenderBufferDesc indexDesc;
+            indexDesc.type = RENDER_BUFFER_INDEX;
+            indexDesc.size = sizeof(uint32_t) * 6;
+            indexDesc.stride = sizeof(uint32_t);
+            indexDesc.name = "Cube side indices";
+            indexDesc.memoryCategory = MEMORY_CATEGORY;
+            quads.push_back({
+                device->createBuffer(vertexDesc, vertices[i]), device->createBuffer(indexDesc, indices[i])
+            });
+        }
     }
 
 public:
@@ -494,18 +399,38 @@ public:
     {
         for (auto value : quads)
         {
-            delete value.quadMeshIndex;
-            delete value.quadMeshVertex;
+            device->destroyBuffer(value.quadMeshIndex);
+            device->destroyBuffer(value.quadMeshVertex);
+        }
+        device->destroySampler(sampler);
+        device->destroyBuffer(viewProjMatrixBuff);
+        device->destroyBuffer(roughnessBuffer);
+        RenderShader shaders[] = {cubeSideVS, convertPS, prefilterPS};
+        for (RenderShader shader : shaders)
+        {
+            if (shader)
+            {
+                device->destroyShader(shader);
+            }
         }
-        sampler->Release();
-        delete viewProjMatrixBuff;
-        delete irradianceGenerator;
-        delete cubemapConvertShader;
-        delete prefilterShader;
-        delete brdfShader;
     }
 
 private:
+    static inline RenderVertexAttribute cubeSideAttributes[] = {
+        {"POSITION", 0, RENDER_FORMAT_R32G32B32_FLOAT}
+    };
+    static inline RenderShaderDesc convertShaderDesc = {
+        RENDER_STAGE_PIXEL, L"Shaders/CubemapGen/HDRToCubePS.hlsl", nullptr, 0, "HDRToCube"
+    };
+    static inline RenderShaderDesc prefilterShaderDesc = {
+        RENDER_STAGE_PIXEL, L"Shaders/CubemapGen/prefilterCube.hlsl", nullptr, 0, "prefilterer"
+    };
+
+    static RenderShaderDesc cubeSideShaderDesc()
+    {
+        return {RENDER_STAGE_VERTEX, L"Shaders/CubemapGen/CubeSideVS.hlsl", cubeSideAttributes, 1, "CubeSideVS"};
+    }
+
     static inline float quadVerticesXPos[]
     {
         0.5f, -0.5f, 0.5f,
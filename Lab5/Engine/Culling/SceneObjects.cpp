@@ -0,0 +1,541 @@
+#include "SceneObjects.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <stdexcept>
+
+#include "../IBL/FloatLanes.h"
+
+namespace
+{
+    const uint32_t BIN_COUNT = 16;
+    const float REBUILD_AREA_RATIO = 2.0f;
+    const uint32_t ALL_PLANES = 0x3f;
+    const float FAR_AWAY = 1e30f;
+
+    // Rows of SceneObjects::slotBounds.
+    enum SlotRow
+    {
+        SLOT_CENTER_X,
+        SLOT_CENTER_Y,
+        SLOT_CENTER_Z,
+        SLOT_EXTENT_X,
+        SLOT_EXTENT_Y,
+        SLOT_EXTENT_Z,
+        SLOT_ROW_COUNT
+    };
+
+    struct Bounds
+    {
+        Float3 boundsMin = RenderMath::makeFloat3(FAR_AWAY, FAR_AWAY, FAR_AWAY);
+        Float3 boundsMax = RenderMath::makeFloat3(-FAR_AWAY, -FAR_AWAY, -FAR_AWAY);
+
+        void grow(const Float3& point)
+        {
+            boundsMin = RenderMath::makeFloat3(std::min(boundsMin.x, point.x), std::min(boundsMin.y, point.y),
+                                               std::min(boundsMin.z, point.z));
+            boundsMax = RenderMath::makeFloat3(std::max(boundsMax.x, point.x), std::max(boundsMax.y, point.y),
+                                               std::max(boundsMax.z, point.z));
+        }
+
+        void grow(const Bounds& other)
+        {
+            grow(other.boundsMin);
+            grow(other.boundsMax);
+        }
+
+        void grow(const Float3& center, const Float3& extent)
+        {
+            grow(RenderMath::makeFloat3(center.x - extent.x, center.y - extent.y, center.z - extent.z));
+            grow(RenderMath::makeFloat3(center.x + extent.x, center.y + extent.y, center.z + extent.z));
+        }
+
+        // Half the surface area, zero while empty.
+        float getArea() const
+        {
+            if (boundsMin.x > boundsMax.x)
+            {
+                return 0.0f;
+            }
+            float x = boundsMax.x - boundsMin.x;
+            float y = boundsMax.y - boundsMin.y;
+            float z = boundsMax.z - boundsMin.z;
+            return x * y + y * z + z * x;
+        }
+    };
+
+    float getAxis(const Float3& vector, uint32_t axis)
+    {
+        return axis == 0 ? vector.x : axis == 1 ? vector.y : vector.z;
+    }
+
+    Bounds getNodeBounds(const BVHNode& node)
+    {
+        Bounds bounds;
+        bounds.boundsMin = node.boundsMin;
+        bounds.boundsMax = node.boundsMax;
+        return bounds;
+    }
+
+    bool setNodeBounds(BVHNode& node, const Bounds& bounds)
+    {
+        const float* oldBounds[] = {&node.boundsMin.x, &node.boundsMax.x};
+        const float* newBounds[] = {&bounds.boundsMin.x, &bounds.boundsMax.x};
+        bool changed = false;
+        for (uint32_t side = 0; side < 2; side++)
+        {
+            for (uint32_t axis = 0; axis < 3; axis++)
+            {
+                changed = changed || oldBounds[side][axis] != newBounds[side][axis];
+            }
+        }
+        node.boundsMin = bounds.boundsMin;
+        node.boundsMax = bounds.boundsMax;
+        return changed;
+    }
+
+    // Frustum planes of a row vector view-projection matrix with a [0, 1] depth range, facing inwards:
+    // left, right, bottom, top, near and far.
+    void getFrustumPlanes(const Float4x4& viewProjection, float (*pPlanes)[4])
+    {
+        const float(*m)[4] = viewProjection.m;
+        for (uint32_t i = 0; i < 4; i++)
+        {
+            pPlanes[0][i] = m[i][3] + m[i][0];
+            pPlanes[1][i] = m[i][3] - m[i][0];
+            pPlanes[2][i] = m[i][3] + m[i][1];
+            pPlanes[3][i] = m[i][3] - m[i][1];
+            pPlanes[4][i] = m[i][2];
+            pPlanes[5][i] = m[i][3] - m[i][2];
+        }
+    }
+}
+
+SceneObjects::SceneObjects()
+{
+}
+
+uint32_t SceneObjects::add(const Float3& boundsMin, const Float3& boundsMax)
+{
+    centers.push_back(RenderMath::makeFloat3(0.0f, 0.0f, 0.0f));
+    extents.push_back(RenderMath::makeFloat3(0.0f, 0.0f, 0.0f));
+    objectSlots.push_back(0);
+    structureDirty = true;
+    uint32_t id = (uint32_t)centers.size() - 1;
+    setBounds(id, boundsMin, boundsMax);
+    return id;
+}
+
+void SceneObjects::setBounds(uint32_t id, const Float3& boundsMin, const Float3& boundsMax)
+{
+    if (id >= centers.size())
+    {
+        throw std::runtime_error("Failed to set object bounds: unknown object");
+    }
+    centers[id] = RenderMath::makeFloat3((boundsMin.x + boundsMax.x) * 0.5f, (boundsMin.y + boundsMax.y) * 0.5f,
+                                         (boundsMin.z + boundsMax.z) * 0.5f);
+    extents[id] = RenderMath::makeFloat3((boundsMax.x - boundsMin.x) * 0.5f, (boundsMax.y - boundsMin.y) * 0.5f,
+                                         (boundsMax.z - boundsMin.z) * 0.5f);
+    if (structureDirty)
+    {
+        return;
+    }
+    uint32_t slot = objectSlots[id];
+    writeSlot(slot);
+    uint32_t leaf = slotLeaves[slot];
+    if (!leafDirty[leaf])
+    {
+        leafDirty[leaf] = 1;
+        dirtyLeaves.push_back(leaf);
+    }
+}
+
+void SceneObjects::clear()
+{
+    centers.clear();
+    extents.clear();
+    objectSlots.clear();
+    slotObjects.clear();
+    slotLeaves.clear();
+    slotBounds.clear();
+    slotStride = 0;
+    nodes.clear();
+    leafDirty.clear();
+    dirtyLeaves.clear();
+    structureDirty = false;
+    builtArea = 0.0f;
+    currentArea = 0.0f;
+}
+
+uint32_t SceneObjects::getObjectCount() const
+{
+    return (uint32_t)centers.size();
+}
+
+void SceneObjects::update()
+{
+    if (structureDirty)
+    {
+        build();
+        return;
+    }
+    if (dirtyLeaves.empty())
+    {
+        return;
+    }
+    refit();
+    if (currentArea > builtArea * REBUILD_AREA_RATIO)
+    {
+        build();
+    }
+}
+
+void SceneObjects::cull(const Float4x4& viewProjection, std::vector<uint32_t>* pVisible, CullStats* pStats) const
+{
+    if (structureDirty || !dirtyLeaves.empty())
+    {
+        throw std::runtime_error("Failed to cull scene objects: the hierarchy is out of date");
+    }
+    pVisible->clear();
+    CullStats stats;
+    if (!nodes.empty())
+    {
+        float planes[6][4];
+        getFrustumPlanes(viewProjection, planes);
+        struct StackEntry
+        {
+            uint32_t node;
+            uint32_t planeMask;
+        };
+        std::vector<StackEntry> stack;
+        stack.push_back({0, ALL_PLANES});
+        while (!stack.empty())
+        {
+            StackEntry entry = stack.back();
+            stack.pop_back();
+            const BVHNode& node = nodes[entry.node];
+            stats.visitedNodes++;
+            Float3 center = RenderMath::makeFloat3((node.boundsMin.x + node.boundsMax.x) * 0.5f,
+                                                   (node.boundsMin.y + node.boundsMax.y) * 0.5f,
+                                                   (node.boundsMin.z + node.boundsMax.z) * 0.5f);
+            Float3 extent = RenderMath::makeFloat3((node.boundsMax.x - node.boundsMin.x) * 0.5f,
+                                                   (node.boundsMax.y - node.boundsMin.y) * 0.5f,
+                                                   (node.boundsMax.z - node.boundsMin.z) * 0.5f);
+            uint32_t planeMask = entry.planeMask;
+            bool outside = false;
+            for (uint32_t plane = 0; plane < 6 && !outside; plane++)
+            {
+                if (!(planeMask & (1u << plane)))
+                {
+                    continue;
+                }
+                const float* p = planes[plane];
+                float distance = p[0] * center.x + p[1] * center.y + p[2] * center.z + p[3];
+                float reach = fabsf(p[0]) * extent.x + fabsf(p[1]) * extent.y + fabsf(p[2]) * extent.z;
+                outside = distance + reach < 0.0f;
+                if (distance - reach >= 0.0f)
+                {
+                    planeMask &= ~(1u << plane);
+                }
+            }
+            if (outside)
+            {
+                continue;
+            }
+            if (!planeMask)
+            {
+                pVisible->insert(pVisible->end(), slotObjects.begin() + node.firstObject,
+                                 slotObjects.begin() + node.firstObject + node.objectCount);
+            }
+            else if (!node.firstChild)
+            {
+                stats.testedObjects += node.objectCount;
+                testSlots(planes, planeMask, node.firstObject, node.objectCount, pVisible);
+            }
+            else
+            {
+                stack.push_back({node.firstChild + 1, planeMask});
+                stack.push_back({node.firstChild, planeMask});
+            }
+        }
+    }
+    stats.visibleObjects = (uint32_t)pVisible->size();
+    if (pStats)
+    {
+        *pStats = stats;
+    }
+}
+
+void SceneObjects::cullLinear(const Float4x4& viewProjection, std::vector<uint32_t>* pVisible) const
+{
+    if (structureDirty)
+    {
+        throw std::runtime_error("Failed to cull scene objects: the hierarchy is out of date");
+    }
+    float planes[6][4];
+    getFrustumPlanes(viewProjection, planes);
+    pVisible->clear();
+    testSlots(planes, ALL_PLANES, 0, (uint32_t)slotObjects.size(), pVisible);
+}
+
+uint32_t SceneObjects::getNodeCount() const
+{
+    return (uint32_t)nodes.size();
+}
+
+uint32_t SceneObjects::getBuildCount() const
+{
+    return buildCount;
+}
+
+float SceneObjects::getAreaRatio() const
+{
+    return builtArea > 0.0f ? currentArea / builtArea : 1.0f;
+}
+
+// Top down, splitting every node with more than LEAF_SIZE objects. The split is the best of BIN_COUNT - 1 planes
+// across the longest axis of the object centers by surface area heuristic, or the median when the centers are too
+// close together to bin.
+void SceneObjects::build()
+{
+    uint32_t objectCount = (uint32_t)centers.size();
+    slotObjects.resize(objectCount);
+    std::iota(slotObjects.begin(), slotObjects.end(), 0);
+    nodes.clear();
+    dirtyLeaves.clear();
+    structureDirty = false;
+    buildCount++;
+    if (!objectCount)
+    {
+        slotLeaves.clear();
+        slotBounds.clear();
+        leafDirty.clear();
+        builtArea = currentArea = 0.0f;
+        return;
+    }
+
+    nodes.reserve(objectCount / LEAF_SIZE * 4 + 1);
+    BVHNode root;
+    root.objectCount = objectCount;
+    nodes.push_back(root);
+    std::vector<uint32_t> stack(1, 0);
+    std::vector<uint8_t> objectBins(objectCount);
+    float area = 0.0f;
+    while (!stack.empty())
+    {
+        uint32_t nodeIndex = stack.back();
+        stack.pop_back();
+        uint32_t first = nodes[nodeIndex].firstObject;
+        uint32_t count = nodes[nodeIndex].objectCount;
+        uint32_t* objects = slotObjects.data() + first;
+        Bounds bounds;
+        Bounds centerBounds;
+        for (uint32_t i = 0; i < count; i++)
+        {
+            bounds.grow(centers[objects[i]], extents[objects[i]]);
+            centerBounds.grow(centers[objects[i]]);
+        }
+        setNodeBounds(nodes[nodeIndex], bounds);
+        area += bounds.getArea();
+        if (count <= LEAF_SIZE)
+        {
+            continue;
+        }
+
+        uint32_t axis = 0;
+        float axisLength = -1.0f;
+        for (uint32_t candidate = 0; candidate < 3; candidate++)
+        {
+            float length = getAxis(centerBounds.boundsMax, candidate) - getAxis(centerBounds.boundsMin, candidate);
+            if (length > axisLength)
+            {
+                axis = candidate;
+                axisLength = length;
+            }
+        }
+        float axisMin = getAxis(centerBounds.boundsMin, axis);
+        float binScale = axisLength > 0.0f ? BIN_COUNT / axisLength : 0.0f;
+        uint32_t splitBin = BIN_COUNT;
+        if (axisLength > 0.0f)
+        {
+            Bounds bins[BIN_COUNT];
+            uint32_t binCounts[BIN_COUNT] = {};
+            for (uint32_t i = 0; i < count; i++)
+            {
+                uint32_t object = objects[i];
+                uint32_t bin = std::min((uint32_t)((getAxis(centers[object], axis) - axisMin) * binScale),
+                                        BIN_COUNT - 1);
+                objectBins[object] = (uint8_t)bin;
+                bins[bin].grow(centers[object], extents[object]);
+                binCounts[bin]++;
+            }
+            float rightCosts[BIN_COUNT] = {};
+            Bounds right;
+            uint32_t rightCount = 0;
+            for (uint32_t bin = BIN_COUNT - 1; bin > 0; bin--)
+            {
+                right.grow(bins[bin]);
+                rightCount += binCounts[bin];
+                rightCosts[bin] = right.getArea() * rightCount;
+            }
+            Bounds left;
+            uint32_t leftCount = 0;
+            float bestCost = 0.0f;
+            for (uint32_t bin = 0; bin + 1 < BIN_COUNT; bin++)
+            {
+                left.grow(bins[bin]);
+                leftCount += binCounts[bin];
+                float cost = left.getArea() * leftCount + rightCosts[bin + 1];
+                if (leftCount && leftCount < count && (splitBin == BIN_COUNT || cost < bestCost))
+                {
+                    splitBin = bin;
+                    bestCost = cost;
+                }
+            }
+        }
+
+        uint32_t leftCount;
+        if (splitBin < BIN_COUNT)
+        {
+            uint32_t* middle = std::partition(objects, objects + count,
+                                              [&](uint32_t object) { return objectBins[object] <= splitBin; });
+            leftCount = (uint32_t)(middle - objects);
+        }
+        else
+        {
+            leftCount = count / 2;
+            std::nth_element(objects, objects + leftCount, objects + count, [&](uint32_t a, uint32_t b)
+            {
+                return getAxis(centers[a], axis) < getAxis(centers[b], axis);
+            });
+        }
+
+        uint32_t firstChild = (uint32_t)nodes.size();
+        nodes[nodeIndex].firstChild = firstChild;
+        BVHNode child;
+        child.parent = nodeIndex;
+        child.firstObject = first;
+        child.objectCount = leftCount;
+        nodes.push_back(child);
+        child.firstObject = first + leftCount;
+        child.objectCount = count - leftCount;
+        nodes.push_back(child);
+        stack.push_back(firstChild + 1);
+        stack.push_back(firstChild);
+    }
+    builtArea = currentArea = area;
+
+    slotStride = objectCount + FloatLanes::WIDTH;
+    slotBounds.assign((size_t)slotStride * SLOT_ROW_COUNT, 0.0f);
+    slotLeaves.resize(objectCount);
+    for (uint32_t slot = 0; slot < objectCount; slot++)
+    {
+        objectSlots[slotObjects[slot]] = slot;
+        writeSlot(slot);
+    }
+    for (uint32_t nodeIndex = 0; nodeIndex < nodes.size(); nodeIndex++)
+    {
+        const BVHNode& node = nodes[nodeIndex];
+        if (!node.firstChild)
+        {
+            std::fill(slotLeaves.begin() + node.firstObject, slotLeaves.begin() + node.firstObject + node.objectCount,
+                      nodeIndex);
+        }
+    }
+    leafDirty.assign(nodes.size(), 0);
+}
+
+// Walks up from every moved leaf while the node bounds keep changing.
+void SceneObjects::refit()
+{
+    for (uint32_t leaf : dirtyLeaves)
+    {
+        leafDirty[leaf] = 0;
+        fitLeaf(leaf);
+        for (uint32_t nodeIndex = leaf; nodeIndex;)
+        {
+            nodeIndex = nodes[nodeIndex].parent;
+            BVHNode& node = nodes[nodeIndex];
+            Bounds bounds = getNodeBounds(nodes[node.firstChild]);
+            bounds.grow(getNodeBounds(nodes[node.firstChild + 1]));
+            float oldArea = getNodeBounds(node).getArea();
+            if (!setNodeBounds(node, bounds))
+            {
+                break;
+            }
+            currentArea += bounds.getArea() - oldArea;
+        }
+    }
+    dirtyLeaves.clear();
+}
+
+void SceneObjects::fitLeaf(uint32_t leaf)
+{
+    BVHNode& node = nodes[leaf];
+    Bounds bounds;
+    for (uint32_t slot = node.firstObject; slot < node.firstObject + node.objectCount; slot++)
+    {
+        uint32_t object = slotObjects[slot];
+        bounds.grow(centers[object], extents[object]);
+    }
+    currentArea += bounds.getArea() - getNodeBounds(node).getArea();
+    setNodeBounds(node, bounds);
+}
+
+void SceneObjects::writeSlot(uint32_t slot)
+{
+    uint32_t object = slotObjects[slot];
+    float* rows = slotBounds.data() + slot;
+    rows[SLOT_CENTER_X * slotStride] = centers[object].x;
+    rows[SLOT_CENTER_Y * slotStride] = centers[object].y;
+    rows[SLOT_CENTER_Z * slotStride] = centers[object].z;
+    rows[SLOT_EXTENT_X * slotStride] = extents[object].x;
+    rows[SLOT_EXTENT_Y * slotStride] = extents[object].y;
+    rows[SLOT_EXTENT_Z * slotStride] = extents[object].z;
+}
+
+void SceneObjects::testSlots(const float (*planes)[4], uint32_t planeMask, uint32_t firstSlot, uint32_t slotCount,
+                             std::vector<uint32_t>* pVisible) const
+{
+    const float* rows[SLOT_ROW_COUNT];
+    for (uint32_t row = 0; row < SLOT_ROW_COUNT; row++)
+    {
+        rows[row] = slotBounds.data() + (size_t)row * slotStride;
+    }
+    // A copy, as std::min would bind the in-class constant to a reference that has no definition to refer to.
+    const uint32_t width = FloatLanes::WIDTH;
+    FloatLanes zero = FloatLanes::set(0.0f);
+    for (uint32_t i = 0; i < slotCount; i += width)
+    {
+        uint32_t slot = firstSlot + i;
+        uint32_t laneCount = std::min(width, slotCount - i);
+        FloatLanes centerX = FloatLanes::load(rows[SLOT_CENTER_X] + slot);
+        FloatLanes centerY = FloatLanes::load(rows[SLOT_CENTER_Y] + slot);
+        FloatLanes centerZ = FloatLanes::load(rows[SLOT_CENTER_Z] + slot);
+        FloatLanes extentX = FloatLanes::load(rows[SLOT_EXTENT_X] + slot);
+        FloatLanes extentY = FloatLanes::load(rows[SLOT_EXTENT_Y] + slot);
+        FloatLanes extentZ = FloatLanes::load(rows[SLOT_EXTENT_Z] + slot);
+        uint32_t visible = (1u << laneCount) - 1;
+        for (uint32_t plane = 0; plane < 6 && visible; plane++)
+        {
+            if (!(planeMask & (1u << plane)))
+            {
+                continue;
+            }
+            const float* p = planes[plane];
+            FloatLanes distance = centerX * FloatLanes::set(p[0]) + centerY * FloatLanes::set(p[1]) +
+                centerZ * FloatLanes::set(p[2]) + FloatLanes::set(p[3]);
+            FloatLanes reach = extentX * FloatLanes::set(fabsf(p[0])) + extentY * FloatLanes::set(fabsf(p[1])) +
+                extentZ * FloatLanes::set(fabsf(p[2]));
+            visible &= (uint32_t)(distance + reach >= zero).getMask();
+        }
+        for (uint32_t lane = 0; visible; visible >>= 1, lane++)
+        {
+            if (visible & 1)
+            {
+                pVisible->push_back(slotObjects[slot + lane]);
+            }
+        }
+    }
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "../RenderDevice/RenderMath.h"
+
+// Leaves own objects[firstObject, firstObject + objectCount) of the leaf order; inner nodes cover the same range as
+// their two children, firstChild and firstChild + 1.
+struct BVHNode
+{
+    Float3 boundsMin;
+    uint32_t firstObject = 0;
+    Float3 boundsMax;
+    uint32_t objectCount = 0;
+    uint32_t firstChild = 0;
+    uint32_t parent = 0;
+};
+
+struct CullStats
+{
+    uint32_t visibleObjects = 0;
+    uint32_t visitedNodes = 0;
+    uint32_t testedObjects = 0;
+};
+
+// Axis-aligned bounding boxes of the objects of a scene, kept in a bounding volume hierarchy for frustum culling.
+// The hierarchy is built with a binned surface area heuristic after objects are added. Moving objects only refits
+// the nodes above them, until refitting has made the nodes twice as large in total as when they were built.
+// Culling skips the planes a node is already inside of, takes whole subtrees inside the frustum without testing
+// them, and tests the boxes of a leaf FloatLanes::WIDTH at a time.
+class SceneObjects
+{
+public:
+    static const uint32_t LEAF_SIZE = 8;
+
+    SceneObjects();
+
+private:
+    // Indexed by object id.
+    std::vector<Float3> centers;
+    std::vector<Float3> extents;
+    std::vector<uint32_t> objectSlots;
+
+    // Indexed by slot, the position of an object in the leaf order. The boxes are rows of a structure of arrays,
+    // padded so a leaf can always load whole lanes.
+    std::vector<uint32_t> slotObjects;
+    std::vector<uint32_t> slotLeaves;
+    std::vector<float> slotBounds;
+    uint32_t slotStride = 0;
+
+    std::vector<BVHNode> nodes;
+    std::vector<uint8_t> leafDirty;
+    std::vector<uint32_t> dirtyLeaves;
+    bool structureDirty = false;
+    float builtArea = 0.0f;
+    float currentArea = 0.0f;
+    uint32_t buildCount = 0;
+
+public:
+    // Returns the id of the object, counting up from zero.
+    uint32_t add(const Float3& boundsMin, const Float3& boundsMax);
+    void setBounds(uint32_t id, const Float3& boundsMin, const Float3& boundsMax);
+    void clear();
+    uint32_t getObjectCount() const;
+
+    // Builds the hierarchy after objects were added, otherwise refits the nodes above the objects that moved.
+    void update();
+    // Replaces pVisible with the ids of the objects whose box is not entirely outside one of the frustum planes of
+    // viewProjection, in leaf order. The hierarchy must be up to date.
+    void cull(const Float4x4& viewProjection, std::vector<uint32_t>* pVisible, CullStats* pStats = nullptr) const;
+    // The same test on every object, without the hierarchy.
+    void cullLinear(const Float4x4& viewProjection, std::vector<uint32_t>* pVisible) const;
+
+    uint32_t getNodeCount() const;
+    uint32_t getBuildCount() const;
+    // Total surface area of the nodes relative to when they were built.
+    float getAreaRatio() const;
+
+private:
+    void build();
+    void refit();
+    void fitLeaf(uint32_t leaf);
+    void writeSlot(uint32_t slot);
+    void testSlots(const float (*planes)[4], uint32_t planeMask, uint32_t firstSlot, uint32_t slotCount,
+                   std::vector<uint32_t>* pVisible) const;
+};
@@ -0,0 +1,287 @@
+#include "FrameGraph.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+bool FrameGraphTextureDesc::operator==(const FrameGraphTextureDesc& other) const
+{
+    return width == other.width && height == other.height && format == other.format && usage == other.usage;
+}
+
+bool FrameGraphTextureDesc::operator!=(const FrameGraphTextureDesc& other) const
+{
+    return !(*this == other);
+}
+
+FrameGraphResource FrameGraph::importTexture(const std::string& name, const FrameGraphTextureDesc& desc)
+{
+    return addResource(name, desc, true);
+}
+
+FrameGraphResource FrameGraph::createTexture(const std::string& name, const FrameGraphTextureDesc& desc)
+{
+    return addResource(name, desc, false);
+}
+
+FrameGraphResource FrameGraph::addResource(const std::string& name, const FrameGraphTextureDesc& desc, bool imported)
+{
+    ResourceNode resource;
+    resource.name = name;
+    resource.desc = desc;
+    resource.imported = imported;
+    resources.push_back(resource);
+    compiled = false;
+    return (FrameGraphResource)(resources.size() - 1);
+}
+
+FrameGraphPass FrameGraph::addPass(const std::string& name, std::function<void()> execute, bool hasSideEffects)
+{
+    PassNode pass;
+    pass.name = name;
+    pass.execute = std::move(execute);
+    pass.hasSideEffects = hasSideEffects;
+    passes.push_back(std::move(pass));
+    compiled = false;
+    return (FrameGraphPass)(passes.size() - 1);
+}
+
+void FrameGraph::read(FrameGraphPass pass, FrameGraphResource resource)
+{
+    if (pass >= passes.size() || resource >= resources.size())
+    {
+        throw std::runtime_error("Failed to declare frame graph read: unknown pass or resource");
+    }
+    auto& reads = passes[pass].reads;
+    if (std::find(reads.begin(), reads.end(), resource) == reads.end())
+    {
+        reads.push_back(resource);
+    }
+    compiled = false;
+}
+
+void FrameGraph::write(FrameGraphPass pass, FrameGraphResource resource)
+{
+    if (pass >= passes.size() || resource >= resources.size())
+    {
+        throw std::runtime_error("Failed to declare frame graph write: unknown pass or resource");
+    }
+    auto& writes = passes[pass].writes;
+    if (std::find(writes.begin(), writes.end(), resource) == writes.end())
+    {
+        writes.push_back(resource);
+        resources[resource].writers.push_back(pass);
+    }
+    compiled = false;
+}
+
+void FrameGraph::compile()
+{
+    validate();
+    cullPasses();
+    assignPhysicalTextures();
+    compiled = true;
+}
+
+void FrameGraph::validate() const
+{
+    for (FrameGraphPass pass = 0; pass < passes.size(); pass++)
+    {
+        for (FrameGraphResource resource : passes[pass].reads)
+        {
+            const ResourceNode& node = resources[resource];
+            if (!node.imported && (node.writers.empty() || node.writers.front() >= pass))
+            {
+                throw std::runtime_error("Frame graph pass " + passes[pass].name + " reads " + node.name +
+                                         " before any earlier pass writes it");
+            }
+        }
+    }
+}
+
+void FrameGraph::cullPasses()
+{
+    std::vector<uint32_t> passReferences(passes.size());
+    std::vector<uint32_t> resourceReferences(resources.size());
+    std::vector<bool> roots(passes.size());
+    for (FrameGraphPass pass = 0; pass < passes.size(); pass++)
+    {
+        passes[pass].culled = false;
+        passReferences[pass] = (uint32_t)passes[pass].writes.size();
+        roots[pass] = passes[pass].hasSideEffects;
+        for (FrameGraphResource resource : passes[pass].writes)
+        {
+            roots[pass] = roots[pass] || resources[resource].imported;
+        }
+        for (FrameGraphResource resource : passes[pass].reads)
+        {
+            resourceReferences[resource]++;
+        }
+    }
+    for (ResourceNode& resource : resources)
+    {
+        resource.readerCount = resourceReferences[&resource - resources.data()];
+    }
+
+    // Walk back from every texture nobody reads, releasing the passes that only existed to produce it.
+    std::vector<FrameGraphResource> unreferenced;
+    for (FrameGraphResource resource = 0; resource < resources.size(); resource++)
+    {
+        if (resourceReferences[resource] == 0 && !resources[resource].imported)
+        {
+            unreferenced.push_back(resource);
+        }
+    }
+    auto cull = [&](FrameGraphPass pass)
+    {
+        passes[pass].culled = true;
+        for (FrameGraphResource resource : passes[pass].reads)
+        {
+            if (--resourceReferences[resource] == 0 && !resources[resource].imported)
+            {
+                unreferenced.push_back(resource);
+            }
+        }
+    };
+    for (FrameGraphPass pass = 0; pass < passes.size(); pass++)
+    {
+        if (passReferences[pass] == 0 && !roots[pass])
+        {
+            cull(pass);
+        }
+    }
+    while (!unreferenced.empty())
+    {
+        FrameGraphResource resource = unreferenced.back();
+        unreferenced.pop_back();
+        for (FrameGraphPass writer : resources[resource].writers)
+        {
+            if (!passes[writer].culled && --passReferences[writer] == 0 && !roots[writer])
+            {
+                cull(writer);
+            }
+        }
+    }
+}
+
+void FrameGraph::assignPhysicalTextures()
+{
+    const uint32_t unused = UINT32_MAX;
+    std::vector<uint32_t> firstUse(resources.size(), unused);
+    std::vector<uint32_t> lastUse(resources.size(), unused);
+    for (FrameGraphPass pass = 0; pass < passes.size(); pass++)
+    {
+        if (passes[pass].culled)
+        {
+            continue;
+        }
+        for (const auto* accesses : {&passes[pass].reads, &passes[pass].writes})
+        {
+            for (FrameGraphResource resource : *accesses)
+            {
+                if (firstUse[resource] == unused)
+                {
+                    firstUse[resource] = pass;
+                }
+                lastUse[resource] = pass;
+            }
+        }
+    }
+
+    physicalTextures.clear();
+    std::vector<uint32_t> freeTextures;
+    for (FrameGraphPass pass = 0; pass < passes.size(); pass++)
+    {
+        for (FrameGraphResource resource = 0; resource < resources.size(); resource++)
+        {
+            ResourceNode& node = resources[resource];
+            if (node.imported || firstUse[resource] != pass)
+            {
+                continue;
+            }
+            auto match = std::find_if(freeTextures.begin(), freeTextures.end(), [&](uint32_t texture)
+            {
+                return physicalTextures[texture] == node.desc;
+            });
+            if (match != freeTextures.end())
+            {
+                node.physicalTexture = *match;
+                freeTextures.erase(match);
+            }
+            else
+            {
+                node.physicalTexture = (uint32_t)physicalTextures.size();
+                physicalTextures.push_back(node.desc);
+            }
+        }
+        for (FrameGraphResource resource = 0; resource < resources.size(); resource++)
+        {
+            if (!resources[resource].imported && lastUse[resource] == pass)
+            {
+                freeTextures.push_back(resources[resource].physicalTexture);
+            }
+        }
+    }
+    for (FrameGraphResource resource = 0; resource < resources.size(); resource++)
+    {
+        if (firstUse[resource] == unused)
+        {
+            resources[resource].physicalTexture = NO_PHYSICAL_TEXTURE;
+        }
+    }
+}
+
+void FrameGraph::execute() const
+{
+    if (!compiled)
+    {
+        throw std::runtime_error("Frame graph executed before compile");
+    }
+    for (const PassNode& pass : passes)
+    {
+        if (!pass.culled && pass.execute)
+        {
+            pass.execute();
+        }
+    }
+}
+
+bool FrameGraph::isCulled(FrameGraphPass pass) const
+{
+    return passes[pass].culled;
+}
+
+uint32_t FrameGraph::getPhysicalTexture(FrameGraphResource resource) const
+{
+    return resources[resource].physicalTexture;
+}
+
+const FrameGraphTextureDesc& FrameGraph::getDesc(FrameGraphResource resource) const
+{
+    return resources[resource].desc;
+}
+
+const std::vector<FrameGraphTextureDesc>& FrameGraph::getPhysicalTextures() const
+{
+    return physicalTextures;
+}
+
+const std::string& FrameGraph::getPassName(FrameGraphPass pass) const
+{
+    return passes[pass].name;
+}
+
+FrameGraphStats FrameGraph::getStats() const
+{
+    FrameGraphStats stats;
+    stats.passCount = (uint32_t)passes.size();
+    for (const PassNode& pass : passes)
+    {
+        stats.culledPassCount += pass.culled;
+    }
+    for (const ResourceNode& resource : resources)
+    {
+        stats.transientTextureCount += !resource.imported && resource.physicalTexture != NO_PHYSICAL_TEXTURE;
+    }
+    stats.physicalTextureCount = (uint32_t)physicalTextures.size();
+    return stats;
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+using FrameGraphResource = uint32_t;
+using FrameGraphPass = uint32_t;
+
+struct FrameGraphTextureDesc
+{
+    uint32_t width = 0;
+    uint32_t height = 0;
+    // Backend format and usage values; the graph only compares them.
+    uint32_t format = 0;
+    uint32_t usage = 0;
+
+    bool operator==(const FrameGraphTextureDesc& other) const;
+    bool operator!=(const FrameGraphTextureDesc& other) const;
+};
+
+struct FrameGraphStats
+{
+    uint32_t passCount = 0;
+    uint32_t culledPassCount = 0;
+    uint32_t transientTextureCount = 0;
+    uint32_t physicalTextureCount = 0;
+};
+
+// Passes declare the textures they read and write and run in the order they were added. compile() drops passes
+// whose results nothing consumes, computes the lifetime of every transient texture and lets transients with equal
+// descriptions and disjoint lifetimes share one physical texture. Passes with side effects, and passes writing an
+// imported texture, are always kept. The graph never touches a GPU: the backend creates getPhysicalTextures() and
+// resolves resources with getPhysicalTexture().
+class FrameGraph
+{
+public:
+    static const uint32_t NO_PHYSICAL_TEXTURE = UINT32_MAX;
+
+    FrameGraphResource importTexture(const std::string& name, const FrameGraphTextureDesc& desc);
+    FrameGraphResource createTexture(const std::string& name, const FrameGraphTextureDesc& desc);
+    FrameGraphPass addPass(const std::string& name, std::function<void()> execute, bool hasSideEffects = false);
+    void read(FrameGraphPass pass, FrameGraphResource resource);
+    void write(FrameGraphPass pass, FrameGraphResource resource);
+
+    void compile();
+    void execute() const;
+
+    bool isCulled(FrameGraphPass pass) const;
+    uint32_t getPhysicalTexture(FrameGraphResource resource) const;
+    const FrameGraphTextureDesc& getDesc(FrameGraphResource resource) const;
+    const std::vector<FrameGraphTextureDesc>& getPhysicalTextures() const;
+    const std::string& getPassName(FrameGraphPass pass) const;
+    FrameGraphStats getStats() const;
+
+private:
+    struct ResourceNode
+    {
+        std::string name;
+        FrameGraphTextureDesc desc;
+        bool imported = false;
+        std::vector<FrameGraphPass> writers;
+        uint32_t readerCount = 0;
+        uint32_t physicalTexture = NO_PHYSICAL_TEXTURE;
+    };
+
+    struct PassNode
+    {
+        std::string name;
+        std::function<void()> execute;
+        bool hasSideEffects = false;
+        std::vector<FrameGraphResource> reads;
+        std::vector<FrameGraphResource> writes;
+        bool culled = false;
+    };
+
+    std::vector<ResourceNode> resources;
+    std::vector<PassNode> passes;
+    std::vector<FrameGraphTextureDesc> physicalTextures;
+    bool compiled = false;
+
+    FrameGraphResource addResource(const std::string& name, const FrameGraphTextureDesc& desc, bool imported);
+    void validate() const;
+    void cullPasses();
+    void assignPhysicalTextures();
+};
@@ -0,0 +1,72 @@
+#include "TransientTexturePool.h"
+
+#include <stdexcept>
+
+void TransientTexturePool::realize(const FrameGraph& frameGraph)
+{
+    const std::vector<FrameGraphTextureDesc>& physicalTextures = frameGraph.getPhysicalTextures();
+    for (size_t i = physicalTextures.size(); i < textures.size(); i++)
+    {
+        device->destroyTexture(textures[i]);
+    }
+    textures.resize(physicalTextures.size(), RENDER_NULL_HANDLE);
+    descs.resize(physicalTextures.size());
+    for (size_t i = 0; i < physicalTextures.size(); i++)
+    {
+        if (textures[i] && descs[i] == physicalTextures[i])
+        {
+            continue;
+        }
+        if (textures[i])
+        {
+            device->destroyTexture(textures[i]);
+        }
+        textures[i] = device->createTexture(makeTextureDesc(physicalTextures[i]));
+        descs[i] = physicalTextures[i];
+    }
+}
+
+RenderTexture TransientTexturePool::getTexture(const FrameGraph& frameGraph, FrameGraphResource resource) const
+{
+    uint32_t physicalTexture = frameGraph.getPhysicalTexture(resource);
+    if (physicalTexture >= textures.size())
+    {
+        throw std::runtime_error("Failed to find transient texture: the resource is culled or not realized");
+    }
+    return textures[physicalTexture];
+}
+
+uint64_t TransientTexturePool::getAllocatedBytes() const
+{
+    uint64_t bytes = 0;
+    for (const FrameGraphTextureDesc& desc : descs)
+    {
+        bytes += RenderDevice::getTextureBytes(makeTextureDesc(desc));
+    }
+    return bytes;
+}
+
+void TransientTexturePool::release()
+{
+    for (RenderTexture texture : textures)
+    {
+        if (texture)
+        {
+            device->destroyTexture(texture);
+        }
+    }
+    textures.clear();
+    descs.clear();
+}
+
+RenderTextureDesc TransientTexturePool::makeTextureDesc(const FrameGraphTextureDesc& desc)
+{
+    RenderTextureDesc textureDesc;
+    textureDesc.width = desc.width;
+    textureDesc.height = desc.height;
+    textureDesc.format = (RenderFormat)desc.format;
+    textureDesc.bindFlags = desc.usage;
+    textureDesc.name = "Frame graph transient";
+    textureDesc.memoryCategory = "Frame graph transients";
+    return textureDesc;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <vector>
+
+#include "FrameGraph.h"
+#include "../RenderDevice/RenderDevice.h"
+
+// RenderDevice backing for the transient textures of a compiled FrameGraph. Descriptions use RenderFormat values as
+// the format and RenderBindFlags as the usage. Textures survive between frames and are only recreated when the graph
+// asks for a different description.
+class TransientTexturePool
+{
+public:
+    explicit TransientTexturePool(RenderDevice* device) : device(device)
+    {
+    }
+
+    void realize(const FrameGraph& frameGraph);
+    RenderTexture getTexture(const FrameGraph& frameGraph, FrameGraphResource resource) const;
+    uint64_t getAllocatedBytes() const;
+    void release();
+
+    static RenderTextureDesc makeTextureDesc(const FrameGraphTextureDesc& desc);
+
+private:
+    RenderDevice* device;
+    std::vector<FrameGraphTextureDesc> descs;
+    std::vector<RenderTexture> textures;
+};
@@ -0,0 +1,74 @@
+#include "BRDFLut.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include "../../Utils/HalfFloat.h"
+
+void BRDFLut::pack(const std::vector<float>& rgbaTexels, std::vector<uint16_t>* pOutput)
+{
+    size_t texelCount = rgbaTexels.size() / 4;
+    pOutput->resize(texelCount * 2);
+    for (size_t i = 0; i < texelCount; i++)
+    {
+        (*pOutput)[i * 2] = HalfFloat::fromFloat(rgbaTexels[i * 4]);
+        (*pOutput)[i * 2 + 1] = HalfFloat::fromFloat(rgbaTexels[i * 4 + 1]);
+    }
+}
+
+void BRDFLut::generateAnalytic(uint32_t size, std::vector<uint16_t>* pOutput)
+{
+    // Karis' fitted approximation of the split-sum integral, used when no baked table ships with the build.
+    pOutput->resize((size_t)size * size * 2);
+    for (uint32_t y = 0; y < size; y++)
+    {
+        float roughness = (y + 0.5f) / size;
+        float rx = roughness * -1.0f + 1.0f;
+        float ry = roughness * -0.0275f + 0.0425f;
+        float rz = roughness * -0.572f + 1.04f;
+        float rw = roughness * 0.022f - 0.04f;
+        for (uint32_t x = 0; x < size; x++)
+        {
+            float dotNV = (x + 0.5f) / size;
+            float a004 = std::min(rx * rx, exp2f(-9.28f * dotNV)) * rx + ry;
+            uint16_t* texel = pOutput->data() + ((size_t)y * size + x) * 2;
+            texel[0] = HalfFloat::fromFloat(a004 * -1.04f + rz);
+            texel[1] = HalfFloat::fromFloat(a004 * 1.04f + rw);
+        }
+    }
+}
+
+bool BRDFLut::write(const std::string& path, uint32_t size, const std::vector<uint16_t>& texels)
+{
+    std::ofstream file(path, std::ios::binary);
+    if (!file || texels.size() != (size_t)size * size * 2)
+    {
+        return false;
+    }
+    BRDFLutHeader header = {};
+    header.magic = MAGIC;
+    header.version = VERSION;
+    header.size = size;
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(texels.data()), texels.size() * sizeof(uint16_t));
+    return (bool)file;
+}
+
+bool BRDFLut::read(const std::string& path, uint32_t* pSize, std::vector<uint16_t>* pTexels)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+    {
+        return false;
+    }
+    BRDFLutHeader header = {};
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!file || header.magic != MAGIC || header.version != VERSION || !header.size || header.size > 4096)
+    {
+        return false;
+    }
+    *pSize = header.size;
+    pTexels->resize((size_t)header.size * header.size * 2);
+    file.read(reinterpret_cast<char*>(pTexels->data()), pTexels->size() * sizeof(uint16_t));
+    return (bool)file;
+}
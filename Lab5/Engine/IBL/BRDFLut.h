@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct BRDFLutHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t size;
+    uint32_t reserved;
+};
+
+// Split-sum BRDF table stored as RG16F: column is NdotV, row is roughness, (scale, bias) per texel.
+class BRDFLut
+{
+public:
+    static const uint32_t MAGIC = 0x46445242; // "BRDF"
+    static const uint32_t VERSION = 1;
+    static const uint32_t DEFAULT_SIZE = 128;
+
+    static void pack(const std::vector<float>& rgbaTexels, std::vector<uint16_t>* pOutput);
+    static void generateAnalytic(uint32_t size, std::vector<uint16_t>* pOutput);
+    static bool write(const std::string& path, uint32_t size, const std::vector<uint16_t>& texels);
+    static bool read(const std::string& path, uint32_t* pSize, std::vector<uint16_t>* pTexels);
+};
@@ -0,0 +1,532 @@
+#include "CubemapBaker.h"
+
+#include <algorithm>
+#include "FloatLanes.h"
+
+using namespace IBLMath;
+
+namespace
+{
+    const uint32_t IRRADIANCE_SOURCE_MAX_SIZE = 64;
+    const uint32_t PREFILTER_SAMPLE_COUNT = 1024;
+    const uint32_t BRDF_SAMPLE_COUNT = 1024;
+
+    Vec3 loadTexel(const float* texels, uint32_t size, int x, int y)
+    {
+        x = std::min(std::max(x, 0), (int)size - 1);
+        y = std::min(std::max(y, 0), (int)size - 1);
+        const float* texel = texels + ((size_t)y * size + x) * 4;
+        return Vec3(texel[0], texel[1], texel[2]);
+    }
+
+    Vec3 sampleEquirectangular(const float* pixels, uint32_t width, uint32_t height, float u, float v)
+    {
+        float x = u * width - 0.5f;
+        float y = v * height - 0.5f;
+        float x0 = floorf(x);
+        float y0 = floorf(y);
+        float fx = x - x0;
+        float fy = y - y0;
+        Vec3 result;
+        for (uint32_t i = 0; i < 4; i++)
+        {
+            int sx = (int)x0 + (int)(i & 1);
+            int sy = (int)y0 + (int)(i >> 1);
+            sx = ((sx % (int)width) + (int)width) % (int)width;
+            sy = std::min(std::max(sy, 0), (int)height - 1);
+            const float* pixel = pixels + ((size_t)sy * width + sx) * 4;
+            float weight = (i & 1 ? fx : 1.0f - fx) * (i >> 1 ? fy : 1.0f - fy);
+            result += Vec3(pixel[0], pixel[1], pixel[2]) * weight;
+        }
+        return result;
+    }
+
+    void storeTexel(float* texel, const Vec3& color)
+    {
+        texel[0] = color.x;
+        texel[1] = color.y;
+        texel[2] = color.z;
+        texel[3] = 1.0f;
+    }
+
+    // Everything in prefilterCube.hlsl that depends only on the sample index and roughness. With N = V = R the
+    // half vector always makes angle theta with N, so dotNL, the pdf and the source lod are shared by all texels.
+    struct PrefilterSample
+    {
+        float cosPhi;
+        float sinPhi;
+        float sinTheta;
+        float cosTheta;
+        float weight;
+        uint32_t lowerMip;
+        float mipFraction;
+    };
+
+    std::vector<PrefilterSample> buildPrefilterSamples(const CpuCubemap& source, float roughness)
+    {
+        std::vector<PrefilterSample> samples;
+        float alpha = roughness * roughness;
+        float omegaP = 4.0f * PI / (6.0f * source.size * source.size);
+        for (uint32_t i = 0; i < PREFILTER_SAMPLE_COUNT; i++)
+        {
+            float xiX, xiY;
+            hammersley2d(i, PREFILTER_SAMPLE_COUNT, &xiX, &xiY);
+            float cosTheta = sqrtf((1.0f - xiY) / (1.0f + (alpha * alpha - 1.0f) * xiY));
+            float dotNL = clamp(2.0f * cosTheta * cosTheta - 1.0f, 0.0f, 1.0f);
+            if (dotNL <= 0.0f)
+            {
+                continue;
+            }
+            float pdf = distributeGGX(cosTheta, roughness) * cosTheta / (4.0f * cosTheta) + 0.0001f;
+            float omegaS = 1.0f / ((float)PREFILTER_SAMPLE_COUNT * pdf);
+            float lod = clamp(0.5f * log2f(omegaS / omegaP) + 1.0f, 0.0f, (float)(source.mipLevels - 1));
+
+            PrefilterSample sample;
+            sample.cosPhi = cosf(2.0f * PI * xiX);
+            sample.sinPhi = sinf(2.0f * PI * xiX);
+            sample.cosTheta = cosTheta;
+            sample.sinTheta = sqrtf(1.0f - cosTheta * cosTheta);
+            sample.weight = dotNL;
+            sample.lowerMip = std::min((uint32_t)lod, source.mipLevels - 1);
+            sample.mipFraction = sample.lowerMip + 1 < source.mipLevels ? lod - (float)sample.lowerMip : 0.0f;
+            samples.push_back(sample);
+        }
+        return samples;
+    }
+
+    // Vectorised directionToCubeFace, with the face index returned as a float lane.
+    void directionToCubeFaceLanes(const FloatLanes& x, const FloatLanes& y, const FloatLanes& z, FloatLanes* pFace,
+                                  FloatLanes* pU, FloatLanes* pV)
+    {
+        FloatLanes zero = FloatLanes::set(0.0f);
+        FloatLanes ax = FloatLanes::abs(x);
+        FloatLanes ay = FloatLanes::abs(y);
+        FloatLanes az = FloatLanes::abs(z);
+        FloatLanes xMajor = (ax >= ay) & (ax >= az);
+        FloatLanes yMajor = ay >= az;
+        FloatLanes xPositive = x >= zero;
+        FloatLanes yPositive = y >= zero;
+        FloatLanes zPositive = z >= zero;
+
+        FloatLanes face = FloatLanes::select(zPositive, FloatLanes::set(4.0f), FloatLanes::set(5.0f));
+        FloatLanes sc = FloatLanes::select(zPositive, x, zero - x);
+        FloatLanes tc = zero - y;
+        FloatLanes ma = az;
+
+        face = FloatLanes::select(yMajor, FloatLanes::select(yPositive, FloatLanes::set(2.0f), FloatLanes::set(3.0f)),
+                                  face);
+        sc = FloatLanes::select(yMajor, x, sc);
+        tc = FloatLanes::select(yMajor, FloatLanes::select(yPositive, z, zero - z), tc);
+        ma = FloatLanes::select(yMajor, ay, ma);
+
+        face = FloatLanes::select(xMajor, FloatLanes::select(xPositive, zero, FloatLanes::set(1.0f)), face);
+        sc = FloatLanes::select(xMajor, FloatLanes::select(xPositive, zero - z, z), sc);
+        tc = FloatLanes::select(xMajor, zero - y, tc);
+        ma = FloatLanes::select(xMajor, ax, ma);
+
+        FloatLanes half = FloatLanes::set(0.5f);
+        FloatLanes one = FloatLanes::set(1.0f);
+        *pFace = face;
+        *pU = half * (sc / ma + one);
+        *pV = half * (tc / ma + one);
+    }
+
+    // Filters one row of one face, FloatLanes::WIDTH texels at a time. Direction math runs in lanes; the cube
+    // fetches stay scalar since the sample footprints are scattered.
+    void prefilterRow(const CpuCubemap& source, const std::vector<PrefilterSample>& samples, uint32_t face,
+                      uint32_t y, uint32_t mipSize, float* pTexels)
+    {
+        const uint32_t width = FloatLanes::WIDTH;
+        float totalWeight = 0.0f;
+        for (const auto& sample : samples)
+        {
+            totalWeight += sample.weight;
+        }
+        for (uint32_t x = 0; x < mipSize; x += width)
+        {
+            float laneData[15][width];
+            for (uint32_t lane = 0; lane < width; lane++)
+            {
+                uint32_t laneX = std::min(x + lane, mipSize - 1);
+                Vec3 normal = normalize(cubeFaceDirection(face, 2.0f * (laneX + 0.5f) / mipSize - 1.0f,
+                                                          2.0f * (y + 0.5f) / mipSize - 1.0f));
+                Vec3 up = fabsf(normal.z) < 0.999f ? Vec3(0.0f, 0.0f, 1.0f) : Vec3(1.0f, 0.0f, 0.0f);
+                Vec3 tangentX = normalize(cross(up, normal));
+                Vec3 tangentY = normalize(cross(normal, tangentX));
+                float phiOffset = random(normal.x, normal.z) * 0.1f;
+                float values[] = {normal.x, normal.y, normal.z, tangentX.x, tangentX.y, tangentX.z,
+                                  tangentY.x, tangentY.y, tangentY.z, cosf(phiOffset), sinf(phiOffset)};
+                for (uint32_t i = 0; i < 11; i++)
+                {
+                    laneData[i][lane] = values[i];
+                }
+            }
+            FloatLanes normalX = FloatLanes::load(laneData[0]);
+            FloatLanes normalY = FloatLanes::load(laneData[1]);
+            FloatLanes normalZ = FloatLanes::load(laneData[2]);
+            FloatLanes tangentXX = FloatLanes::load(laneData[3]);
+            FloatLanes tangentXY = FloatLanes::load(laneData[4]);
+            FloatLanes tangentXZ = FloatLanes::load(laneData[5]);
+            FloatLanes tangentYX = FloatLanes::load(laneData[6]);
+            FloatLanes tangentYY = FloatLanes::load(laneData[7]);
+            FloatLanes tangentYZ = FloatLanes::load(laneData[8]);
+            FloatLanes cosOffset = FloatLanes::load(laneData[9]);
+            FloatLanes sinOffset = FloatLanes::load(laneData[10]);
+
+            Vec3 colors[width];
+            for (const auto& sample : samples)
+            {
+                // cos/sin of (2 PI xi + offset) by angle addition, so no transcendental runs per sample.
+                FloatLanes cosPhi = FloatLanes::set(sample.cosPhi) * cosOffset - FloatLanes::set(sample.sinPhi) *
+                    sinOffset;
+                FloatLanes sinPhi = FloatLanes::set(sample.sinPhi) * cosOffset + FloatLanes::set(sample.cosPhi) *
+                    sinOffset;
+                FloatLanes hx = FloatLanes::set(sample.sinTheta) * cosPhi;
+                FloatLanes hy = FloatLanes::set(sample.sinTheta) * sinPhi;
+                FloatLanes hz = FloatLanes::set(sample.cosTheta);
+                FloatLanes halfX = tangentXX * hx + tangentYX * hy + normalX * hz;
+                FloatLanes halfY = tangentXY * hx + tangentYY * hy + normalY * hz;
+                FloatLanes halfZ = tangentXZ * hx + tangentYZ * hy + normalZ * hz;
+                FloatLanes twoCosTheta = FloatLanes::set(2.0f * sample.cosTheta);
+
+                FloatLanes sampleFace, u, v;
+                directionToCubeFaceLanes(halfX * twoCosTheta - normalX, halfY * twoCosTheta - normalY,
+                                         halfZ * twoCosTheta - normalZ, &sampleFace, &u, &v);
+                sampleFace.store(laneData[11]);
+                u.store(laneData[12]);
+                v.store(laneData[13]);
+                for (uint32_t lane = 0; lane < width; lane++)
+                {
+                    uint32_t laneFace = (uint32_t)laneData[11][lane];
+                    Vec3 color = source.sampleFaceBilinear(laneFace, laneData[12][lane], laneData[13][lane],
+                                                           sample.lowerMip);
+                    if (sample.mipFraction > 0.0f)
+                    {
+                        color = color * (1.0f - sample.mipFraction) +
+                            source.sampleFaceBilinear(laneFace, laneData[12][lane], laneData[13][lane],
+                                                      sample.lowerMip + 1) * sample.mipFraction;
+                    }
+                    colors[lane] += color * sample.weight;
+                }
+            }
+            for (uint32_t lane = 0; lane < width && x + lane < mipSize; lane++)
+            {
+                storeTexel(pTexels + (x + lane) * 4, colors[lane] * (1.0f / totalWeight));
+            }
+        }
+    }
+}
+
+void CpuCubemap::allocate(uint32_t sideSize, uint32_t mipAmount)
+{
+    size = sideSize;
+    mipLevels = mipAmount;
+    size_t faceFloats = 0;
+    for (uint32_t mip = 0; mip < mipLevels; mip++)
+    {
+        faceFloats += (size_t)getMipSize(mip) * getMipSize(mip) * 4;
+    }
+    texels.assign(faceFloats * 6, 0.0f);
+}
+
+uint32_t CpuCubemap::getMipSize(uint32_t mip) const
+{
+    return std::max(size >> mip, 1u);
+}
+
+size_t CpuCubemap::getSubresourceOffset(uint32_t face, uint32_t mip) const
+{
+    size_t faceFloats = texels.size() / 6;
+    size_t offset = faceFloats * face;
+    for (uint32_t i = 0; i < mip; i++)
+    {
+        offset += (size_t)getMipSize(i) * getMipSize(i) * 4;
+    }
+    return offset;
+}
+
+float* CpuCubemap::getTexels(uint32_t face, uint32_t mip)
+{
+    return texels.data() + getSubresourceOffset(face, mip);
+}
+
+const float* CpuCubemap::getTexels(uint32_t face, uint32_t mip) const
+{
+    return texels.data() + getSubresourceOffset(face, mip);
+}
+
+Vec3 CpuCubemap::sampleBilinear(const Vec3& direction, uint32_t mip) const
+{
+    float u, v;
+    uint32_t face = directionToCubeFace(direction, &u, &v);
+    return sampleFaceBilinear(face, u, v, mip);
+}
+
+Vec3 CpuCubemap::sampleFaceBilinear(uint32_t face, float u, float v, uint32_t mip) const
+{
+    uint32_t mipSize = getMipSize(mip);
+    const float* faceTexels = getTexels(face, mip);
+    float x = u * mipSize - 0.5f;
+    float y = v * mipSize - 0.5f;
+    float x0 = floorf(x);
+    float y0 = floorf(y);
+    float fx = x - x0;
+    float fy = y - y0;
+    Vec3 top = loadTexel(faceTexels, mipSize, (int)x0, (int)y0) * (1.0f - fx) +
+        loadTexel(faceTexels, mipSize, (int)x0 + 1, (int)y0) * fx;
+    Vec3 bottom = loadTexel(faceTexels, mipSize, (int)x0, (int)y0 + 1) * (1.0f - fx) +
+        loadTexel(faceTexels, mipSize, (int)x0 + 1, (int)y0 + 1) * fx;
+    return top * (1.0f - fy) + bottom * fy;
+}
+
+Vec3 CpuCubemap::sampleTrilinear(const Vec3& direction, float lod) const
+{
+    lod = clamp(lod, 0.0f, (float)(mipLevels - 1));
+    uint32_t lowerMip = (uint32_t)lod;
+    float fraction = lod - (float)lowerMip;
+    Vec3 lower = sampleBilinear(direction, lowerMip);
+    if (fraction <= 0.0f || lowerMip + 1 >= mipLevels)
+    {
+        return lower;
+    }
+    return lower * (1.0f - fraction) + sampleBilinear(direction, lowerMip + 1) * fraction;
+}
+
+CubemapBaker::CubemapBaker(ThreadPool* threadPool) : threadPool(threadPool)
+{
+}
+
+void CubemapBaker::convertEquirectangular(const float* pixels, uint32_t width, uint32_t height, uint32_t sideSize,
+                                          CpuCubemap* pOutput)
+{
+    uint32_t mipAmount = 1;
+    while ((sideSize >> mipAmount) > 0)
+    {
+        mipAmount++;
+    }
+    pOutput->allocate(sideSize, mipAmount);
+    threadPool->parallelFor(6 * sideSize, [&](uint32_t row)
+    {
+        uint32_t face = row / sideSize;
+        uint32_t y = row % sideSize;
+        float* texels = pOutput->getTexels(face, 0) + (size_t)y * sideSize * 4;
+        for (uint32_t x = 0; x < sideSize; x++)
+        {
+            Vec3 pos = normalize(cubeFaceDirection(face, 2.0f * (x + 0.5f) / sideSize - 1.0f,
+                                                   2.0f * (y + 0.5f) / sideSize - 1.0f));
+            float u = 1.0f - atan2f(pos.z, pos.x) / (2.0f * PI);
+            float v = -atan2f(pos.y, sqrtf(pos.x * pos.x + pos.z * pos.z)) / PI + 0.5f;
+            storeTexel(texels + x * 4, sampleEquirectangular(pixels, width, height, u - floorf(u), v));
+        }
+    });
+}
+
+void CubemapBaker::generateMips(CpuCubemap* pCubemap)
+{
+    for (uint32_t mip = 1; mip < pCubemap->mipLevels; mip++)
+    {
+        uint32_t sourceSize = pCubemap->getMipSize(mip - 1);
+        uint32_t mipSize = pCubemap->getMipSize(mip);
+        threadPool->parallelFor(6, [&](uint32_t face)
+        {
+            const float* source = pCubemap->getTexels(face, mip - 1);
+            float* destination = pCubemap->getTexels(face, mip);
+            for (uint32_t y = 0; y < mipSize; y++)
+            {
+                for (uint32_t x = 0; x < mipSize; x++)
+                {
+                    Vec3 sum = loadTexel(source, sourceSize, x * 2, y * 2) +
+                        loadTexel(source, sourceSize, x * 2 + 1, y * 2) +
+                        loadTexel(source, sourceSize, x * 2, y * 2 + 1) +
+                        loadTexel(source, sourceSize, x * 2 + 1, y * 2 + 1);
+                    storeTexel(destination + ((size_t)y * mipSize + x) * 4, sum * 0.25f);
+                }
+            }
+        });
+    }
+}
+
+void CubemapBaker::renderIrradiance(const CpuCubemap& source, uint32_t sideSize, CpuCubemap* pOutput)
+{
+    // Brute-force reference for the SH irradiance: (1 / PI) * integral of L * cos over the hemisphere, evaluated
+    // as a solid-angle weighted sum over the texels of a small source mip.
+    uint32_t sourceMip = 0;
+    while (sourceMip + 1 < source.mipLevels && source.getMipSize(sourceMip) > IRRADIANCE_SOURCE_MAX_SIZE)
+    {
+        sourceMip++;
+    }
+    uint32_t sourceSize = source.getMipSize(sourceMip);
+    std::vector<Vec3> directions;
+    std::vector<Vec3> radiance;
+    for (uint32_t face = 0; face < 6; face++)
+    {
+        const float* texels = source.getTexels(face, sourceMip);
+        for (uint32_t y = 0; y < sourceSize; y++)
+        {
+            for (uint32_t x = 0; x < sourceSize; x++)
+            {
+                float u = 2.0f * (x + 0.5f) / sourceSize - 1.0f;
+                float v = 2.0f * (y + 0.5f) / sourceSize - 1.0f;
+                float solidAngle = texelSolidAngle(u, v, 2.0f / sourceSize);
+                directions.push_back(normalize(cubeFaceDirection(face, u, v)));
+                radiance.push_back(loadTexel(texels, sourceSize, x, y) * (solidAngle / PI));
+            }
+        }
+    }
+
+    pOutput->allocate(sideSize, 1);
+    threadPool->parallelFor(6 * sideSize, [&](uint32_t row)
+    {
+        uint32_t face = row / sideSize;
+        uint32_t y = row % sideSize;
+        float* texels = pOutput->getTexels(face, 0) + (size_t)y * sideSize * 4;
+        for (uint32_t x = 0; x < sideSize; x++)
+        {
+            Vec3 normal = normalize(cubeFaceDirection(face, 2.0f * (x + 0.5f) / sideSize - 1.0f,
+                                                      2.0f * (y + 0.5f) / sideSize - 1.0f));
+            Vec3 irradiance;
+            for (size_t i = 0; i < directions.size(); i++)
+            {
+                float cosTheta = dot(normal, directions[i]);
+                if (cosTheta > 0.0f)
+                {
+                    irradiance += radiance[i] * cosTheta;
+                }
+            }
+            storeTexel(texels + x * 4, irradiance);
+        }
+    });
+}
+
+void CubemapBaker::renderPrefiltered(const CpuCubemap& source, uint32_t sideSize, const std::vector<float>& roughness,
+                                     CpuCubemap* pOutput)
+{
+    pOutput->allocate(sideSize, (uint32_t)roughness.size());
+    // One flat job list over mips x faces x rows, largest mip first, so the small mips fill in idle threads.
+    std::vector<std::vector<PrefilterSample>> samples(pOutput->mipLevels);
+    std::vector<uint32_t> firstRows(pOutput->mipLevels + 1, 0);
+    for (uint32_t mip = 0; mip < pOutput->mipLevels; mip++)
+    {
+        samples[mip] = buildPrefilterSamples(source, roughness[mip]);
+        firstRows[mip + 1] = firstRows[mip] + 6 * pOutput->getMipSize(mip);
+    }
+    threadPool->parallelFor(firstRows.back(), [&](uint32_t row)
+    {
+        uint32_t mip = 0;
+        while (row >= firstRows[mip + 1])
+        {
+            mip++;
+        }
+        uint32_t mipSize = pOutput->getMipSize(mip);
+        uint32_t face = (row - firstRows[mip]) / mipSize;
+        uint32_t y = (row - firstRows[mip]) % mipSize;
+        float* texels = pOutput->getTexels(face, mip) + (size_t)y * mipSize * 4;
+        if (roughness[mip] == 0.0f)
+        {
+            for (uint32_t x = 0; x < mipSize; x++)
+            {
+                Vec3 direction = normalize(cubeFaceDirection(face, 2.0f * (x + 0.5f) / mipSize - 1.0f,
+                                                             2.0f * (y + 0.5f) / mipSize - 1.0f));
+                storeTexel(texels + x * 4, source.sampleBilinear(direction, 0));
+            }
+            return;
+        }
+        prefilterRow(source, samples[mip], face, y, mipSize, texels);
+    });
+}
+
+void CubemapBaker::renderPrefilteredReference(const CpuCubemap& source, uint32_t sideSize,
+                                              const std::vector<float>& roughness, CpuCubemap* pOutput)
+{
+    pOutput->allocate(sideSize, (uint32_t)roughness.size());
+    for (uint32_t mip = 0; mip < pOutput->mipLevels; mip++)
+    {
+        uint32_t mipSize = pOutput->getMipSize(mip);
+        threadPool->parallelFor(6 * mipSize, [&](uint32_t row)
+        {
+            uint32_t face = row / mipSize;
+            uint32_t y = row % mipSize;
+            float* texels = pOutput->getTexels(face, mip) + (size_t)y * mipSize * 4;
+            for (uint32_t x = 0; x < mipSize; x++)
+            {
+                Vec3 direction = normalize(cubeFaceDirection(face, 2.0f * (x + 0.5f) / mipSize - 1.0f,
+                                                             2.0f * (y + 0.5f) / mipSize - 1.0f));
+                storeTexel(texels + x * 4, prefilterEnvMap(source, direction, roughness[mip]));
+            }
+        });
+    }
+}
+
+void CubemapBaker::renderBRDF(uint32_t sideSize, std::vector<float>* pOutput)
+{
+    pOutput->assign((size_t)sideSize * sideSize * 4, 0.0f);
+    threadPool->parallelFor(sideSize, [&](uint32_t y)
+    {
+        for (uint32_t x = 0; x < sideSize; x++)
+        {
+            float* texel = pOutput->data() + ((size_t)y * sideSize + x) * 4;
+            integrateBRDF((x + 0.5f) / sideSize, (y + 0.5f) / sideSize, &texel[0], &texel[1]);
+            texel[2] = 0.0f;
+            texel[3] = 1.0f;
+        }
+    });
+}
+
+Vec3 CubemapBaker::prefilterEnvMap(const CpuCubemap& source, const Vec3& direction, float roughness)
+{
+    if (roughness == 0.0f)
+    {
+        return source.sampleBilinear(direction, 0);
+    }
+    Vec3 color;
+    float totalWeight = 0.0f;
+    float omegaP = 4.0f * PI / (6.0f * source.size * source.size);
+    for (uint32_t i = 0; i < PREFILTER_SAMPLE_COUNT; i++)
+    {
+        float xiX, xiY;
+        hammersley2d(i, PREFILTER_SAMPLE_COUNT, &xiX, &xiY);
+        Vec3 h = importanceSampleGGX(xiX, xiY, roughness, direction);
+        Vec3 l = h * (2.0f * dot(direction, h)) - direction;
+        float dotNL = clamp(dot(direction, l), 0.0f, 1.0f);
+        if (dotNL > 0.0f)
+        {
+            float dotNH = clamp(dot(direction, h), 0.0f, 1.0f);
+            float dotVH = clamp(dot(direction, h), 0.0f, 1.0f);
+            float pdf = distributeGGX(dotNH, roughness) * dotNH / (4.0f * dotVH) + 0.0001f;
+            float omegaS = 1.0f / ((float)PREFILTER_SAMPLE_COUNT * pdf);
+            float mipLevel = std::max(0.5f * log2f(omegaS / omegaP) + 1.0f, 0.0f);
+            color += source.sampleTrilinear(l, mipLevel) * dotNL;
+            totalWeight += dotNL;
+        }
+    }
+    return color * (1.0f / totalWeight);
+}
+
+void CubemapBaker::integrateBRDF(float dotNV, float roughness, float* pScale, float* pBias)
+{
+    const Vec3 normal(0.0f, 0.0f, 1.0f);
+    Vec3 view(sqrtf(1.0f - dotNV * dotNV), 0.0f, dotNV);
+    float scale = 0.0f;
+    float bias = 0.0f;
+    for (uint32_t i = 0; i < BRDF_SAMPLE_COUNT; i++)
+    {
+        float xiX, xiY;
+        hammersley2d(i, BRDF_SAMPLE_COUNT, &xiX, &xiY);
+        Vec3 h = importanceSampleGGX(xiX, xiY, roughness, normal);
+        Vec3 l = h * (2.0f * dot(view, h)) - view;
+
+        float dotNL = std::max(l.z, 0.0f);
+        float dotVH = std::max(dot(view, h), 0.0f);
+        float dotNH = std::max(h.z, 0.0f);
+        if (dotNL > 0.0f)
+        {
+            float g = geometrySchlickSmithGGX(dotNL, dotNV, roughness);
+            float gVis = (g * dotVH) / (dotNH * dotNV);
+            float fc = powf(1.0f - dotVH, 5.0f);
+            scale += (1.0f - fc) * gVis;
+            bias += fc * gVis;
+        }
+    }
+    *pScale = scale / (float)BRDF_SAMPLE_COUNT;
+    *pBias = bias / (float)BRDF_SAMPLE_COUNT;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "IBLMath.h"
+#include "SphericalHarmonics.h"
+#include "../../Utils/ThreadPool.h"
+
+struct CpuCubemap
+{
+    uint32_t size = 0;
+    uint32_t mipLevels = 0;
+    // RGBA32F texels in D3D subresource order: every mip of face 0, then face 1, ...
+    std::vector<float> texels;
+
+    void allocate(uint32_t sideSize, uint32_t mipAmount);
+    uint32_t getMipSize(uint32_t mip) const;
+    size_t getSubresourceOffset(uint32_t face, uint32_t mip) const;
+    float* getTexels(uint32_t face, uint32_t mip);
+    const float* getTexels(uint32_t face, uint32_t mip) const;
+    IBLMath::Vec3 sampleFaceBilinear(uint32_t face, float u, float v, uint32_t mip) const;
+    IBLMath::Vec3 sampleBilinear(const IBLMath::Vec3& direction, uint32_t mip) const;
+    IBLMath::Vec3 sampleTrilinear(const IBLMath::Vec3& direction, float lod) const;
+};
+
+struct IBLBakeSettings
+{
+    uint32_t irradianceSize = 32;
+    uint32_t prefilteredSize = 128;
+    std::vector<float> prefilteredRoughness = {0.0f, 0.25f, 0.5f, 0.75f, 1.0f};
+};
+
+struct IBLBakeData
+{
+    CpuCubemap cubemap;
+    CpuCubemap irradiance;
+    SHIrradiance irradianceSH;
+    CpuCubemap prefiltered;
+};
+
+class CubemapBaker
+{
+public:
+    CubemapBaker(ThreadPool* threadPool);
+
+private:
+    ThreadPool* threadPool;
+
+public:
+    void convertEquirectangular(const float* pixels, uint32_t width, uint32_t height, uint32_t sideSize,
+                                CpuCubemap* pOutput);
+    void generateMips(CpuCubemap* pCubemap);
+    void renderIrradiance(const CpuCubemap& source, uint32_t sideSize, CpuCubemap* pOutput);
+    void renderPrefiltered(const CpuCubemap& source, uint32_t sideSize, const std::vector<float>& roughness,
+                           CpuCubemap* pOutput);
+    void renderPrefilteredReference(const CpuCubemap& source, uint32_t sideSize, const std::vector<float>& roughness,
+                                    CpuCubemap* pOutput);
+    void renderBRDF(uint32_t sideSize, std::vector<float>* pOutput);
+
+private:
+    IBLMath::Vec3 prefilterEnvMap(const CpuCubemap& source, const IBLMath::Vec3& direction, float roughness);
+    void integrateBRDF(float dotNV, float roughness, float* pScale, float* pBias);
+};
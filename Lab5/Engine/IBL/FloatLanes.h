@@ -0,0 +1,124 @@
+#pragma once
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define IBL_LANES_AVX2
+#elif defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <cstring>
+#include <emmintrin.h>
+#define IBL_LANES_SSE
+#else
+#include <cmath>
+#endif
+
+// Minimal wrapper over the widest float vector the build targets, so kernels are written once for AVX2, SSE and
+// plain scalar builds. Comparisons return all-ones / all-zeros lane masks for select(); getMask() packs them into
+// one bit per lane. loadBytes widens WIDTH unsigned bytes to floats. minimum and maximum avoid the names of the
+// windows.h macros.
+struct FloatLanes
+{
+#if defined(IBL_LANES_AVX2)
+    static const unsigned WIDTH = 8;
+    __m256 value;
+
+    FloatLanes() = default;
+    FloatLanes(__m256 value) : value(value)
+    {
+    }
+
+    static FloatLanes set(float scalar) { return _mm256_set1_ps(scalar); }
+    static FloatLanes load(const float* data) { return _mm256_loadu_ps(data); }
+    static FloatLanes loadBytes(const unsigned char* data)
+    {
+        return _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(data))));
+    }
+    void store(float* data) const { _mm256_storeu_ps(data, value); }
+
+    FloatLanes operator+(const FloatLanes& other) const { return _mm256_add_ps(value, other.value); }
+    FloatLanes operator-(const FloatLanes& other) const { return _mm256_sub_ps(value, other.value); }
+    FloatLanes operator*(const FloatLanes& other) const { return _mm256_mul_ps(value, other.value); }
+    FloatLanes operator/(const FloatLanes& other) const { return _mm256_div_ps(value, other.value); }
+    FloatLanes operator>=(const FloatLanes& other) const { return _mm256_cmp_ps(value, other.value, _CMP_GE_OQ); }
+    FloatLanes operator>(const FloatLanes& other) const { return _mm256_cmp_ps(value, other.value, _CMP_GT_OQ); }
+    FloatLanes operator&(const FloatLanes& other) const { return _mm256_and_ps(value, other.value); }
+    int getMask() const { return _mm256_movemask_ps(value); }
+
+    static FloatLanes abs(const FloatLanes& lanes) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), lanes.value); }
+    static FloatLanes minimum(const FloatLanes& a, const FloatLanes& b) { return _mm256_min_ps(a.value, b.value); }
+    static FloatLanes maximum(const FloatLanes& a, const FloatLanes& b) { return _mm256_max_ps(a.value, b.value); }
+
+    static FloatLanes select(const FloatLanes& mask, const FloatLanes& a, const FloatLanes& b)
+    {
+        return _mm256_blendv_ps(b.value, a.value, mask.value);
+    }
+#elif defined(IBL_LANES_SSE)
+    static const unsigned WIDTH = 4;
+    __m128 value;
+
+    FloatLanes() = default;
+    FloatLanes(__m128 value) : value(value)
+    {
+    }
+
+    static FloatLanes set(float scalar) { return _mm_set1_ps(scalar); }
+    static FloatLanes load(const float* data) { return _mm_loadu_ps(data); }
+    static FloatLanes loadBytes(const unsigned char* data)
+    {
+        int packed;
+        memcpy(&packed, data, sizeof(packed));
+        __m128i zero = _mm_setzero_si128();
+        __m128i bytes = _mm_cvtsi32_si128(packed);
+        return _mm_cvtepi32_ps(_mm_unpacklo_epi16(_mm_unpacklo_epi8(bytes, zero), zero));
+    }
+    void store(float* data) const { _mm_storeu_ps(data, value); }
+
+    FloatLanes operator+(const FloatLanes& other) const { return _mm_add_ps(value, other.value); }
+    FloatLanes operator-(const FloatLanes& other) const { return _mm_sub_ps(value, other.value); }
+    FloatLanes operator*(const FloatLanes& other) const { return _mm_mul_ps(value, other.value); }
+    FloatLanes operator/(const FloatLanes& other) const { return _mm_div_ps(value, other.value); }
+    FloatLanes operator>=(const FloatLanes& other) const { return _mm_cmpge_ps(value, other.value); }
+    FloatLanes operator>(const FloatLanes& other) const { return _mm_cmpgt_ps(value, other.value); }
+    FloatLanes operator&(const FloatLanes& other) const { return _mm_and_ps(value, other.value); }
+    int getMask() const { return _mm_movemask_ps(value); }
+
+    static FloatLanes abs(const FloatLanes& lanes) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), lanes.value); }
+    static FloatLanes minimum(const FloatLanes& a, const FloatLanes& b) { return _mm_min_ps(a.value, b.value); }
+    static FloatLanes maximum(const FloatLanes& a, const FloatLanes& b) { return _mm_max_ps(a.value, b.value); }
+
+    static FloatLanes select(const FloatLanes& mask, const FloatLanes& a, const FloatLanes& b)
+    {
+        return _mm_or_ps(_mm_and_ps(mask.value, a.value), _mm_andnot_ps(mask.value, b.value));
+    }
+#else
+    static const unsigned WIDTH = 1;
+    float value;
+
+    FloatLanes() = default;
+    FloatLanes(float value) : value(value)
+    {
+    }
+
+    static FloatLanes set(float scalar) { return scalar; }
+    static FloatLanes load(const float* data) { return *data; }
+    static FloatLanes loadBytes(const unsigned char* data) { return (float)*data; }
+    void store(float* data) const { *data = value; }
+
+    FloatLanes operator+(const FloatLanes& other) const { return value + other.value; }
+    FloatLanes operator-(const FloatLanes& other) const { return value - other.value; }
+    FloatLanes operator*(const FloatLanes& other) const { return value * other.value; }
+    FloatLanes operator/(const FloatLanes& other) const { return value / other.value; }
+    FloatLanes operator>=(const FloatLanes& other) const { return value >= other.value ? 1.0f : 0.0f; }
+    FloatLanes operator>(const FloatLanes& other) const { return value > other.value ? 1.0f : 0.0f; }
+    FloatLanes operator&(const FloatLanes& other) const { return value != 0.0f && other.value != 0.0f ? 1.0f : 0.0f; }
+    int getMask() const { return value != 0.0f ? 1 : 0; }
+
+    static FloatLanes abs(const FloatLanes& lanes) { return fabsf(lanes.value); }
+    static FloatLanes minimum(const FloatLanes& a, const FloatLanes& b) { return a.value < b.value ? a : b; }
+    static FloatLanes maximum(const FloatLanes& a, const FloatLanes& b) { return a.value > b.value ? a : b; }
+
+    static FloatLanes select(const FloatLanes& mask, const FloatLanes& a, const FloatLanes& b)
+    {
+        return mask.value != 0.0f ? a : b;
+    }
+#endif
+};
@@ -0,0 +1,138 @@
+#include "HDRContainer.h"
+
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+#include "../../Utils/HalfFloat.h"
+#include "../../Utils/SharedExponent.h"
+
+std::string HDRContainer::getContainerPath(const std::string& hdrPath)
+{
+    size_t extension = hdrPath.find_last_of('.');
+    size_t separator = hdrPath.find_last_of("/\\");
+    if (extension == std::string::npos || (separator != std::string::npos && extension < separator))
+    {
+        return hdrPath + ".hdrc";
+    }
+    return hdrPath.substr(0, extension) + ".hdrc";
+}
+
+bool HDRContainer::isSupportedFormat(RenderFormat format)
+{
+    return format == RENDER_FORMAT_R16G16B16A16_FLOAT || format == RENDER_FORMAT_R9G9B9E5_SHAREDEXP;
+}
+
+uint32_t HDRContainer::getBytesPerTexel(RenderFormat format)
+{
+    return format == RENDER_FORMAT_R16G16B16A16_FLOAT ? 8 : 4;
+}
+
+bool HDRContainer::write(const std::string& path, uint64_t sourceHash, const float* pixels, uint32_t width,
+                         uint32_t height, RenderFormat format, const SHIrradiance& irradianceSH,
+                         ThreadPool* threadPool)
+{
+    if (!isSupportedFormat(format) || !width || !height)
+    {
+        return false;
+    }
+    uint32_t texelBytes = getBytesPerTexel(format);
+    size_t rowBytes = (size_t)width * texelBytes;
+    std::vector<uint8_t> texels(rowBytes * height);
+    auto convertRow = [&](uint32_t y)
+    {
+        const float* source = pixels + (size_t)y * width * 4;
+        uint8_t* row = texels.data() + y * rowBytes;
+        for (uint32_t x = 0; x < width; x++, source += 4)
+        {
+            if (format == RENDER_FORMAT_R16G16B16A16_FLOAT)
+            {
+                uint16_t halves[4] = {
+                    HalfFloat::fromFloat(source[0]), HalfFloat::fromFloat(source[1]),
+                    HalfFloat::fromFloat(source[2]), HalfFloat::fromFloat(1.0f)
+                };
+                memcpy(row + x * texelBytes, halves, sizeof(halves));
+            }
+            else
+            {
+                uint32_t packed = SharedExponent::fromFloat3(source[0], source[1], source[2]);
+                memcpy(row + x * texelBytes, &packed, sizeof(packed));
+            }
+        }
+    };
+    if (threadPool)
+    {
+        threadPool->parallelFor(height, convertRow);
+    }
+    else
+    {
+        for (uint32_t y = 0; y < height; y++)
+        {
+            convertRow(y);
+        }
+    }
+
+    std::ofstream file(path, std::ios::binary);
+    if (!file)
+    {
+        return false;
+    }
+    HDRContainerHeader header = {};
+    header.magic = MAGIC;
+    header.version = VERSION;
+    header.sourceHash = sourceHash;
+    header.width = width;
+    header.height = height;
+    header.format = format;
+    header.dataOffset = DATA_ALIGNMENT;
+    header.dataSize = texels.size();
+    header.irradianceSH = irradianceSH;
+    std::vector<char> headerPage(DATA_ALIGNMENT, 0);
+    memcpy(headerPage.data(), &header, sizeof(header));
+    file.write(headerPage.data(), (std::streamsize)headerPage.size());
+    file.write(reinterpret_cast<const char*>(texels.data()), (std::streamsize)texels.size());
+    return (bool)file;
+}
+
+bool HDRContainer::open(const std::string& path, const uint64_t* pSourceHash)
+{
+    close();
+    if (!file.open(path) || file.getSize() < sizeof(HDRContainerHeader))
+    {
+        file.close();
+        return false;
+    }
+    memcpy(&header, file.getData(), sizeof(header));
+    RenderFormat format = (RenderFormat)header.format;
+    bool valid = header.magic == MAGIC && header.version == VERSION &&
+        (!pSourceHash || header.sourceHash == *pSourceHash) && isSupportedFormat(format) && header.width &&
+        header.height && header.dataSize == (uint64_t)header.width * header.height * getBytesPerTexel(format) &&
+        header.dataOffset >= sizeof(header) && header.dataOffset <= file.getSize() &&
+        header.dataSize <= file.getSize() - header.dataOffset;
+    if (!valid)
+    {
+        close();
+    }
+    return valid;
+}
+
+void HDRContainer::close()
+{
+    file.close();
+    header = {};
+}
+
+const HDRContainerHeader& HDRContainer::getHeader() const
+{
+    return header;
+}
+
+RenderFormat HDRContainer::getFormat() const
+{
+    return (RenderFormat)header.format;
+}
+
+const void* HDRContainer::getTexels() const
+{
+    return file.getData() ? file.getData() + header.dataOffset : nullptr;
+}
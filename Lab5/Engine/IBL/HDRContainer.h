@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "SphericalHarmonics.h"
+#include "../RenderDevice/RenderDevice.h"
+#include "../../Utils/MappedFile.h"
+
+struct HDRContainerHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t sourceHash;
+    uint32_t width;
+    uint32_t height;
+    uint32_t format;
+    uint32_t reserved;
+    uint64_t dataOffset;
+    uint64_t dataSize;
+    // Projected from the full-precision source, so the runtime never has to decode the texels.
+    SHIrradiance irradianceSH;
+};
+
+// Equirectangular environment pre-converted from Radiance RGBE to a format the GPU samples directly, either
+// RGBA16F or RGB9E5. The texels start on a page boundary and are stored exactly as a texture upload expects them,
+// so open maps the file and getTexels can be passed as initial data without decoding or copying.
+class HDRContainer
+{
+public:
+    static const uint32_t MAGIC = 0x43524448; // "HDRC"
+    static const uint32_t VERSION = 1;
+    static const uint32_t DATA_ALIGNMENT = 4096;
+
+    static std::string getContainerPath(const std::string& hdrPath);
+    static bool isSupportedFormat(RenderFormat format);
+    static uint32_t getBytesPerTexel(RenderFormat format);
+    // Pixels are RGBA32F as stbi_loadf returns them; alpha is dropped. The thread pool may be null.
+    static bool write(const std::string& path, uint64_t sourceHash, const float* pixels, uint32_t width,
+                      uint32_t height, RenderFormat format, const SHIrradiance& irradianceSH, ThreadPool* threadPool);
+
+    // A null source hash accepts the container without checking it against its HDR, for when only the container
+    // ships.
+    bool open(const std::string& path, const uint64_t* pSourceHash);
+    void close();
+
+    const HDRContainerHeader& getHeader() const;
+    RenderFormat getFormat() const;
+    const void* getTexels() const;
+
+private:
+    MappedFile file;
+    HDRContainerHeader header = {};
+};
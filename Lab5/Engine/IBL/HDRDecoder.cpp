@@ -0,0 +1,353 @@
+#include "HDRDecoder.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+#include "FloatLanes.h"
+#include "../../STB/stb_image.h"
+#include "../../Utils/HalfFloat.h"
+
+#if defined(__F16C__) || (defined(_MSC_VER) && defined(__AVX2__))
+#include <immintrin.h>
+#define HDR_DECODER_F16C
+#endif
+
+namespace
+{
+    // stbi__hdr_gettoken keeps this much of a header line and skips the rest.
+    const size_t MAX_TOKEN_LENGTH = 1023;
+    const long MAX_DIMENSION = 1 << 24;
+    const float ALPHA_LANES[8] = {0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f};
+
+    // Per exponent byte the factor stbi__hdr_convert applies to R, G and B, and zero for the alpha lane, which is
+    // then set to one by adding ALPHA_LANES. Exponent zero decodes to black as in stb_image.
+    struct ExponentScales
+    {
+        float scales[256][4];
+
+        ExponentScales()
+        {
+            for (int exponent = 0; exponent < 256; exponent++)
+            {
+                float scale = exponent ? ldexpf(1.0f, exponent - (128 + 8)) : 0.0f;
+                scales[exponent][0] = scales[exponent][1] = scales[exponent][2] = scale;
+                scales[exponent][3] = 0.0f;
+            }
+        }
+    };
+
+    const ExponentScales& getExponentScales()
+    {
+        static const ExponentScales exponentScales;
+        return exponentScales;
+    }
+
+    std::string readToken(const uint8_t* data, uint64_t size, uint64_t* pPosition)
+    {
+        std::string token;
+        while (*pPosition < size && data[*pPosition] != '\n')
+        {
+            if (token.size() < MAX_TOKEN_LENGTH)
+            {
+                token += (char)data[*pPosition];
+            }
+            ++*pPosition;
+        }
+        if (*pPosition < size)
+        {
+            ++*pPosition;
+        }
+        return token;
+    }
+
+    bool startsWith(const uint8_t* data, uint64_t size, const char* prefix)
+    {
+        size_t length = strlen(prefix);
+        return size >= length && !memcmp(data, prefix, length);
+    }
+
+    // RGBE to RGBA32F, FloatLanes::WIDTH / 4 pixels at a time. Both products are exact powers of two times a byte,
+    // so every path rounds exactly like the scalar multiply in stb_image.
+    void convertRow(const uint8_t* rgbe, uint32_t width, float* pOutput)
+    {
+        const ExponentScales& exponentScales = getExponentScales();
+        const uint32_t pixelsPerLanes = FloatLanes::WIDTH / 4;
+        uint32_t x = 0;
+        if (pixelsPerLanes)
+        {
+            FloatLanes alpha = FloatLanes::load(ALPHA_LANES);
+            for (; x + pixelsPerLanes <= width; x += pixelsPerLanes)
+            {
+                float scales[FloatLanes::WIDTH];
+                for (uint32_t pixel = 0; pixel < pixelsPerLanes; pixel++)
+                {
+                    memcpy(scales + pixel * 4, exponentScales.scales[rgbe[(x + pixel) * 4 + 3]], 4 * sizeof(float));
+                }
+                (FloatLanes::loadBytes(rgbe + x * 4) * FloatLanes::load(scales) + alpha).store(pOutput + x * 4);
+            }
+        }
+        for (; x < width; x++)
+        {
+            const float* scales = exponentScales.scales[rgbe[x * 4 + 3]];
+            for (uint32_t c = 0; c < 4; c++)
+            {
+                pOutput[x * 4 + c] = rgbe[x * 4 + c] * scales[c] + ALPHA_LANES[c];
+            }
+        }
+    }
+
+    void convertToHalf(const float* values, size_t count, uint16_t* pOutput)
+    {
+        size_t i = 0;
+#ifdef HDR_DECODER_F16C
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128i halves = _mm_cvtps_ph(_mm_loadu_ps(values + i), _MM_FROUND_TO_NEAREST_INT);
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(pOutput + i), halves);
+        }
+#endif
+        for (; i < count; i++)
+        {
+            pOutput[i] = HalfFloat::fromFloat(values[i]);
+        }
+    }
+}
+
+bool HDRDecoder::isSupportedFormat(RenderFormat format)
+{
+    return format == RENDER_FORMAT_R32G32B32A32_FLOAT || format == RENDER_FORMAT_R16G16B16A16_FLOAT;
+}
+
+bool HDRDecoder::load(const std::string& path, ThreadPool* threadPool, std::vector<float>* pPixels,
+                      uint32_t* pWidth, uint32_t* pHeight)
+{
+    HDRDecoder decoder;
+    if (decoder.open(path))
+    {
+        pPixels->resize((size_t)decoder.getWidth() * decoder.getHeight() * 4);
+        decoder.decode(RENDER_FORMAT_R32G32B32A32_FLOAT, pPixels->data(), threadPool);
+        *pWidth = decoder.getWidth();
+        *pHeight = decoder.getHeight();
+        return true;
+    }
+    int width, height, nrComponents;
+    float* data = stbi_loadf(path.c_str(), &width, &height, &nrComponents, 4);
+    if (!data)
+    {
+        return false;
+    }
+    pPixels->assign(data, data + (size_t)width * height * 4);
+    stbi_image_free(data);
+    *pWidth = width;
+    *pHeight = height;
+    return true;
+}
+
+bool HDRDecoder::open(const std::string& path)
+{
+    close();
+    uint64_t dataOffset = 0;
+    if (!file.open(path) || !parseHeader(&dataOffset) || !indexScanlines(dataOffset))
+    {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void HDRDecoder::close()
+{
+    file.close();
+    width = 0;
+    height = 0;
+    scanlineOffsets.clear();
+    flatOffset = 0;
+}
+
+uint32_t HDRDecoder::getWidth() const
+{
+    return width;
+}
+
+uint32_t HDRDecoder::getHeight() const
+{
+    return height;
+}
+
+void HDRDecoder::decode(RenderFormat format, void* pOutput, ThreadPool* threadPool) const
+{
+    if (!isSupportedFormat(format))
+    {
+        throw std::runtime_error("Failed to decode HDR: unsupported output format");
+    }
+    bool half = format == RENDER_FORMAT_R16G16B16A16_FLOAT;
+    size_t rowValues = (size_t)width * 4;
+    auto decodeRows = [&](uint32_t task)
+    {
+        std::vector<uint8_t> rgbe(scanlineOffsets.empty() ? 0 : rowValues);
+        std::vector<float> staging(half ? rowValues : 0);
+        uint32_t endY = std::min(height, (task + 1) * ROWS_PER_TASK);
+        for (uint32_t y = task * ROWS_PER_TASK; y < endY; y++)
+        {
+            const uint8_t* source = file.getData() + flatOffset + y * rowValues;
+            if (!scanlineOffsets.empty())
+            {
+                decodeScanline(y, rgbe.data());
+                source = rgbe.data();
+            }
+            float* row = half ? staging.data() : static_cast<float*>(pOutput) + y * rowValues;
+            convertRow(source, width, row);
+            if (half)
+            {
+                convertToHalf(row, rowValues, static_cast<uint16_t*>(pOutput) + y * rowValues);
+            }
+        }
+    };
+    uint32_t taskCount = (height + ROWS_PER_TASK - 1) / ROWS_PER_TASK;
+    if (threadPool)
+    {
+        threadPool->parallelFor(taskCount, decodeRows);
+        return;
+    }
+    for (uint32_t task = 0; task < taskCount; task++)
+    {
+        decodeRows(task);
+    }
+}
+
+// Accepts exactly the headers stbi__hdr_load accepts: the signature line, a FORMAT=32-bit_rle_rgbe line somewhere
+// before the first empty line, then a -Y height +X width resolution line.
+bool HDRDecoder::parseHeader(uint64_t* pDataOffset)
+{
+    const uint8_t* data = file.getData();
+    uint64_t size = file.getSize();
+    if (!startsWith(data, size, "#?RADIANCE\n") && !startsWith(data, size, "#?RGBE\n"))
+    {
+        return false;
+    }
+    uint64_t position = 0;
+    readToken(data, size, &position);
+    bool valid = false;
+    for (;;)
+    {
+        std::string token = readToken(data, size, &position);
+        if (token.empty())
+        {
+            break;
+        }
+        valid |= token == "FORMAT=32-bit_rle_rgbe";
+    }
+    std::string resolution = readToken(data, size, &position);
+    if (!valid || resolution.compare(0, 3, "-Y "))
+    {
+        return false;
+    }
+    char* cursor = nullptr;
+    long rows = strtol(resolution.c_str() + 3, &cursor, 10);
+    while (*cursor == ' ')
+    {
+        cursor++;
+    }
+    if (strncmp(cursor, "+X ", 3))
+    {
+        return false;
+    }
+    long columns = strtol(cursor + 3, nullptr, 10);
+    if (rows <= 0 || columns <= 0 || rows > MAX_DIMENSION || columns > MAX_DIMENSION)
+    {
+        return false;
+    }
+    width = (uint32_t)columns;
+    height = (uint32_t)rows;
+    *pDataOffset = position;
+    return true;
+}
+
+// Walks the run lengths without expanding them, so decode can start any scanline on any thread.
+bool HDRDecoder::indexScanlines(uint64_t dataOffset)
+{
+    const uint8_t* data = file.getData();
+    uint64_t size = file.getSize();
+    uint64_t flatBytes = (uint64_t)width * height * 4;
+    if (width < 8 || width >= 32768)
+    {
+        flatOffset = dataOffset;
+        return size - dataOffset >= flatBytes;
+    }
+    uint64_t position = dataOffset;
+    scanlineOffsets.reserve(height);
+    for (uint32_t y = 0; y < height; y++)
+    {
+        if (size - position < 4)
+        {
+            return false;
+        }
+        const uint8_t* header = data + position;
+        if (header[0] != 2 || header[1] != 2 || (header[2] & 0x80))
+        {
+            // stb_image reads a file that does not start run-length encoded as flat pixels from here on. When that
+            // happens after the first scanline it also restarts at the top of the image; that is left to it.
+            if (y != 0)
+            {
+                return false;
+            }
+            flatOffset = position;
+            return size - position >= flatBytes;
+        }
+        if (((uint32_t)header[2] << 8 | header[3]) != width)
+        {
+            return false;
+        }
+        position += 4;
+        scanlineOffsets.push_back(position);
+        for (uint32_t channel = 0; channel < 4; channel++)
+        {
+            for (uint32_t x = 0; x < width;)
+            {
+                if (position >= size)
+                {
+                    return false;
+                }
+                uint32_t count = data[position++];
+                uint64_t payload = count > 128 ? 1 : count;
+                count = count > 128 ? count - 128 : count;
+                if (count == 0 || count > width - x || size - position < payload)
+                {
+                    return false;
+                }
+                position += payload;
+                x += count;
+            }
+        }
+    }
+    return true;
+}
+
+void HDRDecoder::decodeScanline(uint32_t y, uint8_t* pRgbe) const
+{
+    const uint8_t* data = file.getData() + scanlineOffsets[y];
+    for (uint32_t channel = 0; channel < 4; channel++)
+    {
+        for (uint32_t x = 0; x < width;)
+        {
+            uint32_t count = *data++;
+            if (count > 128)
+            {
+                uint8_t value = *data++;
+                for (count -= 128; count > 0; count--)
+                {
+                    pRgbe[x++ * 4 + channel] = value;
+                }
+            }
+            else
+            {
+                for (; count > 0; count--)
+                {
+                    pRgbe[x++ * 4 + channel] = *data++;
+                }
+            }
+        }
+    }
+}
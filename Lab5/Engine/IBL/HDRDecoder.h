@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "../RenderDevice/RenderDevice.h"
+#include "../../Utils/MappedFile.h"
+#include "../../Utils/ThreadPool.h"
+
+// Radiance RGBE decoder that replaces stbi_loadf for .hdr files. open maps the file, parses the header and walks
+// the RLE stream once to record where every scanline starts; decode then expands and converts the scanlines on the
+// thread pool, straight into the caller's upload buffer. The float output is bit-identical to stbi_loadf with four
+// channels. open refuses anything it cannot reproduce exactly, e.g. truncated data or an image that stops being
+// run-length encoded halfway, so callers fall back to stb_image for those.
+class HDRDecoder
+{
+public:
+    static bool isSupportedFormat(RenderFormat format);
+    // Decodes with HDRDecoder and falls back to stbi_loadf for files it does not take. RGBA32F, alpha 1.
+    static bool load(const std::string& path, ThreadPool* threadPool, std::vector<float>* pPixels, uint32_t* pWidth,
+                     uint32_t* pHeight);
+
+    bool open(const std::string& path);
+    void close();
+
+    uint32_t getWidth() const;
+    uint32_t getHeight() const;
+
+    // Writes tightly packed RGBA rows of R32G32B32A32_FLOAT or R16G16B16A16_FLOAT. The thread pool may be null.
+    void decode(RenderFormat format, void* pOutput, ThreadPool* threadPool) const;
+
+private:
+    static const uint32_t ROWS_PER_TASK = 8;
+
+    MappedFile file;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    // Start of each scanline's RLE data past its four byte header; empty when the pixels are stored flat.
+    std::vector<uint64_t> scanlineOffsets;
+    uint64_t flatOffset = 0;
+
+    bool parseHeader(uint64_t* pDataOffset);
+    bool indexScanlines(uint64_t dataOffset);
+    void decodeScanline(uint32_t y, uint8_t* pRgbe) const;
+};
@@ -0,0 +1,174 @@
+#include "IBLCache.h"
+
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+void PackedCubemap::allocate(uint32_t sideSize, uint32_t mipAmount, RenderFormat packedFormat)
+{
+    size = sideSize;
+    mipLevels = mipAmount;
+    format = packedFormat;
+    data.resize(getSubresourceOffset(6, 0));
+}
+
+size_t PackedCubemap::getSubresourceOffset(uint32_t face, uint32_t mip) const
+{
+    size_t faceBytes = 0;
+    size_t mipOffset = 0;
+    for (uint32_t level = 0; level < mipLevels; level++)
+    {
+        uint32_t mipSize = RenderDevice::getMipSize(size, level);
+        size_t bytes = (size_t)RenderDevice::getSubresourceBytes(format, mipSize, mipSize);
+        mipOffset += level < mip ? bytes : 0;
+        faceBytes += bytes;
+    }
+    return face * faceBytes + mipOffset;
+}
+
+const uint8_t* PackedCubemap::getSubresource(uint32_t face, uint32_t mip) const
+{
+    return data.data() + getSubresourceOffset(face, mip);
+}
+
+std::string IBLCache::getCachePath(const std::string& hdrPath)
+{
+    size_t extension = hdrPath.find_last_of('.');
+    size_t separator = hdrPath.find_last_of("/\\");
+    if (extension == std::string::npos || (separator != std::string::npos && extension < separator))
+    {
+        return hdrPath + ".ibl";
+    }
+    return hdrPath.substr(0, extension) + ".ibl";
+}
+
+bool IBLCache::isSupportedFormat(RenderFormat format)
+{
+    return format == RENDER_FORMAT_R32G32B32A32_FLOAT || format == RENDER_FORMAT_BC6H_UF16;
+}
+
+void IBLCache::packCubemap(const CpuCubemap& cubemap, uint32_t mipLevels, RenderFormat format, BC6HQuality quality,
+                           ThreadPool* threadPool, PackedCubemap* pOutput)
+{
+    if (!isSupportedFormat(format))
+    {
+        throw std::runtime_error("Failed to pack cubemap: unsupported format");
+    }
+    if (format == RENDER_FORMAT_BC6H_UF16 && cubemap.size % BC6H::BLOCK_SIZE)
+    {
+        throw std::runtime_error("Failed to pack cubemap: BC6H needs a side that is a multiple of 4");
+    }
+    pOutput->allocate(cubemap.size, mipLevels, format);
+    for (uint32_t face = 0; face < 6; face++)
+    {
+        for (uint32_t mip = 0; mip < mipLevels; mip++)
+        {
+            uint32_t mipSize = cubemap.getMipSize(mip);
+            uint8_t* subresource = pOutput->data.data() + pOutput->getSubresourceOffset(face, mip);
+            if (format == RENDER_FORMAT_BC6H_UF16)
+            {
+                BC6H::encodeImage(cubemap.getTexels(face, mip), mipSize, mipSize, quality, threadPool, subresource);
+            }
+            else
+            {
+                memcpy(subresource, cubemap.getTexels(face, mip), (size_t)mipSize * mipSize * 4 * sizeof(float));
+            }
+        }
+    }
+}
+
+void IBLCache::unpackCubemap(const PackedCubemap& cubemap, CpuCubemap* pOutput)
+{
+    pOutput->allocate(cubemap.size, cubemap.mipLevels);
+    for (uint32_t face = 0; face < 6; face++)
+    {
+        for (uint32_t mip = 0; mip < cubemap.mipLevels; mip++)
+        {
+            uint32_t mipSize = pOutput->getMipSize(mip);
+            if (cubemap.format == RENDER_FORMAT_BC6H_UF16)
+            {
+                BC6H::decodeImage(cubemap.getSubresource(face, mip), mipSize, mipSize, pOutput->getTexels(face, mip));
+            }
+            else
+            {
+                memcpy(pOutput->getTexels(face, mip), cubemap.getSubresource(face, mip),
+                       (size_t)mipSize * mipSize * 4 * sizeof(float));
+            }
+        }
+    }
+}
+
+void IBLCache::pack(const IBLBakeData& data, RenderFormat format, BC6HQuality quality, ThreadPool* threadPool,
+                    IBLCacheData* pOutput)
+{
+    // Only the top level of the environment cube is sampled at runtime.
+    packCubemap(data.cubemap, 1, format, quality, threadPool, &pOutput->cubemap);
+    packCubemap(data.irradiance, data.irradiance.mipLevels, format, quality, threadPool, &pOutput->irradiance);
+    pOutput->irradianceSH = data.irradianceSH;
+    packCubemap(data.prefiltered, data.prefiltered.mipLevels, format, quality, threadPool, &pOutput->prefiltered);
+}
+
+bool IBLCache::write(const std::string& path, uint64_t sourceHash, const IBLCacheData& data)
+{
+    std::ofstream file(path, std::ios::binary);
+    if (!file)
+    {
+        return false;
+    }
+    IBLCacheHeader header = {};
+    header.magic = MAGIC;
+    header.version = VERSION;
+    header.sourceHash = sourceHash;
+    header.cubemapSize = data.cubemap.size;
+    header.cubemapMipLevels = data.cubemap.mipLevels;
+    header.irradianceSize = data.irradiance.size;
+    header.irradianceMipLevels = data.irradiance.mipLevels;
+    header.prefilteredSize = data.prefiltered.size;
+    header.prefilteredMipLevels = data.prefiltered.mipLevels;
+    header.format = data.cubemap.format;
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    for (const PackedCubemap* cubemap : {&data.cubemap, &data.irradiance, &data.prefiltered})
+    {
+        file.write(reinterpret_cast<const char*>(cubemap->data.data()), cubemap->data.size());
+    }
+    file.write(reinterpret_cast<const char*>(&data.irradianceSH), sizeof(data.irradianceSH));
+    return (bool)file;
+}
+
+bool IBLCache::read(const std::string& path, uint64_t sourceHash, IBLCacheData* pOutput)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+    {
+        return false;
+    }
+    IBLCacheHeader header = {};
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!file || header.magic != MAGIC || header.version != VERSION || header.sourceHash != sourceHash ||
+        !isSupportedFormat((RenderFormat)header.format))
+    {
+        return false;
+    }
+    RenderFormat format = (RenderFormat)header.format;
+    if (!readCubemap(file, header.cubemapSize, header.cubemapMipLevels, format, &pOutput->cubemap) ||
+        !readCubemap(file, header.irradianceSize, header.irradianceMipLevels, format, &pOutput->irradiance) ||
+        !readCubemap(file, header.prefilteredSize, header.prefilteredMipLevels, format, &pOutput->prefiltered))
+    {
+        return false;
+    }
+    file.read(reinterpret_cast<char*>(&pOutput->irradianceSH), sizeof(pOutput->irradianceSH));
+    return (bool)file;
+}
+
+bool IBLCache::readCubemap(std::istream& stream, uint32_t size, uint32_t mipLevels, RenderFormat format,
+                           PackedCubemap* pOutput)
+{
+    if (!size || !mipLevels || (size >> (mipLevels - 1)) == 0)
+    {
+        return false;
+    }
+    pOutput->allocate(size, mipLevels, format);
+    stream.read(reinterpret_cast<char*>(pOutput->data.data()), pOutput->data.size());
+    return (bool)stream;
+}
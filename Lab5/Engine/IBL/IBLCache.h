@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "CubemapBaker.h"
+#include "../RenderDevice/RenderDevice.h"
+#include "../../Utils/BC6H.h"
+
+struct IBLCacheHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t sourceHash;
+    uint32_t cubemapSize;
+    uint32_t cubemapMipLevels;
+    uint32_t irradianceSize;
+    uint32_t irradianceMipLevels;
+    uint32_t prefilteredSize;
+    uint32_t prefilteredMipLevels;
+    uint32_t format;
+    uint32_t reserved;
+};
+
+// A cubemap as it is uploaded: RGBA32F texels or BC6H blocks, every mip of face 0, then face 1, ...
+struct PackedCubemap
+{
+    uint32_t size = 0;
+    uint32_t mipLevels = 0;
+    RenderFormat format = RENDER_FORMAT_R32G32B32A32_FLOAT;
+    std::vector<uint8_t> data;
+
+    void allocate(uint32_t sideSize, uint32_t mipAmount, RenderFormat packedFormat);
+    size_t getSubresourceOffset(uint32_t face, uint32_t mip) const;
+    const uint8_t* getSubresource(uint32_t face, uint32_t mip) const;
+};
+
+// The three cubemaps share one format, recorded in the header.
+struct IBLCacheData
+{
+    PackedCubemap cubemap;
+    PackedCubemap irradiance;
+    SHIrradiance irradianceSH;
+    PackedCubemap prefiltered;
+};
+
+class IBLCache
+{
+public:
+    static const uint32_t MAGIC = 0x43424C49; // "IBLC"
+    static const uint32_t VERSION = 4;
+
+    static std::string getCachePath(const std::string& hdrPath);
+    static bool isSupportedFormat(RenderFormat format);
+    // Packs the first mipLevels mips of a baked cubemap; the quality and thread pool only matter for BC6H.
+    static void packCubemap(const CpuCubemap& cubemap, uint32_t mipLevels, RenderFormat format, BC6HQuality quality,
+                            ThreadPool* threadPool, PackedCubemap* pOutput);
+    static void unpackCubemap(const PackedCubemap& cubemap, CpuCubemap* pOutput);
+    static void pack(const IBLBakeData& data, RenderFormat format, BC6HQuality quality, ThreadPool* threadPool,
+                     IBLCacheData* pOutput);
+    static bool write(const std::string& path, uint64_t sourceHash, const IBLCacheData& data);
+    static bool read(const std::string& path, uint64_t sourceHash, IBLCacheData* pOutput);
+
+private:
+    static bool readCubemap(std::istream& stream, uint32_t size, uint32_t mipLevels, RenderFormat format,
+                            PackedCubemap* pOutput);
+};
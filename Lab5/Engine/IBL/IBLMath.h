@@ -0,0 +1,168 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+
+namespace IBLMath
+{
+    const float PI = 3.14159265359f;
+
+    struct Vec3
+    {
+        float x = 0;
+        float y = 0;
+        float z = 0;
+
+        Vec3() = default;
+
+        Vec3(float x, float y, float z) : x(x), y(y), z(z)
+        {
+        }
+
+        Vec3 operator+(const Vec3& other) const { return Vec3(x + other.x, y + other.y, z + other.z); }
+        Vec3 operator-(const Vec3& other) const { return Vec3(x - other.x, y - other.y, z - other.z); }
+        Vec3 operator*(float value) const { return Vec3(x * value, y * value, z * value); }
+
+        Vec3& operator+=(const Vec3& other)
+        {
+            x += other.x;
+            y += other.y;
+            z += other.z;
+            return *this;
+        }
+    };
+
+    inline float dot(const Vec3& a, const Vec3& b)
+    {
+        return a.x * b.x + a.y * b.y + a.z * b.z;
+    }
+
+    inline Vec3 cross(const Vec3& a, const Vec3& b)
+    {
+        return Vec3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+    }
+
+    inline Vec3 normalize(const Vec3& v)
+    {
+        return v * (1.0f / sqrtf(dot(v, v)));
+    }
+
+    inline float frac(float value)
+    {
+        return value - floorf(value);
+    }
+
+    inline float clamp(float value, float minValue, float maxValue)
+    {
+        return value < minValue ? minValue : value > maxValue ? maxValue : value;
+    }
+
+    // Face order and orientation follow D3D cube arrays, matching the view matrices in CubemapGenerator.
+    inline Vec3 cubeFaceDirection(uint32_t face, float u, float v)
+    {
+        switch (face)
+        {
+        case 0:
+            return Vec3(1.0f, -v, -u);
+        case 1:
+            return Vec3(-1.0f, -v, u);
+        case 2:
+            return Vec3(u, 1.0f, v);
+        case 3:
+            return Vec3(u, -1.0f, -v);
+        case 4:
+            return Vec3(u, -v, 1.0f);
+        default:
+            return Vec3(-u, -v, -1.0f);
+        }
+    }
+
+    inline uint32_t directionToCubeFace(const Vec3& dir, float* pU, float* pV)
+    {
+        float ax = fabsf(dir.x);
+        float ay = fabsf(dir.y);
+        float az = fabsf(dir.z);
+        uint32_t face;
+        float sc, tc, ma;
+        if (ax >= ay && ax >= az)
+        {
+            face = dir.x >= 0 ? 0 : 1;
+            ma = ax;
+            sc = dir.x >= 0 ? -dir.z : dir.z;
+            tc = -dir.y;
+        }
+        else if (ay >= az)
+        {
+            face = dir.y >= 0 ? 2 : 3;
+            ma = ay;
+            sc = dir.x;
+            tc = dir.y >= 0 ? dir.z : -dir.z;
+        }
+        else
+        {
+            face = dir.z >= 0 ? 4 : 5;
+            ma = az;
+            sc = dir.z >= 0 ? dir.x : -dir.x;
+            tc = -dir.y;
+        }
+        *pU = 0.5f * (sc / ma + 1.0f);
+        *pV = 0.5f * (tc / ma + 1.0f);
+        return face;
+    }
+
+    inline float texelSolidAngle(float u, float v, float texelSize)
+    {
+        float distance = 1.0f + u * u + v * v;
+        return texelSize * texelSize / (distance * sqrtf(distance));
+    }
+
+    // Ports of the helpers in prefilterCube.hlsl, also used by the BRDF LUT integration.
+    inline float random(float x, float y)
+    {
+        float dt = x * 12.9898f + y * 78.233f;
+        float sn = fmodf(dt, 3.14f);
+        return frac(sinf(sn) * 43758.5453f);
+    }
+
+    inline void hammersley2d(uint32_t i, uint32_t count, float* pX, float* pY)
+    {
+        uint32_t bits = (i << 16u) | (i >> 16u);
+        bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+        bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+        bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+        bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+        *pX = (float)i / (float)count;
+        *pY = (float)bits * 2.3283064365386963e-10f;
+    }
+
+    inline Vec3 importanceSampleGGX(float xiX, float xiY, float roughness, const Vec3& normal)
+    {
+        float alpha = roughness * roughness;
+        float phi = 2.0f * PI * xiX + random(normal.x, normal.z) * 0.1f;
+        float cosTheta = sqrtf((1.0f - xiY) / (1.0f + (alpha * alpha - 1.0f) * xiY));
+        float sinTheta = sqrtf(1.0f - cosTheta * cosTheta);
+        Vec3 h(sinTheta * cosf(phi), sinTheta * sinf(phi), cosTheta);
+
+        Vec3 up = fabsf(normal.z) < 0.999f ? Vec3(0.0f, 0.0f, 1.0f) : Vec3(1.0f, 0.0f, 0.0f);
+        Vec3 tangentX = normalize(cross(up, normal));
+        Vec3 tangentY = normalize(cross(normal, tangentX));
+
+        return normalize(tangentX * h.x + tangentY * h.y + normal * h.z);
+    }
+
+    inline float distributeGGX(float dotNH, float roughness)
+    {
+        float alpha = roughness * roughness;
+        float alpha2 = alpha * alpha;
+        float denom = dotNH * dotNH * (alpha2 - 1.0f) + 1.0f;
+        return alpha2 / (PI * denom * denom);
+    }
+
+    inline float geometrySchlickSmithGGX(float dotNL, float dotNV, float roughness)
+    {
+        float k = (roughness * roughness) / 2.0f;
+        float gl = dotNL / (dotNL * (1.0f - k) + k);
+        float gv = dotNV / (dotNV * (1.0f - k) + k);
+        return gl * gv;
+    }
+}
@@ -0,0 +1,207 @@
+#include "SphericalHarmonics.h"
+
+#include <vector>
+#include "CubemapBaker.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <xmmintrin.h>
+#define SH_USE_SSE
+#endif
+
+using namespace IBLMath;
+
+namespace
+{
+    // 9 RGBA sums followed by the total solid angle of the row.
+    const uint32_t ROW_SUM_SIZE = SphericalHarmonics::COEFFICIENT_COUNT * 4 + 1;
+
+    struct RowAccumulator
+    {
+#ifdef SH_USE_SSE
+        __m128 sums[SphericalHarmonics::COEFFICIENT_COUNT];
+
+        RowAccumulator()
+        {
+            for (auto& sum : sums)
+            {
+                sum = _mm_setzero_ps();
+            }
+        }
+
+        void add(const float* texel, const float* basis, float weight)
+        {
+            __m128 radiance = _mm_mul_ps(_mm_loadu_ps(texel), _mm_set1_ps(weight));
+            for (uint32_t i = 0; i < SphericalHarmonics::COEFFICIENT_COUNT; i++)
+            {
+                sums[i] = _mm_add_ps(sums[i], _mm_mul_ps(radiance, _mm_set1_ps(basis[i])));
+            }
+            totalWeight += weight;
+        }
+
+        void store(float* pOutput) const
+        {
+            for (uint32_t i = 0; i < SphericalHarmonics::COEFFICIENT_COUNT; i++)
+            {
+                _mm_storeu_ps(pOutput + i * 4, sums[i]);
+            }
+            pOutput[ROW_SUM_SIZE - 1] = totalWeight;
+        }
+#else
+        float sums[SphericalHarmonics::COEFFICIENT_COUNT][4] = {};
+
+        void add(const float* texel, const float* basis, float weight)
+        {
+            for (uint32_t i = 0; i < SphericalHarmonics::COEFFICIENT_COUNT; i++)
+            {
+                for (uint32_t channel = 0; channel < 4; channel++)
+                {
+                    sums[i][channel] += texel[channel] * weight * basis[i];
+                }
+            }
+            totalWeight += weight;
+        }
+
+        void store(float* pOutput) const
+        {
+            for (uint32_t i = 0; i < SphericalHarmonics::COEFFICIENT_COUNT; i++)
+            {
+                for (uint32_t channel = 0; channel < 4; channel++)
+                {
+                    pOutput[i * 4 + channel] = sums[i][channel];
+                }
+            }
+            pOutput[ROW_SUM_SIZE - 1] = totalWeight;
+        }
+#endif
+        float totalWeight = 0.0f;
+    };
+
+    std::vector<float> reduceRows(const std::vector<float>& rowSums, uint32_t rowCount)
+    {
+        // Rows are summed in order so the result does not depend on the thread count.
+        std::vector<float> sums(ROW_SUM_SIZE, 0.0f);
+        for (uint32_t row = 0; row < rowCount; row++)
+        {
+            for (uint32_t i = 0; i < ROW_SUM_SIZE; i++)
+            {
+                sums[i] += rowSums[(size_t)row * ROW_SUM_SIZE + i];
+            }
+        }
+        return sums;
+    }
+}
+
+SHIrradiance SphericalHarmonics::projectCubemap(const CpuCubemap& source, uint32_t mip, ThreadPool* threadPool)
+{
+    uint32_t size = source.getMipSize(mip);
+    std::vector<float> rowSums((size_t)6 * size * ROW_SUM_SIZE);
+    threadPool->parallelFor(6 * size, [&](uint32_t row)
+    {
+        uint32_t face = row / size;
+        uint32_t y = row % size;
+        const float* texels = source.getTexels(face, mip) + (size_t)y * size * 4;
+        RowAccumulator accumulator;
+        float basis[COEFFICIENT_COUNT];
+        for (uint32_t x = 0; x < size; x++)
+        {
+            float u = 2.0f * (x + 0.5f) / size - 1.0f;
+            float v = 2.0f * (y + 0.5f) / size - 1.0f;
+            evaluateBasis(normalize(cubeFaceDirection(face, u, v)), basis);
+            accumulator.add(texels + x * 4, basis, texelSolidAngle(u, v, 2.0f / size));
+        }
+        accumulator.store(rowSums.data() + (size_t)row * ROW_SUM_SIZE);
+    });
+    return convolve(reduceRows(rowSums, 6 * size).data());
+}
+
+SHIrradiance SphericalHarmonics::projectEquirectangular(const float* pixels, uint32_t width, uint32_t height,
+                                                        ThreadPool* threadPool)
+{
+    // Inverse of the mapping used by HDRToCubePS.hlsl.
+    std::vector<float> rowSums((size_t)height * ROW_SUM_SIZE);
+    threadPool->parallelFor(height, [&](uint32_t y)
+    {
+        float elevation = PI * (0.5f - (y + 0.5f) / height);
+        float weight = (2.0f * PI / width) * (PI / height) * cosf(elevation);
+        const float* row = pixels + (size_t)y * width * 4;
+        RowAccumulator accumulator;
+        float basis[COEFFICIENT_COUNT];
+        for (uint32_t x = 0; x < width; x++)
+        {
+            float azimuth = 2.0f * PI * (1.0f - (x + 0.5f) / width);
+            Vec3 direction(cosf(elevation) * cosf(azimuth), sinf(elevation), cosf(elevation) * sinf(azimuth));
+            evaluateBasis(direction, basis);
+            accumulator.add(row + x * 4, basis, weight);
+        }
+        accumulator.store(rowSums.data() + (size_t)y * ROW_SUM_SIZE);
+    });
+    return convolve(reduceRows(rowSums, height).data());
+}
+
+Vec3 SphericalHarmonics::evaluate(const SHIrradiance& irradiance, const Vec3& normal)
+{
+    float basis[COEFFICIENT_COUNT];
+    evaluateBasis(normal, basis);
+    Vec3 result;
+    for (uint32_t i = 0; i < COEFFICIENT_COUNT; i++)
+    {
+        const float* coefficient = irradiance.coefficients[i];
+        result += Vec3(coefficient[0], coefficient[1], coefficient[2]) * basis[i];
+    }
+    return result;
+}
+
+void SphericalHarmonics::renderIrradiance(const SHIrradiance& irradiance, uint32_t sideSize, CpuCubemap* pOutput)
+{
+    pOutput->allocate(sideSize, 1);
+    for (uint32_t face = 0; face < 6; face++)
+    {
+        float* texels = pOutput->getTexels(face, 0);
+        for (uint32_t y = 0; y < sideSize; y++)
+        {
+            for (uint32_t x = 0; x < sideSize; x++)
+            {
+                Vec3 normal = normalize(cubeFaceDirection(face, 2.0f * (x + 0.5f) / sideSize - 1.0f,
+                                                          2.0f * (y + 0.5f) / sideSize - 1.0f));
+                Vec3 color = evaluate(irradiance, normal);
+                float* texel = texels + ((size_t)y * sideSize + x) * 4;
+                texel[0] = color.x;
+                texel[1] = color.y;
+                texel[2] = color.z;
+                texel[3] = 1.0f;
+            }
+        }
+    }
+}
+
+void SphericalHarmonics::evaluateBasis(const Vec3& direction, float* pBasis)
+{
+    // Real SH basis up to l = 2; PBRPixelShader.hlsl evaluates the same constants.
+    pBasis[0] = 0.282095f;
+    pBasis[1] = 0.488603f * direction.y;
+    pBasis[2] = 0.488603f * direction.z;
+    pBasis[3] = 0.488603f * direction.x;
+    pBasis[4] = 1.092548f * direction.x * direction.y;
+    pBasis[5] = 1.092548f * direction.y * direction.z;
+    pBasis[6] = 0.315392f * (3.0f * direction.z * direction.z - 1.0f);
+    pBasis[7] = 1.092548f * direction.x * direction.z;
+    pBasis[8] = 0.546274f * (direction.x * direction.x - direction.y * direction.y);
+}
+
+SHIrradiance SphericalHarmonics::convolve(const float* sums)
+{
+    // Cosine lobe band factors (PI, 2PI/3, PI/4) divided by PI. The texel solid angles only approximate the sphere,
+    // so the projection is rescaled to a total of 4PI.
+    const float bandFactors[] = {1.0f, 2.0f / 3.0f, 2.0f / 3.0f, 2.0f / 3.0f, 0.25f, 0.25f, 0.25f, 0.25f, 0.25f};
+    float normalization = 4.0f * PI / sums[ROW_SUM_SIZE - 1];
+    SHIrradiance result;
+    for (uint32_t i = 0; i < COEFFICIENT_COUNT; i++)
+    {
+        for (uint32_t channel = 0; channel < 3; channel++)
+        {
+            result.coefficients[i][channel] = sums[i * 4 + channel] * normalization * bandFactors[i];
+        }
+        result.coefficients[i][3] = 0.0f;
+    }
+    return result;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+#include "IBLMath.h"
+#include "../../Utils/ThreadPool.h"
+
+struct CpuCubemap;
+
+struct SHIrradiance
+{
+    // L2 coefficients already convolved with the clamped cosine lobe and divided by PI, so evaluating them gives
+    // the same value as CubemapBaker::renderIrradiance. Padded to float4 to match the constant buffer layout.
+    float coefficients[9][4] = {};
+};
+
+class SphericalHarmonics
+{
+public:
+    static const uint32_t COEFFICIENT_COUNT = 9;
+
+    static SHIrradiance projectCubemap(const CpuCubemap& source, uint32_t mip, ThreadPool* threadPool);
+    static SHIrradiance projectEquirectangular(const float* pixels, uint32_t width, uint32_t height,
+                                               ThreadPool* threadPool);
+    static IBLMath::Vec3 evaluate(const SHIrradiance& irradiance, const IBLMath::Vec3& normal);
+    static void renderIrradiance(const SHIrradiance& irradiance, uint32_t sideSize, CpuCubemap* pOutput);
+
+private:
+    static void evaluateBasis(const IBLMath::Vec3& direction, float* pBasis);
+    static SHIrradiance convolve(const float* sums);
+};
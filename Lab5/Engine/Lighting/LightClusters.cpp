@@ -0,0 +1,343 @@
+#include "LightClusters.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "../IBL/FloatLanes.h"
+
+namespace
+{
+    // Depth range of the exponential slices. Slice 0 also takes everything nearer and the last one everything
+    // farther, up to the far plane.
+    const float CLUSTER_NEAR = 0.1f;
+    const float CLUSTER_FAR = 1000.0f;
+    // A sphere reaching this close to the eye plane covers the whole screen.
+    const float MIN_BOUNDS_DEPTH = 1e-4f;
+    const float FAR_AWAY = 1e30f;
+    const uint32_t LIGHTS_PER_TASK = 1024;
+
+    // Rows of LightClusters::bounds: the view space sphere, then its screen rectangle in NDC.
+    enum BoundsRow
+    {
+        BOUNDS_X,
+        BOUNDS_Y,
+        BOUNDS_Z,
+        BOUNDS_RADIUS,
+        BOUNDS_MIN_X,
+        BOUNDS_MAX_X,
+        BOUNDS_MIN_Y,
+        BOUNDS_MAX_Y,
+        BOUNDS_ROW_COUNT
+    };
+
+    // Rows of the candidate lights of one slice, gathered from the bounds.
+    enum CandidateRow
+    {
+        CANDIDATE_X,
+        CANDIDATE_Y,
+        CANDIDATE_Z,
+        CANDIDATE_RADIUS_SQUARED,
+        CANDIDATE_MIN_X,
+        CANDIDATE_MAX_X,
+        CANDIDATE_MIN_Y,
+        CANDIDATE_MAX_Y,
+        CANDIDATE_ROW_COUNT
+    };
+
+    uint32_t roundUpToLanes(uint32_t count)
+    {
+        return (count + FloatLanes::WIDTH - 1) / FloatLanes::WIDTH * FloatLanes::WIDTH;
+    }
+
+    // floor(value) clamped to [0, count - 1]; NaN lands in cell 0 like the HLSL clamp.
+    uint32_t clampCell(float value, uint32_t count)
+    {
+        if (!(value > 0.0f))
+        {
+            return 0;
+        }
+        return (uint32_t)std::min(floorf(value), count - 1.0f);
+    }
+
+    // Distance of the lanes' coordinates to [boxMin, boxMax] along one axis, zero inside.
+    FloatLanes getAxisDistance(const FloatLanes& coordinate, const FloatLanes& boxMin, const FloatLanes& boxMax)
+    {
+        FloatLanes outside = FloatLanes::maximum(boxMin - coordinate, coordinate - boxMax);
+        return FloatLanes::maximum(outside, FloatLanes::set(0.0f));
+    }
+}
+
+LightClusters::LightClusters(ThreadPool* threadPool) : threadPool(threadPool), clusters(CLUSTER_COUNT),
+                                                       sliceLights(GRID_Z), sliceIndices(GRID_Z)
+{
+}
+
+void LightClusters::build(const PointLightSource* lights, uint32_t lightCount, const Float4x4& viewMatrix,
+                          float fovY, float aspectRatio, float farZ)
+{
+    this->viewMatrix = viewMatrix;
+    scaleY = 1.0f / tanf(fovY * 0.5f);
+    scaleX = scaleY / aspectRatio;
+    this->farZ = farZ;
+    depthScale = GRID_Z / log2f(CLUSTER_FAR / CLUSTER_NEAR);
+    depthBias = -log2f(CLUSTER_NEAR) * depthScale;
+
+    boundLights(lights, lightCount);
+    bucketLights(lightCount);
+    if (threadPool)
+    {
+        threadPool->parallelFor(GRID_Z, [this](uint32_t slice) { assignSlice(slice); });
+    }
+    else
+    {
+        for (uint32_t slice = 0; slice < GRID_Z; slice++)
+        {
+            assignSlice(slice);
+        }
+    }
+
+    // Slices fill their clusters with offsets into their own list; append the lists in slice order.
+    size_t indexCount = 0;
+    for (const std::vector<uint32_t>& indices : sliceIndices)
+    {
+        indexCount += indices.size();
+    }
+    lightIndices.resize(indexCount);
+    maxClusterLights = 0;
+    uint32_t sliceOffset = 0;
+    for (uint32_t slice = 0; slice < GRID_Z; slice++)
+    {
+        const std::vector<uint32_t>& indices = sliceIndices[slice];
+        if (!indices.empty())
+        {
+            memcpy(lightIndices.data() + sliceOffset, indices.data(), indices.size() * sizeof(uint32_t));
+        }
+        for (uint32_t cluster = slice * GRID_X * GRID_Y; cluster < (slice + 1) * GRID_X * GRID_Y; cluster++)
+        {
+            clusters[cluster].offset += sliceOffset;
+            maxClusterLights = std::max(maxClusterLights, clusters[cluster].count);
+        }
+        sliceOffset += (uint32_t)indices.size();
+    }
+}
+
+uint32_t LightClusters::findCluster(const Float3& worldPosition) const
+{
+    const float(*m)[4] = viewMatrix.m;
+    float viewX = worldPosition.x * m[0][0] + worldPosition.y * m[1][0] + worldPosition.z * m[2][0] + m[3][0];
+    float viewY = worldPosition.x * m[0][1] + worldPosition.y * m[1][1] + worldPosition.z * m[2][1] + m[3][1];
+    float viewZ = worldPosition.x * m[0][2] + worldPosition.y * m[1][2] + worldPosition.z * m[2][2] + m[3][2];
+    uint32_t x = clampCell((viewX * scaleX / viewZ * 0.5f + 0.5f) * GRID_X, GRID_X);
+    uint32_t y = clampCell((viewY * scaleY / viewZ * 0.5f + 0.5f) * GRID_Y, GRID_Y);
+    return (getSlice(viewZ) * GRID_Y + y) * GRID_X + x;
+}
+
+const std::vector<LightCluster>& LightClusters::getClusters() const
+{
+    return clusters;
+}
+
+const std::vector<uint32_t>& LightClusters::getLightIndices() const
+{
+    return lightIndices;
+}
+
+uint32_t LightClusters::getMaxClusterLights() const
+{
+    return maxClusterLights;
+}
+
+float LightClusters::getDepthScale() const
+{
+    return depthScale;
+}
+
+float LightClusters::getDepthBias() const
+{
+    return depthBias;
+}
+
+// View space spheres and their screen rectangles. Over a box x in [lo, hi], z in [zMin, zMax] in front of the eye,
+// x / z is smallest at lo / zMax when lo is positive and at lo / zMin otherwise, and the other way round for hi.
+void LightClusters::boundLights(const PointLightSource* lights, uint32_t lightCount)
+{
+    boundsStride = roundUpToLanes(lightCount);
+    bounds.assign((size_t)boundsStride * BOUNDS_ROW_COUNT, 0.0f);
+    float* rows[BOUNDS_ROW_COUNT];
+    for (uint32_t row = 0; row < BOUNDS_ROW_COUNT; row++)
+    {
+        rows[row] = bounds.data() + (size_t)row * boundsStride;
+    }
+    for (uint32_t i = 0; i < lightCount; i++)
+    {
+        rows[BOUNDS_X][i] = lights[i].position.x;
+        rows[BOUNDS_Y][i] = lights[i].position.y;
+        rows[BOUNDS_Z][i] = lights[i].position.z;
+        rows[BOUNDS_RADIUS][i] = lights[i].radius;
+    }
+
+    auto boundTask = [&](uint32_t task)
+    {
+        const float(*m)[4] = viewMatrix.m;
+        FloatLanes zero = FloatLanes::set(0.0f);
+        FloatLanes minDepth = FloatLanes::set(MIN_BOUNDS_DEPTH);
+        FloatLanes farAway = FloatLanes::set(FAR_AWAY);
+        FloatLanes negativeFarAway = FloatLanes::set(-FAR_AWAY);
+        uint32_t end = std::min(boundsStride, (task + 1) * LIGHTS_PER_TASK);
+        for (uint32_t i = task * LIGHTS_PER_TASK; i < end; i += FloatLanes::WIDTH)
+        {
+            FloatLanes worldX = FloatLanes::load(rows[BOUNDS_X] + i);
+            FloatLanes worldY = FloatLanes::load(rows[BOUNDS_Y] + i);
+            FloatLanes worldZ = FloatLanes::load(rows[BOUNDS_Z] + i);
+            FloatLanes view[3];
+            for (uint32_t axis = 0; axis < 3; axis++)
+            {
+                view[axis] = worldX * FloatLanes::set(m[0][axis]) + worldY * FloatLanes::set(m[1][axis]) +
+                    worldZ * FloatLanes::set(m[2][axis]) + FloatLanes::set(m[3][axis]);
+                view[axis].store(rows[BOUNDS_X + axis] + i);
+            }
+            FloatLanes radius = FloatLanes::load(rows[BOUNDS_RADIUS] + i);
+            FloatLanes zMin = view[2] - radius;
+            FloatLanes zMax = view[2] + radius;
+            FloatLanes crossesEye = minDepth > zMin;
+            const float scales[2] = {scaleX, scaleY};
+            for (uint32_t axis = 0; axis < 2; axis++)
+            {
+                FloatLanes low = view[axis] - radius;
+                FloatLanes high = view[axis] + radius;
+                FloatLanes lowBound = low / FloatLanes::select(low >= zero, zMax, zMin) * FloatLanes::set(scales[axis]);
+                FloatLanes highBound = high / FloatLanes::select(high >= zero, zMin, zMax) *
+                    FloatLanes::set(scales[axis]);
+                FloatLanes::select(crossesEye, negativeFarAway, lowBound).store(rows[BOUNDS_MIN_X + axis * 2] + i);
+                FloatLanes::select(crossesEye, farAway, highBound).store(rows[BOUNDS_MAX_X + axis * 2] + i);
+            }
+        }
+    };
+    uint32_t taskCount = (boundsStride + LIGHTS_PER_TASK - 1) / LIGHTS_PER_TASK;
+    if (threadPool)
+    {
+        threadPool->parallelFor(taskCount, boundTask);
+        return;
+    }
+    for (uint32_t task = 0; task < taskCount; task++)
+    {
+        boundTask(task);
+    }
+}
+
+// Hands every light on screen to the slices its depth range covers.
+void LightClusters::bucketLights(uint32_t lightCount)
+{
+    for (std::vector<uint32_t>& lights : sliceLights)
+    {
+        lights.clear();
+    }
+    const float* rows = bounds.data();
+    for (uint32_t i = 0; i < lightCount; i++)
+    {
+        float radius = rows[BOUNDS_RADIUS * boundsStride + i];
+        float depth = rows[BOUNDS_Z * boundsStride + i];
+        if (!(radius > 0.0f) || depth + radius <= 0.0f || depth - radius >= farZ ||
+            rows[BOUNDS_MAX_X * boundsStride + i] < -1.0f || rows[BOUNDS_MIN_X * boundsStride + i] > 1.0f ||
+            rows[BOUNDS_MAX_Y * boundsStride + i] < -1.0f || rows[BOUNDS_MIN_Y * boundsStride + i] > 1.0f)
+        {
+            continue;
+        }
+        uint32_t lastSlice = getSlice(depth + radius);
+        for (uint32_t slice = getSlice(depth - radius); slice <= lastSlice; slice++)
+        {
+            sliceLights[slice].push_back(i);
+        }
+    }
+}
+
+// Tests the slice's candidate lights against every cluster of the slice: the sphere has to reach the cluster's view
+// space box and its screen rectangle has to overlap the cluster's tile.
+void LightClusters::assignSlice(uint32_t slice)
+{
+    const std::vector<uint32_t>& candidates = sliceLights[slice];
+    std::vector<uint32_t>& indices = sliceIndices[slice];
+    indices.clear();
+
+    uint32_t stride = roundUpToLanes((uint32_t)candidates.size());
+    std::vector<float> candidateRows((size_t)stride * CANDIDATE_ROW_COUNT);
+    float* rows[CANDIDATE_ROW_COUNT];
+    for (uint32_t row = 0; row < CANDIDATE_ROW_COUNT; row++)
+    {
+        rows[row] = candidateRows.data() + (size_t)row * stride;
+    }
+    for (uint32_t i = 0; i < stride; i++)
+    {
+        if (i >= candidates.size())
+        {
+            // Padding lanes sit far away with an empty rectangle and never pass.
+            rows[CANDIDATE_X][i] = rows[CANDIDATE_Y][i] = rows[CANDIDATE_Z][i] = FAR_AWAY;
+            rows[CANDIDATE_RADIUS_SQUARED][i] = 0.0f;
+            rows[CANDIDATE_MIN_X][i] = rows[CANDIDATE_MIN_Y][i] = FAR_AWAY;
+            rows[CANDIDATE_MAX_X][i] = rows[CANDIDATE_MAX_Y][i] = -FAR_AWAY;
+            continue;
+        }
+        const float* light = bounds.data() + candidates[i];
+        rows[CANDIDATE_X][i] = light[BOUNDS_X * boundsStride];
+        rows[CANDIDATE_Y][i] = light[BOUNDS_Y * boundsStride];
+        rows[CANDIDATE_Z][i] = light[BOUNDS_Z * boundsStride];
+        float radius = light[BOUNDS_RADIUS * boundsStride];
+        rows[CANDIDATE_RADIUS_SQUARED][i] = radius * radius;
+        rows[CANDIDATE_MIN_X][i] = light[BOUNDS_MIN_X * boundsStride];
+        rows[CANDIDATE_MAX_X][i] = light[BOUNDS_MAX_X * boundsStride];
+        rows[CANDIDATE_MIN_Y][i] = light[BOUNDS_MIN_Y * boundsStride];
+        rows[CANDIDATE_MAX_Y][i] = light[BOUNDS_MAX_Y * boundsStride];
+    }
+
+    float nearDepth = slice == 0 ? 0.0f : getSliceDepth(slice);
+    float farDepth = slice == GRID_Z - 1 ? std::max(farZ, getSliceDepth(GRID_Z)) : getSliceDepth(slice + 1);
+    FloatLanes boxMinZ = FloatLanes::set(nearDepth);
+    FloatLanes boxMaxZ = FloatLanes::set(farDepth);
+    for (uint32_t y = 0; y < GRID_Y; y++)
+    {
+        float bottom = 2.0f * y / GRID_Y - 1.0f;
+        float top = 2.0f * (y + 1) / GRID_Y - 1.0f;
+        FloatLanes boxMinY = FloatLanes::set(std::min(bottom / scaleY * nearDepth, bottom / scaleY * farDepth));
+        FloatLanes boxMaxY = FloatLanes::set(std::max(top / scaleY * nearDepth, top / scaleY * farDepth));
+        for (uint32_t x = 0; x < GRID_X; x++)
+        {
+            float left = 2.0f * x / GRID_X - 1.0f;
+            float right = 2.0f * (x + 1) / GRID_X - 1.0f;
+            FloatLanes boxMinX = FloatLanes::set(std::min(left / scaleX * nearDepth, left / scaleX * farDepth));
+            FloatLanes boxMaxX = FloatLanes::set(std::max(right / scaleX * nearDepth, right / scaleX * farDepth));
+            LightCluster& cluster = clusters[(slice * GRID_Y + y) * GRID_X + x];
+            cluster.offset = (uint32_t)indices.size();
+            for (uint32_t i = 0; i < stride; i += FloatLanes::WIDTH)
+            {
+                FloatLanes onTile = (FloatLanes::load(rows[CANDIDATE_MAX_X] + i) >= FloatLanes::set(left)) &
+                    (FloatLanes::set(right) >= FloatLanes::load(rows[CANDIDATE_MIN_X] + i)) &
+                    (FloatLanes::load(rows[CANDIDATE_MAX_Y] + i) >= FloatLanes::set(bottom)) &
+                    (FloatLanes::set(top) >= FloatLanes::load(rows[CANDIDATE_MIN_Y] + i));
+                FloatLanes dx = getAxisDistance(FloatLanes::load(rows[CANDIDATE_X] + i), boxMinX, boxMaxX);
+                FloatLanes dy = getAxisDistance(FloatLanes::load(rows[CANDIDATE_Y] + i), boxMinY, boxMaxY);
+                FloatLanes dz = getAxisDistance(FloatLanes::load(rows[CANDIDATE_Z] + i), boxMinZ, boxMaxZ);
+                FloatLanes radiusSquared = FloatLanes::load(rows[CANDIDATE_RADIUS_SQUARED] + i);
+                FloatLanes reaches = radiusSquared >= dx * dx + dy * dy + dz * dz;
+                for (uint32_t mask = (uint32_t)(onTile & reaches).getMask(), lane = 0; mask; mask >>= 1, lane++)
+                {
+                    if (mask & 1)
+                    {
+                        indices.push_back(candidates[i + lane]);
+                    }
+                }
+            }
+            cluster.count = (uint32_t)indices.size() - cluster.offset;
+        }
+    }
+}
+
+uint32_t LightClusters::getSlice(float depth) const
+{
+    return clampCell(log2f(depth) * depthScale + depthBias, GRID_Z);
+}
+
+float LightClusters::getSliceDepth(uint32_t slice) const
+{
+    return exp2f((slice - depthBias) / depthScale);
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "../RenderDevice/RenderMath.h"
+#include "../../Utils/ThreadPool.h"
+
+// One element of the light buffer, laid out like PointLight in PBRPixelShader.hlsl. The inverse square falloff is
+// windowed to reach zero at radius, so a light touches only the clusters its sphere overlaps.
+struct PointLightSource
+{
+    Float3 position;
+    float radius = 25.0f;
+    Float3 color = RenderMath::makeFloat3(1.0f, 1.0f, 1.0f);
+    float intensity = 0;
+};
+
+// The lights of one cluster are lightIndices[offset, offset + count).
+struct LightCluster
+{
+    uint32_t offset = 0;
+    uint32_t count = 0;
+};
+
+// Clustered light assignment on the CPU. The view frustum is cut into GRID_X x GRID_Y screen tiles and GRID_Z slices
+// spaced exponentially in view depth, and every cluster gets the list of lights whose sphere overlaps it, so the pixel
+// shader only loops over the lights of its own cluster. Lights are transformed and bounded FloatLanes::WIDTH at a
+// time, then the depth slices are filled in parallel, each testing its candidate lights against every cluster
+// box with FloatLanes. A cluster may list a light that only grazes the corner of its box, never miss one that reaches
+// a point inside it.
+class LightClusters
+{
+public:
+    static const uint32_t GRID_X = 16;
+    static const uint32_t GRID_Y = 9;
+    static const uint32_t GRID_Z = 24;
+    static const uint32_t CLUSTER_COUNT = GRID_X * GRID_Y * GRID_Z;
+
+    // The thread pool may be null.
+    explicit LightClusters(ThreadPool* threadPool);
+
+private:
+    ThreadPool* threadPool;
+    Float4x4 viewMatrix;
+    // projection[0][0] and [1][1] of the RenderMath::perspectiveFov matrix the frame is drawn with.
+    float scaleX = 1.0f;
+    float scaleY = 1.0f;
+    float farZ = 1.0f;
+    float depthScale = 0.0f;
+    float depthBias = 0.0f;
+
+    std::vector<LightCluster> clusters;
+    std::vector<uint32_t> lightIndices;
+    uint32_t maxClusterLights = 0;
+
+    // View space bounds of every light, structure of arrays padded to whole lanes.
+    std::vector<float> bounds;
+    uint32_t boundsStride = 0;
+    std::vector<std::vector<uint32_t>> sliceLights;
+    std::vector<std::vector<uint32_t>> sliceIndices;
+
+public:
+    void build(const PointLightSource* lights, uint32_t lightCount, const Float4x4& viewMatrix, float fovY,
+               float aspectRatio, float farZ);
+
+    // The cluster PBRPixelShader.hlsl picks for a pixel at this world position.
+    uint32_t findCluster(const Float3& worldPosition) const;
+    // Indexed by (z * GRID_Y + y) * GRID_X + x, with x and y growing right and up on screen.
+    const std::vector<LightCluster>& getClusters() const;
+    const std::vector<uint32_t>& getLightIndices() const;
+    uint32_t getMaxClusterLights() const;
+    // The shader's slice is floor(log2(viewDepth) * depthScale + depthBias), clamped to the grid.
+    float getDepthScale() const;
+    float getDepthBias() const;
+
+private:
+    void boundLights(const PointLightSource* lights, uint32_t lightCount);
+    void bucketLights(uint32_t lightCount);
+    void assignSlice(uint32_t slice);
+    uint32_t getSlice(float depth) const;
+    float getSliceDepth(uint32_t slice) const;
+};
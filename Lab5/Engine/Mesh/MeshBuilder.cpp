@@ -0,0 +1,132 @@
+#include "MeshBuilder.h"
+
+#include <cstring>
+#include <unordered_map>
+
+#include "MeshOptimizer.h"
+
+namespace
+{
+    struct MeshVertexHash
+    {
+        size_t operator()(const MeshVertex& vertex) const
+        {
+            const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&vertex);
+            uint64_t hash = 14695981039346656037ull;
+            for (size_t i = 0; i < sizeof(MeshVertex); i++)
+            {
+                hash ^= bytes[i];
+                hash *= 1099511628211ull;
+            }
+            return (size_t)hash;
+        }
+    };
+
+    struct MeshVertexEqual
+    {
+        bool operator()(const MeshVertex& first, const MeshVertex& second) const
+        {
+            return memcmp(&first, &second, sizeof(MeshVertex)) == 0;
+        }
+    };
+}
+
+bool MeshData::canUseShortIndices() const
+{
+    return vertices.size() <= UINT16_MAX;
+}
+
+std::vector<uint16_t> MeshData::getShortIndices() const
+{
+    std::vector<uint16_t> result(indices.size());
+    for (size_t i = 0; i < indices.size(); i++)
+    {
+        result[i] = (uint16_t)indices[i];
+    }
+    return result;
+}
+
+MeshData MeshBuilder::buildIndexed(const tinyobj::attrib_t& attrib, const std::vector<tinyobj::shape_t>& shapes,
+                                   const float* defaultColor)
+{
+    MeshData result;
+    size_t sourceVertexCount = 0;
+    for (auto& shape : shapes)
+    {
+        sourceVertexCount += shape.mesh.indices.size();
+    }
+    result.indices.reserve(sourceVertexCount);
+
+    std::unordered_map<MeshVertex, uint32_t, MeshVertexHash, MeshVertexEqual> uniqueVertices;
+    uniqueVertices.reserve(sourceVertexCount);
+    for (auto& shape : shapes)
+    {
+        for (auto& index : shape.mesh.indices)
+        {
+            MeshVertex vertex = makeVertex(attrib, index, defaultColor);
+            auto inserted = uniqueVertices.emplace(vertex, (uint32_t)result.vertices.size());
+            if (inserted.second)
+            {
+                result.vertices.push_back(vertex);
+            }
+            result.indices.push_back(inserted.first->second);
+        }
+    }
+    result.stats.importedCache = MeshOptimizer::analyzeVertexCache(result.indices, (uint32_t)result.vertices.size());
+    MeshOptimizer::optimize(result);
+    result.stats.optimizedCache = MeshOptimizer::analyzeVertexCache(result.indices, (uint32_t)result.vertices.size());
+    calculateStats(result, (uint32_t)sourceVertexCount);
+    return result;
+}
+
+MeshData MeshBuilder::buildFlattened(const tinyobj::attrib_t& attrib, const std::vector<tinyobj::shape_t>& shapes,
+                                     const float* defaultColor)
+{
+    MeshData result;
+    for (auto& shape : shapes)
+    {
+        for (auto& index : shape.mesh.indices)
+        {
+            result.indices.push_back((uint32_t)result.vertices.size());
+            result.vertices.push_back(makeVertex(attrib, index, defaultColor));
+        }
+    }
+    calculateStats(result, (uint32_t)result.vertices.size());
+    return result;
+}
+
+MeshVertex MeshBuilder::makeVertex(const tinyobj::attrib_t& attrib, const tinyobj::index_t& index,
+                                   const float* defaultColor)
+{
+    MeshVertex vertex = {};
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        vertex.position[i] = attrib.vertices[index.vertex_index * 3 + i];
+        vertex.color[i] = defaultColor[i];
+    }
+    if (index.texcoord_index >= 0)
+    {
+        vertex.uv[0] = attrib.texcoords[index.texcoord_index * 2];
+        vertex.uv[1] = attrib.texcoords[index.texcoord_index * 2 + 1];
+    }
+    if (index.normal_index >= 0)
+    {
+        for (uint32_t i = 0; i < 3; i++)
+        {
+            vertex.normal[i] = attrib.normals[index.normal_index * 3 + i];
+        }
+    }
+    return vertex;
+}
+
+void MeshBuilder::calculateStats(MeshData& mesh, uint32_t sourceVertexCount)
+{
+    MeshBuildStats& stats = mesh.stats;
+    stats.sourceVertexCount = sourceVertexCount;
+    stats.uniqueVertexCount = (uint32_t)mesh.vertices.size();
+    stats.indexCount = (uint32_t)mesh.indices.size();
+    stats.indexSize = mesh.canUseShortIndices() ? sizeof(uint16_t) : sizeof(uint32_t);
+    stats.flattenedBytes = (size_t)sourceVertexCount * (sizeof(MeshVertex) + sizeof(uint32_t));
+    stats.indexedBytes = mesh.vertices.size() * sizeof(MeshVertex) + mesh.indices.size() * stats.indexSize;
+    stats.compressionRatio = stats.indexedBytes ? (float)stats.flattenedBytes / (float)stats.indexedBytes : 1.0f;
+}
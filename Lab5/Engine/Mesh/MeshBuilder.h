@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include "../tiny_obj_loader.h"
+
+struct MeshVertex
+{
+    float position[3];
+    float uv[2];
+    float normal[3];
+    float color[3];
+};
+
+// Post-transform vertex cache behaviour of a triangle list on a FIFO cache: vertices transformed per triangle
+// (ACMR, 0.5 at best on large regular meshes, 3 at worst) and per vertex referenced (ATVR, 1 at best).
+struct VertexCacheStats
+{
+    float acmr = 0.0f;
+    float atvr = 0.0f;
+};
+
+struct MeshBuildStats
+{
+    uint32_t sourceVertexCount = 0;
+    uint32_t uniqueVertexCount = 0;
+    uint32_t indexCount = 0;
+    uint32_t indexSize = 0;
+    size_t flattenedBytes = 0;
+    size_t indexedBytes = 0;
+    float compressionRatio = 1.0f;
+    // In the order the file had, and after MeshOptimizer.
+    VertexCacheStats importedCache;
+    VertexCacheStats optimizedCache;
+};
+
+struct MeshData
+{
+    std::vector<MeshVertex> vertices;
+    std::vector<uint32_t> indices;
+    MeshBuildStats stats;
+
+    bool canUseShortIndices() const;
+    std::vector<uint16_t> getShortIndices() const;
+};
+
+class MeshBuilder
+{
+public:
+    static MeshData buildIndexed(const tinyobj::attrib_t& attrib, const std::vector<tinyobj::shape_t>& shapes,
+                                 const float* defaultColor);
+    static MeshData buildFlattened(const tinyobj::attrib_t& attrib, const std::vector<tinyobj::shape_t>& shapes,
+                                   const float* defaultColor);
+
+private:
+    static MeshVertex makeVertex(const tinyobj::attrib_t& attrib, const tinyobj::index_t& index,
+                                 const float* defaultColor);
+    static void calculateStats(MeshData& mesh, uint32_t sourceVertexCount);
+};
@@ -0,0 +1,290 @@
+#include "MeshEncoder.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "../../Utils/HalfFloat.h"
+
+namespace
+{
+    const float SNORM16_MAX = 32767.0f;
+
+    int16_t toSnorm16(float value)
+    {
+        return (int16_t)lroundf(std::min(std::max(value, -1.0f), 1.0f) * SNORM16_MAX);
+    }
+
+    // -32768 and -32767 both mean -1, as on the GPU.
+    float fromSnorm16(int16_t value)
+    {
+        return std::max(value / SNORM16_MAX, -1.0f);
+    }
+
+    float getLength(const float* v)
+    {
+        return sqrtf(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+    }
+
+    // atan2 keeps its precision for small angles, where acos of the dot product runs out of float bits.
+    float getAngleDegrees(const float* a, const float* b)
+    {
+        const float cross[3] = {a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0]};
+        return atan2f(getLength(cross), a[0] * b[0] + a[1] * b[1] + a[2] * b[2]) * 180.0f / RenderMath::PI;
+    }
+
+    // Center and largest half extent of the bounds; a flat or empty mesh keeps a scale of one.
+    Float4 getPositionDequant(const MeshData& mesh)
+    {
+        float boundsMin[3] = {0.0f, 0.0f, 0.0f};
+        float boundsMax[3] = {0.0f, 0.0f, 0.0f};
+        for (size_t i = 0; i < mesh.vertices.size(); i++)
+        {
+            for (int axis = 0; axis < 3; axis++)
+            {
+                float value = mesh.vertices[i].position[axis];
+                boundsMin[axis] = i ? std::min(boundsMin[axis], value) : value;
+                boundsMax[axis] = i ? std::max(boundsMax[axis], value) : value;
+            }
+        }
+        float scale = 0.0f;
+        for (int axis = 0; axis < 3; axis++)
+        {
+            scale = std::max(scale, (boundsMax[axis] - boundsMin[axis]) * 0.5f);
+        }
+        return RenderMath::makeFloat4((boundsMin[0] + boundsMax[0]) * 0.5f, (boundsMin[1] + boundsMax[1]) * 0.5f,
+                                      (boundsMin[2] + boundsMax[2]) * 0.5f, scale > 0.0f ? scale : 1.0f);
+    }
+
+    void quantizePosition(const float* position, const Float4& dequant, int16_t* pOutput)
+    {
+        const float center[3] = {dequant.x, dequant.y, dequant.z};
+        for (int axis = 0; axis < 3; axis++)
+        {
+            pOutput[axis] = toSnorm16((position[axis] - center[axis]) / dequant.w);
+        }
+        pOutput[3] = 0;
+    }
+
+    float dequantize(int16_t value, float center, float scale)
+    {
+        return fromSnorm16(value) * scale + center;
+    }
+}
+
+VertexEncoding MeshEncoder::chooseEncoding(const MeshData& mesh, const VertexEncodingSettings& settings)
+{
+    Float4 dequant = getPositionDequant(mesh);
+    const float center[3] = {dequant.x, dequant.y, dequant.z};
+    float positionError = 0.0f;
+    float uvError = 0.0f;
+    for (const MeshVertex& vertex : mesh.vertices)
+    {
+        int16_t quantized[4];
+        quantizePosition(vertex.position, dequant, quantized);
+        for (int axis = 0; axis < 3; axis++)
+        {
+            float error = fabsf(dequantize(quantized[axis], center[axis], dequant.w) - vertex.position[axis]);
+            positionError = std::max(positionError, error);
+        }
+        for (int i = 0; i < 2; i++)
+        {
+            float error = fabsf(HalfFloat::toFloat(HalfFloat::fromFloat(vertex.uv[i])) - vertex.uv[i]);
+            // Also catches UVs out of the half range, which come back infinite.
+            uvError = std::isfinite(error) ? std::max(uvError, error) : INFINITY;
+        }
+    }
+    VertexEncoding encoding;
+    encoding.position = positionError <= settings.maxPositionError ? VERTEX_POSITION_SNORM16 : VERTEX_POSITION_FLOAT;
+    encoding.uv = uvError <= settings.maxUVError ? VERTEX_UV_HALF : VERTEX_UV_FLOAT;
+    return encoding;
+}
+
+EncodedMesh MeshEncoder::encode(const MeshData& mesh, const VertexEncoding& encoding)
+{
+    EncodedMesh result;
+    result.encoding = encoding;
+    result.stride = getStride(encoding);
+    result.vertices.resize(mesh.vertices.size() * result.stride);
+    result.positionDequant = encoding.position == VERTEX_POSITION_SNORM16
+                                 ? getPositionDequant(mesh)
+                                 : RenderMath::makeFloat4(0.0f, 0.0f, 0.0f, 1.0f);
+    if (!mesh.vertices.empty())
+    {
+        const float* color = mesh.vertices[0].color;
+        result.color = RenderMath::makeFloat3(color[0], color[1], color[2]);
+    }
+
+    for (size_t i = 0; i < mesh.vertices.size(); i++)
+    {
+        const MeshVertex& vertex = mesh.vertices[i];
+        uint8_t* output = &result.vertices[i * result.stride];
+        if (encoding.position == VERTEX_POSITION_SNORM16)
+        {
+            int16_t quantized[4];
+            quantizePosition(vertex.position, result.positionDequant, quantized);
+            memcpy(output, quantized, sizeof(quantized));
+            output += sizeof(quantized);
+        }
+        else
+        {
+            memcpy(output, vertex.position, sizeof(vertex.position));
+            output += sizeof(vertex.position);
+        }
+        if (encoding.uv == VERTEX_UV_HALF)
+        {
+            const uint16_t uv[2] = {HalfFloat::fromFloat(vertex.uv[0]), HalfFloat::fromFloat(vertex.uv[1])};
+            memcpy(output, uv, sizeof(uv));
+            output += sizeof(uv);
+        }
+        else
+        {
+            memcpy(output, vertex.uv, sizeof(vertex.uv));
+            output += sizeof(vertex.uv);
+        }
+        int16_t normal[2];
+        encodeOctahedral(vertex.normal, normal);
+        memcpy(output, normal, sizeof(normal));
+    }
+
+    VertexEncodingStats& stats = result.stats;
+    stats.sourceBytesPerVertex = sizeof(MeshVertex);
+    stats.bytesPerVertex = result.stride;
+    for (uint32_t i = 0; i < (uint32_t)mesh.vertices.size(); i++)
+    {
+        const MeshVertex& source = mesh.vertices[i];
+        MeshVertex decoded = decode(result, i);
+        for (int axis = 0; axis < 3; axis++)
+        {
+            stats.positionError = std::max(stats.positionError, fabsf(decoded.position[axis] - source.position[axis]));
+            stats.colorError = std::max(stats.colorError, fabsf(decoded.color[axis] - source.color[axis]));
+        }
+        for (int axis = 0; axis < 2; axis++)
+        {
+            stats.uvError = std::max(stats.uvError, fabsf(decoded.uv[axis] - source.uv[axis]));
+        }
+        if (getLength(source.normal) > 0.0f)
+        {
+            stats.normalErrorDegrees = std::max(stats.normalErrorDegrees,
+                                                getAngleDegrees(source.normal, decoded.normal));
+        }
+    }
+    return result;
+}
+
+std::vector<RenderVertexAttribute> MeshEncoder::getAttributes(const VertexEncoding& encoding)
+{
+    return {
+        {"POSITION", 0, encoding.position == VERTEX_POSITION_SNORM16 ? RENDER_FORMAT_R16G16B16A16_SNORM
+                                                                     : RENDER_FORMAT_R32G32B32_FLOAT},
+        {"UV", 0, encoding.uv == VERTEX_UV_HALF ? RENDER_FORMAT_R16G16_FLOAT : RENDER_FORMAT_R32G32_FLOAT},
+        {"NORMAL", 0, RENDER_FORMAT_R16G16_SNORM}
+    };
+}
+
+uint32_t MeshEncoder::getStride(const VertexEncoding& encoding)
+{
+    uint32_t stride = 0;
+    for (const RenderVertexAttribute& attribute : getAttributes(encoding))
+    {
+        stride += RenderDevice::getBytesPerPixel(attribute.format);
+    }
+    return stride;
+}
+
+MeshVertex MeshEncoder::decode(const EncodedMesh& mesh, uint32_t vertex)
+{
+    MeshVertex result = {};
+    const uint8_t* input = &mesh.vertices[(size_t)vertex * mesh.stride];
+    if (mesh.encoding.position == VERTEX_POSITION_SNORM16)
+    {
+        int16_t quantized[4];
+        memcpy(quantized, input, sizeof(quantized));
+        input += sizeof(quantized);
+        const float center[3] = {mesh.positionDequant.x, mesh.positionDequant.y, mesh.positionDequant.z};
+        for (int axis = 0; axis < 3; axis++)
+        {
+            result.position[axis] = dequantize(quantized[axis], center[axis], mesh.positionDequant.w);
+        }
+    }
+    else
+    {
+        memcpy(result.position, input, sizeof(result.position));
+        input += sizeof(result.position);
+    }
+    if (mesh.encoding.uv == VERTEX_UV_HALF)
+    {
+        uint16_t uv[2];
+        memcpy(uv, input, sizeof(uv));
+        input += sizeof(uv);
+        result.uv[0] = HalfFloat::toFloat(uv[0]);
+        result.uv[1] = HalfFloat::toFloat(uv[1]);
+    }
+    else
+    {
+        memcpy(result.uv, input, sizeof(result.uv));
+        input += sizeof(result.uv);
+    }
+    int16_t normal[2];
+    memcpy(normal, input, sizeof(normal));
+    decodeOctahedral(normal, result.normal);
+    result.color[0] = mesh.color.x;
+    result.color[1] = mesh.color.y;
+    result.color[2] = mesh.color.z;
+    return result;
+}
+
+// Projects the unit normal onto the octahedron |x| + |y| + |z| = 1 and unfolds the lower half over the corners of
+// the square. Of the four nearest grid points, the one decoding closest to the normal is kept.
+void MeshEncoder::encodeOctahedral(const float* normal, int16_t* pOutput)
+{
+    float sum = fabsf(normal[0]) + fabsf(normal[1]) + fabsf(normal[2]);
+    if (sum == 0.0f)
+    {
+        pOutput[0] = pOutput[1] = 0;
+        return;
+    }
+    float x = normal[0] / sum;
+    float y = normal[1] / sum;
+    if (normal[2] < 0.0f)
+    {
+        float foldedX = (1.0f - fabsf(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+        float foldedY = (1.0f - fabsf(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+        x = foldedX;
+        y = foldedY;
+    }
+    float length = getLength(normal);
+    float bestCosine = -2.0f;
+    for (int candidate = 0; candidate < 4; candidate++)
+    {
+        float scaledX = (candidate & 1 ? ceilf(x * SNORM16_MAX) : floorf(x * SNORM16_MAX)) / SNORM16_MAX;
+        float scaledY = (candidate & 2 ? ceilf(y * SNORM16_MAX) : floorf(y * SNORM16_MAX)) / SNORM16_MAX;
+        const int16_t encoded[2] = {toSnorm16(scaledX), toSnorm16(scaledY)};
+        float decoded[3];
+        decodeOctahedral(encoded, decoded);
+        float cosine = (decoded[0] * normal[0] + decoded[1] * normal[1] + decoded[2] * normal[2]) / length;
+        if (cosine > bestCosine)
+        {
+            bestCosine = cosine;
+            pOutput[0] = encoded[0];
+            pOutput[1] = encoded[1];
+        }
+    }
+}
+
+// The same steps as decodeOctahedral in Shaders/Lighting/VertexShader.hlsl.
+void MeshEncoder::decodeOctahedral(const int16_t* encoded, float* pOutput)
+{
+    float x = fromSnorm16(encoded[0]);
+    float y = fromSnorm16(encoded[1]);
+    float z = 1.0f - fabsf(x) - fabsf(y);
+    float t = std::max(-z, 0.0f);
+    x += x >= 0.0f ? -t : t;
+    y += y >= 0.0f ? -t : t;
+    const float unnormalized[3] = {x, y, z};
+    float length = getLength(unnormalized);
+    for (int axis = 0; axis < 3; axis++)
+    {
+        pOutput[axis] = unnormalized[axis] / length;
+    }
+}
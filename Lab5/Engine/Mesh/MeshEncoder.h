@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "MeshBuilder.h"
+#include "../RenderDevice/RenderDevice.h"
+#include "../RenderDevice/RenderMath.h"
+
+enum VertexPositionEncoding
+{
+    VERTEX_POSITION_FLOAT,
+    // R16G16B16A16_SNORM around the center of the bounds, scaled by the largest half extent.
+    VERTEX_POSITION_SNORM16
+};
+
+enum VertexUVEncoding
+{
+    VERTEX_UV_FLOAT,
+    VERTEX_UV_HALF
+};
+
+// Normals are always octahedral in R16G16_SNORM, which is as small as 10:10:10:2 and more precise. Colors are not
+// stored per vertex.
+struct VertexEncoding
+{
+    VertexPositionEncoding position = VERTEX_POSITION_FLOAT;
+    VertexUVEncoding uv = VERTEX_UV_FLOAT;
+};
+
+struct VertexEncodingSettings
+{
+    // Largest position error 16-bit positions may introduce, in mesh units.
+    float maxPositionError = 1e-3f;
+    // Largest UV error half-float UVs may introduce: half a texel of a 1024 texture, which holds for UVs in [-2, 2].
+    float maxUVError = 1.0f / 2048.0f;
+};
+
+// Largest differences between the decoded vertices and the source ones.
+struct VertexEncodingStats
+{
+    uint32_t sourceBytesPerVertex = 0;
+    uint32_t bytesPerVertex = 0;
+    float positionError = 0.0f;
+    float uvError = 0.0f;
+    float normalErrorDegrees = 0.0f;
+    // Between the vertex colors and the one mesh color drawn instead.
+    float colorError = 0.0f;
+};
+
+struct EncodedMesh
+{
+    VertexEncoding encoding;
+    uint32_t stride = 0;
+    std::vector<uint8_t> vertices;
+    // The shaders decode positions as position * positionDequant.w + positionDequant.xyz.
+    Float4 positionDequant;
+    // The vertex color of the source mesh, to multiply into the per-instance albedo.
+    Float3 color;
+    VertexEncodingStats stats;
+};
+
+// Packs MeshVertex into the smallest vertex format that stays within the error bounds of the settings. The layout
+// of an encoding is POSITION, UV and NORMAL in stream 0, which is what the mesh shaders declare.
+class MeshEncoder
+{
+public:
+    static VertexEncoding chooseEncoding(const MeshData& mesh, const VertexEncodingSettings& settings);
+    static EncodedMesh encode(const MeshData& mesh, const VertexEncoding& encoding);
+    // The stream 0 attributes of the encoding, for RenderShaderDesc::attributes.
+    static std::vector<RenderVertexAttribute> getAttributes(const VertexEncoding& encoding);
+    static uint32_t getStride(const VertexEncoding& encoding);
+    // Reads one vertex back the way the input assembler and the shaders do.
+    static MeshVertex decode(const EncodedMesh& mesh, uint32_t vertex);
+
+    static void encodeOctahedral(const float* normal, int16_t* pOutput);
+    static void decodeOctahedral(const int16_t* encoded, float* pOutput);
+};
@@ -0,0 +1,356 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace
+{
+    // Splitting a cluster may cost this much in cache misses for the chance of a better draw order.
+    const float OVERDRAW_THRESHOLD = 1.05f;
+
+    // A FIFO cache kept as the time each vertex entered it: a vertex is in the cache while fewer than size vertices
+    // entered after it, so flushing only moves the clock.
+    class FifoCache
+    {
+    public:
+        FifoCache(uint32_t vertexCount, uint32_t size) : entryTimes(vertexCount, 0), size(size), time(size + 1)
+        {
+        }
+
+        bool contains(uint32_t vertex) const
+        {
+            return time - entryTimes[vertex] <= size;
+        }
+
+        // Returns 1 on a miss, which transforms the vertex and puts it in the cache.
+        uint32_t access(uint32_t vertex)
+        {
+            if (contains(vertex))
+            {
+                return 0;
+            }
+            entryTimes[vertex] = time++;
+            return 1;
+        }
+
+        // How many vertices entered since vertex did, large if it never did.
+        uint32_t getAge(uint32_t vertex) const
+        {
+            return time - entryTimes[vertex];
+        }
+
+        void flush()
+        {
+            time += size + 1;
+        }
+
+    private:
+        std::vector<uint32_t> entryTimes;
+        uint32_t size;
+        uint32_t time;
+    };
+
+    void subtract(const float* a, const float* b, float* pOutput)
+    {
+        for (int axis = 0; axis < 3; axis++)
+        {
+            pOutput[axis] = a[axis] - b[axis];
+        }
+    }
+
+    // Twice the area times the unit normal of the triangle.
+    void getScaledNormal(const MeshVertex& v0, const MeshVertex& v1, const MeshVertex& v2, float* pOutput)
+    {
+        float edge1[3];
+        float edge2[3];
+        subtract(v1.position, v0.position, edge1);
+        subtract(v2.position, v0.position, edge2);
+        pOutput[0] = edge1[1] * edge2[2] - edge1[2] * edge2[1];
+        pOutput[1] = edge1[2] * edge2[0] - edge1[0] * edge2[2];
+        pOutput[2] = edge1[0] * edge2[1] - edge1[1] * edge2[0];
+    }
+
+    float getLength(const float* v)
+    {
+        return sqrtf(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+    }
+}
+
+void MeshOptimizer::optimize(MeshData& mesh)
+{
+    std::vector<uint32_t> clusters;
+    std::vector<uint32_t> indices = optimizeVertexCache(mesh.indices, (uint32_t)mesh.vertices.size(), &clusters);
+    mesh.indices = optimizeOverdraw(mesh, indices, clusters, OVERDRAW_THRESHOLD);
+    optimizeVertexFetch(mesh);
+}
+
+// Fans around one vertex at a time, emitting all its remaining triangles, then moves to the neighbour that will
+// still be in the cache once its own triangles are emitted, preferring the one that entered it first. With no such
+// neighbour it backtracks to recently used vertices, then to the lowest numbered vertex with triangles left.
+std::vector<uint32_t> MeshOptimizer::optimizeVertexCache(const std::vector<uint32_t>& indices, uint32_t vertexCount,
+                                                         std::vector<uint32_t>* pClusters)
+{
+    uint32_t triangleCount = (uint32_t)(indices.size() / 3);
+    std::vector<uint32_t> liveTriangles(vertexCount, 0);
+    for (uint32_t index : indices)
+    {
+        liveTriangles[index]++;
+    }
+    std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+    for (uint32_t vertex = 0; vertex < vertexCount; vertex++)
+    {
+        adjacencyOffsets[vertex + 1] = adjacencyOffsets[vertex] + liveTriangles[vertex];
+    }
+    std::vector<uint32_t> adjacency(indices.size());
+    std::vector<uint32_t> adjacencyFill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+    for (uint32_t triangle = 0; triangle < triangleCount; triangle++)
+    {
+        for (uint32_t corner = 0; corner < 3; corner++)
+        {
+            adjacency[adjacencyFill[indices[triangle * 3 + corner]]++] = triangle;
+        }
+    }
+
+    std::vector<uint32_t> result;
+    result.reserve(triangleCount * 3);
+    std::vector<uint8_t> emitted(triangleCount, 0);
+    std::vector<uint32_t> deadEnds;
+    std::vector<uint32_t> candidates;
+    FifoCache cache(vertexCount, CACHE_SIZE);
+    uint32_t cursor = 0;
+    auto skipDeadEnd = [&]() -> uint32_t
+    {
+        while (!deadEnds.empty())
+        {
+            uint32_t vertex = deadEnds.back();
+            deadEnds.pop_back();
+            if (liveTriangles[vertex])
+            {
+                return vertex;
+            }
+        }
+        for (; cursor < vertexCount; cursor++)
+        {
+            if (liveTriangles[cursor])
+            {
+                return cursor;
+            }
+        }
+        return UINT32_MAX;
+    };
+
+    if (pClusters)
+    {
+        pClusters->clear();
+    }
+    uint32_t fanning = skipDeadEnd();
+    bool jumped = true;
+    while (fanning != UINT32_MAX)
+    {
+        if (jumped && pClusters && (pClusters->empty() || pClusters->back() != result.size() / 3))
+        {
+            pClusters->push_back((uint32_t)(result.size() / 3));
+        }
+        candidates.clear();
+        for (uint32_t i = adjacencyOffsets[fanning]; i < adjacencyOffsets[fanning + 1]; i++)
+        {
+            uint32_t triangle = adjacency[i];
+            if (emitted[triangle])
+            {
+                continue;
+            }
+            emitted[triangle] = 1;
+            for (uint32_t corner = 0; corner < 3; corner++)
+            {
+                uint32_t vertex = indices[triangle * 3 + corner];
+                result.push_back(vertex);
+                deadEnds.push_back(vertex);
+                candidates.push_back(vertex);
+                liveTriangles[vertex]--;
+                cache.access(vertex);
+            }
+        }
+
+        uint32_t next = UINT32_MAX;
+        int64_t bestPriority = -1;
+        for (uint32_t vertex : candidates)
+        {
+            if (!liveTriangles[vertex])
+            {
+                continue;
+            }
+            // Emitting the fan around a vertex adds at most two vertices to the cache per triangle.
+            int64_t priority = 0;
+            if (cache.getAge(vertex) + 2 * liveTriangles[vertex] <= CACHE_SIZE)
+            {
+                priority = cache.getAge(vertex);
+            }
+            if (priority > bestPriority)
+            {
+                bestPriority = priority;
+                next = vertex;
+            }
+        }
+        jumped = next == UINT32_MAX;
+        fanning = jumped ? skipDeadEnd() : next;
+    }
+    return result;
+}
+
+std::vector<uint32_t> MeshOptimizer::optimizeOverdraw(const MeshData& mesh, const std::vector<uint32_t>& indices,
+                                                      const std::vector<uint32_t>& clusters, float threshold)
+{
+    uint32_t triangleCount = (uint32_t)(indices.size() / 3);
+    if (!triangleCount)
+    {
+        return indices;
+    }
+
+    // Starting over with an empty cache costs a few misses; a cluster is split once the part so far has paid for it.
+    std::vector<uint32_t> starts;
+    FifoCache cache((uint32_t)mesh.vertices.size(), CACHE_SIZE);
+    for (size_t cluster = 0; cluster < clusters.size(); cluster++)
+    {
+        uint32_t start = clusters[cluster];
+        uint32_t end = cluster + 1 < clusters.size() ? clusters[cluster + 1] : triangleCount;
+        cache.flush();
+        uint32_t clusterMisses = 0;
+        for (uint32_t i = start * 3; i < end * 3; i++)
+        {
+            clusterMisses += cache.access(indices[i]);
+        }
+        float limit = threshold * clusterMisses / (end - start);
+
+        starts.push_back(start);
+        cache.flush();
+        uint32_t misses = 0;
+        uint32_t triangles = 0;
+        for (uint32_t triangle = start; triangle < end; triangle++)
+        {
+            for (uint32_t corner = 0; corner < 3; corner++)
+            {
+                misses += cache.access(indices[triangle * 3 + corner]);
+            }
+            triangles++;
+            if (misses <= limit * triangles && triangle + 1 < end)
+            {
+                starts.push_back(triangle + 1);
+                cache.flush();
+                misses = 0;
+                triangles = 0;
+            }
+        }
+        // The rest never reached the limit on its own, so it stays with the part before.
+        if (triangles && misses > limit * triangles && starts.back() != start)
+        {
+            starts.pop_back();
+        }
+    }
+
+    // Area weighted centroids and normals; a cluster far out along its normal is on the outside of the mesh and
+    // likely to hide others, so it is drawn first.
+    float meshCentroid[3] = {0.0f, 0.0f, 0.0f};
+    float meshArea = 0.0f;
+    std::vector<float> clusterCentroids(starts.size() * 3, 0.0f);
+    std::vector<float> clusterNormals(starts.size() * 3, 0.0f);
+    for (size_t cluster = 0; cluster < starts.size(); cluster++)
+    {
+        uint32_t end = cluster + 1 < starts.size() ? starts[cluster + 1] : triangleCount;
+        float clusterArea = 0.0f;
+        for (uint32_t triangle = starts[cluster]; triangle < end; triangle++)
+        {
+            const MeshVertex& v0 = mesh.vertices[indices[triangle * 3]];
+            const MeshVertex& v1 = mesh.vertices[indices[triangle * 3 + 1]];
+            const MeshVertex& v2 = mesh.vertices[indices[triangle * 3 + 2]];
+            float normal[3];
+            getScaledNormal(v0, v1, v2, normal);
+            float area = getLength(normal);
+            for (int axis = 0; axis < 3; axis++)
+            {
+                float center = (v0.position[axis] + v1.position[axis] + v2.position[axis]) / 3.0f;
+                clusterCentroids[cluster * 3 + axis] += center * area;
+                meshCentroid[axis] += center * area;
+                clusterNormals[cluster * 3 + axis] += normal[axis];
+            }
+            clusterArea += area;
+        }
+        for (int axis = 0; axis < 3; axis++)
+        {
+            clusterCentroids[cluster * 3 + axis] /= std::max(clusterArea, 1e-30f);
+        }
+        meshArea += clusterArea;
+    }
+    for (int axis = 0; axis < 3; axis++)
+    {
+        meshCentroid[axis] /= std::max(meshArea, 1e-30f);
+    }
+
+    std::vector<float> sortKeys(starts.size(), 0.0f);
+    for (size_t cluster = 0; cluster < starts.size(); cluster++)
+    {
+        float offset[3];
+        subtract(&clusterCentroids[cluster * 3], meshCentroid, offset);
+        const float* normal = &clusterNormals[cluster * 3];
+        float length = getLength(normal);
+        if (length > 0.0f)
+        {
+            sortKeys[cluster] = (offset[0] * normal[0] + offset[1] * normal[1] + offset[2] * normal[2]) / length;
+        }
+    }
+    std::vector<uint32_t> order(starts.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b)
+    {
+        return sortKeys[a] > sortKeys[b];
+    });
+
+    std::vector<uint32_t> result;
+    result.reserve(indices.size());
+    for (uint32_t cluster : order)
+    {
+        uint32_t end = cluster + 1 < starts.size() ? starts[cluster + 1] : triangleCount;
+        result.insert(result.end(), indices.begin() + starts[cluster] * 3, indices.begin() + end * 3);
+    }
+    return result;
+}
+
+void MeshOptimizer::optimizeVertexFetch(MeshData& mesh)
+{
+    std::vector<uint32_t> remap(mesh.vertices.size(), UINT32_MAX);
+    std::vector<MeshVertex> vertices;
+    vertices.reserve(mesh.vertices.size());
+    for (uint32_t& index : mesh.indices)
+    {
+        if (remap[index] == UINT32_MAX)
+        {
+            remap[index] = (uint32_t)vertices.size();
+            vertices.push_back(mesh.vertices[index]);
+        }
+        index = remap[index];
+    }
+    mesh.vertices = std::move(vertices);
+}
+
+VertexCacheStats MeshOptimizer::analyzeVertexCache(const std::vector<uint32_t>& indices, uint32_t vertexCount,
+                                                   uint32_t cacheSize)
+{
+    VertexCacheStats stats;
+    if (indices.empty())
+    {
+        return stats;
+    }
+    FifoCache cache(vertexCount, cacheSize);
+    std::vector<uint8_t> referenced(vertexCount, 0);
+    uint32_t misses = 0;
+    uint32_t referencedCount = 0;
+    for (uint32_t index : indices)
+    {
+        misses += cache.access(index);
+        referencedCount += referenced[index] ? 0 : 1;
+        referenced[index] = 1;
+    }
+    stats.acmr = (float)misses / (float)(indices.size() / 3);
+    stats.atvr = (float)misses / (float)referencedCount;
+    return stats;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "MeshBuilder.h"
+
+// Reorders an indexed mesh for the GPU without changing what it draws. Triangles are ordered for the post-transform
+// cache with Tipsify (Sander, Nehab and Barczak), then the clusters Tipsify leaves behind are split where the cache
+// allows and sorted outside in, so a mesh tends to occlude itself from any view; vertices are finally renumbered in
+// order of first use so fetching them walks the vertex buffer forward.
+class MeshOptimizer
+{
+public:
+    static const uint32_t CACHE_SIZE = 16;
+
+    // The three passes below, in order, on the whole mesh.
+    static void optimize(MeshData& mesh);
+
+    // Returns the triangles of indices in Tipsify order. pClusters, if set, receives the index of the first triangle
+    // of every run that starts after a dead end, which view-independent overdraw ordering may move as a whole.
+    static std::vector<uint32_t> optimizeVertexCache(const std::vector<uint32_t>& indices, uint32_t vertexCount,
+                                                     std::vector<uint32_t>* pClusters = nullptr);
+    // Returns the triangles of indices, already in vertex cache order, with clusters sorted so the ones farthest out
+    // along their own normal come first. Clusters are first split wherever the cache miss rate of the part before
+    // stays within threshold times that of the whole cluster.
+    static std::vector<uint32_t> optimizeOverdraw(const MeshData& mesh, const std::vector<uint32_t>& indices,
+                                                  const std::vector<uint32_t>& clusters, float threshold);
+    // Renumbers vertices in order of first use and drops the ones no triangle uses.
+    static void optimizeVertexFetch(MeshData& mesh);
+
+    static VertexCacheStats analyzeVertexCache(const std::vector<uint32_t>& indices, uint32_t vertexCount,
+                                               uint32_t cacheSize = CACHE_SIZE);
+};
@@ -0,0 +1,577 @@
+#include "MeshSimplifier.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <functional>
+#include <queue>
+#include <unordered_map>
+#include <utility>
+
+#include "MeshOptimizer.h"
+
+namespace
+{
+    // Open borders keep their shape through planes standing on their edges, weighted this much over the triangles.
+    const double BORDER_WEIGHT = 10.0;
+    // Levels keeping more than this share of the triangles of the level before are dropped.
+    const float MIN_LEVEL_REDUCTION = 0.75f;
+    // A triangle may not turn further than about 75 degrees in one collapse, which also keeps it from folding over
+    // in a few.
+    const double MIN_NORMAL_COSINE = 0.25;
+
+    // The upper triangle of the symmetric 4x4 matrix summing the weighted plane equations, row by row.
+    struct Quadric
+    {
+        double m[10] = {};
+        double weight = 0.0;
+
+        void addPlane(const double* normal, double distance, double planeWeight)
+        {
+            const double plane[4] = {normal[0], normal[1], normal[2], distance};
+            for (int row = 0, k = 0; row < 4; row++)
+            {
+                for (int column = row; column < 4; column++)
+                {
+                    m[k++] += plane[row] * plane[column] * planeWeight;
+                }
+            }
+            weight += planeWeight;
+        }
+
+        void add(const Quadric& other)
+        {
+            for (int k = 0; k < 10; k++)
+            {
+                m[k] += other.m[k];
+            }
+            weight += other.weight;
+        }
+
+        // The weighted sum of squared distances of the point to the planes.
+        double evaluate(const double* point) const
+        {
+            const double v[4] = {point[0], point[1], point[2], 1.0};
+            double result = 0.0;
+            for (int row = 0, k = 0; row < 4; row++)
+            {
+                for (int column = row; column < 4; column++)
+                {
+                    result += (row == column ? 1.0 : 2.0) * m[k++] * v[row] * v[column];
+                }
+            }
+            return result;
+        }
+    };
+
+    struct Collapse
+    {
+        double cost;
+        uint32_t from;
+        uint32_t to;
+        uint32_t fromVersion;
+        uint32_t toVersion;
+
+        bool operator>(const Collapse& other) const
+        {
+            return cost > other.cost;
+        }
+    };
+
+    void subtract(const double* a, const double* b, double* pOutput)
+    {
+        for (int axis = 0; axis < 3; axis++)
+        {
+            pOutput[axis] = a[axis] - b[axis];
+        }
+    }
+
+    void cross(const double* a, const double* b, double* pOutput)
+    {
+        pOutput[0] = a[1] * b[2] - a[2] * b[1];
+        pOutput[1] = a[2] * b[0] - a[0] * b[2];
+        pOutput[2] = a[0] * b[1] - a[1] * b[0];
+    }
+
+    double dot(const double* a, const double* b)
+    {
+        return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+    }
+
+    uint64_t getEdgeKey(uint32_t a, uint32_t b)
+    {
+        return a < b ? (uint64_t)a << 32 | b : (uint64_t)b << 32 | a;
+    }
+
+    // Topology works on welded vertices, one per distinct position; triangle corners keep the mesh vertex, the
+    // wedge, they were drawn with.
+    class EdgeCollapser
+    {
+    public:
+        explicit EdgeCollapser(const MeshData& mesh);
+
+    private:
+        std::vector<uint32_t> weldOf;
+        std::vector<double> positions;
+        std::vector<Quadric> quadrics;
+        std::vector<uint8_t> border;
+        std::vector<uint8_t> locked;
+        std::vector<uint8_t> removed;
+        std::vector<uint32_t> versions;
+        std::vector<std::vector<uint32_t>> vertexTriangles;
+        std::vector<uint32_t> corners;
+        std::vector<uint8_t> triangleAlive;
+        uint32_t liveTriangles = 0;
+        std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>> queue;
+        std::vector<std::pair<uint32_t, uint32_t>> wedgeMap;
+
+    public:
+        std::vector<uint32_t> run(uint32_t targetIndexCount, float maxError, float* pError);
+
+    private:
+        const double* getPosition(uint32_t vertex) const;
+        uint32_t findCorner(uint32_t triangle, uint32_t vertex) const;
+        uint32_t countEdgeTriangles(uint32_t from, uint32_t to) const;
+        void getNeighbors(uint32_t vertex, std::vector<uint32_t>* pNeighbors) const;
+        bool mapWedges(uint32_t from, uint32_t to);
+        bool canCollapse(uint32_t from, uint32_t to);
+        bool getCost(uint32_t from, uint32_t to, double* pCost);
+        void pushEdge(uint32_t a, uint32_t b);
+        void collapse(uint32_t from, uint32_t to);
+    };
+
+    EdgeCollapser::EdgeCollapser(const MeshData& mesh)
+    {
+        uint32_t vertexCount = (uint32_t)mesh.vertices.size();
+        std::vector<uint32_t> order(vertexCount);
+        for (uint32_t i = 0; i < vertexCount; i++)
+        {
+            order[i] = i;
+        }
+        auto lessPosition = [&](uint32_t a, uint32_t b)
+        {
+            return std::lexicographical_compare(mesh.vertices[a].position, mesh.vertices[a].position + 3,
+                                                mesh.vertices[b].position, mesh.vertices[b].position + 3);
+        };
+        std::sort(order.begin(), order.end(), lessPosition);
+        weldOf.resize(vertexCount);
+        for (uint32_t i = 0; i < vertexCount; i++)
+        {
+            if (i == 0 || lessPosition(order[i - 1], order[i]))
+            {
+                for (int axis = 0; axis < 3; axis++)
+                {
+                    positions.push_back(mesh.vertices[order[i]].position[axis]);
+                }
+            }
+            weldOf[order[i]] = (uint32_t)positions.size() / 3 - 1;
+        }
+
+        uint32_t weldedCount = (uint32_t)positions.size() / 3;
+        quadrics.resize(weldedCount);
+        border.assign(weldedCount, 0);
+        locked.assign(weldedCount, 0);
+        removed.assign(weldedCount, 0);
+        versions.assign(weldedCount, 0);
+        vertexTriangles.resize(weldedCount);
+
+        // Triangles that are degenerate once welded cover no area and are dropped.
+        std::unordered_map<uint64_t, uint32_t> edgeTriangles;
+        for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3)
+        {
+            uint32_t welded[3];
+            for (int k = 0; k < 3; k++)
+            {
+                welded[k] = weldOf[mesh.indices[i + k]];
+            }
+            if (welded[0] == welded[1] || welded[1] == welded[2] || welded[2] == welded[0])
+            {
+                continue;
+            }
+            uint32_t triangle = (uint32_t)corners.size() / 3;
+            double edge1[3];
+            double edge2[3];
+            double normal[3];
+            subtract(getPosition(welded[1]), getPosition(welded[0]), edge1);
+            subtract(getPosition(welded[2]), getPosition(welded[0]), edge2);
+            cross(edge1, edge2, normal);
+            double length = sqrt(dot(normal, normal));
+            for (int k = 0; k < 3; k++)
+            {
+                corners.push_back(mesh.indices[i + k]);
+                vertexTriangles[welded[k]].push_back(triangle);
+                edgeTriangles[getEdgeKey(welded[k], welded[(k + 1) % 3])]++;
+                if (length > 0.0)
+                {
+                    double unitNormal[3] = {normal[0] / length, normal[1] / length, normal[2] / length};
+                    quadrics[welded[k]].addPlane(unitNormal, -dot(unitNormal, getPosition(welded[0])),
+                                                 length * 0.5);
+                }
+            }
+        }
+        liveTriangles = (uint32_t)corners.size() / 3;
+        triangleAlive.assign(liveTriangles, 1);
+
+        for (uint32_t triangle = 0; triangle < liveTriangles; triangle++)
+        {
+            for (int k = 0; k < 3; k++)
+            {
+                uint32_t a = weldOf[corners[triangle * 3 + k]];
+                uint32_t b = weldOf[corners[triangle * 3 + (k + 1) % 3]];
+                uint32_t c = weldOf[corners[triangle * 3 + (k + 2) % 3]];
+                uint32_t count = edgeTriangles[getEdgeKey(a, b)];
+                if (count > 2)
+                {
+                    locked[a] = locked[b] = 1;
+                }
+                if (count != 1)
+                {
+                    continue;
+                }
+                border[a] = border[b] = 1;
+                double edge[3];
+                double toThird[3];
+                double normal[3];
+                double side[3];
+                subtract(getPosition(b), getPosition(a), edge);
+                subtract(getPosition(c), getPosition(a), toThird);
+                cross(edge, toThird, normal);
+                cross(edge, normal, side);
+                double length = sqrt(dot(side, side));
+                if (length > 0.0)
+                {
+                    for (int axis = 0; axis < 3; axis++)
+                    {
+                        side[axis] /= length;
+                    }
+                    double planeWeight = BORDER_WEIGHT * dot(edge, edge);
+                    quadrics[a].addPlane(side, -dot(side, getPosition(a)), planeWeight);
+                    quadrics[b].addPlane(side, -dot(side, getPosition(a)), planeWeight);
+                }
+            }
+        }
+        for (const auto& edge : edgeTriangles)
+        {
+            pushEdge((uint32_t)(edge.first >> 32), (uint32_t)edge.first);
+        }
+    }
+
+    std::vector<uint32_t> EdgeCollapser::run(uint32_t targetIndexCount, float maxError, float* pError)
+    {
+        double maxCost = (double)maxError * maxError;
+        double largestCost = 0.0;
+        while ((uint64_t)liveTriangles * 3 > targetIndexCount && !queue.empty())
+        {
+            Collapse candidate = queue.top();
+            queue.pop();
+            if (removed[candidate.from] || removed[candidate.to] || versions[candidate.from] != candidate.fromVersion ||
+                versions[candidate.to] != candidate.toVersion)
+            {
+                continue;
+            }
+            if (candidate.cost > maxCost)
+            {
+                break;
+            }
+            if (!mapWedges(candidate.from, candidate.to) || !canCollapse(candidate.from, candidate.to))
+            {
+                continue;
+            }
+            collapse(candidate.from, candidate.to);
+            largestCost = std::max(largestCost, candidate.cost);
+        }
+        if (pError)
+        {
+            *pError = (float)sqrt(largestCost);
+        }
+
+        std::vector<uint32_t> indices;
+        indices.reserve((size_t)liveTriangles * 3);
+        for (uint32_t triangle = 0; triangle < triangleAlive.size(); triangle++)
+        {
+            if (triangleAlive[triangle])
+            {
+                indices.insert(indices.end(), corners.begin() + triangle * 3, corners.begin() + triangle * 3 + 3);
+            }
+        }
+        return indices;
+    }
+
+    const double* EdgeCollapser::getPosition(uint32_t vertex) const
+    {
+        return positions.data() + (size_t)vertex * 3;
+    }
+
+    uint32_t EdgeCollapser::findCorner(uint32_t triangle, uint32_t vertex) const
+    {
+        for (uint32_t k = 0; k < 3; k++)
+        {
+            if (weldOf[corners[triangle * 3 + k]] == vertex)
+            {
+                return triangle * 3 + k;
+            }
+        }
+        return UINT32_MAX;
+    }
+
+    uint32_t EdgeCollapser::countEdgeTriangles(uint32_t from, uint32_t to) const
+    {
+        uint32_t count = 0;
+        for (uint32_t triangle : vertexTriangles[from])
+        {
+            count += triangleAlive[triangle] && findCorner(triangle, to) != UINT32_MAX;
+        }
+        return count;
+    }
+
+    void EdgeCollapser::getNeighbors(uint32_t vertex, std::vector<uint32_t>* pNeighbors) const
+    {
+        pNeighbors->clear();
+        for (uint32_t triangle : vertexTriangles[vertex])
+        {
+            if (!triangleAlive[triangle])
+            {
+                continue;
+            }
+            for (uint32_t k = 0; k < 3; k++)
+            {
+                uint32_t neighbor = weldOf[corners[triangle * 3 + k]];
+                if (neighbor != vertex)
+                {
+                    pNeighbors->push_back(neighbor);
+                }
+            }
+        }
+        std::sort(pNeighbors->begin(), pNeighbors->end());
+        pNeighbors->erase(std::unique(pNeighbors->begin(), pNeighbors->end()), pNeighbors->end());
+    }
+
+    // Every wedge of from must move to the wedge of to it shares a triangle with along the edge, the same one in
+    // every such triangle. That holds for a plain vertex and for a seam collapsing along the seam, and fails for a
+    // seam crossing the edge, whose wedges would have to pick a side.
+    bool EdgeCollapser::mapWedges(uint32_t from, uint32_t to)
+    {
+        wedgeMap.clear();
+        for (uint32_t triangle : vertexTriangles[from])
+        {
+            uint32_t toCorner = triangleAlive[triangle] ? findCorner(triangle, to) : UINT32_MAX;
+            if (toCorner == UINT32_MAX)
+            {
+                continue;
+            }
+            uint32_t wedge = corners[findCorner(triangle, from)];
+            auto mapped = std::find_if(wedgeMap.begin(), wedgeMap.end(),
+                                       [wedge](const std::pair<uint32_t, uint32_t>& entry)
+                                       {
+                                           return entry.first == wedge;
+                                       });
+            if (mapped == wedgeMap.end())
+            {
+                wedgeMap.push_back(std::make_pair(wedge, corners[toCorner]));
+            }
+            else if (mapped->second != corners[toCorner])
+            {
+                return false;
+            }
+        }
+        for (uint32_t triangle : vertexTriangles[from])
+        {
+            if (!triangleAlive[triangle])
+            {
+                continue;
+            }
+            uint32_t wedge = corners[findCorner(triangle, from)];
+            if (std::none_of(wedgeMap.begin(), wedgeMap.end(),
+                             [wedge](const std::pair<uint32_t, uint32_t>& entry) { return entry.first == wedge; }))
+            {
+                return false;
+            }
+        }
+        return !wedgeMap.empty();
+    }
+
+    // The two ends may only share the neighbors across the triangles of the edge, or the collapse pinches the
+    // surface, and no triangle that stays may turn over.
+    bool EdgeCollapser::canCollapse(uint32_t from, uint32_t to)
+    {
+        std::vector<uint32_t> fromNeighbors;
+        std::vector<uint32_t> toNeighbors;
+        getNeighbors(from, &fromNeighbors);
+        getNeighbors(to, &toNeighbors);
+        std::vector<uint32_t> shared;
+        std::set_intersection(fromNeighbors.begin(), fromNeighbors.end(), toNeighbors.begin(), toNeighbors.end(),
+                              std::back_inserter(shared));
+        if (shared.size() != countEdgeTriangles(from, to))
+        {
+            return false;
+        }
+
+        for (uint32_t triangle : vertexTriangles[from])
+        {
+            if (!triangleAlive[triangle] || findCorner(triangle, to) != UINT32_MAX)
+            {
+                continue;
+            }
+            const double* before[3];
+            const double* after[3];
+            for (uint32_t k = 0; k < 3; k++)
+            {
+                uint32_t vertex = weldOf[corners[triangle * 3 + k]];
+                before[k] = getPosition(vertex);
+                after[k] = vertex == from ? getPosition(to) : before[k];
+            }
+            double edge1[3];
+            double edge2[3];
+            double normalBefore[3];
+            double normalAfter[3];
+            subtract(before[1], before[0], edge1);
+            subtract(before[2], before[0], edge2);
+            cross(edge1, edge2, normalBefore);
+            subtract(after[1], after[0], edge1);
+            subtract(after[2], after[0], edge2);
+            cross(edge1, edge2, normalAfter);
+            double lengths = sqrt(dot(normalBefore, normalBefore) * dot(normalAfter, normalAfter));
+            if (dot(normalBefore, normalAfter) <= MIN_NORMAL_COSINE * lengths || lengths == 0.0)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool EdgeCollapser::getCost(uint32_t from, uint32_t to, double* pCost)
+    {
+        if (locked[from] || (border[from] && countEdgeTriangles(from, to) != 1) || !mapWedges(from, to))
+        {
+            return false;
+        }
+        Quadric quadric = quadrics[from];
+        quadric.add(quadrics[to]);
+        *pCost = quadric.weight > 0.0 ? std::max(quadric.evaluate(getPosition(to)) / quadric.weight, 0.0) : 0.0;
+        return true;
+    }
+
+    // Queues the cheaper direction the edge may collapse in, if any.
+    void EdgeCollapser::pushEdge(uint32_t a, uint32_t b)
+    {
+        double forwardCost = DBL_MAX;
+        double backwardCost = DBL_MAX;
+        bool forward = getCost(a, b, &forwardCost);
+        bool backward = getCost(b, a, &backwardCost);
+        if (!forward && !backward)
+        {
+            return;
+        }
+        uint32_t from = forward && forwardCost <= backwardCost ? a : b;
+        uint32_t to = from == a ? b : a;
+        queue.push({std::min(forwardCost, backwardCost), from, to, versions[from], versions[to]});
+    }
+
+    // Expects wedgeMap to hold the wedges of from.
+    void EdgeCollapser::collapse(uint32_t from, uint32_t to)
+    {
+        for (uint32_t triangle : vertexTriangles[from])
+        {
+            if (!triangleAlive[triangle])
+            {
+                continue;
+            }
+            if (findCorner(triangle, to) != UINT32_MAX)
+            {
+                triangleAlive[triangle] = 0;
+                liveTriangles--;
+                continue;
+            }
+            uint32_t corner = findCorner(triangle, from);
+            for (const std::pair<uint32_t, uint32_t>& entry : wedgeMap)
+            {
+                if (entry.first == corners[corner])
+                {
+                    corners[corner] = entry.second;
+                    break;
+                }
+            }
+            vertexTriangles[to].push_back(triangle);
+        }
+        vertexTriangles[from].clear();
+        std::vector<uint32_t>& toTriangles = vertexTriangles[to];
+        toTriangles.erase(std::remove_if(toTriangles.begin(), toTriangles.end(),
+                                         [this](uint32_t triangle) { return !triangleAlive[triangle]; }),
+                          toTriangles.end());
+        quadrics[to].add(quadrics[from]);
+        border[to] = border[to] || border[from];
+        removed[from] = 1;
+        versions[to]++;
+
+        std::vector<uint32_t> neighbors;
+        getNeighbors(to, &neighbors);
+        for (uint32_t neighbor : neighbors)
+        {
+            pushEdge(to, neighbor);
+        }
+    }
+}
+
+std::vector<uint32_t> MeshSimplifier::simplify(const MeshData& mesh, uint32_t targetIndexCount, float maxError,
+                                               float* pError)
+{
+    EdgeCollapser collapser(mesh);
+    return collapser.run(targetIndexCount, maxError, pError);
+}
+
+std::vector<std::vector<MeshLOD>> MeshSimplifier::buildLODChains(const std::vector<const MeshData*>& meshes,
+                                                                 const MeshLODSettings& settings,
+                                                                 ThreadPool* threadPool)
+{
+    std::vector<std::vector<MeshLOD>> chains(meshes.size());
+    std::vector<std::pair<uint32_t, uint32_t>> tasks;
+    for (uint32_t mesh = 0; mesh < meshes.size(); mesh++)
+    {
+        uint32_t triangleCount = (uint32_t)(meshes[mesh]->indices.size() / 3);
+        uint32_t levelCount = 1;
+        while (levelCount < settings.maxLevels && (triangleCount >> levelCount) >= settings.minTriangles)
+        {
+            tasks.push_back(std::make_pair(mesh, levelCount++));
+        }
+        chains[mesh].resize(levelCount);
+        chains[mesh][0].indices = meshes[mesh]->indices;
+    }
+
+    auto simplifyLevel = [&](uint32_t task)
+    {
+        uint32_t mesh = tasks[task].first;
+        uint32_t level = tasks[task].second;
+        uint32_t targetIndexCount = (uint32_t)(meshes[mesh]->indices.size() / 3 >> level) * 3;
+        MeshLOD& lod = chains[mesh][level];
+        lod.indices = simplify(*meshes[mesh], targetIndexCount, FLT_MAX, &lod.error);
+        lod.indices = MeshOptimizer::optimizeVertexCache(lod.indices, (uint32_t)meshes[mesh]->vertices.size());
+    };
+    if (threadPool)
+    {
+        threadPool->parallelFor((uint32_t)tasks.size(), simplifyLevel);
+    }
+    else
+    {
+        for (uint32_t task = 0; task < tasks.size(); task++)
+        {
+            simplifyLevel(task);
+        }
+    }
+
+    // Coarser levels never claim less error than finer ones, so picking by error stays monotonic.
+    for (std::vector<MeshLOD>& chain : chains)
+    {
+        std::vector<MeshLOD> kept;
+        for (MeshLOD& lod : chain)
+        {
+            if (!kept.empty() && lod.indices.size() >= kept.back().indices.size() * MIN_LEVEL_REDUCTION)
+            {
+                continue;
+            }
+            lod.error = kept.empty() ? lod.error : std::max(lod.error, kept.back().error);
+            kept.push_back(std::move(lod));
+        }
+        chain = std::move(kept);
+    }
+    return chains;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "MeshBuilder.h"
+#include "../../Utils/ThreadPool.h"
+
+// One level of detail: a triangle list over the vertices of the full mesh, and how far its surface may be from the
+// full mesh, in mesh units.
+struct MeshLOD
+{
+    std::vector<uint32_t> indices;
+    float error = 0.0f;
+};
+
+struct MeshLODSettings
+{
+    uint32_t maxLevels = 6;
+    // Levels stop halving the triangle count of the level before at this many triangles.
+    uint32_t minTriangles = 64;
+};
+
+// Quadric error metric simplification (Garland and Heckbert) by half-edge collapse, so the simplified mesh reuses the
+// vertices of the original and every level of a chain shares one vertex buffer. Vertices are welded by position for
+// topology; attribute seams collapse only along themselves, open borders only along the border, and a collapse that
+// would flip a triangle or pinch the surface is skipped. The error is the root mean square distance of the kept
+// vertex to the area weighted planes of the original triangles merged into it.
+class MeshSimplifier
+{
+public:
+    // Collapses the cheapest edges until at most targetIndexCount indices remain or the next collapse would cost more
+    // than maxError. Returns indices into mesh.vertices; pError receives the largest error of the collapses made.
+    static std::vector<uint32_t> simplify(const MeshData& mesh, uint32_t targetIndexCount, float maxError,
+                                          float* pError);
+    // Level 0 is the mesh itself. Level n targets half the triangles of level n - 1 and is simplified from the full
+    // mesh, then ordered for the vertex cache; levels that barely shrink are dropped. Every level of every mesh is a
+    // separate task on the thread pool, which may be null.
+    static std::vector<std::vector<MeshLOD>> buildLODChains(const std::vector<const MeshData*>& meshes,
+                                                            const MeshLODSettings& settings, ThreadPool* threadPool);
+};
@@ -0,0 +1,186 @@
+#include "FrameProfiler.h"
+
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+FrameProfiler::FrameProfiler(ID3D11Device* device, ID3D11DeviceContext* deviceContext)
+    : deviceContext(deviceContext)
+{
+    // Without the annotation interface scopes still time, they just leave no markers for PIX or RenderDoc.
+    if (FAILED(deviceContext->QueryInterface(IID_PPV_ARGS(&annotation))))
+    {
+        annotation = nullptr;
+    }
+
+    D3D11_QUERY_DESC disjointDesc = {D3D11_QUERY_TIMESTAMP_DISJOINT, 0};
+    D3D11_QUERY_DESC timestampDesc = {D3D11_QUERY_TIMESTAMP, 0};
+    for (auto& queryFrame : queryFrames)
+    {
+        // One timestamp opens the frame, then a begin and an end for every scope.
+        queryFrame.timestamps.resize(1 + 2 * MAX_GPU_SCOPES);
+        if (FAILED(device->CreateQuery(&disjointDesc, &queryFrame.disjoint)))
+        {
+            throw std::runtime_error("Failed to create profiler disjoint query");
+        }
+        for (auto& timestamp : queryFrame.timestamps)
+        {
+            if (FAILED(device->CreateQuery(&timestampDesc, &timestamp)))
+            {
+                throw std::runtime_error("Failed to create profiler timestamp query");
+            }
+        }
+    }
+}
+
+FrameProfiler::~FrameProfiler()
+{
+    for (auto& queryFrame : queryFrames)
+    {
+        queryFrame.disjoint->Release();
+        for (auto timestamp : queryFrame.timestamps)
+        {
+            timestamp->Release();
+        }
+    }
+    if (annotation)
+    {
+        annotation->Release();
+    }
+}
+
+void FrameProfiler::beginFrame()
+{
+    collectFrames();
+    ProfilerQueryFrame& queryFrame = queryFrames[currentFrame];
+    if (queryFrame.pending)
+    {
+        // The GPU is more than QUERY_FRAME_COUNT frames behind; keep the CPU spans and give up on its timings.
+        stats.droppedFrames++;
+        aggregator.addFrame(std::move(queryFrame.frame));
+        queryFrame.pending = false;
+    }
+    recorder.beginFrame(frameIndex);
+    deviceContext->Begin(queryFrame.disjoint);
+    deviceContext->End(queryFrame.timestamps[0]);
+    queryFrame.timestampCount = 1;
+}
+
+void FrameProfiler::endFrame()
+{
+    ProfilerQueryFrame& queryFrame = queryFrames[currentFrame];
+    deviceContext->End(queryFrame.disjoint);
+    queryFrame.frame = recorder.endFrame();
+    queryFrame.pending = true;
+    currentFrame = (currentFrame + 1) % QUERY_FRAME_COUNT;
+    frameIndex++;
+}
+
+void FrameProfiler::beginScope(const char* name)
+{
+    if (annotation)
+    {
+        std::wstring wideName(name, name + strlen(name));
+        annotation->BeginEvent(wideName.c_str());
+    }
+    uint32_t sample = recorder.beginScope(name);
+    if (sample < MAX_GPU_SCOPES)
+    {
+        deviceContext->End(queryFrames[currentFrame].timestamps[1 + 2 * sample]);
+    }
+}
+
+void FrameProfiler::endScope()
+{
+    uint32_t sample = recorder.endScope();
+    if (sample < MAX_GPU_SCOPES)
+    {
+        deviceContext->End(queryFrames[currentFrame].timestamps[2 + 2 * sample]);
+    }
+    if (annotation)
+    {
+        annotation->EndEvent();
+    }
+}
+
+const ProfileAggregator& FrameProfiler::getAggregator() const
+{
+    return aggregator;
+}
+
+const FrameProfilerStats& FrameProfiler::getStats() const
+{
+    return stats;
+}
+
+void FrameProfiler::exportChromeTrace(const std::string& path) const
+{
+    std::ofstream file(path);
+    if (!file)
+    {
+        throw std::runtime_error("Failed to open profiler trace " + path);
+    }
+    aggregator.writeChromeTrace(file);
+}
+
+void FrameProfiler::collectFrames()
+{
+    // The slot about to be reused holds the oldest frame. Frames finish in submission order, so collection stops at
+    // the first one that is not ready.
+    for (uint32_t i = 0; i < QUERY_FRAME_COUNT; i++)
+    {
+        ProfilerQueryFrame& queryFrame = queryFrames[(currentFrame + i) % QUERY_FRAME_COUNT];
+        if (!queryFrame.pending)
+        {
+            continue;
+        }
+        if (!readFrame(queryFrame))
+        {
+            return;
+        }
+        aggregator.addFrame(std::move(queryFrame.frame));
+        queryFrame.pending = false;
+        stats.collectedFrames++;
+    }
+}
+
+bool FrameProfiler::readFrame(ProfilerQueryFrame& queryFrame)
+{
+    D3D11_QUERY_DATA_TIMESTAMP_DISJOINT disjointData = {};
+    if (deviceContext->GetData(queryFrame.disjoint, &disjointData, sizeof(disjointData),
+                               D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK)
+    {
+        return false;
+    }
+    if (disjointData.Disjoint)
+    {
+        // The clock changed mid-frame (power state, GPU reset); its timestamps are meaningless.
+        stats.disjointFrames++;
+        return true;
+    }
+
+    UINT64 frameStart = 0;
+    if (deviceContext->GetData(queryFrame.timestamps[0], &frameStart, sizeof(frameStart),
+                               D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK)
+    {
+        return false;
+    }
+    double ticksToMs = 1000.0 / (double)disjointData.Frequency;
+    std::vector<ProfileSample>& samples = queryFrame.frame.samples;
+    for (uint32_t i = 0; i < samples.size() && i < MAX_GPU_SCOPES; i++)
+    {
+        UINT64 begin = 0;
+        UINT64 end = 0;
+        if (deviceContext->GetData(queryFrame.timestamps[1 + 2 * i], &begin, sizeof(begin),
+                                   D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK ||
+            deviceContext->GetData(queryFrame.timestamps[2 + 2 * i], &end, sizeof(end),
+                                   D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK)
+        {
+            return false;
+        }
+        samples[i].hasGpu = true;
+        samples[i].gpuStartMs = (double)(begin - frameStart) * ticksToMs;
+        samples[i].gpuDurationMs = (double)(end - begin) * ticksToMs;
+    }
+    return true;
+}
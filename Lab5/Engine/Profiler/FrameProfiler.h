@@ -0,0 +1,78 @@
+#pragma once
+
+#include <d3d11.h>
+#include <d3d11_1.h>
+#include <string>
+#include <vector>
+
+#include "ProfileTimeline.h"
+
+struct ProfilerQueryFrame
+{
+    ID3D11Query* disjoint = nullptr;
+    std::vector<ID3D11Query*> timestamps;
+    ProfileFrame frame;
+    uint32_t timestampCount = 0;
+    bool pending = false;
+};
+
+struct FrameProfilerStats
+{
+    uint64_t collectedFrames = 0;
+    uint64_t droppedFrames = 0;
+    uint64_t disjointFrames = 0;
+};
+
+// Brackets every scope with a debugger marker, a CPU span and a pair of GPU timestamps. Timestamps are read back
+// QUERY_FRAME_COUNT frames late without ever waiting on the GPU; until they arrive a frame is not aggregated.
+class FrameProfiler
+{
+public:
+    static const uint32_t QUERY_FRAME_COUNT = 4;
+    static const uint32_t MAX_GPU_SCOPES = 64;
+
+    FrameProfiler(ID3D11Device* device, ID3D11DeviceContext* deviceContext);
+    ~FrameProfiler();
+
+    void beginFrame();
+    void endFrame();
+    void beginScope(const char* name);
+    void endScope();
+
+    const ProfileAggregator& getAggregator() const;
+    const FrameProfilerStats& getStats() const;
+    void exportChromeTrace(const std::string& path) const;
+
+private:
+    ID3D11DeviceContext* deviceContext;
+    ID3DUserDefinedAnnotation* annotation = nullptr;
+    CpuFrameRecorder recorder;
+    ProfileAggregator aggregator;
+    ProfilerQueryFrame queryFrames[QUERY_FRAME_COUNT];
+    uint32_t currentFrame = 0;
+    uint64_t frameIndex = 0;
+    FrameProfilerStats stats;
+
+    void collectFrames();
+    bool readFrame(ProfilerQueryFrame& queryFrame);
+};
+
+class ProfileScope
+{
+public:
+    ProfileScope(FrameProfiler* profiler, const char* name) : profiler(profiler)
+    {
+        profiler->beginScope(name);
+    }
+
+    ~ProfileScope()
+    {
+        profiler->endScope();
+    }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    FrameProfiler* profiler;
+};
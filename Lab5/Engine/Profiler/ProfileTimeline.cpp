@@ -0,0 +1,219 @@
+#include "ProfileTimeline.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <stdexcept>
+
+namespace
+{
+    const uint32_t CPU_THREAD_ID = 1;
+    const uint32_t GPU_THREAD_ID = 2;
+}
+
+CpuFrameRecorder::CpuFrameRecorder() : epoch(std::chrono::steady_clock::now())
+{
+}
+
+void CpuFrameRecorder::beginFrame(uint64_t frameIndex)
+{
+    if (inFrame)
+    {
+        throw std::runtime_error("Profiler frame begun twice");
+    }
+    frame = ProfileFrame();
+    frame.index = frameIndex;
+    frame.cpuStartMs = getTimeMs();
+    inFrame = true;
+}
+
+uint32_t CpuFrameRecorder::beginScope(const std::string& name)
+{
+    if (!inFrame)
+    {
+        throw std::runtime_error("Profiler scope " + name + " begun outside a frame");
+    }
+    ProfileSample sample;
+    sample.name = name;
+    sample.depth = (uint32_t)openScopes.size();
+    sample.cpuStartMs = getTimeMs();
+    frame.samples.push_back(sample);
+    openScopes.push_back((uint32_t)frame.samples.size() - 1);
+    return openScopes.back();
+}
+
+uint32_t CpuFrameRecorder::endScope()
+{
+    if (openScopes.empty())
+    {
+        throw std::runtime_error("Profiler scope ended without a matching begin");
+    }
+    uint32_t sample = openScopes.back();
+    openScopes.pop_back();
+    frame.samples[sample].cpuDurationMs = getTimeMs() - frame.samples[sample].cpuStartMs;
+    return sample;
+}
+
+ProfileFrame CpuFrameRecorder::endFrame()
+{
+    if (!inFrame || !openScopes.empty())
+    {
+        throw std::runtime_error("Profiler frame ended with unbalanced scopes");
+    }
+    frame.cpuDurationMs = getTimeMs() - frame.cpuStartMs;
+    inFrame = false;
+    return std::move(frame);
+}
+
+double CpuFrameRecorder::getTimeMs() const
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+ProfileAggregator::ProfileAggregator(uint32_t historySize) : historySize(historySize)
+{
+}
+
+void ProfileAggregator::addFrame(ProfileFrame frame)
+{
+    frames.push_back(std::move(frame));
+    while (frames.size() > historySize)
+    {
+        frames.pop_front();
+    }
+}
+
+std::vector<ProfilePassStats> ProfileAggregator::getPassStats() const
+{
+    // Passes are listed in the order of the newest frame; a pass missing from some frames averages over the frames
+    // that ran it.
+    std::vector<ProfilePassStats> stats;
+    std::vector<uint32_t> cpuCounts;
+    std::vector<uint32_t> gpuCounts;
+    if (frames.empty())
+    {
+        return stats;
+    }
+    for (const ProfileSample& sample : frames.back().samples)
+    {
+        auto existing = std::find_if(stats.begin(), stats.end(), [&](const ProfilePassStats& pass)
+        {
+            return pass.name == sample.name && pass.depth == sample.depth;
+        });
+        if (existing == stats.end())
+        {
+            ProfilePassStats pass;
+            pass.name = sample.name;
+            pass.depth = sample.depth;
+            stats.push_back(pass);
+        }
+    }
+    cpuCounts.resize(stats.size());
+    gpuCounts.resize(stats.size());
+    for (const ProfileFrame& frame : frames)
+    {
+        for (const ProfileSample& sample : frame.samples)
+        {
+            for (size_t i = 0; i < stats.size(); i++)
+            {
+                ProfilePassStats& pass = stats[i];
+                if (pass.name != sample.name || pass.depth != sample.depth)
+                {
+                    continue;
+                }
+                pass.cpuAverageMs += sample.cpuDurationMs;
+                pass.cpuMaxMs = std::max(pass.cpuMaxMs, sample.cpuDurationMs);
+                cpuCounts[i]++;
+                if (sample.hasGpu)
+                {
+                    pass.gpuAverageMs += sample.gpuDurationMs;
+                    pass.gpuMaxMs = std::max(pass.gpuMaxMs, sample.gpuDurationMs);
+                    pass.hasGpu = true;
+                    gpuCounts[i]++;
+                }
+                break;
+            }
+        }
+    }
+    for (size_t i = 0; i < stats.size(); i++)
+    {
+        stats[i].cpuAverageMs /= cpuCounts[i];
+        if (gpuCounts[i])
+        {
+            stats[i].gpuAverageMs /= gpuCounts[i];
+        }
+    }
+    return stats;
+}
+
+const std::deque<ProfileFrame>& ProfileAggregator::getFrames() const
+{
+    return frames;
+}
+
+void ProfileAggregator::writeChromeTrace(std::ostream& out) const
+{
+    // GPU events go on their own track. The two clocks are unrelated, so each frame's first GPU timestamp is
+    // placed at the CPU start of the same frame.
+    out << "{\"traceEvents\":[";
+    out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << CPU_THREAD_ID
+        << ",\"args\":{\"name\":\"CPU\"}},";
+    out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << GPU_THREAD_ID
+        << ",\"args\":{\"name\":\"GPU\"}}";
+    for (const ProfileFrame& frame : frames)
+    {
+        writeEvent(out, "Frame " + std::to_string(frame.index), "frame", CPU_THREAD_ID, frame.cpuStartMs,
+                   frame.cpuDurationMs, frame.index);
+        for (const ProfileSample& sample : frame.samples)
+        {
+            writeEvent(out, sample.name, "cpu", CPU_THREAD_ID, sample.cpuStartMs, sample.cpuDurationMs, frame.index);
+            if (sample.hasGpu)
+            {
+                writeEvent(out, sample.name, "gpu", GPU_THREAD_ID, frame.cpuStartMs + sample.gpuStartMs,
+                           sample.gpuDurationMs, frame.index);
+            }
+        }
+    }
+    out << "],\"displayTimeUnit\":\"ms\"}" << std::endl;
+}
+
+void ProfileAggregator::writeEvent(std::ostream& out, const std::string& name, const char* category,
+                                   uint32_t threadId, double startMs, double durationMs, uint64_t frameIndex)
+{
+    char times[64];
+    snprintf(times, sizeof(times), "\"ts\":%.3f,\"dur\":%.3f", startMs * 1000.0, durationMs * 1000.0);
+    out << ",{\"name\":\"" << escapeJson(name) << "\",\"cat\":\"" << category
+        << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << threadId << "," << times << ",\"args\":{\"frame\":" << frameIndex
+        << "}}";
+}
+
+std::string ProfileAggregator::escapeJson(const std::string& text)
+{
+    std::string escaped;
+    for (char character : text)
+    {
+        switch (character)
+        {
+        case '"':
+            escaped += "\\\"";
+            break;
+        case '\\':
+            escaped += "\\\\";
+            break;
+        case '\n':
+            escaped += "\\n";
+            break;
+        default:
+            if ((unsigned char)character < 0x20)
+            {
+                char code[8];
+                snprintf(code, sizeof(code), "\\u%04x", character);
+                escaped += code;
+            }
+            else
+            {
+                escaped += character;
+            }
+        }
+    }
+    return escaped;
+}
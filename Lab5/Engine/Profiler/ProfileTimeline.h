@@ -0,0 +1,78 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <ostream>
+#include <string>
+#include <vector>
+
+struct ProfileSample
+{
+    std::string name;
+    uint32_t depth = 0;
+    // CPU times are relative to the recorder's creation, GPU times to the frame's first timestamp.
+    double cpuStartMs = 0;
+    double cpuDurationMs = 0;
+    bool hasGpu = false;
+    double gpuStartMs = 0;
+    double gpuDurationMs = 0;
+};
+
+struct ProfileFrame
+{
+    uint64_t index = 0;
+    double cpuStartMs = 0;
+    double cpuDurationMs = 0;
+    std::vector<ProfileSample> samples;
+};
+
+struct ProfilePassStats
+{
+    std::string name;
+    uint32_t depth = 0;
+    double cpuAverageMs = 0;
+    double cpuMaxMs = 0;
+    double gpuAverageMs = 0;
+    double gpuMaxMs = 0;
+    bool hasGpu = false;
+};
+
+// Records the nested CPU spans of one frame. Samples are stored in the order their scopes begin.
+class CpuFrameRecorder
+{
+public:
+    CpuFrameRecorder();
+
+    void beginFrame(uint64_t frameIndex);
+    uint32_t beginScope(const std::string& name);
+    uint32_t endScope();
+    ProfileFrame endFrame();
+    double getTimeMs() const;
+
+private:
+    std::chrono::steady_clock::time_point epoch;
+    ProfileFrame frame;
+    std::vector<uint32_t> openScopes;
+    bool inFrame = false;
+};
+
+// Keeps the last frames whose results have arrived, averages them per pass and exports them as a Chrome trace.
+class ProfileAggregator
+{
+public:
+    explicit ProfileAggregator(uint32_t historySize = 120);
+
+    void addFrame(ProfileFrame frame);
+    std::vector<ProfilePassStats> getPassStats() const;
+    const std::deque<ProfileFrame>& getFrames() const;
+    void writeChromeTrace(std::ostream& out) const;
+
+private:
+    uint32_t historySize;
+    std::deque<ProfileFrame> frames;
+
+    static void writeEvent(std::ostream& out, const std::string& name, const char* category, uint32_t threadId,
+                           double startMs, double durationMs, uint64_t frameIndex);
+    static std::string escapeJson(const std::string& text);
+};
@@ -0,0 +1,968 @@
+#include "D3D11RenderDevice.h"
+
+#include <cfloat>
+#include <cstring>
+#include <stdexcept>
+
+#include "../../Utils/MemoryAccounting.h"
+
+namespace
+{
+    const uint32_t MAX_BOUND_RESOURCES = 8;
+
+    DXGI_FORMAT toDxgiFormat(RenderFormat format)
+    {
+        switch (format)
+        {
+        case RENDER_FORMAT_R8G8B8A8_UNORM:
+            return DXGI_FORMAT_R8G8B8A8_UNORM;
+        case RENDER_FORMAT_R16G16_FLOAT:
+            return DXGI_FORMAT_R16G16_FLOAT;
+        case RENDER_FORMAT_R16G16B16A16_FLOAT:
+            return DXGI_FORMAT_R16G16B16A16_FLOAT;
+        case RENDER_FORMAT_R32_FLOAT:
+            return DXGI_FORMAT_R32_FLOAT;
+        case RENDER_FORMAT_R32G32_FLOAT:
+            return DXGI_FORMAT_R32G32_FLOAT;
+        case RENDER_FORMAT_R32G32B32_FLOAT:
+            return DXGI_FORMAT_R32G32B32_FLOAT;
+        case RENDER_FORMAT_R32G32B32A32_FLOAT:
+            return DXGI_FORMAT_R32G32B32A32_FLOAT;
+        case RENDER_FORMAT_R9G9B9E5_SHAREDEXP:
+            return DXGI_FORMAT_R9G9B9E5_SHAREDEXP;
+        case RENDER_FORMAT_BC6H_UF16:
+            return DXGI_FORMAT_BC6H_UF16;
+        case RENDER_FORMAT_D24_UNORM_S8_UINT:
+            return DXGI_FORMAT_D24_UNORM_S8_UINT;
+        case RENDER_FORMAT_R16G16_SNORM:
+            return DXGI_FORMAT_R16G16_SNORM;
+        case RENDER_FORMAT_R16G16B16A16_SNORM:
+            return DXGI_FORMAT_R16G16B16A16_SNORM;
+        default:
+            throw std::runtime_error("Failed to convert render format");
+        }
+    }
+
+    RenderFormat toRenderFormat(DXGI_FORMAT format)
+    {
+        switch (format)
+        {
+        case DXGI_FORMAT_R8G8B8A8_UNORM:
+            return RENDER_FORMAT_R8G8B8A8_UNORM;
+        case DXGI_FORMAT_R16G16B16A16_FLOAT:
+            return RENDER_FORMAT_R16G16B16A16_FLOAT;
+        case DXGI_FORMAT_R32G32B32A32_FLOAT:
+            return RENDER_FORMAT_R32G32B32A32_FLOAT;
+        case DXGI_FORMAT_D24_UNORM_S8_UINT:
+            return RENDER_FORMAT_D24_UNORM_S8_UINT;
+        default:
+            return RENDER_FORMAT_UNKNOWN;
+        }
+    }
+
+    UINT toBindFlags(uint32_t bindFlags)
+    {
+        UINT result = 0;
+        result |= bindFlags & RENDER_BIND_SHADER_RESOURCE ? D3D11_BIND_SHADER_RESOURCE : 0;
+        result |= bindFlags & RENDER_BIND_RENDER_TARGET ? D3D11_BIND_RENDER_TARGET : 0;
+        result |= bindFlags & RENDER_BIND_UNORDERED_ACCESS ? D3D11_BIND_UNORDERED_ACCESS : 0;
+        result |= bindFlags & RENDER_BIND_DEPTH_STENCIL ? D3D11_BIND_DEPTH_STENCIL : 0;
+        return result;
+    }
+
+    const char* getProfile(RenderShaderStage stage)
+    {
+        switch (stage)
+        {
+        case RENDER_STAGE_VERTEX:
+            return "vs_5_0";
+        case RENDER_STAGE_PIXEL:
+            return "ps_5_0";
+        default:
+            return "cs_5_0";
+        }
+    }
+
+    template <typename Child>
+    void setDebugName(Child* child, const std::string& name)
+    {
+#if defined(_DEBUG)
+        child->SetPrivateData(WKPDID_D3DDebugObjectName, (UINT)name.size(), name.c_str());
+#endif
+    }
+
+    std::string makeName(const char* name, const char* fallback, uint32_t handle)
+    {
+        return name ? std::string(name) : std::string(fallback) + " #" + std::to_string(handle);
+    }
+}
+
+D3D11RenderDevice::D3D11RenderDevice(ID3D11Device* device, ID3D11DeviceContext* deviceContext,
+                                     DXStateCache* stateCache, ConstantRing* constantRing)
+    : device(device),
+      deviceContext(deviceContext),
+      stateCache(stateCache),
+      constantRing(constantRing),
+      shaderLoader(&shaderThreadPool)
+{
+    createStates();
+}
+
+D3D11RenderDevice::~D3D11RenderDevice()
+{
+    textures.forEach([this](uint32_t, TextureEntry& entry)
+    {
+        if (!entry.external)
+        {
+            MemoryAccounting::release(entry.memoryCategory, entry.bytes);
+        }
+        releaseTexture(entry);
+    });
+    buffers.forEach([this](uint32_t, BufferEntry& entry)
+    {
+        MemoryAccounting::release(entry.memoryCategory, entry.bytes);
+        releaseBuffer(entry);
+    });
+    shaders.forEach([this](uint32_t, ShaderEntry& entry) { releaseShader(entry); });
+    samplers.forEach([](uint32_t, ID3D11SamplerState*& sampler) { sampler->Release(); });
+    readbacks.forEach([](uint32_t, ReadbackEntry& entry)
+    {
+        entry.texture->Release();
+        entry.query->Release();
+    });
+    lessEqualDepthState->Release();
+    noCullRasterState->Release();
+}
+
+RenderTexture D3D11RenderDevice::createTexture(const RenderTextureDesc& desc, const void* const* initialData)
+{
+    D3D11_TEXTURE2D_DESC textureDesc = {};
+    textureDesc.Width = desc.width;
+    textureDesc.Height = desc.height;
+    textureDesc.MipLevels = desc.mipLevels;
+    textureDesc.ArraySize = desc.arraySize;
+    textureDesc.Format = toDxgiFormat(desc.format);
+    textureDesc.SampleDesc.Count = 1;
+    // Textures that are only ever sampled never change after the upload.
+    bool immutable = initialData && desc.bindFlags == RENDER_BIND_SHADER_RESOURCE;
+    textureDesc.Usage = immutable ? D3D11_USAGE_IMMUTABLE : D3D11_USAGE_DEFAULT;
+    textureDesc.BindFlags = toBindFlags(desc.bindFlags);
+    textureDesc.MiscFlags = desc.cube ? D3D11_RESOURCE_MISC_TEXTURECUBE : 0;
+
+    std::vector<D3D11_SUBRESOURCE_DATA> subresources;
+    if (initialData)
+    {
+        subresources.resize(desc.mipLevels * desc.arraySize);
+        for (uint32_t slice = 0; slice < desc.arraySize; slice++)
+        {
+            for (uint32_t mip = 0; mip < desc.mipLevels; mip++)
+            {
+                uint32_t index = D3D11CalcSubresource(mip, slice, desc.mipLevels);
+                subresources[index].pSysMem = initialData[index];
+                subresources[index].SysMemPitch = getRowPitch(desc.format, getMipSize(desc.width, mip));
+            }
+        }
+    }
+
+    TextureEntry entry;
+    entry.desc = desc;
+    entry.memoryCategory = desc.memoryCategory;
+    if (FAILED(device->CreateTexture2D(&textureDesc, initialData ? subresources.data() : nullptr, &entry.texture)))
+    {
+        throw std::runtime_error("Failed to create texture");
+    }
+    entry.bytes = getTextureBytes(desc);
+    entry.renderTargetViews.resize(desc.bindFlags & RENDER_BIND_RENDER_TARGET ? desc.mipLevels * desc.arraySize : 0);
+    entry.depthStencilViews.resize(desc.bindFlags & RENDER_BIND_DEPTH_STENCIL ? desc.mipLevels * desc.arraySize : 0);
+    RenderTexture handle = textures.insert(entry);
+    TextureEntry& inserted = textures.get(handle);
+    inserted.name = makeName(desc.name, "Texture", handle);
+    inserted.desc.name = nullptr;
+    inserted.desc.memoryCategory = nullptr;
+    setDebugName(inserted.texture, inserted.name);
+    MemoryAccounting::allocate(inserted.memoryCategory, inserted.bytes);
+    return handle;
+}
+
+RenderTexture D3D11RenderDevice::registerTexture(ID3D11Texture2D* texture, const char* name)
+{
+    D3D11_TEXTURE2D_DESC textureDesc = {};
+    texture->GetDesc(&textureDesc);
+
+    TextureEntry entry;
+    entry.desc = describeTexture(textureDesc);
+    entry.texture = texture;
+    entry.texture->AddRef();
+    entry.external = true;
+    entry.renderTargetViews.resize(textureDesc.MipLevels * textureDesc.ArraySize);
+    RenderTexture handle = textures.insert(entry);
+    textures.get(handle).name = makeName(name, "Texture", handle);
+    return handle;
+}
+
+RenderTextureDesc D3D11RenderDevice::describeTexture(const D3D11_TEXTURE2D_DESC& desc)
+{
+    RenderTextureDesc result;
+    result.width = desc.Width;
+    result.height = desc.Height;
+    result.mipLevels = desc.MipLevels;
+    result.arraySize = desc.ArraySize;
+    result.format = toRenderFormat(desc.Format);
+    result.bindFlags = desc.BindFlags & D3D11_BIND_RENDER_TARGET ? RENDER_BIND_RENDER_TARGET : 0;
+    result.name = nullptr;
+    result.memoryCategory = nullptr;
+    return result;
+}
+
+void D3D11RenderDevice::unregisterTexture(RenderTexture texture)
+{
+    if (!textures.get(texture).external)
+    {
+        throw std::runtime_error("Failed to unregister texture: the texture is owned by the device");
+    }
+    TextureEntry entry = textures.remove(texture);
+    releaseTexture(entry);
+}
+
+RenderBuffer D3D11RenderDevice::createBuffer(const RenderBufferDesc& desc, const void* initialData)
+{
+    BufferEntry entry;
+    entry.desc = desc;
+    entry.memoryCategory = desc.memoryCategory;
+    if (desc.type == RENDER_BUFFER_CONSTANT)
+    {
+        // Constants live in the ring, which accounts for its own memory.
+        std::vector<uint8_t> data(desc.size);
+        if (initialData)
+        {
+            memcpy(data.data(), initialData, desc.size);
+        }
+        entry.constants = new ConstantBuffer(constantRing, data.data(), desc.size, desc.name);
+    }
+    else
+    {
+        D3D11_BUFFER_DESC bufferDesc = {};
+        bufferDesc.ByteWidth = desc.size;
+        bufferDesc.Usage = D3D11_USAGE_DEFAULT;
+        switch (desc.type)
+        {
+        case RENDER_BUFFER_VERTEX:
+            bufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+            break;
+        case RENDER_BUFFER_INDEX:
+            bufferDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
+            break;
+        case RENDER_BUFFER_INSTANCE:
+            // Rewritten with WRITE_DISCARD whenever the instance list changes.
+            bufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+            bufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+            bufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+            break;
+        default:
+            bufferDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_UNORDERED_ACCESS;
+            bufferDesc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
+            bufferDesc.StructureByteStride = desc.stride;
+            break;
+        }
+        D3D11_SUBRESOURCE_DATA data = {};
+        data.pSysMem = initialData;
+        if (FAILED(device->CreateBuffer(&bufferDesc, initialData ? &data : nullptr, &entry.buffer)))
+        {
+            throw std::runtime_error("Failed to create buffer");
+        }
+        entry.bytes = desc.size;
+    }
+
+    if (desc.type == RENDER_BUFFER_STRUCTURED)
+    {
+        D3D11_SHADER_RESOURCE_VIEW_DESC descSRV = {};
+        descSRV.Format = DXGI_FORMAT_UNKNOWN;
+        descSRV.ViewDimension = D3D11_SRV_DIMENSION_BUFFER;
+        descSRV.Buffer.NumElements = desc.size / desc.stride;
+
+        D3D11_UNORDERED_ACCESS_VIEW_DESC descUAV = {};
+        descUAV.Format = DXGI_FORMAT_UNKNOWN;
+        descUAV.ViewDimension = D3D11_UAV_DIMENSION_BUFFER;
+        descUAV.Buffer.NumElements = desc.size / desc.stride;
+        if (FAILED(device->CreateShaderResourceView(entry.buffer, &descSRV, &entry.shaderResourceView)) ||
+            FAILED(device->CreateUnorderedAccessView(entry.buffer, &descUAV, &entry.unorderedAccessView)))
+        {
+            releaseBuffer(entry);
+            throw std::runtime_error("Failed to create structured buffer views");
+        }
+    }
+
+    RenderBuffer handle = buffers.insert(entry);
+    BufferEntry& inserted = buffers.get(handle);
+    inserted.name = makeName(desc.name, "Buffer", handle);
+    inserted.desc.name = nullptr;
+    inserted.desc.memoryCategory = nullptr;
+    if (inserted.buffer)
+    {
+        setDebugName(inserted.buffer, inserted.name);
+    }
+    MemoryAccounting::allocate(inserted.memoryCategory, inserted.bytes);
+    return handle;
+}
+
+void D3D11RenderDevice::requestShader(const RenderShaderDesc& desc)
+{
+    shaderLoader.request(desc.path, getProfile(desc.stage));
+}
+
+RenderShader D3D11RenderDevice::createShader(const RenderShaderDesc& desc)
+{
+    // Borrowed from the loader, which compiles on demand when nothing requested it earlier.
+    ID3DBlob* bytecode = shaderLoader.getBytecode(desc.path, getProfile(desc.stage));
+    ShaderEntry entry;
+    entry.stage = desc.stage;
+    HRESULT result = E_FAIL;
+    switch (desc.stage)
+    {
+    case RENDER_STAGE_VERTEX:
+        result = device->CreateVertexShader(bytecode->GetBufferPointer(), bytecode->GetBufferSize(), nullptr,
+                                            &entry.vertexShader);
+        break;
+    case RENDER_STAGE_PIXEL:
+        result = device->CreatePixelShader(bytecode->GetBufferPointer(), bytecode->GetBufferSize(), nullptr,
+                                           &entry.pixelShader);
+        break;
+    case RENDER_STAGE_COMPUTE:
+        result = device->CreateComputeShader(bytecode->GetBufferPointer(), bytecode->GetBufferSize(), nullptr,
+                                             &entry.computeShader);
+        break;
+    }
+    if (FAILED(result))
+    {
+        throw std::runtime_error(std::string("Failed to create shader ") + (desc.name ? desc.name : ""));
+    }
+
+    if (desc.attributeCount)
+    {
+        std::vector<D3D11_INPUT_ELEMENT_DESC> inputs(desc.attributeCount);
+        for (uint32_t i = 0; i < desc.attributeCount; i++)
+        {
+            const RenderVertexAttribute& attribute = desc.attributes[i];
+            inputs[i].SemanticName = attribute.semantic;
+            inputs[i].SemanticIndex = attribute.semanticIndex;
+            inputs[i].Format = toDxgiFormat(attribute.format);
+            inputs[i].InputSlot = attribute.slot;
+            inputs[i].AlignedByteOffset = D3D11_APPEND_ALIGNED_ELEMENT;
+            inputs[i].InputSlotClass = attribute.perInstance
+                                           ? D3D11_INPUT_PER_INSTANCE_DATA
+                                           : D3D11_INPUT_PER_VERTEX_DATA;
+            inputs[i].InstanceDataStepRate = attribute.perInstance ? 1 : 0;
+        }
+        if (FAILED(device->CreateInputLayout(inputs.data(), desc.attributeCount, bytecode->GetBufferPointer(),
+            bytecode->GetBufferSize(), &entry.inputLayout)))
+        {
+            releaseShader(entry);
+            throw std::runtime_error("Failed to create input layout");
+        }
+    }
+    return shaders.insert(entry);
+}
+
+RenderSampler D3D11RenderDevice::createSampler(RenderFilter filter, RenderAddressMode addressMode)
+{
+    D3D11_SAMPLER_DESC desc = {};
+    switch (filter)
+    {
+    case RENDER_FILTER_ANISOTROPIC:
+        desc.Filter = D3D11_FILTER_ANISOTROPIC;
+        break;
+    case RENDER_FILTER_MINIMUM:
+        desc.Filter = D3D11_FILTER_MINIMUM_MIN_MAG_MIP_LINEAR;
+        break;
+    case RENDER_FILTER_MAXIMUM:
+        desc.Filter = D3D11_FILTER_MAXIMUM_MIN_MAG_MIP_LINEAR;
+        break;
+    default:
+        desc.Filter = D3D11_FILTER_MIN_MAG_MIP_LINEAR;
+        break;
+    }
+    D3D11_TEXTURE_ADDRESS_MODE address = addressMode == RENDER_ADDRESS_CLAMP
+                                             ? D3D11_TEXTURE_ADDRESS_CLAMP
+                                             : D3D11_TEXTURE_ADDRESS_WRAP;
+    desc.AddressU = address;
+    desc.AddressV = address;
+    desc.AddressW = address;
+    desc.MinLOD = -FLT_MAX;
+    desc.MaxLOD = FLT_MAX;
+    desc.MipLODBias = 0.0f;
+    desc.MaxAnisotropy = 16;
+    desc.ComparisonFunc = D3D11_COMPARISON_NEVER;
+    desc.BorderColor[0] = desc.BorderColor[1] = desc.BorderColor[2] = desc.BorderColor[3] = 1.0f;
+
+    ID3D11SamplerState* sampler = nullptr;
+    if (FAILED(device->CreateSamplerState(&desc, &sampler)))
+    {
+        throw std::runtime_error("Failed to create sampler");
+    }
+    return samplers.insert(sampler);
+}
+
+RenderReadback D3D11RenderDevice::createReadback(const RenderTextureDesc& desc)
+{
+    D3D11_TEXTURE2D_DESC textureDesc = {};
+    textureDesc.Width = desc.width;
+    textureDesc.Height = desc.height;
+    textureDesc.MipLevels = 1;
+    textureDesc.ArraySize = 1;
+    textureDesc.Format = toDxgiFormat(desc.format);
+    textureDesc.SampleDesc.Count = 1;
+    textureDesc.Usage = D3D11_USAGE_STAGING;
+    textureDesc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+
+    D3D11_QUERY_DESC queryDesc = {};
+    queryDesc.Query = D3D11_QUERY_EVENT;
+
+    ReadbackEntry entry;
+    if (FAILED(device->CreateTexture2D(&textureDesc, nullptr, &entry.texture)) ||
+        FAILED(device->CreateQuery(&queryDesc, &entry.query)))
+    {
+        throw std::runtime_error("Failed to create readback");
+    }
+    return readbacks.insert(entry);
+}
+
+void D3D11RenderDevice::destroyTexture(RenderTexture texture)
+{
+    if (textures.get(texture).external)
+    {
+        throw std::runtime_error("Failed to destroy texture: registered textures are unregistered instead");
+    }
+    TextureEntry entry = textures.remove(texture);
+    MemoryAccounting::release(entry.memoryCategory, entry.bytes);
+    releaseTexture(entry);
+}
+
+void D3D11RenderDevice::destroyBuffer(RenderBuffer buffer)
+{
+    BufferEntry entry = buffers.remove(buffer);
+    MemoryAccounting::release(entry.memoryCategory, entry.bytes);
+    releaseBuffer(entry);
+}
+
+void D3D11RenderDevice::destroyShader(RenderShader shader)
+{
+    ShaderEntry entry = shaders.remove(shader);
+    releaseShader(entry);
+}
+
+void D3D11RenderDevice::destroySampler(RenderSampler sampler)
+{
+    samplers.remove(sampler)->Release();
+}
+
+void D3D11RenderDevice::destroyReadback(RenderReadback readback)
+{
+    ReadbackEntry entry = readbacks.remove(readback);
+    entry.texture->Release();
+    entry.query->Release();
+}
+
+void D3D11RenderDevice::beginFrame()
+{
+    if (profiler)
+    {
+        profiler->beginFrame();
+    }
+    constantRing->beginFrame();
+    stateCache->beginFrame();
+}
+
+void D3D11RenderDevice::endFrame()
+{
+    if (profiler)
+    {
+        profiler->endFrame();
+    }
+}
+
+void D3D11RenderDevice::beginScope(const char* name)
+{
+    if (profiler)
+    {
+        profiler->beginScope(name);
+    }
+}
+
+void D3D11RenderDevice::endScope()
+{
+    if (profiler)
+    {
+        profiler->endScope();
+    }
+}
+
+void D3D11RenderDevice::beginPass(const RenderPassDesc& desc)
+{
+    ID3D11RenderTargetView* renderTargetViews[RenderPassDesc::MAX_COLOR_ATTACHMENTS] = {};
+    for (uint32_t i = 0; i < desc.colorCount; i++)
+    {
+        renderTargetViews[i] = getRenderTargetView(textures.get(desc.colors[i].texture), desc.colors[i]);
+        if (desc.clearColor)
+        {
+            deviceContext->ClearRenderTargetView(renderTargetViews[i], desc.clearValue);
+        }
+    }
+    ID3D11DepthStencilView* depthStencilView = nullptr;
+    if (desc.depth.texture)
+    {
+        depthStencilView = getDepthStencilView(textures.get(desc.depth.texture), desc.depth);
+        if (desc.clearDepth)
+        {
+            deviceContext->ClearDepthStencilView(depthStencilView, D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, 1.0f, 0);
+        }
+    }
+    // Whatever a previous pass wrote may be read here, so sampled textures from earlier passes are dropped first.
+    ID3D11ShaderResourceView* nullViews[MAX_BOUND_RESOURCES] = {};
+    deviceContext->PSSetShaderResources(0, MAX_BOUND_RESOURCES, nullViews);
+    deviceContext->OMSetRenderTargets(desc.colorCount, renderTargetViews, depthStencilView);
+    boundColorCount = desc.colorCount;
+
+    const RenderAttachment& first = desc.colorCount ? desc.colors[0] : desc.depth;
+    const RenderTextureDesc& firstDesc = textures.get(first.texture).desc;
+    D3D11_VIEWPORT viewport = {};
+    viewport.Width = (float)getMipSize(firstDesc.width, first.mip);
+    viewport.Height = (float)getMipSize(firstDesc.height, first.mip);
+    viewport.MinDepth = 0.0f;
+    viewport.MaxDepth = 1.0f;
+    deviceContext->RSSetViewports(1, &viewport);
+}
+
+void D3D11RenderDevice::endPass()
+{
+    ID3D11RenderTargetView* nullTargets[RenderPassDesc::MAX_COLOR_ATTACHMENTS] = {};
+    deviceContext->OMSetRenderTargets(boundColorCount, nullTargets, nullptr);
+    boundColorCount = 0;
+}
+
+void D3D11RenderDevice::setPipeline(const RenderPipelineDesc& desc)
+{
+    ShaderEntry& vertexShader = shaders.get(desc.vertexShader);
+    stateCache->setVertexShader(vertexShader.vertexShader);
+    stateCache->setPixelShader(shaders.get(desc.pixelShader).pixelShader);
+    stateCache->setInputLayout(vertexShader.inputLayout);
+    stateCache->setPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    stateCache->setDepthStencilState(desc.depthMode == RENDER_DEPTH_LESS_EQUAL
+                                         ? lessEqualDepthState
+                                         : (ID3D11DepthStencilState*)nullptr, 0);
+    stateCache->setRasterizerState(desc.cullMode == RENDER_CULL_NONE
+                                       ? noCullRasterState
+                                       : (ID3D11RasterizerState*)nullptr);
+    stateCache->setBlendState((ID3D11BlendState*)nullptr, nullptr, 0xFFFFFFFF);
+}
+
+void D3D11RenderDevice::setComputeShader(RenderShader shader)
+{
+    if (shader)
+    {
+        stateCache->setComputeShader(shaders.get(shader).computeShader);
+        return;
+    }
+    // Unbinding also frees every compute resource so the textures can be bound as targets again.
+    ID3D11UnorderedAccessView* nullViews[MAX_BOUND_RESOURCES] = {};
+    ID3D11ShaderResourceView* nullResources[MAX_BOUND_RESOURCES] = {};
+    deviceContext->CSSetUnorderedAccessViews(0, MAX_BOUND_RESOURCES, nullViews, nullptr);
+    deviceContext->CSSetShaderResources(0, MAX_BOUND_RESOURCES, nullResources);
+    stateCache->setComputeShader((ID3D11ComputeShader*)nullptr);
+}
+
+void D3D11RenderDevice::setTextures(RenderShaderStage stage, uint32_t slot, uint32_t count,
+                                    const RenderTexture* textures)
+{
+    ID3D11ShaderResourceView* views[MAX_BOUND_RESOURCES] = {};
+    for (uint32_t i = 0; i < count; i++)
+    {
+        views[i] = textures[i] ? getShaderResourceView(this->textures.get(textures[i])) : nullptr;
+    }
+    setShaderResources(stage, slot, count, views);
+}
+
+void D3D11RenderDevice::setBuffers(RenderShaderStage stage, uint32_t slot, uint32_t count,
+                                   const RenderBuffer* buffers)
+{
+    ID3D11ShaderResourceView* views[MAX_BOUND_RESOURCES] = {};
+    for (uint32_t i = 0; i < count; i++)
+    {
+        views[i] = buffers[i] ? this->buffers.get(buffers[i]).shaderResourceView : nullptr;
+    }
+    setShaderResources(stage, slot, count, views);
+}
+
+void D3D11RenderDevice::setStorageTextures(uint32_t slot, uint32_t count, const RenderTexture* textures)
+{
+    ID3D11UnorderedAccessView* views[MAX_BOUND_RESOURCES] = {};
+    for (uint32_t i = 0; i < count; i++)
+    {
+        views[i] = textures[i] ? getUnorderedAccessView(this->textures.get(textures[i])) : nullptr;
+    }
+    deviceContext->CSSetUnorderedAccessViews(slot, count, views, nullptr);
+}
+
+void D3D11RenderDevice::setStorageBuffers(uint32_t slot, uint32_t count, const RenderBuffer* buffers)
+{
+    ID3D11UnorderedAccessView* views[MAX_BOUND_RESOURCES] = {};
+    for (uint32_t i = 0; i < count; i++)
+    {
+        views[i] = buffers[i] ? this->buffers.get(buffers[i]).unorderedAccessView : nullptr;
+    }
+    deviceContext->CSSetUnorderedAccessViews(slot, count, views, nullptr);
+}
+
+void D3D11RenderDevice::setSamplers(RenderShaderStage stage, uint32_t slot, uint32_t count,
+                                    const RenderSampler* samplers)
+{
+    ID3D11SamplerState* states[MAX_BOUND_RESOURCES] = {};
+    for (uint32_t i = 0; i < count; i++)
+    {
+        states[i] = this->samplers.get(samplers[i]);
+    }
+    switch (stage)
+    {
+    case RENDER_STAGE_VERTEX:
+        stateCache->setVertexSamplers(slot, count, states);
+        break;
+    case RENDER_STAGE_PIXEL:
+        stateCache->setPixelSamplers(slot, count, states);
+        break;
+    case RENDER_STAGE_COMPUTE:
+        stateCache->setComputeSamplers(slot, count, states);
+        break;
+    }
+}
+
+void D3D11RenderDevice::setConstantBuffer(RenderShaderStage stage, uint32_t slot, RenderBuffer buffer)
+{
+    ConstantBuffer* constants = buffers.get(buffer).constants;
+    if (!constants)
+    {
+        throw std::runtime_error("Failed to bind constant buffer: not a constant buffer");
+    }
+    switch (stage)
+    {
+    case RENDER_STAGE_VERTEX:
+        constants->bindToVertexShader(deviceContext, slot);
+        break;
+    case RENDER_STAGE_PIXEL:
+        constants->bindToPixelShader(deviceContext, slot);
+        break;
+    case RENDER_STAGE_COMPUTE:
+        constants->bindToComputeShader(deviceContext, slot);
+        break;
+    }
+}
+
+void D3D11RenderDevice::updateBuffer(RenderBuffer buffer, const void* data, uint32_t size)
+{
+    BufferEntry& entry = buffers.get(buffer);
+    if (entry.constants)
+    {
+        entry.constants->updateData(deviceContext, const_cast<void*>(data));
+        return;
+    }
+    if (entry.desc.type == RENDER_BUFFER_STRUCTURED)
+    {
+        // Default usage, since compute shaders also write it; only the bytes given are replaced.
+        D3D11_BOX box = {0, 0, 0, size, 1, 1};
+        deviceContext->UpdateSubresource(entry.buffer, 0, &box, data, 0, 0);
+        return;
+    }
+    D3D11_MAPPED_SUBRESOURCE mapped;
+    if (FAILED(deviceContext->Map(entry.buffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped)))
+    {
+        throw std::runtime_error("Failed to map buffer");
+    }
+    memcpy(mapped.pData, data, size);
+    deviceContext->Unmap(entry.buffer, 0);
+}
+
+void D3D11RenderDevice::clearStorageBuffer(RenderBuffer buffer)
+{
+    UINT zeros[4] = {};
+    deviceContext->ClearUnorderedAccessViewUint(buffers.get(buffer).unorderedAccessView, zeros);
+}
+
+void D3D11RenderDevice::draw(uint32_t vertexCount, uint32_t instanceCount)
+{
+    if (instanceCount == 1)
+    {
+        deviceContext->Draw(vertexCount, 0);
+        return;
+    }
+    deviceContext->DrawInstanced(vertexCount, instanceCount, 0, 0);
+}
+
+void D3D11RenderDevice::drawIndexed(RenderBuffer vertexBuffer, RenderBuffer indexBuffer, uint32_t indexCount,
+                                    RenderBuffer instanceBuffer, uint32_t instanceCount)
+{
+    const BufferEntry& vertices = buffers.get(vertexBuffer);
+    const BufferEntry& indices = buffers.get(indexBuffer);
+    ID3D11Buffer* vertexBuffers[] = {vertices.buffer, nullptr};
+    UINT strides[] = {vertices.desc.stride, 0};
+    UINT offsets[] = {0, 0};
+    UINT bufferCount = 1;
+    if (instanceBuffer)
+    {
+        const BufferEntry& instances = buffers.get(instanceBuffer);
+        vertexBuffers[1] = instances.buffer;
+        strides[1] = instances.desc.stride;
+        bufferCount = 2;
+    }
+    deviceContext->IASetVertexBuffers(0, bufferCount, vertexBuffers, strides, offsets);
+    deviceContext->IASetIndexBuffer(indices.buffer,
+                                    indices.desc.stride == 2 ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT, 0);
+    if (instanceBuffer)
+    {
+        deviceContext->DrawIndexedInstanced(indexCount, instanceCount, 0, 0, 0);
+        return;
+    }
+    deviceContext->DrawIndexed(indexCount, 0, 0);
+}
+
+void D3D11RenderDevice::dispatch(uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ)
+{
+    deviceContext->Dispatch(groupCountX, groupCountY, groupCountZ);
+}
+
+void D3D11RenderDevice::copyToReadback(RenderReadback readback, RenderTexture texture)
+{
+    ReadbackEntry& entry = readbacks.get(readback);
+    deviceContext->CopyResource(entry.texture, textures.get(texture).texture);
+    deviceContext->End(entry.query);
+}
+
+bool D3D11RenderDevice::readReadback(RenderReadback readback, void* data, uint32_t size)
+{
+    ReadbackEntry& entry = readbacks.get(readback);
+    if (deviceContext->GetData(entry.query, nullptr, 0, D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK)
+    {
+        return false;
+    }
+    D3D11_MAPPED_SUBRESOURCE mappedResource = {};
+    HRESULT result = deviceContext->Map(entry.texture, 0, D3D11_MAP_READ, D3D11_MAP_FLAG_DO_NOT_WAIT,
+                                        &mappedResource);
+    if (result == DXGI_ERROR_WAS_STILL_DRAWING)
+    {
+        return false;
+    }
+    if (FAILED(result))
+    {
+        throw std::runtime_error("Failed to map readback");
+    }
+    memcpy(data, mappedResource.pData, size);
+    deviceContext->Unmap(entry.texture, 0);
+    return true;
+}
+
+void D3D11RenderDevice::setProfiler(FrameProfiler* profiler)
+{
+    this->profiler = profiler;
+}
+
+void D3D11RenderDevice::invalidateState()
+{
+    stateCache->invalidate();
+}
+
+ID3D11ShaderResourceView* D3D11RenderDevice::getShaderResourceView(TextureEntry& entry)
+{
+    if (entry.shaderResourceView)
+    {
+        return entry.shaderResourceView;
+    }
+    D3D11_SHADER_RESOURCE_VIEW_DESC desc = {};
+    desc.Format = toDxgiFormat(entry.desc.format);
+    if (entry.desc.cube)
+    {
+        desc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURECUBE;
+        desc.TextureCube.MipLevels = entry.desc.mipLevels;
+    }
+    else if (entry.desc.arraySize > 1)
+    {
+        desc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2DARRAY;
+        desc.Texture2DArray.MipLevels = entry.desc.mipLevels;
+        desc.Texture2DArray.ArraySize = entry.desc.arraySize;
+    }
+    else
+    {
+        desc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+        desc.Texture2D.MipLevels = entry.desc.mipLevels;
+    }
+    if (FAILED(device->CreateShaderResourceView(entry.texture, &desc, &entry.shaderResourceView)))
+    {
+        throw std::runtime_error("Failed to create shader resource view for " + entry.name);
+    }
+    return entry.shaderResourceView;
+}
+
+ID3D11UnorderedAccessView* D3D11RenderDevice::getUnorderedAccessView(TextureEntry& entry)
+{
+    if (!entry.unorderedAccessView &&
+        FAILED(device->CreateUnorderedAccessView(entry.texture, nullptr, &entry.unorderedAccessView)))
+    {
+        throw std::runtime_error("Failed to create unordered access view for " + entry.name);
+    }
+    return entry.unorderedAccessView;
+}
+
+ID3D11RenderTargetView* D3D11RenderDevice::getRenderTargetView(TextureEntry& entry,
+                                                               const RenderAttachment& attachment)
+{
+    ID3D11RenderTargetView*& view = entry.renderTargetViews.at(
+        D3D11CalcSubresource(attachment.mip, attachment.slice, entry.desc.mipLevels));
+    if (view)
+    {
+        return view;
+    }
+    D3D11_RENDER_TARGET_VIEW_DESC desc = {};
+    D3D11_RENDER_TARGET_VIEW_DESC* pDesc = &desc;
+    if (entry.external)
+    {
+        // Swap chain buffers may be typeless or sRGB; the default view keeps whatever they were created with.
+        pDesc = nullptr;
+    }
+    else if (entry.desc.arraySize > 1)
+    {
+        desc.Format = toDxgiFormat(entry.desc.format);
+        desc.ViewDimension = D3D11_RTV_DIMENSION_TEXTURE2DARRAY;
+        desc.Texture2DArray.MipSlice = attachment.mip;
+        desc.Texture2DArray.FirstArraySlice = attachment.slice;
+        desc.Texture2DArray.ArraySize = 1;
+    }
+    else
+    {
+        desc.Format = toDxgiFormat(entry.desc.format);
+        desc.ViewDimension = D3D11_RTV_DIMENSION_TEXTURE2D;
+        desc.Texture2D.MipSlice = attachment.mip;
+    }
+    if (FAILED(device->CreateRenderTargetView(entry.texture, pDesc, &view)))
+    {
+        throw std::runtime_error("Failed to create render target view for " + entry.name);
+    }
+    return view;
+}
+
+ID3D11DepthStencilView* D3D11RenderDevice::getDepthStencilView(TextureEntry& entry,
+                                                               const RenderAttachment& attachment)
+{
+    ID3D11DepthStencilView*& view = entry.depthStencilViews.at(
+        D3D11CalcSubresource(attachment.mip, attachment.slice, entry.desc.mipLevels));
+    if (view)
+    {
+        return view;
+    }
+    D3D11_DEPTH_STENCIL_VIEW_DESC desc = {};
+    desc.Format = toDxgiFormat(entry.desc.format);
+    desc.ViewDimension = D3D11_DSV_DIMENSION_TEXTURE2D;
+    desc.Texture2D.MipSlice = attachment.mip;
+    if (FAILED(device->CreateDepthStencilView(entry.texture, &desc, &view)))
+    {
+        throw std::runtime_error("Failed to create depth stencil view for " + entry.name);
+    }
+    return view;
+}
+
+void D3D11RenderDevice::setShaderResources(RenderShaderStage stage, uint32_t slot, uint32_t count,
+                                           ID3D11ShaderResourceView* const* views)
+{
+    switch (stage)
+    {
+    case RENDER_STAGE_VERTEX:
+        deviceContext->VSSetShaderResources(slot, count, views);
+        break;
+    case RENDER_STAGE_PIXEL:
+        deviceContext->PSSetShaderResources(slot, count, views);
+        break;
+    case RENDER_STAGE_COMPUTE:
+        deviceContext->CSSetShaderResources(slot, count, views);
+        break;
+    }
+}
+
+void D3D11RenderDevice::releaseTexture(TextureEntry& entry)
+{
+    for (ID3D11RenderTargetView* view : entry.renderTargetViews)
+    {
+        if (view)
+        {
+            view->Release();
+        }
+    }
+    for (ID3D11DepthStencilView* view : entry.depthStencilViews)
+    {
+        if (view)
+        {
+            view->Release();
+        }
+    }
+    if (entry.shaderResourceView)
+    {
+        entry.shaderResourceView->Release();
+    }
+    if (entry.unorderedAccessView)
+    {
+        entry.unorderedAccessView->Release();
+    }
+    entry.texture->Release();
+}
+
+void D3D11RenderDevice::releaseBuffer(BufferEntry& entry)
+{
+    delete entry.constants;
+    if (entry.shaderResourceView)
+    {
+        entry.shaderResourceView->Release();
+    }
+    if (entry.unorderedAccessView)
+    {
+        entry.unorderedAccessView->Release();
+    }
+    if (entry.buffer)
+    {
+        entry.buffer->Release();
+    }
+}
+
+void D3D11RenderDevice::releaseShader(ShaderEntry& entry)
+{
+    if (entry.vertexShader)
+    {
+        entry.vertexShader->Release();
+    }
+    if (entry.pixelShader)
+    {
+        entry.pixelShader->Release();
+    }
+    if (entry.computeShader)
+    {
+        entry.computeShader->Release();
+    }
+    if (entry.inputLayout)
+    {
+        entry.inputLayout->Release();
+    }
+}
+
+void D3D11RenderDevice::createStates()
+{
+    D3D11_RASTERIZER_DESC rasterDesc = {};
+    rasterDesc.FillMode = D3D11_FILL_SOLID;
+    rasterDesc.CullMode = D3D11_CULL_NONE;
+    rasterDesc.FrontCounterClockwise = true;
+    if (FAILED(device->CreateRasterizerState(&rasterDesc, &noCullRasterState)))
+    {
+        throw std::runtime_error("Failed to create raster state");
+    }
+
+    D3D11_DEPTH_STENCIL_DESC depthDesc = {};
+    depthDesc.DepthEnable = true;
+    depthDesc.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ALL;
+    depthDesc.DepthFunc = D3D11_COMPARISON_LESS_EQUAL;
+    if (FAILED(device->CreateDepthStencilState(&depthDesc, &lessEqualDepthState)))
+    {
+        throw std::runtime_error("Failed to create depth state");
+    }
+}
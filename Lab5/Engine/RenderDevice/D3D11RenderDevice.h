@@ -0,0 +1,143 @@
+#pragma once
+
+#include <d3d11.h>
+#include <string>
+#include <vector>
+
+#include "HandleTable.h"
+#include "RenderDevice.h"
+#include "../Profiler/FrameProfiler.h"
+#include "../../DXDevice/DXStateCache.h"
+#include "../../DXShader/ConstantBuffer.h"
+#include "../../DXShader/ShaderLoader.h"
+#include "../../Utils/ThreadPool.h"
+
+// RenderDevice on a D3D11 immediate context. Views are created on first use and cached per subresource, pipeline
+// state goes through the DXStateCache, constants through the ConstantRing and shaders compile on the device's own
+// ShaderLoader. Scopes forward to the FrameProfiler when one is set.
+class D3D11RenderDevice : public RenderDevice
+{
+public:
+    D3D11RenderDevice(ID3D11Device* device, ID3D11DeviceContext* deviceContext, DXStateCache* stateCache,
+                      ConstantRing* constantRing);
+    ~D3D11RenderDevice() override;
+
+    RenderTexture createTexture(const RenderTextureDesc& desc, const void* const* initialData = nullptr) override;
+    RenderBuffer createBuffer(const RenderBufferDesc& desc, const void* initialData = nullptr) override;
+    void requestShader(const RenderShaderDesc& desc) override;
+    RenderShader createShader(const RenderShaderDesc& desc) override;
+    RenderSampler createSampler(RenderFilter filter, RenderAddressMode addressMode) override;
+    RenderReadback createReadback(const RenderTextureDesc& desc) override;
+    void destroyTexture(RenderTexture texture) override;
+    void destroyBuffer(RenderBuffer buffer) override;
+    void destroyShader(RenderShader shader) override;
+    void destroySampler(RenderSampler sampler) override;
+    void destroyReadback(RenderReadback readback) override;
+
+    void beginFrame() override;
+    void endFrame() override;
+    void beginScope(const char* name) override;
+    void endScope() override;
+
+    void beginPass(const RenderPassDesc& desc) override;
+    void endPass() override;
+    void setPipeline(const RenderPipelineDesc& desc) override;
+    void setComputeShader(RenderShader shader) override;
+    void setTextures(RenderShaderStage stage, uint32_t slot, uint32_t count, const RenderTexture* textures) override;
+    void setBuffers(RenderShaderStage stage, uint32_t slot, uint32_t count, const RenderBuffer* buffers) override;
+    void setStorageTextures(uint32_t slot, uint32_t count, const RenderTexture* textures) override;
+    void setStorageBuffers(uint32_t slot, uint32_t count, const RenderBuffer* buffers) override;
+    void setSamplers(RenderShaderStage stage, uint32_t slot, uint32_t count, const RenderSampler* samplers) override;
+    void setConstantBuffer(RenderShaderStage stage, uint32_t slot, RenderBuffer buffer) override;
+
+    void updateBuffer(RenderBuffer buffer, const void* data, uint32_t size) override;
+    void clearStorageBuffer(RenderBuffer buffer) override;
+    void draw(uint32_t vertexCount, uint32_t instanceCount = 1) override;
+    void drawIndexed(RenderBuffer vertexBuffer, RenderBuffer indexBuffer, uint32_t indexCount,
+                     RenderBuffer instanceBuffer = RENDER_NULL_HANDLE, uint32_t instanceCount = 1) override;
+    void dispatch(uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ) override;
+
+    void copyToReadback(RenderReadback readback, RenderTexture texture) override;
+    bool readReadback(RenderReadback readback, void* data, uint32_t size) override;
+
+    // Wraps a texture owned elsewhere, e.g. a swap chain buffer; it must be unregistered before its owner lets go.
+    RenderTexture registerTexture(ID3D11Texture2D* texture, const char* name);
+    void unregisterTexture(RenderTexture texture);
+    // The description of a texture created outside the device, for wrapping or sizing it.
+    static RenderTextureDesc describeTexture(const D3D11_TEXTURE2D_DESC& desc);
+    void setProfiler(FrameProfiler* profiler);
+    // Code that drives the context directly, like the ImGui backend, leaves the state cache out of date.
+    void invalidateState();
+
+private:
+    struct TextureEntry
+    {
+        RenderTextureDesc desc;
+        std::string name;
+        std::string memoryCategory;
+        ID3D11Texture2D* texture = nullptr;
+        ID3D11ShaderResourceView* shaderResourceView = nullptr;
+        ID3D11UnorderedAccessView* unorderedAccessView = nullptr;
+        // One per subresource, indexed like D3D11CalcSubresource.
+        std::vector<ID3D11RenderTargetView*> renderTargetViews;
+        std::vector<ID3D11DepthStencilView*> depthStencilViews;
+        uint64_t bytes = 0;
+        bool external = false;
+    };
+
+    struct BufferEntry
+    {
+        RenderBufferDesc desc;
+        std::string name;
+        std::string memoryCategory;
+        ID3D11Buffer* buffer = nullptr;
+        ID3D11ShaderResourceView* shaderResourceView = nullptr;
+        ID3D11UnorderedAccessView* unorderedAccessView = nullptr;
+        ConstantBuffer* constants = nullptr;
+        uint64_t bytes = 0;
+    };
+
+    struct ShaderEntry
+    {
+        RenderShaderStage stage = RENDER_STAGE_VERTEX;
+        ID3D11VertexShader* vertexShader = nullptr;
+        ID3D11PixelShader* pixelShader = nullptr;
+        ID3D11ComputeShader* computeShader = nullptr;
+        ID3D11InputLayout* inputLayout = nullptr;
+    };
+
+    struct ReadbackEntry
+    {
+        ID3D11Texture2D* texture = nullptr;
+        ID3D11Query* query = nullptr;
+    };
+
+    ID3D11Device* device;
+    ID3D11DeviceContext* deviceContext;
+    DXStateCache* stateCache;
+    ConstantRing* constantRing;
+    FrameProfiler* profiler = nullptr;
+    ThreadPool shaderThreadPool;
+    ShaderLoader shaderLoader;
+
+    HandleTable<TextureEntry> textures;
+    HandleTable<BufferEntry> buffers;
+    HandleTable<ShaderEntry> shaders;
+    HandleTable<ID3D11SamplerState*> samplers;
+    HandleTable<ReadbackEntry> readbacks;
+
+    ID3D11DepthStencilState* lessEqualDepthState = nullptr;
+    ID3D11RasterizerState* noCullRasterState = nullptr;
+    uint32_t boundColorCount = 0;
+
+    ID3D11ShaderResourceView* getShaderResourceView(TextureEntry& entry);
+    ID3D11UnorderedAccessView* getUnorderedAccessView(TextureEntry& entry);
+    ID3D11RenderTargetView* getRenderTargetView(TextureEntry& entry, const RenderAttachment& attachment);
+    ID3D11DepthStencilView* getDepthStencilView(TextureEntry& entry, const RenderAttachment& attachment);
+    void setShaderResources(RenderShaderStage stage, uint32_t slot, uint32_t count,
+                            ID3D11ShaderResourceView* const* views);
+    void releaseTexture(TextureEntry& entry);
+    void releaseBuffer(BufferEntry& entry);
+    void releaseShader(ShaderEntry& entry);
+    void createStates();
+};
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+// Storage behind the RenderDevice handles. Handle zero is never issued, and a destroyed handle is never issued again,
+// so a stale handle fails loudly instead of aliasing a newer resource.
+template <typename T>
+class HandleTable
+{
+public:
+    uint32_t insert(const T& value)
+    {
+        entries.push_back(value);
+        alive.push_back(true);
+        liveCount++;
+        return (uint32_t)entries.size();
+    }
+
+    T& get(uint32_t handle)
+    {
+        if (!contains(handle))
+        {
+            throw std::runtime_error("Failed to find render resource: invalid handle");
+        }
+        return entries[handle - 1];
+    }
+
+    const T& get(uint32_t handle) const
+    {
+        if (!contains(handle))
+        {
+            throw std::runtime_error("Failed to find render resource: invalid handle");
+        }
+        return entries[handle - 1];
+    }
+
+    T remove(uint32_t handle)
+    {
+        T value = get(handle);
+        entries[handle - 1] = T();
+        alive[handle - 1] = false;
+        liveCount--;
+        return value;
+    }
+
+    bool contains(uint32_t handle) const
+    {
+        return handle != 0 && handle <= entries.size() && alive[handle - 1];
+    }
+
+    uint32_t getLiveCount() const
+    {
+        return liveCount;
+    }
+
+    template <typename Function>
+    void forEach(Function function)
+    {
+        for (size_t i = 0; i < entries.size(); i++)
+        {
+            if (alive[i])
+            {
+                function((uint32_t)(i + 1), entries[i]);
+            }
+        }
+    }
+
+private:
+    std::vector<T> entries;
+    std::vector<bool> alive;
+    uint32_t liveCount = 0;
+};
@@ -0,0 +1,653 @@
+#include "RecordingRenderDevice.h"
+
+#include <cstring>
+#include <stdexcept>
+
+#include "../../Utils/MemoryAccounting.h"
+
+namespace
+{
+    std::string makeName(const char* name, const char* fallback, uint32_t handle)
+    {
+        return name ? std::string(name) : std::string(fallback) + " #" + std::to_string(handle);
+    }
+}
+
+bool RenderCommand::operator==(const RenderCommand& other) const
+{
+    return type == other.type && name == other.name && arguments[0] == other.arguments[0] &&
+        arguments[1] == other.arguments[1] && arguments[2] == other.arguments[2];
+}
+
+bool RenderCommand::operator!=(const RenderCommand& other) const
+{
+    return !(*this == other);
+}
+
+bool RenderFrameCounters::operator==(const RenderFrameCounters& other) const
+{
+    return passes == other.passes && drawCalls == other.drawCalls && dispatches == other.dispatches &&
+        pipelineChanges == other.pipelineChanges && resourceBindings == other.resourceBindings &&
+        bufferUploads == other.bufferUploads && readbackCopies == other.readbackCopies &&
+        vertices == other.vertices && instances == other.instances && threadGroups == other.threadGroups &&
+        uploadedBytes == other.uploadedBytes && targetPixels == other.targetPixels;
+}
+
+bool RenderFrameCounters::operator!=(const RenderFrameCounters& other) const
+{
+    return !(*this == other);
+}
+
+RecordingRenderDevice::RecordingRenderDevice(uint32_t readbackLatency) : readbackLatency(readbackLatency)
+{
+}
+
+RecordingRenderDevice::~RecordingRenderDevice()
+{
+    textures.forEach([](uint32_t, TextureEntry& texture)
+    {
+        MemoryAccounting::release(texture.memoryCategory, texture.bytes);
+    });
+    buffers.forEach([](uint32_t, BufferEntry& buffer)
+    {
+        MemoryAccounting::release(buffer.memoryCategory, buffer.desc.size);
+    });
+}
+
+RenderTexture RecordingRenderDevice::createTexture(const RenderTextureDesc& desc, const void* const* initialData)
+{
+    if (desc.width == 0 || desc.height == 0 || desc.mipLevels == 0 || desc.arraySize == 0)
+    {
+        throw std::runtime_error("Failed to create texture: empty description");
+    }
+    if (desc.cube && desc.arraySize % 6 != 0)
+    {
+        throw std::runtime_error("Failed to create texture: cube textures need six slices per cube");
+    }
+    if ((desc.bindFlags & RENDER_BIND_DEPTH_STENCIL) && desc.format != RENDER_FORMAT_D24_UNORM_S8_UINT)
+    {
+        throw std::runtime_error("Failed to create texture: depth stencil needs a depth format");
+    }
+    if (initialData)
+    {
+        for (uint32_t i = 0; i < desc.mipLevels * desc.arraySize; i++)
+        {
+            if (!initialData[i])
+            {
+                throw std::runtime_error("Failed to create texture: missing initial data for a subresource");
+            }
+        }
+    }
+
+    TextureEntry texture;
+    texture.desc = desc;
+    texture.memoryCategory = desc.memoryCategory;
+    texture.bytes = getTextureBytes(desc);
+    RenderTexture handle = textures.insert(texture);
+    TextureEntry& entry = textures.get(handle);
+    entry.name = makeName(desc.name, "Texture", handle);
+    entry.desc.name = nullptr;
+    entry.desc.memoryCategory = nullptr;
+    MemoryAccounting::allocate(entry.memoryCategory, entry.bytes);
+    resourceStats.textures++;
+    addResourceBytes(entry.bytes, 0);
+    return handle;
+}
+
+RenderBuffer RecordingRenderDevice::createBuffer(const RenderBufferDesc& desc, const void* initialData)
+{
+    if (desc.size == 0)
+    {
+        throw std::runtime_error("Failed to create buffer: empty description");
+    }
+    bool needsData = desc.type == RENDER_BUFFER_VERTEX || desc.type == RENDER_BUFFER_INDEX;
+    if (needsData && !initialData)
+    {
+        throw std::runtime_error("Failed to create buffer: vertex and index buffers need initial data");
+    }
+    if (desc.type == RENDER_BUFFER_INDEX && desc.stride != 2 && desc.stride != 4)
+    {
+        throw std::runtime_error("Failed to create buffer: indices must be 16 or 32 bits");
+    }
+    if ((desc.type == RENDER_BUFFER_STRUCTURED || desc.type == RENDER_BUFFER_VERTEX ||
+            desc.type == RENDER_BUFFER_INSTANCE) && (desc.stride == 0 || desc.size % desc.stride != 0))
+    {
+        throw std::runtime_error("Failed to create buffer: size is not a multiple of the stride");
+    }
+
+    BufferEntry buffer;
+    buffer.desc = desc;
+    buffer.memoryCategory = desc.memoryCategory;
+    if (desc.type == RENDER_BUFFER_CONSTANT)
+    {
+        buffer.constants.assign((desc.size + 15) / 16 * 16, 0);
+        if (initialData)
+        {
+            memcpy(buffer.constants.data(), initialData, desc.size);
+        }
+    }
+    RenderBuffer handle = buffers.insert(buffer);
+    BufferEntry& entry = buffers.get(handle);
+    entry.name = makeName(desc.name, "Buffer", handle);
+    entry.desc.name = nullptr;
+    entry.desc.memoryCategory = nullptr;
+    MemoryAccounting::allocate(entry.memoryCategory, desc.size);
+    resourceStats.buffers++;
+    addResourceBytes(0, desc.size);
+    return handle;
+}
+
+void RecordingRenderDevice::requestShader(const RenderShaderDesc& desc)
+{
+    if (!desc.path)
+    {
+        throw std::runtime_error("Failed to request shader: no path");
+    }
+}
+
+RenderShader RecordingRenderDevice::createShader(const RenderShaderDesc& desc)
+{
+    requestShader(desc);
+    if (failingStages[desc.stage])
+    {
+        throw std::runtime_error("Failed to create shader: stage disabled on the recording device");
+    }
+    if (desc.stage != RENDER_STAGE_VERTEX && desc.attributeCount)
+    {
+        throw std::runtime_error("Failed to create shader: only vertex shaders take vertex attributes");
+    }
+    ShaderEntry shader;
+    shader.stage = desc.stage;
+    shader.hasVertexInput = desc.attributeCount != 0;
+    RenderShader handle = shaders.insert(shader);
+    shaders.get(handle).name = makeName(desc.name, "Shader", handle);
+    resourceStats.shaders++;
+    return handle;
+}
+
+RenderSampler RecordingRenderDevice::createSampler(RenderFilter filter, RenderAddressMode addressMode)
+{
+    SamplerEntry sampler;
+    sampler.filter = filter;
+    sampler.addressMode = addressMode;
+    resourceStats.samplers++;
+    return samplers.insert(sampler);
+}
+
+RenderReadback RecordingRenderDevice::createReadback(const RenderTextureDesc& desc)
+{
+    ReadbackEntry readback;
+    readback.desc = desc;
+    resourceStats.readbacks++;
+    return readbacks.insert(readback);
+}
+
+void RecordingRenderDevice::destroyTexture(RenderTexture texture)
+{
+    TextureEntry entry = textures.remove(texture);
+    MemoryAccounting::release(entry.memoryCategory, entry.bytes);
+    resourceStats.textures--;
+    resourceStats.textureBytes -= entry.bytes;
+}
+
+void RecordingRenderDevice::destroyBuffer(RenderBuffer buffer)
+{
+    BufferEntry entry = buffers.remove(buffer);
+    MemoryAccounting::release(entry.memoryCategory, entry.desc.size);
+    resourceStats.buffers--;
+    resourceStats.bufferBytes -= entry.desc.size;
+}
+
+void RecordingRenderDevice::destroyShader(RenderShader shader)
+{
+    shaders.remove(shader);
+    resourceStats.shaders--;
+}
+
+void RecordingRenderDevice::destroySampler(RenderSampler sampler)
+{
+    samplers.remove(sampler);
+    resourceStats.samplers--;
+}
+
+void RecordingRenderDevice::destroyReadback(RenderReadback readback)
+{
+    readbacks.remove(readback);
+    resourceStats.readbacks--;
+}
+
+void RecordingRenderDevice::beginFrame()
+{
+    if (inFrame)
+    {
+        throw std::runtime_error("Failed to begin frame: the previous frame was not ended");
+    }
+    inFrame = true;
+    frameIndex++;
+    commands.clear();
+    counters = RenderFrameCounters();
+    // The D3D11 backend starts every frame from unknown state, so state changes are counted the same way.
+    pipeline = RenderPipelineDesc();
+    computeShader = RENDER_NULL_HANDLE;
+}
+
+void RecordingRenderDevice::endFrame()
+{
+    if (!inFrame || inPass || scopeDepth)
+    {
+        throw std::runtime_error("Failed to end frame: unbalanced frame, pass or scope");
+    }
+    inFrame = false;
+}
+
+void RecordingRenderDevice::beginScope(const char* name)
+{
+    scopeDepth++;
+    record(RENDER_COMMAND_BEGIN_SCOPE, name);
+}
+
+void RecordingRenderDevice::endScope()
+{
+    if (!scopeDepth)
+    {
+        throw std::runtime_error("Failed to end scope: no scope is open");
+    }
+    scopeDepth--;
+    record(RENDER_COMMAND_END_SCOPE, "");
+}
+
+void RecordingRenderDevice::beginPass(const RenderPassDesc& desc)
+{
+    if (inPass)
+    {
+        throw std::runtime_error("Failed to begin pass: passes cannot nest");
+    }
+    if (desc.colorCount > RenderPassDesc::MAX_COLOR_ATTACHMENTS || (!desc.colorCount && !desc.depth.texture))
+    {
+        throw std::runtime_error("Failed to begin pass: invalid attachment count");
+    }
+    const RenderAttachment& first = desc.colorCount ? desc.colors[0] : desc.depth;
+    const RenderTextureDesc& firstDesc = textures.get(first.texture).desc;
+    uint32_t width = getMipSize(firstDesc.width, first.mip);
+    uint32_t height = getMipSize(firstDesc.height, first.mip);
+    for (uint32_t i = 0; i <= desc.colorCount; i++)
+    {
+        const RenderAttachment& attachment = i < desc.colorCount ? desc.colors[i] : desc.depth;
+        if (i == desc.colorCount && !attachment.texture)
+        {
+            break;
+        }
+        validateAttachment(attachment, i < desc.colorCount ? RENDER_BIND_RENDER_TARGET : RENDER_BIND_DEPTH_STENCIL);
+        const RenderTextureDesc& attachmentDesc = textures.get(attachment.texture).desc;
+        if (getMipSize(attachmentDesc.width, attachment.mip) != width ||
+            getMipSize(attachmentDesc.height, attachment.mip) != height)
+        {
+            throw std::runtime_error("Failed to begin pass: attachments differ in size");
+        }
+    }
+    if (desc.clearDepth && !desc.depth.texture)
+    {
+        throw std::runtime_error("Failed to begin pass: depth clear without a depth attachment");
+    }
+
+    inPass = true;
+    counters.passes++;
+    counters.targetPixels += (uint64_t)width * height * (desc.colorCount + (desc.depth.texture ? 1 : 0));
+    record(RENDER_COMMAND_BEGIN_PASS, desc.name ? desc.name : "", width, height, desc.colorCount);
+}
+
+void RecordingRenderDevice::endPass()
+{
+    if (!inPass)
+    {
+        throw std::runtime_error("Failed to end pass: no pass is open");
+    }
+    inPass = false;
+    record(RENDER_COMMAND_END_PASS, "");
+}
+
+void RecordingRenderDevice::setPipeline(const RenderPipelineDesc& desc)
+{
+    if (shaders.get(desc.vertexShader).stage != RENDER_STAGE_VERTEX ||
+        shaders.get(desc.pixelShader).stage != RENDER_STAGE_PIXEL)
+    {
+        throw std::runtime_error("Failed to set pipeline: shader stages do not match");
+    }
+    if (desc.vertexShader == pipeline.vertexShader && desc.pixelShader == pipeline.pixelShader &&
+        desc.depthMode == pipeline.depthMode && desc.cullMode == pipeline.cullMode)
+    {
+        return;
+    }
+    pipeline = desc;
+    counters.pipelineChanges++;
+    record(RENDER_COMMAND_SET_PIPELINE, shaders.get(desc.vertexShader).name + " + " +
+           shaders.get(desc.pixelShader).name, desc.depthMode, desc.cullMode);
+}
+
+void RecordingRenderDevice::setComputeShader(RenderShader shader)
+{
+    if (shader && shaders.get(shader).stage != RENDER_STAGE_COMPUTE)
+    {
+        throw std::runtime_error("Failed to set compute shader: not a compute shader");
+    }
+    if (shader == computeShader)
+    {
+        return;
+    }
+    computeShader = shader;
+    if (shader)
+    {
+        counters.pipelineChanges++;
+    }
+    record(RENDER_COMMAND_SET_COMPUTE_SHADER, shader ? shaders.get(shader).name : "");
+}
+
+void RecordingRenderDevice::setTextures(RenderShaderStage stage, uint32_t slot, uint32_t count,
+                                        const RenderTexture* textures)
+{
+    bindTextures("textures", stage, slot, count, textures, RENDER_BIND_SHADER_RESOURCE);
+}
+
+void RecordingRenderDevice::setBuffers(RenderShaderStage stage, uint32_t slot, uint32_t count,
+                                       const RenderBuffer* buffers)
+{
+    bindBuffers("buffers", stage, slot, count, buffers, RENDER_BUFFER_STRUCTURED);
+}
+
+void RecordingRenderDevice::setStorageTextures(uint32_t slot, uint32_t count, const RenderTexture* textures)
+{
+    if (inPass)
+    {
+        throw std::runtime_error("Failed to bind storage textures: compute bindings inside a pass");
+    }
+    bindTextures("storage textures", RENDER_STAGE_COMPUTE, slot, count, textures, RENDER_BIND_UNORDERED_ACCESS);
+}
+
+void RecordingRenderDevice::setStorageBuffers(uint32_t slot, uint32_t count, const RenderBuffer* buffers)
+{
+    if (inPass)
+    {
+        throw std::runtime_error("Failed to bind storage buffers: compute bindings inside a pass");
+    }
+    bindBuffers("storage buffers", RENDER_STAGE_COMPUTE, slot, count, buffers, RENDER_BUFFER_STRUCTURED);
+}
+
+void RecordingRenderDevice::setSamplers(RenderShaderStage stage, uint32_t slot, uint32_t count,
+                                        const RenderSampler* samplers)
+{
+    for (uint32_t i = 0; i < count; i++)
+    {
+        this->samplers.get(samplers[i]);
+    }
+    counters.resourceBindings += count;
+    record(RENDER_COMMAND_BIND, "samplers", stage, slot, count);
+}
+
+void RecordingRenderDevice::setConstantBuffer(RenderShaderStage stage, uint32_t slot, RenderBuffer buffer)
+{
+    BufferEntry& entry = buffers.get(buffer);
+    if (entry.desc.type != RENDER_BUFFER_CONSTANT)
+    {
+        throw std::runtime_error("Failed to bind constant buffer: not a constant buffer");
+    }
+    if (entry.dirty)
+    {
+        entry.dirty = false;
+        counters.bufferUploads++;
+        counters.uploadedBytes += entry.constants.size();
+        record(RENDER_COMMAND_UPDATE_BUFFER, entry.name, entry.constants.size());
+    }
+    counters.resourceBindings++;
+    record(RENDER_COMMAND_BIND, entry.name, stage, slot, 1);
+}
+
+void RecordingRenderDevice::updateBuffer(RenderBuffer buffer, const void* data, uint32_t size)
+{
+    BufferEntry& entry = buffers.get(buffer);
+    if (size > entry.desc.size)
+    {
+        throw std::runtime_error("Failed to update buffer: data is larger than the buffer");
+    }
+    if (entry.desc.type == RENDER_BUFFER_CONSTANT)
+    {
+        if (memcmp(entry.constants.data(), data, size) != 0)
+        {
+            memcpy(entry.constants.data(), data, size);
+            entry.dirty = true;
+        }
+        return;
+    }
+    if (entry.desc.type != RENDER_BUFFER_INSTANCE && entry.desc.type != RENDER_BUFFER_STRUCTURED)
+    {
+        throw std::runtime_error("Failed to update buffer: only constant, instance and structured buffers are dynamic");
+    }
+    counters.bufferUploads++;
+    counters.uploadedBytes += size;
+    record(RENDER_COMMAND_UPDATE_BUFFER, entry.name, size);
+}
+
+void RecordingRenderDevice::clearStorageBuffer(RenderBuffer buffer)
+{
+    const BufferEntry& entry = requireBuffer(buffer, RENDER_BUFFER_STRUCTURED,
+                                             "Failed to clear buffer: not a structured buffer");
+    record(RENDER_COMMAND_CLEAR_STORAGE_BUFFER, entry.name, entry.desc.size);
+}
+
+void RecordingRenderDevice::draw(uint32_t vertexCount, uint32_t instanceCount)
+{
+    if (!inPass || !pipeline.vertexShader)
+    {
+        throw std::runtime_error("Failed to draw: no pass or pipeline is bound");
+    }
+    if (shaders.get(pipeline.vertexShader).hasVertexInput)
+    {
+        throw std::runtime_error("Failed to draw: the vertex shader expects vertex buffers");
+    }
+    counters.drawCalls++;
+    counters.vertices += (uint64_t)vertexCount * instanceCount;
+    counters.instances += instanceCount;
+    record(RENDER_COMMAND_DRAW, shaders.get(pipeline.pixelShader).name, vertexCount, instanceCount);
+}
+
+void RecordingRenderDevice::drawIndexed(RenderBuffer vertexBuffer, RenderBuffer indexBuffer, uint32_t indexCount,
+                                        RenderBuffer instanceBuffer, uint32_t instanceCount)
+{
+    if (!inPass || !pipeline.vertexShader)
+    {
+        throw std::runtime_error("Failed to draw: no pass or pipeline is bound");
+    }
+    if (!shaders.get(pipeline.vertexShader).hasVertexInput)
+    {
+        throw std::runtime_error("Failed to draw: the vertex shader takes no vertex buffers");
+    }
+    requireBuffer(vertexBuffer, RENDER_BUFFER_VERTEX, "Failed to draw: not a vertex buffer");
+    const BufferEntry& indices = requireBuffer(indexBuffer, RENDER_BUFFER_INDEX, "Failed to draw: not an index buffer");
+    if ((uint64_t)indexCount * indices.desc.stride > indices.desc.size)
+    {
+        throw std::runtime_error("Failed to draw: index count exceeds the index buffer");
+    }
+    if (instanceBuffer)
+    {
+        const BufferEntry& instances = requireBuffer(instanceBuffer, RENDER_BUFFER_INSTANCE,
+                                                     "Failed to draw: not an instance buffer");
+        if ((uint64_t)instanceCount * instances.desc.stride > instances.desc.size)
+        {
+            throw std::runtime_error("Failed to draw: instance count exceeds the instance buffer");
+        }
+    }
+    else if (instanceCount != 1)
+    {
+        throw std::runtime_error("Failed to draw: instancing without an instance buffer");
+    }
+    counters.drawCalls++;
+    counters.vertices += (uint64_t)indexCount * instanceCount;
+    counters.instances += instanceCount;
+    record(RENDER_COMMAND_DRAW_INDEXED, shaders.get(pipeline.pixelShader).name, indexCount, instanceCount);
+}
+
+void RecordingRenderDevice::dispatch(uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ)
+{
+    if (inPass || !computeShader)
+    {
+        throw std::runtime_error("Failed to dispatch: no compute shader bound or a pass is open");
+    }
+    counters.dispatches++;
+    counters.threadGroups += (uint64_t)groupCountX * groupCountY * groupCountZ;
+    record(RENDER_COMMAND_DISPATCH, shaders.get(computeShader).name, groupCountX, groupCountY, groupCountZ);
+}
+
+void RecordingRenderDevice::copyToReadback(RenderReadback readback, RenderTexture texture)
+{
+    ReadbackEntry& entry = readbacks.get(readback);
+    const TextureEntry& source = textures.get(texture);
+    if (source.desc.width != entry.desc.width || source.desc.height != entry.desc.height ||
+        source.desc.format != entry.desc.format)
+    {
+        throw std::runtime_error("Failed to copy to readback: texture does not match the readback");
+    }
+    if (entry.pending)
+    {
+        throw std::runtime_error("Failed to copy to readback: previous copy not read yet");
+    }
+    entry.pending = true;
+    entry.copyFrame = frameIndex;
+    counters.readbackCopies++;
+    record(RENDER_COMMAND_COPY_TO_READBACK, source.name);
+}
+
+bool RecordingRenderDevice::readReadback(RenderReadback readback, void* data, uint32_t size)
+{
+    ReadbackEntry& entry = readbacks.get(readback);
+    if (!entry.pending || frameIndex - entry.copyFrame < readbackLatency)
+    {
+        return false;
+    }
+    if (size > getTextureBytes(entry.desc))
+    {
+        throw std::runtime_error("Failed to read readback: requested more than the texture holds");
+    }
+    memset(data, 0, size);
+    entry.pending = false;
+    return true;
+}
+
+void RecordingRenderDevice::failShaderStage(RenderShaderStage stage)
+{
+    failingStages[stage] = true;
+}
+
+const std::vector<RenderCommand>& RecordingRenderDevice::getCommands() const
+{
+    return commands;
+}
+
+const RenderFrameCounters& RecordingRenderDevice::getFrameCounters() const
+{
+    return counters;
+}
+
+const RenderResourceStats& RecordingRenderDevice::getResourceStats() const
+{
+    return resourceStats;
+}
+
+const RenderTextureDesc& RecordingRenderDevice::getTextureDesc(RenderTexture texture) const
+{
+    return textures.get(texture).desc;
+}
+
+uint64_t RecordingRenderDevice::getFrameIndex() const
+{
+    return frameIndex;
+}
+
+void RecordingRenderDevice::record(RenderCommandType type, const std::string& name, uint64_t argument0,
+                                   uint64_t argument1, uint64_t argument2)
+{
+    RenderCommand command;
+    command.type = type;
+    command.name = name;
+    command.arguments[0] = argument0;
+    command.arguments[1] = argument1;
+    command.arguments[2] = argument2;
+    commands.push_back(command);
+}
+
+void RecordingRenderDevice::bindTextures(const char* kind, RenderShaderStage stage, uint32_t slot, uint32_t count,
+                                         const RenderTexture* textures, uint32_t requiredFlag)
+{
+    std::string names;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        names += i ? ", " : "";
+        if (!textures[i])
+        {
+            names += "null";
+            continue;
+        }
+        const TextureEntry& entry = this->textures.get(textures[i]);
+        if (!(entry.desc.bindFlags & requiredFlag))
+        {
+            throw std::runtime_error(std::string("Failed to bind ") + kind + ": " + entry.name +
+                                     " was not created for this use");
+        }
+        names += entry.name;
+        counters.resourceBindings++;
+    }
+    record(RENDER_COMMAND_BIND, names, stage, slot, count);
+}
+
+void RecordingRenderDevice::bindBuffers(const char* kind, RenderShaderStage stage, uint32_t slot, uint32_t count,
+                                        const RenderBuffer* buffers, RenderBufferType requiredType)
+{
+    std::string names;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        names += i ? ", " : "";
+        if (!buffers[i])
+        {
+            names += "null";
+            continue;
+        }
+        names += requireBuffer(buffers[i], requiredType,
+                               (std::string("Failed to bind ") + kind + ": wrong buffer type").c_str()).name;
+        counters.resourceBindings++;
+    }
+    record(RENDER_COMMAND_BIND, names, stage, slot, count);
+}
+
+const RecordingRenderDevice::BufferEntry& RecordingRenderDevice::requireBuffer(RenderBuffer buffer,
+                                                                               RenderBufferType type,
+                                                                               const char* error) const
+{
+    const BufferEntry& entry = buffers.get(buffer);
+    if (entry.desc.type != type)
+    {
+        throw std::runtime_error(error);
+    }
+    return entry;
+}
+
+void RecordingRenderDevice::validateAttachment(const RenderAttachment& attachment, uint32_t requiredFlag) const
+{
+    const RenderTextureDesc& desc = textures.get(attachment.texture).desc;
+    if (!(desc.bindFlags & requiredFlag))
+    {
+        throw std::runtime_error("Failed to begin pass: attachment was not created for this use");
+    }
+    if (attachment.mip >= desc.mipLevels || attachment.slice >= desc.arraySize)
+    {
+        throw std::runtime_error("Failed to begin pass: attachment subresource out of range");
+    }
+}
+
+void RecordingRenderDevice::addResourceBytes(uint64_t textureBytes, uint64_t bufferBytes)
+{
+    resourceStats.textureBytes += textureBytes;
+    resourceStats.bufferBytes += bufferBytes;
+    uint64_t total = resourceStats.textureBytes + resourceStats.bufferBytes;
+    if (total > resourceStats.peakBytes)
+    {
+        resourceStats.peakBytes = total;
+    }
+}
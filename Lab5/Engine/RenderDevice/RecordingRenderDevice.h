@@ -0,0 +1,194 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "HandleTable.h"
+#include "RenderDevice.h"
+
+enum RenderCommandType
+{
+    RENDER_COMMAND_BEGIN_PASS,
+    RENDER_COMMAND_END_PASS,
+    RENDER_COMMAND_BEGIN_SCOPE,
+    RENDER_COMMAND_END_SCOPE,
+    RENDER_COMMAND_SET_PIPELINE,
+    RENDER_COMMAND_SET_COMPUTE_SHADER,
+    RENDER_COMMAND_BIND,
+    RENDER_COMMAND_UPDATE_BUFFER,
+    RENDER_COMMAND_CLEAR_STORAGE_BUFFER,
+    RENDER_COMMAND_DRAW,
+    RENDER_COMMAND_DRAW_INDEXED,
+    RENDER_COMMAND_DISPATCH,
+    RENDER_COMMAND_COPY_TO_READBACK
+};
+
+// One recorded call. The name is the pass, scope or bound resource name; the arguments depend on the type, e.g.
+// vertex or index count and instance count for draws, group counts for dispatches, byte size for uploads.
+struct RenderCommand
+{
+    RenderCommandType type;
+    std::string name;
+    uint64_t arguments[3] = {};
+
+    bool operator==(const RenderCommand& other) const;
+    bool operator!=(const RenderCommand& other) const;
+};
+
+// Work submitted since beginFrame. Everything is counted from the calls alone, so two runs of the same frame give
+// the same numbers on any machine.
+struct RenderFrameCounters
+{
+    uint32_t passes = 0;
+    uint32_t drawCalls = 0;
+    uint32_t dispatches = 0;
+    uint32_t pipelineChanges = 0;
+    uint32_t resourceBindings = 0;
+    uint32_t bufferUploads = 0;
+    uint32_t readbackCopies = 0;
+    uint64_t vertices = 0;
+    uint64_t instances = 0;
+    uint64_t threadGroups = 0;
+    uint64_t uploadedBytes = 0;
+    // Attachment area of every pass, a proxy for fill and clear bandwidth.
+    uint64_t targetPixels = 0;
+
+    bool operator==(const RenderFrameCounters& other) const;
+    bool operator!=(const RenderFrameCounters& other) const;
+};
+
+struct RenderResourceStats
+{
+    uint32_t textures = 0;
+    uint32_t buffers = 0;
+    uint32_t shaders = 0;
+    uint32_t samplers = 0;
+    uint32_t readbacks = 0;
+    uint64_t textureBytes = 0;
+    uint64_t bufferBytes = 0;
+    uint64_t peakBytes = 0;
+};
+
+// Backend that runs no GPU work: it validates every call the way a debug layer would, records the command stream
+// of the current frame and tracks the size of every resource. Readbacks complete readbackLatency frames after the
+// copy and return zeros. Shaders are never compiled; failShaderStage makes createShader throw for one stage so
+// fallback paths can run headless too.
+class RecordingRenderDevice : public RenderDevice
+{
+public:
+    static const uint32_t DEFAULT_READBACK_LATENCY = 2;
+
+    explicit RecordingRenderDevice(uint32_t readbackLatency = DEFAULT_READBACK_LATENCY);
+    ~RecordingRenderDevice() override;
+
+    RenderTexture createTexture(const RenderTextureDesc& desc, const void* const* initialData = nullptr) override;
+    RenderBuffer createBuffer(const RenderBufferDesc& desc, const void* initialData = nullptr) override;
+    void requestShader(const RenderShaderDesc& desc) override;
+    RenderShader createShader(const RenderShaderDesc& desc) override;
+    RenderSampler createSampler(RenderFilter filter, RenderAddressMode addressMode) override;
+    RenderReadback createReadback(const RenderTextureDesc& desc) override;
+    void destroyTexture(RenderTexture texture) override;
+    void destroyBuffer(RenderBuffer buffer) override;
+    void destroyShader(RenderShader shader) override;
+    void destroySampler(RenderSampler sampler) override;
+    void destroyReadback(RenderReadback readback) override;
+
+    void beginFrame() override;
+    void endFrame() override;
+    void beginScope(const char* name) override;
+    void endScope() override;
+
+    void beginPass(const RenderPassDesc& desc) override;
+    void endPass() override;
+    void setPipeline(const RenderPipelineDesc& desc) override;
+    void setComputeShader(RenderShader shader) override;
+    void setTextures(RenderShaderStage stage, uint32_t slot, uint32_t count, const RenderTexture* textures) override;
+    void setBuffers(RenderShaderStage stage, uint32_t slot, uint32_t count, const RenderBuffer* buffers) override;
+    void setStorageTextures(uint32_t slot, uint32_t count, const RenderTexture* textures) override;
+    void setStorageBuffers(uint32_t slot, uint32_t count, const RenderBuffer* buffers) override;
+    void setSamplers(RenderShaderStage stage, uint32_t slot, uint32_t count, const RenderSampler* samplers) override;
+    void setConstantBuffer(RenderShaderStage stage, uint32_t slot, RenderBuffer buffer) override;
+
+    void updateBuffer(RenderBuffer buffer, const void* data, uint32_t size) override;
+    void clearStorageBuffer(RenderBuffer buffer) override;
+    void draw(uint32_t vertexCount, uint32_t instanceCount = 1) override;
+    void drawIndexed(RenderBuffer vertexBuffer, RenderBuffer indexBuffer, uint32_t indexCount,
+                     RenderBuffer instanceBuffer = RENDER_NULL_HANDLE, uint32_t instanceCount = 1) override;
+    void dispatch(uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ) override;
+
+    void copyToReadback(RenderReadback readback, RenderTexture texture) override;
+    bool readReadback(RenderReadback readback, void* data, uint32_t size) override;
+
+    void failShaderStage(RenderShaderStage stage);
+    const std::vector<RenderCommand>& getCommands() const;
+    const RenderFrameCounters& getFrameCounters() const;
+    const RenderResourceStats& getResourceStats() const;
+    const RenderTextureDesc& getTextureDesc(RenderTexture texture) const;
+    uint64_t getFrameIndex() const;
+
+private:
+    struct TextureEntry
+    {
+        RenderTextureDesc desc;
+        std::string name;
+        std::string memoryCategory;
+        uint64_t bytes = 0;
+    };
+
+    struct BufferEntry
+    {
+        RenderBufferDesc desc;
+        std::string name;
+        std::string memoryCategory;
+        std::vector<uint8_t> constants;
+        bool dirty = true;
+    };
+
+    struct ShaderEntry
+    {
+        RenderShaderStage stage = RENDER_STAGE_VERTEX;
+        std::string name;
+        bool hasVertexInput = false;
+    };
+
+    struct SamplerEntry
+    {
+        RenderFilter filter = RENDER_FILTER_LINEAR;
+        RenderAddressMode addressMode = RENDER_ADDRESS_WRAP;
+    };
+
+    struct ReadbackEntry
+    {
+        RenderTextureDesc desc;
+        uint64_t copyFrame = 0;
+        bool pending = false;
+    };
+
+    HandleTable<TextureEntry> textures;
+    HandleTable<BufferEntry> buffers;
+    HandleTable<ShaderEntry> shaders;
+    HandleTable<SamplerEntry> samplers;
+    HandleTable<ReadbackEntry> readbacks;
+
+    uint32_t readbackLatency;
+    bool failingStages[3] = {};
+    std::vector<RenderCommand> commands;
+    RenderFrameCounters counters;
+    RenderResourceStats resourceStats;
+    uint64_t frameIndex = 0;
+    bool inFrame = false;
+    bool inPass = false;
+    uint32_t scopeDepth = 0;
+    RenderPipelineDesc pipeline;
+    RenderShader computeShader = RENDER_NULL_HANDLE;
+
+    void record(RenderCommandType type, const std::string& name, uint64_t argument0 = 0, uint64_t argument1 = 0,
+                uint64_t argument2 = 0);
+    void bindTextures(const char* kind, RenderShaderStage stage, uint32_t slot, uint32_t count,
+                      const RenderTexture* textures, uint32_t requiredFlag);
+    void bindBuffers(const char* kind, RenderShaderStage stage, uint32_t slot, uint32_t count,
+                     const RenderBuffer* buffers, RenderBufferType requiredType);
+    const BufferEntry& requireBuffer(RenderBuffer buffer, RenderBufferType type, const char* error) const;
+    void validateAttachment(const RenderAttachment& attachment, uint32_t requiredFlag) const;
+    void addResourceBytes(uint64_t textureBytes, uint64_t bufferBytes);
+};
@@ -0,0 +1,65 @@
+#include "RenderDevice.h"
+
+#include <stdexcept>
+
+#include "../../Utils/BC6H.h"
+
+uint32_t RenderDevice::getBytesPerPixel(RenderFormat format)
+{
+    switch (format)
+    {
+    case RENDER_FORMAT_R32G32B32A32_FLOAT:
+        return 16;
+    case RENDER_FORMAT_R32G32B32_FLOAT:
+        return 12;
+    case RENDER_FORMAT_R16G16B16A16_FLOAT:
+    case RENDER_FORMAT_R16G16B16A16_SNORM:
+    case RENDER_FORMAT_R32G32_FLOAT:
+        return 8;
+    case RENDER_FORMAT_R32_FLOAT:
+    case RENDER_FORMAT_R16G16_FLOAT:
+    case RENDER_FORMAT_R16G16_SNORM:
+    case RENDER_FORMAT_R8G8B8A8_UNORM:
+    case RENDER_FORMAT_R9G9B9E5_SHAREDEXP:
+    case RENDER_FORMAT_D24_UNORM_S8_UINT:
+        return 4;
+    default:
+        throw std::runtime_error("Failed to size texture: unsupported format");
+    }
+}
+
+bool RenderDevice::isBlockCompressed(RenderFormat format)
+{
+    return format == RENDER_FORMAT_BC6H_UF16;
+}
+
+uint32_t RenderDevice::getRowPitch(RenderFormat format, uint32_t width)
+{
+    if (isBlockCompressed(format))
+    {
+        return (width + BC6H::BLOCK_SIZE - 1) / BC6H::BLOCK_SIZE * BC6H::BLOCK_BYTES;
+    }
+    return width * getBytesPerPixel(format);
+}
+
+uint64_t RenderDevice::getSubresourceBytes(RenderFormat format, uint32_t width, uint32_t height)
+{
+    uint32_t rows = isBlockCompressed(format) ? (height + BC6H::BLOCK_SIZE - 1) / BC6H::BLOCK_SIZE : height;
+    return (uint64_t)getRowPitch(format, width) * rows;
+}
+
+uint64_t RenderDevice::getTextureBytes(const RenderTextureDesc& desc)
+{
+    uint64_t bytes = 0;
+    for (uint32_t mip = 0; mip < desc.mipLevels; mip++)
+    {
+        bytes += getSubresourceBytes(desc.format, getMipSize(desc.width, mip), getMipSize(desc.height, mip));
+    }
+    return bytes * desc.arraySize;
+}
+
+uint32_t RenderDevice::getMipSize(uint32_t size, uint32_t mip)
+{
+    size >>= mip;
+    return size ? size : 1;
+}
@@ -0,0 +1,233 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+using RenderTexture = uint32_t;
+using RenderBuffer = uint32_t;
+using RenderShader = uint32_t;
+using RenderSampler = uint32_t;
+using RenderReadback = uint32_t;
+
+const uint32_t RENDER_NULL_HANDLE = 0;
+
+enum RenderFormat
+{
+    RENDER_FORMAT_UNKNOWN = 0,
+    RENDER_FORMAT_R8G8B8A8_UNORM,
+    RENDER_FORMAT_R16G16_FLOAT,
+    RENDER_FORMAT_R16G16B16A16_FLOAT,
+    RENDER_FORMAT_R32_FLOAT,
+    RENDER_FORMAT_R32G32_FLOAT,
+    RENDER_FORMAT_R32G32B32_FLOAT,
+    RENDER_FORMAT_R32G32B32A32_FLOAT,
+    RENDER_FORMAT_R9G9B9E5_SHAREDEXP,
+    RENDER_FORMAT_BC6H_UF16,
+    RENDER_FORMAT_D24_UNORM_S8_UINT,
+    // Vertex attributes only.
+    RENDER_FORMAT_R16G16_SNORM,
+    RENDER_FORMAT_R16G16B16A16_SNORM
+};
+
+enum RenderBindFlags
+{
+    RENDER_BIND_SHADER_RESOURCE = 1,
+    RENDER_BIND_RENDER_TARGET = 2,
+    RENDER_BIND_UNORDERED_ACCESS = 4,
+    RENDER_BIND_DEPTH_STENCIL = 8
+};
+
+enum RenderBufferType
+{
+    RENDER_BUFFER_VERTEX,
+    RENDER_BUFFER_INDEX,
+    // Vertex stream rewritten by updateBuffer, usually once per frame.
+    RENDER_BUFFER_INSTANCE,
+    RENDER_BUFFER_CONSTANT,
+    // Readable from every stage and writable from compute shaders; cleared with clearStorageBuffer. updateBuffer
+    // replaces its first bytes from the CPU.
+    RENDER_BUFFER_STRUCTURED
+};
+
+enum RenderShaderStage
+{
+    RENDER_STAGE_VERTEX,
+    RENDER_STAGE_PIXEL,
+    RENDER_STAGE_COMPUTE
+};
+
+enum RenderDepthMode
+{
+    RENDER_DEPTH_LESS,
+    RENDER_DEPTH_LESS_EQUAL
+};
+
+enum RenderCullMode
+{
+    RENDER_CULL_BACK,
+    RENDER_CULL_NONE
+};
+
+enum RenderFilter
+{
+    RENDER_FILTER_LINEAR,
+    RENDER_FILTER_ANISOTROPIC,
+    RENDER_FILTER_MINIMUM,
+    RENDER_FILTER_MAXIMUM
+};
+
+enum RenderAddressMode
+{
+    RENDER_ADDRESS_WRAP,
+    RENDER_ADDRESS_CLAMP
+};
+
+struct RenderTextureDesc
+{
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t mipLevels = 1;
+    uint32_t arraySize = 1;
+    RenderFormat format = RENDER_FORMAT_UNKNOWN;
+    uint32_t bindFlags = 0;
+    bool cube = false;
+    const char* name = nullptr;
+    const char* memoryCategory = "Textures";
+};
+
+struct RenderBufferDesc
+{
+    RenderBufferType type = RENDER_BUFFER_VERTEX;
+    uint32_t size = 0;
+    // Vertex, instance and structured element size; 2 or 4 for index buffers.
+    uint32_t stride = 0;
+    const char* name = nullptr;
+    const char* memoryCategory = "Buffers";
+};
+
+struct RenderVertexAttribute
+{
+    const char* semantic;
+    uint32_t semanticIndex;
+    RenderFormat format;
+    uint32_t slot = 0;
+    bool perInstance = false;
+};
+
+struct RenderShaderDesc
+{
+    RenderShaderStage stage = RENDER_STAGE_VERTEX;
+    const wchar_t* path = nullptr;
+    // Vertex shaders only; attributes are packed in order within their slot.
+    const RenderVertexAttribute* attributes = nullptr;
+    uint32_t attributeCount = 0;
+    const char* name = nullptr;
+};
+
+struct RenderPipelineDesc
+{
+    RenderShader vertexShader = RENDER_NULL_HANDLE;
+    RenderShader pixelShader = RENDER_NULL_HANDLE;
+    RenderDepthMode depthMode = RENDER_DEPTH_LESS;
+    RenderCullMode cullMode = RENDER_CULL_BACK;
+};
+
+struct RenderAttachment
+{
+    RenderTexture texture = RENDER_NULL_HANDLE;
+    uint32_t mip = 0;
+    uint32_t slice = 0;
+};
+
+// The viewport covers the first attachment at its mip.
+struct RenderPassDesc
+{
+    static const uint32_t MAX_COLOR_ATTACHMENTS = 4;
+
+    const char* name = nullptr;
+    RenderAttachment colors[MAX_COLOR_ATTACHMENTS];
+    uint32_t colorCount = 0;
+    RenderAttachment depth;
+    bool clearColor = false;
+    float clearValue[4] = {};
+    bool clearDepth = false;
+};
+
+// Backend-neutral view of the GPU used by the scene renderer, the tone mapper and the cubemap generator. Handles are
+// never reused while alive and RENDER_NULL_HANDLE unbinds a slot. Failures throw std::runtime_error. Initial texture
+// data is one pointer per subresource, slice-major like D3D11CalcSubresource, with tightly packed rows.
+class RenderDevice
+{
+public:
+    virtual ~RenderDevice() = default;
+
+    virtual RenderTexture createTexture(const RenderTextureDesc& desc, const void* const* initialData = nullptr) = 0;
+    virtual RenderBuffer createBuffer(const RenderBufferDesc& desc, const void* initialData = nullptr) = 0;
+    // Lets the backend start compiling before createShader asks for the result.
+    virtual void requestShader(const RenderShaderDesc& desc) = 0;
+    virtual RenderShader createShader(const RenderShaderDesc& desc) = 0;
+    virtual RenderSampler createSampler(RenderFilter filter, RenderAddressMode addressMode) = 0;
+    virtual RenderReadback createReadback(const RenderTextureDesc& desc) = 0;
+    virtual void destroyTexture(RenderTexture texture) = 0;
+    virtual void destroyBuffer(RenderBuffer buffer) = 0;
+    virtual void destroyShader(RenderShader shader) = 0;
+    virtual void destroySampler(RenderSampler sampler) = 0;
+    virtual void destroyReadback(RenderReadback readback) = 0;
+
+    virtual void beginFrame() = 0;
+    virtual void endFrame() = 0;
+    virtual void beginScope(const char* name) = 0;
+    virtual void endScope() = 0;
+
+    virtual void beginPass(const RenderPassDesc& desc) = 0;
+    virtual void endPass() = 0;
+    virtual void setPipeline(const RenderPipelineDesc& desc) = 0;
+    virtual void setComputeShader(RenderShader shader) = 0;
+    virtual void setTextures(RenderShaderStage stage, uint32_t slot, uint32_t count, const RenderTexture* textures) = 0;
+    virtual void setBuffers(RenderShaderStage stage, uint32_t slot, uint32_t count, const RenderBuffer* buffers) = 0;
+    virtual void setStorageTextures(uint32_t slot, uint32_t count, const RenderTexture* textures) = 0;
+    virtual void setStorageBuffers(uint32_t slot, uint32_t count, const RenderBuffer* buffers) = 0;
+    virtual void setSamplers(RenderShaderStage stage, uint32_t slot, uint32_t count,
+                             const RenderSampler* samplers) = 0;
+    virtual void setConstantBuffer(RenderShaderStage stage, uint32_t slot, RenderBuffer buffer) = 0;
+
+    // Constant buffers keep a copy and upload at the next bind, and only if the data changed.
+    virtual void updateBuffer(RenderBuffer buffer, const void* data, uint32_t size) = 0;
+    virtual void clearStorageBuffer(RenderBuffer buffer) = 0;
+    virtual void draw(uint32_t vertexCount, uint32_t instanceCount = 1) = 0;
+    virtual void drawIndexed(RenderBuffer vertexBuffer, RenderBuffer indexBuffer, uint32_t indexCount,
+                             RenderBuffer instanceBuffer = RENDER_NULL_HANDLE, uint32_t instanceCount = 1) = 0;
+    virtual void dispatch(uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ) = 0;
+
+    virtual void copyToReadback(RenderReadback readback, RenderTexture texture) = 0;
+    // Never waits: returns false while the copy is still in flight.
+    virtual bool readReadback(RenderReadback readback, void* data, uint32_t size) = 0;
+
+    // Throws for block-compressed formats; size those with getRowPitch and getSubresourceBytes.
+    static uint32_t getBytesPerPixel(RenderFormat format);
+    static bool isBlockCompressed(RenderFormat format);
+    static uint32_t getRowPitch(RenderFormat format, uint32_t width);
+    static uint64_t getSubresourceBytes(RenderFormat format, uint32_t width, uint32_t height);
+    static uint64_t getTextureBytes(const RenderTextureDesc& desc);
+    static uint32_t getMipSize(uint32_t size, uint32_t mip);
+};
+
+class RenderScope
+{
+public:
+    RenderScope(RenderDevice* device, const char* name) : device(device)
+    {
+        device->beginScope(name);
+    }
+
+    ~RenderScope()
+    {
+        device->endScope();
+    }
+
+    RenderScope(const RenderScope&) = delete;
+    RenderScope& operator=(const RenderScope&) = delete;
+
+private:
+    RenderDevice* device;
+};
@@ -0,0 +1,157 @@
+#pragma once
+
+#include <cmath>
+
+// Plain float vectors and row-major matrices with the same memory layout as the DirectXMath XMFLOAT and XMMATRIX
+// types, so constant buffer layouts stay unchanged. Matrices follow the DirectXMath conventions: row vectors,
+// left-handed view space and a [0, 1] depth range.
+struct Float2
+{
+    float x = 0;
+    float y = 0;
+};
+
+struct Float3
+{
+    float x = 0;
+    float y = 0;
+    float z = 0;
+};
+
+struct Float4
+{
+    float x = 0;
+    float y = 0;
+    float z = 0;
+    float w = 0;
+};
+
+struct Float4x4
+{
+    float m[4][4] = {};
+};
+
+namespace RenderMath
+{
+    const float PI = 3.14159265359f;
+
+    inline Float3 makeFloat3(float x, float y, float z)
+    {
+        Float3 result;
+        result.x = x;
+        result.y = y;
+        result.z = z;
+        return result;
+    }
+
+    inline Float4 makeFloat4(float x, float y, float z, float w)
+    {
+        Float4 result;
+        result.x = x;
+        result.y = y;
+        result.z = z;
+        result.w = w;
+        return result;
+    }
+
+    inline Float2 makeFloat2(float x, float y)
+    {
+        Float2 result;
+        result.x = x;
+        result.y = y;
+        return result;
+    }
+
+    inline float dot(const Float3& a, const Float3& b)
+    {
+        return a.x * b.x + a.y * b.y + a.z * b.z;
+    }
+
+    inline Float3 cross(const Float3& a, const Float3& b)
+    {
+        return makeFloat3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+    }
+
+    inline Float3 normalize(const Float3& v)
+    {
+        float scale = 1.0f / sqrtf(dot(v, v));
+        return makeFloat3(v.x * scale, v.y * scale, v.z * scale);
+    }
+
+    inline Float4x4 identity()
+    {
+        Float4x4 result;
+        for (int i = 0; i < 4; i++)
+        {
+            result.m[i][i] = 1.0f;
+        }
+        return result;
+    }
+
+    inline Float4x4 multiply(const Float4x4& a, const Float4x4& b)
+    {
+        Float4x4 result;
+        for (int row = 0; row < 4; row++)
+        {
+            for (int column = 0; column < 4; column++)
+            {
+                for (int k = 0; k < 4; k++)
+                {
+                    result.m[row][column] += a.m[row][k] * b.m[k][column];
+                }
+            }
+        }
+        return result;
+    }
+
+    inline Float4x4 scaling(float x, float y, float z)
+    {
+        Float4x4 result = identity();
+        result.m[0][0] = x;
+        result.m[1][1] = y;
+        result.m[2][2] = z;
+        return result;
+    }
+
+    inline Float4x4 translation(float x, float y, float z)
+    {
+        Float4x4 result = identity();
+        result.m[3][0] = x;
+        result.m[3][1] = y;
+        result.m[3][2] = z;
+        return result;
+    }
+
+    // XMMatrixLookToLH.
+    inline Float4x4 lookTo(const Float3& eye, const Float3& direction, const Float3& up)
+    {
+        Float3 zAxis = normalize(direction);
+        Float3 xAxis = normalize(cross(up, zAxis));
+        Float3 yAxis = cross(zAxis, xAxis);
+        Float4x4 result;
+        const Float3* axes[] = {&xAxis, &yAxis, &zAxis};
+        for (int column = 0; column < 3; column++)
+        {
+            result.m[0][column] = axes[column]->x;
+            result.m[1][column] = axes[column]->y;
+            result.m[2][column] = axes[column]->z;
+            result.m[3][column] = -dot(*axes[column], eye);
+        }
+        result.m[3][3] = 1.0f;
+        return result;
+    }
+
+    // XMMatrixPerspectiveFovLH.
+    inline Float4x4 perspectiveFov(float fovY, float aspectRatio, float nearZ, float farZ)
+    {
+        float height = 1.0f / tanf(fovY * 0.5f);
+        float range = farZ / (farZ - nearZ);
+        Float4x4 result;
+        result.m[0][0] = height / aspectRatio;
+        result.m[1][1] = height;
+        result.m[2][2] = range;
+        result.m[2][3] = 1.0f;
+        result.m[3][2] = -range * nearZ;
+        return result;
+    }
+}
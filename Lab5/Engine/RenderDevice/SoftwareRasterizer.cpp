@@ -0,0 +1,409 @@
+#include "SoftwareRasterizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "../IBL/FloatLanes.h"
+#include "../../Utils/ThreadPool.h"
+
+namespace
+{
+    const uint32_t SETUP_CHUNK_SIZE = 1024;
+    const uint32_t MAX_CLIPPED_VERTICES = 9;
+    // Triangles are clipped to the near plane and to a guard band this many viewports wide, which keeps snapped
+    // coordinates well inside the exact range of a float.
+    const float GUARD_BAND = 2.0f;
+    const float NEAR_W = 1e-5f;
+    const float LANE_OFFSETS[8] = {0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f};
+
+    struct ClipVertex
+    {
+        float position[4];
+        float varyings[SOFTWARE_MAX_VARYINGS];
+    };
+
+    float planeDistance(const ClipVertex& vertex, uint32_t plane)
+    {
+        const float* p = vertex.position;
+        switch (plane)
+        {
+        case 0:
+            return p[3] - NEAR_W;
+        case 1:
+            return GUARD_BAND * p[3] - p[0];
+        case 2:
+            return GUARD_BAND * p[3] + p[0];
+        case 3:
+            return GUARD_BAND * p[3] - p[1];
+        default:
+            return GUARD_BAND * p[3] + p[1];
+        }
+    }
+
+    ClipVertex interpolate(const ClipVertex& a, const ClipVertex& b, float t, uint32_t varyingCount)
+    {
+        ClipVertex result;
+        for (uint32_t i = 0; i < 4; i++)
+        {
+            result.position[i] = a.position[i] + (b.position[i] - a.position[i]) * t;
+        }
+        for (uint32_t i = 0; i < varyingCount; i++)
+        {
+            result.varyings[i] = a.varyings[i] + (b.varyings[i] - a.varyings[i]) * t;
+        }
+        return result;
+    }
+
+    // Sutherland-Hodgman against one plane; returns the new vertex count.
+    uint32_t clipPolygon(const ClipVertex* input, uint32_t count, uint32_t plane, uint32_t varyingCount,
+                         ClipVertex* pOutput)
+    {
+        uint32_t outputCount = 0;
+        for (uint32_t i = 0; i < count; i++)
+        {
+            const ClipVertex& a = input[i];
+            const ClipVertex& b = input[(i + 1) % count];
+            float distanceA = planeDistance(a, plane);
+            float distanceB = planeDistance(b, plane);
+            if (distanceA >= 0.0f)
+            {
+                pOutput[outputCount++] = a;
+            }
+            if ((distanceA >= 0.0f) != (distanceB >= 0.0f))
+            {
+                pOutput[outputCount++] = interpolate(a, b, distanceA / (distanceA - distanceB), varyingCount);
+            }
+        }
+        return outputCount;
+    }
+
+    float snap(float value)
+    {
+        return roundf(value * SoftwareRasterizer::SUBPIXEL_STEPS) / SoftwareRasterizer::SUBPIXEL_STEPS;
+    }
+}
+
+SoftwareRasterizer::SoftwareRasterizer(ThreadPool* threadPool) : threadPool(threadPool)
+{
+}
+
+void SoftwareRasterizer::drawTriangles(const SoftwareRasterState& state, const SoftwareVertex* vertices,
+                                       const uint32_t* indices, uint32_t triangleCount)
+{
+    stats.triangles += triangleCount;
+    uint32_t chunkCount = (triangleCount + SETUP_CHUNK_SIZE - 1) / SETUP_CHUNK_SIZE;
+    if (setupChunks.size() < chunkCount)
+    {
+        setupChunks.resize(chunkCount);
+    }
+    forEach(chunkCount, [&](uint32_t chunk)
+    {
+        std::vector<Triangle>& output = setupChunks[chunk];
+        output.clear();
+        uint32_t end = std::min((chunk + 1) * SETUP_CHUNK_SIZE, triangleCount);
+        for (uint32_t i = chunk * SETUP_CHUNK_SIZE; i < end; i++)
+        {
+            const SoftwareVertex* corners[3] = {
+                &vertices[indices[i * 3]], &vertices[indices[i * 3 + 1]], &vertices[indices[i * 3 + 2]]
+            };
+            setupTriangle(state, corners, &output);
+        }
+    });
+
+    triangles.clear();
+    for (uint32_t chunk = 0; chunk < chunkCount; chunk++)
+    {
+        for (const Triangle& triangle : setupChunks[chunk])
+        {
+            triangles.push_back(&triangle);
+        }
+    }
+    stats.rasterizedTriangles += triangles.size();
+
+    uint32_t tilesX = (state.width + TILE_SIZE - 1) / TILE_SIZE;
+    uint32_t tilesY = (state.height + TILE_SIZE - 1) / TILE_SIZE;
+    bins.resize(tilesX * tilesY);
+    for (std::vector<uint32_t>& bin : bins)
+    {
+        bin.clear();
+    }
+    for (uint32_t i = 0; i < triangles.size(); i++)
+    {
+        const Triangle& triangle = *triangles[i];
+        for (uint32_t tileY = triangle.minY / TILE_SIZE; tileY <= triangle.maxY / TILE_SIZE; tileY++)
+        {
+            for (uint32_t tileX = triangle.minX / TILE_SIZE; tileX <= triangle.maxX / TILE_SIZE; tileX++)
+            {
+                bins[tileY * tilesX + tileX].push_back(i);
+                stats.binnedTriangles++;
+            }
+        }
+    }
+
+    std::vector<uint32_t> activeTiles;
+    for (uint32_t tile = 0; tile < bins.size(); tile++)
+    {
+        if (!bins[tile].empty())
+        {
+            activeTiles.push_back(tile);
+        }
+    }
+    std::vector<SoftwareRasterStats> tileStats(activeTiles.size());
+    forEach((uint32_t)activeTiles.size(), [&](uint32_t i)
+    {
+        uint32_t tile = activeTiles[i];
+        rasterizeTile(state, tile % tilesX, tile / tilesX, bins[tile], &tileStats[i]);
+    });
+    for (const SoftwareRasterStats& tile : tileStats)
+    {
+        stats.shadedPixels += tile.shadedPixels;
+        stats.depthRejectedPixels += tile.depthRejectedPixels;
+    }
+}
+
+void SoftwareRasterizer::forEach(uint32_t count, const std::function<void(uint32_t)>& body)
+{
+    if (threadPool && count > 1)
+    {
+        threadPool->parallelFor(count, body);
+        return;
+    }
+    for (uint32_t i = 0; i < count; i++)
+    {
+        body(i);
+    }
+}
+
+void SoftwareRasterizer::setThreadPool(ThreadPool* threadPool)
+{
+    this->threadPool = threadPool;
+}
+
+const SoftwareRasterStats& SoftwareRasterizer::getStats() const
+{
+    return stats;
+}
+
+void SoftwareRasterizer::resetStats()
+{
+    stats = SoftwareRasterStats();
+}
+
+void SoftwareRasterizer::setupTriangle(const SoftwareRasterState& state, const SoftwareVertex* const* corners,
+                                       std::vector<Triangle>* pOutput) const
+{
+    ClipVertex polygons[2][MAX_CLIPPED_VERTICES];
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        memcpy(polygons[0][i].position, &corners[i]->position, sizeof(float) * 4);
+        memcpy(polygons[0][i].varyings, corners[i]->varyings, sizeof(float) * state.varyingCount);
+    }
+    uint32_t count = 3;
+    uint32_t current = 0;
+    for (uint32_t plane = 0; plane < 5 && count >= 3; plane++)
+    {
+        uint32_t outside = 0;
+        for (uint32_t i = 0; i < count; i++)
+        {
+            outside += planeDistance(polygons[current][i], plane) < 0.0f ? 1 : 0;
+        }
+        if (outside == 0)
+        {
+            continue;
+        }
+        count = outside == count ? 0 : clipPolygon(polygons[current], count, plane, state.varyingCount,
+                                                   polygons[1 - current]);
+        current = 1 - current;
+    }
+    if (count < 3)
+    {
+        return;
+    }
+
+    float x[MAX_CLIPPED_VERTICES];
+    float y[MAX_CLIPPED_VERTICES];
+    float depth[MAX_CLIPPED_VERTICES];
+    float inverseW[MAX_CLIPPED_VERTICES];
+    const ClipVertex* polygon = polygons[current];
+    for (uint32_t i = 0; i < count; i++)
+    {
+        inverseW[i] = 1.0f / polygon[i].position[3];
+        x[i] = snap((polygon[i].position[0] * inverseW[i] * 0.5f + 0.5f) * state.width);
+        y[i] = snap((0.5f - polygon[i].position[1] * inverseW[i] * 0.5f) * state.height);
+        depth[i] = polygon[i].position[2] * inverseW[i];
+    }
+
+    for (uint32_t fan = 1; fan + 1 < count; fan++)
+    {
+        uint32_t v[3] = {0, fan, fan + 1};
+        float area = (x[v[1]] - x[v[0]]) * (y[v[2]] - y[v[0]]) - (x[v[2]] - x[v[0]]) * (y[v[1]] - y[v[0]]);
+        if (area == 0.0f)
+        {
+            continue;
+        }
+        // Clockwise on the y-down target is front facing, as with FrontCounterClockwise = FALSE.
+        if (area < 0.0f)
+        {
+            if (state.cullMode == RENDER_CULL_BACK)
+            {
+                continue;
+            }
+            std::swap(v[1], v[2]);
+            area = -area;
+        }
+
+        Triangle triangle;
+        float minX = std::min(std::min(x[v[0]], x[v[1]]), x[v[2]]);
+        float maxX = std::max(std::max(x[v[0]], x[v[1]]), x[v[2]]);
+        float minY = std::min(std::min(y[v[0]], y[v[1]]), y[v[2]]);
+        float maxY = std::max(std::max(y[v[0]], y[v[1]]), y[v[2]]);
+        triangle.minX = std::max((int)ceilf(minX - 0.5f), 0);
+        triangle.minY = std::max((int)ceilf(minY - 0.5f), 0);
+        triangle.maxX = std::min((int)floorf(maxX - 0.5f), (int)state.width - 1);
+        triangle.maxY = std::min((int)floorf(maxY - 0.5f), (int)state.height - 1);
+        if (triangle.minX > triangle.maxX || triangle.minY > triangle.maxY)
+        {
+            continue;
+        }
+
+        for (uint32_t i = 0; i < 3; i++)
+        {
+            triangle.x[i] = x[v[i]];
+            triangle.y[i] = y[v[i]];
+            triangle.depth[i] = depth[v[i]];
+            triangle.inverseW[i] = inverseW[v[i]];
+            for (uint32_t j = 0; j < state.varyingCount; j++)
+            {
+                triangle.varyings[i][j] = polygon[v[i]].varyings[j] * inverseW[v[i]];
+            }
+        }
+        for (uint32_t i = 0; i < 3; i++)
+        {
+            uint32_t a = i;
+            uint32_t b = (i + 1) % 3;
+            Edge& edge = triangle.edges[i];
+            float deltaX = triangle.x[b] - triangle.x[a];
+            float deltaY = triangle.y[b] - triangle.y[a];
+            edge.topLeft = deltaY < 0.0f || (deltaY == 0.0f && deltaX > 0.0f);
+            bool reversed = triangle.x[a] > triangle.x[b] || (triangle.x[a] == triangle.x[b] &&
+                                                               triangle.y[a] > triangle.y[b]);
+            uint32_t origin = reversed ? b : a;
+            edge.originX = triangle.x[origin];
+            edge.originY = triangle.y[origin];
+            edge.deltaX = reversed ? -deltaX : deltaX;
+            edge.deltaY = reversed ? -deltaY : deltaY;
+            edge.sign = reversed ? -1.0f : 1.0f;
+        }
+        triangle.inverseArea = 1.0f / area;
+        pOutput->push_back(triangle);
+    }
+}
+
+void SoftwareRasterizer::rasterizeTile(const SoftwareRasterState& state, uint32_t tileX, uint32_t tileY,
+                                       const std::vector<uint32_t>& bin, SoftwareRasterStats* pStats) const
+{
+    int tileMinX = (int)(tileX * TILE_SIZE);
+    int tileMinY = (int)(tileY * TILE_SIZE);
+    int tileMaxX = std::min(tileMinX + (int)TILE_SIZE, (int)state.width) - 1;
+    int tileMaxY = std::min(tileMinY + (int)TILE_SIZE, (int)state.height) - 1;
+    FloatLanes laneOffsets = FloatLanes::load(LANE_OFFSETS);
+    FloatLanes zero = FloatLanes::set(0.0f);
+    float edgeValues[3][FloatLanes::WIDTH];
+
+    for (uint32_t index : bin)
+    {
+        const Triangle& triangle = *triangles[index];
+        int minX = std::max(triangle.minX, tileMinX);
+        int maxX = std::min(triangle.maxX, tileMaxX);
+        int minY = std::max(triangle.minY, tileMinY);
+        int maxY = std::min(triangle.maxY, tileMaxY);
+        for (int y = minY; y <= maxY; y++)
+        {
+            float pixelY = (float)y + 0.5f;
+            FloatLanes rowTerms[3];
+            for (uint32_t i = 0; i < 3; i++)
+            {
+                const Edge& edge = triangle.edges[i];
+                rowTerms[i] = FloatLanes::set(edge.deltaX * (pixelY - edge.originY));
+            }
+            for (int x = minX; x <= maxX; x += FloatLanes::WIDTH)
+            {
+                FloatLanes pixelX = laneOffsets + FloatLanes::set((float)x + 0.5f);
+                int mask = -1;
+                FloatLanes values[3];
+                for (uint32_t i = 0; i < 3; i++)
+                {
+                    const Edge& edge = triangle.edges[i];
+                    FloatLanes raw = rowTerms[i] - FloatLanes::set(edge.deltaY) * (pixelX -
+                                                                                   FloatLanes::set(edge.originX));
+                    values[i] = raw * FloatLanes::set(edge.sign);
+                    mask &= (edge.topLeft ? values[i] >= zero : values[i] > zero).getMask();
+                }
+                if (!mask)
+                {
+                    continue;
+                }
+                for (uint32_t i = 0; i < 3; i++)
+                {
+                    values[i].store(edgeValues[i]);
+                }
+                for (uint32_t lane = 0; lane < FloatLanes::WIDTH && x + (int)lane <= maxX; lane++)
+                {
+                    if (!(mask & (1 << lane)))
+                    {
+                        continue;
+                    }
+                    // Edge i is opposite vertex (i + 2) % 3.
+                    const float weights[3] = {
+                        edgeValues[1][lane] * triangle.inverseArea, edgeValues[2][lane] * triangle.inverseArea,
+                        edgeValues[0][lane] * triangle.inverseArea
+                    };
+                    shadePixel(state, triangle, (uint32_t)(x + lane), (uint32_t)y, weights, pStats);
+                }
+            }
+        }
+    }
+}
+
+void SoftwareRasterizer::shadePixel(const SoftwareRasterState& state, const Triangle& triangle, uint32_t x,
+                                    uint32_t y, const float* weights, SoftwareRasterStats* pStats) const
+{
+    float depth = weights[0] * triangle.depth[0] + weights[1] * triangle.depth[1] + weights[2] * triangle.depth[2];
+    SoftwareTexture* depthTexture = state.depth.texture;
+    Float4 quantizedDepth;
+    if (depthTexture)
+    {
+        quantizedDepth = depthTexture->quantize(RenderMath::makeFloat4(depth, 0.0f, 0.0f, 0.0f));
+        float stored = depthTexture->load(state.depth.slice, state.depth.mip, x, y).x;
+        bool passed = state.depthMode == RENDER_DEPTH_LESS ? quantizedDepth.x < stored : quantizedDepth.x <= stored;
+        if (depth < 0.0f || depth > 1.0f || !passed)
+        {
+            pStats->depthRejectedPixels++;
+            return;
+        }
+    }
+
+    float inverseW = weights[0] * triangle.inverseW[0] + weights[1] * triangle.inverseW[1] +
+        weights[2] * triangle.inverseW[2];
+    float w = 1.0f / inverseW;
+    float varyings[SOFTWARE_MAX_VARYINGS];
+    for (uint32_t i = 0; i < state.varyingCount; i++)
+    {
+        varyings[i] = (weights[0] * triangle.varyings[0][i] + weights[1] * triangle.varyings[1][i] +
+            weights[2] * triangle.varyings[2][i]) * w;
+    }
+
+    Float4 outputs[RenderPassDesc::MAX_COLOR_ATTACHMENTS];
+    state.pixelShader(*state.pixelBindings, varyings, outputs);
+    pStats->shadedPixels++;
+    for (uint32_t i = 0; i < state.colorCount; i++)
+    {
+        const SoftwareRenderTarget& target = state.colors[i];
+        target.texture->store(target.slice, target.mip, x, y, outputs[i]);
+    }
+    if (depthTexture)
+    {
+        depthTexture->store(state.depth.slice, state.depth.mip, x, y, quantizedDepth);
+    }
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "SoftwareShaders.h"
+#include "SoftwareTexture.h"
+
+class ThreadPool;
+
+struct SoftwareRenderTarget
+{
+    SoftwareTexture* texture = nullptr;
+    uint32_t mip = 0;
+    uint32_t slice = 0;
+};
+
+// Everything a draw needs past the vertex shader.
+struct SoftwareRasterState
+{
+    SoftwareRenderTarget colors[RenderPassDesc::MAX_COLOR_ATTACHMENTS];
+    uint32_t colorCount = 0;
+    SoftwareRenderTarget depth;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    RenderDepthMode depthMode = RENDER_DEPTH_LESS;
+    RenderCullMode cullMode = RENDER_CULL_BACK;
+    SoftwarePixelShader pixelShader = nullptr;
+    const SoftwareBindings* pixelBindings = nullptr;
+    uint32_t varyingCount = 0;
+};
+
+struct SoftwareRasterStats
+{
+    uint64_t triangles = 0;
+    // Left after culling and clipping; a clipped triangle can become several.
+    uint64_t rasterizedTriangles = 0;
+    uint64_t binnedTriangles = 0;
+    uint64_t shadedPixels = 0;
+    uint64_t depthRejectedPixels = 0;
+};
+
+// Tile-based rasterizer. Triangles are set up and clipped in parallel, binned into TILE_SIZE tiles and then every
+// tile is rasterized by one worker, walking its bin in submission order. A pixel therefore always sees primitives in
+// API order and the image does not depend on the thread count. Coverage is evaluated FloatLanes::WIDTH pixels at a
+// time with the D3D top-left fill rule on positions snapped to 1/256 pixel.
+class SoftwareRasterizer
+{
+public:
+    static const uint32_t TILE_SIZE = 32;
+    static const uint32_t SUBPIXEL_STEPS = 256;
+
+    // Without a pool everything runs on the calling thread.
+    explicit SoftwareRasterizer(ThreadPool* threadPool);
+
+    // Vertices are in clip space; every three indices form a triangle.
+    void drawTriangles(const SoftwareRasterState& state, const SoftwareVertex* vertices, const uint32_t* indices,
+                       uint32_t triangleCount);
+    void forEach(uint32_t count, const std::function<void(uint32_t)>& body);
+    void setThreadPool(ThreadPool* threadPool);
+
+    const SoftwareRasterStats& getStats() const;
+    void resetStats();
+
+private:
+    struct Edge
+    {
+        // Relative to the lexicographically smaller endpoint, so both triangles sharing an edge get exactly
+        // opposite values and no pixel on it is drawn twice or skipped.
+        float originX;
+        float originY;
+        float deltaX;
+        float deltaY;
+        float sign;
+        bool topLeft;
+    };
+
+    struct Triangle
+    {
+        Edge edges[3];
+        float x[3];
+        float y[3];
+        float depth[3];
+        float inverseW[3];
+        // Pre-divided by w for perspective-correct interpolation.
+        float varyings[3][SOFTWARE_MAX_VARYINGS];
+        float inverseArea;
+        int minX;
+        int minY;
+        int maxX;
+        int maxY;
+    };
+
+    ThreadPool* threadPool;
+    SoftwareRasterStats stats;
+    std::vector<std::vector<Triangle>> setupChunks;
+    std::vector<const Triangle*> triangles;
+    std::vector<std::vector<uint32_t>> bins;
+
+    void setupTriangle(const SoftwareRasterState& state, const SoftwareVertex* const* corners,
+                       std::vector<Triangle>* pOutput) const;
+    void rasterizeTile(const SoftwareRasterState& state, uint32_t tileX, uint32_t tileY,
+                       const std::vector<uint32_t>& bin, SoftwareRasterStats* pStats) const;
+    void shadePixel(const SoftwareRasterState& state, const Triangle& triangle, uint32_t x, uint32_t y,
+                    const float* weights, SoftwareRasterStats* pStats) const;
+};
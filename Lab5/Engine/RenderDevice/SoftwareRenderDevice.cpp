@@ -0,0 +1,798 @@
+#include "SoftwareRenderDevice.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+
+#include "../../Utils/HalfFloat.h"
+#include "../../Utils/MemoryAccounting.h"
+#include "../../Utils/ThreadPool.h"
+
+namespace
+{
+    // Vertices shaded per batch of instances; bounds the memory a large instanced draw needs.
+    const uint32_t BATCH_VERTICES = 65536;
+    const uint32_t VERTEX_CHUNK_SIZE = 256;
+
+    uint32_t resolveThreadCount(uint32_t threadCount)
+    {
+        if (threadCount)
+        {
+            return threadCount;
+        }
+        return std::max(std::thread::hardware_concurrency(), 1u);
+    }
+
+    bool isVertexFormat(RenderFormat format)
+    {
+        switch (format)
+        {
+        case RENDER_FORMAT_R8G8B8A8_UNORM:
+        case RENDER_FORMAT_R16G16_FLOAT:
+        case RENDER_FORMAT_R16G16B16A16_FLOAT:
+        case RENDER_FORMAT_R16G16_SNORM:
+        case RENDER_FORMAT_R16G16B16A16_SNORM:
+        case RENDER_FORMAT_R32_FLOAT:
+        case RENDER_FORMAT_R32G32_FLOAT:
+        case RENDER_FORMAT_R32G32B32_FLOAT:
+        case RENDER_FORMAT_R32G32B32A32_FLOAT:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    // The conversion the input assembler applies: UNORM and SNORM to [0, 1] and [-1, 1], halves to floats.
+    Float4 readAttribute(RenderFormat format, const uint8_t* data)
+    {
+        float values[4] = {0.0f, 0.0f, 0.0f, 1.0f};
+        switch (format)
+        {
+        case RENDER_FORMAT_R8G8B8A8_UNORM:
+            for (int i = 0; i < 4; i++)
+            {
+                values[i] = data[i] / 255.0f;
+            }
+            break;
+        case RENDER_FORMAT_R16G16_FLOAT:
+        case RENDER_FORMAT_R16G16B16A16_FLOAT:
+            for (int i = 0; i < (format == RENDER_FORMAT_R16G16_FLOAT ? 2 : 4); i++)
+            {
+                uint16_t half;
+                memcpy(&half, data + i * 2, sizeof(half));
+                values[i] = HalfFloat::toFloat(half);
+            }
+            break;
+        case RENDER_FORMAT_R16G16_SNORM:
+        case RENDER_FORMAT_R16G16B16A16_SNORM:
+            for (int i = 0; i < (format == RENDER_FORMAT_R16G16_SNORM ? 2 : 4); i++)
+            {
+                int16_t value;
+                memcpy(&value, data + i * 2, sizeof(value));
+                values[i] = std::max(value / 32767.0f, -1.0f);
+            }
+            break;
+        default:
+            memcpy(values, data, RenderDevice::getBytesPerPixel(format));
+            break;
+        }
+        return RenderMath::makeFloat4(values[0], values[1], values[2], values[3]);
+    }
+}
+
+SoftwareRenderDevice::SoftwareRenderDevice(uint32_t threadCount) : rasterizer(nullptr)
+{
+    setThreadCount(threadCount);
+}
+
+SoftwareRenderDevice::~SoftwareRenderDevice()
+{
+    textures.forEach([](uint32_t, TextureEntry& texture)
+    {
+        MemoryAccounting::release(texture.memoryCategory, texture.bytes);
+    });
+    buffers.forEach([](uint32_t, BufferEntry& buffer)
+    {
+        MemoryAccounting::release(buffer.memoryCategory, buffer.desc.size);
+    });
+}
+
+RenderTexture SoftwareRenderDevice::createTexture(const RenderTextureDesc& desc, const void* const* initialData)
+{
+    if (desc.width == 0 || desc.height == 0 || desc.mipLevels == 0 || desc.arraySize == 0)
+    {
+        throw std::runtime_error("Failed to create texture: empty description");
+    }
+    if (desc.cube && desc.arraySize % 6 != 0)
+    {
+        throw std::runtime_error("Failed to create texture: cube textures need six slices per cube");
+    }
+    if ((desc.bindFlags & RENDER_BIND_DEPTH_STENCIL) && desc.format != RENDER_FORMAT_D24_UNORM_S8_UINT)
+    {
+        throw std::runtime_error("Failed to create texture: depth stencil needs a depth format");
+    }
+
+    RenderTextureDesc textureDesc = desc;
+    textureDesc.name = nullptr;
+    textureDesc.memoryCategory = nullptr;
+    TextureEntry entry;
+    entry.texture = std::make_shared<SoftwareTexture>(textureDesc);
+    entry.memoryCategory = desc.memoryCategory;
+    entry.bytes = getTextureBytes(desc);
+    if (initialData)
+    {
+        for (uint32_t slice = 0; slice < desc.arraySize; slice++)
+        {
+            for (uint32_t mip = 0; mip < desc.mipLevels; mip++)
+            {
+                const void* data = initialData[slice * desc.mipLevels + mip];
+                if (!data)
+                {
+                    throw std::runtime_error("Failed to create texture: missing initial data for a subresource");
+                }
+                entry.texture->upload(slice, mip, data);
+            }
+        }
+    }
+    MemoryAccounting::allocate(entry.memoryCategory, entry.bytes);
+    return textures.insert(entry);
+}
+
+RenderBuffer SoftwareRenderDevice::createBuffer(const RenderBufferDesc& desc, const void* initialData)
+{
+    if (desc.size == 0)
+    {
+        throw std::runtime_error("Failed to create buffer: empty description");
+    }
+    bool needsData = desc.type == RENDER_BUFFER_VERTEX || desc.type == RENDER_BUFFER_INDEX;
+    if (needsData && !initialData)
+    {
+        throw std::runtime_error("Failed to create buffer: vertex and index buffers need initial data");
+    }
+    if (desc.type == RENDER_BUFFER_INDEX && desc.stride != 2 && desc.stride != 4)
+    {
+        throw std::runtime_error("Failed to create buffer: indices must be 16 or 32 bits");
+    }
+    if ((desc.type == RENDER_BUFFER_STRUCTURED || desc.type == RENDER_BUFFER_VERTEX ||
+            desc.type == RENDER_BUFFER_INSTANCE) && (desc.stride == 0 || desc.size % desc.stride != 0))
+    {
+        throw std::runtime_error("Failed to create buffer: size is not a multiple of the stride");
+    }
+
+    BufferEntry entry;
+    entry.desc = desc;
+    entry.desc.name = nullptr;
+    entry.desc.memoryCategory = nullptr;
+    entry.memoryCategory = desc.memoryCategory;
+    // Constant buffers are padded to whole registers so a port can read its last float4.
+    entry.data.assign(desc.type == RENDER_BUFFER_CONSTANT ? (desc.size + 15) / 16 * 16 : desc.size, 0);
+    if (initialData)
+    {
+        memcpy(entry.data.data(), initialData, desc.size);
+    }
+    MemoryAccounting::allocate(entry.memoryCategory, desc.size);
+    return buffers.insert(entry);
+}
+
+void SoftwareRenderDevice::requestShader(const RenderShaderDesc& desc)
+{
+    if (!desc.path)
+    {
+        throw std::runtime_error("Failed to request shader: no path");
+    }
+}
+
+RenderShader SoftwareRenderDevice::createShader(const RenderShaderDesc& desc)
+{
+    requestShader(desc);
+    const SoftwareProgram* program = SoftwareShaders::find(desc.path);
+    if (!program)
+    {
+        throw std::runtime_error("Failed to create shader: no software port of the program");
+    }
+    if (program->stage != desc.stage)
+    {
+        throw std::runtime_error("Failed to create shader: the program is for another stage");
+    }
+    ShaderEntry entry;
+    entry.program = program;
+    for (uint32_t i = 0; i < desc.attributeCount; i++)
+    {
+        if (!isVertexFormat(desc.attributes[i].format))
+        {
+            throw std::runtime_error("Failed to create shader: unsupported vertex attribute format");
+        }
+        if (desc.attributes[i].slot == 0 && !desc.attributes[i].perInstance)
+        {
+            entry.attributes.push_back(desc.attributes[i]);
+        }
+    }
+    return shaders.insert(entry);
+}
+
+RenderSampler SoftwareRenderDevice::createSampler(RenderFilter filter, RenderAddressMode addressMode)
+{
+    SoftwareSampler sampler;
+    sampler.filter = filter;
+    sampler.addressMode = addressMode;
+    return samplers.insert(sampler);
+}
+
+RenderReadback SoftwareRenderDevice::createReadback(const RenderTextureDesc& desc)
+{
+    ReadbackEntry readback;
+    readback.desc = desc;
+    readback.desc.name = nullptr;
+    readback.desc.memoryCategory = nullptr;
+    readback.data.resize(RenderDevice::getBytesPerPixel(desc.format) * (size_t)desc.width * desc.height);
+    return readbacks.insert(readback);
+}
+
+void SoftwareRenderDevice::destroyTexture(RenderTexture texture)
+{
+    TextureEntry entry = textures.remove(texture);
+    MemoryAccounting::release(entry.memoryCategory, entry.bytes);
+}
+
+void SoftwareRenderDevice::destroyBuffer(RenderBuffer buffer)
+{
+    BufferEntry entry = buffers.remove(buffer);
+    MemoryAccounting::release(entry.memoryCategory, entry.desc.size);
+}
+
+void SoftwareRenderDevice::destroyShader(RenderShader shader)
+{
+    shaders.remove(shader);
+}
+
+void SoftwareRenderDevice::destroySampler(RenderSampler sampler)
+{
+    samplers.remove(sampler);
+}
+
+void SoftwareRenderDevice::destroyReadback(RenderReadback readback)
+{
+    readbacks.remove(readback);
+}
+
+void SoftwareRenderDevice::beginFrame()
+{
+    if (inFrame)
+    {
+        throw std::runtime_error("Failed to begin frame: the previous frame was not ended");
+    }
+    inFrame = true;
+    rasterizer.resetStats();
+}
+
+void SoftwareRenderDevice::endFrame()
+{
+    if (!inFrame || inPass || scopeDepth)
+    {
+        throw std::runtime_error("Failed to end frame: unbalanced frame, pass or scope");
+    }
+    inFrame = false;
+}
+
+void SoftwareRenderDevice::beginScope(const char*)
+{
+    scopeDepth++;
+}
+
+void SoftwareRenderDevice::endScope()
+{
+    if (!scopeDepth)
+    {
+        throw std::runtime_error("Failed to end scope: no scope is open");
+    }
+    scopeDepth--;
+}
+
+void SoftwareRenderDevice::beginPass(const RenderPassDesc& desc)
+{
+    if (inPass)
+    {
+        throw std::runtime_error("Failed to begin pass: passes cannot nest");
+    }
+    if (desc.colorCount > RenderPassDesc::MAX_COLOR_ATTACHMENTS || (!desc.colorCount && !desc.depth.texture))
+    {
+        throw std::runtime_error("Failed to begin pass: invalid attachment count");
+    }
+    const RenderAttachment& first = desc.colorCount ? desc.colors[0] : desc.depth;
+    const SoftwareTexture& firstTexture = *textures.get(first.texture).texture;
+    uint32_t width = firstTexture.getWidth(first.mip);
+    uint32_t height = firstTexture.getHeight(first.mip);
+    for (uint32_t i = 0; i <= desc.colorCount; i++)
+    {
+        const RenderAttachment& attachment = i < desc.colorCount ? desc.colors[i] : desc.depth;
+        if (i == desc.colorCount && !attachment.texture)
+        {
+            break;
+        }
+        validateAttachment(attachment, i < desc.colorCount ? RENDER_BIND_RENDER_TARGET : RENDER_BIND_DEPTH_STENCIL);
+        const SoftwareTexture& texture = *textures.get(attachment.texture).texture;
+        if (texture.getWidth(attachment.mip) != width || texture.getHeight(attachment.mip) != height)
+        {
+            throw std::runtime_error("Failed to begin pass: attachments differ in size");
+        }
+    }
+    if (desc.clearDepth && !desc.depth.texture)
+    {
+        throw std::runtime_error("Failed to begin pass: depth clear without a depth attachment");
+    }
+
+    inPass = true;
+    pass = desc;
+    if (desc.clearColor)
+    {
+        Float4 value = RenderMath::makeFloat4(desc.clearValue[0], desc.clearValue[1], desc.clearValue[2],
+                                              desc.clearValue[3]);
+        for (uint32_t i = 0; i < desc.colorCount; i++)
+        {
+            textures.get(desc.colors[i].texture).texture->clear(desc.colors[i].slice, desc.colors[i].mip, value);
+        }
+    }
+    if (desc.clearDepth)
+    {
+        textures.get(desc.depth.texture).texture->clear(desc.depth.slice, desc.depth.mip,
+                                                       RenderMath::makeFloat4(1.0f, 0.0f, 0.0f, 0.0f));
+    }
+}
+
+void SoftwareRenderDevice::endPass()
+{
+    if (!inPass)
+    {
+        throw std::runtime_error("Failed to end pass: no pass is open");
+    }
+    inPass = false;
+}
+
+void SoftwareRenderDevice::setPipeline(const RenderPipelineDesc& desc)
+{
+    if (shaders.get(desc.vertexShader).program->stage != RENDER_STAGE_VERTEX ||
+        shaders.get(desc.pixelShader).program->stage != RENDER_STAGE_PIXEL)
+    {
+        throw std::runtime_error("Failed to set pipeline: shader stages do not match");
+    }
+    pipeline = desc;
+}
+
+void SoftwareRenderDevice::setComputeShader(RenderShader shader)
+{
+    if (shader && shaders.get(shader).program->stage != RENDER_STAGE_COMPUTE)
+    {
+        throw std::runtime_error("Failed to set compute shader: not a compute shader");
+    }
+    computeShader = shader;
+}
+
+void SoftwareRenderDevice::setTextures(RenderShaderStage stage, uint32_t slot, uint32_t count,
+                                       const RenderTexture* textures)
+{
+    checkSlots("textures", slot, count, SOFTWARE_TEXTURE_SLOTS);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        if (textures[i] && !(this->textures.get(textures[i]).texture->getDesc().bindFlags &
+                                RENDER_BIND_SHADER_RESOURCE))
+        {
+            throw std::runtime_error("Failed to bind textures: texture was not created for this use");
+        }
+        stages[stage].textures[slot + i] = textures[i];
+    }
+}
+
+void SoftwareRenderDevice::setBuffers(RenderShaderStage stage, uint32_t slot, uint32_t count,
+                                      const RenderBuffer* buffers)
+{
+    checkSlots("buffers", slot, count, SOFTWARE_TEXTURE_SLOTS);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        if (buffers[i])
+        {
+            requireBuffer(buffers[i], RENDER_BUFFER_STRUCTURED, "Failed to bind buffers: wrong buffer type");
+        }
+        stages[stage].buffers[slot + i] = buffers[i];
+    }
+}
+
+void SoftwareRenderDevice::setStorageTextures(uint32_t slot, uint32_t count, const RenderTexture* textures)
+{
+    if (inPass)
+    {
+        throw std::runtime_error("Failed to bind storage textures: compute bindings inside a pass");
+    }
+    checkSlots("storage textures", slot, count, SOFTWARE_STORAGE_SLOTS);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        if (textures[i] && !(this->textures.get(textures[i]).texture->getDesc().bindFlags &
+                                RENDER_BIND_UNORDERED_ACCESS))
+        {
+            throw std::runtime_error("Failed to bind storage textures: texture was not created for this use");
+        }
+        storageTextures[slot + i] = textures[i];
+    }
+}
+
+void SoftwareRenderDevice::setStorageBuffers(uint32_t slot, uint32_t count, const RenderBuffer* buffers)
+{
+    if (inPass)
+    {
+        throw std::runtime_error("Failed to bind storage buffers: compute bindings inside a pass");
+    }
+    checkSlots("storage buffers", slot, count, SOFTWARE_STORAGE_SLOTS);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        if (buffers[i])
+        {
+            requireBuffer(buffers[i], RENDER_BUFFER_STRUCTURED, "Failed to bind storage buffers: wrong buffer type");
+        }
+        storageBuffers[slot + i] = buffers[i];
+    }
+}
+
+void SoftwareRenderDevice::setSamplers(RenderShaderStage stage, uint32_t slot, uint32_t count,
+                                       const RenderSampler* samplers)
+{
+    checkSlots("samplers", slot, count, SOFTWARE_SAMPLER_SLOTS);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        this->samplers.get(samplers[i]);
+        stages[stage].samplers[slot + i] = samplers[i];
+    }
+}
+
+void SoftwareRenderDevice::setConstantBuffer(RenderShaderStage stage, uint32_t slot, RenderBuffer buffer)
+{
+    checkSlots("constant buffer", slot, 1, SOFTWARE_CONSTANT_SLOTS);
+    requireBuffer(buffer, RENDER_BUFFER_CONSTANT, "Failed to bind constant buffer: not a constant buffer");
+    stages[stage].constants[slot] = buffer;
+}
+
+void SoftwareRenderDevice::updateBuffer(RenderBuffer buffer, const void* data, uint32_t size)
+{
+    BufferEntry& entry = buffers.get(buffer);
+    if (size > entry.desc.size)
+    {
+        throw std::runtime_error("Failed to update buffer: data is larger than the buffer");
+    }
+    if (entry.desc.type != RENDER_BUFFER_CONSTANT && entry.desc.type != RENDER_BUFFER_INSTANCE &&
+        entry.desc.type != RENDER_BUFFER_STRUCTURED)
+    {
+        throw std::runtime_error("Failed to update buffer: only constant, instance and structured buffers are dynamic");
+    }
+    memcpy(entry.data.data(), data, size);
+}
+
+void SoftwareRenderDevice::clearStorageBuffer(RenderBuffer buffer)
+{
+    requireBuffer(buffer, RENDER_BUFFER_STRUCTURED, "Failed to clear buffer: not a structured buffer");
+    std::vector<uint8_t>& data = buffers.get(buffer).data;
+    std::fill(data.begin(), data.end(), 0);
+}
+
+void SoftwareRenderDevice::draw(uint32_t vertexCount, uint32_t instanceCount)
+{
+    if (!inPass || !pipeline.vertexShader)
+    {
+        throw std::runtime_error("Failed to draw: no pass or pipeline is bound");
+    }
+    const ShaderEntry& vertexShader = shaders.get(pipeline.vertexShader);
+    const SoftwareProgram& pixelProgram = *shaders.get(pipeline.pixelShader).program;
+    SoftwareBindings vertexBindings = resolveBindings(RENDER_STAGE_VERTEX);
+    SoftwareBindings pixelBindings = resolveBindings(RENDER_STAGE_PIXEL);
+    SoftwareRasterState state = makeRasterState(*vertexShader.program, pixelProgram, &pixelBindings);
+
+    uint32_t batchInstances = std::max(BATCH_VERTICES / std::max(vertexCount, 1u), 1u);
+    for (uint32_t firstInstance = 0; firstInstance < instanceCount; firstInstance += batchInstances)
+    {
+        uint32_t batchCount = std::min(batchInstances, instanceCount - firstInstance);
+        shadeVertices(vertexShader, vertexBindings, nullptr, 0, vertexCount, nullptr, 0, firstInstance, batchCount);
+        indices.resize((size_t)batchCount * vertexCount);
+        for (uint32_t i = 0; i < indices.size(); i++)
+        {
+            indices[i] = i;
+        }
+        rasterizer.drawTriangles(state, vertices.data(), indices.data(), (uint32_t)indices.size() / 3);
+    }
+}
+
+void SoftwareRenderDevice::drawIndexed(RenderBuffer vertexBuffer, RenderBuffer indexBuffer, uint32_t indexCount,
+                                       RenderBuffer instanceBuffer, uint32_t instanceCount)
+{
+    if (!inPass || !pipeline.vertexShader)
+    {
+        throw std::runtime_error("Failed to draw: no pass or pipeline is bound");
+    }
+    const BufferEntry& vertexEntry = requireBuffer(vertexBuffer, RENDER_BUFFER_VERTEX,
+                                                   "Failed to draw: not a vertex buffer");
+    const BufferEntry& indexEntry = requireBuffer(indexBuffer, RENDER_BUFFER_INDEX,
+                                                  "Failed to draw: not an index buffer");
+    if ((uint64_t)indexCount * indexEntry.desc.stride > indexEntry.desc.size)
+    {
+        throw std::runtime_error("Failed to draw: index count exceeds the index buffer");
+    }
+    const BufferEntry* instanceEntry = nullptr;
+    if (instanceBuffer)
+    {
+        instanceEntry = &requireBuffer(instanceBuffer, RENDER_BUFFER_INSTANCE,
+                                       "Failed to draw: not an instance buffer");
+        if ((uint64_t)instanceCount * instanceEntry->desc.stride > instanceEntry->desc.size)
+        {
+            throw std::runtime_error("Failed to draw: instance count exceeds the instance buffer");
+        }
+    }
+    else if (instanceCount != 1)
+    {
+        throw std::runtime_error("Failed to draw: instancing without an instance buffer");
+    }
+
+    uint32_t vertexCount = vertexEntry.desc.size / vertexEntry.desc.stride;
+    std::vector<uint32_t> sourceIndices(indexCount);
+    for (uint32_t i = 0; i < indexCount; i++)
+    {
+        if (indexEntry.desc.stride == 2)
+        {
+            sourceIndices[i] = ((const uint16_t*)indexEntry.data.data())[i];
+        }
+        else
+        {
+            sourceIndices[i] = ((const uint32_t*)indexEntry.data.data())[i];
+        }
+        if (sourceIndices[i] >= vertexCount)
+        {
+            throw std::runtime_error("Failed to draw: index outside the vertex buffer");
+        }
+    }
+
+    const ShaderEntry& vertexShader = shaders.get(pipeline.vertexShader);
+    const SoftwareProgram& pixelProgram = *shaders.get(pipeline.pixelShader).program;
+    SoftwareBindings vertexBindings = resolveBindings(RENDER_STAGE_VERTEX);
+    SoftwareBindings pixelBindings = resolveBindings(RENDER_STAGE_PIXEL);
+    SoftwareRasterState state = makeRasterState(*vertexShader.program, pixelProgram, &pixelBindings);
+    assembleVertices(vertexShader, vertexEntry.data.data(), vertexEntry.desc.stride, vertexCount);
+
+    uint32_t batchInstances = std::max(BATCH_VERTICES / vertexCount, 1u);
+    for (uint32_t firstInstance = 0; firstInstance < instanceCount; firstInstance += batchInstances)
+    {
+        uint32_t batchCount = std::min(batchInstances, instanceCount - firstInstance);
+        shadeVertices(vertexShader, vertexBindings, vertexEntry.data.data(), vertexEntry.desc.stride, vertexCount,
+                      instanceEntry ? instanceEntry->data.data() : nullptr,
+                      instanceEntry ? instanceEntry->desc.stride : 0, firstInstance, batchCount);
+        indices.resize((size_t)batchCount * indexCount);
+        for (uint32_t instance = 0; instance < batchCount; instance++)
+        {
+            for (uint32_t i = 0; i < indexCount; i++)
+            {
+                indices[(size_t)instance * indexCount + i] = instance * vertexCount + sourceIndices[i];
+            }
+        }
+        rasterizer.drawTriangles(state, vertices.data(), indices.data(), batchCount * (indexCount / 3));
+    }
+}
+
+void SoftwareRenderDevice::dispatch(uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ)
+{
+    if (inPass || !computeShader)
+    {
+        throw std::runtime_error("Failed to dispatch: no compute shader bound or a pass is open");
+    }
+    SoftwareBindings bindings = resolveBindings(RENDER_STAGE_COMPUTE);
+    shaders.get(computeShader).program->computeShader(bindings, groupCountX, groupCountY, groupCountZ);
+}
+
+void SoftwareRenderDevice::copyToReadback(RenderReadback readback, RenderTexture texture)
+{
+    ReadbackEntry& entry = readbacks.get(readback);
+    const SoftwareTexture& source = *textures.get(texture).texture;
+    const RenderTextureDesc& sourceDesc = source.getDesc();
+    if (sourceDesc.width != entry.desc.width || sourceDesc.height != entry.desc.height ||
+        sourceDesc.format != entry.desc.format)
+    {
+        throw std::runtime_error("Failed to copy to readback: texture does not match the readback");
+    }
+    if (entry.pending)
+    {
+        throw std::runtime_error("Failed to copy to readback: previous copy not read yet");
+    }
+    source.download(0, 0, entry.data.data());
+    entry.pending = true;
+}
+
+bool SoftwareRenderDevice::readReadback(RenderReadback readback, void* data, uint32_t size)
+{
+    ReadbackEntry& entry = readbacks.get(readback);
+    if (!entry.pending)
+    {
+        return false;
+    }
+    if (size > entry.data.size())
+    {
+        throw std::runtime_error("Failed to read readback: requested more than the texture holds");
+    }
+    memcpy(data, entry.data.data(), size);
+    entry.pending = false;
+    return true;
+}
+
+const SoftwareTexture& SoftwareRenderDevice::getTexture(RenderTexture texture) const
+{
+    return *textures.get(texture).texture;
+}
+
+void SoftwareRenderDevice::setThreadCount(uint32_t threadCount)
+{
+    this->threadCount = resolveThreadCount(threadCount);
+    // parallelFor also runs work on the calling thread.
+    threadPool.reset(this->threadCount > 1 ? new ThreadPool(this->threadCount - 1) : nullptr);
+    rasterizer.setThreadPool(threadPool.get());
+}
+
+uint32_t SoftwareRenderDevice::getThreadCount() const
+{
+    return threadCount;
+}
+
+const SoftwareRasterStats& SoftwareRenderDevice::getRasterStats() const
+{
+    return rasterizer.getStats();
+}
+
+SoftwareBindings SoftwareRenderDevice::resolveBindings(RenderShaderStage stage)
+{
+    // A slot still naming a destroyed resource reads as unbound; the renderer frees temporary textures without
+    // clearing the slots they were bound to.
+    auto findTexture = [this](RenderTexture texture)
+    {
+        return textures.contains(texture) ? textures.get(texture).texture.get() : nullptr;
+    };
+    auto findBuffer = [this](RenderBuffer buffer)
+    {
+        return buffers.contains(buffer) ? &buffers.get(buffer).data : nullptr;
+    };
+    const StageState& state = stages[stage];
+    SoftwareBindings bindings;
+    for (uint32_t i = 0; i < SOFTWARE_TEXTURE_SLOTS; i++)
+    {
+        bindings.textures[i] = findTexture(state.textures[i]);
+        bindings.buffers[i] = findBuffer(state.buffers[i]);
+    }
+    for (uint32_t i = 0; i < SOFTWARE_SAMPLER_SLOTS; i++)
+    {
+        if (samplers.contains(state.samplers[i]))
+        {
+            bindings.samplers[i] = samplers.get(state.samplers[i]);
+        }
+    }
+    for (uint32_t i = 0; i < SOFTWARE_CONSTANT_SLOTS; i++)
+    {
+        const std::vector<uint8_t>* constants = findBuffer(state.constants[i]);
+        bindings.constants[i] = constants ? constants->data() : nullptr;
+    }
+    for (uint32_t i = 0; stage == RENDER_STAGE_COMPUTE && i < SOFTWARE_STORAGE_SLOTS; i++)
+    {
+        bindings.storageBuffers[i] = findBuffer(storageBuffers[i]);
+        bindings.storageTextures[i] = findTexture(storageTextures[i]);
+    }
+    bindings.threadPool = threadPool.get();
+    return bindings;
+}
+
+SoftwareRasterState SoftwareRenderDevice::makeRasterState(const SoftwareProgram& vertexProgram,
+                                                          const SoftwareProgram& pixelProgram,
+                                                          const SoftwareBindings* pixelBindings)
+{
+    SoftwareRasterState state;
+    for (uint32_t i = 0; i < pass.colorCount; i++)
+    {
+        state.colors[i].texture = textures.get(pass.colors[i].texture).texture.get();
+        state.colors[i].mip = pass.colors[i].mip;
+        state.colors[i].slice = pass.colors[i].slice;
+    }
+    state.colorCount = pass.colorCount;
+    if (pass.depth.texture)
+    {
+        state.depth.texture = textures.get(pass.depth.texture).texture.get();
+        state.depth.mip = pass.depth.mip;
+        state.depth.slice = pass.depth.slice;
+    }
+    const SoftwareRenderTarget& first = pass.colorCount ? state.colors[0] : state.depth;
+    state.width = first.texture->getWidth(first.mip);
+    state.height = first.texture->getHeight(first.mip);
+    state.depthMode = pipeline.depthMode;
+    state.cullMode = pipeline.cullMode;
+    state.pixelShader = pixelProgram.pixelShader;
+    state.pixelBindings = pixelBindings;
+    state.varyingCount = vertexProgram.varyingCount;
+    return state;
+}
+
+// Attributes are packed in declaration order, as D3D11_APPEND_ALIGNED_ELEMENT lays them out.
+void SoftwareRenderDevice::assembleVertices(const ShaderEntry& shader, const uint8_t* vertexData,
+                                            uint32_t vertexStride, uint32_t vertexCount)
+{
+    uint32_t attributeCount = (uint32_t)shader.attributes.size();
+    std::vector<uint32_t> offsets(attributeCount);
+    uint32_t size = 0;
+    for (uint32_t i = 0; i < attributeCount; i++)
+    {
+        offsets[i] = size;
+        size += RenderDevice::getBytesPerPixel(shader.attributes[i].format);
+    }
+    if (size > vertexStride)
+    {
+        throw std::runtime_error("Failed to draw: vertex attributes exceed the vertex stride");
+    }
+    vertexAttributes.resize((size_t)vertexCount * attributeCount);
+    rasterizer.forEach((vertexCount + VERTEX_CHUNK_SIZE - 1) / VERTEX_CHUNK_SIZE, [&](uint32_t chunk)
+    {
+        uint32_t end = std::min((chunk + 1) * VERTEX_CHUNK_SIZE, vertexCount);
+        for (uint32_t vertex = chunk * VERTEX_CHUNK_SIZE; vertex < end; vertex++)
+        {
+            const uint8_t* element = vertexData + (size_t)vertex * vertexStride;
+            for (uint32_t i = 0; i < attributeCount; i++)
+            {
+                vertexAttributes[(size_t)vertex * attributeCount + i] =
+                    readAttribute(shader.attributes[i].format, element + offsets[i]);
+            }
+        }
+    });
+}
+
+void SoftwareRenderDevice::shadeVertices(const ShaderEntry& shader, const SoftwareBindings& bindings,
+                                         const uint8_t* vertexData, uint32_t vertexStride, uint32_t vertexCount,
+                                         const uint8_t* instanceData, uint32_t instanceStride,
+                                         uint32_t firstInstance, uint32_t instanceCount)
+{
+    uint32_t attributeCount = vertexData ? (uint32_t)shader.attributes.size() : 0;
+    uint32_t total = vertexCount * instanceCount;
+    vertices.resize(total);
+    rasterizer.forEach((total + VERTEX_CHUNK_SIZE - 1) / VERTEX_CHUNK_SIZE, [&](uint32_t chunk)
+    {
+        uint32_t end = std::min((chunk + 1) * VERTEX_CHUNK_SIZE, total);
+        for (uint32_t i = chunk * VERTEX_CHUNK_SIZE; i < end; i++)
+        {
+            SoftwareVertexInput input;
+            input.vertexId = i % vertexCount;
+            input.vertex = vertexData ? vertexData + (size_t)input.vertexId * vertexStride : nullptr;
+            uint32_t instance = firstInstance + i / vertexCount;
+            input.instance = instanceData ? instanceData + (size_t)instance * instanceStride : nullptr;
+            input.attributes = attributeCount ? &vertexAttributes[(size_t)input.vertexId * attributeCount] : nullptr;
+            shader.program->vertexShader(bindings, input, &vertices[i]);
+        }
+    });
+}
+
+void SoftwareRenderDevice::checkSlots(const char* kind, uint32_t slot, uint32_t count, uint32_t slotCount) const
+{
+    if (slot + count > slotCount)
+    {
+        throw std::runtime_error(std::string("Failed to bind ") + kind + ": slot out of range");
+    }
+}
+
+void SoftwareRenderDevice::validateAttachment(const RenderAttachment& attachment, uint32_t requiredFlag) const
+{
+    const RenderTextureDesc& desc = textures.get(attachment.texture).texture->getDesc();
+    if (!(desc.bindFlags & requiredFlag))
+    {
+        throw std::runtime_error("Failed to begin pass: attachment was not created for this use");
+    }
+    if (attachment.mip >= desc.mipLevels || attachment.slice >= desc.arraySize)
+    {
+        throw std::runtime_error("Failed to begin pass: attachment subresource out of range");
+    }
+}
+
+const SoftwareRenderDevice::BufferEntry& SoftwareRenderDevice::requireBuffer(RenderBuffer buffer,
+                                                                             RenderBufferType type,
+                                                                             const char* error) const
+{
+    const BufferEntry& entry = buffers.get(buffer);
+    if (entry.desc.type != type)
+    {
+        throw std::runtime_error(error);
+    }
+    return entry;
+}
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "HandleTable.h"
+#include "RenderDevice.h"
+#include "SoftwareRasterizer.h"
+#include "SoftwareShaders.h"
+#include "SoftwareTexture.h"
+
+class ThreadPool;
+
+// Backend that renders on the CPU. Every HLSL program the renderer uses has a C++ port in SoftwareShaders, draws go
+// through the tile-based SoftwareRasterizer and dispatches run their port directly, so frames render on machines
+// without a GPU and the result can be read back pixel for pixel. Work executes as it is submitted and readbacks
+// complete immediately. The output does not depend on the thread count.
+class SoftwareRenderDevice : public RenderDevice
+{
+public:
+    // Zero uses one thread per hardware thread; the calling thread counts as one of them.
+    explicit SoftwareRenderDevice(uint32_t threadCount = 0);
+    ~SoftwareRenderDevice() override;
+
+    RenderTexture createTexture(const RenderTextureDesc& desc, const void* const* initialData = nullptr) override;
+    RenderBuffer createBuffer(const RenderBufferDesc& desc, const void* initialData = nullptr) override;
+    void requestShader(const RenderShaderDesc& desc) override;
+    RenderShader createShader(const RenderShaderDesc& desc) override;
+    RenderSampler createSampler(RenderFilter filter, RenderAddressMode addressMode) override;
+    RenderReadback createReadback(const RenderTextureDesc& desc) override;
+    void destroyTexture(RenderTexture texture) override;
+    void destroyBuffer(RenderBuffer buffer) override;
+    void destroyShader(RenderShader shader) override;
+    void destroySampler(RenderSampler sampler) override;
+    void destroyReadback(RenderReadback readback) override;
+
+    void beginFrame() override;
+    void endFrame() override;
+    void beginScope(const char* name) override;
+    void endScope() override;
+
+    void beginPass(const RenderPassDesc& desc) override;
+    void endPass() override;
+    void setPipeline(const RenderPipelineDesc& desc) override;
+    void setComputeShader(RenderShader shader) override;
+    void setTextures(RenderShaderStage stage, uint32_t slot, uint32_t count, const RenderTexture* textures) override;
+    void setBuffers(RenderShaderStage stage, uint32_t slot, uint32_t count, const RenderBuffer* buffers) override;
+    void setStorageTextures(uint32_t slot, uint32_t count, const RenderTexture* textures) override;
+    void setStorageBuffers(uint32_t slot, uint32_t count, const RenderBuffer* buffers) override;
+    void setSamplers(RenderShaderStage stage, uint32_t slot, uint32_t count, const RenderSampler* samplers) override;
+    void setConstantBuffer(RenderShaderStage stage, uint32_t slot, RenderBuffer buffer) override;
+
+    void updateBuffer(RenderBuffer buffer, const void* data, uint32_t size) override;
+    void clearStorageBuffer(RenderBuffer buffer) override;
+    void draw(uint32_t vertexCount, uint32_t instanceCount = 1) override;
+    void drawIndexed(RenderBuffer vertexBuffer, RenderBuffer indexBuffer, uint32_t indexCount,
+                     RenderBuffer instanceBuffer = RENDER_NULL_HANDLE, uint32_t instanceCount = 1) override;
+    void dispatch(uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ) override;
+
+    void copyToReadback(RenderReadback readback, RenderTexture texture) override;
+    bool readReadback(RenderReadback readback, void* data, uint32_t size) override;
+
+    const SoftwareTexture& getTexture(RenderTexture texture) const;
+    // Changes the thread count between frames while keeping every resource, e.g. to measure scaling on one scene.
+    void setThreadCount(uint32_t threadCount);
+    uint32_t getThreadCount() const;
+    // Counted since beginFrame.
+    const SoftwareRasterStats& getRasterStats() const;
+
+private:
+    struct TextureEntry
+    {
+        std::shared_ptr<SoftwareTexture> texture;
+        std::string memoryCategory;
+        uint64_t bytes = 0;
+    };
+
+    struct BufferEntry
+    {
+        RenderBufferDesc desc;
+        std::string memoryCategory;
+        std::vector<uint8_t> data;
+    };
+
+    // Only the per-vertex attributes of stream 0 are converted; the instance stream is read raw.
+    struct ShaderEntry
+    {
+        const SoftwareProgram* program = nullptr;
+        std::vector<RenderVertexAttribute> attributes;
+    };
+
+    struct ReadbackEntry
+    {
+        RenderTextureDesc desc;
+        std::vector<uint8_t> data;
+        bool pending = false;
+    };
+
+    // Handles bound to the registers of one stage; resolved when work is submitted.
+    struct StageState
+    {
+        RenderTexture textures[SOFTWARE_TEXTURE_SLOTS] = {};
+        RenderSampler samplers[SOFTWARE_SAMPLER_SLOTS] = {};
+        RenderBuffer constants[SOFTWARE_CONSTANT_SLOTS] = {};
+        RenderBuffer buffers[SOFTWARE_TEXTURE_SLOTS] = {};
+    };
+
+    HandleTable<TextureEntry> textures;
+    HandleTable<BufferEntry> buffers;
+    HandleTable<ShaderEntry> shaders;
+    HandleTable<SoftwareSampler> samplers;
+    HandleTable<ReadbackEntry> readbacks;
+
+    std::unique_ptr<ThreadPool> threadPool;
+    SoftwareRasterizer rasterizer;
+    uint32_t threadCount = 1;
+    StageState stages[3];
+    RenderTexture storageTextures[SOFTWARE_STORAGE_SLOTS] = {};
+    RenderBuffer storageBuffers[SOFTWARE_STORAGE_SLOTS] = {};
+    RenderPipelineDesc pipeline;
+    RenderShader computeShader = RENDER_NULL_HANDLE;
+    RenderPassDesc pass;
+    bool inFrame = false;
+    bool inPass = false;
+    uint32_t scopeDepth = 0;
+    std::vector<SoftwareVertex> vertices;
+    std::vector<uint32_t> indices;
+    std::vector<Float4> vertexAttributes;
+
+    SoftwareBindings resolveBindings(RenderShaderStage stage);
+    SoftwareRasterState makeRasterState(const SoftwareProgram& vertexProgram, const SoftwareProgram& pixelProgram,
+                                        const SoftwareBindings* pixelBindings);
+    void assembleVertices(const ShaderEntry& shader, const uint8_t* vertexData, uint32_t vertexStride,
+                          uint32_t vertexCount);
+    void shadeVertices(const ShaderEntry& shader, const SoftwareBindings& bindings, const uint8_t* vertexData,
+                       uint32_t vertexStride, uint32_t vertexCount, const uint8_t* instanceData,
+                       uint32_t instanceStride, uint32_t firstInstance, uint32_t instanceCount);
+    void checkSlots(const char* kind, uint32_t slot, uint32_t count, uint32_t slotCount) const;
+    void validateAttachment(const RenderAttachment& attachment, uint32_t requiredFlag) const;
+    const BufferEntry& requireBuffer(RenderBuffer buffer, RenderBufferType type, const char* error) const;
+};
@@ -0,0 +1,583 @@
+#include "SoftwareShaders.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <cwctype>
+
+#include "../IBL/IBLMath.h"
+#include "../Lighting/LightClusters.h"
+#include "../ToneMap/LuminanceReduction.h"
+
+namespace
+{
+    const float PI = 3.14159265359f;
+
+    Float3 operator+(const Float3& a, const Float3& b)
+    {
+        return RenderMath::makeFloat3(a.x + b.x, a.y + b.y, a.z + b.z);
+    }
+
+    Float3 operator-(const Float3& a, const Float3& b)
+    {
+        return RenderMath::makeFloat3(a.x - b.x, a.y - b.y, a.z - b.z);
+    }
+
+    Float3 operator*(const Float3& a, const Float3& b)
+    {
+        return RenderMath::makeFloat3(a.x * b.x, a.y * b.y, a.z * b.z);
+    }
+
+    Float3 operator*(const Float3& a, float b)
+    {
+        return RenderMath::makeFloat3(a.x * b, a.y * b, a.z * b);
+    }
+
+    Float3 operator/(const Float3& a, float b)
+    {
+        return a * (1.0f / b);
+    }
+
+    Float3 splat(float value)
+    {
+        return RenderMath::makeFloat3(value, value, value);
+    }
+
+    Float3 maxFloat3(const Float3& a, const Float3& b)
+    {
+        return RenderMath::makeFloat3(std::max(a.x, b.x), std::max(a.y, b.y), std::max(a.z, b.z));
+    }
+
+    Float3 lerpFloat3(const Float3& a, const Float3& b, float t)
+    {
+        return a + (b - a) * t;
+    }
+
+    float clampFloat(float value, float minValue, float maxValue)
+    {
+        return std::min(std::max(value, minValue), maxValue);
+    }
+
+    float length(const Float3& v)
+    {
+        return sqrtf(RenderMath::dot(v, v));
+    }
+
+    Float3 readFloat3(const float* values)
+    {
+        return RenderMath::makeFloat3(values[0], values[1], values[2]);
+    }
+
+    Float3 rgb(const Float4& value)
+    {
+        return RenderMath::makeFloat3(value.x, value.y, value.z);
+    }
+
+    Float4 makeColor(const Float3& color, float alpha)
+    {
+        return RenderMath::makeFloat4(color.x, color.y, color.z, alpha);
+    }
+
+    // Row vector times a row-major matrix: what mul(matrix, v) computes for a cbuffer matrix uploaded untransposed,
+    // and mul(v, matrix) for one assembled from rows.
+    Float4 transform(const Float4& v, const Float4x4& m)
+    {
+        const float in[4] = {v.x, v.y, v.z, v.w};
+        float out[4] = {};
+        for (int column = 0; column < 4; column++)
+        {
+            for (int k = 0; k < 4; k++)
+            {
+                out[column] += in[k] * m.m[k][column];
+            }
+        }
+        return RenderMath::makeFloat4(out[0], out[1], out[2], out[3]);
+    }
+
+    template <typename T>
+    T readConstants(const uint8_t* bytes)
+    {
+        T value;
+        memcpy(&value, bytes, sizeof(T));
+        return value;
+    }
+
+    // Stream 1 of the lighting shader, see InstanceData.
+    struct InstanceInput
+    {
+        Float4x4 worldMatrix;
+        Float4 albedo;
+        Float2 material;
+    };
+
+    // Mesh attributes come from the input assembler as POSITION, UV and NORMAL, see MeshEncoder.
+    struct MeshTransform
+    {
+        Float4x4 cameraMatrix;
+        Float4 positionDequant;
+    };
+
+    struct SkyboxTransform
+    {
+        Float4x4 worldMatrix;
+        Float4x4 cameraMatrix;
+        Float4 size;
+        Float4 positionDequant;
+        Float3 cameraPosition;
+    };
+
+    struct PointLight
+    {
+        Float3 position;
+        float radius;
+        Float3 color;
+        float intensity;
+    };
+
+    struct LightData
+    {
+        Float4x4 cameraMatrix;
+        Float3 cameraPosition;
+        float clusterDepthScale;
+        float clusterDepthBias;
+    };
+
+    struct Configuration
+    {
+        int defaultFunction;
+        int normalDistribution;
+        int fresnelFunction;
+        int geometryFunction;
+        float configMetallic;
+        float configRoughness;
+        float ambientIntensity;
+        int irradianceMode;
+    };
+
+    Float3 dequantizePosition(const Float4& position, const Float4& dequant)
+    {
+        return RenderMath::makeFloat3(position.x * dequant.w + dequant.x, position.y * dequant.w + dequant.y,
+                                      position.z * dequant.w + dequant.z);
+    }
+
+    Float3 decodeOctahedral(const Float4& encoded)
+    {
+        Float3 n = RenderMath::makeFloat3(encoded.x, encoded.y, 1.0f - fabsf(encoded.x) - fabsf(encoded.y));
+        float t = std::max(-n.z, 0.0f);
+        n.x += n.x >= 0.0f ? -t : t;
+        n.y += n.y >= 0.0f ? -t : t;
+        return RenderMath::normalize(n);
+    }
+
+    // Shaders/CubemapGen
+
+    void cubeSideVS(const SoftwareBindings& bindings, const SoftwareVertexInput& input, SoftwareVertex* pOutput)
+    {
+        Float4x4 viewProjection = readConstants<Float4x4>(bindings.constants[0]);
+        const float* position = (const float*)input.vertex;
+        pOutput->position = transform(RenderMath::makeFloat4(position[0], position[1], position[2], 1.0f),
+                                      viewProjection);
+        memcpy(pOutput->varyings, position, sizeof(float) * 3);
+    }
+
+    void hdrToCubePS(const SoftwareBindings& bindings, const float* varyings, Float4* pOutputs)
+    {
+        Float3 pos = RenderMath::normalize(readFloat3(varyings));
+        float u = 1 - atan2f(pos.z, pos.x) / (2 * PI);
+        float v = -atan2f(pos.y, sqrtf(pos.x * pos.x + pos.z * pos.z)) / PI + 0.5f;
+        pOutputs[0] = makeColor(rgb(bindings.textures[0]->sample(bindings.samplers[0], u, v, 0.0f)), 1.0f);
+    }
+
+    void prefilterCubePS(const SoftwareBindings& bindings, const float* varyings, Float4* pOutputs)
+    {
+        const uint32_t SAMPLE_COUNT = 1024u;
+        const float envMapDim = 128;
+        float roughness = readConstants<Float4>(bindings.constants[0]).x;
+        Float3 R = RenderMath::normalize(readFloat3(varyings));
+        IBLMath::Vec3 N(R.x, R.y, R.z);
+        IBLMath::Vec3 V = N;
+        Float3 color = splat(0.0f);
+        float totalWeight = 0.0f;
+        for (uint32_t i = 0u; i < SAMPLE_COUNT; i++)
+        {
+            float xiX, xiY;
+            IBLMath::hammersley2d(i, SAMPLE_COUNT, &xiX, &xiY);
+            IBLMath::Vec3 H = IBLMath::importanceSampleGGX(xiX, xiY, roughness, N);
+            IBLMath::Vec3 L = H * (2.0f * IBLMath::dot(V, H)) - V;
+            float dotNL = clampFloat(IBLMath::dot(N, L), 0.0f, 1.0f);
+            if (dotNL > 0.0f)
+            {
+                float dotNH = clampFloat(IBLMath::dot(N, H), 0.0f, 1.0f);
+                float dotVH = clampFloat(IBLMath::dot(V, H), 0.0f, 1.0f);
+                float pdf = IBLMath::distributeGGX(dotNH, roughness) * dotNH / (4.0f * dotVH) + 0.0001f;
+                float omegaS = 1.0f / ((float)SAMPLE_COUNT * pdf);
+                float omegaP = 4.0f * PI / (6.0f * envMapDim * envMapDim);
+                float mipLevel = roughness == 0.0f ? 0.0f : std::max(0.5f * log2f(omegaS / omegaP) + 1.0f, 0.0f);
+                Float4 texel = bindings.textures[0]->sampleCube(bindings.samplers[0],
+                                                                RenderMath::makeFloat3(L.x, L.y, L.z), mipLevel);
+                color = color + rgb(texel) * dotNL;
+                totalWeight += dotNL;
+            }
+        }
+        pOutputs[0] = makeColor(color / totalWeight, 1.0f);
+    }
+
+    // Shaders/Skybox
+
+    void skyboxVS(const SoftwareBindings& bindings, const SoftwareVertexInput& input, SoftwareVertex* pOutput)
+    {
+        SkyboxTransform transformData = readConstants<SkyboxTransform>(bindings.constants[0]);
+        Float3 position = dequantizePosition(input.attributes[0], transformData.positionDequant);
+        Float3 pos = transformData.cameraPosition + position * transformData.size.x;
+        Float4 world = transform(RenderMath::makeFloat4(pos.x, pos.y, pos.z, 1.0f), transformData.worldMatrix);
+        pOutput->position = transform(world, transformData.cameraMatrix);
+        pOutput->position.z = 0.0f;
+        memcpy(pOutput->varyings, &position, sizeof(float) * 3);
+    }
+
+    void skyboxPS(const SoftwareBindings& bindings, const float* varyings, Float4* pOutputs)
+    {
+        Float4 texel = bindings.textures[0]->sampleCube(bindings.samplers[0], readFloat3(varyings), 0.0f);
+        pOutputs[0] = RenderMath::makeFloat4(texel.x * 10, texel.y * 10, texel.z * 10, 10.0f);
+    }
+
+    // Shaders/Lighting: worldPos (4), normal (3), uv (2), color (3), material (2).
+
+    void lightingVS(const SoftwareBindings& bindings, const SoftwareVertexInput& input, SoftwareVertex* pOutput)
+    {
+        MeshTransform transformData = readConstants<MeshTransform>(bindings.constants[0]);
+        InstanceInput instance = readConstants<InstanceInput>(input.instance);
+        Float3 position = dequantizePosition(input.attributes[0], transformData.positionDequant);
+        Float3 objectNormal = decodeOctahedral(input.attributes[2]);
+        Float4 worldPos = transform(RenderMath::makeFloat4(position.x, position.y, position.z, 1.0f),
+                                    instance.worldMatrix);
+        Float4 normal = transform(RenderMath::makeFloat4(objectNormal.x, objectNormal.y, objectNormal.z, 0.0f),
+                                  instance.worldMatrix);
+        pOutput->position = transform(worldPos, transformData.cameraMatrix);
+        float* varyings = pOutput->varyings;
+        memcpy(varyings, &worldPos, sizeof(float) * 4);
+        memcpy(varyings + 4, &normal, sizeof(float) * 3);
+        memcpy(varyings + 7, &input.attributes[1], sizeof(float) * 2);
+        memcpy(varyings + 9, &instance.albedo, sizeof(float) * 3);
+        memcpy(varyings + 12, &instance.material, sizeof(float) * 2);
+    }
+
+    float distributeGGX(const Float3& normals, const Float3& halfWayVector, float roughness)
+    {
+        float a = roughness * roughness;
+        float NdotH = std::max(RenderMath::dot(normals, halfWayVector), 0.0f);
+        float NdotH2 = NdotH * NdotH;
+        float nom = a;
+        float denom = (NdotH2 * (nom - 1.0f) + 1.0f);
+        denom = PI * denom * denom;
+        return nom / denom;
+    }
+
+    float schlickGeometryGGX(float dotWorldViewVector, float roughness)
+    {
+        float roughnessKoef = ((roughness + 1.0f) * (roughness + 1.0f)) / 8.0f;
+        return dotWorldViewVector / (dotWorldViewVector * (1.0f - roughnessKoef) + roughnessKoef);
+    }
+
+    float smithGeometry(const Float3& normals, const Float3& worldViewVector, const Float3& lightPosition,
+                        float roughness)
+    {
+        float worldViewVectorDot = std::max(RenderMath::dot(normals, worldViewVector), 0.0f);
+        float lightDot = std::max(RenderMath::dot(normals, lightPosition), 0.0f);
+        return schlickGeometryGGX(lightDot, roughness) * schlickGeometryGGX(worldViewVectorDot, roughness);
+    }
+
+    Float3 fresnelFunctionMetal(const Float3& objColor, const Float3& startFresnelSchlick, const Float3& h,
+                                const Float3& worldViewVector, float metallic)
+    {
+        Float3 f = startFresnelSchlick * (1 - metallic) + objColor * metallic;
+        return f + (splat(1.0f) - f) * powf(1.0f - std::max(RenderMath::dot(h, worldViewVector), 0.0f), 5);
+    }
+
+    Float3 fresnelSchlickRoughness(float cosTheta, const Float3& F0, float roughness)
+    {
+        return F0 + (maxFloat3(splat(1.0f - roughness), F0) - F0) * powf(1.0f - cosTheta, 5.0f);
+    }
+
+    float distanceAttenuation(float distance, float radius)
+    {
+        float ratio = distance / radius;
+        float window = clampFloat(1.0f - ratio * ratio * ratio * ratio, 0.0f, 1.0f);
+        return window * window / std::max(distance * distance, 1.0f);
+    }
+
+    uint32_t findCluster(const LightData& lightData, const Float3& worldPos)
+    {
+        Float4 clipPos = transform(RenderMath::makeFloat4(worldPos.x, worldPos.y, worldPos.z, 1.0f),
+                                   lightData.cameraMatrix);
+        float ndcX = clipPos.x / clipPos.w;
+        float ndcY = clipPos.y / clipPos.w;
+        auto cell = [](float value, uint32_t count)
+        {
+            return (uint32_t)clampFloat(floorf(value), 0.0f, count - 1.0f);
+        };
+        uint32_t x = cell((ndcX * 0.5f + 0.5f) * LightClusters::GRID_X, LightClusters::GRID_X);
+        uint32_t y = cell((ndcY * 0.5f + 0.5f) * LightClusters::GRID_Y, LightClusters::GRID_Y);
+        uint32_t z = cell(log2f(clipPos.w) * lightData.clusterDepthScale + lightData.clusterDepthBias,
+                          LightClusters::GRID_Z);
+        return (z * LightClusters::GRID_Y + y) * LightClusters::GRID_X + x;
+    }
+
+    Float3 processPointLight(const Configuration& configuration, const PointLight& light, const Float3& normals,
+                             const Float3& fragmentPosition, const Float3& worldViewVector,
+                             const Float3& startFresnelSchlick, float roughness, float metallic, const Float3& albedo)
+    {
+        Float3 processedLightPos = RenderMath::normalize(light.position - fragmentPosition);
+        float distance = length(light.position - fragmentPosition);
+        Float3 halfWay = RenderMath::normalize((worldViewVector + processedLightPos) / 2.0f);
+
+        Float3 radiance = light.color * (light.intensity * distanceAttenuation(distance, light.radius));
+
+        float halfWayGGX = distributeGGX(normals, halfWay, roughness);
+        float geometrySmith = smithGeometry(normals, worldViewVector, processedLightPos, roughness);
+        Float3 fresnelSchlick = fresnelFunctionMetal(albedo, startFresnelSchlick, halfWay, worldViewVector,
+                                                     metallic);
+
+        Float3 numerator = splat(0.0f);
+        float denominator = 1;
+        float lightTerm = 4.0f * std::max(RenderMath::dot(normals, worldViewVector), 0.0f) *
+            std::max(RenderMath::dot(normals, processedLightPos), 0.0f) + 0.0001f;
+        if (configuration.defaultFunction)
+        {
+            numerator = fresnelSchlick * (halfWayGGX * geometrySmith);
+            denominator = lightTerm;
+        }
+        else if (configuration.fresnelFunction)
+        {
+            numerator = fresnelSchlick;
+            denominator = lightTerm;
+        }
+        else if (configuration.normalDistribution)
+        {
+            numerator = splat(halfWayGGX);
+        }
+        else if (configuration.geometryFunction)
+        {
+            numerator = splat(geometrySmith);
+        }
+
+        Float3 specular = numerator / denominator;
+        if (!configuration.defaultFunction)
+        {
+            return specular;
+        }
+        Float3 finalFresnelSchlick = (splat(1.0f) - fresnelSchlick) * (1.0f - metallic + 0.001f);
+        float NdotL = std::max(RenderMath::dot(normals, processedLightPos), 0.0f);
+        return (finalFresnelSchlick * albedo / PI + specular) * radiance * NdotL;
+    }
+
+    Float3 irradianceSH(const Float4* sh, const Float3& normal)
+    {
+        Float3 result = rgb(sh[0]) * 0.282095f;
+        result = result + rgb(sh[1]) * (0.488603f * normal.y);
+        result = result + rgb(sh[2]) * (0.488603f * normal.z);
+        result = result + rgb(sh[3]) * (0.488603f * normal.x);
+        result = result + rgb(sh[4]) * (1.092548f * normal.x * normal.y);
+        result = result + rgb(sh[5]) * (1.092548f * normal.y * normal.z);
+        result = result + rgb(sh[6]) * (0.315392f * (3.0f * normal.z * normal.z - 1.0f));
+        result = result + rgb(sh[7]) * (1.092548f * normal.x * normal.z);
+        result = result + rgb(sh[8]) * (0.546274f * (normal.x * normal.x - normal.y * normal.y));
+        return maxFloat3(result, splat(0.0f));
+    }
+
+    void pbrPS(const SoftwareBindings& bindings, const float* varyings, Float4* pOutputs)
+    {
+        LightData lightData = readConstants<LightData>(bindings.constants[0]);
+        Configuration configuration = readConstants<Configuration>(bindings.constants[1]);
+        const Float4* sh = (const Float4*)bindings.constants[2];
+        const SoftwareTexture* irradianceTexture = bindings.textures[0];
+        const SoftwareTexture* prefilteredTexture = bindings.textures[1];
+        const SoftwareTexture* brdfTexture = bindings.textures[2];
+        const SoftwareSampler& prefilteredSampler = bindings.samplers[1];
+        const PointLight* lights = (const PointLight*)bindings.buffers[3]->data();
+        const LightCluster* lightClusters = (const LightCluster*)bindings.buffers[4]->data();
+        const uint32_t* lightIndices = (const uint32_t*)bindings.buffers[5]->data();
+
+        Float3 worldPos = readFloat3(varyings);
+        Float3 normal = RenderMath::normalize(readFloat3(varyings + 4));
+        Float3 color = readFloat3(varyings + 9);
+        float metallic = varyings[12];
+        float roughness = varyings[13];
+        Float3 worldViewVector = RenderMath::normalize(lightData.cameraPosition - worldPos);
+
+        Float3 startFresnelSchlick = lerpFloat3(splat(0.04f), color, metallic);
+        Float3 Lo = splat(0.0f);
+        LightCluster cluster = lightClusters[findCluster(lightData, worldPos)];
+        for (uint32_t i = 0; i < cluster.count; i++)
+        {
+            Lo = Lo + processPointLight(configuration, lights[lightIndices[cluster.offset + i]], normal, worldPos,
+                                        worldViewVector, startFresnelSchlick, roughness, metallic, color);
+        }
+
+        Float3 R = normal * (-2.0f * RenderMath::dot(normal, splat(0.0f) - worldViewVector)) - worldViewVector;
+        float dotNV = std::max(RenderMath::dot(normal, worldViewVector), 0.0f);
+        Float4 brdf = brdfTexture->sample(prefilteredSampler, dotNV, roughness, 0.0f);
+
+        const float MAX_REFLECTION_LOD = 9.0f;
+        float lod = roughness * MAX_REFLECTION_LOD;
+        float lodf = floorf(lod);
+        float lodc = ceilf(lod);
+        Float3 reflection = lerpFloat3(rgb(prefilteredTexture->sampleCube(prefilteredSampler, R, lodf)),
+                                       rgb(prefilteredTexture->sampleCube(prefilteredSampler, R, lodc)), lod - lodf);
+        Float3 irradiance = configuration.irradianceMode
+                                ? rgb(irradianceTexture->sampleCube(prefilteredSampler, normal, 0.0f))
+                                : irradianceSH(sh, normal);
+
+        Float3 diffuse = irradiance * color;
+        Float3 F = fresnelSchlickRoughness(dotNV, startFresnelSchlick, roughness);
+        Float3 specular = reflection * (F * brdf.x + splat(brdf.y));
+        Float3 kD = (splat(1.0f) - F) * (1.0f - metallic);
+        Float3 ambient = kD * diffuse + specular;
+        pOutputs[0] = makeColor(ambient * configuration.ambientIntensity + Lo, 1.0f);
+    }
+
+    // Shaders/ToneMap
+
+    void mappingVS(const SoftwareBindings&, const SoftwareVertexInput& input, SoftwareVertex* pOutput)
+    {
+        static const float POSITIONS[6][2] = {{1, 1}, {1, -1}, {-1, -1}, {-1, 1}, {1, 1}, {-1, -1}};
+        float x = input.vertexId < 6 ? POSITIONS[input.vertexId][0] : 0.0f;
+        float y = input.vertexId < 6 ? POSITIONS[input.vertexId][1] : 0.0f;
+        pOutput->position = RenderMath::makeFloat4(x, y, 0, input.vertexId < 6 ? 1.0f : 0.0f);
+        pOutput->varyings[0] = x * 0.5f + 0.5f;
+        pOutput->varyings[1] = 0.5f - y * 0.5f;
+    }
+
+    void brightnessPS(const SoftwareBindings& bindings, const float* varyings, Float4* pOutputs)
+    {
+        float values[3];
+        for (uint32_t i = 0; i < 3; i++)
+        {
+            Float4 texel = bindings.textures[i]->sample(bindings.samplers[i], varyings[0], varyings[1], 0.0f);
+            const float color[3] = {texel.x, texel.y, texel.z};
+            values[i] = LuminanceReduction::brightness(color);
+        }
+        pOutputs[0] = RenderMath::makeFloat4(logf(values[0] + 1.0f), 0, 0, 0);
+        pOutputs[1] = RenderMath::makeFloat4(values[1], 0, 0, 0);
+        pOutputs[2] = RenderMath::makeFloat4(values[2], 0, 0, 0);
+    }
+
+    void downsamplePS(const SoftwareBindings& bindings, const float* varyings, Float4* pOutputs)
+    {
+        for (uint32_t i = 0; i < 3; i++)
+        {
+            float value = bindings.textures[i]->sample(bindings.samplers[i], varyings[0], varyings[1], 0.0f).x;
+            pOutputs[i] = RenderMath::makeFloat4(value, 0, 0, 0);
+        }
+    }
+
+    Float3 uncharted2Tonemap(const Float3& x)
+    {
+        const float A = 0.1f;
+        const float B = 0.50f;
+        const float C = 0.1f;
+        const float D = 0.20f;
+        const float E = 0.02f;
+        const float F = 0.30f;
+        Float3 numerator = x * (x * A + splat(C * B)) + splat(D * E);
+        Float3 denominator = x * (x * A + splat(B)) + splat(D * F);
+        return RenderMath::makeFloat3(numerator.x / denominator.x, numerator.y / denominator.y,
+                                      numerator.z / denominator.z) - splat(E / F);
+    }
+
+    void tonemapPS(const SoftwareBindings& bindings, const float* varyings, Float4* pOutputs)
+    {
+        const float W = 11.2f;
+        const SoftwareSampler& sampler = bindings.samplers[0];
+        float adaptedAvg = readConstants<Float4>(bindings.constants[0]).x;
+        Float3 color = rgb(bindings.textures[0]->sample(sampler, varyings[0], varyings[1], 0.0f));
+
+        float avg = expf(adaptedAvg) - 1.0f;
+        float keyValue = 1.03f - 2.0f / (2.0f + logf(avg + 1.0f));
+        float minimum = bindings.textures[2]->sample(sampler, 0.5f, 0.5f, 0.0f).x;
+        float maximum = bindings.textures[3]->sample(sampler, 0.5f, 0.5f, 0.0f).x;
+        float exposure = keyValue / std::min(std::max(avg, minimum), maximum);
+        Float3 curr = uncharted2Tonemap(color * exposure);
+        Float3 white = uncharted2Tonemap(splat(W));
+        pOutputs[0] = makeColor(RenderMath::makeFloat3(curr.x / white.x, curr.y / white.y, curr.z / white.z), 1.0f);
+    }
+
+    LuminanceConstants readLuminanceConstants(const SoftwareBindings& bindings)
+    {
+        return readConstants<LuminanceConstants>(bindings.constants[0]);
+    }
+
+    // The group loop of both kernels already lives in LuminanceReduction, step for step with the HLSL.
+    void luminanceReduceCS(const SoftwareBindings& bindings, uint32_t, uint32_t, uint32_t)
+    {
+        LuminanceConstants constants = readLuminanceConstants(bindings);
+        std::vector<LuminanceStats> partials;
+        std::vector<uint32_t> histogram;
+        LuminanceReduction::reduceGroups((const float*)bindings.textures[0]->getTexels(0, 0), constants, &partials,
+                                         &histogram);
+        std::vector<uint8_t>& partialBytes = *bindings.storageBuffers[0];
+        memcpy(partialBytes.data(), partials.data(),
+               std::min(partialBytes.size(), partials.size() * sizeof(LuminanceStats)));
+        uint32_t* histogramBins = (uint32_t*)bindings.storageBuffers[1]->data();
+        for (uint32_t bin = 0; bin < LuminanceReduction::HISTOGRAM_BINS; bin++)
+        {
+            histogramBins[bin] += histogram[bin];
+        }
+    }
+
+    void luminanceFinalizeCS(const SoftwareBindings& bindings, uint32_t, uint32_t, uint32_t)
+    {
+        LuminanceConstants constants = readLuminanceConstants(bindings);
+        std::vector<LuminanceStats> partials(constants.groupCount);
+        memcpy(partials.data(), bindings.buffers[0]->data(), partials.size() * sizeof(LuminanceStats));
+        std::vector<uint32_t> histogram(LuminanceReduction::HISTOGRAM_BINS);
+        memcpy(histogram.data(), bindings.buffers[1]->data(), histogram.size() * sizeof(uint32_t));
+        LuminanceResult result = LuminanceReduction::finalize(partials, histogram, constants);
+        const float values[3] = {result.average, result.minimum, result.maximum};
+        for (uint32_t i = 0; i < 3; i++)
+        {
+            bindings.storageTextures[i]->store(0, 0, 0, 0, RenderMath::makeFloat4(values[i], 0, 0, 0));
+        }
+    }
+
+    const SoftwareProgram PROGRAMS[] = {
+        {L"Shaders/CubemapGen/CubeSideVS.hlsl", RENDER_STAGE_VERTEX, 3, cubeSideVS, nullptr, nullptr},
+        {L"Shaders/CubemapGen/HDRToCubePS.hlsl", RENDER_STAGE_PIXEL, 0, nullptr, hdrToCubePS, nullptr},
+        {L"Shaders/CubemapGen/prefilterCube.hlsl", RENDER_STAGE_PIXEL, 0, nullptr, prefilterCubePS, nullptr},
+        {L"Shaders/Skybox/skyboxVS.hlsl", RENDER_STAGE_VERTEX, 3, skyboxVS, nullptr, nullptr},
+        {L"Shaders/Skybox/skyboxPS.hlsl", RENDER_STAGE_PIXEL, 0, nullptr, skyboxPS, nullptr},
+        {L"Shaders/Lighting/VertexShader.hlsl", RENDER_STAGE_VERTEX, 14, lightingVS, nullptr, nullptr},
+        {L"Shaders/Lighting/PBRPixelShader.hlsl", RENDER_STAGE_PIXEL, 0, nullptr, pbrPS, nullptr},
+        {L"Shaders/ToneMap/mappingVS.hlsl", RENDER_STAGE_VERTEX, 2, mappingVS, nullptr, nullptr},
+        {L"Shaders/ToneMap/brightnessPS.hlsl", RENDER_STAGE_PIXEL, 0, nullptr, brightnessPS, nullptr},
+        {L"Shaders/ToneMap/downsamplePS.hlsl", RENDER_STAGE_PIXEL, 0, nullptr, downsamplePS, nullptr},
+        {L"Shaders/ToneMap/tonemapPS.hlsl", RENDER_STAGE_PIXEL, 0, nullptr, tonemapPS, nullptr},
+        {L"Shaders/ToneMap/luminanceReduceCS.hlsl", RENDER_STAGE_COMPUTE, 0, nullptr, nullptr, luminanceReduceCS},
+        {L"Shaders/ToneMap/luminanceFinalizeCS.hlsl", RENDER_STAGE_COMPUTE, 0, nullptr, nullptr,
+         luminanceFinalizeCS}
+    };
+
+    bool pathsEqual(const wchar_t* a, const wchar_t* b)
+    {
+        for (; *a && *b; a++, b++)
+        {
+            if (towlower(*a) != towlower(*b))
+            {
+                return false;
+            }
+        }
+        return *a == *b;
+    }
+}
+
+const SoftwareProgram* SoftwareShaders::find(const wchar_t* path)
+{
+    for (const SoftwareProgram& program : PROGRAMS)
+    {
+        if (pathsEqual(program.path, path))
+        {
+            return &program;
+        }
+    }
+    return nullptr;
+}
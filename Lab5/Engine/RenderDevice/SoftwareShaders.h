@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "RenderDevice.h"
+#include "RenderMath.h"
+#include "SoftwareTexture.h"
+
+class ThreadPool;
+
+const uint32_t SOFTWARE_MAX_VARYINGS = 16;
+const uint32_t SOFTWARE_TEXTURE_SLOTS = 8;
+const uint32_t SOFTWARE_SAMPLER_SLOTS = 8;
+const uint32_t SOFTWARE_CONSTANT_SLOTS = 4;
+const uint32_t SOFTWARE_STORAGE_SLOTS = 4;
+
+// Device state visible to one shader stage, the software counterpart of the t#, s#, b# and u# registers. Constants
+// point at the cbuffer bytes in their HLSL layout. Textures and buffers share the t# registers, so both span them.
+struct SoftwareBindings
+{
+    const SoftwareTexture* textures[SOFTWARE_TEXTURE_SLOTS] = {};
+    SoftwareSampler samplers[SOFTWARE_SAMPLER_SLOTS];
+    const uint8_t* constants[SOFTWARE_CONSTANT_SLOTS] = {};
+    const std::vector<uint8_t>* buffers[SOFTWARE_TEXTURE_SLOTS] = {};
+    std::vector<uint8_t>* storageBuffers[SOFTWARE_STORAGE_SLOTS] = {};
+    SoftwareTexture* storageTextures[SOFTWARE_STORAGE_SLOTS] = {};
+    ThreadPool* threadPool = nullptr;
+};
+
+struct SoftwareVertexInput
+{
+    // The element of vertex stream 0 and of the per-instance stream 1; null when the draw has no such stream.
+    const uint8_t* vertex = nullptr;
+    const uint8_t* instance = nullptr;
+    // Stream 0 as the input assembler hands it over: one Float4 per vertex attribute of the shader, converted from
+    // its format, with missing components taken from (0, 0, 0, 1). Null when the shader declares no attributes.
+    const Float4* attributes = nullptr;
+    uint32_t vertexId = 0;
+};
+
+// SV_POSITION in clip space followed by the interpolated outputs, packed as the pixel shader reads them.
+struct SoftwareVertex
+{
+    Float4 position;
+    float varyings[SOFTWARE_MAX_VARYINGS];
+};
+
+using SoftwareVertexShader = void (*)(const SoftwareBindings& bindings, const SoftwareVertexInput& input,
+                                      SoftwareVertex* pOutput);
+// Writes one colour per render target of the pass.
+using SoftwarePixelShader = void (*)(const SoftwareBindings& bindings, const float* varyings, Float4* pOutputs);
+// Runs the whole dispatch; a port may spread its groups over bindings.threadPool.
+using SoftwareComputeShader = void (*)(const SoftwareBindings& bindings, uint32_t groupCountX, uint32_t groupCountY,
+                                       uint32_t groupCountZ);
+
+struct SoftwareProgram
+{
+    const wchar_t* path;
+    RenderShaderStage stage;
+    // Vertex shaders: how many floats of SoftwareVertex::varyings the matching pixel shader reads.
+    uint32_t varyingCount;
+    SoftwareVertexShader vertexShader;
+    SoftwarePixelShader pixelShader;
+    SoftwareComputeShader computeShader;
+};
+
+// C++ ports of the HLSL programs under Shaders/, looked up by the path the RenderShaderDesc names. They follow the
+// HLSL line by line, including its quirks, so the software image matches the GPU one.
+namespace SoftwareShaders
+{
+    // Paths compare case-insensitively, as they do on Windows. Returns null for a file without a port.
+    const SoftwareProgram* find(const wchar_t* path);
+}
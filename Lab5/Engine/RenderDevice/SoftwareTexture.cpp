@@ -0,0 +1,315 @@
+#include "SoftwareTexture.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+#include "../IBL/IBLMath.h"
+#include "../../Utils/BC6H.h"
+#include "../../Utils/HalfFloat.h"
+#include "../../Utils/SharedExponent.h"
+
+namespace
+{
+    const float DEPTH_SCALE = 16777215.0f;
+
+    Float4 makeTexel(float x, float y, float z, float w)
+    {
+        return RenderMath::makeFloat4(x, y, z, w);
+    }
+
+    float roundHalf(float value)
+    {
+        return HalfFloat::toFloat(HalfFloat::fromFloat(value));
+    }
+
+    Float4 roundSharedExponent(const Float4& value)
+    {
+        float rgb[3];
+        SharedExponent::toFloat3(SharedExponent::fromFloat3(value.x, value.y, value.z), rgb);
+        return makeTexel(rgb[0], rgb[1], rgb[2], 1.0f);
+    }
+
+    float roundUnorm8(float value)
+    {
+        return floorf(std::min(std::max(value, 0.0f), 1.0f) * 255.0f + 0.5f) / 255.0f;
+    }
+
+    uint32_t wrapCoordinate(int coordinate, uint32_t size, RenderAddressMode addressMode)
+    {
+        if (addressMode == RENDER_ADDRESS_CLAMP)
+        {
+            return (uint32_t)std::min(std::max(coordinate, 0), (int)size - 1);
+        }
+        int wrapped = coordinate % (int)size;
+        return (uint32_t)(wrapped < 0 ? wrapped + (int)size : wrapped);
+    }
+
+    Float4 reduce(RenderFilter filter, const Float4& a, const Float4& b)
+    {
+        if (filter == RENDER_FILTER_MINIMUM)
+        {
+            return makeTexel(std::min(a.x, b.x), std::min(a.y, b.y), std::min(a.z, b.z), std::min(a.w, b.w));
+        }
+        return makeTexel(std::max(a.x, b.x), std::max(a.y, b.y), std::max(a.z, b.z), std::max(a.w, b.w));
+    }
+
+    Float4 lerp(const Float4& a, const Float4& b, float t)
+    {
+        return makeTexel(a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t, a.z + (b.z - a.z) * t,
+                         a.w + (b.w - a.w) * t);
+    }
+}
+
+SoftwareTexture::SoftwareTexture(const RenderTextureDesc& desc) : desc(desc)
+{
+    subresources.resize(desc.arraySize * desc.mipLevels);
+    for (uint32_t slice = 0; slice < desc.arraySize; slice++)
+    {
+        for (uint32_t mip = 0; mip < desc.mipLevels; mip++)
+        {
+            subresources[slice * desc.mipLevels + mip].resize((size_t)getWidth(mip) * getHeight(mip));
+        }
+    }
+}
+
+const RenderTextureDesc& SoftwareTexture::getDesc() const
+{
+    return desc;
+}
+
+uint32_t SoftwareTexture::getWidth(uint32_t mip) const
+{
+    return RenderDevice::getMipSize(desc.width, mip);
+}
+
+uint32_t SoftwareTexture::getHeight(uint32_t mip) const
+{
+    return RenderDevice::getMipSize(desc.height, mip);
+}
+
+Float4* SoftwareTexture::getTexels(uint32_t slice, uint32_t mip)
+{
+    return subresources[slice * desc.mipLevels + mip].data();
+}
+
+const Float4* SoftwareTexture::getTexels(uint32_t slice, uint32_t mip) const
+{
+    return subresources[slice * desc.mipLevels + mip].data();
+}
+
+void SoftwareTexture::upload(uint32_t slice, uint32_t mip, const void* data)
+{
+    std::vector<Float4>& texels = subresources[slice * desc.mipLevels + mip];
+    if (desc.format == RENDER_FORMAT_BC6H_UF16)
+    {
+        BC6H::decodeImage((const uint8_t*)data, getWidth(mip), getHeight(mip), &texels.data()->x);
+        return;
+    }
+    const uint8_t* bytes = (const uint8_t*)data;
+    uint32_t stride = RenderDevice::getBytesPerPixel(desc.format);
+    for (size_t i = 0; i < texels.size(); i++)
+    {
+        const uint8_t* texel = bytes + i * stride;
+        float channels[4] = {0.0f, 0.0f, 0.0f, 1.0f};
+        switch (desc.format)
+        {
+        case RENDER_FORMAT_R8G8B8A8_UNORM:
+            for (uint32_t c = 0; c < 4; c++)
+            {
+                channels[c] = texel[c] / 255.0f;
+            }
+            break;
+        case RENDER_FORMAT_R16G16_FLOAT:
+        case RENDER_FORMAT_R16G16B16A16_FLOAT:
+            for (uint32_t c = 0; c < stride / 2; c++)
+            {
+                uint16_t half;
+                memcpy(&half, texel + c * 2, sizeof(half));
+                channels[c] = HalfFloat::toFloat(half);
+            }
+            break;
+        case RENDER_FORMAT_R9G9B9E5_SHAREDEXP:
+        {
+            uint32_t packed;
+            memcpy(&packed, texel, sizeof(packed));
+            SharedExponent::toFloat3(packed, channels);
+            break;
+        }
+        case RENDER_FORMAT_D24_UNORM_S8_UINT:
+        {
+            uint32_t depth;
+            memcpy(&depth, texel, sizeof(depth));
+            channels[0] = (depth & 0xFFFFFF) / DEPTH_SCALE;
+            break;
+        }
+        default:
+            memcpy(channels, texel, stride);
+            break;
+        }
+        texels[i] = makeTexel(channels[0], channels[1], channels[2], channels[3]);
+    }
+}
+
+void SoftwareTexture::download(uint32_t slice, uint32_t mip, void* data) const
+{
+    if (RenderDevice::isBlockCompressed(desc.format))
+    {
+        throw std::runtime_error("Failed to download texture: block-compressed formats are upload only");
+    }
+    const std::vector<Float4>& texels = subresources[slice * desc.mipLevels + mip];
+    uint8_t* bytes = (uint8_t*)data;
+    uint32_t stride = RenderDevice::getBytesPerPixel(desc.format);
+    for (size_t i = 0; i < texels.size(); i++)
+    {
+        uint8_t* texel = bytes + i * stride;
+        const float channels[4] = {texels[i].x, texels[i].y, texels[i].z, texels[i].w};
+        switch (desc.format)
+        {
+        case RENDER_FORMAT_R8G8B8A8_UNORM:
+            for (uint32_t c = 0; c < 4; c++)
+            {
+                texel[c] = (uint8_t)(roundUnorm8(channels[c]) * 255.0f + 0.5f);
+            }
+            break;
+        case RENDER_FORMAT_R16G16_FLOAT:
+        case RENDER_FORMAT_R16G16B16A16_FLOAT:
+            for (uint32_t c = 0; c < stride / 2; c++)
+            {
+                uint16_t half = HalfFloat::fromFloat(channels[c]);
+                memcpy(texel + c * 2, &half, sizeof(half));
+            }
+            break;
+        case RENDER_FORMAT_R9G9B9E5_SHAREDEXP:
+        {
+            uint32_t packed = SharedExponent::fromFloat3(channels[0], channels[1], channels[2]);
+            memcpy(texel, &packed, sizeof(packed));
+            break;
+        }
+        case RENDER_FORMAT_D24_UNORM_S8_UINT:
+        {
+            uint32_t depth = (uint32_t)(std::min(std::max(channels[0], 0.0f), 1.0f) * DEPTH_SCALE + 0.5f);
+            memcpy(texel, &depth, sizeof(depth));
+            break;
+        }
+        default:
+            memcpy(texel, channels, stride);
+            break;
+        }
+    }
+}
+
+void SoftwareTexture::store(uint32_t slice, uint32_t mip, uint32_t x, uint32_t y, const Float4& value)
+{
+    subresources[slice * desc.mipLevels + mip][(size_t)y * getWidth(mip) + x] = quantize(value);
+}
+
+void SoftwareTexture::clear(uint32_t slice, uint32_t mip, const Float4& value)
+{
+    std::vector<Float4>& texels = subresources[slice * desc.mipLevels + mip];
+    std::fill(texels.begin(), texels.end(), quantize(value));
+}
+
+Float4 SoftwareTexture::load(uint32_t slice, uint32_t mip, uint32_t x, uint32_t y) const
+{
+    return subresources[slice * desc.mipLevels + mip][(size_t)y * getWidth(mip) + x];
+}
+
+Float4 SoftwareTexture::sample(const SoftwareSampler& sampler, float u, float v, float lod, uint32_t slice) const
+{
+    float maxLod = (float)(desc.mipLevels - 1);
+    lod = std::min(std::max(lod, 0.0f), maxLod);
+    uint32_t lowerMip = (uint32_t)lod;
+    float fraction = lod - (float)lowerMip;
+    Float4 lower = sampleMip(sampler, u, v, lowerMip, slice);
+    if (fraction == 0.0f || lowerMip + 1 >= desc.mipLevels)
+    {
+        return lower;
+    }
+    Float4 upper = sampleMip(sampler, u, v, lowerMip + 1, slice);
+    if (sampler.filter == RENDER_FILTER_MINIMUM || sampler.filter == RENDER_FILTER_MAXIMUM)
+    {
+        return reduce(sampler.filter, lower, upper);
+    }
+    return lerp(lower, upper, fraction);
+}
+
+Float4 SoftwareTexture::sampleCube(const SoftwareSampler& sampler, const Float3& direction, float lod) const
+{
+    // Filtering stops at the face edge instead of blending across the seam; at the sizes the renderer uses the
+    // difference is below the half-float precision of the targets.
+    float u, v;
+    uint32_t face = IBLMath::directionToCubeFace(IBLMath::Vec3(direction.x, direction.y, direction.z), &u, &v);
+    SoftwareSampler faceSampler = sampler;
+    faceSampler.addressMode = RENDER_ADDRESS_CLAMP;
+    return sample(faceSampler, u, v, lod, face);
+}
+
+Float4 SoftwareTexture::quantize(const Float4& value) const
+{
+    switch (desc.format)
+    {
+    case RENDER_FORMAT_R8G8B8A8_UNORM:
+        return makeTexel(roundUnorm8(value.x), roundUnorm8(value.y), roundUnorm8(value.z), roundUnorm8(value.w));
+    case RENDER_FORMAT_R16G16_FLOAT:
+        return makeTexel(roundHalf(value.x), roundHalf(value.y), 0.0f, 1.0f);
+    case RENDER_FORMAT_R16G16B16A16_FLOAT:
+        return makeTexel(roundHalf(value.x), roundHalf(value.y), roundHalf(value.z), roundHalf(value.w));
+    case RENDER_FORMAT_R32_FLOAT:
+        return makeTexel(value.x, 0.0f, 0.0f, 1.0f);
+    case RENDER_FORMAT_R32G32_FLOAT:
+        return makeTexel(value.x, value.y, 0.0f, 1.0f);
+    case RENDER_FORMAT_R32G32B32_FLOAT:
+        return makeTexel(value.x, value.y, value.z, 1.0f);
+    case RENDER_FORMAT_R9G9B9E5_SHAREDEXP:
+        return roundSharedExponent(value);
+    case RENDER_FORMAT_D24_UNORM_S8_UINT:
+        return makeTexel(floorf(std::min(std::max(value.x, 0.0f), 1.0f) * DEPTH_SCALE + 0.5f) / DEPTH_SCALE,
+                         0.0f, 0.0f, 1.0f);
+    default:
+        return value;
+    }
+}
+
+Float4 SoftwareTexture::sampleMip(const SoftwareSampler& sampler, float u, float v, uint32_t mip,
+                                  uint32_t slice) const
+{
+    uint32_t width = getWidth(mip);
+    uint32_t height = getHeight(mip);
+    float x = u * width - 0.5f;
+    float y = v * height - 0.5f;
+    float floorX = floorf(x);
+    float floorY = floorf(y);
+    float fractionX = x - floorX;
+    float fractionY = y - floorY;
+    uint32_t x0 = wrapCoordinate((int)floorX, width, sampler.addressMode);
+    uint32_t x1 = wrapCoordinate((int)floorX + 1, width, sampler.addressMode);
+    uint32_t y0 = wrapCoordinate((int)floorY, height, sampler.addressMode);
+    uint32_t y1 = wrapCoordinate((int)floorY + 1, height, sampler.addressMode);
+    const Float4* texels = getTexels(slice, mip);
+    const Float4& t00 = texels[(size_t)y0 * width + x0];
+    const Float4& t10 = texels[(size_t)y0 * width + x1];
+    const Float4& t01 = texels[(size_t)y1 * width + x0];
+    const Float4& t11 = texels[(size_t)y1 * width + x1];
+
+    if (sampler.filter == RENDER_FILTER_MINIMUM || sampler.filter == RENDER_FILTER_MAXIMUM)
+    {
+        // Only the taps that carry weight take part, as in the D3D11 reduction filters.
+        Float4 result = t00;
+        if (fractionX > 0.0f)
+        {
+            result = reduce(sampler.filter, result, t10);
+        }
+        if (fractionY > 0.0f)
+        {
+            result = reduce(sampler.filter, result, t01);
+            if (fractionX > 0.0f)
+            {
+                result = reduce(sampler.filter, result, t11);
+            }
+        }
+        return result;
+    }
+    return lerp(lerp(t00, t10, fractionX), lerp(t01, t11, fractionX), fractionY);
+}
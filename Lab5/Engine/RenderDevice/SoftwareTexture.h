@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "RenderDevice.h"
+#include "RenderMath.h"
+
+struct SoftwareSampler
+{
+    RenderFilter filter = RENDER_FILTER_LINEAR;
+    RenderAddressMode addressMode = RENDER_ADDRESS_WRAP;
+};
+
+// Texture memory of the software backend. Every format is held as RGBA32F so shaders never decode texels; stores
+// round to the declared format, so an 8-bit or half target keeps the precision it would have on the GPU. Sampling
+// follows the D3D11 rules for the filters the renderer uses: bilinear within a mip, linear between mips, and the
+// minimum/maximum reductions over the same four taps.
+class SoftwareTexture
+{
+public:
+    explicit SoftwareTexture(const RenderTextureDesc& desc);
+
+    const RenderTextureDesc& getDesc() const;
+    uint32_t getWidth(uint32_t mip) const;
+    uint32_t getHeight(uint32_t mip) const;
+    Float4* getTexels(uint32_t slice, uint32_t mip);
+    const Float4* getTexels(uint32_t slice, uint32_t mip) const;
+
+    // Tightly packed rows in the texture's format; BC6H uploads decode to RGBA32F and cannot be downloaded.
+    void upload(uint32_t slice, uint32_t mip, const void* data);
+    void download(uint32_t slice, uint32_t mip, void* data) const;
+    void store(uint32_t slice, uint32_t mip, uint32_t x, uint32_t y, const Float4& value);
+    void clear(uint32_t slice, uint32_t mip, const Float4& value);
+
+    Float4 load(uint32_t slice, uint32_t mip, uint32_t x, uint32_t y) const;
+    Float4 sample(const SoftwareSampler& sampler, float u, float v, float lod, uint32_t slice = 0) const;
+    Float4 sampleCube(const SoftwareSampler& sampler, const Float3& direction, float lod) const;
+
+    Float4 quantize(const Float4& value) const;
+
+private:
+    RenderTextureDesc desc;
+    // Slice-major like D3D11CalcSubresource.
+    std::vector<std::vector<Float4>> subresources;
+
+    Float4 sampleMip(const SoftwareSampler& sampler, float u, float v, uint32_t mip, uint32_t slice) const;
+};
@@ -1,16 +1,35 @@
 #include "Renderer.h"
 
+#include <cstring>
 #include <iostream>
 #include <random>
+#include <string>
 
 #include "../ImGUI/imgui.h"
 #include "../ImGUI/imgui_impl_dx11.h"
 #include "../ImGUI/imgui_impl_win32.h"
 
 #include "tiny_obj_loader.h"
-#include "../STB/stb_image.h"
+#include "../DXShader/ShaderCompiler.h"
+#include "../Utils/FileSystemUtils.h"
+#include "../Utils/MemoryAccounting.h"
 
-#define PI 3.14159265359
+namespace
+{
+    double toMegabytes(uint64_t bytes)
+    {
+        return bytes / (1024.0 * 1024.0);
+    }
+
+    Float4x4 toFloat4x4(const XMMATRIX& matrix)
+    {
+        XMFLOAT4X4 stored;
+        XMStoreFloat4x4(&stored, matrix);
+        Float4x4 result;
+        memcpy(result.m, stored.m, sizeof(result.m));
+        return result;
+    }
+}
 
 DXSwapChain* Renderer::swapChain = nullptr;
 Renderer* Renderer::instance = nullptr;
@@ -19,8 +38,11 @@ void Renderer::resizeCallback(uint32_t width, uint32_t height)
 {
     if (swapChain)
     {
+        // The device holds a reference to the back buffer, which ResizeBuffers needs released.
+        instance->renderDevice->unregisterTexture(instance->backBuffer);
         swapChain->resize(width, height);
-        instance->toneMapper->resize(width, height);
+        instance->registerBackBuffer();
+        instance->sceneRenderer->resize(width, height);
     }
 }
 
@@ -32,237 +54,117 @@ Renderer::Renderer(Window* window) : engineWindow(window)
     window->getInputSystem()->addKeyCallback(&camera);
     window->getInputSystem()->addMouseCallback(&camera);
     window->getInputSystem()->addKeyCallback(this);
-    loadShader();
-    loadSphere();
-    loadConstants();
-    window->getInputSystem()->addKeyCallback(this);
-    keys.push_back({DIK_F1, KEY_DOWN});
-    keys.push_back({DIK_F2, KEY_DOWN});
-    keys.push_back({DIK_F3, KEY_DOWN});
-    device.getDeviceContext()->QueryInterface(IID_PPV_ARGS(&annotation));
-    toneMapper = new ToneMapper(device.getDevice(), annotation);
-    toneMapper->initialize(window->getWidth(), window->getHeight(), DX_SWAPCHAIN_DEFAULT_BUFFER_AMOUNT);
-
-    D3D11_SAMPLER_DESC desc = {};
-
-    desc.Filter = D3D11_FILTER_ANISOTROPIC;
-    desc.AddressU = D3D11_TEXTURE_ADDRESS_WRAP;
-    desc.AddressV = D3D11_TEXTURE_ADDRESS_WRAP;
-    desc.AddressW = D3D11_TEXTURE_ADDRESS_WRAP;
-    desc.MinLOD = -D3D11_FLOAT32_MAX;
-    desc.MaxLOD = D3D11_FLOAT32_MAX;
-    desc.MipLODBias = 0.0f;
-    desc.MaxAnisotropy = 16;
-    desc.ComparisonFunc = D3D11_COMPARISON_NEVER;
-    desc.BorderColor[0] = desc.BorderColor[1] = desc.BorderColor[2] = desc.BorderColor[3] = 1.0f;
-
-    if (FAILED(device.getDevice()->CreateSamplerState(&desc, &sampler)))
-    {
-        throw std::runtime_error("Failed to create sampler");
-    }
-
-    desc.Filter = D3D11_FILTER_MIN_MAG_MIP_LINEAR;
-    desc.AddressU = D3D11_TEXTURE_ADDRESS_CLAMP;
-    desc.AddressV = D3D11_TEXTURE_ADDRESS_CLAMP;
-    desc.AddressW = D3D11_TEXTURE_ADDRESS_CLAMP;
-
-    if (FAILED(device.getDevice()->CreateSamplerState(&desc, &avgSampler)))
+    constantRing = new ConstantRing(device.getDevice(), device.getDeviceContext());
+    renderDevice = new D3D11RenderDevice(device.getDevice(), device.getDeviceContext(), device.getStateCache(),
+                                         constantRing);
+    registerBackBuffer();
+
+    // Every shader stage compiles on the device's pool while the mesh and the environment load on this thread.
+    SceneRenderer::requestShaders(renderDevice);
+    MeshData sphere;
+    float color[] = {0.541, 0, 0.82745};
+    if (!makesphere3(sphere, color))
     {
-        throw std::runtime_error("Failed to create sampler");
+        throw std::runtime_error("Failed to load sphere mesh");
     }
-
-    
-    D3D11_RASTERIZER_DESC cmdesc = {};
-    ZeroMemory(&cmdesc, sizeof(D3D11_RASTERIZER_DESC));
-    cmdesc.FillMode = D3D11_FILL_SOLID;
-    cmdesc.CullMode = D3D11_CULL_NONE;
-    cmdesc.FrontCounterClockwise = true;
-    uint32_t stencRef = 0;
-    device.getDeviceContext()->RSGetState(&defaultRasterState);
-    device.getDeviceContext()->OMGetDepthStencilState(&defaultDepthState, &stencRef);
-
-    if (FAILED(device.getDevice()->CreateRasterizerState(&cmdesc, &skyboxRasterState)))
+    std::cout << "Sphere mesh: " << sphere.stats.sourceVertexCount << " source vertices, "
+        << sphere.stats.uniqueVertexCount << " unique vertices, " << sphere.stats.indexSize * 8 << "-bit indices, "
+        << "compression ratio " << sphere.stats.compressionRatio << std::endl;
+    std::cout << "    vertex cache: ACMR " << sphere.stats.importedCache.acmr << " -> "
+        << sphere.stats.optimizedCache.acmr << ", ATVR " << sphere.stats.importedCache.atvr << " -> "
+        << sphere.stats.optimizedCache.atvr << std::endl;
+    sceneRenderer = new SceneRenderer(renderDevice);
+    sceneRenderer->initialize(window->getWidth(), window->getHeight(), sphere);
+    const std::vector<SphereLevel>& sphereLevels = sceneRenderer->getSphereLevels();
+    for (size_t i = 0; i < sphereLevels.size(); i++)
     {
-        throw std::runtime_error("Failed to create raster state");
+        std::cout << "    LOD " << i << ": " << sphereLevels[i].indexCount / 3 << " triangles, error "
+            << sphereLevels[i].error << std::endl;
     }
+    const VertexEncodingStats& encodingStats = sceneRenderer->getVertexEncodingStats();
+    std::cout << "    vertex format: " << encodingStats.sourceBytesPerVertex << " -> " << encodingStats.bytesPerVertex
+        << " bytes per vertex, position error " << encodingStats.positionError << ", UV error "
+        << encodingStats.uvError << ", normal error " << encodingStats.normalErrorDegrees << " degrees" << std::endl;
+    auto workDir = FileSystemUtils::getCurrentDirectoryPath();
+    sceneRenderer->loadEnvironment(std::string(workDir.begin(), workDir.end()), "hdr_room2.hdr");
 
-    D3D11_DEPTH_STENCIL_DESC dssDesc;
-    ZeroMemory(&dssDesc, sizeof(D3D11_DEPTH_STENCIL_DESC));
-    dssDesc.DepthEnable = true;
-    dssDesc.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ALL;
-    dssDesc.DepthFunc = D3D11_COMPARISON_LESS_EQUAL;
+    window->getInputSystem()->addKeyCallback(this);
+    keys.push_back({DIK_F1, KEY_DOWN});
+    keys.push_back({DIK_F2, KEY_DOWN});
+    keys.push_back({DIK_F3, KEY_DOWN});
+    profiler = new FrameProfiler(device.getDevice(), device.getDeviceContext());
+    renderDevice->setProfiler(profiler);
+    loadImgui();
 
-    if (FAILED(device.getDevice()->CreateDepthStencilState(&dssDesc, &skyboxDepthState)))
+    MemoryStats memoryStats = MemoryAccounting::getStats();
+    std::cout << "GPU memory after startup: " << toMegabytes(memoryStats.currentBytes) << " MB, peak "
+        << toMegabytes(memoryStats.peakBytes) << " MB" << std::endl;
+    for (const auto& category : memoryStats.categories)
     {
-        throw std::runtime_error("Failed to create depth state");
+        std::cout << "    " << category.name << ": " << toMegabytes(category.currentBytes) << " MB, peak "
+            << toMegabytes(category.peakBytes) << " MB" << std::endl;
     }
-    loadImgui();
-    loadCubeMap();
 }
 
-void calcSkyboxSize(SkyboxConfig& config, uint32_t width, uint32_t height, float fovDeg)
+void Renderer::registerBackBuffer()
 {
-    float n = 0.01f;
-    float fov = XMConvertToRadians(fovDeg);
-    float halfW = tanf(fov / 2) * n;
-    float halfH = height / float(width) * halfW;
-    config.size.x = sqrtf(n * n + halfH * halfH + halfW * halfW) * 1.1f;
+    backBuffer = renderDevice->registerTexture(swapChain->getBackBuffer(), "Back buffer");
 }
 
 void Renderer::drawFrame()
 {
-    drawGui();
-    shaderConstant.cameraMatrix = camera.getViewMatrix();
-
-    XMMATRIX mProjection = DirectX::XMMatrixPerspectiveFovLH(XMConvertToRadians(90),
-                                                             (float)engineWindow->getWidth() / (float)engineWindow->
-                                                             getHeight(), 0.001f, 2000.0f);
-    shaderConstant.cameraMatrix = XMMatrixMultiply(shaderConstant.cameraMatrix, mProjection);
-    skyboxConfig.cameraMatrix = shaderConstant.cameraMatrix;
-    skyboxConfig.cameraPosition = camera.getPosition();
-    calcSkyboxSize(skyboxConfig, engineWindow->getWidth(), engineWindow->getHeight(), 90);
-
-    lightConstantData.cameraPosition = camera.getPosition();
-    constantBuffer->updateData(device.getDeviceContext(), &shaderConstant);
-    lightConstant->updateData(device.getDeviceContext(), &lightConstantData);
-    pbrConfiguration->updateData(device.getDeviceContext(), &configuration);
-    skyboxConfigConstant->updateData(device.getDeviceContext(), &skyboxConfig);
-
-#ifdef _DEBUG
-    annotation->BeginEvent(L"Clear render targets");
-#endif
-    
-    toneMapper->clearRenderTarget(device.getDeviceContext(), swapChain->getCurrentImage());
-#ifdef _DEBUG
-    annotation->EndEvent();
-    annotation->EndEvent();
-#endif
-#ifdef _DEBUG
-    annotation->BeginEvent(L"Rendering skybox");
-#endif
-    toneMapper->getRendertargetView()->bind(device.getDeviceContext(), engineWindow->getWidth(),
-                                            engineWindow->getHeight(), swapChain->getCurrentImage());
-    cubeMapShader->bind(device.getDeviceContext());
-    device.getDeviceContext()->PSSetSamplers(0, 1, &sampler);
-    skyboxConfigConstant->bindToVertexShader(device.getDeviceContext());
-    device.getDeviceContext()->PSSetShaderResources(0, 1, &cubemap.cubemapSRV);
-    device.getDeviceContext()->OMSetDepthStencilState(skyboxDepthState, 1);
-    device.getDeviceContext()->RSSetState(skyboxRasterState);
-    cubeMapShader->draw(device.getDeviceContext(), sphereIndex, sphereVertex);
-
-    toneMapper->getRendertargetView()->clearDepthAttachments(device.getDeviceContext());
-#ifdef _DEBUG
-    annotation->EndEvent();
-#endif
-#ifdef _DEBUG
-    annotation->BeginEvent(L"Rendering pbr light");
-#endif
-    shader->bind(device.getDeviceContext());
-    ID3D11SamplerState* samplers[] = {sampler, avgSampler};
-    
-    device.getDeviceContext()->PSSetSamplers(0, 2, samplers);
-    ID3D11ShaderResourceView* resources[] = {cubemap.irradianceSRV, cubemap.prefilteredSRV, cubemap.brdfSRV};
-    
-    device.getDeviceContext()->PSSetShaderResources(0, 3, resources);
-
-    constantBuffer->bindToVertexShader(device.getDeviceContext());
-    lightConstant->bindToPixelShader(device.getDeviceContext());
-    pbrConfiguration->bindToPixelShader(device.getDeviceContext(), 1);
-    device.getDeviceContext()->OMSetDepthStencilState(defaultDepthState, 1);
-    device.getDeviceContext()->RSSetState(defaultRasterState);
-    shader->draw(device.getDeviceContext(), sphereIndex, sphereVertex);
-#ifdef _DEBUG
-    annotation->EndEvent();
-#endif
-    toneMapper->makeBrightnessMaps(device.getDeviceContext(), swapChain->getCurrentImage());
-    swapChain->clearRenderTargets(device.getDeviceContext(), 0, 0, 0, 1.0f);
-    device.getDeviceContext()->PSSetSamplers(0, 1, &sampler);
-
-    swapChain->bind(device.getDeviceContext(), engineWindow->getWidth(), engineWindow->getHeight());
-    toneMapper->postProcessToneMap(device.getDeviceContext(), swapChain->getCurrentImage());
-    ImGui::Render();
-    ImGui_ImplDX11_RenderDrawData(ImGui::GetDrawData());
-    DXDevice::unBindRenderTargets(device.getDeviceContext());
-    swapChain->present(true);
-}
-
-
-void Renderer::loadShader()
-{
-    std::vector<ShaderCreateInfo> shadersInfos;
-    shadersInfos.push_back({L"Shaders/Lighting/VertexShader.hlsl", VERTEX_SHADER, "Lab5 cube vertex shader"});
-    shadersInfos.push_back({L"Shaders/Lighting/PBRPixelShader.hlsl", PIXEL_SHADER, "Lab5 cube pixel shader"});
-    shader = Shader::loadShader(device.getDevice(), shadersInfos.data(), (uint32_t)shadersInfos.size());
-    std::vector<ShaderVertexInput> vertexInputs;
-    vertexInputs.push_back({"POSITION", 0, sizeof(float) * 3, DXGI_FORMAT_R32G32B32_FLOAT});
-    vertexInputs.push_back({"UV", 0, sizeof(float) * 2, DXGI_FORMAT_R32G32_FLOAT});
-    vertexInputs.push_back({"NORMAL", 0, sizeof(float) * 3, DXGI_FORMAT_R32G32B32_FLOAT});
-    vertexInputs.push_back({"COLOR", 0, sizeof(float) * 3, DXGI_FORMAT_R32G32B32A32_FLOAT});
-
-    shader->makeInputLayout(device.getDevice(), vertexInputs.data(), (uint32_t)vertexInputs.size());
-
-
-    shadersInfos.clear();
-    shadersInfos.push_back({L"Shaders/Skybox/skyboxVS.hlsl", VERTEX_SHADER, "Lab5 skybox vertex shader"});
-    shadersInfos.push_back({L"Shaders/Skybox/skyboxPS.hlsl", PIXEL_SHADER, "Lab5 skybox pixel shader"});
-    cubeMapShader = Shader::loadShader(device.getDevice(), shadersInfos.data(), shadersInfos.size());;
-    cubeMapShader->makeInputLayout(device.getDevice(), vertexInputs.data(), vertexInputs.size());
-}
+    renderDevice->beginFrame();
+    SceneView view;
+    {
+        ProfileScope scope(profiler, "Update");
+        drawGui();
+        sceneRenderer->setSphereGridSize(sphereGridSize);
+        sceneRenderer->setScatteredLightCount(scatteredLightCount);
+        sceneRenderer->setLodErrorPixels(lodErrorPixels);
+        view.width = engineWindow->getWidth();
+        view.height = engineWindow->getHeight();
+        view.viewMatrix = toFloat4x4(camera.getViewMatrix());
+        XMFLOAT3 position = camera.getPosition();
+        view.cameraPosition = RenderMath::makeFloat3(position.x, position.y, position.z);
+    }
 
-void Renderer::loadSphere()
-{
-    std::vector<float> vertices;
-    std::vector<uint32_t> indices;
-    float color[] = {0.541, 0, 0.82745};
-    makesphere3(vertices, indices, color);
-    sphereVertex = new VertexBuffer(device.getDevice(), vertices.size() * sizeof(float), sizeof(float)*11,
-                                              vertices.data(),
-                                              "Sphere vertex buffer");
-    sphereIndex = new IndexBuffer(device.getDevice(), indices.data(), indices.size(),
-                                            "Sphere index buffer");
+    sceneRenderer->drawFrame(view, backBuffer, [this]()
+    {
+        ImGui::Render();
+        ImGui_ImplDX11_RenderDrawData(ImGui::GetDrawData());
+        // The ImGui backend sets its own pipeline state directly on the context.
+        renderDevice->invalidateState();
+    });
+    {
+        ProfileScope scope(profiler, "Present");
+        swapChain->present(true);
+    }
+    renderDevice->endFrame();
 }
 
 void Renderer::release()
 {
-    delete sphereVertex;
-    delete sphereIndex;
-    delete constantBuffer;
-    delete shader;
+    sceneRenderer->destroy();
+    delete sceneRenderer;
+    renderDevice->unregisterTexture(backBuffer);
+    delete renderDevice;
     delete swapChain;
-    toneMapper->destroy();
-    delete toneMapper;
-    sampler->Release();
-    skyboxDepthState->Release();
-    skyboxRasterState->Release();
-    cubemap.cubemapSRV->Release();
-    cubemap.cubemapTexture->Release();
-    
-    cubemap.irradianceSRV->Release();
-    cubemap.irradianceTexture->Release();
-    
-    cubemap.prefilteredSRV->Release();
-    cubemap.prefilteredTexture->Release();
-    cubemap.brdfTexture->Release();
-    cubemap.brdfSRV->Release();
-    
-    annotation->Release();
+    delete profiler;
 
     ImGui_ImplWin32_Shutdown();
     ImGui_ImplDX11_Shutdown();
     ImGui::DestroyContext();
-    delete cubeMapShader;
-    delete lightConstant;
-    delete pbrConfiguration;
-    delete skyboxConfigConstant;
+    delete constantRing;
 }
 
 void Renderer::keyEvent(WindowKey key)
 {
     uint32_t index = key.key - DIK_F1;
-    lightConstantData.sources[index].intensity *= 100;
-    if (lightConstantData.sources[index].intensity > 1000000)
+    PointLightSource& source = sceneRenderer->getLights()[index];
+    source.intensity *= 100;
+    if (source.intensity > 1000000)
     {
-        lightConstantData.sources[index].intensity = 1;
+        source.intensity = 1;
     }
 }
 
@@ -275,7 +177,7 @@ WindowKey* Renderer::getKeys(uint32_t* pKeysAmountOut)
 
 
 
-void Renderer::makesphere3(std::vector<float>& verticesOutput, std::vector<uint32_t>& indicesOutput, float* defaultColor)
+bool Renderer::makesphere3(MeshData& meshOutput, float* defaultColor)
 {
     tinyobj::attrib_t inattrib;
     std::vector<tinyobj::shape_t> inshapes;
@@ -289,34 +191,11 @@ void Renderer::makesphere3(std::vector<float>& verticesOutput, std::vector<uint3
     bool ret = tinyobj::LoadObj(&inattrib, &inshapes, &materials, &err, s.c_str());
     if (!err.empty()) {
         std::cerr << err << std::endl;
-        return;
-    }
-    
-    uint32_t idCounter = 0;
-    for (auto shape : inshapes)
-    {
-        for (auto index : shape.mesh.indices)
-        {
-            verticesOutput.push_back(inattrib.vertices[index.vertex_index*3]);
-            verticesOutput.push_back(inattrib.vertices[index.vertex_index*3+1]);
-            verticesOutput.push_back(inattrib.vertices[index.vertex_index*3+2]);
-
-            verticesOutput.push_back(inattrib.texcoords[index.texcoord_index*2]);
-            verticesOutput.push_back(inattrib.texcoords[index.texcoord_index*2+1]);
-            
-            verticesOutput.push_back(inattrib.normals[index.normal_index*3]);
-            verticesOutput.push_back(inattrib.normals[index.normal_index*3+1]);
-            verticesOutput.push_back(inattrib.normals[index.normal_index*3+2]);
-
-            verticesOutput.push_back(defaultColor[0]);
-            verticesOutput.push_back(defaultColor[1]);
-            verticesOutput.push_back(defaultColor[2]);
-
-            indicesOutput.push_back(idCounter);
-            idCounter++;
-        }
+        return false;
     }
 
+    meshOutput = MeshBuilder::buildIndexed(inattrib, inshapes, defaultColor);
+    return ret;
 }
 
 void Renderer::drawGui()
@@ -324,6 +203,9 @@ void Renderer::drawGui()
     ImGui_ImplDX11_NewFrame();
     ImGui_ImplWin32_NewFrame();
     ImGui::NewFrame();
+    PBRConfiguration& configuration = sceneRenderer->getConfiguration();
+    std::vector<PointLightSource>& lights = sceneRenderer->getLights();
+    ToneMapper* toneMapper = sceneRenderer->getToneMapper();
     ImGui::Begin("PBR configuration: ");
     ImGui::Text("Light pbr configuration: ");
     ImGui::SliderFloat("Ambient intensity", &configuration.ambientIntensity, 0, 50);
@@ -352,54 +234,107 @@ void Renderer::drawGui()
         }
     }
 
+    ImGui::Combo("Irradiance", &configuration.irradianceMode, "spherical harmonics\0irradiance cubemap\0");
+
+    static int reductionMode = LUMINANCE_REDUCTION_COMPUTE;
+    if (ImGui::Combo("Luminance reduction", &reductionMode, "compute shader\0pixel shader pyramid\0"))
+    {
+        toneMapper->setReductionMode(reductionMode);
+    }
+    static int exposureMode = LUMINANCE_EXPOSURE_AVERAGE;
+    if (ImGui::Combo("Exposure", &exposureMode, "log average\0histogram percentile (compute only)\0"))
+    {
+        toneMapper->setExposureMode(exposureMode);
+    }
+
+    const LuminanceReadbackStats& readbackStats = toneMapper->getReadbackStats();
+    ImGui::Text("Luminance readback: %llu frames old, %.3f ms stall (max %.3f ms), %llu dropped",
+                readbackStats.lastLatencyFrames, readbackStats.lastStallMs, readbackStats.maxStallMs,
+                readbackStats.droppedSamples);
+    ShaderCompilerStats shaderStats = ShaderCompiler::getStats();
+    ImGui::Text("Shaders: %u loaded from cache, %u compiled", shaderStats.cacheHits, shaderStats.compiled);
+    ConstantRingStats ringStats = constantRing->getStats();
+    ImGui::Text("Constants: %llu uploads (%llu KB), %llu unchanged, %llu ring resets%s", ringStats.uploads,
+                ringStats.uploadedBytes / 1024, ringStats.skippedUploads, ringStats.bufferResets,
+                constantRing->isOffsetBindingSupported() ? "" : " (no offset binding)");
+    StateCacheStats stateStats = device.getStateCache()->getFrameStats();
+    ImGui::Text("State calls: %u issued, %u redundant skipped", stateStats.issued, stateStats.skipped);
+    const FrameGraphStats& frameGraphStats = sceneRenderer->getFrameGraphStats();
+    ImGui::Text("Frame graph: %u passes (%u culled), %u transient textures in %u (%llu KB)",
+                frameGraphStats.passCount, frameGraphStats.culledPassCount, frameGraphStats.transientTextureCount,
+                frameGraphStats.physicalTextureCount, sceneRenderer->getTransientBytes() / 1024);
+    MemoryStats memoryStats = MemoryAccounting::getStats();
+    ImGui::Text("GPU memory: %.1f MB (peak %.1f MB)", toMegabytes(memoryStats.currentBytes),
+                toMegabytes(memoryStats.peakBytes));
+    for (const auto& category : memoryStats.categories)
+    {
+        ImGui::Text("    %s: %.1f MB (peak %.1f MB)", category.name.c_str(), toMegabytes(category.currentBytes),
+                    toMegabytes(category.peakBytes));
+    }
+
     ImGui::Text("Mesh configuration");
+    ImGui::SliderInt("Sphere grid", &sphereGridSize, 1, SceneRenderer::MAX_SPHERE_GRID_SIZE);
+    const CullStats& cullStats = sceneRenderer->getCullStats();
+    ImGui::Text("%u of %d spheres in view (%u of %u BVH nodes visited)", cullStats.visibleObjects,
+                sphereGridSize * sphereGridSize, cullStats.visitedNodes,
+                sceneRenderer->getSceneObjects().getNodeCount());
+    ImGui::SliderFloat("LOD error (pixels)", &lodErrorPixels, 0, 8);
+    const std::vector<SphereLevel>& sphereLevels = sceneRenderer->getSphereLevels();
+    for (size_t i = 0; i < sphereLevels.size(); i++)
+    {
+        ImGui::Text("    LOD %zu: %u triangles, error %.4f, %zu spheres", i, sphereLevels[i].indexCount / 3,
+                    sphereLevels[i].error, sphereLevels[i].instances.size());
+    }
     ImGui::SliderFloat("Metallic value", &configuration.metallic, 0.001, 1);
     ImGui::SliderFloat("Roughness value", &configuration.roughness, 0.001, 1);
     ImGui::Text("Lights configuration");
-    float lightsPosition[3][3];
-    for (uint32_t i = 0; i < 3; i++)
+    for (uint32_t i = 0; i < SceneRenderer::MAIN_LIGHT_COUNT; i++)
     {
-        lightsPosition[i][0] = lightConstantData.sources[i].position.x;
-        lightsPosition[i][1] = lightConstantData.sources[i].position.y;
-        lightsPosition[i][2] = lightConstantData.sources[i].position.z;
+        float lightPosition[3] = {lights[i].position.x, lights[i].position.y, lights[i].position.z};
+        std::string label = "Light " + std::to_string(i + 1);
+        ImGui::DragFloat3((label + " position").c_str(), lightPosition);
+        ImGui::SliderFloat((label + " intensity").c_str(), &lights[i].intensity, 0, 10000);
+        ImGui::SliderFloat((label + " radius").c_str(), &lights[i].radius, 0.1f, 200);
+        lights[i].position = RenderMath::makeFloat3(lightPosition[0], lightPosition[1], lightPosition[2]);
     }
-    ImGui::DragFloat3("Light 1 position", lightsPosition[0]);
-    ImGui::SliderFloat("Light 1 intensity", &lightConstantData.sources[0].intensity, 0, 10000);
-    ImGui::DragFloat3("Light 2 position", lightsPosition[1]);
-    ImGui::SliderFloat("Light 2 intensity", &lightConstantData.sources[1].intensity, 0, 10000);
-    ImGui::DragFloat3("Light 3 position", lightsPosition[2]);
-    ImGui::SliderFloat("Light 3 intensity", &lightConstantData.sources[2].intensity, 0, 10000);
-    for (uint32_t i = 0; i < 3; i++)
+    ImGui::SliderInt("Scattered lights", &scatteredLightCount, 0, (int)SceneRenderer::MAX_SCATTERED_LIGHTS);
+    const LightClusters* lightClusters = sceneRenderer->getLightClusters();
+    ImGui::Text("%zu lights, %zu cluster entries, at most %u in one cluster", lights.size(),
+                lightClusters->getLightIndices().size(), lightClusters->getMaxClusterLights());
+    ImGui::End();
+
+    ImGui::Begin("Profiler");
+    const FrameProfilerStats& profilerStats = profiler->getStats();
+    ImGui::Text("%llu frames collected, %llu dropped, %llu disjoint", profilerStats.collectedFrames,
+                profilerStats.droppedFrames, profilerStats.disjointFrames);
+    for (const ProfilePassStats& pass : profiler->getAggregator().getPassStats())
     {
-        lightConstantData.sources[i].position.x = lightsPosition[i][0];
-        lightConstantData.sources[i].position.y = lightsPosition[i][1];
-        lightConstantData.sources[i].position.z = lightsPosition[i][2];
+        if (pass.hasGpu)
+        {
+            ImGui::Text("%*s%-28s cpu %6.3f ms  gpu %6.3f ms (max %6.3f)", pass.depth * 2, "", pass.name.c_str(),
+                        pass.cpuAverageMs, pass.gpuAverageMs, pass.gpuMaxMs);
+        }
+        else
+        {
+            ImGui::Text("%*s%-28s cpu %6.3f ms", pass.depth * 2, "", pass.name.c_str(), pass.cpuAverageMs);
+        }
+    }
+    if (ImGui::Button("Export Chrome trace"))
+    {
+        try
+        {
+            profiler->exportChromeTrace("profile_trace.json");
+            std::cout << "Profiler trace written to profile_trace.json" << std::endl;
+        }
+        catch (const std::runtime_error& error)
+        {
+            std::cerr << error.what() << std::endl;
+        }
     }
     ImGui::End();
 }
 
 
-void Renderer::loadConstants()
-{
-    ZeroMemory(&shaderConstant, sizeof(ShaderConstant));
-    shaderConstant.worldMatrix = DirectX::XMMatrixIdentity()*XMMatrixScaling(3, 3, 3);
-    constantBuffer = new ConstantBuffer(device.getDevice(), &shaderConstant, sizeof(ShaderConstant),
-                                        "Camera and mesh transform matrices");
-
-    lightConstantData.sources[0].position = XMFLOAT3(0, 5, 0);
-    lightConstantData.sources[1].position = XMFLOAT3(-5, 0, 0);
-    lightConstantData.sources[2].position = XMFLOAT3(0, -5, -5);
-
-    lightConstant = new ConstantBuffer(device.getDevice(), &lightConstantData, sizeof(lightConstantData),
-                                       "Light sources infos");
-
-    pbrConfiguration = new ConstantBuffer(device.getDevice(), &pbrConfiguration, sizeof(PBRConfiguration),
-                                          "PBR configuration buffer");
-    skyboxConfig.worldMatrix = DirectX::XMMatrixIdentity();
-    skyboxConfigConstant = new ConstantBuffer(device.getDevice(), &skyboxConfig, sizeof(SkyboxConfig),
-                                              "Skybox configuration");
-}
-
 void Renderer::loadImgui()
 {
     IMGUI_CHECKVERSION();
@@ -417,14 +352,3 @@ void Renderer::loadImgui()
         throw std::runtime_error("Failed to initialize imgui");
     }
 }
-
-
-void Renderer::loadCubeMap()
-{
-    CubemapGenerator generator(&device);
-    generator.loadHDRCubemap("hdr_room2.hdr", &cubemap);
-
-    cubemap.sourceTexture->Release();
-    cubemap.sourceResourceView->Release();
-    generator.destroy();
-}
@@ -1,52 +1,13 @@
 #pragma once
-#include "ToneMapper.h"
+#include "SceneRenderer.h"
 #include "../DXDevice/DXSwapChain.h"
 #include "../DXDevice/DXDevice.h"
-#include "../DXShader/Shader.h"
-#include "../DXShader/ConstantBuffer.h"
+#include "../DXShader/ConstantRing.h"
 #include "Camera/Camera.h"
 #include <d3d11_1.h>
-#include "CubemapGenerator.h"
-struct PBRConfiguration
-{
-    int defaultFunction = 1;
-    int normalDistribution = 0;
-    int fresnelFunction = 0;
-    int geometryFunction = 0;
-
-    float metallic = 0.9;
-    float roughness = 0.03;
-    float ambientIntensity = 15.0f;
-    float alignment;
-};
-
-
-struct ShaderConstant
-{
-    XMMATRIX worldMatrix;
-    XMMATRIX cameraMatrix;
-};
-
-struct SkyboxConfig
-{
-    XMMATRIX worldMatrix;
-    XMMATRIX cameraMatrix;
-    XMFLOAT4 size;
-    XMFLOAT3 cameraPosition;
-
-};
-
-struct PointLightSource
-{
-    XMFLOAT3 position;
-    float intensity = 0;
-};
-
-struct LightConstant
-{
-    PointLightSource sources[3];
-    XMFLOAT3 cameraPosition;
-};
+#include "Profiler/FrameProfiler.h"
+#include "RenderDevice/D3D11RenderDevice.h"
+#include "Mesh/MeshBuilder.h"
 
 struct Vertex
 {
@@ -70,43 +31,23 @@ private:
     Window* engineWindow;
     DXDevice device;
     std::vector<WindowKey> keys;
-    Shader* shader;
-    Shader* cubeMapShader;
-    ShaderConstant shaderConstant{};
-    alignas(256) LightConstant lightConstantData{};
-    PBRConfiguration configuration;
-    SkyboxConfig skyboxConfig{};
-    ConstantBuffer* constantBuffer;
-    ConstantBuffer* lightConstant;
-    ConstantBuffer* pbrConfiguration;
-    ConstantBuffer* skyboxConfigConstant;
-    ToneMapper* toneMapper;
-    ID3D11SamplerState* sampler;
-    ID3D11SamplerState* avgSampler;
-    
-    VertexBuffer* sphereVertex = nullptr;
-    IndexBuffer* sphereIndex = nullptr;
+    ConstantRing* constantRing;
+    D3D11RenderDevice* renderDevice;
+    SceneRenderer* sceneRenderer;
+    RenderTexture backBuffer = RENDER_NULL_HANDLE;
+    int sphereGridSize = 1;
+    int scatteredLightCount = 0;
+    float lodErrorPixels = 1.0f;
     Camera camera;
-    ID3DUserDefinedAnnotation* annotation;
-    
-    HDRCubemap cubemap;
-
-    ID3D11DepthStencilState* skyboxDepthState;
-    ID3D11RasterizerState* skyboxRasterState;
-
-    ID3D11DepthStencilState* defaultDepthState;
-    ID3D11RasterizerState* defaultRasterState;
+    FrameProfiler* profiler;
 public:
     void drawFrame();
     void release();
     void keyEvent(WindowKey key) override;
     WindowKey* getKeys(uint32_t* pKeysAmountOut) override;
-    void makesphere3(std::vector<float>& verticesOutput, std::vector<uint32_t>& indicesOutput, float* defaultColor);
+    bool makesphere3(MeshData& meshOutput, float* defaultColor);
 private:
     void drawGui();
-    void loadShader();
-    void loadSphere();
-    void loadConstants();
     void loadImgui();
-    void loadCubeMap();
+    void registerBackBuffer();
 };
@@ -0,0 +1,727 @@
+#include "SceneRenderer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <stdexcept>
+
+namespace
+{
+    const char* MEMORY_CATEGORY = "Scene";
+    const float NEAR_PLANE = 0.001f;
+    const float FAR_PLANE = 2000.0f;
+    const uint32_t MIN_LIGHT_BUFFER_CAPACITY = 64;
+    const uint32_t SCATTERED_LIGHT_SEED = 1234;
+    // Scattered lights fill a slab around the largest sphere grid.
+    const float SCATTER_EXTENT = 80.0f;
+    const float SCATTER_DEPTH = 16.0f;
+
+    // Stream 0 follows the encoding of the sphere, see MeshEncoder::getAttributes.
+    const RenderVertexAttribute INSTANCE_ATTRIBUTES[] = {
+        {"INSTANCE_WORLD", 0, RENDER_FORMAT_R32G32B32A32_FLOAT, 1, true},
+        {"INSTANCE_WORLD", 1, RENDER_FORMAT_R32G32B32A32_FLOAT, 1, true},
+        {"INSTANCE_WORLD", 2, RENDER_FORMAT_R32G32B32A32_FLOAT, 1, true},
+        {"INSTANCE_WORLD", 3, RENDER_FORMAT_R32G32B32A32_FLOAT, 1, true},
+        {"INSTANCE_ALBEDO", 0, RENDER_FORMAT_R32G32B32A32_FLOAT, 1, true},
+        {"INSTANCE_MATERIAL", 0, RENDER_FORMAT_R32G32_FLOAT, 1, true}
+    };
+
+    const RenderShaderDesc LIGHTING_VS = {
+        RENDER_STAGE_VERTEX, L"Shaders/Lighting/VertexShader.hlsl", nullptr, 0, "Lab5 cube vertex shader"
+    };
+    const RenderShaderDesc LIGHTING_PS = {
+        RENDER_STAGE_PIXEL, L"Shaders/Lighting/PBRPixelShader.hlsl", nullptr, 0, "Lab5 cube pixel shader"
+    };
+    const RenderShaderDesc SKYBOX_VS = {
+        RENDER_STAGE_VERTEX, L"Shaders/Skybox/skyboxVS.hlsl", nullptr, 0, "Lab5 skybox vertex shader"
+    };
+    const RenderShaderDesc SKYBOX_PS = {
+        RENDER_STAGE_PIXEL, L"Shaders/Skybox/skyboxPS.hlsl", nullptr, 0, "Lab5 skybox pixel shader"
+    };
+
+    void calcSkyboxSize(SkyboxConfig& config, uint32_t width, uint32_t height, float fovDeg)
+    {
+        float n = 0.01f;
+        float fov = fovDeg * RenderMath::PI / 180.0f;
+        float halfW = tanf(fov / 2) * n;
+        float halfH = height / float(width) * halfW;
+        config.size.x = sqrtf(n * n + halfH * halfH + halfW * halfW) * 1.1f;
+    }
+
+    // The box around a box moved by an affine row vector matrix.
+    void transformBounds(const Float3& boundsMin, const Float3& boundsMax, const Float4x4& matrix, Float3* pMin,
+                         Float3* pMax)
+    {
+        const float center[3] = {(boundsMin.x + boundsMax.x) * 0.5f, (boundsMin.y + boundsMax.y) * 0.5f,
+                                 (boundsMin.z + boundsMax.z) * 0.5f};
+        const float extent[3] = {(boundsMax.x - boundsMin.x) * 0.5f, (boundsMax.y - boundsMin.y) * 0.5f,
+                                 (boundsMax.z - boundsMin.z) * 0.5f};
+        float outputMin[3];
+        float outputMax[3];
+        for (int column = 0; column < 3; column++)
+        {
+            float outputCenter = matrix.m[3][column];
+            float outputExtent = 0.0f;
+            for (int row = 0; row < 3; row++)
+            {
+                outputCenter += center[row] * matrix.m[row][column];
+                outputExtent += extent[row] * fabsf(matrix.m[row][column]);
+            }
+            outputMin[column] = outputCenter - outputExtent;
+            outputMax[column] = outputCenter + outputExtent;
+        }
+        *pMin = RenderMath::makeFloat3(outputMin[0], outputMin[1], outputMin[2]);
+        *pMax = RenderMath::makeFloat3(outputMax[0], outputMax[1], outputMax[2]);
+    }
+
+    // The center moves with the matrix; the radius grows with the longest of its scaled axes.
+    Float4 transformSphere(const Float3& center, float radius, const Float4x4& matrix)
+    {
+        float output[3];
+        float scaleSquared = 0.0f;
+        for (int column = 0; column < 3; column++)
+        {
+            output[column] = matrix.m[3][column] + center.x * matrix.m[0][column] + center.y * matrix.m[1][column] +
+                             center.z * matrix.m[2][column];
+            float rowSquared = matrix.m[column][0] * matrix.m[column][0] + matrix.m[column][1] * matrix.m[column][1] +
+                               matrix.m[column][2] * matrix.m[column][2];
+            scaleSquared = std::max(scaleSquared, rowSquared);
+        }
+        return RenderMath::makeFloat4(output[0], output[1], output[2], radius * sqrtf(scaleSquared));
+    }
+}
+
+SceneRenderer::SceneRenderer(RenderDevice* device) : device(device)
+{
+}
+
+void SceneRenderer::requestShaders(RenderDevice* device)
+{
+    device->requestShader(LIGHTING_VS);
+    device->requestShader(LIGHTING_PS);
+    device->requestShader(SKYBOX_VS);
+    device->requestShader(SKYBOX_PS);
+    ToneMapper::requestShaders(device);
+}
+
+void SceneRenderer::initialize(uint32_t width, uint32_t height, const MeshData& sphere)
+{
+    threadPool = new ThreadPool();
+    loadSphere(sphere);
+    loadShaders();
+    loadConstants();
+    lightClusters = new LightClusters(threadPool);
+    toneMapper = new ToneMapper(device);
+    toneMapper->initialize(width, height, ToneMapper::DEFAULT_HDR_RING_SIZE);
+    texturePool = new TransientTexturePool(device);
+
+    sampler = device->createSampler(RENDER_FILTER_ANISOTROPIC, RENDER_ADDRESS_WRAP);
+    clampSampler = device->createSampler(RENDER_FILTER_LINEAR, RENDER_ADDRESS_CLAMP);
+}
+
+void SceneRenderer::loadEnvironment(const std::string& directory, const std::string& name)
+{
+    CubemapGenerator generator(device);
+    generator.loadHDRCubemap(directory, name, &cubemap);
+    generator.destroy();
+    createIrradianceConstant();
+}
+
+void SceneRenderer::loadEnvironment(const std::string& directory, const HDRImage& image, ThreadPool* threadPool)
+{
+    CubemapGenerator generator(device);
+    generator.loadBRDFLut(directory, &cubemap);
+    generator.renderHDRCubemap(image, threadPool, &cubemap);
+    generator.destroy();
+    createIrradianceConstant();
+}
+
+void SceneRenderer::resize(uint32_t width, uint32_t height)
+{
+    toneMapper->resize(width, height);
+}
+
+void SceneRenderer::drawFrame(const SceneView& view, RenderTexture backBuffer, const std::function<void()>& overlay)
+{
+    updateConstants(view);
+    updateInstances();
+    cullInstances(view);
+
+    toneMapper->beginFrame();
+    RenderTexture hdrTexture = toneMapper->getHdrTarget();
+    FrameGraphTextureDesc hdrDesc;
+    hdrDesc.width = view.width;
+    hdrDesc.height = view.height;
+    hdrDesc.format = ToneMapper::HDR_FORMAT;
+    hdrDesc.usage = RENDER_BIND_RENDER_TARGET | RENDER_BIND_SHADER_RESOURCE;
+    FrameGraphTextureDesc backBufferDesc = hdrDesc;
+    backBufferDesc.format = RENDER_FORMAT_R8G8B8A8_UNORM;
+    backBufferDesc.usage = RENDER_BIND_RENDER_TARGET;
+
+    FrameGraph frameGraph;
+    FrameGraphResource hdrTarget = frameGraph.importTexture("HDR scene", hdrDesc);
+    FrameGraphResource backBufferTarget = frameGraph.importTexture("Back buffer", backBufferDesc);
+
+    FrameGraphPass skyboxPass = frameGraph.addPass("Skybox", [&]()
+    {
+        RenderScope scope(device, "Skybox");
+        drawSkybox(hdrTexture);
+    });
+    frameGraph.write(skyboxPass, hdrTarget);
+
+    FrameGraphPass lightingPass = frameGraph.addPass("PBR lighting", [&]()
+    {
+        RenderScope scope(device, "PBR lighting");
+        drawSpheres(hdrTexture);
+    });
+    frameGraph.read(lightingPass, hdrTarget);
+    frameGraph.write(lightingPass, hdrTarget);
+
+    LuminanceTargets luminance = toneMapper->addLuminancePasses(&frameGraph, texturePool, hdrTarget);
+
+    FrameGraphPass clearPass = frameGraph.addPass("Clear back buffer", [&]()
+    {
+        RenderScope scope(device, "Clear back buffer");
+        RenderPassDesc pass;
+        pass.name = "Clear back buffer";
+        pass.colorCount = 1;
+        pass.colors[0].texture = backBuffer;
+        pass.clearColor = true;
+        pass.clearValue[3] = 1.0f;
+        device->beginPass(pass);
+        device->endPass();
+    });
+    frameGraph.write(clearPass, backBufferTarget);
+
+    toneMapper->addToneMapPass(&frameGraph, texturePool, hdrTarget, luminance, backBufferTarget, backBuffer);
+
+    FrameGraphPass overlayPass = frameGraph.addPass("GUI", [&]()
+    {
+        RenderScope scope(device, "GUI");
+        RenderPassDesc pass;
+        pass.name = "GUI";
+        pass.colorCount = 1;
+        pass.colors[0].texture = backBuffer;
+        device->beginPass(pass);
+        if (overlay)
+        {
+            overlay();
+        }
+        device->endPass();
+    }, true);
+    frameGraph.read(overlayPass, backBufferTarget);
+    frameGraph.write(overlayPass, backBufferTarget);
+
+    {
+        RenderScope scope(device, "Frame graph compile");
+        frameGraph.compile();
+        texturePool->realize(frameGraph);
+    }
+    frameGraph.execute();
+    frameGraphStats = frameGraph.getStats();
+}
+
+void SceneRenderer::drawSkybox(RenderTexture hdrTexture)
+{
+    RenderPassDesc pass;
+    pass.name = "Skybox";
+    pass.colorCount = 1;
+    pass.colors[0].texture = hdrTexture;
+    pass.depth.texture = toneMapper->getDepthTarget();
+    pass.clearColor = true;
+    pass.clearValue[0] = pass.clearValue[1] = pass.clearValue[2] = 0.25f;
+    pass.clearValue[3] = 1.0f;
+    pass.clearDepth = true;
+    device->beginPass(pass);
+
+    RenderPipelineDesc pipeline;
+    pipeline.vertexShader = skyboxVS;
+    pipeline.pixelShader = skyboxPS;
+    pipeline.depthMode = RENDER_DEPTH_LESS_EQUAL;
+    pipeline.cullMode = RENDER_CULL_NONE;
+    device->setPipeline(pipeline);
+    device->setSamplers(RENDER_STAGE_PIXEL, 0, 1, &sampler);
+    device->setConstantBuffer(RENDER_STAGE_VERTEX, 0, skyboxConfigConstant);
+    device->setTextures(RENDER_STAGE_PIXEL, 0, 1, &cubemap.cubemapTexture);
+    device->drawIndexed(sphereVertex, sphereLevels[0].indexBuffer, sphereLevels[0].indexCount);
+
+    device->endPass();
+}
+
+void SceneRenderer::drawSpheres(RenderTexture hdrTexture)
+{
+    // The skybox leaves its depth behind; the spheres are drawn over it.
+    RenderPassDesc pass;
+    pass.name = "PBR lighting";
+    pass.colorCount = 1;
+    pass.colors[0].texture = hdrTexture;
+    pass.depth.texture = toneMapper->getDepthTarget();
+    pass.clearDepth = true;
+    device->beginPass(pass);
+
+    RenderPipelineDesc pipeline;
+    pipeline.vertexShader = lightingVS;
+    pipeline.pixelShader = lightingPS;
+    device->setPipeline(pipeline);
+    RenderSampler samplers[] = {sampler, clampSampler};
+    device->setSamplers(RENDER_STAGE_PIXEL, 0, 2, samplers);
+    RenderTexture resources[] = {cubemap.irradianceTexture, cubemap.prefilteredTexture, cubemap.brdfTexture};
+    device->setTextures(RENDER_STAGE_PIXEL, 0, 3, resources);
+    device->setConstantBuffer(RENDER_STAGE_VERTEX, 0, constantBuffer);
+    device->setConstantBuffer(RENDER_STAGE_PIXEL, 0, lightConstant);
+    device->setConstantBuffer(RENDER_STAGE_PIXEL, 1, pbrConfiguration);
+    device->setConstantBuffer(RENDER_STAGE_PIXEL, 2, irradianceSHConstant);
+    RenderBuffer lightResources[] = {lightBuffer, lightClusterBuffer, lightIndexBuffer};
+    device->setBuffers(RENDER_STAGE_PIXEL, 3, 3, lightResources);
+    for (const SphereLevel& level : sphereLevels)
+    {
+        if (!level.instances.empty())
+        {
+            device->drawIndexed(sphereVertex, level.indexBuffer, level.indexCount, level.instanceBuffer,
+                                (uint32_t)level.instances.size());
+        }
+    }
+
+    device->endPass();
+}
+
+void SceneRenderer::updateConstants(const SceneView& view)
+{
+    Float4x4 projection = RenderMath::perspectiveFov(view.fovDegrees * RenderMath::PI / 180.0f,
+                                                     (float)view.width / (float)view.height, NEAR_PLANE, FAR_PLANE);
+    shaderConstant.cameraMatrix = RenderMath::multiply(view.viewMatrix, projection);
+    skyboxConfig.cameraMatrix = shaderConstant.cameraMatrix;
+    skyboxConfig.cameraPosition = view.cameraPosition;
+    calcSkyboxSize(skyboxConfig, view.width, view.height, view.fovDegrees);
+
+    lightConstantData.cameraMatrix = shaderConstant.cameraMatrix;
+    lightConstantData.cameraPosition = view.cameraPosition;
+    updateLights(view);
+    device->updateBuffer(constantBuffer, &shaderConstant, sizeof(ShaderConstant));
+    device->updateBuffer(lightConstant, &lightConstantData, sizeof(LightConstant));
+    device->updateBuffer(pbrConfiguration, &configuration, sizeof(PBRConfiguration));
+    device->updateBuffer(skyboxConfigConstant, &skyboxConfig, sizeof(SkyboxConfig));
+}
+
+void SceneRenderer::updateLights(const SceneView& view)
+{
+    RenderScope scope(device, "Light clusters");
+    lightClusters->build(lights.data(), (uint32_t)lights.size(), view.viewMatrix,
+                         view.fovDegrees * RenderMath::PI / 180.0f, (float)view.width / (float)view.height, FAR_PLANE);
+    lightConstantData.clusterDepthScale = lightClusters->getDepthScale();
+    lightConstantData.clusterDepthBias = lightClusters->getDepthBias();
+
+    const std::vector<uint32_t>& lightIndices = lightClusters->getLightIndices();
+    reserveLightBuffer(&lightBuffer, &lightCapacity, (uint32_t)lights.size(), sizeof(PointLightSource),
+                       "Point lights");
+    reserveLightBuffer(&lightIndexBuffer, &lightIndexCapacity, (uint32_t)lightIndices.size(), sizeof(uint32_t),
+                       "Light cluster indices");
+    if (!lights.empty())
+    {
+        device->updateBuffer(lightBuffer, lights.data(), (uint32_t)(lights.size() * sizeof(PointLightSource)));
+    }
+    device->updateBuffer(lightClusterBuffer, lightClusters->getClusters().data(),
+                         LightClusters::CLUSTER_COUNT * sizeof(LightCluster));
+    if (!lightIndices.empty())
+    {
+        device->updateBuffer(lightIndexBuffer, lightIndices.data(), (uint32_t)(lightIndices.size() * sizeof(uint32_t)));
+    }
+}
+
+// Grows by doubling, so a light count that creeps up does not recreate the buffer every frame.
+void SceneRenderer::reserveLightBuffer(RenderBuffer* pBuffer, uint32_t* pCapacity, uint32_t count, uint32_t stride,
+                                       const char* name)
+{
+    if (*pBuffer && count <= *pCapacity)
+    {
+        return;
+    }
+    uint32_t capacity = std::max(*pCapacity, MIN_LIGHT_BUFFER_CAPACITY);
+    while (capacity < count)
+    {
+        capacity *= 2;
+    }
+    if (*pBuffer)
+    {
+        device->destroyBuffer(*pBuffer);
+    }
+    RenderBufferDesc desc;
+    desc.type = RENDER_BUFFER_STRUCTURED;
+    desc.size = capacity * stride;
+    desc.stride = stride;
+    desc.name = name;
+    desc.memoryCategory = MEMORY_CATEGORY;
+    *pBuffer = device->createBuffer(desc);
+    *pCapacity = capacity;
+}
+
+void SceneRenderer::updateInstances()
+{
+    // A single sphere shows the material from the GUI; a grid sweeps metallic along X and roughness along Y.
+    std::vector<InstanceData> grid(sphereGridSize * sphereGridSize);
+    float scale = sphereGridSize == 1 ? 3.0f : 1.0f;
+    float spacing = 2.5f;
+    float extent = (sphereGridSize - 1) * spacing;
+    for (int row = 0; row < sphereGridSize; row++)
+    {
+        for (int column = 0; column < sphereGridSize; column++)
+        {
+            InstanceData& instance = grid[row * sphereGridSize + column];
+            instance.worldMatrix = RenderMath::multiply(RenderMath::scaling(scale, scale, scale),
+                                                        RenderMath::translation(column * spacing - extent / 2,
+                                                                                row * spacing - extent / 2, 0.0f));
+            const Float3& color = sphereEncoding.color;
+            instance.albedo = RenderMath::makeFloat4(color.x, color.y, color.z, 1.0f);
+            if (sphereGridSize == 1)
+            {
+                instance.material = RenderMath::makeFloat2(configuration.metallic, configuration.roughness);
+            }
+            else
+            {
+                float step = 1.0f / (sphereGridSize - 1);
+                instance.material = RenderMath::makeFloat2(0.001f + 0.999f * column * step,
+                                                           0.001f + 0.999f * row * step);
+            }
+        }
+    }
+    if (grid.size() == instances.size() &&
+        memcmp(grid.data(), instances.data(), grid.size() * sizeof(InstanceData)) == 0)
+    {
+        return;
+    }
+    instances = std::move(grid);
+    instanceSpheres.resize(instances.size());
+    sceneObjects.clear();
+    for (size_t i = 0; i < instances.size(); i++)
+    {
+        Float3 boundsMin;
+        Float3 boundsMax;
+        transformBounds(sphereBoundsMin, sphereBoundsMax, instances[i].worldMatrix, &boundsMin, &boundsMax);
+        sceneObjects.add(boundsMin, boundsMax);
+        instanceSpheres[i] = transformSphere(sphereCenter, sphereRadius, instances[i].worldMatrix);
+    }
+}
+
+// Each level's instance buffer holds the visible spheres drawn at that level and is uploaded when they change.
+void SceneRenderer::cullInstances(const SceneView& view)
+{
+    RenderScope scope(device, "Frustum culling");
+    sceneObjects.update();
+    sceneObjects.cull(shaderConstant.cameraMatrix, &visibleObjects, &cullStats);
+    for (SphereLevel& level : sphereLevels)
+    {
+        level.pendingInstances.clear();
+    }
+    for (uint32_t object : visibleObjects)
+    {
+        sphereLevels[selectLevel(instanceSpheres[object], view)].pendingInstances.push_back(instances[object]);
+    }
+    for (SphereLevel& level : sphereLevels)
+    {
+        bool changed = level.pendingInstances.size() != level.instances.size() ||
+                       memcmp(level.pendingInstances.data(), level.instances.data(),
+                              level.instances.size() * sizeof(InstanceData)) != 0;
+        if (!changed)
+        {
+            continue;
+        }
+        level.instances.swap(level.pendingInstances);
+        if (!level.instances.empty())
+        {
+            device->updateBuffer(level.instanceBuffer, level.instances.data(),
+                                 (uint32_t)(level.instances.size() * sizeof(InstanceData)));
+        }
+    }
+}
+
+// The error of a level scales with the sphere it is drawn on; projected the way the radius is, it is the number of
+// pixels the silhouette may move. The camera inside or touching the bounding sphere gets the full mesh.
+uint32_t SceneRenderer::selectLevel(const Float4& boundingSphere, const SceneView& view) const
+{
+    Float3 offset = RenderMath::makeFloat3(boundingSphere.x - view.cameraPosition.x,
+                                           boundingSphere.y - view.cameraPosition.y,
+                                           boundingSphere.z - view.cameraPosition.z);
+    float distance = sqrtf(RenderMath::dot(offset, offset));
+    if (distance <= boundingSphere.w || sphereRadius <= 0.0f)
+    {
+        return 0;
+    }
+    float pixelsPerUnit = view.height * 0.5f / (distance * tanf(view.fovDegrees * RenderMath::PI / 360.0f));
+    float pixelsPerError = boundingSphere.w / sphereRadius * pixelsPerUnit;
+    uint32_t selected = 0;
+    for (uint32_t i = 1; i < (uint32_t)sphereLevels.size(); i++)
+    {
+        if (sphereLevels[i].error * pixelsPerError > lodErrorPixels)
+        {
+            break;
+        }
+        selected = i;
+    }
+    return selected;
+}
+
+PBRConfiguration& SceneRenderer::getConfiguration()
+{
+    return configuration;
+}
+
+std::vector<PointLightSource>& SceneRenderer::getLights()
+{
+    return lights;
+}
+
+void SceneRenderer::setScatteredLightCount(uint32_t count)
+{
+    if (count > MAX_SCATTERED_LIGHTS)
+    {
+        throw std::runtime_error("Failed to scatter lights: too many lights");
+    }
+    if (count == scatteredLightCount && lights.size() == MAIN_LIGHT_COUNT + count)
+    {
+        return;
+    }
+    scatteredLightCount = count;
+    lights.resize(MAIN_LIGHT_COUNT);
+    std::mt19937 random(SCATTERED_LIGHT_SEED);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        PointLightSource light;
+        light.position.x = (unit(random) - 0.5f) * SCATTER_EXTENT;
+        light.position.y = (unit(random) - 0.5f) * SCATTER_EXTENT;
+        light.position.z = (unit(random) - 0.5f) * SCATTER_DEPTH;
+        light.radius = 2.0f + 6.0f * unit(random);
+        light.color = RenderMath::makeFloat3(0.25f + 0.75f * unit(random), 0.25f + 0.75f * unit(random),
+                                             0.25f + 0.75f * unit(random));
+        light.intensity = 50.0f + 200.0f * unit(random);
+        lights.push_back(light);
+    }
+}
+
+const LightClusters* SceneRenderer::getLightClusters() const
+{
+    return lightClusters;
+}
+
+const SceneObjects& SceneRenderer::getSceneObjects() const
+{
+    return sceneObjects;
+}
+
+const CullStats& SceneRenderer::getCullStats() const
+{
+    return cullStats;
+}
+
+void SceneRenderer::setSphereGridSize(int size)
+{
+    if (size < 1 || size > (int)MAX_SPHERE_GRID_SIZE)
+    {
+        throw std::runtime_error("Failed to set sphere grid size: out of range");
+    }
+    sphereGridSize = size;
+}
+
+const std::vector<SphereLevel>& SceneRenderer::getSphereLevels() const
+{
+    return sphereLevels;
+}
+
+const VertexEncodingStats& SceneRenderer::getVertexEncodingStats() const
+{
+    return sphereEncoding.stats;
+}
+
+void SceneRenderer::setLodErrorPixels(float pixels)
+{
+    lodErrorPixels = std::max(pixels, 0.0f);
+}
+
+ToneMapper* SceneRenderer::getToneMapper()
+{
+    return toneMapper;
+}
+
+const FrameGraphStats& SceneRenderer::getFrameGraphStats() const
+{
+    return frameGraphStats;
+}
+
+uint64_t SceneRenderer::getTransientBytes() const
+{
+    return texturePool->getAllocatedBytes();
+}
+
+void SceneRenderer::loadShaders()
+{
+    std::vector<RenderVertexAttribute> meshAttributes = MeshEncoder::getAttributes(sphereEncoding.encoding);
+    RenderShaderDesc skyboxDesc = SKYBOX_VS;
+    skyboxDesc.attributes = meshAttributes.data();
+    skyboxDesc.attributeCount = (uint32_t)meshAttributes.size();
+    std::vector<RenderVertexAttribute> instancedAttributes = meshAttributes;
+    instancedAttributes.insert(instancedAttributes.end(), std::begin(INSTANCE_ATTRIBUTES),
+                               std::end(INSTANCE_ATTRIBUTES));
+    RenderShaderDesc lightingDesc = LIGHTING_VS;
+    lightingDesc.attributes = instancedAttributes.data();
+    lightingDesc.attributeCount = (uint32_t)instancedAttributes.size();
+
+    lightingVS = device->createShader(lightingDesc);
+    lightingPS = device->createShader(LIGHTING_PS);
+    skyboxVS = device->createShader(skyboxDesc);
+    skyboxPS = device->createShader(SKYBOX_PS);
+}
+
+void SceneRenderer::loadSphere(const MeshData& sphere)
+{
+    sphereEncoding = MeshEncoder::encode(sphere, MeshEncoder::chooseEncoding(sphere, VertexEncodingSettings()));
+    shaderConstant.positionDequant = sphereEncoding.positionDequant;
+    skyboxConfig.positionDequant = sphereEncoding.positionDequant;
+    RenderBufferDesc vertexDesc;
+    vertexDesc.type = RENDER_BUFFER_VERTEX;
+    vertexDesc.size = (uint32_t)sphereEncoding.vertices.size();
+    vertexDesc.stride = sphereEncoding.stride;
+    vertexDesc.name = "Sphere vertex buffer";
+    vertexDesc.memoryCategory = MEMORY_CATEGORY;
+    sphereVertex = device->createBuffer(vertexDesc, sphereEncoding.vertices.data());
+    float boundsMin[3] = {0.0f, 0.0f, 0.0f};
+    float boundsMax[3] = {0.0f, 0.0f, 0.0f};
+    for (size_t i = 0; i < sphere.vertices.size(); i++)
+    {
+        for (int axis = 0; axis < 3; axis++)
+        {
+            float value = sphere.vertices[i].position[axis];
+            boundsMin[axis] = i ? std::min(boundsMin[axis], value) : value;
+            boundsMax[axis] = i ? std::max(boundsMax[axis], value) : value;
+        }
+    }
+    sphereBoundsMin = RenderMath::makeFloat3(boundsMin[0], boundsMin[1], boundsMin[2]);
+    sphereBoundsMax = RenderMath::makeFloat3(boundsMax[0], boundsMax[1], boundsMax[2]);
+    sphereCenter = RenderMath::makeFloat3((boundsMin[0] + boundsMax[0]) * 0.5f, (boundsMin[1] + boundsMax[1]) * 0.5f,
+                                          (boundsMin[2] + boundsMax[2]) * 0.5f);
+    float radiusSquared = 0.0f;
+    for (const MeshVertex& vertex : sphere.vertices)
+    {
+        Float3 offset = RenderMath::makeFloat3(vertex.position[0] - sphereCenter.x, vertex.position[1] - sphereCenter.y,
+                                               vertex.position[2] - sphereCenter.z);
+        radiusSquared = std::max(radiusSquared, RenderMath::dot(offset, offset));
+    }
+    sphereRadius = sqrtf(radiusSquared);
+
+    std::vector<MeshLOD> chain = MeshSimplifier::buildLODChains({&sphere}, MeshLODSettings(), threadPool)[0];
+    RenderBufferDesc instanceDesc;
+    instanceDesc.type = RENDER_BUFFER_INSTANCE;
+    instanceDesc.size = sizeof(InstanceData) * MAX_SPHERE_GRID_SIZE * MAX_SPHERE_GRID_SIZE;
+    instanceDesc.stride = sizeof(InstanceData);
+    instanceDesc.name = "Sphere instances";
+    instanceDesc.memoryCategory = MEMORY_CATEGORY;
+    sphereLevels.resize(chain.size());
+    for (size_t i = 0; i < chain.size(); i++)
+    {
+        SphereLevel& level = sphereLevels[i];
+        level.indexBuffer = createIndexBuffer(sphere, chain[i].indices,
+                                              i ? "Sphere LOD index buffer" : "Sphere index buffer");
+        level.indexCount = (uint32_t)chain[i].indices.size();
+        level.error = chain[i].error;
+        level.instanceBuffer = device->createBuffer(instanceDesc);
+    }
+}
+
+RenderBuffer SceneRenderer::createIndexBuffer(const MeshData& sphere, const std::vector<uint32_t>& indices,
+                                              const char* name)
+{
+    RenderBufferDesc indexDesc;
+    indexDesc.type = RENDER_BUFFER_INDEX;
+    indexDesc.name = name;
+    indexDesc.memoryCategory = MEMORY_CATEGORY;
+    if (sphere.canUseShortIndices())
+    {
+        std::vector<uint16_t> shortIndices(indices.begin(), indices.end());
+        indexDesc.size = (uint32_t)(shortIndices.size() * sizeof(uint16_t));
+        indexDesc.stride = sizeof(uint16_t);
+        return device->createBuffer(indexDesc, shortIndices.data());
+    }
+    indexDesc.size = (uint32_t)(indices.size() * sizeof(uint32_t));
+    indexDesc.stride = sizeof(uint32_t);
+    return device->createBuffer(indexDesc, indices.data());
+}
+
+void SceneRenderer::loadConstants()
+{
+    RenderBufferDesc constantDesc;
+    constantDesc.type = RENDER_BUFFER_CONSTANT;
+    constantDesc.size = sizeof(ShaderConstant);
+    constantDesc.name = "Camera matrix";
+    constantBuffer = device->createBuffer(constantDesc, &shaderConstant);
+
+    lights.resize(MAIN_LIGHT_COUNT);
+    lights[0].position = RenderMath::makeFloat3(0, 5, 0);
+    lights[1].position = RenderMath::makeFloat3(-5, 0, 0);
+    lights[2].position = RenderMath::makeFloat3(0, -5, -5);
+    constantDesc.size = sizeof(LightConstant);
+    constantDesc.name = "Light sources infos";
+    lightConstant = device->createBuffer(constantDesc, &lightConstantData);
+
+    constantDesc.size = sizeof(PBRConfiguration);
+    constantDesc.name = "PBR configuration buffer";
+    pbrConfiguration = device->createBuffer(constantDesc, &configuration);
+
+    skyboxConfig.worldMatrix = RenderMath::identity();
+    constantDesc.size = sizeof(SkyboxConfig);
+    constantDesc.name = "Skybox configuration";
+    skyboxConfigConstant = device->createBuffer(constantDesc, &skyboxConfig);
+
+    RenderBufferDesc clusterDesc;
+    clusterDesc.type = RENDER_BUFFER_STRUCTURED;
+    clusterDesc.size = LightClusters::CLUSTER_COUNT * sizeof(LightCluster);
+    clusterDesc.stride = sizeof(LightCluster);
+    clusterDesc.name = "Light clusters";
+    clusterDesc.memoryCategory = MEMORY_CATEGORY;
+    lightClusterBuffer = device->createBuffer(clusterDesc);
+    reserveLightBuffer(&lightBuffer, &lightCapacity, MAIN_LIGHT_COUNT, sizeof(PointLightSource), "Point lights");
+    reserveLightBuffer(&lightIndexBuffer, &lightIndexCapacity, 0, sizeof(uint32_t), "Light cluster indices");
+}
+
+void SceneRenderer::createIrradianceConstant()
+{
+    RenderBufferDesc constantDesc;
+    constantDesc.type = RENDER_BUFFER_CONSTANT;
+    constantDesc.size = sizeof(SHIrradiance);
+    constantDesc.name = "Irradiance SH coefficients";
+    irradianceSHConstant = device->createBuffer(constantDesc, &cubemap.irradianceSH);
+}
+
+void SceneRenderer::destroy()
+{
+    toneMapper->destroy();
+    delete toneMapper;
+    texturePool->release();
+    delete texturePool;
+    CubemapGenerator::destroyCubemap(device, &cubemap);
+    delete lightClusters;
+    delete threadPool;
+
+    RenderBuffer buffers[] = {
+        constantBuffer, lightConstant, pbrConfiguration, skyboxConfigConstant, irradianceSHConstant, lightBuffer,
+        lightClusterBuffer, lightIndexBuffer, sphereVertex
+    };
+    for (RenderBuffer buffer : buffers)
+    {
+        if (buffer)
+        {
+            device->destroyBuffer(buffer);
+        }
+    }
+    for (const SphereLevel& level : sphereLevels)
+    {
+        device->destroyBuffer(level.indexBuffer);
+        device->destroyBuffer(level.instanceBuffer);
+    }
+    RenderShader shaders[] = {lightingVS, lightingPS, skyboxVS, skyboxPS};
+    for (RenderShader shader : shaders)
+    {
+        device->destroyShader(shader);
+    }
+    device->destroySampler(sampler);
+    device->destroySampler(clampSampler);
+}
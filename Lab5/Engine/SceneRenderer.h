@@ -0,0 +1,198 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "CubemapGenerator.h"
+#include "ToneMapper.h"
+#include "Culling/SceneObjects.h"
+#include "FrameGraph/FrameGraph.h"
+#include "FrameGraph/TransientTexturePool.h"
+#include "Lighting/LightClusters.h"
+#include "Mesh/MeshBuilder.h"
+#include "Mesh/MeshEncoder.h"
+#include "Mesh/MeshSimplifier.h"
+#include "RenderDevice/RenderDevice.h"
+#include "RenderDevice/RenderMath.h"
+
+enum IrradianceMode
+{
+    IRRADIANCE_MODE_SH = 0,
+    IRRADIANCE_MODE_CUBEMAP = 1
+};
+
+struct PBRConfiguration
+{
+    int defaultFunction = 1;
+    int normalDistribution = 0;
+    int fresnelFunction = 0;
+    int geometryFunction = 0;
+
+    float metallic = 0.9;
+    float roughness = 0.03;
+    float ambientIntensity = 15.0f;
+    int irradianceMode = IRRADIANCE_MODE_SH;
+};
+
+
+struct ShaderConstant
+{
+    Float4x4 cameraMatrix;
+    Float4 positionDequant;
+};
+
+// Vertex stream 1 of the lighting shader, one element per sphere.
+struct InstanceData
+{
+    Float4x4 worldMatrix;
+    Float4 albedo;
+    Float2 material;
+};
+
+// One level of detail of the sphere mesh and the visible spheres drawn with it, as uploaded.
+struct SphereLevel
+{
+    RenderBuffer indexBuffer = RENDER_NULL_HANDLE;
+    uint32_t indexCount = 0;
+    float error = 0.0f;
+    RenderBuffer instanceBuffer = RENDER_NULL_HANDLE;
+    std::vector<InstanceData> instances;
+    std::vector<InstanceData> pendingInstances;
+};
+
+struct SkyboxConfig
+{
+    Float4x4 worldMatrix;
+    Float4x4 cameraMatrix;
+    Float4 size;
+    Float4 positionDequant;
+    Float3 cameraPosition;
+
+};
+
+// The lights themselves are in a structured buffer; the pixel shader finds its cluster with these.
+struct LightConstant
+{
+    Float4x4 cameraMatrix;
+    Float3 cameraPosition;
+    float clusterDepthScale = 0;
+    float clusterDepthBias = 0;
+};
+
+struct SceneView
+{
+    uint32_t width = 0;
+    uint32_t height = 0;
+    Float4x4 viewMatrix;
+    Float3 cameraPosition;
+    float fovDegrees = 90.0f;
+};
+
+// The frame itself: skybox, instanced PBR spheres, luminance reduction and tone mapping, scheduled through a
+// FrameGraph on a RenderDevice. Knows nothing about windows, input or the GUI, so it also runs headless. Point lights
+// are clustered on the CPU every frame, see LightClusters, and only the spheres in the view frustum are drawn, see
+// SceneObjects, each at the coarsest level of detail whose error stays under a pixel or so on screen.
+class SceneRenderer
+{
+public:
+    static const uint32_t MAX_SPHERE_GRID_SIZE = 32;
+    // The lights the GUI edits; scattered lights follow them.
+    static const uint32_t MAIN_LIGHT_COUNT = 3;
+    static const uint32_t MAX_SCATTERED_LIGHTS = 16384;
+
+    explicit SceneRenderer(RenderDevice* device);
+
+private:
+    RenderDevice* device;
+    ToneMapper* toneMapper = nullptr;
+    TransientTexturePool* texturePool = nullptr;
+    FrameGraphStats frameGraphStats;
+    HDRCubemap cubemap;
+    ThreadPool* threadPool = nullptr;
+    LightClusters* lightClusters = nullptr;
+    SceneObjects sceneObjects;
+
+    RenderShader lightingVS = RENDER_NULL_HANDLE;
+    RenderShader lightingPS = RENDER_NULL_HANDLE;
+    RenderShader skyboxVS = RENDER_NULL_HANDLE;
+    RenderShader skyboxPS = RENDER_NULL_HANDLE;
+    RenderSampler sampler = RENDER_NULL_HANDLE;
+    RenderSampler clampSampler = RENDER_NULL_HANDLE;
+
+    ShaderConstant shaderConstant{};
+    LightConstant lightConstantData{};
+    std::vector<PointLightSource> lights;
+    uint32_t scatteredLightCount = 0;
+    PBRConfiguration configuration;
+    SkyboxConfig skyboxConfig{};
+    RenderBuffer constantBuffer = RENDER_NULL_HANDLE;
+    RenderBuffer lightConstant = RENDER_NULL_HANDLE;
+    RenderBuffer pbrConfiguration = RENDER_NULL_HANDLE;
+    RenderBuffer skyboxConfigConstant = RENDER_NULL_HANDLE;
+    RenderBuffer irradianceSHConstant = RENDER_NULL_HANDLE;
+    RenderBuffer lightBuffer = RENDER_NULL_HANDLE;
+    RenderBuffer lightClusterBuffer = RENDER_NULL_HANDLE;
+    RenderBuffer lightIndexBuffer = RENDER_NULL_HANDLE;
+    uint32_t lightCapacity = 0;
+    uint32_t lightIndexCapacity = 0;
+
+    EncodedMesh sphereEncoding;
+    RenderBuffer sphereVertex = RENDER_NULL_HANDLE;
+    std::vector<SphereLevel> sphereLevels;
+    Float3 sphereBoundsMin;
+    Float3 sphereBoundsMax;
+    Float3 sphereCenter;
+    float sphereRadius = 0.0f;
+    float lodErrorPixels = 1.0f;
+    // Every sphere of the grid and its bounding sphere, indexed by scene object id.
+    std::vector<InstanceData> instances;
+    std::vector<Float4> instanceSpheres;
+    std::vector<uint32_t> visibleObjects;
+    CullStats cullStats;
+    int sphereGridSize = 1;
+
+public:
+    static void requestShaders(RenderDevice* device);
+    void initialize(uint32_t width, uint32_t height, const MeshData& sphere);
+    // Loads the IBL maps from the baked cache next to the HDR file, or renders them from the HDR image.
+    void loadEnvironment(const std::string& directory, const std::string& name);
+    void loadEnvironment(const std::string& directory, const HDRImage& image, ThreadPool* threadPool);
+    void resize(uint32_t width, uint32_t height);
+    // The overlay runs last, inside a pass on the back buffer.
+    void drawFrame(const SceneView& view, RenderTexture backBuffer, const std::function<void()>& overlay);
+
+    PBRConfiguration& getConfiguration();
+    std::vector<PointLightSource>& getLights();
+    // Keeps the main lights and places count dim coloured lights among the spheres, the same ones for the same count.
+    void setScatteredLightCount(uint32_t count);
+    const LightClusters* getLightClusters() const;
+    const SceneObjects& getSceneObjects() const;
+    const CullStats& getCullStats() const;
+    void setSphereGridSize(int size);
+    const std::vector<SphereLevel>& getSphereLevels() const;
+    const VertexEncodingStats& getVertexEncodingStats() const;
+    // How far, in pixels, a level may stray from the full mesh on screen before a finer one is drawn.
+    void setLodErrorPixels(float pixels);
+    ToneMapper* getToneMapper();
+    const FrameGraphStats& getFrameGraphStats() const;
+    uint64_t getTransientBytes() const;
+
+    void destroy();
+
+private:
+    void loadShaders();
+    void loadSphere(const MeshData& sphere);
+    RenderBuffer createIndexBuffer(const MeshData& sphere, const std::vector<uint32_t>& indices, const char* name);
+    void loadConstants();
+    void createIrradianceConstant();
+    void updateConstants(const SceneView& view);
+    void updateLights(const SceneView& view);
+    void reserveLightBuffer(RenderBuffer* pBuffer, uint32_t* pCapacity, uint32_t count, uint32_t stride,
+                            const char* name);
+    void updateInstances();
+    void cullInstances(const SceneView& view);
+    uint32_t selectLevel(const Float4& boundingSphere, const SceneView& view) const;
+    void drawSkybox(RenderTexture hdrTexture);
+    void drawSpheres(RenderTexture hdrTexture);
+};
@@ -0,0 +1,171 @@
+#include "LuminanceReduction.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    // Histogram covers 2^-10 .. 2^6 in quarter-stop bins.
+    const float MIN_LOG2 = -10.0f;
+    const float LOG2_RANGE = 16.0f;
+    const float LOW_PERCENTILE = 0.5f;
+    const float HIGH_PERCENTILE = 0.95f;
+}
+
+LuminanceConstants LuminanceReduction::makeConstants(uint32_t width, uint32_t height, uint32_t exposureMode)
+{
+    LuminanceConstants constants = {};
+    constants.width = width;
+    constants.height = height;
+    constants.groupCountX = (width + GROUP_SIZE - 1) / GROUP_SIZE;
+    constants.groupCount = constants.groupCountX * ((height + GROUP_SIZE - 1) / GROUP_SIZE);
+    constants.minLog2 = MIN_LOG2;
+    constants.log2Range = LOG2_RANGE;
+    constants.lowPercentile = LOW_PERCENTILE;
+    constants.highPercentile = HIGH_PERCENTILE;
+    constants.exposureMode = exposureMode;
+    return constants;
+}
+
+float LuminanceReduction::brightness(const float* rgb)
+{
+    return rgb[0] * 0.2126f + rgb[1] * 0.7151f + rgb[2] * 0.0722f;
+}
+
+uint32_t LuminanceReduction::histogramBin(float brightness, const LuminanceConstants& constants)
+{
+    if (!(brightness > 0.0f))
+    {
+        return 0;
+    }
+    float position = (log2f(brightness) - constants.minLog2) / constants.log2Range;
+    position = std::min(std::max(position, 0.0f), 1.0f);
+    return std::min((uint32_t)(position * HISTOGRAM_BINS), HISTOGRAM_BINS - 1);
+}
+
+void LuminanceReduction::reduceGroups(const float* rgbaPixels, const LuminanceConstants& constants,
+                                      std::vector<LuminanceStats>* pPartials, std::vector<uint32_t>* pHistogram)
+{
+    pPartials->assign(constants.groupCount, LuminanceStats());
+    pHistogram->assign(HISTOGRAM_BINS, 0);
+    std::vector<LuminanceStats> groupStats(THREAD_COUNT);
+    for (uint32_t group = 0; group < constants.groupCount; group++)
+    {
+        uint32_t groupX = group % constants.groupCountX;
+        uint32_t groupY = group / constants.groupCountX;
+        for (uint32_t index = 0; index < THREAD_COUNT; index++)
+        {
+            uint32_t x = groupX * GROUP_SIZE + index % GROUP_SIZE;
+            uint32_t y = groupY * GROUP_SIZE + index / GROUP_SIZE;
+            groupStats[index] = LuminanceStats();
+            if (x < constants.width && y < constants.height)
+            {
+                float value = brightness(rgbaPixels + ((size_t)y * constants.width + x) * 4);
+                groupStats[index] = {logf(value + 1.0f), value, value};
+                (*pHistogram)[histogramBin(value, constants)]++;
+            }
+        }
+        (*pPartials)[group] = reduceTree(groupStats);
+    }
+}
+
+LuminanceResult LuminanceReduction::finalize(const std::vector<LuminanceStats>& partials,
+                                             const std::vector<uint32_t>& histogram,
+                                             const LuminanceConstants& constants)
+{
+    // One group: every thread folds a strided slice of the partials, then the group reduces as a tree.
+    std::vector<LuminanceStats> threadStats(THREAD_COUNT);
+    for (uint32_t index = 0; index < THREAD_COUNT; index++)
+    {
+        for (uint32_t i = index; i < constants.groupCount; i += THREAD_COUNT)
+        {
+            threadStats[index] = combine(threadStats[index], partials[i]);
+        }
+    }
+    LuminanceStats total = reduceTree(threadStats);
+
+    LuminanceResult result;
+    result.average = total.logSum / (float)(constants.width * constants.height);
+    if (constants.exposureMode == LUMINANCE_EXPOSURE_HISTOGRAM)
+    {
+        result.average = histogramAverage(histogram, constants);
+    }
+    result.minimum = total.minimum;
+    result.maximum = total.maximum;
+    return result;
+}
+
+LuminanceResult LuminanceReduction::reduceReference(const float* rgbaPixels, const LuminanceConstants& constants)
+{
+    size_t pixelCount = (size_t)constants.width * constants.height;
+    double logSum = 0.0;
+    LuminanceResult result = {0.0f, FLT_MAX, 0.0f};
+    std::vector<float> log2Values;
+    log2Values.reserve(pixelCount);
+    for (size_t i = 0; i < pixelCount; i++)
+    {
+        float value = brightness(rgbaPixels + i * 4);
+        logSum += log((double)value + 1.0);
+        result.minimum = std::min(result.minimum, value);
+        result.maximum = std::max(result.maximum, value);
+        float log2Value = value > 0.0f ? log2f(value) : constants.minLog2;
+        log2Values.push_back(std::min(std::max(log2Value, constants.minLog2),
+                                      constants.minLog2 + constants.log2Range));
+    }
+    result.average = (float)(logSum / pixelCount);
+
+    if (constants.exposureMode == LUMINANCE_EXPOSURE_HISTOGRAM)
+    {
+        // Exact trimmed mean of the sorted log2 luminances, without binning.
+        std::sort(log2Values.begin(), log2Values.end());
+        size_t first = (size_t)(pixelCount * (double)constants.lowPercentile);
+        size_t last = std::max(first + 1, (size_t)(pixelCount * (double)constants.highPercentile));
+        double log2Sum = 0.0;
+        for (size_t i = first; i < last; i++)
+        {
+            log2Sum += log2Values[i];
+        }
+        result.average = (float)log(exp2(log2Sum / (double)(last - first)) + 1.0);
+    }
+    return result;
+}
+
+LuminanceStats LuminanceReduction::combine(const LuminanceStats& a, const LuminanceStats& b)
+{
+    return {a.logSum + b.logSum, std::min(a.minimum, b.minimum), std::max(a.maximum, b.maximum)};
+}
+
+LuminanceStats LuminanceReduction::reduceTree(std::vector<LuminanceStats>& values)
+{
+    // Same pairing as the groupshared loop, so float sums round exactly like the GPU.
+    for (uint32_t stride = (uint32_t)values.size() / 2; stride > 0; stride >>= 1)
+    {
+        for (uint32_t index = 0; index < stride; index++)
+        {
+            values[index] = combine(values[index], values[index + stride]);
+        }
+    }
+    return values[0];
+}
+
+float LuminanceReduction::histogramAverage(const std::vector<uint32_t>& histogram,
+                                           const LuminanceConstants& constants)
+{
+    // Mean log2 luminance of the pixels between the two percentiles, counting partial bins at the edges.
+    float pixelCount = (float)(constants.width * constants.height);
+    float low = pixelCount * constants.lowPercentile;
+    float high = pixelCount * constants.highPercentile;
+    float passed = 0.0f;
+    float log2Sum = 0.0f;
+    float weight = 0.0f;
+    for (uint32_t bin = 0; bin < HISTOGRAM_BINS; bin++)
+    {
+        float count = (float)histogram[bin];
+        float inside = std::max(std::min(passed + count, high) - std::max(passed, low), 0.0f);
+        log2Sum += inside * (constants.minLog2 + (bin + 0.5f) * constants.log2Range / HISTOGRAM_BINS);
+        weight += inside;
+        passed += count;
+    }
+    float log2Average = weight > 0.0f ? log2Sum / weight : constants.minLog2;
+    return logf(exp2f(log2Average) + 1.0f);
+}
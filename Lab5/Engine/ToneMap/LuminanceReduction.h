@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cfloat>
+#include <cstdint>
+#include <vector>
+
+enum LuminanceExposure
+{
+    LUMINANCE_EXPOSURE_AVERAGE = 0,
+    LUMINANCE_EXPOSURE_HISTOGRAM = 1
+};
+
+// Layout of the LuminanceData cbuffer in Shaders/ToneMap/LuminanceReduction.hlsli.
+struct LuminanceConstants
+{
+    uint32_t width;
+    uint32_t height;
+    uint32_t groupCountX;
+    uint32_t groupCount;
+    float minLog2;
+    float log2Range;
+    float lowPercentile;
+    float highPercentile;
+    uint32_t exposureMode;
+    uint32_t padding[3];
+};
+
+struct LuminanceStats
+{
+    float logSum = 0.0f;
+    float minimum = FLT_MAX;
+    float maximum = 0.0f;
+};
+
+// What the tone mapper reads from the 1x1 targets: average of log(L + 1), minimum and maximum luminance.
+struct LuminanceResult
+{
+    float average;
+    float minimum;
+    float maximum;
+};
+
+// CPU mirror of luminanceReduceCS.hlsl / luminanceFinalizeCS.hlsl. The group reduction and the histogram percentile
+// follow the shaders step by step, so the luminance suite of EngineTests can check them against a plain scalar loop.
+class LuminanceReduction
+{
+public:
+    static const uint32_t GROUP_SIZE = 16;
+    static const uint32_t THREAD_COUNT = GROUP_SIZE * GROUP_SIZE;
+    static const uint32_t HISTOGRAM_BINS = 64;
+
+    static LuminanceConstants makeConstants(uint32_t width, uint32_t height, uint32_t exposureMode);
+    static float brightness(const float* rgb);
+    static uint32_t histogramBin(float brightness, const LuminanceConstants& constants);
+
+    static void reduceGroups(const float* rgbaPixels, const LuminanceConstants& constants,
+                             std::vector<LuminanceStats>* pPartials, std::vector<uint32_t>* pHistogram);
+    static LuminanceResult finalize(const std::vector<LuminanceStats>& partials, const std::vector<uint32_t>& histogram,
+                                    const LuminanceConstants& constants);
+    static LuminanceResult reduceReference(const float* rgbaPixels, const LuminanceConstants& constants);
+
+private:
+    static LuminanceStats combine(const LuminanceStats& a, const LuminanceStats& b);
+    static LuminanceStats reduceTree(std::vector<LuminanceStats>& values);
+    static float histogramAverage(const std::vector<uint32_t>& histogram, const LuminanceConstants& constants);
+};
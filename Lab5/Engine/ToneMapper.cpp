@@ -1,406 +1,458 @@
 ﻿#include "ToneMapper.h"
 
-#include "../DXDevice/DXDevice.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
 
-
-void ToneMapper::destroy()
+namespace
 {
-    destroyScaledBrighnessMaps();
-    delete rtv;
-    samplerAvg->Release();
-    samplerMin->Release();
-    samplerMax->Release();
-    delete constantBuffer;
-    mappingVS->Release();
-    brightnessPS->Release();
-    downsamplePS->Release();
-    tonemapPS->Release();
+    const char* MEMORY_CATEGORY = "HDR scene";
+    RenderShaderDesc MAPPING_VS = {
+        RENDER_STAGE_VERTEX, L"Shaders/ToneMap/mappingVS.hlsl", nullptr, 0, "Mapping VS"
+    };
+    RenderShaderDesc PIXEL_SHADERS[] = {
+        {RENDER_STAGE_PIXEL, L"Shaders/ToneMap/brightnessPS.hlsl", nullptr, 0, "Brightness PS"},
+        {RENDER_STAGE_PIXEL, L"Shaders/ToneMap/downsamplePS.hlsl", nullptr, 0, "Downsample PS"},
+        {RENDER_STAGE_PIXEL, L"Shaders/ToneMap/toneMapPS.hlsl", nullptr, 0, "Tone map PS"}
+    };
+    RenderShaderDesc COMPUTE_SHADERS[] = {
+        {RENDER_STAGE_COMPUTE, L"Shaders/ToneMap/luminanceReduceCS.hlsl", nullptr, 0, "Luminance reduce CS"},
+        {RENDER_STAGE_COMPUTE, L"Shaders/ToneMap/luminanceFinalizeCS.hlsl", nullptr, 0, "Luminance finalize CS"}
+    };
 }
 
-void ToneMapper::initialize(uint32_t width,
-                            uint32_t height, uint32_t imageInSwapChain)
-{
-    createTextures(width, height, imageInSwapChain);
-    HRESULT result = 0;
-
-    D3D11_SAMPLER_DESC desc = {};
-    desc.Filter = D3D11_FILTER_MIN_MAG_MIP_LINEAR;
 
-    desc.AddressU = D3D11_TEXTURE_ADDRESS_WRAP;
-    desc.AddressV = D3D11_TEXTURE_ADDRESS_WRAP;
-    desc.AddressW = D3D11_TEXTURE_ADDRESS_WRAP;
-    desc.MinLOD = -FLT_MAX;
-    desc.MaxLOD = FLT_MAX;
-    desc.MipLODBias = 0.0f;
-    desc.MaxAnisotropy = 16;
-    desc.ComparisonFunc = D3D11_COMPARISON_NEVER;
-    desc.BorderColor[0] = desc.BorderColor[1] = desc.BorderColor[2] = desc.BorderColor[3] = 1.0f;
-    result = device->CreateSamplerState(&desc, &samplerAvg);
-
-
-    if (SUCCEEDED(result))
+void ToneMapper::destroy()
+{
+    destroyLuminanceBuffers();
+    destroyTextures();
+    device->destroySampler(samplerAvg);
+    device->destroySampler(samplerMin);
+    device->destroySampler(samplerMax);
+    device->destroyBuffer(constantBuffer);
+    device->destroyShader(mappingVS);
+    device->destroyShader(brightnessPS);
+    device->destroyShader(downsamplePS);
+    device->destroyShader(tonemapPS);
+    if (luminanceReduceCS)
     {
-        desc.Filter = D3D11_FILTER_MINIMUM_ANISOTROPIC;
-
-        desc.AddressU = D3D11_TEXTURE_ADDRESS_WRAP;
-        desc.AddressV = D3D11_TEXTURE_ADDRESS_WRAP;
-        desc.AddressW = D3D11_TEXTURE_ADDRESS_WRAP;
-        desc.MinLOD = -FLT_MAX;
-        desc.MaxLOD = FLT_MAX;
-        desc.MipLODBias = 0.0f;
-        desc.MaxAnisotropy = 16;
-        desc.ComparisonFunc = D3D11_COMPARISON_NEVER;
-        desc.BorderColor[0] = desc.BorderColor[1] = desc.BorderColor[2] = desc.BorderColor[3] = 1.0f;
-        result = device->CreateSamplerState(&desc, &samplerMin);
+        device->destroyShader(luminanceReduceCS);
     }
-
-    if (SUCCEEDED(result))
+    if (luminanceFinalizeCS)
     {
-        desc.Filter = D3D11_FILTER_MAXIMUM_ANISOTROPIC;
-
-        desc.AddressU = D3D11_TEXTURE_ADDRESS_WRAP;
-        desc.AddressV = D3D11_TEXTURE_ADDRESS_WRAP;
-        desc.AddressW = D3D11_TEXTURE_ADDRESS_WRAP;
-        desc.MinLOD = -FLT_MAX;
-        desc.MaxLOD = FLT_MAX;
-        desc.MipLODBias = 0.0f;
-        desc.MaxAnisotropy = 16;
-        desc.ComparisonFunc = D3D11_COMPARISON_NEVER;
-        desc.BorderColor[0] = desc.BorderColor[1] = desc.BorderColor[2] = desc.BorderColor[3] = 1.0f;
-        result = device->CreateSamplerState(&desc, &samplerMax);
+        device->destroyShader(luminanceFinalizeCS);
     }
-
-    if (SUCCEEDED(result))
+    device->destroyBuffer(luminanceConstantBuffer);
+    for (auto& readback : luminanceReadbacks)
     {
-        adaptData.adapt = DirectX::XMFLOAT4(0.0f, 0.5f, 0.0f, 0.0f);
-        constantBuffer = new ConstantBuffer(device, &adaptData, sizeof(AdaptData), "Adapt data");
+        device->destroyReadback(readback.readback);
     }
-    loadShaders();
 }
 
-void ToneMapper::destroyScaledBrighnessMaps()
+void ToneMapper::requestShaders(RenderDevice* device)
 {
-    for (auto& scaledFrame : scaledFrames)
+    device->requestShader(MAPPING_VS);
+    for (const RenderShaderDesc& desc : PIXEL_SHADERS)
     {
-        scaledFrame.avg.shaderResourceView->Release();
-        scaledFrame.avg.renderTargetView->Release();
-        scaledFrame.avg.texture->Release();
-        scaledFrame.min.shaderResourceView->Release();
-        scaledFrame.min.renderTargetView->Release();
-        scaledFrame.min.texture->Release();
-        scaledFrame.max.shaderResourceView->Release();
-        scaledFrame.max.renderTargetView->Release();
-        scaledFrame.max.texture->Release();
+        device->requestShader(desc);
     }
-    readAvgTexture->Release();
+    for (const RenderShaderDesc& desc : COMPUTE_SHADERS)
+    {
+        device->requestShader(desc);
+    }
+}
 
-    scaledFrames.clear();
+void ToneMapper::initialize(uint32_t width, uint32_t height, uint32_t hdrRingSize)
+{
+    this->hdrRingSize = hdrRingSize;
+    createTextures(width, height);
+
+    samplerAvg = device->createSampler(RENDER_FILTER_LINEAR, RENDER_ADDRESS_WRAP);
+    samplerMin = device->createSampler(RENDER_FILTER_MINIMUM, RENDER_ADDRESS_WRAP);
+    samplerMax = device->createSampler(RENDER_FILTER_MAXIMUM, RENDER_ADDRESS_WRAP);
+
+    adaptData.adapt = RenderMath::makeFloat4(0.0f, 0.5f, 0.0f, 0.0f);
+    RenderBufferDesc constantDesc;
+    constantDesc.type = RENDER_BUFFER_CONSTANT;
+    constantDesc.size = sizeof(AdaptData);
+    constantDesc.name = "Adapt data";
+    constantBuffer = device->createBuffer(constantDesc, &adaptData);
+    constantDesc.size = sizeof(LuminanceConstants);
+    constantDesc.name = "Luminance reduction data";
+    luminanceConstantBuffer = device->createBuffer(constantDesc, &luminanceConstants);
+
+    loadShaders();
+    loadComputeShaders();
+    createLuminanceReadbacks();
+}
+
+void ToneMapper::destroyLuminanceBuffers()
+{
+    device->destroyBuffer(luminancePartials);
+    device->destroyBuffer(luminanceHistogram);
+    luminancePartials = RENDER_NULL_HANDLE;
+    luminanceHistogram = RENDER_NULL_HANDLE;
     scaledTexturesAmount = 0;
 }
 
 void ToneMapper::resize(uint32_t width, uint32_t height)
 {
-    destroyScaledBrighnessMaps();
-    createTextures(width, height, 0);
+    destroyLuminanceBuffers();
+    destroyTextures();
+    createTextures(width, height);
 }
 
-void ToneMapper::makeBrightnessMaps(ID3D11DeviceContext* deviceContext, uint32_t currentImage)
+LuminanceTargets ToneMapper::addLuminancePasses(FrameGraph* frameGraph, TransientTexturePool* texturePool,
+                                                FrameGraphResource hdrTarget)
 {
-#ifdef _DEBUG
-    annotations->BeginEvent(L"HDR");
-#endif
-#ifdef _DEBUG
-    annotations->EndEvent();
-    annotations->BeginEvent(L"Rendering brightness maps");
-#endif
+    // Both reductions are declared every frame. The tone map pass reads only the selected one, so the graph culls
+    // the other and its textures are never allocated.
+    LuminanceTargets pyramid = addBrightnessPyramidPasses(frameGraph, texturePool, hdrTarget);
+    // The pyramid stays as the fallback when the compute shaders are unavailable.
+    if (!luminanceReduceCS || !luminanceFinalizeCS)
+    {
+        return pyramid;
+    }
 
-    for (int i = scaledTexturesAmount; i >= 0; i--)
+    LuminanceTargets reduced = createLuminanceTargets(frameGraph, "Reduced luminance", 1,
+                                                      RENDER_BIND_SHADER_RESOURCE | RENDER_BIND_UNORDERED_ACCESS);
+    FrameGraphPass pass = frameGraph->addPass("Luminance reduction", [=]()
     {
-        if (i == scaledTexturesAmount)
+        RenderTexture targets[3];
+        for (uint32_t i = 0; i < 3; i++)
         {
-            ID3D11RenderTargetView* views[] = {
-                scaledFrames[i].avg.renderTargetView,
-                scaledFrames[i].min.renderTargetView,
-                scaledFrames[i].max.renderTargetView
-            };
-            deviceContext->OMSetRenderTargets(3, views, nullptr);
+            targets[i] = texturePool->getTexture(*frameGraph, reduced.textures[i]);
         }
-        else
+        reduceLuminance(targets);
+    });
+    frameGraph->read(pass, hdrTarget);
+    for (FrameGraphResource texture : reduced.textures)
+    {
+        frameGraph->write(pass, texture);
+    }
+    return reductionMode == LUMINANCE_REDUCTION_COMPUTE ? reduced : pyramid;
+}
+
+LuminanceTargets ToneMapper::addBrightnessPyramidPasses(FrameGraph* frameGraph, TransientTexturePool* texturePool,
+                                                        FrameGraphResource hdrTarget)
+{
+    LuminanceTargets previous = {};
+    for (int i = scaledTexturesAmount; i >= 0; i--)
+    {
+        LuminanceTargets level = createLuminanceTargets(frameGraph, "Brightness level " + std::to_string(i), 1 << i,
+                                                        RENDER_BIND_RENDER_TARGET | RENDER_BIND_SHADER_RESOURCE);
+        bool top = i == (int)scaledTexturesAmount;
+        FrameGraphPass pass = frameGraph->addPass("Brightness level " + std::to_string(i), [=]()
+        {
+            RenderTexture targets[3];
+            RenderTexture sources[3];
+            for (uint32_t j = 0; j < 3; j++)
+            {
+                targets[j] = texturePool->getTexture(*frameGraph, level.textures[j]);
+                sources[j] = top ? getHdrTarget() : texturePool->getTexture(*frameGraph, previous.textures[j]);
+            }
+            renderBrightnessLevel(i, targets, sources);
+        });
+        for (uint32_t j = 0; j < 3; j++)
         {
-            ID3D11RenderTargetView* views[] = {
-                scaledFrames[i].avg.renderTargetView, scaledFrames[i].min.renderTargetView,
-                scaledFrames[i].max.renderTargetView
-            };
-            deviceContext->OMSetRenderTargets(3, views, nullptr);
+            frameGraph->read(pass, top ? hdrTarget : previous.textures[j]);
+            frameGraph->write(pass, level.textures[j]);
         }
+        previous = level;
+    }
+    return previous;
+}
 
-        ID3D11SamplerState* samplers[] = {samplerAvg, samplerMin, samplerMax};
-        deviceContext->PSSetSamplers(0, 3, samplers);
-
-        D3D11_VIEWPORT viewport;
-        viewport.TopLeftX = 0;
-        viewport.TopLeftY = 0;
-        viewport.Width = (FLOAT)pow(2, i);
-        viewport.Height = (FLOAT)pow(2, i);
-        viewport.MinDepth = 0.0f;
-        viewport.MaxDepth = 1.0f;
-        deviceContext->RSSetViewports(1, &viewport);
-
-        ID3D11ShaderResourceView* resources[] = {
-            i == scaledTexturesAmount
-                ? rtv->getResourceViews()[currentImage]
-                : scaledFrames[i + 1].avg.shaderResourceView,
-            i == scaledTexturesAmount
-                ? rtv->getResourceViews()[currentImage]
-                : scaledFrames[i + 1].min.shaderResourceView,
-            i == scaledTexturesAmount
-                ? rtv->getResourceViews()[currentImage]
-                : scaledFrames[i + 1].max.shaderResourceView
-        };
-        deviceContext->PSSetShaderResources(0, 3, resources);
-        deviceContext->OMSetDepthStencilState(nullptr, 0);
-        deviceContext->RSSetState(nullptr);
-        deviceContext->OMSetBlendState(nullptr, nullptr, 0xFFFFFFFF);
-        deviceContext->IASetInputLayout(nullptr);
-        deviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-        deviceContext->VSSetShader(mappingVS, nullptr, 0);
-        deviceContext->PSSetShader(i == scaledTexturesAmount ? brightnessPS : downsamplePS, nullptr, 0);
-        deviceContext->Draw(6, 0);
-
-        DXDevice::unBindRenderTargets(deviceContext);
+void ToneMapper::addToneMapPass(FrameGraph* frameGraph, TransientTexturePool* texturePool,
+                                FrameGraphResource hdrTarget, const LuminanceTargets& luminance,
+                                FrameGraphResource output, RenderTexture outputTexture)
+{
+    FrameGraphPass pass = frameGraph->addPass("Tone mapping", [=]()
+    {
+        RenderTexture textures[3];
+        for (uint32_t i = 0; i < 3; i++)
+        {
+            textures[i] = texturePool->getTexture(*frameGraph, luminance.textures[i]);
+        }
+        postProcessToneMap(textures, outputTexture);
+    });
+    frameGraph->read(pass, hdrTarget);
+    for (FrameGraphResource texture : luminance.textures)
+    {
+        frameGraph->read(pass, texture);
     }
-#ifdef _DEBUG
-    annotations->EndEvent();
-#endif
+    frameGraph->write(pass, output);
 }
 
-void ToneMapper::postProcessToneMap(ID3D11DeviceContext* deviceContext, uint32_t currentImage)
+LuminanceTargets ToneMapper::createLuminanceTargets(FrameGraph* frameGraph, const std::string& name, uint32_t side,
+                                                    uint32_t usage)
 {
-#ifdef _DEBUG
-    annotations->BeginEvent(L"Tone mapping");
-#endif
+    FrameGraphTextureDesc desc;
+    desc.width = side;
+    desc.height = side;
+    desc.format = RENDER_FORMAT_R32_FLOAT;
+    desc.usage = usage;
+
+    LuminanceTargets targets;
+    targets.textures[0] = frameGraph->createTexture(name + " avg", desc);
+    targets.textures[1] = frameGraph->createTexture(name + " min", desc);
+    targets.textures[2] = frameGraph->createTexture(name + " max", desc);
+    return targets;
+}
 
-    auto time = std::chrono::high_resolution_clock::now();
-    float dtime = std::chrono::duration<float, std::milli>(time - lastFrameTime).count() * 0.001;
-    lastFrameTime = time;
-#ifdef _DEBUG
-    annotations->BeginEvent(L"Calculating adaptation");
-#endif
+void ToneMapper::reduceLuminance(const RenderTexture* targets)
+{
+    RenderScope scope(device, "Luminance reduction");
+    luminanceConstants.exposureMode = exposureMode;
+    device->updateBuffer(luminanceConstantBuffer, &luminanceConstants, sizeof(LuminanceConstants));
+    device->clearStorageBuffer(luminanceHistogram);
+
+    RenderTexture hdrTexture = getHdrTarget();
+    RenderBuffer reduceBuffers[] = {luminancePartials, luminanceHistogram};
+    device->setComputeShader(luminanceReduceCS);
+    device->setTextures(RENDER_STAGE_COMPUTE, 0, 1, &hdrTexture);
+    device->setStorageBuffers(0, 2, reduceBuffers);
+    device->setConstantBuffer(RENDER_STAGE_COMPUTE, 0, luminanceConstantBuffer);
+    device->dispatch(luminanceConstants.groupCountX, luminanceConstants.groupCount / luminanceConstants.groupCountX,
+                     1);
+
+    // The targets replace the reduce outputs before the partials are read back as inputs.
+    device->setComputeShader(luminanceFinalizeCS);
+    device->setStorageTextures(0, 3, targets);
+    device->setBuffers(RENDER_STAGE_COMPUTE, 0, 2, reduceBuffers);
+    device->dispatch(1, 1, 1);
+    device->setComputeShader(RENDER_NULL_HANDLE);
+}
 
-    deviceContext->CopyResource(readAvgTexture, scaledFrames[0].avg.texture);
-    D3D11_MAPPED_SUBRESOURCE ResourceDesc = {};
-    if (FAILED(deviceContext->Map(readAvgTexture, 0, D3D11_MAP_READ, 0, &ResourceDesc)))
+void ToneMapper::renderBrightnessLevel(uint32_t level, const RenderTexture* targets, const RenderTexture* sources)
+{
+    RenderScope scope(device, level == scaledTexturesAmount ? "Brightness map" : "Brightness downsample");
+    RenderPassDesc pass;
+    pass.name = "Brightness level";
+    pass.colorCount = 3;
+    for (uint32_t i = 0; i < 3; i++)
     {
-        throw std::runtime_error("Failed to read values from brightness buffer");
+        pass.colors[i].texture = targets[i];
     }
+    device->beginPass(pass);
+
+    RenderPipelineDesc pipeline;
+    pipeline.vertexShader = mappingVS;
+    pipeline.pixelShader = level == scaledTexturesAmount ? brightnessPS : downsamplePS;
+    device->setPipeline(pipeline);
+    RenderSampler samplers[] = {samplerAvg, samplerMin, samplerMax};
+    device->setSamplers(RENDER_STAGE_PIXEL, 0, 3, samplers);
+    device->setTextures(RENDER_STAGE_PIXEL, 0, 3, sources);
+    device->draw(6);
+
+    device->endPass();
+}
 
-    float avg;
-    if (ResourceDesc.pData)
+void ToneMapper::postProcessToneMap(const RenderTexture* luminance, RenderTexture output)
+{
+    RenderScope toneMapScope(device, "Tone mapping");
+
+    auto time = std::chrono::steady_clock::now();
+    float dtime = std::chrono::duration<float, std::milli>(time - lastFrameTime).count() * 0.001;
+    lastFrameTime = time;
     {
-        float* pData = reinterpret_cast<float*>(ResourceDesc.pData);
-        avg = *((float*)ResourceDesc.pData);
+        RenderScope adaptationScope(device, "Calculating adaptation");
+        readLuminance();
+        queueLuminanceReadback(luminance[0]);
+        frameIndex++;
+
+        adapt += (lastLuminance - adapt) * (1.0f - exp(-dtime / s));
+
+
+        adaptData.adapt = RenderMath::makeFloat4(adapt, 0.0f, 0.0f, 0.0f);
+
+        device->updateBuffer(constantBuffer, &adaptData, sizeof(AdaptData));
     }
-    deviceContext->Unmap(readAvgTexture, 0);
+    RenderScope postprocessScope(device, "Postprocess: tone mapping");
+
+    RenderPassDesc pass;
+    pass.name = "Tone mapping";
+    pass.colorCount = 1;
+    pass.colors[0].texture = output;
+    device->beginPass(pass);
+
+    RenderPipelineDesc pipeline;
+    pipeline.vertexShader = mappingVS;
+    pipeline.pixelShader = tonemapPS;
+    device->setPipeline(pipeline);
+    RenderTexture resources[] = {getHdrTarget(), luminance[0], luminance[1], luminance[2]};
+    device->setTextures(RENDER_STAGE_PIXEL, 0, 4, resources);
+    device->setSamplers(RENDER_STAGE_PIXEL, 0, 1, &samplerAvg);
+    device->setConstantBuffer(RENDER_STAGE_PIXEL, 0, constantBuffer);
+    device->draw(6);
+
+    device->endPass();
+}
 
-    adapt += (avg - adapt) * (1.0f - exp(-dtime / s));
+void ToneMapper::beginFrame()
+{
+    hdrImage = (hdrImage + 1) % hdrRingSize;
+}
 
+uint32_t ToneMapper::getHdrImage() const
+{
+    return hdrImage;
+}
 
-    adaptData.adapt = DirectX::XMFLOAT4(adapt, 0.0f, 0.0f, 0.0f);
+RenderTexture ToneMapper::getHdrTarget() const
+{
+    return hdrTargets[hdrImage];
+}
 
-    constantBuffer->updateData(deviceContext, &adaptData);
-#ifdef _DEBUG
-    annotations->EndEvent();
-    annotations->BeginEvent(L"Postprocess: tone mapping");
-#endif
+RenderTexture ToneMapper::getDepthTarget() const
+{
+    return depthTarget;
+}
 
-    ID3D11ShaderResourceView* resources[] = {
-        rtv->getResourceViews()[currentImage],
-        scaledFrames[0].avg.shaderResourceView,
-        scaledFrames[0].min.shaderResourceView,
-        scaledFrames[0].max.shaderResourceView
-    };
-    deviceContext->PSSetShaderResources(0, 4, resources);
-    deviceContext->OMSetDepthStencilState(nullptr, 0);
-    deviceContext->RSSetState(nullptr);
-    deviceContext->OMSetBlendState(nullptr, nullptr, 0xFFFFFFFF);
-    deviceContext->IASetInputLayout(nullptr);
-    deviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-    constantBuffer->bindToPixelShader(deviceContext);
-    deviceContext->VSSetShader(mappingVS, nullptr, 0);
-    deviceContext->PSSetShader(tonemapPS, nullptr, 0);
-    deviceContext->Draw(6, 0);
-#ifdef _DEBUG
-    annotations->EndEvent();
-    annotations->EndEvent();
-    annotations->EndEvent();
-#endif
+const LuminanceReadbackStats& ToneMapper::getReadbackStats() const
+{
+    return readbackStats;
 }
 
-DXRenderTargetView* ToneMapper::getRendertargetView()
+void ToneMapper::setReductionMode(int mode)
 {
-    return rtv;
+    reductionMode = mode;
 }
 
-void ToneMapper::clearRenderTarget(ID3D11DeviceContext* deviceContext, uint32_t currentImage)
+void ToneMapper::setExposureMode(int mode)
 {
-    rtv->clearColorAttachments(deviceContext, 0.25f, 0.25f, 0.25f, 1.0f, currentImage);
-    rtv->clearDepthAttachments(deviceContext);
-    float color[4] = {0.25f, 0.25f, 0.25f, 1.0f};
-    for (auto& scaledFrame : scaledFrames)
-    {
-        deviceContext->ClearRenderTargetView(scaledFrame.avg.renderTargetView, color);
-    }
-#ifdef _DEBUG
-    annotations->BeginEvent(L"Rendering main frame");
-#endif
+    exposureMode = mode;
 }
 
-void ToneMapper::createTextures(uint32_t width, uint32_t height, uint32_t imagesInSwapChainAmount)
+void ToneMapper::readLuminance()
 {
-    if (!rtv)
+    // Drains every finished copy in submission order without ever waiting on the GPU; adaptation uses the newest.
+    auto start = std::chrono::steady_clock::now();
+    while (luminanceReadbacks[readbackReadIndex].pending)
     {
-        rtv = new DXRenderTargetView(device, imagesInSwapChainAmount, width, height,
-                                     "Frame for brightness map postprocess");
+        LuminanceReadback& readback = luminanceReadbacks[readbackReadIndex];
+        if (!device->readReadback(readback.readback, &lastLuminance, sizeof(float)))
+        {
+            break;
+        }
+        readbackStats.lastLatencyFrames = frameIndex - readback.frame;
+        readback.pending = false;
+        readbackReadIndex = (readbackReadIndex + 1) % LUMINANCE_READBACK_RING_SIZE;
     }
-    else
+    readbackStats.lastStallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).
+        count();
+    if (readbackStats.lastStallMs > readbackStats.maxStallMs)
     {
-        rtv->destroy();
-        rtv->resize(width, height);
+        readbackStats.maxStallMs = readbackStats.lastStallMs;
     }
-    int minSide = min(width, height);
+}
 
-    while (minSide >>= 1)
-    {
-        scaledTexturesAmount++;
-    }
-    for (int i = 0; i < scaledTexturesAmount + 1; i++)
+void ToneMapper::queueLuminanceReadback(RenderTexture luminance)
+{
+    LuminanceReadback& readback = luminanceReadbacks[readbackWriteIndex];
+    if (readback.pending)
     {
-        ScaledFrame scaledFrame;
-        createSquareTexture(scaledFrame.avg, i);
-        createSquareTexture(scaledFrame.min, i);
-        createSquareTexture(scaledFrame.max, i);
-        scaledFrames.push_back(scaledFrame);
+        // Every slot is still in flight; skip this frame's sample rather than stall.
+        readbackStats.droppedSamples++;
+        return;
     }
-    D3D11_TEXTURE2D_DESC textureDesc = {};
-
-    textureDesc.Width = 1;
-    textureDesc.Height = 1;
-    textureDesc.MipLevels = 0;
-    textureDesc.ArraySize = 1;
-    textureDesc.Format = DXGI_FORMAT_R32_FLOAT;
-    textureDesc.SampleDesc.Count = 1;
-    textureDesc.Usage = D3D11_USAGE_STAGING;
-    textureDesc.BindFlags = 0;
-    textureDesc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
-    textureDesc.MiscFlags = 0;
-
-    device->CreateTexture2D(&textureDesc, NULL, &readAvgTexture);
+    device->copyToReadback(readback.readback, luminance);
+    readback.frame = frameIndex;
+    readback.pending = true;
+    readbackWriteIndex = (readbackWriteIndex + 1) % LUMINANCE_READBACK_RING_SIZE;
 }
 
-
-void ToneMapper::createSquareTexture(Texture& text, uint32_t len)
+void ToneMapper::createTextures(uint32_t width, uint32_t height)
 {
-    D3D11_TEXTURE2D_DESC desc;
-    desc.Format = DXGI_FORMAT_R32_FLOAT;
-    desc.ArraySize = 1;
-    desc.MipLevels = 1;
-    desc.Usage = D3D11_USAGE_DEFAULT;
-    desc.BindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE;
-    desc.CPUAccessFlags = 0;
-    desc.MiscFlags = 0;
-    desc.SampleDesc.Count = 1;
-    desc.SampleDesc.Quality = 0;
-    desc.Height = pow(2, len);
-    desc.Width = pow(2, len);
-    HRESULT result = device->CreateTexture2D(&desc, nullptr, &text.texture);
-    if (SUCCEEDED(result))
-    {
-        D3D11_SHADER_RESOURCE_VIEW_DESC descSRV = {};
-        descSRV.Format = DXGI_FORMAT_R32_FLOAT;
-        descSRV.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
-        descSRV.Texture2D.MipLevels = 1;
-        descSRV.Texture2D.MostDetailedMip = 0;
-        result = device->CreateShaderResourceView(text.texture, &descSRV, &text.shaderResourceView);
-        if (FAILED(result))
-        {
-            throw std::runtime_error("Failed to create shader resource view");
-        }
-    }
-    else
+    RenderTextureDesc desc;
+    desc.width = width;
+    desc.height = height;
+    desc.format = HDR_FORMAT;
+    desc.bindFlags = RENDER_BIND_RENDER_TARGET | RENDER_BIND_SHADER_RESOURCE;
+    desc.name = "HDR scene";
+    desc.memoryCategory = MEMORY_CATEGORY;
+    hdrTargets.resize(hdrRingSize);
+    for (RenderTexture& target : hdrTargets)
     {
-        throw std::runtime_error("Failed to create texture");
+        target = device->createTexture(desc);
     }
+    desc.format = RENDER_FORMAT_D24_UNORM_S8_UINT;
+    desc.bindFlags = RENDER_BIND_DEPTH_STENCIL;
+    desc.name = "HDR scene depth";
+    depthTarget = device->createTexture(desc);
 
+    int minSide = std::min(width, height);
 
-    result = device->CreateRenderTargetView(text.texture, nullptr, &text.renderTargetView);
-    if (FAILED(result))
+    while (minSide >>= 1)
     {
-        throw std::runtime_error("Failed to create render target view");
+        scaledTexturesAmount++;
     }
+    luminanceConstants = LuminanceReduction::makeConstants(width, height, exposureMode);
+    luminancePartials = createComputeBuffer(sizeof(float) * 3, luminanceConstants.groupCount,
+                                            "Luminance partials");
+    luminanceHistogram = createComputeBuffer(sizeof(uint32_t), LuminanceReduction::HISTOGRAM_BINS,
+                                             "Luminance histogram");
 }
 
-void ToneMapper::loadShaders()
+void ToneMapper::destroyTextures()
 {
-    HRESULT result = 0;
-    ID3DBlob* vertexShaderBuffer = nullptr;
-    ID3DBlob* pixelShaderBuffer = nullptr;
-    int flags = 0;
-#ifdef _DEBUG
-    flags = D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION;
-#endif
-
-    if (SUCCEEDED(result))
+    for (RenderTexture target : hdrTargets)
     {
-        result = D3DCompileFromFile(L"Shaders/ToneMap/brightnessPS.hlsl", NULL, NULL, "main", "ps_5_0", flags, 0,
-                                    &pixelShaderBuffer, NULL);
-        if (SUCCEEDED(result))
-        {
-            result = device->CreatePixelShader(pixelShaderBuffer->GetBufferPointer(),
-                                               pixelShaderBuffer->GetBufferSize(), NULL, &brightnessPS);
-        }
+        device->destroyTexture(target);
     }
+    hdrTargets.clear();
+    device->destroyTexture(depthTarget);
+    depthTarget = RENDER_NULL_HANDLE;
+}
 
-    pixelShaderBuffer->Release();
+RenderBuffer ToneMapper::createComputeBuffer(uint32_t elementSize, uint32_t elementCount, const char* name)
+{
+    RenderBufferDesc desc;
+    desc.type = RENDER_BUFFER_STRUCTURED;
+    desc.size = elementSize * elementCount;
+    desc.stride = elementSize;
+    desc.name = name;
+    desc.memoryCategory = "Luminance reduction";
+    return device->createBuffer(desc);
+}
+
+void ToneMapper::createLuminanceReadbacks()
+{
+    RenderTextureDesc desc;
+    desc.width = 1;
+    desc.height = 1;
+    desc.format = RENDER_FORMAT_R32_FLOAT;
 
-    if (SUCCEEDED(result))
+    for (auto& readback : luminanceReadbacks)
     {
-        result = D3DCompileFromFile(L"Shaders/ToneMap/mappingVS.hlsl", NULL, NULL, "main", "vs_5_0", flags, 0,
-                                    &vertexShaderBuffer,
-                                    NULL);
-        if (SUCCEEDED(result))
-        {
-            result = device->CreateVertexShader(vertexShaderBuffer->GetBufferPointer(),
-                                                vertexShaderBuffer->GetBufferSize(), NULL, &mappingVS);
-        }
+        readback.readback = device->createReadback(desc);
     }
-    if (SUCCEEDED(result))
+}
+
+
+void ToneMapper::loadShaders()
+{
+    mappingVS = device->createShader(MAPPING_VS);
+    brightnessPS = device->createShader(PIXEL_SHADERS[0]);
+    downsamplePS = device->createShader(PIXEL_SHADERS[1]);
+    tonemapPS = device->createShader(PIXEL_SHADERS[2]);
+}
+
+void ToneMapper::loadComputeShaders()
+{
+    try
     {
-        result = D3DCompileFromFile(L"Shaders/ToneMap/downsamplePS.hlsl", NULL, NULL, "main", "ps_5_0", flags, 0,
-                                    &pixelShaderBuffer, NULL);
-        if (SUCCEEDED(result))
-        {
-            result = device->CreatePixelShader(pixelShaderBuffer->GetBufferPointer(),
-                                               pixelShaderBuffer->GetBufferSize(), NULL, &downsamplePS);
-        }
+        luminanceReduceCS = device->createShader(COMPUTE_SHADERS[0]);
+        luminanceFinalizeCS = device->createShader(COMPUTE_SHADERS[1]);
     }
-
-    vertexShaderBuffer->Release();
-    pixelShaderBuffer->Release();
-    if (SUCCEEDED(result))
+    catch (const std::runtime_error& error)
     {
-        result = D3DCompileFromFile(L"Shaders/ToneMap/toneMapPS.hlsl", NULL, NULL, "main", "ps_5_0", flags, 0,
-                                    &pixelShaderBuffer,
-                                    NULL);
-        if (SUCCEEDED(result))
+        // Not fatal: addLuminancePasses falls back to the pixel shader pyramid.
+        std::cerr << error.what() << std::endl;
+        if (luminanceReduceCS)
         {
-            result = device->CreatePixelShader(pixelShaderBuffer->GetBufferPointer(),
-                                               pixelShaderBuffer->GetBufferSize(), NULL, &tonemapPS);
+            device->destroyShader(luminanceReduceCS);
+            luminanceReduceCS = RENDER_NULL_HANDLE;
         }
     }
-
-    pixelShaderBuffer->Release();
-    if (FAILED(result))
-    {
-        throw std::runtime_error("Failed to initialize shaders");
-    }
 }
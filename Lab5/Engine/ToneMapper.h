@@ -1,80 +1,133 @@
 ﻿#pragma once
 
 #include <chrono>
-#include <d3d11.h>
-#include <d3d11_1.h>
-#include <DirectXMath.h>
 #include <vector>
-#include <d3dcompiler.h>
 #include <stdexcept>
+#include <string>
 
-#include "../DXDevice/DXRenderTargetView.h"
-#include "../DXShader/ConstantBuffer.h"
+#include "FrameGraph/FrameGraph.h"
+#include "FrameGraph/TransientTexturePool.h"
+#include "RenderDevice/RenderDevice.h"
+#include "RenderDevice/RenderMath.h"
+#include "ToneMap/LuminanceReduction.h"
 
-struct Texture
+enum LuminanceReductionMode
 {
-    ID3D11Texture2D* texture = nullptr;
-    ID3D11RenderTargetView* renderTargetView = nullptr;
-    ID3D11ShaderResourceView* shaderResourceView = nullptr;
+    LUMINANCE_REDUCTION_COMPUTE = 0,
+    LUMINANCE_REDUCTION_PYRAMID = 1
 };
 
-struct ScaledFrame
+// Frame graph textures holding the average, minimum and maximum luminance, in that order.
+struct LuminanceTargets
 {
-    Texture min;
-    Texture avg;
-    Texture max;
+    FrameGraphResource textures[3];
 };
 
 struct AdaptData
 {
-    DirectX::XMFLOAT4 adapt;
+    Float4 adapt;
+};
+
+struct LuminanceReadback
+{
+    RenderReadback readback = RENDER_NULL_HANDLE;
+    uint64_t frame = 0;
+    bool pending = false;
+};
+
+struct LuminanceReadbackStats
+{
+    uint64_t lastLatencyFrames = 0;
+    uint64_t droppedSamples = 0;
+    double lastStallMs = 0;
+    double maxStallMs = 0;
 };
 
 class ToneMapper
 {
 public:
-    ToneMapper(ID3D11Device* device, ID3DUserDefinedAnnotation* annotations)
-        : device(device),
-          annotations(annotations)
+    // One HDR scene target is enough on an immediate context: the tone map pass consumes it before the next frame
+    // writes it, and D3D11 orders the two. Only a pass reading an older frame's image needs a longer ring.
+    static const uint32_t DEFAULT_HDR_RING_SIZE = 1;
+    static const RenderFormat HDR_FORMAT = RENDER_FORMAT_R16G16B16A16_FLOAT;
+
+    explicit ToneMapper(RenderDevice* device)
+        : device(device)
     {
     }
 
 private:
-    ID3D11Device* device;
-    DXRenderTargetView* rtv;
+    RenderDevice* device;
+    std::vector<RenderTexture> hdrTargets;
+    RenderTexture depthTarget = RENDER_NULL_HANDLE;
+    uint32_t hdrRingSize = DEFAULT_HDR_RING_SIZE;
+    uint32_t hdrImage = 0;
     uint32_t scaledTexturesAmount = 0;
-    std::vector<ScaledFrame> scaledFrames;
-    ID3D11SamplerState* samplerAvg;
-    ID3D11SamplerState* samplerMin;
-    ID3D11SamplerState* samplerMax;
-    ConstantBuffer* constantBuffer;
+    RenderSampler samplerAvg;
+    RenderSampler samplerMin;
+    RenderSampler samplerMax;
+    RenderBuffer constantBuffer;
     AdaptData adaptData{};
 
-    ID3D11VertexShader* mappingVS;
-    ID3D11PixelShader* brightnessPS;
-    ID3D11PixelShader* downsamplePS;
-    ID3D11PixelShader* tonemapPS;
+    RenderShader mappingVS;
+    RenderShader brightnessPS;
+    RenderShader downsamplePS;
+    RenderShader tonemapPS;
+    RenderShader luminanceReduceCS = RENDER_NULL_HANDLE;
+    RenderShader luminanceFinalizeCS = RENDER_NULL_HANDLE;
+    RenderBuffer luminanceConstantBuffer;
+    LuminanceConstants luminanceConstants{};
+    RenderBuffer luminancePartials = RENDER_NULL_HANDLE;
+    RenderBuffer luminanceHistogram = RENDER_NULL_HANDLE;
+    int reductionMode = LUMINANCE_REDUCTION_COMPUTE;
+    int exposureMode = LUMINANCE_EXPOSURE_AVERAGE;
     std::chrono::time_point<std::chrono::steady_clock> lastFrameTime;
-    ID3D11Texture2D* readAvgTexture;
-    ID3DUserDefinedAnnotation* annotations;
     float adapt = 0;
     float s = 0.5f;
 
+    static const uint32_t LUMINANCE_READBACK_RING_SIZE = 4;
+    LuminanceReadback luminanceReadbacks[LUMINANCE_READBACK_RING_SIZE];
+    uint32_t readbackWriteIndex = 0;
+    uint32_t readbackReadIndex = 0;
+    uint64_t frameIndex = 0;
+    float lastLuminance = 0;
+    LuminanceReadbackStats readbackStats;
+
 public:
-    void initialize(uint32_t width, uint32_t height, uint32_t imagesInSwapChainAmount);
+    static void requestShaders(RenderDevice* device);
+    void initialize(uint32_t width, uint32_t height, uint32_t hdrRingSize);
+
 
-    
     void resize(uint32_t width, uint32_t height);
-    void makeBrightnessMaps(ID3D11DeviceContext* deviceContext, uint32_t currentImage);
-    void postProcessToneMap(ID3D11DeviceContext* deviceContext, uint32_t currentImage);
+    LuminanceTargets addLuminancePasses(FrameGraph* frameGraph, TransientTexturePool* texturePool,
+                                        FrameGraphResource hdrTarget);
+    void addToneMapPass(FrameGraph* frameGraph, TransientTexturePool* texturePool, FrameGraphResource hdrTarget,
+                        const LuminanceTargets& luminance, FrameGraphResource output, RenderTexture outputTexture);
 
-    DXRenderTargetView* getRendertargetView();
+    void beginFrame();
+    uint32_t getHdrImage() const;
+    RenderTexture getHdrTarget() const;
+    RenderTexture getDepthTarget() const;
+    const LuminanceReadbackStats& getReadbackStats() const;
+    void setReductionMode(int mode);
+    void setExposureMode(int mode);
 
-    void clearRenderTarget(ID3D11DeviceContext* deviceContext, uint32_t currentImage);
     void destroy();
 private:
-    void createTextures(uint32_t width, uint32_t height, uint32_t imagesInSwapChainAmount);
-    void createSquareTexture(Texture& text, uint32_t len);
+    void createTextures(uint32_t width, uint32_t height);
+    void destroyTextures();
+    LuminanceTargets createLuminanceTargets(FrameGraph* frameGraph, const std::string& name, uint32_t side,
+                                            uint32_t usage);
+    RenderBuffer createComputeBuffer(uint32_t elementSize, uint32_t elementCount, const char* name);
     void loadShaders();
-    void destroyScaledBrighnessMaps();
+    void loadComputeShaders();
+    LuminanceTargets addBrightnessPyramidPasses(FrameGraph* frameGraph, TransientTexturePool* texturePool,
+                                                FrameGraphResource hdrTarget);
+    void reduceLuminance(const RenderTexture* targets);
+    void renderBrightnessLevel(uint32_t level, const RenderTexture* targets, const RenderTexture* sources);
+    void postProcessToneMap(const RenderTexture* luminance, RenderTexture output);
+    void createLuminanceReadbacks();
+    void readLuminance();
+    void queueLuminanceReadback(RenderTexture luminance);
+    void destroyLuminanceBuffers();
 };
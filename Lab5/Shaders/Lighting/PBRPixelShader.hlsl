@@ -11,18 +11,33 @@ struct PixelShaderInput
     float3 normal: NORMAL;
     float2 uv: UV;
     float3 color: COLOR;
+    float2 material: MATERIAL;
 };
 
 struct PointLight
 {
     float3 position;
+    float radius;
+    float3 color;
     float intensity;
 };
 
+// Clustered lights, built on the CPU by LightClusters: the cluster of a pixel lists the lights that can reach it as
+// an offset and count into lightIndices.
+static const uint CLUSTER_GRID_X = 16;
+static const uint CLUSTER_GRID_Y = 9;
+static const uint CLUSTER_GRID_Z = 24;
+
+StructuredBuffer<PointLight> lights : register (t3);
+StructuredBuffer<uint2> lightClusters : register (t4);
+StructuredBuffer<uint> lightIndices : register (t5);
+
 cbuffer LightData: register(b0)
 {
-    PointLight lightsInfos[3];
+    float4x4 cameraMatrix;
     float3 cameraPosition;
+    float clusterDepthScale;
+    float clusterDepthBias;
 };
 
 cbuffer Configuration: register(b1)
@@ -32,10 +47,16 @@ cbuffer Configuration: register(b1)
     int fresnelFunction;
     int geometryFunction;
 
-    float metallic;
-    float roughness;
+    // Superseded by the per-instance material, kept for the buffer layout.
+    float configMetallic;
+    float configRoughness;
     float ambientIntensity;
-    float alignment;
+    int irradianceMode;
+};
+
+cbuffer IrradianceSH: register(b2)
+{
+    float4 shCoefficients[9];
 };
 
 
@@ -88,6 +109,24 @@ float3 F_SchlickR(float cosTheta, float3 F0, float roughness)
     return F0 + (max(float3(1.0 - roughness, 1.0-roughness, 1.0-roughness), F0) - F0) * pow(1.0 - cosTheta, 5.0);
 }
 
+// Inverse square falloff windowed to zero at the light radius.
+float distanceAttenuation(float distance, float radius)
+{
+    float ratio = distance / radius;
+    float window = saturate(1.0 - ratio * ratio * ratio * ratio);
+    return window * window / max(distance * distance, 1.0);
+}
+
+uint findCluster(float3 worldPos)
+{
+    float4 clipPos = mul(cameraMatrix, float4(worldPos, 1.0f));
+    float2 ndc = clipPos.xy / clipPos.w;
+    uint x = (uint)clamp(floor((ndc.x * 0.5 + 0.5) * CLUSTER_GRID_X), 0.0, CLUSTER_GRID_X - 1.0);
+    uint y = (uint)clamp(floor((ndc.y * 0.5 + 0.5) * CLUSTER_GRID_Y), 0.0, CLUSTER_GRID_Y - 1.0);
+    uint z = (uint)clamp(floor(log2(clipPos.w) * clusterDepthScale + clusterDepthBias), 0.0, CLUSTER_GRID_Z - 1.0);
+    return (z * CLUSTER_GRID_Y + y) * CLUSTER_GRID_X + x;
+}
+
 float3 processPointLight(PointLight light, float3 normals, float3 fragmentPosition, float3 worldViewVector,
                          float3 startFresnelSchlick, float roughness, float metallic, float3 albedo)
 {
@@ -95,8 +134,7 @@ float3 processPointLight(PointLight light, float3 normals, float3 fragmentPositi
     float distance = length(light.position - fragmentPosition);
     float3 halfWay = normalize((worldViewVector + processedLightPos)/2.0f);
     
-    float attenuation = clamp(1.0 / (distance * distance), 0.01, 1.0f);
-    float3 radiance = float3(1, 1, 1)* light.intensity *attenuation;
+    float3 radiance = light.color * light.intensity * distanceAttenuation(distance, light.radius);
 
     float halfWayGGX = distributeGGX(normals, halfWay, roughness);
     float geometrySmith = smithGeometry(normals, worldViewVector, processedLightPos, roughness);
@@ -146,6 +184,20 @@ float3 processPointLight(PointLight light, float3 normals, float3 fragmentPositi
     }
 }
 
+float3 irradianceSH(float3 normal)
+{
+    float3 result = shCoefficients[0].rgb * 0.282095;
+    result += shCoefficients[1].rgb * 0.488603 * normal.y;
+    result += shCoefficients[2].rgb * 0.488603 * normal.z;
+    result += shCoefficients[3].rgb * 0.488603 * normal.x;
+    result += shCoefficients[4].rgb * 1.092548 * normal.x * normal.y;
+    result += shCoefficients[5].rgb * 1.092548 * normal.y * normal.z;
+    result += shCoefficients[6].rgb * 0.315392 * (3.0 * normal.z * normal.z - 1.0);
+    result += shCoefficients[7].rgb * 1.092548 * normal.x * normal.z;
+    result += shCoefficients[8].rgb * 0.546274 * (normal.x * normal.x - normal.y * normal.y);
+    return max(result, float3(0, 0, 0));
+}
+
 float3 prefilteredReflection(float3 R, float roughness)
 {
     const float MAX_REFLECTION_LOD = 9.0; 
@@ -162,6 +214,8 @@ float4 main(PixelShaderInput psInput) : SV_Target
 {
     float3 normal = normalize(psInput.normal);
     float3 worldViewVector = normalize(cameraPosition - psInput.worldPos);
+    float metallic = psInput.material.x;
+    float roughness = psInput.material.y;
 
     
 
@@ -171,15 +225,16 @@ float4 main(PixelShaderInput psInput) : SV_Target
 
 
     float3 Lo = float3(0, 0, 0);
-    for (uint i = 0; i < 3; i++)
+    uint2 cluster = lightClusters[findCluster(psInput.worldPos.xyz)];
+    for (uint i = 0; i < cluster.y; i++)
     {
-        Lo += processPointLight(lightsInfos[i], normal, psInput.worldPos, worldViewVector, startFresnelSchlick,
-                                roughness, metallic, psInput.color);
+        Lo += processPointLight(lights[lightIndices[cluster.x + i]], normal, psInput.worldPos, worldViewVector,
+                                startFresnelSchlick, roughness, metallic, psInput.color);
     }
     float3 R = reflect(-worldViewVector, normal); 
     float2 brdf = brdfTexture.Sample(prefilteredSampler, float2(max(dot(normal, worldViewVector), 0.0f), roughness)).rg;
     float3 reflection = prefilteredReflection(R, roughness).rgb;	
-    float3 irradiance = irradianceTexture.Sample(prefilteredSampler, normal).rgb;
+    float3 irradiance = irradianceMode ? irradianceTexture.Sample(prefilteredSampler, normal).rgb : irradianceSH(normal);
 
     float3 diffuse = irradiance * psInput.color;	
 
@@ -3,8 +3,13 @@ struct VS_INPUT
 {
     float3 position: POSITION;
     float2 uv: UV;
-    float3 normal: NORMAL;
-    float3 color: COLOR;
+    float2 normal: NORMAL;
+    float4 worldRow0: INSTANCE_WORLD0;
+    float4 worldRow1: INSTANCE_WORLD1;
+    float4 worldRow2: INSTANCE_WORLD2;
+    float4 worldRow3: INSTANCE_WORLD3;
+    float4 albedo: INSTANCE_ALBEDO;
+    float2 material: INSTANCE_MATERIAL;
 };
 
 struct VS_OUTPUT
@@ -14,22 +19,35 @@ struct VS_OUTPUT
     float3 normal: NORMAL;
     float2 uv: UV;
     float3 color: COLOR;
+    float2 material: MATERIAL;
 };
 
 cbuffer TransformData: register(b0)
 {
-    float4x4 worldMatrix;
     float4x4 cameraMatrix;
+    float4 positionDequant;
 };
 
+// Octahedral normals, see MeshEncoder::decodeOctahedral.
+float3 decodeOctahedral(float2 encoded)
+{
+    float3 n = float3(encoded, 1.0f - abs(encoded.x) - abs(encoded.y));
+    float t = max(-n.z, 0.0f);
+    n.xy += n.xy >= 0.0f ? -t : t;
+    return normalize(n);
+}
 
 VS_OUTPUT main(VS_INPUT vsInput)
 {
     VS_OUTPUT output = (VS_OUTPUT)0;
-    output.position = mul(cameraMatrix, mul(worldMatrix, float4(vsInput.position, 1.0f)));
-    output.worldPos = mul(worldMatrix, float4(vsInput.position, 1.0f));
+    // Instance rows are the rows of the CPU-side row-vector matrix.
+    float4x4 worldMatrix = float4x4(vsInput.worldRow0, vsInput.worldRow1, vsInput.worldRow2, vsInput.worldRow3);
+    float3 position = vsInput.position * positionDequant.w + positionDequant.xyz;
+    output.worldPos = mul(float4(position, 1.0f), worldMatrix);
+    output.position = mul(cameraMatrix, output.worldPos);
     output.uv = vsInput.uv;
-    output.normal = mul(float4(vsInput.normal, 0), worldMatrix).xyz;
-    output.color = vsInput.color;
+    output.normal = mul(float4(decodeOctahedral(vsInput.normal), 0), worldMatrix).xyz;
+    output.color = vsInput.albedo.rgb;
+    output.material = vsInput.material;
     return output;
 }
\ No newline at end of file
@@ -1,9 +1,6 @@
 struct VS_INPUT
 {
     float3 position: POSITION;
-    float2 uv: UV;
-    float3 normal: NORMAL;
-    float3 color: COLOR;
 };
 
 struct VS_OUTPUT
@@ -18,6 +15,7 @@ cbuffer TransformData: register(b0)
     float4x4 worldMatrix;
     float4x4 cameraMatrix;
     float4 size;
+    float4 positionDequant;
     float3 cameraPosition;
 };
 
@@ -25,10 +23,11 @@ cbuffer TransformData: register(b0)
 VS_OUTPUT main(VS_INPUT vsInput)
 {
     VS_OUTPUT output = (VS_OUTPUT)0;
-    float3 pos = cameraPosition.xyz + vsInput.position * size.x;
+    float3 position = vsInput.position * positionDequant.w + positionDequant.xyz;
+    float3 pos = cameraPosition.xyz + position * size.x;
     output.position = mul(cameraMatrix, mul(worldMatrix, float4(pos, 1.0f)));
     output.position.z =  0.0f;
-    output.uv = vsInput.position;
-    output.normal = vsInput.normal;
+    output.uv = position;
+    output.normal = position;
     return output;
 }
\ No newline at end of file
@@ -0,0 +1,66 @@
+// Shared by luminanceReduceCS.hlsl and luminanceFinalizeCS.hlsl. Engine/ToneMap/LuminanceReduction.cpp mirrors this
+// math on the CPU; keep the constants in sync.
+#define GROUP_SIZE 16
+#define THREAD_COUNT (GROUP_SIZE * GROUP_SIZE)
+#define HISTOGRAM_BINS 64
+#define FLOAT_MAX 3.402823466e+38f
+
+#define LUMINANCE_EXPOSURE_AVERAGE 0
+#define LUMINANCE_EXPOSURE_HISTOGRAM 1
+
+cbuffer LuminanceData : register(b0)
+{
+    uint2 size;
+    uint groupCountX;
+    uint groupCount;
+    float minLog2;
+    float log2Range;
+    float lowPercentile;
+    float highPercentile;
+    uint exposureMode;
+};
+
+// x: sum of log(L + 1), y: minimum, z: maximum.
+groupshared float3 sharedStats[THREAD_COUNT];
+
+float calcBrightness(float3 color)
+{
+    return (color[0] * 0.2126f) + (color[1] * 0.7151f) + (color[2] * 0.0722f);
+}
+
+float3 emptyStats()
+{
+    return float3(0.0f, FLOAT_MAX, 0.0f);
+}
+
+float3 combineStats(float3 a, float3 b)
+{
+    return float3(a.x + b.x, min(a.y, b.y), max(a.z, b.z));
+}
+
+uint histogramBin(float brightness)
+{
+    if (!(brightness > 0.0f))
+    {
+        return 0;
+    }
+    float position = saturate((log2(brightness) - minLog2) / log2Range);
+    return min((uint)(position * HISTOGRAM_BINS), HISTOGRAM_BINS - 1);
+}
+
+float3 reduceGroup(uint index, float3 stats)
+{
+    sharedStats[index] = stats;
+    GroupMemoryBarrierWithGroupSync();
+
+    [unroll]
+    for (uint stride = THREAD_COUNT / 2; stride > 0; stride >>= 1)
+    {
+        if (index < stride)
+        {
+            sharedStats[index] = combineStats(sharedStats[index], sharedStats[index + stride]);
+        }
+        GroupMemoryBarrierWithGroupSync();
+    }
+    return sharedStats[0];
+}
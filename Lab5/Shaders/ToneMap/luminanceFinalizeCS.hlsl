@@ -0,0 +1,51 @@
+#include "LuminanceReduction.hlsli"
+
+StructuredBuffer<float3> partials : register(t0);
+StructuredBuffer<uint> histogram : register(t1);
+RWTexture2D<float> avgTexture : register(u0);
+RWTexture2D<float> minTexture : register(u1);
+RWTexture2D<float> maxTexture : register(u2);
+
+// Mean log2 luminance of the pixels between the two percentiles, counting partial bins at the edges.
+float histogramAverage()
+{
+    float pixelCount = (float)(size.x * size.y);
+    float low = pixelCount * lowPercentile;
+    float high = pixelCount * highPercentile;
+    float passed = 0.0f;
+    float log2Sum = 0.0f;
+    float weight = 0.0f;
+    for (uint bin = 0; bin < HISTOGRAM_BINS; bin++)
+    {
+        float count = (float)histogram[bin];
+        float inside = max(min(passed + count, high) - max(passed, low), 0.0f);
+        log2Sum += inside * (minLog2 + (bin + 0.5f) * log2Range / HISTOGRAM_BINS);
+        weight += inside;
+        passed += count;
+    }
+    float log2Average = weight > 0.0f ? log2Sum / weight : minLog2;
+    return log(exp2(log2Average) + 1.0f);
+}
+
+[numthreads(THREAD_COUNT, 1, 1)]
+void main(uint index : SV_GroupIndex)
+{
+    float3 stats = emptyStats();
+    for (uint i = index; i < groupCount; i += THREAD_COUNT)
+    {
+        stats = combineStats(stats, partials[i]);
+    }
+
+    float3 total = reduceGroup(index, stats);
+    if (index == 0)
+    {
+        float average = total.x / (float)(size.x * size.y);
+        if (exposureMode == LUMINANCE_EXPOSURE_HISTOGRAM)
+        {
+            average = histogramAverage();
+        }
+        avgTexture[uint2(0, 0)] = average;
+        minTexture[uint2(0, 0)] = total.y;
+        maxTexture[uint2(0, 0)] = total.z;
+    }
+}
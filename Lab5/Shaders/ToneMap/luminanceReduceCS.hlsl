@@ -0,0 +1,35 @@
+#include "LuminanceReduction.hlsli"
+
+Texture2D<float4> hdrTexture : register(t0);
+RWStructuredBuffer<float3> partials : register(u0);
+RWStructuredBuffer<uint> histogram : register(u1);
+
+groupshared uint sharedHistogram[HISTOGRAM_BINS];
+
+[numthreads(GROUP_SIZE, GROUP_SIZE, 1)]
+void main(uint3 groupId : SV_GroupID, uint3 dispatchId : SV_DispatchThreadID, uint index : SV_GroupIndex)
+{
+    if (index < HISTOGRAM_BINS)
+    {
+        sharedHistogram[index] = 0;
+    }
+    GroupMemoryBarrierWithGroupSync();
+
+    float3 stats = emptyStats();
+    if (all(dispatchId.xy < size))
+    {
+        float brightness = calcBrightness(hdrTexture[dispatchId.xy].rgb);
+        stats = float3(log(brightness + 1.0f), brightness, brightness);
+        InterlockedAdd(sharedHistogram[histogramBin(brightness)], 1);
+    }
+
+    float3 groupStats = reduceGroup(index, stats);
+    if (index == 0)
+    {
+        partials[groupId.y * groupCountX + groupId.x] = groupStats;
+    }
+    if (index < HISTOGRAM_BINS && sharedHistogram[index] != 0)
+    {
+        InterlockedAdd(histogram[index], sharedHistogram[index]);
+    }
+}
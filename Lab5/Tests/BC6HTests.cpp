@@ -0,0 +1,156 @@
+#include "TestSuites.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "TestUtils.h"
+#include "../Engine/IBL/IBLCache.h"
+#include "../Engine/RenderDevice/SoftwareTexture.h"
+#include "../Utils/BC6H.h"
+#include "../Utils/HalfFloat.h"
+#include "../Utils/ThreadPool.h"
+
+using TestUtils::check;
+
+namespace
+{
+    // Mean of |decoded - source| / source over the RGB channels of an RGBA32F image.
+    float measureRelativeError(const std::vector<float>& decoded, const std::vector<float>& source)
+    {
+        double errorSum = 0.0;
+        size_t count = 0;
+        for (size_t i = 0; i < source.size(); i++)
+        {
+            if (i % 4 != 3)
+            {
+                errorSum += fabs(decoded[i] - source[i]) / std::max(source[i], 1e-4f);
+                count++;
+            }
+        }
+        return (float)(errorSum / count);
+    }
+}
+
+int testBC6H()
+{
+    bool passed = true;
+
+    float constant[16 * 4];
+    for (uint32_t i = 0; i < 16; i++)
+    {
+        const float texel[4] = {0.1f, 3.0f, 1000.0f, 1.0f};
+        memcpy(constant + i * 4, texel, sizeof(texel));
+    }
+    uint8_t block[BC6H::BLOCK_BYTES];
+    float decodedBlock[16 * 4];
+    BC6H::encodeBlock(constant, BC6H_QUALITY_HIGH, block);
+    BC6H::decodeBlock(block, decodedBlock);
+    bool exact = true;
+    for (uint32_t i = 0; i < 16 * 4; i++)
+    {
+        exact &= decodedBlock[i] == (i % 4 == 3 ? 1.0f : HalfFloat::toFloat(HalfFloat::fromFloat(constant[i])));
+    }
+    passed &= check(exact, "a flat block keeps full half precision in high quality");
+
+    const float outOfRange[4] = {-1.0f, NAN, 1.0e9f, 1.0f};
+    for (uint32_t i = 0; i < 16; i++)
+    {
+        memcpy(constant + i * 4, outOfRange, sizeof(outOfRange));
+    }
+    BC6H::encodeBlock(constant, BC6H_QUALITY_FAST, block);
+    BC6H::decodeBlock(block, decodedBlock);
+    passed &= check(decodedBlock[0] == 0.0f && decodedBlock[1] == 0.0f && decodedBlock[2] == 65504.0f &&
+                    decodedBlock[3] == 1.0f, "negative and NaN channels encode as zero and large ones clamp");
+
+    memset(block, 0, sizeof(block));
+    block[0] = 0x13;
+    BC6H::decodeBlock(block, decodedBlock);
+    passed &= check(decodedBlock[0] == 0.0f && decodedBlock[3] == 1.0f, "reserved modes decode to black");
+
+    // A smooth HDR gradient with a slowly changing tint and a hot spot three orders of magnitude brighter, at a
+    // size that leaves partial blocks on two edges.
+    const uint32_t width = 38;
+    const uint32_t height = 21;
+    std::vector<float> image((size_t)width * height * 4);
+    for (uint32_t y = 0; y < height; y++)
+    {
+        for (uint32_t x = 0; x < width; x++)
+        {
+            float* texel = &image[((size_t)y * width + x) * 4];
+            float distance = hypotf((float)x - 20.0f, (float)y - 8.0f);
+            float intensity = 0.05f + 0.02f * x + 0.01f * y + 200.0f * expf(-distance * distance / 6.0f);
+            texel[0] = intensity;
+            texel[1] = intensity * (0.8f + 0.1f * sinf(0.2f * x));
+            texel[2] = intensity * 0.6f;
+            texel[3] = 1.0f;
+        }
+    }
+    std::vector<uint8_t> blocks(BC6H::getImageBytes(width, height));
+    passed &= check(blocks.size() == 10 * 6 * BC6H::BLOCK_BYTES, "partial blocks are stored whole");
+    ThreadPool threadPool(2);
+    float errors[2];
+    for (BC6HQuality quality : {BC6H_QUALITY_FAST, BC6H_QUALITY_HIGH})
+    {
+        BC6H::encodeImage(image.data(), width, height, quality, &threadPool, blocks.data());
+        std::vector<uint8_t> serial(blocks.size());
+        BC6H::encodeImage(image.data(), width, height, quality, nullptr, serial.data());
+        passed &= check(serial == blocks, "encoding on the thread pool writes the same blocks");
+        std::vector<float> decoded(image.size());
+        BC6H::decodeImage(blocks.data(), width, height, decoded.data());
+        errors[quality] = measureRelativeError(decoded, image);
+    }
+    std::cout << "Mean relative error: fast " << errors[BC6H_QUALITY_FAST] << ", high "
+        << errors[BC6H_QUALITY_HIGH] << std::endl;
+    passed &= check(errors[BC6H_QUALITY_FAST] < 0.025f && errors[BC6H_QUALITY_HIGH] <= errors[BC6H_QUALITY_FAST],
+                    "both qualities stay within 2.5% and high quality is no worse than fast");
+
+    RenderTextureDesc desc;
+    desc.width = width;
+    desc.height = height;
+    desc.format = RENDER_FORMAT_BC6H_UF16;
+    SoftwareTexture texture(desc);
+    texture.upload(0, 0, blocks.data());
+    std::vector<float> decoded(image.size());
+    BC6H::decodeImage(blocks.data(), width, height, decoded.data());
+    passed &= check(!memcmp(texture.getTexels(0, 0), decoded.data(), decoded.size() * sizeof(float)),
+                    "the software backend samples the decoded blocks");
+
+    desc.width = desc.height = 128;
+    desc.mipLevels = 5;
+    desc.arraySize = 6;
+    passed &= check(RenderDevice::getRowPitch(RENDER_FORMAT_BC6H_UF16, 6) == 2 * BC6H::BLOCK_BYTES &&
+                    RenderDevice::getTextureBytes(desc) == 6 * (1024 + 256 + 64 + 16 + 4) * BC6H::BLOCK_BYTES,
+                    "BC6H textures are sized by blocks");
+
+    CpuCubemap cubemap;
+    cubemap.allocate(16, 3);
+    for (size_t i = 0; i < cubemap.texels.size(); i++)
+    {
+        cubemap.texels[i] = i % 4 == 3 ? 1.0f : 0.25f + (float)(i % 37) / 8.0f;
+    }
+    IBLBakeData bake;
+    bake.cubemap = cubemap;
+    bake.irradiance = cubemap;
+    bake.prefiltered = cubemap;
+    bake.irradianceSH.coefficients[0][0] = 0.5f;
+    IBLCacheData packed;
+    IBLCache::pack(bake, RENDER_FORMAT_BC6H_UF16, BC6H_QUALITY_FAST, &threadPool, &packed);
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / "bc6h-test";
+    std::filesystem::create_directories(directory);
+    std::string cachePath = (directory / "environment.ibl").string();
+    IBLCacheData read;
+    passed &= check(IBLCache::write(cachePath, 7, packed) && IBLCache::read(cachePath, 7, &read) &&
+                    read.cubemap.format == RENDER_FORMAT_BC6H_UF16 && read.cubemap.mipLevels == 1 &&
+                    read.prefiltered.mipLevels == 3 && read.prefiltered.data == packed.prefiltered.data &&
+                    read.irradianceSH.coefficients[0][0] == 0.5f, "a BC6H IBL cache reads back");
+    passed &= check(!IBLCache::read(cachePath, 8, &read), "a stale BC6H IBL cache is rejected");
+    std::filesystem::remove_all(directory);
+
+    std::cout << (passed ? "All BC6H checks passed" : "BC6H checks failed") << std::endl;
+    return passed ? 0 : 1;
+}
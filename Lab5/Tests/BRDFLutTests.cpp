@@ -0,0 +1,139 @@
+#include "TestSuites.h"
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <iostream>
+#include <vector>
+
+#include "TestUtils.h"
+#include "../Engine/IBL/BRDFLut.h"
+#include "../Engine/IBL/CubemapBaker.h"
+#include "../Utils/HalfFloat.h"
+#include "../Utils/ThreadPool.h"
+
+using TestUtils::check;
+
+namespace
+{
+    const uint32_t LUT_SIZE = 32;
+    const float STORED_MAX_ERROR = 0.001f;
+    const float SAMPLED_MAX_ERROR = 0.01f;
+    // Karis' fit is made for mobile and is a few hundredths off on average, most of it near grazing.
+    const float ANALYTIC_MAX_MEAN_ERROR = 0.05f;
+    const uint32_t QUADRATURE_THETA_STEPS = 2048;
+    const uint32_t QUADRATURE_PHI_STEPS = 512;
+
+    // The split-sum integral over a plain (theta, phi) grid of light directions instead of GGX samples:
+    // (1 - Fc, Fc) * D * G / (4 * NdotV), the NdotL of the rendering equation cancelling the one in the BRDF.
+    void integrateQuadrature(float dotNV, float roughness, float* pScale, float* pBias)
+    {
+        const IBLMath::Vec3 view(sqrtf(1.0f - dotNV * dotNV), 0.0f, dotNV);
+        double scale = 0.0;
+        double bias = 0.0;
+        float thetaStep = 0.5f * IBLMath::PI / QUADRATURE_THETA_STEPS;
+        float phiStep = 2.0f * IBLMath::PI / QUADRATURE_PHI_STEPS;
+        for (uint32_t i = 0; i < QUADRATURE_THETA_STEPS; i++)
+        {
+            float theta = (i + 0.5f) * thetaStep;
+            double rowWeight = sinf(theta) * thetaStep * phiStep;
+            for (uint32_t j = 0; j < QUADRATURE_PHI_STEPS; j++)
+            {
+                float phi = (j + 0.5f) * phiStep;
+                IBLMath::Vec3 light(sinf(theta) * cosf(phi), sinf(theta) * sinf(phi), cosf(theta));
+                IBLMath::Vec3 half = IBLMath::normalize(light + view);
+                float fc = powf(1.0f - std::max(IBLMath::dot(view, half), 0.0f), 5.0f);
+                double value = IBLMath::distributeGGX(half.z, roughness) *
+                    IBLMath::geometrySchlickSmithGGX(light.z, dotNV, roughness) / (4.0f * dotNV) * rowWeight;
+                scale += (1.0f - fc) * value;
+                bias += fc * value;
+            }
+        }
+        *pScale = (float)scale;
+        *pBias = (float)bias;
+    }
+
+    const float* getTexel(const std::vector<float>& lut, uint32_t x, uint32_t y)
+    {
+        return &lut[((size_t)y * LUT_SIZE + x) * 4];
+    }
+
+    float measureMeanError(const std::vector<uint16_t>& texels, const std::vector<float>& reference, float* pMaxError)
+    {
+        double errorSum = 0.0;
+        float maxError = 0.0f;
+        for (size_t i = 0; i < texels.size(); i++)
+        {
+            float error = fabsf(HalfFloat::toFloat(texels[i]) - reference[i / 2 * 4 + i % 2]);
+            errorSum += error;
+            maxError = std::max(maxError, error);
+        }
+        *pMaxError = maxError;
+        return texels.empty() ? 0.0f : (float)(errorSum / texels.size());
+    }
+}
+
+// Checks the sampled split-sum table against values known without sampling, and the RG16F file it is stored in.
+int testBRDFLut()
+{
+    bool passed = true;
+    ThreadPool threadPool(0);
+    CubemapBaker baker(&threadPool);
+    std::vector<float> lut;
+    baker.renderBRDF(LUT_SIZE, &lut);
+
+    // A mirror sends all light back along the reflection with G = 1, leaving only Schlick's Fresnel:
+    // scale 1 - (1 - NdotV)^5 and bias (1 - NdotV)^5, so (1, 0) head on.
+    const float* headOn = getTexel(lut, LUT_SIZE - 1, 0);
+    passed &= check(fabsf(headOn[0] - 1.0f) <= SAMPLED_MAX_ERROR && fabsf(headOn[1]) <= SAMPLED_MAX_ERROR,
+                    "a smooth surface seen head on gives (1, 0)");
+    // The first column is so close to grazing that the little roughness of the first row already shadows it.
+    bool mirror = true;
+    for (uint32_t x = 1; x < LUT_SIZE; x++)
+    {
+        float fresnel = powf(1.0f - (x + 0.5f) / LUT_SIZE, 5.0f);
+        const float* texel = getTexel(lut, x, 0);
+        mirror &= fabsf(texel[0] - (1.0f - fresnel)) <= SAMPLED_MAX_ERROR &&
+            fabsf(texel[1] - fresnel) <= SAMPLED_MAX_ERROR;
+    }
+    passed &= check(mirror, "a smooth surface follows Schlick's Fresnel away from grazing");
+
+    // Mid-range texels against the same integral taken on a fine grid of directions.
+    const uint32_t samples[][2] = {{16, 16}, {8, 24}, {24, 8}, {28, 28}, {4, 12}};
+    bool matchesQuadrature = true;
+    for (const uint32_t* sample : samples)
+    {
+        float dotNV = (sample[0] + 0.5f) / LUT_SIZE;
+        float roughness = (sample[1] + 0.5f) / LUT_SIZE;
+        float scale, bias;
+        integrateQuadrature(dotNV, roughness, &scale, &bias);
+        const float* texel = getTexel(lut, sample[0], sample[1]);
+        std::cout << "     NdotV " << dotNV << ", roughness " << roughness << ": (" << texel[0] << ", " << texel[1]
+            << ") vs (" << scale << ", " << bias << ")" << std::endl;
+        matchesQuadrature &= fabsf(texel[0] - scale) <= SAMPLED_MAX_ERROR &&
+            fabsf(texel[1] - bias) <= SAMPLED_MAX_ERROR;
+    }
+    passed &= check(matchesQuadrature, "rough texels match a quadrature of the same integral");
+
+    std::vector<uint16_t> packed;
+    BRDFLut::pack(lut, &packed);
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "brdf-lut-test.lut";
+    uint32_t size = 0;
+    std::vector<uint16_t> stored;
+    bool roundTrips = BRDFLut::write(path.string(), LUT_SIZE, packed) &&
+        BRDFLut::read(path.string(), &size, &stored) && size == LUT_SIZE && stored == packed;
+    std::filesystem::remove(path);
+    passed &= check(roundTrips, "the table reads back from its file unchanged");
+    float storedMaxError;
+    measureMeanError(stored, lut, &storedMaxError);
+    passed &= check(storedMaxError <= STORED_MAX_ERROR, "RG16F keeps the table within 0.001");
+
+    std::vector<uint16_t> analytic;
+    BRDFLut::generateAnalytic(LUT_SIZE, &analytic);
+    float analyticMaxError;
+    float analyticMeanError = measureMeanError(analytic, lut, &analyticMaxError);
+    std::cout << "     analytic fit: mean error " << analyticMeanError << ", max " << analyticMaxError << std::endl;
+    passed &= check(analyticMeanError <= ANALYTIC_MAX_MEAN_ERROR, "the analytic fallback stays close to the table");
+
+    return passed ? 0 : 1;
+}
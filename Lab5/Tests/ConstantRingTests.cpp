@@ -0,0 +1,84 @@
+#include "TestSuites.h"
+
+#include <iostream>
+#include <stdexcept>
+
+#include "TestUtils.h"
+#include "../Utils/RingAllocator.h"
+
+using TestUtils::check;
+
+// Replays frames of constant uploads against RingAllocator, the sub-allocator behind ConstantRing.
+int testConstantRing()
+{
+    const uint32_t alignment = 256;
+    bool passed = true;
+    {
+        RingAllocator ring(4096, alignment);
+        RingAllocation first;
+        RingAllocation second;
+        passed &= check(ring.allocate(64, &first) && ring.allocate(300, &second), "allocations fit");
+        passed &= check(first.offset == 0 && first.size == 256 && second.offset == 256 && second.size == 512,
+                        "allocations are 256-byte aligned and padded");
+        passed &= check(first.discard && !second.discard, "only the first map of a buffer discards");
+    }
+    {
+        // Frames of varying size: a wrap may only happen at a frame boundary and must discard.
+        RingAllocator ring(4096, alignment);
+        const uint32_t sizes[] = {208, 64, 144, 576, 80};
+        bool neverFull = true;
+        bool noOverlap = true;
+        bool wrapsDiscard = true;
+        uint64_t wraps = 0;
+        for (uint32_t frame = 0; frame < 200; frame++)
+        {
+            uint64_t generation = ring.getGeneration();
+            ring.beginFrame();
+            bool wrapped = ring.getGeneration() != generation;
+            wraps += wrapped;
+            uint32_t end = ring.getOffset();
+            uint32_t count = 2 + frame % 4;
+            for (uint32_t i = 0; i < count; i++)
+            {
+                RingAllocation allocation;
+                if (!ring.allocate(sizes[(frame + i) % 5], &allocation))
+                {
+                    neverFull = false;
+                    break;
+                }
+                noOverlap &= allocation.offset == end && allocation.offset % alignment == 0;
+                wrapsDiscard &= allocation.discard == ((wrapped || frame == 0) && i == 0);
+                end = allocation.offset + allocation.size;
+            }
+        }
+        passed &= check(neverFull, "frames never run out of space once the peak frame is known");
+        passed &= check(noOverlap, "allocations within a frame are contiguous and aligned");
+        passed &= check(wraps > 0 && wrapsDiscard, "the ring wraps between frames with a discard");
+    }
+    {
+        RingAllocator ring(1024, alignment);
+        RingAllocation allocation;
+        ring.allocate(768, &allocation);
+        passed &= check(!ring.allocate(512, &allocation), "an overflowing request is refused");
+        uint64_t generation = ring.getGeneration();
+        ring.reset(2048);
+        passed &= check(ring.getGeneration() == generation + 1 && ring.getCapacity() == 2048,
+                        "reset starts a new generation");
+        passed &= check(ring.allocate(512, &allocation) && allocation.offset == 0 && allocation.discard,
+                        "the replacement buffer starts with a discard");
+    }
+    {
+        bool threw = false;
+        try
+        {
+            RingAllocator ring(1000, 48);
+        }
+        catch (const std::runtime_error&)
+        {
+            threw = true;
+        }
+        passed &= check(threw, "invalid alignment is rejected");
+    }
+    std::cout << (passed ? "All constant ring checks passed" : "Constant ring checks failed") << std::endl;
+    return passed ? 0 : 1;
+}
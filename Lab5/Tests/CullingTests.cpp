@@ -0,0 +1,141 @@
+#include "TestSuites.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "TestUtils.h"
+#include "../Engine/Culling/SceneObjects.h"
+
+using TestUtils::check;
+
+int testCulling()
+{
+    bool passed = true;
+    std::mt19937 random(11);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    auto randomPoint = [&](float extent)
+    {
+        return RenderMath::makeFloat3((unit(random) - 0.5f) * extent, (unit(random) - 0.5f) * extent,
+                                      (unit(random) - 0.5f) * extent);
+    };
+    auto makeBounds = [](const Float3& center, float size, Float3* pMin, Float3* pMax)
+    {
+        *pMin = RenderMath::makeFloat3(center.x - size, center.y - size * 0.5f, center.z - size);
+        *pMax = RenderMath::makeFloat3(center.x + size, center.y + size * 0.5f, center.z + size);
+    };
+
+    SceneObjects objects;
+    bool counted = true;
+    std::vector<Float3> centers(20000);
+    std::vector<float> sizes(centers.size());
+    for (size_t i = 0; i < centers.size(); i++)
+    {
+        // A few clumps on top of a uniform spread, so the hierarchy sees uneven density.
+        centers[i] = i % 4 ? randomPoint(400.0f) : randomPoint(20.0f);
+        sizes[i] = 0.1f + 3.0f * unit(random);
+        Float3 boundsMin;
+        Float3 boundsMax;
+        makeBounds(centers[i], sizes[i], &boundsMin, &boundsMax);
+        counted &= objects.add(boundsMin, boundsMax) == i;
+    }
+    passed &= check(counted, "ids count up from zero");
+    std::vector<uint32_t> visible;
+    bool threw = false;
+    try
+    {
+        objects.cull(RenderMath::identity(), &visible);
+    }
+    catch (const std::runtime_error&)
+    {
+        threw = true;
+    }
+    passed &= check(threw, "culling before update throws");
+    objects.update();
+    std::cout << objects.getObjectCount() << " objects in " << objects.getNodeCount() << " nodes" << std::endl;
+
+    // The hierarchy must find exactly the objects the linear pass finds, and every object whose center is on
+    // screen, from eyes inside and outside the objects.
+    auto checkViews = [&](const char* description)
+    {
+        bool matched = true;
+        bool complete = true;
+        uint32_t visited = 0;
+        uint32_t seen = 0;
+        for (uint32_t view = 0; view < 16; view++)
+        {
+            Float3 eye = randomPoint(view < 8 ? 100.0f : 1200.0f);
+            Float3 direction = randomPoint(2.0f);
+            Float4x4 viewProjection = RenderMath::multiply(
+                RenderMath::lookTo(eye, direction, RenderMath::makeFloat3(0.0f, 1.0f, 0.0f)),
+                RenderMath::perspectiveFov(0.4f + 1.2f * unit(random), 16.0f / 9.0f, 0.1f, 300.0f));
+            CullStats stats;
+            std::vector<uint32_t> linear;
+            objects.cull(viewProjection, &visible, &stats);
+            objects.cullLinear(viewProjection, &linear);
+            std::sort(visible.begin(), visible.end());
+            std::sort(linear.begin(), linear.end());
+            matched &= visible == linear && stats.visibleObjects == visible.size();
+            visited += stats.visitedNodes;
+            seen += (uint32_t)visible.size();
+            const float(*m)[4] = viewProjection.m;
+            for (uint32_t id = 0; id < centers.size(); id++)
+            {
+                const Float3& c = centers[id];
+                float clip[4];
+                for (uint32_t column = 0; column < 4; column++)
+                {
+                    clip[column] = c.x * m[0][column] + c.y * m[1][column] + c.z * m[2][column] + m[3][column];
+                }
+                bool onScreen = fabsf(clip[0]) < clip[3] && fabsf(clip[1]) < clip[3] && clip[2] > 0.0f &&
+                    clip[2] < clip[3];
+                complete &= !onScreen || std::binary_search(visible.begin(), visible.end(), id);
+            }
+        }
+        std::cout << description << ": " << seen / 16 << " visible and " << visited / 16
+            << " nodes visited per view" << std::endl;
+        passed &= check(matched, (std::string(description) + ": the hierarchy matches the linear test").c_str());
+        passed &= check(complete, (std::string(description) + ": objects on screen are visible").c_str());
+    };
+    checkViews("built");
+    passed &= check(objects.getBuildCount() == 1 && objects.getAreaRatio() == 1.0f, "one build");
+
+    for (size_t i = 0; i < centers.size(); i += 10)
+    {
+        Float3 offset = randomPoint(4.0f);
+        centers[i] = RenderMath::makeFloat3(centers[i].x + offset.x, centers[i].y + offset.y,
+                                            centers[i].z + offset.z);
+        Float3 boundsMin;
+        Float3 boundsMax;
+        makeBounds(centers[i], sizes[i], &boundsMin, &boundsMax);
+        objects.setBounds((uint32_t)i, boundsMin, boundsMax);
+    }
+    objects.update();
+    std::cout << "Area after a small move: " << objects.getAreaRatio() << "x" << std::endl;
+    passed &= check(objects.getBuildCount() == 1 && objects.getAreaRatio() > 1.0f, "a small move refits");
+    checkViews("refitted");
+
+    for (size_t i = 0; i < centers.size(); i++)
+    {
+        centers[i] = randomPoint(400.0f);
+        Float3 boundsMin;
+        Float3 boundsMax;
+        makeBounds(centers[i], sizes[i], &boundsMin, &boundsMax);
+        objects.setBounds((uint32_t)i, boundsMin, boundsMax);
+    }
+    objects.update();
+    passed &= check(objects.getBuildCount() == 2 && objects.getAreaRatio() == 1.0f, "scattering rebuilds");
+    checkViews("rebuilt");
+
+    objects.clear();
+    objects.update();
+    objects.cull(RenderMath::identity(), &visible);
+    passed &= check(visible.empty() && objects.getNodeCount() == 0, "an empty scene shows nothing");
+
+    std::cout << (passed ? "All culling checks passed" : "Culling checks failed") << std::endl;
+    return passed ? 0 : 1;
+}
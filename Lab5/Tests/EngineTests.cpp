@@ -0,0 +1,101 @@
+#include "TestSuites.h"
+
+#include <cstring>
+#include <iostream>
+
+namespace
+{
+    struct TestSuite
+    {
+        const char* name;
+        int (*run)();
+    };
+
+    const TestSuite SUITES[] = {
+        {"mesh-builder", testMeshBuilder},
+        {"spherical-harmonics", testSphericalHarmonics},
+        {"brdf-lut", testBRDFLut},
+        {"luminance", testLuminance},
+        {"shader-cache", testShaderCache},
+        {"scheduler", testScheduler},
+        {"constant-ring", testConstantRing},
+        {"state-cache", testStateCache},
+        {"frame-graph", testFrameGraph},
+        {"memory", testMemory},
+        {"profiler", testProfiler},
+        {"render-device", testRenderDevice},
+        {"software-device", testSoftwareDevice},
+        {"hdr-container", testHDRContainer},
+        {"hdr-decoder", testHDRDecoder},
+        {"bc6h", testBC6H},
+        {"light-clusters", testLightClusters},
+        {"culling", testCulling},
+        {"mesh-lod", testMeshLOD},
+        {"mesh-optimizer", testMeshOptimizer},
+        {"vertex-encoding", testVertexEncoding}
+    };
+
+    void printUsage()
+    {
+        std::cout << "Usage: EngineTests [suite...]" << std::endl;
+        std::cout << "       EngineTests --list" << std::endl;
+        std::cout << "Runs the named suites, or all of them without arguments." << std::endl;
+    }
+
+    const TestSuite* findSuite(const char* name)
+    {
+        for (const TestSuite& suite : SUITES)
+        {
+            if (!strcmp(suite.name, name))
+            {
+                return &suite;
+            }
+        }
+        return nullptr;
+    }
+
+    bool runSuite(const TestSuite& suite)
+    {
+        std::cout << "[" << suite.name << "]" << std::endl;
+        return suite.run() == 0;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if (argc == 2 && !strcmp(argv[1], "--list"))
+    {
+        for (const TestSuite& suite : SUITES)
+        {
+            std::cout << suite.name << std::endl;
+        }
+        return 0;
+    }
+    for (int i = 1; i < argc; i++)
+    {
+        if (!findSuite(argv[i]))
+        {
+            std::cerr << "Unknown test suite " << argv[i] << std::endl;
+            printUsage();
+            return 1;
+        }
+    }
+
+    int failed = 0;
+    int count = 0;
+    if (argc == 1)
+    {
+        for (const TestSuite& suite : SUITES)
+        {
+            failed += !runSuite(suite);
+            count++;
+        }
+    }
+    for (int i = 1; i < argc; i++)
+    {
+        failed += !runSuite(*findSuite(argv[i]));
+        count++;
+    }
+    std::cout << count - failed << " of " << count << " suites passed" << std::endl;
+    return failed ? 1 : 0;
+}
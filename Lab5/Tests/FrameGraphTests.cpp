@@ -0,0 +1,162 @@
+#include "TestSuites.h"
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "TestUtils.h"
+#include "../Engine/FrameGraph/FrameGraph.h"
+
+using TestUtils::check;
+
+// Compiles small graphs shaped like the tone mapper's and checks culling, lifetimes and aliasing.
+int testFrameGraph()
+{
+    FrameGraphTextureDesc screen{1280, 720, 2, 0x28};
+    FrameGraphTextureDesc pixel{1, 1, 41, 0x88};
+    FrameGraphTextureDesc half{640, 360, 2, 0x28};
+    bool passed = true;
+
+    {
+        std::string executed;
+        FrameGraph graph;
+        FrameGraphResource hdr = graph.importTexture("HDR", screen);
+        FrameGraphResource backBuffer = graph.importTexture("Back buffer", screen);
+        FrameGraphResource reduced = graph.createTexture("Reduced", pixel);
+        FrameGraphResource pyramid = graph.createTexture("Pyramid", half);
+        FrameGraphResource pyramidTop = graph.createTexture("Pyramid top", pixel);
+        FrameGraphResource unused = graph.createTexture("Unused", half);
+
+        FrameGraphPass scene = graph.addPass("Scene", [&]() { executed += "scene "; });
+        graph.write(scene, hdr);
+        FrameGraphPass reduce = graph.addPass("Reduce", [&]() { executed += "reduce "; });
+        graph.read(reduce, hdr);
+        graph.write(reduce, reduced);
+        FrameGraphPass downsample = graph.addPass("Downsample", [&]() { executed += "downsample "; });
+        graph.read(downsample, hdr);
+        graph.write(downsample, pyramid);
+        FrameGraphPass pyramidLevel = graph.addPass("Pyramid level", [&]() { executed += "level "; });
+        graph.read(pyramidLevel, pyramid);
+        graph.write(pyramidLevel, pyramidTop);
+        graph.write(pyramidLevel, unused);
+        FrameGraphPass toneMap = graph.addPass("Tone map", [&]() { executed += "tonemap "; });
+        graph.read(toneMap, hdr);
+        graph.read(toneMap, reduced);
+        graph.write(toneMap, backBuffer);
+        FrameGraphPass capture = graph.addPass("Capture", [&]() { executed += "capture "; }, true);
+        graph.read(capture, hdr);
+        FrameGraphPass orphan = graph.addPass("Orphan", [&]() { executed += "orphan "; });
+        graph.read(orphan, reduced);
+        graph.compile();
+        graph.execute();
+
+        passed &= check(!graph.isCulled(scene) && !graph.isCulled(toneMap),
+                        "passes writing imported textures are kept");
+        passed &= check(!graph.isCulled(capture), "passes with side effects are kept");
+        passed &= check(graph.isCulled(downsample) && graph.isCulled(pyramidLevel),
+                        "a chain nobody reads is culled back to its first pass");
+        passed &= check(graph.isCulled(orphan), "a pass that writes nothing is culled");
+        passed &= check(executed == "scene reduce tonemap capture ", "surviving passes run in declaration order");
+        passed &= check(graph.getPhysicalTexture(pyramid) == FrameGraph::NO_PHYSICAL_TEXTURE &&
+                        graph.getPhysicalTexture(unused) == FrameGraph::NO_PHYSICAL_TEXTURE &&
+                        graph.getPhysicalTextures().size() == 1, "culled textures are never allocated");
+        FrameGraphStats stats = graph.getStats();
+        passed &= check(stats.passCount == 7 && stats.culledPassCount == 3 && stats.transientTextureCount == 1 &&
+                        stats.physicalTextureCount == 1, "stats count passes and textures");
+    }
+
+    {
+        // A chain of equal-sized ping-pong targets: each lives from its writer to its single reader.
+        FrameGraph graph;
+        FrameGraphResource output = graph.importTexture("Output", screen);
+        std::vector<FrameGraphResource> chain;
+        FrameGraphPass previous = 0;
+        for (uint32_t i = 0; i < 4; i++)
+        {
+            chain.push_back(graph.createTexture("Blur " + std::to_string(i), half));
+            FrameGraphPass pass = graph.addPass("Blur " + std::to_string(i), nullptr);
+            if (i > 0)
+            {
+                graph.read(pass, chain[i - 1]);
+            }
+            graph.write(pass, chain[i]);
+            previous = pass;
+        }
+        FrameGraphResource other = graph.createTexture("Other size", pixel);
+        FrameGraphPass reduce = graph.addPass("Reduce", nullptr);
+        graph.read(reduce, chain.back());
+        graph.write(reduce, other);
+        FrameGraphPass composite = graph.addPass("Composite", nullptr);
+        graph.read(composite, other);
+        graph.write(composite, output);
+        graph.compile();
+
+        passed &= check(graph.getPhysicalTexture(chain[0]) == graph.getPhysicalTexture(chain[2]) &&
+                        graph.getPhysicalTexture(chain[1]) == graph.getPhysicalTexture(chain[3]),
+                        "equal textures with disjoint lifetimes share memory");
+        passed &= check(graph.getPhysicalTexture(chain[0]) != graph.getPhysicalTexture(chain[1]),
+                        "a texture is not reused while it is still read");
+        passed &= check(graph.getPhysicalTexture(other) != graph.getPhysicalTexture(chain[0]) &&
+                        graph.getPhysicalTexture(other) != graph.getPhysicalTexture(chain[1]),
+                        "textures with different descriptions never alias");
+        passed &= check(graph.getPhysicalTextures().size() == 3 && !graph.isCulled(previous),
+                        "five transients fit in three physical textures");
+    }
+
+    {
+        // Culling the pass that writes nothing releases First once, so Producer keeps the reference Second holds.
+        FrameGraph graph;
+        FrameGraphResource output = graph.importTexture("Output", screen);
+        FrameGraphResource first = graph.createTexture("First", half);
+        FrameGraphResource second = graph.createTexture("Second", half);
+        FrameGraphPass producer = graph.addPass("Producer", nullptr);
+        graph.write(producer, first);
+        graph.write(producer, second);
+        FrameGraphPass reader = graph.addPass("Reader", nullptr);
+        graph.read(reader, first);
+        FrameGraphPass consumer = graph.addPass("Consumer", nullptr);
+        graph.read(consumer, second);
+        graph.write(consumer, output);
+        graph.compile();
+
+        passed &= check(graph.isCulled(reader) && !graph.isCulled(consumer),
+                        "only the pass that writes nothing is culled");
+        passed &= check(!graph.isCulled(producer), "a writer stays while any of its textures is still read");
+    }
+
+    {
+        FrameGraph graph;
+        FrameGraphResource output = graph.importTexture("Output", screen);
+        FrameGraphResource texture = graph.createTexture("Texture", half);
+        FrameGraphPass consumer = graph.addPass("Consumer", nullptr);
+        graph.read(consumer, texture);
+        graph.write(consumer, output);
+        FrameGraphPass producer = graph.addPass("Producer", nullptr);
+        graph.write(producer, texture);
+        bool threw = false;
+        try
+        {
+            graph.compile();
+        }
+        catch (const std::runtime_error&)
+        {
+            threw = true;
+        }
+        passed &= check(threw, "reading a transient before it is written is rejected");
+
+        threw = false;
+        try
+        {
+            graph.read(consumer, 42);
+        }
+        catch (const std::runtime_error&)
+        {
+            threw = true;
+        }
+        passed &= check(threw, "unknown resources are rejected");
+    }
+
+    std::cout << (passed ? "All frame graph checks passed" : "Frame graph checks failed") << std::endl;
+    return passed ? 0 : 1;
+}
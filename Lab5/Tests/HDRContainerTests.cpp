@@ -0,0 +1,123 @@
+#include "TestSuites.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "TestUtils.h"
+#include "../Engine/CubemapGenerator.h"
+#include "../Engine/IBL/HDRContainer.h"
+#include "../Engine/RenderDevice/RecordingRenderDevice.h"
+#include "../Engine/RenderDevice/RenderMath.h"
+#include "../Engine/RenderDevice/SoftwareTexture.h"
+#include "../Utils/SharedExponent.h"
+
+using TestUtils::check;
+
+// Round trips RGB9E5, writes and maps both container formats and loads an environment from a container alone,
+// with no HDR next to it to decode.
+int testHDRContainer()
+{
+    bool passed = true;
+
+    bool roundTrips = true;
+    for (float value : {1.0f, 0.001f, 3.14159f, 1000.0f, 60000.0f})
+    {
+        float rgb[3];
+        SharedExponent::toFloat3(SharedExponent::fromFloat3(value, value * 0.5f, 0.0f), rgb);
+        roundTrips &= fabsf(rgb[0] - value) <= value / 512.0f && fabsf(rgb[1] - value * 0.5f) <= value / 512.0f &&
+            rgb[2] == 0.0f;
+    }
+    passed &= check(roundTrips, "RGB9E5 keeps 9 bits of the largest channel");
+    float clamped[3];
+    SharedExponent::toFloat3(SharedExponent::fromFloat3(-1.0f, NAN, 1.0e9f), clamped);
+    passed &= check(clamped[0] == 0.0f && clamped[1] == 0.0f && clamped[2] == SharedExponent::MAX_VALUE,
+                    "negative and NaN channels encode as zero and large ones clamp");
+
+    const uint32_t width = 64;
+    const uint32_t height = 32;
+    std::vector<float> pixels((size_t)width * height * 4);
+    for (uint32_t i = 0; i < width * height; i++)
+    {
+        pixels[i * 4 + 0] = 0.001f * powf(1.5f, (float)(i % 40));
+        pixels[i * 4 + 1] = 0.5f + (float)(i % width) / width;
+        pixels[i * 4 + 2] = (float)(i / width);
+        pixels[i * 4 + 3] = 1.0f;
+    }
+    SHIrradiance irradianceSH;
+    irradianceSH.coefficients[0][0] = 0.25f;
+    irradianceSH.coefficients[8][2] = -0.5f;
+
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / "hdr-container-test";
+    std::filesystem::create_directories(directory);
+    std::string containerPath = (directory / HDRContainer::getContainerPath("environment.hdr")).string();
+    const uint64_t sourceHash = 42;
+    const uint64_t otherHash = 43;
+    for (RenderFormat format : {RENDER_FORMAT_R16G16B16A16_FLOAT, RENDER_FORMAT_R9G9B9E5_SHAREDEXP})
+    {
+        HDRContainer container;
+        bool written = HDRContainer::write(containerPath, sourceHash, pixels.data(), width, height, format,
+                                           irradianceSH, nullptr);
+        passed &= check(written && container.open(containerPath, &sourceHash) && container.getFormat() == format,
+                        "a written container maps with its source hash");
+        passed &= check((uintptr_t)container.getTexels() % HDRContainer::DATA_ALIGNMENT == 0,
+                        "the texels start on a page boundary");
+
+        RenderTextureDesc desc;
+        desc.width = width;
+        desc.height = height;
+        desc.format = format;
+        SoftwareTexture texture(desc);
+        texture.upload(0, 0, container.getTexels());
+        float maxError = 0.0f;
+        for (uint32_t i = 0; i < width * height; i++)
+        {
+            const Float4& texel = texture.getTexels(0, 0)[i];
+            const float* source = &pixels[i * 4];
+            float largest = std::max(source[0], std::max(source[1], source[2]));
+            float error = std::max(fabsf(texel.x - source[0]), std::max(fabsf(texel.y - source[1]),
+                                                                            fabsf(texel.z - source[2])));
+            maxError = std::max(maxError, error / largest);
+        }
+        passed &= check(maxError <= 1.0f / 256.0f, "mapped texels upload as the source values");
+        passed &= check(!memcmp(&container.getHeader().irradianceSH, &irradianceSH, sizeof(irradianceSH)),
+                        "the SH irradiance is stored in the header");
+        container.close();
+
+        passed &= check(!container.open(containerPath, &otherHash) && container.open(containerPath, nullptr),
+                        "a stale container is rejected unless the source is unknown");
+        container.close();
+    }
+
+    RecordingRenderDevice device;
+    CubemapGenerator generator(&device);
+    HDRCubemap cubemap;
+    bool loaded = true;
+    try
+    {
+        generator.loadHDRCubemap(directory.string() + "/", "environment.hdr", &cubemap);
+    }
+    catch (const std::runtime_error&)
+    {
+        loaded = false;
+    }
+    passed &= check(loaded && cubemap.cubemapTexture && cubemap.prefilteredTexture &&
+                    !memcmp(&cubemap.irradianceSH, &irradianceSH, sizeof(irradianceSH)),
+                    "an environment loads from the container without decoding an HDR");
+    CubemapGenerator::destroyCubemap(&device, &cubemap);
+    generator.destroy();
+
+    std::filesystem::resize_file(containerPath, HDRContainer::DATA_ALIGNMENT + 16);
+    HDRContainer truncated;
+    passed &= check(!truncated.open(containerPath, nullptr), "a truncated container is rejected");
+    truncated.close();
+    std::filesystem::remove_all(directory);
+
+    std::cout << (passed ? "All HDR container checks passed" : "HDR container checks failed") << std::endl;
+    return passed ? 0 : 1;
+}
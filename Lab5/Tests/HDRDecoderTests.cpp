@@ -0,0 +1,188 @@
+#include "TestSuites.h"
+
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "TestUtils.h"
+#include "../Engine/IBL/HDRDecoder.h"
+#include "../STB/stb_image.h"
+#include "../Utils/HalfFloat.h"
+#include "../Utils/ThreadPool.h"
+
+using TestUtils::check;
+using TestUtils::writeFile;
+
+namespace
+{
+    // Run-length encodes one RGBE scanline the way Radiance writes it: runs of three or more equal bytes, literal
+    // dumps of up to 128 bytes in between.
+    std::string encodeRleScanline(const uint8_t* rgbe, uint32_t width)
+    {
+        std::string scanline = {2, 2, (char)(width >> 8), (char)(width & 0xFF)};
+        for (uint32_t channel = 0; channel < 4; channel++)
+        {
+            auto at = [&](uint32_t x) { return rgbe[x * 4 + channel]; };
+            for (uint32_t x = 0; x < width;)
+            {
+                uint32_t run = 1;
+                while (x + run < width && run < 127 && at(x + run) == at(x))
+                {
+                    run++;
+                }
+                if (run >= 3)
+                {
+                    scanline += (char)(128 + run);
+                    scanline += (char)at(x);
+                    x += run;
+                    continue;
+                }
+                uint32_t end = x;
+                while (end < width && end - x < 128 &&
+                       !(end + 2 < width && at(end) == at(end + 1) && at(end) == at(end + 2)))
+                {
+                    end++;
+                }
+                scanline += (char)(end - x);
+                for (; x < end; x++)
+                {
+                    scanline += (char)at(x);
+                }
+            }
+        }
+        return scanline;
+    }
+
+    std::string makeRadianceHeader(const char* signature, const std::string& extraLines, uint32_t width,
+                                   uint32_t height)
+    {
+        return std::string(signature) + "\n" + extraLines + "FORMAT=32-bit_rle_rgbe\n\n-Y " + std::to_string(height) +
+            " +X " + std::to_string(width) + "\n";
+    }
+
+    // HDRDecoder::load must reproduce stbi_loadf bit for bit, and fail where it fails. When the decoder takes the
+    // file itself, its half output must also match converting stb's floats with HalfFloat.
+    bool decodesLikeStb(const std::string& path, ThreadPool* threadPool)
+    {
+        int width, height, nrComponents;
+        float* expected = stbi_loadf(path.c_str(), &width, &height, &nrComponents, 4);
+        std::vector<float> pixels;
+        uint32_t decodedWidth = 0, decodedHeight = 0;
+        bool loaded = HDRDecoder::load(path, threadPool, &pixels, &decodedWidth, &decodedHeight);
+        if (!expected)
+        {
+            return !loaded;
+        }
+        size_t count = (size_t)width * height * 4;
+        bool same = loaded && decodedWidth == (uint32_t)width && decodedHeight == (uint32_t)height &&
+            !memcmp(pixels.data(), expected, count * sizeof(float));
+        HDRDecoder decoder;
+        if (same && decoder.open(path))
+        {
+            std::vector<uint16_t> halves(count);
+            decoder.decode(RENDER_FORMAT_R16G16B16A16_FLOAT, halves.data(), threadPool);
+            for (size_t i = 0; i < count; i++)
+            {
+                same &= halves[i] == HalfFloat::fromFloat(expected[i]);
+            }
+        }
+        stbi_image_free(expected);
+        return same;
+    }
+}
+
+int testHDRDecoder()
+{
+    bool passed = true;
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / "hdr-decoder-test";
+    std::filesystem::create_directories(directory);
+    ThreadPool threadPool(2);
+
+    // Mantissas with long runs and noise, and exponents that cover black, float denormals and the largest
+    // value, which overflows to infinity as a half.
+    const uint32_t width = 300;
+    const uint32_t height = 37;
+    std::vector<uint8_t> rgbe((size_t)width * height * 4);
+    uint32_t state = 12345;
+    for (uint32_t y = 0; y < height; y++)
+    {
+        for (uint32_t x = 0; x < width; x++)
+        {
+            uint8_t* pixel = &rgbe[((size_t)y * width + x) * 4];
+            state = state * 1664525u + 1013904223u;
+            bool flat = (x / 16 + y) % 3 == 0;
+            for (uint32_t c = 0; c < 3; c++)
+            {
+                pixel[c] = flat ? (uint8_t)(64 * c + y) : (uint8_t)(state >> (8 * c + 8));
+            }
+            const uint8_t exponents[] = {0, 1, 5, 9, 100, 128, 129, 140, 160, 254, 255};
+            pixel[3] = flat ? 128 : exponents[(state >> 4) % 11];
+        }
+    }
+    std::string rle;
+    for (uint32_t y = 0; y < height; y++)
+    {
+        rle += encodeRleScanline(&rgbe[(size_t)y * width * 4], width);
+    }
+    std::string flatPixels(rgbe.begin(), rgbe.end());
+
+    struct Case
+    {
+        const char* name;
+        std::string contents;
+        bool opens;
+    };
+    std::string longLine = "# " + std::string(2000, 'x') + "FORMAT=32-bit_rle_rgbe\n";
+    std::string firstScanline = encodeRleScanline(rgbe.data(), width);
+    std::string corrupt = rle;
+    corrupt[firstScanline.size() + 4] = (char)255;
+    std::vector<uint8_t> narrow(rgbe.begin(), rgbe.begin() + 5 * 6 * 4);
+    std::vector<uint8_t> flatWide(rgbe.begin(), rgbe.begin() + 64 * 4 * 4);
+    flatWide[0] = 7;
+    const Case cases[] = {
+        {"run-length encoded scanlines", makeRadianceHeader("#?RADIANCE", "", width, height) + rle, true},
+        {"#?RGBE with extra and overlong header lines",
+         makeRadianceHeader("#?RGBE", "EXPOSURE=1.0\n" + longLine, width, height) + rle, true},
+        {"flat pixels narrower than eight",
+         makeRadianceHeader("#?RADIANCE", "", 5, 6) + std::string(narrow.begin(), narrow.end()), true},
+        {"flat pixels from the first scanline",
+         makeRadianceHeader("#?RADIANCE", "", 64, 4) + std::string(flatWide.begin(), flatWide.end()), true},
+        {"flat pixels after an encoded scanline",
+         makeRadianceHeader("#?RADIANCE", "", width, height) + firstScanline + flatPixels, false},
+        {"truncated scanlines", makeRadianceHeader("#?RADIANCE", "", width, height) + rle.substr(0, rle.size() / 2),
+         false},
+        {"corrupt run lengths", makeRadianceHeader("#?RADIANCE", "", width, height) + corrupt, false},
+        {"a missing FORMAT line", "#?RADIANCE\n\n-Y 1 +X 1\n" + std::string(4, '\x80'), false},
+    };
+    for (const Case& test : cases)
+    {
+        std::string path = (directory / "test.hdr").string();
+        writeFile(path, test.contents);
+        HDRDecoder decoder;
+        bool opened = decoder.open(path);
+        decoder.close();
+        std::string description = std::string(test.opens ? "decoded: " : "left to stb_image: ") + test.name;
+        passed &= check(opened == test.opens && decodesLikeStb(path, nullptr) && decodesLikeStb(path, &threadPool),
+                        description.c_str());
+    }
+
+    HDRDecoder decoder;
+    bool rejected = false;
+    try
+    {
+        float pixel[4];
+        decoder.decode(RENDER_FORMAT_R8G8B8A8_UNORM, pixel, nullptr);
+    }
+    catch (const std::runtime_error&)
+    {
+        rejected = true;
+    }
+    passed &= check(rejected, "decoding to a format other than RGBA32F or RGBA16F throws");
+    std::filesystem::remove_all(directory);
+
+    std::cout << (passed ? "All HDR decoder checks passed" : "HDR decoder checks failed") << std::endl;
+    return passed ? 0 : 1;
+}
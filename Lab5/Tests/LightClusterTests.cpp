@@ -0,0 +1,115 @@
+#include "TestSuites.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "TestUtils.h"
+#include "../Engine/Lighting/LightClusters.h"
+#include "../Utils/ThreadPool.h"
+
+using TestUtils::check;
+
+int testLightClusters()
+{
+    bool passed = true;
+    const float FOV_Y = 1.2f;
+    const float ASPECT_RATIO = 16.0f / 9.0f;
+    const float FAR_Z = 2000.0f;
+    Float3 eye = RenderMath::makeFloat3(3.0f, 2.0f, -30.0f);
+    Float4x4 viewMatrix = RenderMath::lookTo(eye, RenderMath::makeFloat3(-0.1f, -0.05f, 1.0f),
+                                             RenderMath::makeFloat3(0.0f, 1.0f, 0.0f));
+
+    // Lights all around the eye: in front, behind, straddling the eye plane and far past the last slice.
+    std::mt19937 random(7);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    std::vector<PointLightSource> lights(3000);
+    for (PointLightSource& light : lights)
+    {
+        light.position = RenderMath::makeFloat3((unit(random) - 0.5f) * 120.0f, (unit(random) - 0.5f) * 80.0f,
+                                                -60.0f + powf(unit(random), 3.0f) * 1200.0f);
+        light.radius = 0.5f + 8.0f * unit(random);
+        light.intensity = 1.0f;
+    }
+    lights[0].position = eye;
+    lights[1].position = RenderMath::makeFloat3(eye.x, eye.y, eye.z - 20.0f);
+    lights[1].radius = 5.0f;
+    lights[2].radius = 0.0f;
+
+    ThreadPool threadPool(3);
+    LightClusters threaded(&threadPool);
+    LightClusters serial(nullptr);
+    threaded.build(lights.data(), (uint32_t)lights.size(), viewMatrix, FOV_Y, ASPECT_RATIO, FAR_Z);
+    serial.build(lights.data(), (uint32_t)lights.size(), viewMatrix, FOV_Y, ASPECT_RATIO, FAR_Z);
+    passed &= check(threaded.getLightIndices() == serial.getLightIndices() &&
+                    !memcmp(threaded.getClusters().data(), serial.getClusters().data(),
+                            LightClusters::CLUSTER_COUNT * sizeof(LightCluster)),
+                    "the thread pool assigns the same lists");
+
+    const std::vector<LightCluster>& clusters = serial.getClusters();
+    const std::vector<uint32_t>& indices = serial.getLightIndices();
+    bool ordered = true;
+    size_t listed = 0;
+    std::vector<uint32_t> clusterCounts(lights.size());
+    for (const LightCluster& cluster : clusters)
+    {
+        ordered &= cluster.offset == listed;
+        listed += cluster.count;
+        for (uint32_t i = 0; i < cluster.count; i++)
+        {
+            uint32_t light = indices[cluster.offset + i];
+            ordered &= i == 0 || light > indices[cluster.offset + i - 1];
+            clusterCounts[light]++;
+        }
+    }
+    passed &= check(ordered && listed == indices.size(), "clusters list distinct lights back to back");
+    passed &= check(clusterCounts[0] > 0 && clusterCounts[1] == 0 && clusterCounts[2] == 0,
+                    "a light around the eye is kept, one behind it and an empty one are not");
+    std::cout << indices.size() << " entries for " << lights.size() << " lights, at most "
+        << serial.getMaxClusterLights() << " in a cluster" << std::endl;
+    passed &= check(indices.size() < lights.size() * 8, "lights land in a few clusters each");
+
+    // Any point a light reaches and the camera sees must find the light in its own cluster.
+    uint32_t visiblePoints = 0;
+    uint32_t missedPoints = 0;
+    for (uint32_t i = 0; i < 200000; i++)
+    {
+        uint32_t light = (uint32_t)(unit(random) * (lights.size() - 1));
+        Float3 offset = RenderMath::makeFloat3(unit(random) - 0.5f, unit(random) - 0.5f, unit(random) - 0.5f);
+        float offsetLength = sqrtf(RenderMath::dot(offset, offset));
+        if (offsetLength > 0.5f || offsetLength == 0.0f || lights[light].radius == 0.0f)
+        {
+            continue;
+        }
+        float scale = 0.99f * lights[light].radius * unit(random) / offsetLength;
+        Float3 point = RenderMath::makeFloat3(lights[light].position.x + offset.x * scale,
+                                              lights[light].position.y + offset.y * scale,
+                                              lights[light].position.z + offset.z * scale);
+        const float(*m)[4] = viewMatrix.m;
+        float viewX = point.x * m[0][0] + point.y * m[1][0] + point.z * m[2][0] + m[3][0];
+        float viewY = point.x * m[0][1] + point.y * m[1][1] + point.z * m[2][1] + m[3][1];
+        float viewZ = point.x * m[0][2] + point.y * m[1][2] + point.z * m[2][2] + m[3][2];
+        float scaleY = 1.0f / tanf(FOV_Y * 0.5f);
+        if (viewZ < 0.001f || viewZ > FAR_Z || fabsf(viewX * scaleY / ASPECT_RATIO) > viewZ ||
+            fabsf(viewY * scaleY) > viewZ)
+        {
+            continue;
+        }
+        visiblePoints++;
+        const LightCluster& cluster = clusters[serial.findCluster(point)];
+        const uint32_t* begin = indices.data() + cluster.offset;
+        missedPoints += std::find(begin, begin + cluster.count, light) == begin + cluster.count;
+    }
+    std::cout << visiblePoints << " lit points on screen, " << missedPoints << " missed" << std::endl;
+    passed &= check(visiblePoints > 10000 && missedPoints == 0, "every lit point finds its light");
+
+    serial.build(nullptr, 0, viewMatrix, FOV_Y, ASPECT_RATIO, FAR_Z);
+    passed &= check(serial.getLightIndices().empty() && serial.getMaxClusterLights() == 0,
+                    "no lights leave every cluster empty");
+
+    std::cout << (passed ? "All light cluster checks passed" : "Light cluster checks failed") << std::endl;
+    return passed ? 0 : 1;
+}
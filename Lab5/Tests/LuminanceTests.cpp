@@ -0,0 +1,143 @@
+#include "TestSuites.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "TestUtils.h"
+#include "../Engine/ToneMap/LuminanceReduction.h"
+
+using TestUtils::check;
+
+namespace
+{
+    // Not multiples of the group size, so the partial groups at the edges are covered.
+    const uint32_t IMAGE_WIDTH = 203;
+    const uint32_t IMAGE_HEIGHT = 117;
+    const float MAX_RELATIVE_ERROR = 0.0001f;
+    const float HISTOGRAM_MAX_STOPS = 16.0f / LuminanceReduction::HISTOGRAM_BINS;
+
+    // Grey pixels whose brightness runs along each row; the rows are all the same.
+    std::vector<float> makeGradient(float (*getBrightness)(float position))
+    {
+        const float grey[3] = {1.0f, 1.0f, 1.0f};
+        float greyBrightness = LuminanceReduction::brightness(grey);
+        std::vector<float> pixels((size_t)IMAGE_WIDTH * IMAGE_HEIGHT * 4);
+        for (uint32_t y = 0; y < IMAGE_HEIGHT; y++)
+        {
+            for (uint32_t x = 0; x < IMAGE_WIDTH; x++)
+            {
+                float value = getBrightness((x + 0.5f) / IMAGE_WIDTH) / greyBrightness;
+                float* pixel = &pixels[((size_t)y * IMAGE_WIDTH + x) * 4];
+                pixel[0] = pixel[1] = pixel[2] = value;
+                pixel[3] = 1.0f;
+            }
+        }
+        return pixels;
+    }
+
+    // log(L + 1) from 0 to 4, evenly spaced, so its mean is exactly 2.
+    float getLogGradient(float position)
+    {
+        return expf(4.0f * position) - 1.0f;
+    }
+
+    // log2 L from -8 to 4. Between the 50th and 95th percentile it spans -2 to 3.4, for a mean of 0.7.
+    float getLog2Gradient(float position)
+    {
+        return exp2f(-8.0f + 12.0f * position);
+    }
+
+    float exposureStops(float logAverage)
+    {
+        return log2f(expf(logAverage) - 1.0f);
+    }
+
+    LuminanceResult reduce(const std::vector<float>& pixels, uint32_t width, uint32_t height, uint32_t exposureMode)
+    {
+        LuminanceConstants constants = LuminanceReduction::makeConstants(width, height, exposureMode);
+        std::vector<LuminanceStats> partials;
+        std::vector<uint32_t> histogram;
+        LuminanceReduction::reduceGroups(pixels.data(), constants, &partials, &histogram);
+        return LuminanceReduction::finalize(partials, histogram, constants);
+    }
+
+    // The mirror of the compute shaders against the plain scalar loop, in both exposure modes.
+    bool matchesReference(const std::vector<float>& pixels, uint32_t width, uint32_t height)
+    {
+        bool matches = true;
+        for (uint32_t exposureMode : {LUMINANCE_EXPOSURE_AVERAGE, LUMINANCE_EXPOSURE_HISTOGRAM})
+        {
+            LuminanceConstants constants = LuminanceReduction::makeConstants(width, height, exposureMode);
+            LuminanceResult result = reduce(pixels, width, height, exposureMode);
+            LuminanceResult reference = LuminanceReduction::reduceReference(pixels.data(), constants);
+            matches &= result.minimum == reference.minimum && result.maximum == reference.maximum;
+            if (exposureMode == LUMINANCE_EXPOSURE_AVERAGE)
+            {
+                matches &= fabsf(result.average - reference.average) <=
+                    MAX_RELATIVE_ERROR * std::max(fabsf(reference.average), FLT_MIN);
+            }
+            else
+            {
+                matches &= fabsf(exposureStops(result.average) - exposureStops(reference.average)) <=
+                    HISTOGRAM_MAX_STOPS;
+            }
+        }
+        return matches;
+    }
+}
+
+// Reduces generated images whose averages are known in closed form, then random ones against the scalar loop.
+int testLuminance()
+{
+    bool passed = true;
+
+    std::vector<float> logGradient = makeGradient(getLogGradient);
+    LuminanceResult average = reduce(logGradient, IMAGE_WIDTH, IMAGE_HEIGHT, LUMINANCE_EXPOSURE_AVERAGE);
+    passed &= check(fabsf(average.average - 2.0f) <= 2.0f * MAX_RELATIVE_ERROR,
+                    "the log average of an even log(L + 1) ramp is its midpoint");
+    float darkest = getLogGradient(0.5f / IMAGE_WIDTH);
+    float brightest = getLogGradient((IMAGE_WIDTH - 0.5f) / IMAGE_WIDTH);
+    passed &= check(fabsf(average.minimum - darkest) <= darkest * MAX_RELATIVE_ERROR &&
+                        fabsf(average.maximum - brightest) <= brightest * MAX_RELATIVE_ERROR,
+                    "minimum and maximum are the two ends of the ramp");
+
+    // The histogram only knows quarter stops, the scalar loop sorts the exact values.
+    std::vector<float> log2Gradient = makeGradient(getLog2Gradient);
+    LuminanceConstants constants =
+        LuminanceReduction::makeConstants(IMAGE_WIDTH, IMAGE_HEIGHT, LUMINANCE_EXPOSURE_HISTOGRAM);
+    float referenceStops = exposureStops(LuminanceReduction::reduceReference(log2Gradient.data(), constants).average);
+    float histogramStops = exposureStops(
+        reduce(log2Gradient, IMAGE_WIDTH, IMAGE_HEIGHT, LUMINANCE_EXPOSURE_HISTOGRAM).average);
+    std::cout << "     trimmed log2 mean: histogram " << histogramStops << ", exact " << referenceStops
+        << ", expected 0.7" << std::endl;
+    passed &= check(fabsf(referenceStops - 0.7f) <= 12.0f / IMAGE_WIDTH,
+                    "the exact percentile mean of an even log2 ramp is the middle of its trimmed range");
+    passed &= check(fabsf(histogramStops - 0.7f) <= HISTOGRAM_MAX_STOPS,
+                    "the histogram percentile mean is within a bin of it");
+
+    // Three decades of random luminance, as a whole image and as a crop that ends partway into a group.
+    std::mt19937 random(7);
+    std::uniform_real_distribution<float> exponent(-3.0f, 3.0f);
+    std::vector<float> noise((size_t)IMAGE_WIDTH * IMAGE_HEIGHT * 4);
+    for (size_t i = 0; i < noise.size(); i++)
+    {
+        noise[i] = i % 4 == 3 ? 1.0f : powf(10.0f, exponent(random));
+    }
+    passed &= check(matchesReference(noise, IMAGE_WIDTH, IMAGE_HEIGHT),
+                    "the group reduction matches the scalar loop on random pixels");
+    const uint32_t cropWidth = IMAGE_WIDTH - 5;
+    const uint32_t cropHeight = IMAGE_HEIGHT - 3;
+    std::vector<float> crop((size_t)cropWidth * cropHeight * 4);
+    for (uint32_t y = 0; y < cropHeight; y++)
+    {
+        std::copy_n(noise.data() + (size_t)y * IMAGE_WIDTH * 4, (size_t)cropWidth * 4,
+                    crop.data() + (size_t)y * cropWidth * 4);
+    }
+    passed &= check(matchesReference(crop, cropWidth, cropHeight), "and on a crop of them");
+
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,63 @@
+#include "TestSuites.h"
+
+#include <iostream>
+#include <string>
+
+#include "TestUtils.h"
+#include "../Utils/MemoryAccounting.h"
+
+using TestUtils::check;
+
+namespace
+{
+    uint64_t getCategoryBytes(const MemoryStats& stats, const std::string& name, bool peak)
+    {
+        for (const auto& category : stats.categories)
+        {
+            if (category.name == name)
+            {
+                return peak ? category.peakBytes : category.currentBytes;
+            }
+        }
+        return 0;
+    }
+}
+
+// Replays the HDR target resize the renderer performs, once with a ring of four targets and once with one.
+int testMemory()
+{
+    const uint64_t target = 1920ull * 1080 * 8;
+    const uint64_t depth = 1920ull * 1080 * 4;
+    bool passed = true;
+
+    uint64_t peaks[2];
+    uint32_t ringSizes[2] = {4, 1};
+    for (uint32_t i = 0; i < 2; i++)
+    {
+        MemoryAccounting::resetPeak();
+        uint64_t bytes = target * ringSizes[i] + depth;
+        MemoryAccounting::allocate("HDR scene", bytes);
+        MemoryAccounting::allocate("Constant ring", 64 * 1024);
+        MemoryAccounting::release("HDR scene", bytes);
+        MemoryAccounting::allocate("HDR scene", bytes);
+        MemoryStats stats = MemoryAccounting::getStats();
+        peaks[i] = getCategoryBytes(stats, "HDR scene", true);
+        passed &= check(getCategoryBytes(stats, "HDR scene", false) == bytes && peaks[i] == bytes,
+                        "a resize releases before it allocates, so the peak stays at one set of targets");
+        MemoryAccounting::release("HDR scene", bytes);
+        MemoryAccounting::release("Constant ring", 64 * 1024);
+    }
+    std::cout << "HDR scene peak: " << peaks[0] / (1024 * 1024) << " MB with four targets, "
+        << peaks[1] / (1024 * 1024) << " MB with one" << std::endl;
+    passed &= check(peaks[0] - peaks[1] == target * 3, "three targets are saved");
+
+    MemoryAccounting::release("HDR scene", 1);
+    MemoryStats stats = MemoryAccounting::getStats();
+    passed &= check(stats.currentBytes == 0 && stats.categories.size() == 2,
+                    "an unbalanced release is clamped and categories are kept");
+    MemoryAccounting::resetPeak();
+    passed &= check(MemoryAccounting::getStats().peakBytes == 0, "resetPeak drops to the current total");
+
+    std::cout << (passed ? "All memory accounting checks passed" : "Memory accounting checks failed") << std::endl;
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,154 @@
+#include "TestSuites.h"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "TestUtils.h"
+#include "../Engine/Mesh/MeshBuilder.h"
+
+using TestUtils::check;
+
+namespace
+{
+    const float DEFAULT_COLOR[3] = {0.25f, 0.5f, 0.75f};
+
+    // A grid of quads in the OBJ layout: one position, UV and normal per grid point, each corner referring to all
+    // three by the same index. Odd rows leave the UVs out, as some files do. Depth is offset by the first index so
+    // grids sharing an attribute pool never share a vertex.
+    void makeGrid(uint32_t width, uint32_t height, tinyobj::attrib_t& attrib, tinyobj::shape_t& shape)
+    {
+        uint32_t base = (uint32_t)attrib.vertices.size() / 3;
+        for (uint32_t y = 0; y <= height; y++)
+        {
+            for (uint32_t x = 0; x <= width; x++)
+            {
+                attrib.vertices.insert(attrib.vertices.end(), {(float)x, (float)y, (float)(base + (x * y) % 7)});
+                attrib.texcoords.insert(attrib.texcoords.end(), {(float)x / width, (float)y / height});
+                attrib.normals.insert(attrib.normals.end(), {0.0f, 0.0f, -1.0f});
+            }
+        }
+        for (uint32_t y = 0; y < height; y++)
+        {
+            for (uint32_t x = 0; x < width; x++)
+            {
+                const uint32_t corners[6] = {0, width + 1, 1, 1, width + 1, width + 2};
+                for (uint32_t corner : corners)
+                {
+                    int index = (int)(base + y * (width + 1) + x + corner);
+                    shape.mesh.indices.push_back({index, index, y % 2 ? -1 : index});
+                }
+            }
+        }
+    }
+
+    // Every triangle as the bytes of its vertices, rotated to start at the smallest so winding is kept, sorted.
+    std::vector<std::string> getTriangleSet(const std::vector<MeshVertex>& corners)
+    {
+        std::vector<std::string> triangles;
+        for (size_t i = 0; i + 2 < corners.size(); i += 3)
+        {
+            uint32_t first = 0;
+            for (uint32_t k = 1; k < 3; k++)
+            {
+                first = memcmp(&corners[i + k], &corners[i + first], sizeof(MeshVertex)) < 0 ? k : first;
+            }
+            std::string triangle;
+            for (uint32_t k = 0; k < 3; k++)
+            {
+                triangle.append((const char*)&corners[i + (first + k) % 3], sizeof(MeshVertex));
+            }
+            triangles.push_back(triangle);
+        }
+        std::sort(triangles.begin(), triangles.end());
+        return triangles;
+    }
+
+    // The corners an indexed mesh draws, in draw order.
+    std::vector<MeshVertex> expand(const MeshData& mesh)
+    {
+        std::vector<MeshVertex> corners;
+        for (uint32_t index : mesh.indices)
+        {
+            corners.push_back(index < mesh.vertices.size() ? mesh.vertices[index] : MeshVertex{});
+        }
+        return corners;
+    }
+
+    // The same, read through the 16-bit copy of the index buffer the renderer uploads when it fits.
+    std::vector<MeshVertex> expandShort(const MeshData& mesh)
+    {
+        std::vector<MeshVertex> corners;
+        for (uint16_t index : mesh.getShortIndices())
+        {
+            corners.push_back(index < mesh.vertices.size() ? mesh.vertices[index] : MeshVertex{});
+        }
+        return corners;
+    }
+
+    // buildFlattened is the oracle: one vertex per corner in file order, nothing merged or reordered.
+    bool checkAgainstFlattened(const tinyobj::attrib_t& attrib, const std::vector<tinyobj::shape_t>& shapes,
+                               uint32_t expectedUnique, const std::string& name)
+    {
+        MeshData indexed = MeshBuilder::buildIndexed(attrib, shapes, DEFAULT_COLOR);
+        MeshData flattened = MeshBuilder::buildFlattened(attrib, shapes, DEFAULT_COLOR);
+        bool passed = true;
+
+        bool inRange = true;
+        for (uint32_t index : indexed.indices)
+        {
+            inRange &= index < indexed.vertices.size();
+        }
+        passed &= check(inRange, (name + ": every index is inside the vertex buffer").c_str());
+        passed &= check(indexed.indices.size() == flattened.vertices.size(),
+                        (name + ": one index per corner of the file").c_str());
+        passed &= check(indexed.vertices.size() == expectedUnique,
+                        (name + ": corners sharing every attribute share a vertex").c_str());
+        passed &= check(getTriangleSet(expand(indexed)) == getTriangleSet(flattened.vertices),
+                        (name + ": expanded through its indices it draws the flattened triangles").c_str());
+
+        bool shortIndices = expectedUnique <= UINT16_MAX;
+        passed &= check(indexed.canUseShortIndices() == shortIndices &&
+                            indexed.stats.indexSize == (shortIndices ? sizeof(uint16_t) : sizeof(uint32_t)),
+                        (name + (shortIndices ? ": fits 16-bit indices" : ": needs 32-bit indices")).c_str());
+        if (shortIndices)
+        {
+            passed &= check(getTriangleSet(expandShort(indexed)) == getTriangleSet(flattened.vertices),
+                            (name + ": the 16-bit index buffer draws the same triangles").c_str());
+        }
+        passed &= check(indexed.stats.sourceVertexCount == flattened.stats.sourceVertexCount &&
+                            indexed.stats.flattenedBytes == flattened.stats.flattenedBytes &&
+                            indexed.stats.indexedBytes < flattened.stats.indexedBytes,
+                        (name + ": the stats compare against the flattened size").c_str());
+        return passed;
+    }
+}
+
+int testMeshBuilder()
+{
+    bool passed = true;
+
+    tinyobj::attrib_t emptyAttrib;
+    MeshData empty = MeshBuilder::buildIndexed(emptyAttrib, {}, DEFAULT_COLOR);
+    passed &= check(empty.vertices.empty() && empty.indices.empty() && empty.stats.compressionRatio == 1.0f,
+                    "an empty file builds an empty mesh");
+
+    // Two shapes sharing one attribute pool.
+    tinyobj::attrib_t attrib;
+    std::vector<tinyobj::shape_t> shapes(2);
+    makeGrid(16, 8, attrib, shapes[0]);
+    makeGrid(4, 4, attrib, shapes[1]);
+    // Grid lines between a row with UVs and one without carry both versions of each point, the outer two one each.
+    uint32_t gridUnique = 17 * 16 + 5 * 8;
+    passed &= checkAgainstFlattened(attrib, shapes, gridUnique, "small grid");
+
+    // Over 65535 distinct vertices, so only a 32-bit index buffer can address them.
+    tinyobj::attrib_t largeAttrib;
+    std::vector<tinyobj::shape_t> largeShapes(1);
+    makeGrid(300, 128, largeAttrib, largeShapes[0]);
+    uint32_t largeUnique = 301 * 256;
+    passed &= checkAgainstFlattened(largeAttrib, largeShapes, largeUnique, "large grid");
+
+    return passed ? 0 : 1;
+}
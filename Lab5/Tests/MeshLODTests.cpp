@@ -0,0 +1,201 @@
+#include "TestSuites.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <vector>
+
+#include "TestUtils.h"
+#include "../Engine/Mesh/MeshSimplifier.h"
+#include "../Engine/RenderDevice/RenderMath.h"
+#include "../Utils/ThreadPool.h"
+
+using TestUtils::check;
+using TestUtils::makeTestSphere;
+
+namespace
+{
+    // Edges shared by exactly two triangles once vertices are welded by position, and every triangle facing away
+    // from the origin.
+    bool isClosedAndOutward(const MeshData& mesh, const std::vector<uint32_t>& indices)
+    {
+        std::map<std::vector<float>, uint32_t> welded;
+        std::map<std::pair<uint32_t, uint32_t>, int> edges;
+        bool outward = true;
+        for (size_t i = 0; i < indices.size(); i += 3)
+        {
+            uint32_t triangle[3];
+            Float3 points[3];
+            for (uint32_t k = 0; k < 3; k++)
+            {
+                const float* position = mesh.vertices[indices[i + k]].position;
+                points[k] = RenderMath::makeFloat3(position[0], position[1], position[2]);
+                triangle[k] = welded.emplace(std::vector<float>(position, position + 3), (uint32_t)welded.size())
+                    .first->second;
+            }
+            // The fans around the poles of the test spheres start with triangles that weld to a line.
+            if (triangle[0] == triangle[1] || triangle[1] == triangle[2] || triangle[2] == triangle[0])
+            {
+                continue;
+            }
+            for (uint32_t k = 0; k < 3; k++)
+            {
+                edges[std::make_pair(std::min(triangle[k], triangle[(k + 1) % 3]),
+                                     std::max(triangle[k], triangle[(k + 1) % 3]))]++;
+            }
+            Float3 edge1 = RenderMath::makeFloat3(points[1].x - points[0].x, points[1].y - points[0].y,
+                                                  points[1].z - points[0].z);
+            Float3 edge2 = RenderMath::makeFloat3(points[2].x - points[0].x, points[2].y - points[0].y,
+                                                  points[2].z - points[0].z);
+            Float3 normal = RenderMath::cross(edge1, edge2);
+            outward &= RenderMath::dot(normal, points[0]) > 0.0f;
+        }
+        bool closed = true;
+        for (const auto& edge : edges)
+        {
+            closed &= edge.second == 2;
+        }
+        return closed && outward;
+    }
+}
+
+int testMeshLOD()
+{
+    bool passed = true;
+    // The poles and the last column of the test spheres miss by rounding; snap them shut like shared OBJ
+    // positions would be.
+    auto makeClosedSphere = [](uint32_t rings, uint32_t segments)
+    {
+        MeshData mesh = makeTestSphere(rings, segments);
+        for (uint32_t i = 0; i < mesh.vertices.size(); i++)
+        {
+            float* position = mesh.vertices[i].position;
+            if (i % (segments + 1) == segments)
+            {
+                memcpy(position, mesh.vertices[i - segments].position, sizeof(mesh.vertices[i].position));
+            }
+            if (fabsf(position[1]) > 0.9999f)
+            {
+                position[0] = position[2] = 0.0f;
+                position[1] = position[1] > 0.0f ? 1.0f : -1.0f;
+            }
+        }
+        return mesh;
+    };
+    MeshData sphere = makeClosedSphere(32, 48);
+    MeshData finer = makeClosedSphere(64, 96);
+    std::vector<const MeshData*> meshes = {&sphere, &finer};
+    MeshLODSettings settings;
+    ThreadPool threadPool(3);
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::vector<MeshLOD>> chains = MeshSimplifier::buildLODChains(meshes, settings, &threadPool);
+    double threadedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start)
+        .count();
+    start = std::chrono::steady_clock::now();
+    std::vector<std::vector<MeshLOD>> serial = MeshSimplifier::buildLODChains(meshes, settings, nullptr);
+    double serialMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "LOD chains: " << threadedMs << " ms on the thread pool, " << serialMs << " ms serial"
+        << std::endl;
+    bool same = chains.size() == serial.size();
+    for (size_t mesh = 0; same && mesh < chains.size(); mesh++)
+    {
+        same &= chains[mesh].size() == serial[mesh].size();
+        for (size_t level = 0; same && level < chains[mesh].size(); level++)
+        {
+            same &= chains[mesh][level].indices == serial[mesh][level].indices &&
+                chains[mesh][level].error == serial[mesh][level].error;
+        }
+    }
+    passed &= check(same, "the thread pool builds the same chains");
+
+    for (size_t mesh = 0; mesh < meshes.size(); mesh++)
+    {
+        const std::vector<MeshLOD>& chain = chains[mesh];
+        bool shrinking = chain.size() >= 4 && chain[0].error == 0.0f;
+        bool intact = true;
+        bool seamsKept = true;
+        for (size_t level = 0; level < chain.size(); level++)
+        {
+            const std::vector<uint32_t>& indices = chain[level].indices;
+            // The surface of a unit sphere: how far inside it the centers of the triangles sink.
+            float deviation = 0.0f;
+            for (size_t i = 0; i < indices.size(); i += 3)
+            {
+                Float3 center;
+                float minU = 1.0f;
+                float maxU = 0.0f;
+                for (uint32_t k = 0; k < 3; k++)
+                {
+                    const MeshVertex& vertex = meshes[mesh]->vertices[indices[i + k]];
+                    center.x += vertex.position[0] / 3.0f;
+                    center.y += vertex.position[1] / 3.0f;
+                    center.z += vertex.position[2] / 3.0f;
+                    // Pole vertices take every u along the seam row.
+                    if (fabsf(vertex.position[1]) < 1.0f)
+                    {
+                        minU = std::min(minU, vertex.uv[0]);
+                        maxU = std::max(maxU, vertex.uv[0]);
+                    }
+                }
+                deviation = std::max(deviation, 1.0f - sqrtf(RenderMath::dot(center, center)));
+                seamsKept &= maxU - minU < 0.5f;
+            }
+            std::cout << "mesh " << mesh << " LOD " << level << ": " << indices.size() / 3 << " triangles, error "
+                << chain[level].error << ", deviation " << deviation << std::endl;
+            intact &= isClosedAndOutward(*meshes[mesh], indices);
+            if (level > 0)
+            {
+                shrinking &= indices.size() < chain[level - 1].indices.size() &&
+                    chain[level].error >= chain[level - 1].error;
+            }
+        }
+        passed &= check(shrinking, "levels lose triangles and gain error");
+        passed &= check(intact, "every level stays closed with no triangle turned over");
+        passed &= check(seamsKept, "no triangle stretches across the texture seam");
+    }
+
+    // A flat grid: interior vertices cost nothing to remove, the border must keep its outline.
+    MeshData grid;
+    const uint32_t GRID_SIZE = 12;
+    for (uint32_t y = 0; y <= GRID_SIZE; y++)
+    {
+        for (uint32_t x = 0; x <= GRID_SIZE; x++)
+        {
+            MeshVertex vertex{};
+            vertex.position[0] = (float)x;
+            vertex.position[2] = (float)y;
+            grid.vertices.push_back(vertex);
+        }
+    }
+    for (uint32_t y = 0; y < GRID_SIZE; y++)
+    {
+        for (uint32_t x = 0; x < GRID_SIZE; x++)
+        {
+            uint32_t a = y * (GRID_SIZE + 1) + x;
+            uint32_t b = a + GRID_SIZE + 1;
+            const uint32_t quad[] = {a, b, a + 1, a + 1, b, b + 1};
+            grid.indices.insert(grid.indices.end(), quad, quad + 6);
+        }
+    }
+    float gridError = -1.0f;
+    std::vector<uint32_t> flat = MeshSimplifier::simplify(grid, 0, 0.0f, &gridError);
+    float area = 0.0f;
+    for (size_t i = 0; i < flat.size(); i += 3)
+    {
+        const float* p0 = grid.vertices[flat[i]].position;
+        const float* p1 = grid.vertices[flat[i + 1]].position;
+        const float* p2 = grid.vertices[flat[i + 2]].position;
+        area += 0.5f * fabsf((p1[0] - p0[0]) * (p2[2] - p0[2]) - (p2[0] - p0[0]) * (p1[2] - p0[2]));
+    }
+    std::cout << "Flat grid: " << grid.indices.size() / 3 << " triangles down to " << flat.size() / 3
+        << ", area " << area << std::endl;
+    passed &= check(flat.size() < grid.indices.size() / 2 && gridError == 0.0f &&
+                    fabsf(area - GRID_SIZE * GRID_SIZE) < 1e-3f,
+                    "a flat grid simplifies at no error and keeps its outline");
+
+    std::cout << (passed ? "All mesh LOD checks passed" : "Mesh LOD checks failed") << std::endl;
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,125 @@
+#include "TestSuites.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "TestUtils.h"
+#include "../Engine/Mesh/MeshOptimizer.h"
+
+using TestUtils::check;
+using TestUtils::makeTestSphere;
+
+namespace
+{
+    // Every triangle as the bytes of its vertices, rotated to start at the smallest so winding is kept, sorted.
+    std::vector<std::string> getTriangleSet(const MeshData& mesh)
+    {
+        std::vector<std::string> triangles;
+        for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3)
+        {
+            const MeshVertex* corners[3] = {&mesh.vertices[mesh.indices[i]], &mesh.vertices[mesh.indices[i + 1]],
+                                            &mesh.vertices[mesh.indices[i + 2]]};
+            uint32_t first = 0;
+            for (uint32_t k = 1; k < 3; k++)
+            {
+                first = memcmp(corners[k], corners[first], sizeof(MeshVertex)) < 0 ? k : first;
+            }
+            std::string triangle;
+            for (uint32_t k = 0; k < 3; k++)
+            {
+                triangle.append((const char*)corners[(first + k) % 3], sizeof(MeshVertex));
+            }
+            triangles.push_back(triangle);
+        }
+        std::sort(triangles.begin(), triangles.end());
+        return triangles;
+    }
+}
+
+int testMeshOptimizer()
+{
+    bool passed = true;
+
+    MeshData single;
+    single.vertices.resize(3);
+    single.indices = {0, 1, 2};
+    VertexCacheStats singleStats = MeshOptimizer::analyzeVertexCache(single.indices, 3);
+    passed &= check(singleStats.acmr == 3.0f && singleStats.atvr == 1.0f,
+                    "a lone triangle transforms three vertices, each once");
+
+    // The triangles of a sphere in random order, the worst case for the cache.
+    MeshData sphere = makeTestSphere(32, 48);
+    std::vector<uint32_t> triangleOrder(sphere.indices.size() / 3);
+    for (uint32_t i = 0; i < triangleOrder.size(); i++)
+    {
+        triangleOrder[i] = i;
+    }
+    std::shuffle(triangleOrder.begin(), triangleOrder.end(), std::mt19937(7));
+    MeshData shuffled = sphere;
+    for (size_t i = 0; i < triangleOrder.size(); i++)
+    {
+        memcpy(&shuffled.indices[i * 3], &sphere.indices[triangleOrder[i] * 3], 3 * sizeof(uint32_t));
+    }
+    uint32_t vertexCount = (uint32_t)shuffled.vertices.size();
+    VertexCacheStats before = MeshOptimizer::analyzeVertexCache(shuffled.indices, vertexCount);
+    std::vector<uint32_t> clusters;
+    std::vector<uint32_t> tipsified = MeshOptimizer::optimizeVertexCache(shuffled.indices, vertexCount, &clusters);
+    VertexCacheStats tipsify = MeshOptimizer::analyzeVertexCache(tipsified, vertexCount);
+    MeshData optimized = shuffled;
+    MeshOptimizer::optimize(optimized);
+    VertexCacheStats after = MeshOptimizer::analyzeVertexCache(optimized.indices, vertexCount);
+    std::cout << "Shuffled sphere: ACMR " << before.acmr << " -> " << tipsify.acmr << " after Tipsify ("
+        << clusters.size() << " clusters), " << after.acmr << " after overdraw ordering; ATVR " << before.atvr
+        << " -> " << after.atvr << std::endl;
+    passed &= check(tipsify.acmr < 0.8f && tipsify.acmr < before.acmr / 2.0f && !clusters.empty() &&
+                    clusters[0] == 0, "Tipsify at least halves the cache misses of a shuffled sphere");
+    passed &= check(after.acmr <= tipsify.acmr * 1.1f, "overdraw ordering keeps most of the cache gain");
+    passed &= check(getTriangleSet(optimized) == getTriangleSet(shuffled),
+                    "the optimized mesh draws the same triangles with the same winding");
+    bool firstUse = optimized.vertices.size() == shuffled.vertices.size();
+    uint32_t nextVertex = 0;
+    for (uint32_t index : optimized.indices)
+    {
+        firstUse &= index <= nextVertex;
+        nextVertex = std::max(nextVertex, index + 1);
+    }
+    passed &= check(firstUse, "vertices are numbered in order of first use");
+
+    // A shell around one a quarter its size, inner first: the outer shell hides the inner from every side. The
+    // ordering works on whole clusters, which on a mesh this coarse span up to half a shell, hence the margin.
+    MeshData shells = makeTestSphere(8, 12);
+    MeshData inner = shells;
+    for (MeshVertex& vertex : shells.vertices)
+    {
+        for (int axis = 0; axis < 3; axis++)
+        {
+            vertex.position[axis] *= 4.0f;
+        }
+    }
+    uint32_t innerTriangles = (uint32_t)(inner.indices.size() / 3);
+    for (uint32_t& index : shells.indices)
+    {
+        index += (uint32_t)inner.vertices.size();
+    }
+    shells.vertices.insert(shells.vertices.begin(), inner.vertices.begin(), inner.vertices.end());
+    shells.indices.insert(shells.indices.begin(), inner.indices.begin(), inner.indices.end());
+    MeshOptimizer::optimize(shells);
+    uint32_t outerFirst = 0;
+    for (uint32_t i = 0; i < innerTriangles; i++)
+    {
+        const float* position = shells.vertices[shells.indices[i * 3]].position;
+        outerFirst += position[0] * position[0] + position[1] * position[1] + position[2] * position[2] > 4.0f;
+    }
+    passed &= check(outerFirst == innerTriangles, "the outer shell is drawn before the inner one");
+
+    MeshData empty;
+    MeshOptimizer::optimize(empty);
+    passed &= check(empty.indices.empty() && empty.vertices.empty(), "an empty mesh stays empty");
+
+    std::cout << (passed ? "All mesh optimizer checks passed" : "Mesh optimizer checks failed") << std::endl;
+    return passed ? 0 : 1;
+}
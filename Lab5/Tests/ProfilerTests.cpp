@@ -0,0 +1,168 @@
+#include "TestSuites.h"
+
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "TestUtils.h"
+#include "../Engine/Profiler/ProfileTimeline.h"
+
+using TestUtils::check;
+
+namespace
+{
+    ProfileSample makeSample(const char* name, uint32_t depth, double cpuMs, double gpuMs)
+    {
+        ProfileSample sample;
+        sample.name = name;
+        sample.depth = depth;
+        sample.cpuDurationMs = cpuMs;
+        sample.hasGpu = gpuMs >= 0;
+        sample.gpuDurationMs = sample.hasGpu ? gpuMs : 0;
+        return sample;
+    }
+
+    size_t countOccurrences(const std::string& text, const std::string& pattern)
+    {
+        size_t count = 0;
+        for (size_t position = text.find(pattern); position != std::string::npos;
+             position = text.find(pattern, position + 1))
+        {
+            count++;
+        }
+        return count;
+    }
+
+    // Nesting outside strings must close, which is enough to catch a broken writer without a JSON parser.
+    bool isBalancedJson(const std::string& text)
+    {
+        int depth = 0;
+        bool inString = false;
+        for (size_t i = 0; i < text.size(); i++)
+        {
+            char character = text[i];
+            if (inString)
+            {
+                if (character == '\\')
+                {
+                    i++;
+                }
+                else if (character == '"')
+                {
+                    inString = false;
+                }
+                continue;
+            }
+            if (character == '"')
+            {
+                inString = true;
+            }
+            else if (character == '{' || character == '[')
+            {
+                depth++;
+            }
+            else if ((character == '}' || character == ']') && --depth < 0)
+            {
+                return false;
+            }
+        }
+        return depth == 0 && !inString;
+    }
+}
+
+// Covers the CPU half of FrameProfiler: scope recording, per-pass aggregation and the Chrome trace writer.
+int testProfiler()
+{
+    bool passed = true;
+
+    CpuFrameRecorder recorder;
+    recorder.beginFrame(7);
+    recorder.beginScope("Tone mapping");
+    uint32_t adaptation = recorder.beginScope("Calculating adaptation");
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    passed &= check(recorder.endScope() == adaptation, "endScope closes the innermost scope");
+    recorder.beginScope("Postprocess");
+    recorder.endScope();
+    recorder.endScope();
+    recorder.beginScope("GUI");
+    recorder.endScope();
+    ProfileFrame frame = recorder.endFrame();
+    passed &= check(frame.index == 7 && frame.samples.size() == 4 && frame.samples[0].depth == 0 &&
+                    frame.samples[1].depth == 1 && frame.samples[2].depth == 1 && frame.samples[3].depth == 0,
+                    "samples keep begin order and nesting depth");
+    double childrenMs = frame.samples[1].cpuDurationMs + frame.samples[2].cpuDurationMs;
+    passed &= check(frame.samples[1].cpuDurationMs >= 2.0 && frame.samples[0].cpuDurationMs >= childrenMs &&
+                    frame.cpuDurationMs >= frame.samples[0].cpuDurationMs,
+                    "a scope lasts at least as long as its children");
+
+    bool threw = false;
+    try
+    {
+        recorder.beginFrame(8);
+        recorder.beginScope("Unclosed");
+        recorder.endFrame();
+    }
+    catch (const std::runtime_error&)
+    {
+        threw = true;
+    }
+    passed &= check(threw, "a frame with an open scope is rejected");
+    threw = false;
+    try
+    {
+        CpuFrameRecorder other;
+        other.beginFrame(0);
+        other.endScope();
+    }
+    catch (const std::runtime_error&)
+    {
+        threw = true;
+    }
+    passed &= check(threw, "an end without a begin is rejected");
+
+    ProfileAggregator aggregator(3);
+    for (uint32_t i = 0; i < 4; i++)
+    {
+        ProfileFrame sampled;
+        sampled.index = i;
+        sampled.cpuStartMs = 16.0 * i;
+        sampled.cpuDurationMs = 16.0;
+        // The first frame is pushed out of the three-frame history and must not affect the averages.
+        double scale = i == 0 ? 100.0 : (double)i;
+        sampled.samples.push_back(makeSample("Skybox", 0, 1.0 * scale, 2.0 * scale));
+        sampled.samples.push_back(makeSample("Brightness \"map\"", 1, 0.5, i == 3 ? -1.0 : 0.25));
+        if (i != 2)
+        {
+            sampled.samples.push_back(makeSample("Present", 0, 4.0, -1.0));
+        }
+        aggregator.addFrame(sampled);
+    }
+    std::vector<ProfilePassStats> stats = aggregator.getPassStats();
+    passed &= check(aggregator.getFrames().size() == 3 && aggregator.getFrames().front().index == 1,
+                    "history keeps the newest frames");
+    passed &= check(stats.size() == 3 && stats[0].name == "Skybox" && stats[2].name == "Present",
+                    "passes are listed in the order of the newest frame");
+    passed &= check(stats[0].cpuAverageMs == 2.0 && stats[0].cpuMaxMs == 3.0 && stats[0].gpuAverageMs == 4.0 &&
+                    stats[0].gpuMaxMs == 6.0, "averages and maxima cover the history only");
+    passed &= check(stats[1].hasGpu && stats[1].gpuAverageMs == 0.25 && stats[1].depth == 1,
+                    "frames without GPU results do not dilute the GPU average");
+    passed &= check(!stats[2].hasGpu && stats[2].cpuAverageMs == 4.0, "a pass missing from a frame is skipped");
+
+    std::ostringstream trace;
+    aggregator.writeChromeTrace(trace);
+    std::string json = trace.str();
+    passed &= check(isBalancedJson(json) && json.find("{\"traceEvents\":[") == 0, "trace is well-formed");
+    passed &= check(countOccurrences(json, "\"ph\":\"X\"") == 3 + 8 + 5 &&
+                    countOccurrences(json, "\"cat\":\"gpu\"") == 5,
+                    "one event per frame and sample, plus one per GPU result");
+    passed &= check(json.find("Brightness \\\"map\\\"") != std::string::npos, "names are escaped");
+    passed &= check(json.find("\"ts\":48000.000,\"dur\":16000.000") != std::string::npos,
+                    "times are exported in microseconds");
+
+    std::cout << (passed ? "All profiler checks passed" : "Profiler checks failed") << std::endl;
+    return passed ? 0 : 1;
+}
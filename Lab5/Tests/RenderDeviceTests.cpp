@@ -0,0 +1,164 @@
+#include "TestSuites.h"
+
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+#include "TestUtils.h"
+#include "../Engine/SceneRenderer.h"
+#include "../Engine/RenderDevice/RecordingRenderDevice.h"
+#include "../Utils/ThreadPool.h"
+
+using TestUtils::check;
+using TestUtils::makeTestSphere;
+
+namespace
+{
+    uint32_t countCommands(const std::vector<RenderCommand>& commands, RenderCommandType type, const char* name)
+    {
+        uint32_t count = 0;
+        for (const RenderCommand& command : commands)
+        {
+            if (command.type == type && (!name || command.name == name))
+            {
+                count++;
+            }
+        }
+        return count;
+    }
+
+    struct RecordedFrame
+    {
+        std::vector<RenderCommand> commands;
+        RenderFrameCounters counters;
+        uint32_t overlayCalls = 0;
+    };
+
+    RecordedFrame recordSceneFrame(RecordingRenderDevice* device, SceneRenderer* scene, const SceneView& view,
+                                   RenderTexture backBuffer)
+    {
+        RecordedFrame frame;
+        device->beginFrame();
+        scene->drawFrame(view, backBuffer, [&]() { frame.overlayCalls++; });
+        device->endFrame();
+        frame.commands = device->getCommands();
+        frame.counters = device->getFrameCounters();
+        return frame;
+    }
+}
+
+// Drives SceneRenderer on the recording backend: IBL generation, the frame graph in both luminance reduction
+// modes, the compute shader fallback and resource cleanup, all without a GPU.
+int testRenderDevice()
+{
+    bool passed = true;
+
+    MeshData sphere = makeTestSphere(16, 24);
+    HDRImage image;
+    image.width = 64;
+    image.height = 32;
+    image.pixels.assign((size_t)image.width * image.height * 4, 1.0f);
+
+    SceneView view;
+    view.width = 320;
+    view.height = 240;
+    view.viewMatrix = RenderMath::translation(0.0f, 0.0f, 10.0f);
+    view.cameraPosition = RenderMath::makeFloat3(0.0f, 0.0f, -10.0f);
+
+    for (int failCompute = 0; failCompute < 2; failCompute++)
+    {
+        RecordingRenderDevice device;
+        if (failCompute)
+        {
+            device.failShaderStage(RENDER_STAGE_COMPUTE);
+        }
+        RenderTextureDesc backBufferDesc;
+        backBufferDesc.width = view.width;
+        backBufferDesc.height = view.height;
+        backBufferDesc.format = RENDER_FORMAT_R8G8B8A8_UNORM;
+        backBufferDesc.bindFlags = RENDER_BIND_RENDER_TARGET;
+        backBufferDesc.name = "Back buffer";
+        RenderTexture backBuffer = device.createTexture(backBufferDesc);
+
+        SceneRenderer::requestShaders(&device);
+        SceneRenderer scene(&device);
+        scene.initialize(view.width, view.height, sphere);
+        ThreadPool threadPool(2);
+        device.beginFrame();
+        scene.loadEnvironment("missing directory/", image, &threadPool);
+        device.endFrame();
+        const std::vector<RenderCommand>& bake = device.getCommands();
+        passed &= check(device.getFrameCounters().drawCalls == 6 + 30 &&
+                        countCommands(bake, RENDER_COMMAND_BEGIN_PASS, "Cubemap face") == 6 &&
+                        countCommands(bake, RENDER_COMMAND_BEGIN_PASS, "Prefiltered face") == 30,
+                        "the environment renders six cube faces and five prefiltered mips per face");
+
+        scene.setSphereGridSize(4);
+        std::vector<RecordedFrame> frames;
+        for (uint32_t i = 0; i < 6; i++)
+        {
+            frames.push_back(recordSceneFrame(&device, &scene, view, backBuffer));
+        }
+        const RecordedFrame& last = frames.back();
+        passed &= check(last.overlayCalls == 1 &&
+                        countCommands(last.commands, RENDER_COMMAND_BEGIN_PASS, "GUI") == 1,
+                        "the overlay runs once, inside the GUI pass");
+        passed &= check(frames[4].commands == last.commands && frames[4].counters == last.counters,
+                        "steady-state frames record the same work");
+        passed &= check(countCommands(last.commands, RENDER_COMMAND_DRAW_INDEXED, nullptr) == 2 &&
+                        last.counters.instances >= 16,
+                        "skybox and spheres take one draw each, the spheres instanced");
+
+        bool computeReduction = !failCompute;
+        uint32_t dispatches = countCommands(last.commands, RENDER_COMMAND_DISPATCH, nullptr);
+        uint32_t pyramidPasses = countCommands(last.commands, RENDER_COMMAND_BEGIN_PASS, "Brightness level");
+        passed &= check(computeReduction ? dispatches > 0 && pyramidPasses == 0
+                                         : dispatches == 0 && pyramidPasses > 0,
+                        failCompute ? "a compute shader failure falls back to the pyramid"
+                                    : "compute reduction replaces the pyramid passes");
+
+        scene.getToneMapper()->setReductionMode(LUMINANCE_REDUCTION_PYRAMID);
+        RecordedFrame pyramid = recordSceneFrame(&device, &scene, view, backBuffer);
+        passed &= check(countCommands(pyramid.commands, RENDER_COMMAND_DISPATCH, nullptr) == 0 &&
+                        countCommands(pyramid.commands, RENDER_COMMAND_BEGIN_PASS, "Brightness level") > 0,
+                        "pyramid mode reduces with pixel shader passes only");
+
+        SceneView turned = view;
+        turned.viewMatrix = RenderMath::translation(0.0f, 0.0f, -10.0f);
+        RecordedFrame culled = recordSceneFrame(&device, &scene, turned, backBuffer);
+        passed &= check(countCommands(culled.commands, RENDER_COMMAND_DRAW_INDEXED, nullptr) == 1 &&
+                        scene.getCullStats().visibleObjects == 0,
+                        "spheres behind the camera are culled and not drawn");
+
+        const std::vector<SphereLevel>& levels = scene.getSphereLevels();
+        scene.setLodErrorPixels(0.0f);
+        recordSceneFrame(&device, &scene, view, backBuffer);
+        bool finest = levels[0].instances.size() == 16;
+        scene.setLodErrorPixels(1e6f);
+        RecordedFrame coarse = recordSceneFrame(&device, &scene, view, backBuffer);
+        passed &= check(levels.size() > 1 && finest && levels.back().instances.size() == 16 &&
+                        countCommands(coarse.commands, RENDER_COMMAND_DRAW_INDEXED, nullptr) == 2,
+                        "the screen error bound picks the full mesh or the coarsest level");
+
+        bool threw = false;
+        try
+        {
+            scene.setSphereGridSize(SceneRenderer::MAX_SPHERE_GRID_SIZE + 1);
+        }
+        catch (const std::runtime_error&)
+        {
+            threw = true;
+        }
+        passed &= check(threw, "an oversized sphere grid is rejected");
+
+        scene.destroy();
+        device.destroyTexture(backBuffer);
+        const RenderResourceStats& stats = device.getResourceStats();
+        passed &= check(stats.textures == 0 && stats.buffers == 0 && stats.shaders == 0 && stats.samplers == 0 &&
+                        stats.readbacks == 0 && stats.textureBytes == 0 && stats.bufferBytes == 0,
+                        "destroy releases every resource");
+    }
+
+    std::cout << (passed ? "All render device checks passed" : "Render device checks failed") << std::endl;
+    return passed ? 0 : 1;
+}
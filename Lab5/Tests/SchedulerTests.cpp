@@ -0,0 +1,86 @@
+#include "TestSuites.h"
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "TestUtils.h"
+#include "../Utils/TaskBatch.h"
+#include "../Utils/ThreadPool.h"
+
+using TestUtils::check;
+
+// Drives TaskBatch, the scheduler behind ShaderLoader, with a stub compiler that sleeps instead of compiling.
+int testScheduler()
+{
+    const uint32_t threadCount = 4;
+    const auto compileTime = std::chrono::milliseconds(50);
+    std::atomic<uint32_t> compileCount{0};
+    std::atomic<uint32_t> inFlight{0};
+    std::atomic<uint32_t> maxInFlight{0};
+    auto stubCompiler = [&](const std::string& path)
+    {
+        compileCount++;
+        uint32_t running = ++inFlight;
+        uint32_t previous = maxInFlight.load();
+        while (running > previous && !maxInFlight.compare_exchange_weak(previous, running))
+        {
+        }
+        std::this_thread::sleep_for(compileTime);
+        inFlight--;
+        if (path == "broken.hlsl")
+        {
+            throw std::runtime_error("Failed to compile shader " + path);
+        }
+        return "bytecode of " + path;
+    };
+
+    const std::vector<std::string> paths = {
+        "a.hlsl", "b.hlsl", "c.hlsl", "d.hlsl", "e.hlsl", "f.hlsl", "g.hlsl", "h.hlsl"
+    };
+    bool passed = true;
+    ThreadPool threadPool(threadCount);
+    {
+        TaskBatch<std::string, std::string> batch(&threadPool, stubCompiler);
+        auto start = std::chrono::steady_clock::now();
+        std::vector<TaskBatch<std::string, std::string>::Handle> handles;
+        for (const auto& path : paths)
+        {
+            handles.push_back(batch.enqueue(path));
+        }
+        passed &= check(batch.enqueue("c.hlsl") == handles[2], "repeated request returns the same handle");
+
+        bool resultsMatch = true;
+        for (size_t i = paths.size(); i-- > 0;)
+        {
+            resultsMatch &= batch.get(handles[i]) == "bytecode of " + paths[i];
+        }
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        passed &= check(resultsMatch, "results collected in reverse order match their requests");
+        passed &= check(compileCount == paths.size(), "each distinct request compiles once");
+        passed &= check(maxInFlight > 1, "requests compile concurrently");
+        passed &= check(elapsed < compileTime * (long long)paths.size(), "batch finishes faster than in sequence");
+    }
+    {
+        TaskBatch<std::string, std::string> batch(&threadPool, stubCompiler);
+        auto broken = batch.enqueue("broken.hlsl");
+        auto working = batch.enqueue("a.hlsl");
+        bool threw = false;
+        try
+        {
+            batch.get(broken);
+        }
+        catch (const std::runtime_error&)
+        {
+            threw = true;
+        }
+        passed &= check(threw, "compile errors are rethrown to the caller");
+        passed &= check(batch.get(working) == "bytecode of a.hlsl", "a failed request does not affect others");
+    }
+    std::cout << (passed ? "All scheduler checks passed" : "Scheduler checks failed") << std::endl;
+    return passed ? 0 : 1;
+}
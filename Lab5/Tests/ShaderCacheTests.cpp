@@ -0,0 +1,95 @@
+#include "TestSuites.h"
+
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "TestUtils.h"
+#include "../DXShader/ShaderCache.h"
+#include "../Utils/HashUtils.h"
+
+using TestUtils::check;
+using TestUtils::writeFile;
+
+// Exercises the key and manifest rules the engine relies on, using plain files in place of the compiler. Works in
+// a directory of its own under the system temp directory, the only one it deletes.
+int testShaderCache()
+{
+    std::filesystem::path root = std::filesystem::temp_directory_path() / "shader-cache-test";
+    std::error_code error;
+    std::filesystem::remove_all(root, error);
+    std::filesystem::create_directories(root, error);
+    std::filesystem::path sourcePath = root / "shader.hlsl";
+    std::filesystem::path includePath = root / "common.hlsli";
+    if (!writeFile(sourcePath, "#include \"common.hlsli\"\nfloat4 main() : SV_Target { return value(); }\n") ||
+        !writeFile(includePath, "float4 value() { return 1; }\n"))
+    {
+        std::cerr << "Failed to write to " << root.string() << std::endl;
+        return 1;
+    }
+
+    ShaderCache cache((root / "cache").string());
+    ShaderCacheKey key;
+    key.sourcePath = sourcePath.generic_string();
+    key.entryPoint = "main";
+    key.profile = "ps_5_0";
+    key.flags = 0x1;
+
+    std::vector<ShaderDependency> dependencies(2);
+    dependencies[0].path = key.sourcePath;
+    dependencies[1].path = includePath.generic_string();
+    HashUtils::hashFile(dependencies[0].path, &dependencies[0].hash);
+    HashUtils::hashFile(dependencies[1].path, &dependencies[1].hash);
+    const std::string bytecode = "DXBC fake bytecode";
+
+    bool passed = true;
+    std::vector<char> loaded;
+    passed &= check(!cache.load(key, &loaded), "cold cache misses");
+    passed &= check(cache.store(key, dependencies, bytecode.data(), bytecode.size()), "entry is stored");
+    passed &= check(cache.load(key, &loaded) && std::string(loaded.begin(), loaded.end()) == bytecode,
+                    "warm cache returns the stored bytecode");
+
+    ShaderCacheKey otherKey = key;
+    otherKey.flags = 0x2;
+    passed &= check(cache.getEntryPath(otherKey) != cache.getEntryPath(key) && !cache.load(otherKey, &loaded),
+                    "different flags use a different entry");
+    otherKey = key;
+    otherKey.profile = "ps_5_1";
+    passed &= check(cache.getEntryPath(otherKey) != cache.getEntryPath(key) && !cache.load(otherKey, &loaded),
+                    "different profile uses a different entry");
+    otherKey = key;
+    otherKey.entryPoint = "mainAlt";
+    passed &= check(!cache.load(otherKey, &loaded), "different entry point misses");
+
+    writeFile(includePath, "float4 value() { return 2; }\n");
+    passed &= check(!cache.load(key, &loaded), "edited include invalidates the entry");
+    HashUtils::hashFile(dependencies[1].path, &dependencies[1].hash);
+    cache.store(key, dependencies, bytecode.data(), bytecode.size());
+    passed &= check(cache.load(key, &loaded), "restored entry hits again");
+
+    writeFile(sourcePath, "float4 main() : SV_Target { return 3; }\n");
+    passed &= check(!cache.load(key, &loaded), "edited source invalidates the entry");
+    HashUtils::hashFile(dependencies[0].path, &dependencies[0].hash);
+    cache.store(key, dependencies, bytecode.data(), bytecode.size());
+
+    std::filesystem::remove(includePath, error);
+    passed &= check(!cache.load(key, &loaded), "deleted include invalidates the entry");
+    writeFile(includePath, "float4 value() { return 2; }\n");
+    passed &= check(cache.load(key, &loaded), "recreated include with the same contents hits");
+
+    std::string entryPath = cache.getEntryPath(key);
+    std::filesystem::resize_file(entryPath, std::filesystem::file_size(entryPath) - 1, error);
+    passed &= check(!cache.load(key, &loaded), "truncated entry is rejected");
+    cache.store(key, dependencies, bytecode.data(), bytecode.size());
+    {
+        std::ofstream file(entryPath, std::ios::binary | std::ios::app);
+        file << "x";
+    }
+    passed &= check(!cache.load(key, &loaded), "entry with trailing data is rejected");
+
+    std::filesystem::remove_all(root, error);
+    std::cout << (passed ? "All shader cache checks passed" : "Shader cache checks failed") << std::endl;
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,221 @@
+#include "TestSuites.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "TestUtils.h"
+#include "../Engine/SceneRenderer.h"
+#include "../Engine/IBL/CubemapBaker.h"
+#include "../Engine/IBL/IBLCache.h"
+#include "../Engine/IBL/SphericalHarmonics.h"
+#include "../Engine/RenderDevice/SoftwareRenderDevice.h"
+#include "../Utils/HashUtils.h"
+#include "../Utils/ThreadPool.h"
+
+using TestUtils::check;
+using TestUtils::makeTestSphere;
+
+namespace
+{
+    // Renders one SceneRenderer frame on the software backend and returns the tone mapped RGBA8 image.
+    std::vector<uint8_t> renderSoftwareFrame(SoftwareRenderDevice* device, SceneRenderer* scene,
+                                             const SceneView& view, RenderTexture backBuffer,
+                                             SoftwareRasterStats* pStats)
+    {
+        device->beginFrame();
+        scene->drawFrame(view, backBuffer, []() {});
+        device->endFrame();
+        *pStats = device->getRasterStats();
+        const SoftwareTexture& texture = device->getTexture(backBuffer);
+        std::vector<uint8_t> pixels(RenderDevice::getTextureBytes(texture.getDesc()));
+        texture.download(0, 0, pixels.data());
+        return pixels;
+    }
+
+    std::vector<Float4> readSoftwareTexels(const SoftwareRenderDevice& device, RenderTexture texture)
+    {
+        const SoftwareTexture& source = device.getTexture(texture);
+        const Float4* texels = source.getTexels(0, 0);
+        return std::vector<Float4>(texels, texels + (size_t)source.getWidth(0) * source.getHeight(0));
+    }
+}
+
+// Runs the CPU backend: the fill rule on a full-screen quad, the ported luminance and tone map passes and a
+// whole SceneRenderer frame, which must not depend on the number of threads.
+int testSoftwareDevice()
+{
+    bool passed = true;
+
+    {
+        SoftwareRenderDevice device(3);
+        RenderTextureDesc sourceDesc;
+        sourceDesc.width = 4;
+        sourceDesc.height = 4;
+        sourceDesc.format = RENDER_FORMAT_R32_FLOAT;
+        sourceDesc.bindFlags = RENDER_BIND_SHADER_RESOURCE;
+        std::vector<float> sourceTexels(16, 0.75f);
+        const void* sourceData = sourceTexels.data();
+        RenderTexture source = device.createTexture(sourceDesc, &sourceData);
+        RenderTextureDesc targetDesc;
+        targetDesc.width = 37;
+        targetDesc.height = 23;
+        targetDesc.format = RENDER_FORMAT_R32_FLOAT;
+        targetDesc.bindFlags = RENDER_BIND_RENDER_TARGET | RENDER_BIND_SHADER_RESOURCE;
+        RenderTexture targets[3] = {
+            device.createTexture(targetDesc), device.createTexture(targetDesc), device.createTexture(targetDesc)
+        };
+
+        RenderShaderDesc vertexShaderDesc;
+        vertexShaderDesc.path = L"Shaders/ToneMap/mappingVS.hlsl";
+        RenderShaderDesc pixelShaderDesc;
+        pixelShaderDesc.stage = RENDER_STAGE_PIXEL;
+        pixelShaderDesc.path = L"Shaders/ToneMap/downsamplePS.hlsl";
+        RenderPipelineDesc pipeline;
+        pipeline.vertexShader = device.createShader(vertexShaderDesc);
+        pipeline.pixelShader = device.createShader(pixelShaderDesc);
+        RenderSampler sampler = device.createSampler(RENDER_FILTER_LINEAR, RENDER_ADDRESS_CLAMP);
+        const RenderTexture sources[3] = {source, source, source};
+        const RenderSampler samplers[3] = {sampler, sampler, sampler};
+
+        device.beginFrame();
+        RenderPassDesc pass;
+        pass.colorCount = 3;
+        for (uint32_t i = 0; i < 3; i++)
+        {
+            pass.colors[i].texture = targets[i];
+        }
+        pass.clearColor = true;
+        device.beginPass(pass);
+        device.setPipeline(pipeline);
+        device.setTextures(RENDER_STAGE_PIXEL, 0, 3, sources);
+        device.setSamplers(RENDER_STAGE_PIXEL, 0, 3, samplers);
+        device.draw(6);
+        device.endPass();
+        device.endFrame();
+
+        bool covered = true;
+        for (RenderTexture target : targets)
+        {
+            const SoftwareTexture& texture = device.getTexture(target);
+            for (uint32_t i = 0; i < targetDesc.width * targetDesc.height; i++)
+            {
+                covered &= texture.getTexels(0, 0)[i].x == 0.75f;
+            }
+        }
+        passed &= check(covered, "a full-screen quad covers every pixel of every render target");
+        passed &= check(device.getRasterStats().shadedPixels == targetDesc.width * targetDesc.height,
+                        "the shared diagonal is shaded exactly once");
+
+        bool threw = false;
+        try
+        {
+            RenderShaderDesc missing;
+            missing.path = L"Shaders/Missing.hlsl";
+            device.createShader(missing);
+        }
+        catch (const std::runtime_error&)
+        {
+            threw = true;
+        }
+        passed &= check(threw, "a program without a port is rejected");
+    }
+
+    MeshData sphere = makeTestSphere(16, 24);
+    // The prefilter port takes 1024 samples per texel at 128x128, far too slow for a test, so the environment
+    // comes from a small IBL cache baked on the CPU, the way IBLBaker output is picked up.
+    const uint32_t environmentWidth = 32;
+    const uint32_t environmentHeight = 16;
+    std::vector<float> environment;
+    for (uint32_t y = 0; y < environmentHeight; y++)
+    {
+        for (uint32_t x = 0; x < environmentWidth; x++)
+        {
+            float sky = 4.0f * (1.0f - (float)y / environmentHeight);
+            const float texel[4] = {sky, sky * 0.8f + 0.2f, 0.5f + (float)x / environmentWidth, 1.0f};
+            environment.insert(environment.end(), texel, texel + 4);
+        }
+    }
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / "software-device-test";
+    std::filesystem::create_directories(directory);
+    std::string hdrPath = (directory / "environment.hdr").string();
+    std::ofstream(hdrPath, std::ios::binary) << "test environment";
+    uint64_t sourceHash = 0;
+    HashUtils::hashFile(hdrPath, &sourceHash);
+    ThreadPool threadPool(2);
+    CubemapBaker baker(&threadPool);
+    IBLBakeData bake;
+    baker.convertEquirectangular(environment.data(), environmentWidth, environmentHeight, environmentHeight,
+                                 &bake.cubemap);
+    baker.generateMips(&bake.cubemap);
+    bake.irradianceSH = SphericalHarmonics::projectCubemap(bake.cubemap, 0, &threadPool);
+    baker.renderIrradiance(bake.cubemap, 4, &bake.irradiance);
+    baker.renderPrefiltered(bake.cubemap, 16, {0.0f, 0.25f, 0.5f, 0.75f, 1.0f}, &bake.prefiltered);
+    IBLCacheData packed;
+    IBLCache::pack(bake, RENDER_FORMAT_R32G32B32A32_FLOAT, BC6H_QUALITY_FAST, nullptr, &packed);
+    passed &= check(IBLCache::write((directory / IBLCache::getCachePath("environment.hdr")).string(),
+                                    sourceHash, packed), "the test environment is baked");
+
+    SceneView view;
+    view.width = 61;
+    view.height = 45;
+    view.viewMatrix = RenderMath::translation(0.0f, 0.0f, 10.0f);
+    view.cameraPosition = RenderMath::makeFloat3(0.0f, 0.0f, -10.0f);
+
+    SoftwareRenderDevice device(4);
+    RenderTextureDesc backBufferDesc;
+    backBufferDesc.width = view.width;
+    backBufferDesc.height = view.height;
+    backBufferDesc.format = RENDER_FORMAT_R8G8B8A8_UNORM;
+    backBufferDesc.bindFlags = RENDER_BIND_RENDER_TARGET;
+    RenderTexture backBuffer = device.createTexture(backBufferDesc);
+    SceneRenderer::requestShaders(&device);
+    SceneRenderer scene(&device);
+    scene.initialize(view.width, view.height, sphere);
+    device.beginFrame();
+    scene.loadEnvironment(directory.string() + "/", "environment.hdr");
+    device.endFrame();
+
+    SoftwareRasterStats serialStats;
+    SoftwareRasterStats parallelStats;
+    device.setThreadCount(1);
+    std::vector<uint8_t> serial = renderSoftwareFrame(&device, &scene, view, backBuffer, &serialStats);
+    std::vector<Float4> serialScene = readSoftwareTexels(device, scene.getToneMapper()->getHdrTarget());
+    device.setThreadCount(3);
+    renderSoftwareFrame(&device, &scene, view, backBuffer, &parallelStats);
+    std::vector<Float4> parallelScene = readSoftwareTexels(device, scene.getToneMapper()->getHdrTarget());
+    // Exposure adapts with wall-clock time, so the comparison uses the HDR scene rather than the back buffer.
+    passed &= check(memcmp(serialScene.data(), parallelScene.data(), serialScene.size() * sizeof(Float4)) == 0 &&
+                    serialStats.shadedPixels == parallelStats.shadedPixels,
+                    "the HDR scene is identical on one and on three threads");
+    bool finite = true;
+    for (const Float4& texel : serialScene)
+    {
+        finite &= std::isfinite(texel.x) && std::isfinite(texel.y) && std::isfinite(texel.z);
+    }
+    passed &= check(finite, "every HDR scene texel is finite");
+    passed &= check(serialStats.triangles > serialStats.rasterizedTriangles &&
+                    serialStats.rasterizedTriangles > 0, "back faces of the sphere are culled");
+
+    // The sphere and the sky can tone map to the same colour; in the HDR scene the sky writes an alpha of 10.
+    uint32_t centre = (view.height / 2) * view.width + view.width / 2;
+    passed &= check(serialScene[centre].w == 1.0f && serialScene[0].w == 10.0f && serial[centre * 4 + 3] == 255,
+                    "the sphere covers the centre of the image");
+
+    SoftwareRasterStats pyramidStats;
+    scene.getToneMapper()->setReductionMode(LUMINANCE_REDUCTION_PYRAMID);
+    renderSoftwareFrame(&device, &scene, view, backBuffer, &pyramidStats);
+    passed &= check(pyramidStats.shadedPixels > serialStats.shadedPixels,
+                    "the pyramid reduction renders through pixel shader passes");
+
+    scene.destroy();
+    device.destroyTexture(backBuffer);
+    std::filesystem::remove_all(directory);
+
+    std::cout << (passed ? "All software device checks passed" : "Software device checks failed") << std::endl;
+    return passed ? 0 : 1;
+}
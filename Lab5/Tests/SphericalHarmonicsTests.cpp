@@ -0,0 +1,174 @@
+#include "TestSuites.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "TestUtils.h"
+#include "../Engine/IBL/CubemapBaker.h"
+#include "../Engine/IBL/SphericalHarmonics.h"
+#include "../Utils/ThreadPool.h"
+
+using TestUtils::check;
+
+namespace
+{
+    const uint32_t ENVIRONMENT_WIDTH = 256;
+    const uint32_t ENVIRONMENT_HEIGHT = 128;
+    const uint32_t CUBE_SIZE = 64;
+    const uint32_t IRRADIANCE_SIZE = 16;
+    const float SH_MAX_MEAN_ERROR = 0.05f;
+    const float SUN_MAX_MEAN_ERROR = 0.15f;
+
+    // Equirectangular environment whose radiance depends only on the angle to +Y, the top row of the image.
+    std::vector<float> makeEnvironment(const IBLMath::Vec3& color, float (*getRadiance)(float cosine))
+    {
+        std::vector<float> pixels((size_t)ENVIRONMENT_WIDTH * ENVIRONMENT_HEIGHT * 4);
+        for (uint32_t y = 0; y < ENVIRONMENT_HEIGHT; y++)
+        {
+            float radiance = getRadiance(cosf(IBLMath::PI * (y + 0.5f) / ENVIRONMENT_HEIGHT));
+            for (uint32_t x = 0; x < ENVIRONMENT_WIDTH; x++)
+            {
+                float* pixel = &pixels[((size_t)y * ENVIRONMENT_WIDTH + x) * 4];
+                pixel[0] = color.x * radiance;
+                pixel[1] = color.y * radiance;
+                pixel[2] = color.z * radiance;
+                pixel[3] = 1.0f;
+            }
+        }
+        return pixels;
+    }
+
+    float getConstant(float)
+    {
+        return 1.0f;
+    }
+
+    float getClampedCosine(float cosine)
+    {
+        return std::max(cosine, 0.0f);
+    }
+
+    // A small bright disc around +Y, about 8 degrees across at half power.
+    float getSun(float cosine)
+    {
+        return 50.0f * powf(std::max(cosine, 0.0f), 256.0f);
+    }
+
+    // Mean and largest distance of the SH irradiance from the brute-force cube, relative to the mean irradiance.
+    void measureError(const SHIrradiance& irradiance, const CpuCubemap& reference, float* pMeanError,
+                      float* pMaxError)
+    {
+        uint32_t size = reference.getMipSize(0);
+        double referenceSum = 0.0;
+        double errorSum = 0.0;
+        float maxError = 0.0f;
+        for (uint32_t face = 0; face < 6; face++)
+        {
+            const float* texels = reference.getTexels(face, 0);
+            for (uint32_t y = 0; y < size; y++)
+            {
+                for (uint32_t x = 0; x < size; x++)
+                {
+                    IBLMath::Vec3 normal = IBLMath::normalize(IBLMath::cubeFaceDirection(
+                        face, 2.0f * (x + 0.5f) / size - 1.0f, 2.0f * (y + 0.5f) / size - 1.0f));
+                    const float* texel = texels + ((size_t)y * size + x) * 4;
+                    IBLMath::Vec3 expected(texel[0], texel[1], texel[2]);
+                    IBLMath::Vec3 difference = SphericalHarmonics::evaluate(irradiance, normal) - expected;
+                    float error = sqrtf(IBLMath::dot(difference, difference));
+                    referenceSum += sqrtf(IBLMath::dot(expected, expected));
+                    errorSum += error;
+                    maxError = std::max(maxError, error);
+                }
+            }
+        }
+        double referenceMean = referenceSum / (6.0 * size * size);
+        *pMeanError = (float)(errorSum / (6.0 * size * size) / referenceMean);
+        *pMaxError = (float)(maxError / referenceMean);
+    }
+
+    bool isNear(const IBLMath::Vec3& value, const IBLMath::Vec3& expected, float tolerance)
+    {
+        IBLMath::Vec3 difference = value - expected;
+        return sqrtf(IBLMath::dot(difference, difference)) <= tolerance * sqrtf(IBLMath::dot(expected, expected));
+    }
+
+    struct BakedEnvironment
+    {
+        SHIrradiance cubeSH;
+        SHIrradiance equirectangularSH;
+        CpuCubemap irradiance;
+    };
+
+    // Both SH projections the baker has, next to the brute-force convolution they stand in for.
+    BakedEnvironment bake(const std::vector<float>& pixels, ThreadPool* threadPool)
+    {
+        CubemapBaker baker(threadPool);
+        CpuCubemap cubemap;
+        baker.convertEquirectangular(pixels.data(), ENVIRONMENT_WIDTH, ENVIRONMENT_HEIGHT, CUBE_SIZE, &cubemap);
+        baker.generateMips(&cubemap);
+        BakedEnvironment result;
+        result.cubeSH = SphericalHarmonics::projectCubemap(cubemap, 0, threadPool);
+        result.equirectangularSH = SphericalHarmonics::projectEquirectangular(pixels.data(), ENVIRONMENT_WIDTH,
+                                                                             ENVIRONMENT_HEIGHT, threadPool);
+        baker.renderIrradiance(cubemap, IRRADIANCE_SIZE, &result.irradiance);
+        return result;
+    }
+
+    bool checkAgainstBruteForce(const BakedEnvironment& baked, float maxMeanError, const char* name)
+    {
+        float cubeMeanError, cubeMaxError, equirectangularMeanError, equirectangularMaxError;
+        measureError(baked.cubeSH, baked.irradiance, &cubeMeanError, &cubeMaxError);
+        measureError(baked.equirectangularSH, baked.irradiance, &equirectangularMeanError, &equirectangularMaxError);
+        std::cout << "     " << name << ": cube projection mean " << cubeMeanError * 100.0f << "%, max "
+            << cubeMaxError * 100.0f << "%; equirectangular projection mean " << equirectangularMeanError * 100.0f
+            << "%, max " << equirectangularMaxError * 100.0f << "%" << std::endl;
+        return check(cubeMeanError <= maxMeanError && equirectangularMeanError <= maxMeanError,
+                     (std::string(name) + ": SH irradiance matches the brute-force convolution").c_str());
+    }
+}
+
+// Projects synthetic environments to SH and compares the result with the brute-force irradiance cube, and with the
+// closed forms where the environment has one.
+int testSphericalHarmonics()
+{
+    bool passed = true;
+    ThreadPool threadPool(0);
+    const IBLMath::Vec3 up(0.0f, 1.0f, 0.0f);
+    const IBLMath::Vec3 down(0.0f, -1.0f, 0.0f);
+    const IBLMath::Vec3 side(1.0f, 0.0f, 0.0f);
+
+    // A constant sky of radiance L gives an irradiance of L everywhere once divided by PI.
+    const IBLMath::Vec3 skyColor(0.4f, 0.6f, 1.0f);
+    BakedEnvironment constant = bake(makeEnvironment(skyColor, getConstant), &threadPool);
+    bool flat = true;
+    for (const IBLMath::Vec3& normal : {up, down, side, IBLMath::normalize(IBLMath::Vec3(1.0f, -2.0f, 3.0f))})
+    {
+        flat &= isNear(SphericalHarmonics::evaluate(constant.cubeSH, normal), skyColor, 0.01f);
+        flat &= isNear(SphericalHarmonics::evaluate(constant.equirectangularSH, normal), skyColor, 0.01f);
+    }
+    passed &= check(flat, "a constant sky gives its own radiance as irradiance in every direction");
+    float meanError, maxError;
+    measureError(constant.cubeSH, constant.irradiance, &meanError, &maxError);
+    passed &= check(maxError <= 0.01f, "the brute-force cube of a constant sky is flat too");
+
+    // Radiance L * max(cos, 0) about +Y: a normal facing it collects L * 2 / 3, one facing away nothing.
+    BakedEnvironment lobe = bake(makeEnvironment(skyColor, getClampedCosine), &threadPool);
+    passed &= check(isNear(SphericalHarmonics::evaluate(lobe.cubeSH, up), skyColor * (2.0f / 3.0f), 0.02f) &&
+                        isNear(SphericalHarmonics::evaluate(lobe.equirectangularSH, up), skyColor * (2.0f / 3.0f),
+                               0.02f),
+                    "a cosine lobe gives two thirds of its peak facing it");
+    IBLMath::Vec3 away = SphericalHarmonics::evaluate(lobe.cubeSH, down);
+    passed &= check(sqrtf(IBLMath::dot(away, away)) <= 0.05f * sqrtf(IBLMath::dot(skyColor, skyColor)),
+                    "and close to nothing facing away");
+    passed &= checkAgainstBruteForce(lobe, SH_MAX_MEAN_ERROR, "cosine lobe");
+
+    // A sun is the worst case for nine coefficients: the clamped cosine it casts comes out about 11% off on
+    // average, which bounds how far a real environment with a sharp light can drift.
+    BakedEnvironment sun = bake(makeEnvironment(IBLMath::Vec3(1.0f, 0.9f, 0.8f), getSun), &threadPool);
+    passed &= checkAgainstBruteForce(sun, SUN_MAX_MEAN_ERROR, "sun");
+
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,143 @@
+#include "TestSuites.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "TestUtils.h"
+#include "../DXDevice/StateCache.h"
+
+using TestUtils::check;
+
+namespace
+{
+    struct MockObject
+    {
+        const char* name;
+    };
+
+    enum MockTopology
+    {
+        MOCK_TOPOLOGY_LINE_LIST = 2,
+        MOCK_TOPOLOGY_TRIANGLE_LIST = 4
+    };
+
+    // Stands in for ID3D11DeviceContext and records every call that reaches it.
+    struct MockContext
+    {
+        std::vector<std::string> calls;
+
+        void VSSetShader(MockObject* shader, void**, uint32_t) { record("VS", shader); }
+        void PSSetShader(MockObject* shader, void**, uint32_t) { record("PS", shader); }
+        void CSSetShader(MockObject* shader, void**, uint32_t) { record("CS", shader); }
+        void IASetInputLayout(MockObject* layout) { record("IL", layout); }
+        void IASetPrimitiveTopology(MockTopology topology) { calls.push_back("TOPO " + std::to_string(topology)); }
+        void OMSetDepthStencilState(MockObject* state, uint32_t) { record("DS", state); }
+        void RSSetState(MockObject* state) { record("RS", state); }
+        void OMSetBlendState(MockObject* state, const float*, uint32_t) { record("BS", state); }
+        void VSSetSamplers(uint32_t start, uint32_t count, MockObject* const*) { recordRange("VSS", start, count); }
+        void PSSetSamplers(uint32_t start, uint32_t count, MockObject* const*) { recordRange("PSS", start, count); }
+        void CSSetSamplers(uint32_t start, uint32_t count, MockObject* const*) { recordRange("CSS", start, count); }
+
+        void record(const char* call, MockObject* object)
+        {
+            calls.push_back(std::string(call) + " " + (object ? object->name : "null"));
+        }
+
+        void recordRange(const char* call, uint32_t start, uint32_t count)
+        {
+            calls.push_back(std::string(call) + " " + std::to_string(start) + "+" + std::to_string(count));
+        }
+
+        std::string take()
+        {
+            std::string joined;
+            for (const auto& call : calls)
+            {
+                joined += (joined.empty() ? "" : ", ") + call;
+            }
+            calls.clear();
+            return joined;
+        }
+    };
+}
+
+// Drives StateCache, the filter in front of the D3D11 context, against a recording mock.
+int testStateCache()
+{
+    MockObject shaderA{"A"};
+    MockObject shaderB{"B"};
+    MockObject samplerAvg{"avg"};
+    MockObject samplerMin{"min"};
+    MockObject samplerMax{"max"};
+    MockObject state{"state"};
+    MockObject* none = nullptr;
+    MockContext context;
+    StateCache<MockContext> cache(&context);
+    bool passed = true;
+
+    cache.setVertexShader(none);
+    passed &= check(context.take() == "VS null", "unknown state is never assumed to be null");
+    cache.setVertexShader(&shaderA);
+    cache.setVertexShader(&shaderA);
+    cache.setPixelShader(&shaderA);
+    passed &= check(context.take() == "VS A, PS A", "repeated shader is dropped, other stages are separate");
+    cache.setPrimitiveTopology(MOCK_TOPOLOGY_TRIANGLE_LIST);
+    cache.setPrimitiveTopology(MOCK_TOPOLOGY_TRIANGLE_LIST);
+    cache.setPrimitiveTopology(MOCK_TOPOLOGY_LINE_LIST);
+    passed &= check(context.take() == "TOPO 4, TOPO 2", "topology changes are forwarded once");
+
+    cache.setDepthStencilState(&state, 1);
+    cache.setDepthStencilState(&state, 1);
+    cache.setDepthStencilState(&state, 0);
+    passed &= check(context.take() == "DS state, DS state", "stencil reference is part of the depth state");
+    const float ones[4] = {1.0f, 1.0f, 1.0f, 1.0f};
+    const float half[4] = {0.5f, 0.5f, 0.5f, 0.5f};
+    cache.setBlendState(none, nullptr, 0xFFFFFFFF);
+    cache.setBlendState(none, ones, 0xFFFFFFFF);
+    cache.setBlendState(none, half, 0xFFFFFFFF);
+    cache.setBlendState(none, half, 0x0000FFFF);
+    passed &= check(context.take() == "BS null, BS null, BS null",
+                    "null blend factor matches ones; factor and mask changes are forwarded");
+
+    MockObject* samplers[] = {&samplerAvg, &samplerMin, &samplerMax};
+    cache.setPixelSamplers(0, 3, samplers);
+    samplers[1] = &samplerAvg;
+    cache.setPixelSamplers(0, 3, samplers);
+    cache.setPixelSamplers(0, 3, samplers);
+    cache.setPixelSamplers(2, 1, samplers);
+    cache.setVertexSamplers(0, 1, samplers);
+    passed &= check(context.take() == "PSS 0+3, PSS 1+1, PSS 2+1, VSS 0+1",
+                    "sampler calls shrink to the changed slot range per stage");
+
+    cache.invalidate();
+    cache.setRasterizerState(none);
+    cache.setPixelShader(&shaderA);
+    passed &= check(context.take() == "RS null, PS A", "invalidate forces the next calls through");
+
+    // Two frames of the tone mapper's 11 pyramid passes: only the first pass and the shader switch get through.
+    MockObject* pyramidSamplers[] = {&samplerAvg, &samplerMin, &samplerMax};
+    for (uint32_t frame = 0; frame < 2; frame++)
+    {
+        cache.beginFrame();
+        cache.invalidate();
+        for (uint32_t pass = 0; pass < 11; pass++)
+        {
+            cache.setPixelSamplers(0, 3, pyramidSamplers);
+            cache.setDepthStencilState(none, 0);
+            cache.setRasterizerState(none);
+            cache.setBlendState(none, nullptr, 0xFFFFFFFF);
+            cache.setInputLayout(none);
+            cache.setPrimitiveTopology(MOCK_TOPOLOGY_TRIANGLE_LIST);
+            cache.setVertexShader(&shaderA);
+            cache.setPixelShader(pass == 0 ? &shaderB : &shaderA);
+        }
+    }
+    cache.beginFrame();
+    StateCacheStats stats = cache.getFrameStats();
+    context.take();
+    passed &= check(stats.issued == 9 && stats.skipped == 79, "per-frame counts of issued and skipped calls");
+
+    std::cout << (passed ? "All state cache checks passed" : "State cache checks failed") << std::endl;
+    return passed ? 0 : 1;
+}
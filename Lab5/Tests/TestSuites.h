@@ -0,0 +1,25 @@
+#pragma once
+
+// One suite per subsystem, each in its own file. A suite prints one line per check and returns 0 when all of them
+// pass.
+int testMeshBuilder();
+int testSphericalHarmonics();
+int testBRDFLut();
+int testLuminance();
+int testShaderCache();
+int testScheduler();
+int testConstantRing();
+int testStateCache();
+int testFrameGraph();
+int testMemory();
+int testProfiler();
+int testRenderDevice();
+int testSoftwareDevice();
+int testHDRContainer();
+int testHDRDecoder();
+int testBC6H();
+int testLightClusters();
+int testCulling();
+int testMeshLOD();
+int testMeshOptimizer();
+int testVertexEncoding();
@@ -0,0 +1,68 @@
+#include "TestUtils.h"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#include "../Engine/RenderDevice/RenderMath.h"
+
+namespace TestUtils
+{
+    bool check(bool condition, const char* description)
+    {
+        std::cout << (condition ? "ok   " : "FAIL ") << description << std::endl;
+        return condition;
+    }
+
+    bool writeFile(const std::filesystem::path& path, const std::string& contents)
+    {
+        std::ofstream file(path, std::ios::binary);
+        file << contents;
+        return (bool)file;
+    }
+
+    MeshData makeTestSphere(uint32_t rings, uint32_t segments)
+    {
+        MeshData sphere;
+        for (uint32_t ring = 0; ring <= rings; ring++)
+        {
+            float theta = RenderMath::PI * ring / rings;
+            for (uint32_t segment = 0; segment <= segments; segment++)
+            {
+                float phi = 2.0f * RenderMath::PI * segment / segments;
+                MeshVertex vertex{};
+                vertex.position[0] = sinf(theta) * cosf(phi);
+                vertex.position[1] = cosf(theta);
+                vertex.position[2] = sinf(theta) * sinf(phi);
+                memcpy(vertex.normal, vertex.position, sizeof(vertex.normal));
+                vertex.uv[0] = (float)segment / segments;
+                vertex.uv[1] = (float)ring / rings;
+                vertex.color[0] = vertex.color[1] = vertex.color[2] = 1.0f;
+                sphere.vertices.push_back(vertex);
+            }
+        }
+        for (uint32_t ring = 0; ring < rings; ring++)
+        {
+            for (uint32_t segment = 0; segment < segments; segment++)
+            {
+                uint32_t a = ring * (segments + 1) + segment;
+                uint32_t b = a + segments + 1;
+                const uint32_t quad[2][3] = {{a, b, a + 1}, {a + 1, b, b + 1}};
+                for (const uint32_t* triangle : quad)
+                {
+                    const float* p0 = sphere.vertices[triangle[0]].position;
+                    const float* p1 = sphere.vertices[triangle[1]].position;
+                    const float* p2 = sphere.vertices[triangle[2]].position;
+                    Float3 normal = RenderMath::cross(
+                        RenderMath::makeFloat3(p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]),
+                        RenderMath::makeFloat3(p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]));
+                    bool outward = RenderMath::dot(normal, RenderMath::makeFloat3(p0[0], p0[1], p0[2])) > 0.0f;
+                    sphere.indices.push_back(triangle[0]);
+                    sphere.indices.push_back(outward ? triangle[1] : triangle[2]);
+                    sphere.indices.push_back(outward ? triangle[2] : triangle[1]);
+                }
+            }
+        }
+        return sphere;
+    }
+}
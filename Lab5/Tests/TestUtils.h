@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+#include "../Engine/Mesh/MeshBuilder.h"
+
+// Shared by the suites in this directory.
+namespace TestUtils
+{
+    // Prints one check as "ok" or "FAIL" with its description and returns the condition.
+    bool check(bool condition, const char* description);
+    bool writeFile(const std::filesystem::path& path, const std::string& contents);
+    // Outward-facing UV sphere, wound clockwise when seen from outside like the meshes the renderer loads.
+    MeshData makeTestSphere(uint32_t rings, uint32_t segments);
+}
@@ -0,0 +1,101 @@
+#include "TestSuites.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <random>
+
+#include "TestUtils.h"
+#include "../Engine/Mesh/MeshEncoder.h"
+
+using TestUtils::check;
+using TestUtils::makeTestSphere;
+
+int testVertexEncoding()
+{
+    bool passed = true;
+
+    std::mt19937 random(11);
+    std::normal_distribution<float> gaussian;
+    float worstDegrees = 0.0f;
+    for (int i = 0; i < 10000; i++)
+    {
+        float normal[3] = {gaussian(random), gaussian(random), gaussian(random)};
+        // Axes and octant borders, where the octahedron folds.
+        if (i < 6)
+        {
+            normal[0] = normal[1] = normal[2] = 0.0f;
+            normal[i / 2] = i % 2 ? -1.0f : 1.0f;
+        }
+        int16_t encoded[2];
+        MeshEncoder::encodeOctahedral(normal, encoded);
+        float decoded[3];
+        MeshEncoder::decodeOctahedral(encoded, decoded);
+        // atan2 rather than acos, which cannot resolve angles this small.
+        Float3 a = RenderMath::makeFloat3(normal[0], normal[1], normal[2]);
+        Float3 b = RenderMath::makeFloat3(decoded[0], decoded[1], decoded[2]);
+        Float3 cross = RenderMath::cross(a, b);
+        float degrees = atan2f(sqrtf(RenderMath::dot(cross, cross)), RenderMath::dot(a, b)) * 180.0f /
+                        RenderMath::PI;
+        worstDegrees = std::max(worstDegrees, degrees);
+    }
+    std::cout << "Octahedral normals: worst error " << worstDegrees << " degrees" << std::endl;
+    passed &= check(worstDegrees < 0.01f, "16-bit octahedral normals stay within a hundredth of a degree");
+
+    VertexEncodingSettings settings;
+    MeshData sphere = makeTestSphere(16, 24);
+    VertexEncoding encoding = MeshEncoder::chooseEncoding(sphere, settings);
+    EncodedMesh encoded = MeshEncoder::encode(sphere, encoding);
+    const VertexEncodingStats& stats = encoded.stats;
+    std::cout << "Unit sphere: " << stats.sourceBytesPerVertex << " -> " << stats.bytesPerVertex
+        << " bytes per vertex, position error " << stats.positionError << ", UV error " << stats.uvError
+        << ", normal error " << stats.normalErrorDegrees << " degrees" << std::endl;
+    passed &= check(encoding.position == VERTEX_POSITION_SNORM16 && encoding.uv == VERTEX_UV_HALF &&
+                    encoded.stride == 16 && encoded.vertices.size() == sphere.vertices.size() * 16,
+                    "a unit sphere packs into 16 bytes per vertex");
+    passed &= check(stats.positionError <= settings.maxPositionError && stats.uvError <= settings.maxUVError &&
+                    stats.normalErrorDegrees < 0.01f && stats.colorError == 0.0f,
+                    "the packed sphere stays within the error bounds");
+    uint32_t attributeBytes = 0;
+    for (const RenderVertexAttribute& attribute : MeshEncoder::getAttributes(encoding))
+    {
+        attributeBytes += RenderDevice::getBytesPerPixel(attribute.format);
+    }
+    passed &= check(attributeBytes == encoded.stride, "the input layout covers the whole vertex");
+
+    MeshData large = sphere;
+    for (MeshVertex& vertex : large.vertices)
+    {
+        for (int axis = 0; axis < 3; axis++)
+        {
+            vertex.position[axis] *= 1000.0f;
+        }
+    }
+    VertexEncoding largeEncoding = MeshEncoder::chooseEncoding(large, settings);
+    passed &= check(largeEncoding.position == VERTEX_POSITION_FLOAT && MeshEncoder::getStride(largeEncoding) == 20,
+                    "a mesh too large for 16-bit positions keeps float positions");
+    EncodedMesh largeEncoded = MeshEncoder::encode(large, largeEncoding);
+    passed &= check(largeEncoded.stats.positionError == 0.0f, "float positions come back unchanged");
+
+    MeshData tiled = sphere;
+    for (MeshVertex& vertex : tiled.vertices)
+    {
+        vertex.uv[0] += 100.0f;
+    }
+    VertexEncoding tiledEncoding = MeshEncoder::chooseEncoding(tiled, settings);
+    passed &= check(tiledEncoding.position == VERTEX_POSITION_SNORM16 && tiledEncoding.uv == VERTEX_UV_FLOAT,
+                    "UVs too far from the origin for half floats stay float");
+
+    MeshData tinted = sphere;
+    tinted.vertices[0].color[0] = 0.5f;
+    passed &= check(MeshEncoder::encode(tinted, encoding).stats.colorError == 0.5f,
+                    "vertex colors that differ from the mesh color are reported");
+
+    MeshData empty;
+    EncodedMesh emptyEncoded = MeshEncoder::encode(empty, MeshEncoder::chooseEncoding(empty, settings));
+    passed &= check(emptyEncoded.vertices.empty() && emptyEncoded.positionDequant.w == 1.0f,
+                    "an empty mesh encodes to nothing");
+
+    std::cout << (passed ? "All vertex encoding checks passed" : "Vertex encoding checks failed") << std::endl;
+    return passed ? 0 : 1;
+}
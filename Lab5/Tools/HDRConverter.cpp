@@ -0,0 +1,391 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../Engine/IBL/HDRContainer.h"
+#include "../Engine/IBL/HDRDecoder.h"
+#include "../Engine/IBL/SphericalHarmonics.h"
+#include "../STB/stb_image.h"
+#include "../Utils/HalfFloat.h"
+#include "../Utils/HashUtils.h"
+#include "../Utils/SharedExponent.h"
+#include "../Utils/ThreadPool.h"
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    double elapsedMs(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    const float MAX_MEAN_ERROR = 0.01f;
+    const uint32_t PAGE_SIZE = 4096;
+    const uint32_t DECODE_RUNS = 3;
+
+    void printUsage()
+    {
+        std::cout << "Usage: HDRConverter <input.hdr> [output.hdrc] [--format rgba16f|rgb9e5] [--threads N]"
+            << " [--benchmark]" << std::endl;
+        std::cout << "       HDRConverter --verify-decoder <input.hdr>... [--threads N]" << std::endl;
+    }
+
+    bool parseFormat(const char* name, RenderFormat* pFormat)
+    {
+        if (!strcmp(name, "rgba16f"))
+        {
+            *pFormat = RENDER_FORMAT_R16G16B16A16_FLOAT;
+            return true;
+        }
+        if (!strcmp(name, "rgb9e5"))
+        {
+            *pFormat = RENDER_FORMAT_R9G9B9E5_SHAREDEXP;
+            return true;
+        }
+        return false;
+    }
+
+    void decodeTexel(RenderFormat format, const uint8_t* texel, float* pRgbOut)
+    {
+        if (format == RENDER_FORMAT_R16G16B16A16_FLOAT)
+        {
+            uint16_t halves[3];
+            memcpy(halves, texel, sizeof(halves));
+            for (uint32_t c = 0; c < 3; c++)
+            {
+                pRgbOut[c] = HalfFloat::toFloat(halves[c]);
+            }
+            return;
+        }
+        uint32_t packed;
+        memcpy(&packed, texel, sizeof(packed));
+        SharedExponent::toFloat3(packed, pRgbOut);
+    }
+
+    // Error of the stored texels relative to the mean source value, so dark texels do not dominate.
+    float measureMeanError(const HDRContainer& container, const float* pixels)
+    {
+        const HDRContainerHeader& header = container.getHeader();
+        uint32_t texelBytes = HDRContainer::getBytesPerTexel(container.getFormat());
+        const uint8_t* texels = static_cast<const uint8_t*>(container.getTexels());
+        double sourceSum = 0.0;
+        double errorSum = 0.0;
+        for (size_t i = 0; i < (size_t)header.width * header.height; i++)
+        {
+            float rgb[3];
+            decodeTexel(container.getFormat(), texels + i * texelBytes, rgb);
+            for (uint32_t c = 0; c < 3; c++)
+            {
+                sourceSum += fabs(pixels[i * 4 + c]);
+                errorSum += fabs(rgb[c] - pixels[i * 4 + c]);
+            }
+        }
+        return sourceSum > 0.0 ? (float)(errorSum / sourceSum) : 0.0f;
+    }
+
+#ifdef __linux__
+    uint64_t readStatusKb(const char* field)
+    {
+        std::ifstream status("/proc/self/status");
+        std::string line;
+        size_t length = strlen(field);
+        while (std::getline(status, line))
+        {
+            if (!line.compare(0, length, field))
+            {
+                return strtoull(line.c_str() + length, nullptr, 10);
+            }
+        }
+        return 0;
+    }
+
+    // Lowers the peak resident set to the current one (Linux 4.0+), so each load gets its own peak.
+    void resetPeakRss()
+    {
+        std::ofstream clearRefs("/proc/self/clear_refs");
+        clearRefs << "5";
+    }
+
+    // Peak growth of the resident set while load runs, in MB.
+    template <typename Load>
+    double measurePeakRss(Load&& load)
+    {
+        resetPeakRss();
+        uint64_t baselineKb = readStatusKb("VmRSS:");
+        load();
+        uint64_t peakKb = readStatusKb("VmHWM:");
+        return peakKb > baselineKb ? (peakKb - baselineKb) / 1024.0 : 0.0;
+    }
+#else
+    template <typename Load>
+    double measurePeakRss(Load&& load)
+    {
+        load();
+        return -1.0;
+    }
+#endif
+
+    void printLoad(const char* name, double ms, double peakMb, uint64_t uploadBytes)
+    {
+        std::cout << name << ": " << ms << " ms, ";
+        if (peakMb >= 0.0)
+        {
+            std::cout << "peak RSS +" << peakMb << " MB, ";
+        }
+        else
+        {
+            std::cout << "peak RSS not measured on this platform, ";
+        }
+        std::cout << uploadBytes / (1024.0 * 1024.0) << " MB handed to the texture upload" << std::endl;
+    }
+
+    // Compares what the renderer pays to get upload-ready texels: a full RGBE decode, single-threaded in stb_image and
+    // on the thread pool in HDRDecoder, against mapping the container and reading every page of it the way the
+    // driver does when it copies the initial data.
+    bool benchmarkLoad(const std::string& inputPath, const std::string& containerPath, ThreadPool* threadPool)
+    {
+        int width = 0, height = 0, nrComponents = 0;
+        double decodeMs = 0.0;
+        double decodePeakMb = measurePeakRss([&]()
+        {
+            auto start = Clock::now();
+            float* pixels = stbi_loadf(inputPath.c_str(), &width, &height, &nrComponents, 4);
+            decodeMs = elapsedMs(start);
+            stbi_image_free(pixels);
+        });
+
+        double decoderMs = 0.0;
+        double decoderPeakMb = measurePeakRss([&]()
+        {
+            auto start = Clock::now();
+            std::vector<float> pixels;
+            uint32_t decodedWidth, decodedHeight;
+            HDRDecoder::load(inputPath, threadPool, &pixels, &decodedWidth, &decodedHeight);
+            decoderMs = elapsedMs(start);
+        });
+
+        bool opened = false;
+        uint64_t containerBytes = 0;
+        double mapMs = 0.0;
+        double mapPeakMb = measurePeakRss([&]()
+        {
+            auto start = Clock::now();
+            HDRContainer container;
+            opened = container.open(containerPath, nullptr);
+            if (opened)
+            {
+                const uint8_t* texels = static_cast<const uint8_t*>(container.getTexels());
+                containerBytes = container.getHeader().dataSize;
+                volatile uint8_t checksum = 0;
+                for (uint64_t offset = 0; offset < containerBytes; offset += PAGE_SIZE)
+                {
+                    checksum = checksum + texels[offset];
+                }
+            }
+            mapMs = elapsedMs(start);
+        });
+        if (!opened)
+        {
+            std::cerr << "Failed to map " << containerPath << std::endl;
+            return false;
+        }
+
+        uint64_t decodedBytes = (uint64_t)width * height * 4 * sizeof(float);
+        printLoad("stbi_loadf", decodeMs, decodePeakMb, decodedBytes);
+        printLoad("HDRDecoder", decoderMs, decoderPeakMb, decodedBytes);
+        printLoad("Mapped container", mapMs, mapPeakMb, containerBytes);
+        std::cout << "Speedup over stbi_loadf: HDRDecoder " << decodeMs / decoderMs << "x, mapped container "
+            << decodeMs / mapMs << "x" << std::endl;
+        return true;
+    }
+
+    double timeDecode(const HDRDecoder& decoder, RenderFormat format, void* pOutput, uint32_t threadCount)
+    {
+        std::unique_ptr<ThreadPool> threadPool(threadCount > 1 ? new ThreadPool(threadCount - 1) : nullptr);
+        double bestMs = 0.0;
+        for (uint32_t run = 0; run < DECODE_RUNS; run++)
+        {
+            auto start = Clock::now();
+            decoder.decode(format, pOutput, threadPool.get());
+            double ms = elapsedMs(start);
+            bestMs = run == 0 || ms < bestMs ? ms : bestMs;
+        }
+        return bestMs;
+    }
+
+    // Checks HDRDecoder against stbi_loadf bit for bit in both output formats, then times it from one thread up to
+    // maxThreads, the calling thread included.
+    bool verifyDecoder(const std::string& path, uint32_t maxThreads)
+    {
+        int width, height, nrComponents;
+        auto start = Clock::now();
+        float* reference = stbi_loadf(path.c_str(), &width, &height, &nrComponents, 4);
+        double stbMs = elapsedMs(start);
+        if (!reference)
+        {
+            std::cerr << "Failed to load hdr " << path << std::endl;
+            return false;
+        }
+        HDRDecoder decoder;
+        if (!decoder.open(path))
+        {
+            stbi_image_free(reference);
+            std::cout << path << ": not taken by HDRDecoder, loads through stb_image" << std::endl;
+            return true;
+        }
+        size_t count = (size_t)width * height * 4;
+        std::vector<float> pixels(count);
+        std::vector<uint16_t> halves(count);
+        decoder.decode(RENDER_FORMAT_R32G32B32A32_FLOAT, pixels.data(), nullptr);
+        decoder.decode(RENDER_FORMAT_R16G16B16A16_FLOAT, halves.data(), nullptr);
+        bool floatsMatch = !memcmp(pixels.data(), reference, count * sizeof(float));
+        std::vector<uint16_t> referenceHalves(count);
+        for (size_t i = 0; i < count; i++)
+        {
+            referenceHalves[i] = HalfFloat::fromFloat(reference[i]);
+        }
+        bool halvesMatch = halves == referenceHalves;
+        std::cout << path << " (" << width << "x" << height << "): RGBA32F " << (floatsMatch ? "matches" : "differs")
+            << ", RGBA16F " << (halvesMatch ? "matches" : "differs") << "; stbi_loadf " << stbMs << " ms"
+            << std::endl;
+
+        double serialMs = 0.0;
+        for (uint32_t threads = 1;; threads = std::min(threads * 2, maxThreads))
+        {
+            std::fill(pixels.begin(), pixels.end(), 0.0f);
+            std::fill(halves.begin(), halves.end(), (uint16_t)0);
+            double ms = timeDecode(decoder, RENDER_FORMAT_R32G32B32A32_FLOAT, pixels.data(), threads);
+            double halfMs = timeDecode(decoder, RENDER_FORMAT_R16G16B16A16_FLOAT, halves.data(), threads);
+            serialMs = threads == 1 ? ms : serialMs;
+            floatsMatch &= !memcmp(pixels.data(), reference, count * sizeof(float));
+            halvesMatch &= halves == referenceHalves;
+            std::cout << "  " << threads << " threads: RGBA32F " << ms << " ms (" << serialMs / ms << "x, "
+                << stbMs / ms << "x stbi_loadf), RGBA16F " << halfMs << " ms" << std::endl;
+            if (threads == maxThreads)
+            {
+                break;
+            }
+        }
+        stbi_image_free(reference);
+        if (!floatsMatch || !halvesMatch)
+        {
+            std::cerr << path << ": HDRDecoder differs from stbi_loadf" << std::endl;
+        }
+        return floatsMatch && halvesMatch;
+    }
+}
+
+// Converts a Radiance HDR to the container CubemapGenerator maps when there is no baked IBL cache, and checks the
+// result against the decoded source.
+int main(int argc, char** argv)
+{
+    std::vector<std::string> paths;
+    RenderFormat format = RENDER_FORMAT_R9G9B9E5_SHAREDEXP;
+    uint32_t threadCount = 0;
+    bool benchmark = false;
+    bool verifyDecoderOnly = false;
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--format") && i + 1 < argc)
+        {
+            if (!parseFormat(argv[++i], &format))
+            {
+                printUsage();
+                return 1;
+            }
+        }
+        else if (!strcmp(argv[i], "--threads") && i + 1 < argc)
+        {
+            threadCount = (uint32_t)atoi(argv[++i]);
+        }
+        else if (!strcmp(argv[i], "--benchmark"))
+        {
+            benchmark = true;
+        }
+        else if (!strcmp(argv[i], "--verify-decoder"))
+        {
+            verifyDecoderOnly = true;
+        }
+        else
+        {
+            paths.push_back(argv[i]);
+        }
+    }
+    if (paths.empty() || (!verifyDecoderOnly && paths.size() > 2))
+    {
+        printUsage();
+        return 1;
+    }
+    if (verifyDecoderOnly)
+    {
+        uint32_t maxThreads = threadCount ? threadCount : std::max(std::thread::hardware_concurrency(), 1u);
+        bool passed = true;
+        for (const std::string& path : paths)
+        {
+            passed &= verifyDecoder(path, maxThreads);
+        }
+        return passed ? 0 : 1;
+    }
+    std::string inputPath = paths[0];
+    std::string outputPath = paths.size() > 1 ? paths[1] : HDRContainer::getContainerPath(inputPath);
+
+    uint64_t sourceHash = 0;
+    if (!HashUtils::hashFile(inputPath, &sourceHash))
+    {
+        std::cerr << "Failed to read " << inputPath << std::endl;
+        return 1;
+    }
+
+    ThreadPool threadPool(threadCount);
+    auto start = Clock::now();
+    std::vector<float> image;
+    uint32_t width, height;
+    if (!HDRDecoder::load(inputPath, &threadPool, &image, &width, &height))
+    {
+        std::cerr << "Failed to load hdr " << inputPath << std::endl;
+        return 1;
+    }
+    std::cout << "Loaded " << inputPath << " (" << width << "x" << height << ") in " << elapsedMs(start) << " ms"
+        << std::endl;
+    const float* pixels = image.data();
+
+    start = Clock::now();
+    SHIrradiance irradianceSH = SphericalHarmonics::projectEquirectangular(pixels, width, height, &threadPool);
+    bool written = HDRContainer::write(outputPath, sourceHash, pixels, width, height, format, irradianceSH,
+                                       &threadPool);
+    double convertMs = elapsedMs(start);
+
+    HDRContainer container;
+    if (!written || !container.open(outputPath, &sourceHash))
+    {
+        std::cerr << "Failed to write " << outputPath << std::endl;
+        return 1;
+    }
+    float meanError = measureMeanError(container, pixels);
+    std::vector<float>().swap(image);
+    std::cout << "Wrote " << outputPath << " (" << (format == RENDER_FORMAT_R9G9B9E5_SHAREDEXP ? "RGB9E5" : "RGBA16F")
+        << ", " << container.getHeader().dataSize << " bytes) in " << convertMs << " ms; mean error "
+        << meanError * 100.0f << "%" << std::endl;
+    container.close();
+    if (meanError > MAX_MEAN_ERROR)
+    {
+        std::cerr << "Stored texels differ from the source by more than " << MAX_MEAN_ERROR * 100.0f << "%"
+            << std::endl;
+        return 1;
+    }
+
+    if (benchmark && !benchmarkLoad(inputPath, outputPath, &threadPool))
+    {
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,320 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../Engine/IBL/BRDFLut.h"
+#include "../Engine/IBL/CubemapBaker.h"
+#include "../Engine/IBL/FloatLanes.h"
+#include "../Engine/IBL/HDRDecoder.h"
+#include "../Engine/IBL/IBLCache.h"
+#include "../Engine/IBL/SphericalHarmonics.h"
+#include "../Utils/BC6H.h"
+#include "../Utils/HashUtils.h"
+#include "../Utils/ThreadPool.h"
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    double elapsedMs(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    const float PREFILTER_MAX_MEAN_ERROR = 0.01f;
+
+    void printUsage()
+    {
+        std::cout << "Usage: IBLBaker <input.hdr> [output.ibl] [--threads N] [--compression none|fast|high]"
+            << " [--benchmark]" << std::endl;
+        std::cout << "       IBLBaker --brdf-lut <output.lut> [--threads N]" << std::endl;
+    }
+
+    double countTexels(const CpuCubemap& cubemap)
+    {
+        double texels = 0.0;
+        for (uint32_t mip = 0; mip < cubemap.mipLevels; mip++)
+        {
+            texels += 6.0 * cubemap.getMipSize(mip) * cubemap.getMipSize(mip);
+        }
+        return texels;
+    }
+
+    float measureMeanError(const CpuCubemap& cubemap, const CpuCubemap& reference)
+    {
+        double referenceSum = 0.0;
+        double errorSum = 0.0;
+        for (size_t i = 0; i < reference.texels.size(); i += 4)
+        {
+            for (uint32_t channel = 0; channel < 3; channel++)
+            {
+                referenceSum += fabs(reference.texels[i + channel]);
+                errorSum += fabs(cubemap.texels[i + channel] - reference.texels[i + channel]);
+            }
+        }
+        return referenceSum > 0.0 ? (float)(errorSum / referenceSum) : 0.0f;
+    }
+
+    // Times the lane kernel against the scalar port of prefilterCube.hlsl and checks they agree.
+    bool benchmarkPrefilter(CubemapBaker& baker, const CpuCubemap& source, const IBLBakeSettings& settings)
+    {
+        CpuCubemap reference;
+        auto start = Clock::now();
+        baker.renderPrefilteredReference(source, settings.prefilteredSize, settings.prefilteredRoughness, &reference);
+        double referenceMs = elapsedMs(start);
+
+        CpuCubemap prefiltered;
+        start = Clock::now();
+        baker.renderPrefiltered(source, settings.prefilteredSize, settings.prefilteredRoughness, &prefiltered);
+        double lanesMs = elapsedMs(start);
+
+        double texels = countTexels(reference);
+        float meanError = measureMeanError(prefiltered, reference);
+        std::cout << "Prefilter benchmark (" << FloatLanes::WIDTH << " lanes): reference " << referenceMs << " ms, "
+            << texels / referenceMs * 1000.0 << " texels/s; lanes " << lanesMs << " ms, "
+            << texels / lanesMs * 1000.0 << " texels/s; speedup " << referenceMs / lanesMs << "x; mean error "
+            << meanError * 100.0f << "%" << std::endl;
+        if (meanError > PREFILTER_MAX_MEAN_ERROR)
+        {
+            std::cerr << "Prefilter lanes differ from reference by more than " << PREFILTER_MAX_MEAN_ERROR * 100.0f
+                << "%" << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    // PSNR of the packed cubemap against the float bake over every stored mip. Both sides go through log2(1 + x)
+    // first, so the sun and the dark parts of an HDR environment weigh in the way they look after tone mapping.
+    double measurePSNR(const PackedCubemap& packed, const CpuCubemap& reference)
+    {
+        CpuCubemap decoded;
+        IBLCache::unpackCubemap(packed, &decoded);
+        double errorSum = 0.0;
+        double peak = 0.0;
+        double count = 0.0;
+        for (uint32_t face = 0; face < 6; face++)
+        {
+            for (uint32_t mip = 0; mip < packed.mipLevels; mip++)
+            {
+                const float* texels = decoded.getTexels(face, mip);
+                const float* expected = reference.getTexels(face, mip);
+                size_t texelCount = (size_t)decoded.getMipSize(mip) * decoded.getMipSize(mip);
+                for (size_t i = 0; i < texelCount * 4; i++)
+                {
+                    if (i % 4 == 3)
+                    {
+                        continue;
+                    }
+                    double value = log2(1.0 + std::max(expected[i], 0.0f));
+                    double error = log2(1.0 + texels[i]) - value;
+                    errorSum += error * error;
+                    peak = std::max(peak, value);
+                    count += 1.0;
+                }
+            }
+        }
+        return errorSum > 0.0 ? 10.0 * log10(peak * peak / (errorSum / count)) : INFINITY;
+    }
+
+    uint64_t getCubemapBytes(const PackedCubemap& cubemap, RenderFormat format)
+    {
+        RenderTextureDesc desc;
+        desc.width = cubemap.size;
+        desc.height = cubemap.size;
+        desc.mipLevels = cubemap.mipLevels;
+        desc.arraySize = 6;
+        desc.format = format;
+        return RenderDevice::getTextureBytes(desc);
+    }
+
+    // Upload size, the device memory the runtime textures take and the quality of each packed cubemap.
+    void printCacheStats(const IBLCacheData& packed, const IBLBakeData& data)
+    {
+        const PackedCubemap* cubemaps[] = {&packed.cubemap, &packed.irradiance, &packed.prefiltered};
+        const CpuCubemap* references[] = {&data.cubemap, &data.irradiance, &data.prefiltered};
+        const char* names[] = {"Environment", "Irradiance", "Prefiltered"};
+        uint64_t uploadBytes = 0;
+        uint64_t deviceBytes = 0;
+        uint64_t floatBytes = 0;
+        for (uint32_t i = 0; i < 3; i++)
+        {
+            uploadBytes += cubemaps[i]->data.size();
+            deviceBytes += getCubemapBytes(*cubemaps[i], cubemaps[i]->format);
+            floatBytes += getCubemapBytes(*cubemaps[i], RENDER_FORMAT_R32G32B32A32_FLOAT);
+            if (cubemaps[i]->format != RENDER_FORMAT_R32G32B32A32_FLOAT)
+            {
+                std::cout << names[i] << " cube PSNR vs RGBA32F: " << measurePSNR(*cubemaps[i], *references[i])
+                    << " dB" << std::endl;
+            }
+        }
+        const double megabyte = 1024.0 * 1024.0;
+        std::cout << "Startup upload " << uploadBytes / megabyte << " MB, VRAM " << deviceBytes / megabyte
+            << " MB (RGBA32F: " << floatBytes / megabyte << " MB, " << (double)floatBytes / deviceBytes << "x)"
+            << std::endl;
+    }
+
+    // Integrates the split-sum LUT once and stores it as RG16F. The brdf-lut suite of EngineTests checks the
+    // integral and the file format.
+    int bakeBRDFLut(const std::string& outputPath, ThreadPool* threadPool)
+    {
+        CubemapBaker baker(threadPool);
+        std::vector<float> integral;
+        auto start = Clock::now();
+        baker.renderBRDF(BRDFLut::DEFAULT_SIZE, &integral);
+        std::cout << "BRDF LUT " << BRDFLut::DEFAULT_SIZE << ": " << elapsedMs(start) << " ms" << std::endl;
+
+        std::vector<uint16_t> texels;
+        BRDFLut::pack(integral, &texels);
+        if (!BRDFLut::write(outputPath, BRDFLut::DEFAULT_SIZE, texels))
+        {
+            std::cerr << "Failed to write " << outputPath << std::endl;
+            return 1;
+        }
+        std::cout << "Wrote " << outputPath << " (" << texels.size() * sizeof(uint16_t) << " bytes)" << std::endl;
+        return 0;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::string inputPath;
+    std::string outputPath;
+    uint32_t threadCount = 0;
+    bool benchmark = false;
+    RenderFormat format = RENDER_FORMAT_BC6H_UF16;
+    BC6HQuality quality = BC6H_QUALITY_HIGH;
+    std::string brdfLutPath;
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--threads") && i + 1 < argc)
+        {
+            threadCount = (uint32_t)atoi(argv[++i]);
+        }
+        else if (!strcmp(argv[i], "--compression") && i + 1 < argc)
+        {
+            const char* compression = argv[++i];
+            if (strcmp(compression, "none") && strcmp(compression, "fast") && strcmp(compression, "high"))
+            {
+                printUsage();
+                return 1;
+            }
+            format = strcmp(compression, "none") ? RENDER_FORMAT_BC6H_UF16 : RENDER_FORMAT_R32G32B32A32_FLOAT;
+            quality = strcmp(compression, "fast") ? BC6H_QUALITY_HIGH : BC6H_QUALITY_FAST;
+        }
+        else if (!strcmp(argv[i], "--brdf-lut") && i + 1 < argc)
+        {
+            brdfLutPath = argv[++i];
+        }
+        else if (!strcmp(argv[i], "--benchmark"))
+        {
+            benchmark = true;
+        }
+        else if (inputPath.empty())
+        {
+            inputPath = argv[i];
+        }
+        else if (outputPath.empty())
+        {
+            outputPath = argv[i];
+        }
+        else
+        {
+            printUsage();
+            return 1;
+        }
+    }
+    if (!brdfLutPath.empty() && inputPath.empty())
+    {
+        ThreadPool threadPool(threadCount);
+        return bakeBRDFLut(brdfLutPath, &threadPool);
+    }
+    if (inputPath.empty())
+    {
+        printUsage();
+        return 1;
+    }
+    if (outputPath.empty())
+    {
+        outputPath = IBLCache::getCachePath(inputPath);
+    }
+
+    uint64_t sourceHash = 0;
+    if (!HashUtils::hashFile(inputPath, &sourceHash))
+    {
+        std::cerr << "Failed to read " << inputPath << std::endl;
+        return 1;
+    }
+
+    ThreadPool threadPool(threadCount);
+    auto start = Clock::now();
+    std::vector<float> image;
+    uint32_t width, height;
+    if (!HDRDecoder::load(inputPath, &threadPool, &image, &width, &height))
+    {
+        std::cerr << "Failed to load hdr " << inputPath << std::endl;
+        return 1;
+    }
+    std::cout << "Loaded " << inputPath << " (" << width << "x" << height << ") in " << elapsedMs(start) << " ms"
+        << std::endl;
+    const float* pixels = image.data();
+
+    CubemapBaker baker(&threadPool);
+    IBLBakeSettings settings;
+    IBLBakeData data;
+    std::cout << "Baking with " << threadPool.getThreadCount() << " threads" << std::endl;
+
+    start = Clock::now();
+    baker.convertEquirectangular(pixels, width, height, (uint32_t)(width < height ? width : height), &data.cubemap);
+    baker.generateMips(&data.cubemap);
+    std::cout << "Environment cube " << data.cubemap.size << ": " << elapsedMs(start) << " ms" << std::endl;
+
+    start = Clock::now();
+    data.irradianceSH = SphericalHarmonics::projectCubemap(data.cubemap, 0, &threadPool);
+    std::cout << "Irradiance SH: " << elapsedMs(start) << " ms" << std::endl;
+    std::vector<float>().swap(image);
+
+    start = Clock::now();
+    baker.renderIrradiance(data.cubemap, settings.irradianceSize, &data.irradiance);
+    std::cout << "Irradiance cube " << settings.irradianceSize << ": " << elapsedMs(start) << " ms" << std::endl;
+
+    start = Clock::now();
+    baker.renderPrefiltered(data.cubemap, settings.prefilteredSize, settings.prefilteredRoughness,
+                            &data.prefiltered);
+    double prefilterMs = elapsedMs(start);
+    std::cout << "Prefiltered cube " << settings.prefilteredSize << " (" << data.prefiltered.mipLevels
+        << " mips): " << prefilterMs << " ms, " << countTexels(data.prefiltered) / prefilterMs * 1000.0
+        << " texels/s" << std::endl;
+    if (benchmark && !benchmarkPrefilter(baker, data.cubemap, settings))
+    {
+        return 1;
+    }
+
+    if (format == RENDER_FORMAT_BC6H_UF16 && data.cubemap.size % BC6H::BLOCK_SIZE)
+    {
+        std::cout << "Environment cube side " << data.cubemap.size << " is not a multiple of " << BC6H::BLOCK_SIZE
+            << ", storing RGBA32F" << std::endl;
+        format = RENDER_FORMAT_R32G32B32A32_FLOAT;
+    }
+    start = Clock::now();
+    IBLCacheData packed;
+    IBLCache::pack(data, format, quality, &threadPool, &packed);
+    if (format == RENDER_FORMAT_BC6H_UF16)
+    {
+        std::cout << "BC6H " << (quality == BC6H_QUALITY_FAST ? "fast" : "high quality") << " encode: "
+            << elapsedMs(start) << " ms" << std::endl;
+    }
+    printCacheStats(packed, data);
+
+    if (!IBLCache::write(outputPath, sourceHash, packed))
+    {
+        std::cerr << "Failed to write " << outputPath << std::endl;
+        return 1;
+    }
+    std::cout << "Wrote " << outputPath << std::endl;
+    return 0;
+}
@@ -0,0 +1,70 @@
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../DXShader/ShaderCache.h"
+#include "../Utils/HashUtils.h"
+
+namespace
+{
+    void printUsage()
+    {
+        std::cout << "Usage: ShaderCacheTool <cache directory> [--prune]" << std::endl;
+    }
+
+    // Lists every entry with the shader it belongs to and whether its sources still match; --prune deletes the rest.
+    int inspectCache(const std::string& directory, bool prune)
+    {
+        std::error_code error;
+        uint32_t entryCount = 0;
+        uint32_t staleCount = 0;
+        for (const auto& item : std::filesystem::directory_iterator(directory, error))
+        {
+            if (item.path().extension() != ".cso")
+            {
+                continue;
+            }
+            ShaderCacheKey key;
+            std::vector<ShaderDependency> dependencies;
+            std::vector<char> bytecode;
+            bool readable = ShaderCache::readEntry(item.path().string(), &key, &dependencies, &bytecode);
+            bool upToDate = readable && ShaderCache::isUpToDate(dependencies);
+            entryCount++;
+            std::cout << item.path().filename().string() << ": ";
+            if (readable)
+            {
+                std::cout << key.sourcePath << " " << key.entryPoint << " " << key.profile << " flags 0x" << std::hex
+                    << key.flags << std::dec << ", " << dependencies.size() << " files, " << bytecode.size()
+                    << " bytes, ";
+            }
+            std::cout << (upToDate ? "up to date" : readable ? "stale" : "unreadable") << std::endl;
+            if (!upToDate)
+            {
+                staleCount++;
+                if (prune)
+                {
+                    std::filesystem::remove(item.path(), error);
+                }
+            }
+        }
+        if (error)
+        {
+            std::cerr << "Failed to read " << directory << std::endl;
+            return 1;
+        }
+        std::cout << entryCount << " entries, " << staleCount << (prune ? " stale removed" : " stale") << std::endl;
+        return 0;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if (argc == 2 || (argc == 3 && !strcmp(argv[2], "--prune")))
+    {
+        return inspectCache(argv[1], argc == 3);
+    }
+    printUsage();
+    return 1;
+}
@@ -0,0 +1,440 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../Engine/SceneRenderer.h"
+#include "../Engine/Mesh/MeshEncoder.h"
+#include "../Engine/Mesh/MeshOptimizer.h"
+#include "../Engine/tiny_obj_loader.h"
+#include "../Engine/RenderDevice/SoftwareRenderDevice.h"
+#include "../Utils/ImageWriter.h"
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    double elapsedMs(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    void printUsage()
+    {
+        std::cout << "Usage: SoftwareRenderer [sphere.wvf] [environment.hdr] [--size WxH] [--grid N] [--frames N]"
+            << " [--threads N] [--lights N] [--png output.png] [--exr output.exr] [--benchmark] [--benchmark-lights]"
+            << " [--benchmark-culling] [--mesh-stats]" << std::endl;
+    }
+
+    bool loadSphere(const std::string& path, MeshData* pOutput)
+    {
+        tinyobj::attrib_t attrib;
+        std::vector<tinyobj::shape_t> shapes;
+        std::vector<tinyobj::material_t> materials;
+        std::string error;
+        bool loaded = tinyobj::LoadObj(&attrib, &shapes, &materials, &error, path.c_str());
+        if (!loaded || !error.empty())
+        {
+            std::cerr << "Failed to load " << path << (error.empty() ? "" : ": " + error) << std::endl;
+            return false;
+        }
+        float defaultColor[3] = {1.0f, 1.0f, 1.0f};
+        *pOutput = MeshBuilder::buildIndexed(attrib, shapes, defaultColor);
+        return true;
+    }
+
+    void printMeshStats(const MeshData& mesh)
+    {
+        const MeshBuildStats& stats = mesh.stats;
+        std::cout << "Sphere mesh: " << stats.indexCount / 3 << " triangles, " << stats.sourceVertexCount
+            << " source vertices, " << stats.uniqueVertexCount << " unique vertices" << std::endl;
+        std::cout << "Vertex cache (" << MeshOptimizer::CACHE_SIZE << " entry FIFO): ACMR "
+            << stats.importedCache.acmr << " -> " << stats.optimizedCache.acmr << ", ATVR "
+            << stats.importedCache.atvr << " -> " << stats.optimizedCache.atvr << std::endl;
+        EncodedMesh encoded = MeshEncoder::encode(mesh, MeshEncoder::chooseEncoding(mesh, VertexEncodingSettings()));
+        const VertexEncodingStats& encoding = encoded.stats;
+        std::cout << "Vertex format: " << encoding.sourceBytesPerVertex << " -> " << encoding.bytesPerVertex
+            << " bytes per vertex, position error " << encoding.positionError << ", UV error " << encoding.uvError
+            << ", normal error " << encoding.normalErrorDegrees << " degrees, color error " << encoding.colorError
+            << std::endl;
+    }
+
+    // Looks at the sphere grid from the front, far enough back that the 90 degree view holds all of it.
+    SceneView makeView(uint32_t width, uint32_t height, int gridSize)
+    {
+        float distance = std::max(10.0f, (gridSize - 1) * 2.5f + 4.0f);
+        SceneView view;
+        view.width = width;
+        view.height = height;
+        view.viewMatrix = RenderMath::translation(0.0f, 0.0f, distance);
+        view.cameraPosition = RenderMath::makeFloat3(0.0f, 0.0f, -distance);
+        return view;
+    }
+
+    double renderFrames(SoftwareRenderDevice* device, SceneRenderer* scene, const SceneView& view,
+                        RenderTexture backBuffer, uint32_t frameCount)
+    {
+        auto start = Clock::now();
+        for (uint32_t i = 0; i < frameCount; i++)
+        {
+            device->beginFrame();
+            scene->drawFrame(view, backBuffer, []() {});
+            device->endFrame();
+        }
+        return elapsedMs(start) / frameCount;
+    }
+
+    // Times LightClusters::build on the scattered lights of the scene, seen from where the largest grid is in view.
+    void benchmarkLightClusters(SceneRenderer* scene, uint32_t width, uint32_t height, uint32_t maxThreads)
+    {
+        const uint32_t LIGHT_COUNTS[] = {1000, 10000};
+        const uint32_t BUILD_COUNT = 20;
+        SceneView view = makeView(width, height, SceneRenderer::MAX_SPHERE_GRID_SIZE);
+        for (uint32_t lightCount : LIGHT_COUNTS)
+        {
+            scene->setScatteredLightCount(lightCount);
+            const std::vector<PointLightSource>& lights = scene->getLights();
+            double serialMs = 0.0;
+            for (uint32_t threads = 1;; threads = std::min(threads * 2, maxThreads))
+            {
+                ThreadPool threadPool(threads);
+                LightClusters clusters(threads == 1 ? nullptr : &threadPool);
+                auto build = [&]()
+                {
+                    clusters.build(lights.data(), (uint32_t)lights.size(), view.viewMatrix,
+                                   view.fovDegrees * RenderMath::PI / 180.0f, (float)width / height, 2000.0f);
+                };
+                build();
+                auto start = Clock::now();
+                for (uint32_t i = 0; i < BUILD_COUNT; i++)
+                {
+                    build();
+                }
+                double ms = elapsedMs(start) / BUILD_COUNT;
+                serialMs = threads == 1 ? ms : serialMs;
+                size_t entries = clusters.getLightIndices().size();
+                std::cout << lights.size() << " lights, " << threads << " threads: " << ms << " ms per build, "
+                    << serialMs / ms << "x, " << entries << " entries, "
+                    << (double)entries / LightClusters::CLUSTER_COUNT << " per cluster (max "
+                    << clusters.getMaxClusterLights() << ")" << std::endl;
+                if (threads == maxThreads)
+                {
+                    break;
+                }
+            }
+        }
+    }
+
+    // Times building, refitting and culling SceneObjects with 100k boxes spread through a city sized block, and
+    // compares culling with the plain linear test.
+    void benchmarkSceneObjects(uint32_t width, uint32_t height)
+    {
+        const uint32_t OBJECT_COUNT = 100000;
+        const uint32_t REPEAT_COUNT = 20;
+        const float SCENE_EXTENT = 2000.0f;
+        std::mt19937 random(5);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+        std::vector<Float3> centers(OBJECT_COUNT);
+        std::vector<float> sizes(OBJECT_COUNT);
+        for (uint32_t i = 0; i < OBJECT_COUNT; i++)
+        {
+            centers[i] = RenderMath::makeFloat3((unit(random) - 0.5f) * SCENE_EXTENT, unit(random) * 50.0f,
+                                                (unit(random) - 0.5f) * SCENE_EXTENT);
+            sizes[i] = 0.5f + 4.0f * unit(random);
+        }
+        auto setObject = [&](SceneObjects& objects, uint32_t id, bool added)
+        {
+            Float3 boundsMin = RenderMath::makeFloat3(centers[id].x - sizes[id], centers[id].y - sizes[id],
+                                                      centers[id].z - sizes[id]);
+            Float3 boundsMax = RenderMath::makeFloat3(centers[id].x + sizes[id], centers[id].y + sizes[id],
+                                                      centers[id].z + sizes[id]);
+            if (added)
+            {
+                objects.add(boundsMin, boundsMax);
+            }
+            else
+            {
+                objects.setBounds(id, boundsMin, boundsMax);
+            }
+        };
+
+        SceneObjects objects;
+        double buildMs = 0.0;
+        for (uint32_t repeat = 0; repeat < REPEAT_COUNT; repeat++)
+        {
+            objects.clear();
+            for (uint32_t i = 0; i < OBJECT_COUNT; i++)
+            {
+                setObject(objects, i, true);
+            }
+            auto start = Clock::now();
+            objects.update();
+            buildMs += elapsedMs(start) / REPEAT_COUNT;
+        }
+        std::cout << OBJECT_COUNT << " objects: build " << buildMs << " ms, " << objects.getNodeCount() << " nodes"
+            << std::endl;
+
+        // A tenth or all of the objects drift a little every frame.
+        const uint32_t MOVE_STRIDES[] = {10, 1};
+        uint32_t buildCount = objects.getBuildCount();
+        for (uint32_t stride : MOVE_STRIDES)
+        {
+            double refitMs = 0.0;
+            for (uint32_t repeat = 0; repeat < REPEAT_COUNT; repeat++)
+            {
+                for (uint32_t i = repeat % stride; i < OBJECT_COUNT; i += stride)
+                {
+                    centers[i].x += unit(random) - 0.5f;
+                    centers[i].z += unit(random) - 0.5f;
+                    setObject(objects, i, false);
+                }
+                auto start = Clock::now();
+                objects.update();
+                refitMs += elapsedMs(start) / REPEAT_COUNT;
+            }
+            std::cout << OBJECT_COUNT / stride << " moving: refit " << refitMs << " ms, area "
+                << objects.getAreaRatio() << "x, " << objects.getBuildCount() - buildCount << " rebuilds" << std::endl;
+        }
+
+        // Standing in the middle of the block, and from high above its edge looking down over it.
+        struct CullView
+        {
+            const char* name;
+            Float3 eye;
+            Float3 direction;
+        };
+        const CullView VIEWS[] = {
+            {"street", RenderMath::makeFloat3(0.0f, 10.0f, 0.0f), RenderMath::makeFloat3(1.0f, 0.0f, 0.2f)},
+            {"overview", RenderMath::makeFloat3(0.0f, 1000.0f, -1200.0f), RenderMath::makeFloat3(0.0f, -1.0f, 1.0f)}
+        };
+        Float4x4 projection = RenderMath::perspectiveFov(RenderMath::PI / 2.0f, (float)width / height, 0.001f,
+                                                         2000.0f);
+        std::vector<uint32_t> visible;
+        for (const CullView& cullView : VIEWS)
+        {
+            Float4x4 viewProjection = RenderMath::multiply(
+                RenderMath::lookTo(cullView.eye, cullView.direction, RenderMath::makeFloat3(0.0f, 1.0f, 0.0f)),
+                projection);
+            CullStats stats;
+            auto start = Clock::now();
+            for (uint32_t repeat = 0; repeat < REPEAT_COUNT; repeat++)
+            {
+                objects.cull(viewProjection, &visible, &stats);
+            }
+            double cullMs = elapsedMs(start) / REPEAT_COUNT;
+            start = Clock::now();
+            for (uint32_t repeat = 0; repeat < REPEAT_COUNT; repeat++)
+            {
+                objects.cullLinear(viewProjection, &visible);
+            }
+            double linearMs = elapsedMs(start) / REPEAT_COUNT;
+            std::cout << cullView.name << ": cull " << cullMs << " ms, linear " << linearMs << " ms, "
+                << stats.visibleObjects << " visible, " << stats.visitedNodes << " nodes visited, "
+                << stats.testedObjects << " objects tested" << std::endl;
+        }
+    }
+
+    void printFrameStats(const SoftwareRasterStats& stats)
+    {
+        std::cout << stats.triangles << " triangles, " << stats.rasterizedTriangles << " after culling and clipping, "
+            << stats.binnedTriangles << " tile bins, " << stats.shadedPixels << " pixels shaded, "
+            << stats.depthRejectedPixels << " rejected by depth" << std::endl;
+    }
+}
+
+// Renders the PBR scene on the CPU through SoftwareRenderDevice, without a GPU or a window, and writes the frame
+// to disk. --benchmark measures how frame time scales with the number of threads, --benchmark-lights how long
+// clustering 1k and 10k point lights takes, --benchmark-culling how long the scene object hierarchy takes with 100k
+// objects. --mesh-stats stops after loading the sphere and printing its vertex cache statistics.
+int main(int argc, char** argv)
+{
+    std::string spherePath;
+    std::string environmentPath;
+    std::string pngPath;
+    std::string exrPath;
+    uint32_t width = 640;
+    uint32_t height = 480;
+    int gridSize = 1;
+    uint32_t frameCount = 1;
+    uint32_t threadCount = 0;
+    uint32_t lightCount = 0;
+    bool benchmark = false;
+    bool benchmarkLights = false;
+    bool benchmarkCulling = false;
+    bool meshStats = false;
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--size") && i + 1 < argc)
+        {
+            char* separator = nullptr;
+            width = (uint32_t)strtoul(argv[++i], &separator, 10);
+            height = *separator == 'x' ? (uint32_t)strtoul(separator + 1, nullptr, 10) : 0;
+            if (!width || !height)
+            {
+                printUsage();
+                return 1;
+            }
+        }
+        else if (!strcmp(argv[i], "--grid") && i + 1 < argc)
+        {
+            gridSize = atoi(argv[++i]);
+        }
+        else if (!strcmp(argv[i], "--frames") && i + 1 < argc)
+        {
+            frameCount = std::max(atoi(argv[++i]), 1);
+        }
+        else if (!strcmp(argv[i], "--threads") && i + 1 < argc)
+        {
+            threadCount = (uint32_t)atoi(argv[++i]);
+        }
+        else if (!strcmp(argv[i], "--lights") && i + 1 < argc)
+        {
+            lightCount = (uint32_t)atoi(argv[++i]);
+        }
+        else if (!strcmp(argv[i], "--png") && i + 1 < argc)
+        {
+            pngPath = argv[++i];
+        }
+        else if (!strcmp(argv[i], "--exr") && i + 1 < argc)
+        {
+            exrPath = argv[++i];
+        }
+        else if (!strcmp(argv[i], "--benchmark"))
+        {
+            benchmark = true;
+        }
+        else if (!strcmp(argv[i], "--benchmark-lights"))
+        {
+            benchmarkLights = true;
+        }
+        else if (!strcmp(argv[i], "--benchmark-culling"))
+        {
+            benchmarkCulling = true;
+        }
+        else if (!strcmp(argv[i], "--mesh-stats"))
+        {
+            meshStats = true;
+        }
+        else if (spherePath.empty())
+        {
+            spherePath = argv[i];
+        }
+        else if (environmentPath.empty())
+        {
+            environmentPath = argv[i];
+        }
+        else
+        {
+            printUsage();
+            return 1;
+        }
+    }
+    spherePath = spherePath.empty() ? "sphere.wvf" : spherePath;
+    environmentPath = environmentPath.empty() ? "hdr_room2.hdr" : environmentPath;
+
+    MeshData sphere;
+    if (!loadSphere(spherePath, &sphere))
+    {
+        return 1;
+    }
+    printMeshStats(sphere);
+    if (meshStats)
+    {
+        return 0;
+    }
+    size_t separator = environmentPath.find_last_of("/\\");
+    std::string directory = separator == std::string::npos ? "" : environmentPath.substr(0, separator + 1);
+    std::string name = separator == std::string::npos ? environmentPath : environmentPath.substr(separator + 1);
+
+    try
+    {
+        SoftwareRenderDevice device(threadCount);
+        std::cout << "Rendering " << width << "x" << height << " on " << device.getThreadCount() << " threads"
+            << std::endl;
+        RenderTextureDesc backBufferDesc;
+        backBufferDesc.width = width;
+        backBufferDesc.height = height;
+        backBufferDesc.format = RENDER_FORMAT_R8G8B8A8_UNORM;
+        backBufferDesc.bindFlags = RENDER_BIND_RENDER_TARGET;
+        backBufferDesc.name = "Back buffer";
+        RenderTexture backBuffer = device.createTexture(backBufferDesc);
+
+        SceneRenderer::requestShaders(&device);
+        SceneRenderer scene(&device);
+        scene.initialize(width, height, sphere);
+        const std::vector<SphereLevel>& sphereLevels = scene.getSphereLevels();
+        for (size_t i = 0; i < sphereLevels.size(); i++)
+        {
+            std::cout << "LOD " << i << ": " << sphereLevels[i].indexCount / 3 << " triangles, error "
+                << sphereLevels[i].error << std::endl;
+        }
+        scene.setSphereGridSize(gridSize);
+        scene.setScatteredLightCount(lightCount);
+        auto start = Clock::now();
+        device.beginFrame();
+        scene.loadEnvironment(directory, name);
+        device.endFrame();
+        std::cout << "Environment: " << elapsedMs(start) << " ms" << std::endl;
+
+        SceneView view = makeView(width, height, gridSize);
+        double frameMs = renderFrames(&device, &scene, view, backBuffer, frameCount);
+        std::cout << "Frame: " << frameMs << " ms" << std::endl;
+        printFrameStats(device.getRasterStats());
+
+        if (benchmark)
+        {
+            uint32_t maxThreads = device.getThreadCount();
+            double serialMs = 0.0;
+            for (uint32_t threads = 1;; threads = std::min(threads * 2, maxThreads))
+            {
+                device.setThreadCount(threads);
+                double ms = renderFrames(&device, &scene, view, backBuffer, std::max(frameCount, 3u));
+                serialMs = threads == 1 ? ms : serialMs;
+                std::cout << threads << " threads: " << ms << " ms per frame, " << serialMs / ms << "x" << std::endl;
+                if (threads == maxThreads)
+                {
+                    break;
+                }
+            }
+        }
+
+        if (benchmarkLights)
+        {
+            benchmarkLightClusters(&scene, width, height, device.getThreadCount());
+            scene.setScatteredLightCount(lightCount);
+        }
+
+        if (benchmarkCulling)
+        {
+            benchmarkSceneObjects(width, height);
+        }
+
+        if (!pngPath.empty())
+        {
+            std::vector<uint8_t> pixels(RenderDevice::getTextureBytes(backBufferDesc));
+            device.getTexture(backBuffer).download(0, 0, pixels.data());
+            ImageWriter::writePng(pngPath, width, height, pixels.data());
+            std::cout << "Wrote " << pngPath << std::endl;
+        }
+        if (!exrPath.empty())
+        {
+            const SoftwareTexture& hdr = device.getTexture(scene.getToneMapper()->getHdrTarget());
+            ImageWriter::writeExr(exrPath, width, height, &hdr.getTexels(0, 0)->x);
+            std::cout << "Wrote " << exrPath << std::endl;
+        }
+
+        scene.destroy();
+        device.destroyTexture(backBuffer);
+    }
+    catch (const std::exception& exception)
+    {
+        std::cerr << exception.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,490 @@
+#include "BC6H.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+#include "HalfFloat.h"
+
+namespace
+{
+    const uint32_t TEXEL_COUNT = 16;
+    const float MAX_HALF_BITS = 0x7BFF;
+    const int WEIGHTS[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+    const uint32_t REFIT_ITERATIONS = 3;
+    const uint32_t POWER_ITERATIONS = 4;
+
+    // The single-region modes: 5 mode bits, the precision of the first endpoint and of the second, which all but
+    // mode 11 store as a signed delta from the first.
+    struct Mode
+    {
+        uint32_t bits;
+        uint32_t endpointBits;
+        uint32_t deltaBits;
+    };
+
+    const Mode MODES[] = {{0x03, 10, 10}, {0x07, 11, 9}, {0x0B, 12, 8}, {0x0F, 16, 4}};
+
+    bool isTransformed(const Mode& mode)
+    {
+        return mode.deltaBits != mode.endpointBits;
+    }
+
+    struct Block
+    {
+        int endpoints[2][3];
+        uint8_t indices[TEXEL_COUNT];
+        float error;
+    };
+
+    class BitWriter
+    {
+    public:
+        explicit BitWriter(uint8_t* pBlock) : block(pBlock)
+        {
+            memset(block, 0, BC6H::BLOCK_BYTES);
+        }
+
+        void write(uint32_t value, uint32_t count)
+        {
+            for (uint32_t i = 0; i < count; i++, position++)
+            {
+                block[position >> 3] |= (uint8_t)(((value >> i) & 1) << (position & 7));
+            }
+        }
+
+    private:
+        uint8_t* block;
+        uint32_t position = 0;
+    };
+
+    class BitReader
+    {
+    public:
+        explicit BitReader(const uint8_t* block) : block(block)
+        {
+        }
+
+        uint32_t read(uint32_t count)
+        {
+            uint32_t value = 0;
+            for (uint32_t i = 0; i < count; i++, position++)
+            {
+                value |= (uint32_t)((block[position >> 3] >> (position & 7)) & 1) << i;
+            }
+            return value;
+        }
+
+    private:
+        const uint8_t* block;
+        uint32_t position = 0;
+    };
+
+    // Endpoint expansion and interpolation exactly as the D3D11 spec defines them for unsigned blocks.
+    int unquantize(int value, uint32_t bits)
+    {
+        if (bits >= 15)
+        {
+            return value;
+        }
+        if (value == 0)
+        {
+            return 0;
+        }
+        if (value == (1 << bits) - 1)
+        {
+            return 0xFFFF;
+        }
+        return ((value << 16) + 0x8000) >> bits;
+    }
+
+    int decodeTexel(int low, int high, uint32_t index)
+    {
+        int interpolated = (low * (64 - WEIGHTS[index]) + high * WEIGHTS[index] + 32) >> 6;
+        return (interpolated * 31) >> 6;
+    }
+
+    // The endpoint value whose decoded half bits come closest to value.
+    int quantize(float value, uint32_t bits)
+    {
+        int maxValue = (1 << bits) - 1;
+        float unquantized = value * 64.0f / 31.0f;
+        int guess = (int)(bits >= 15 ? unquantized : unquantized * (float)(1 << bits) / 65536.0f);
+        int best = 0;
+        float bestError = FLT_MAX;
+        for (int candidate = guess - 1; candidate <= guess + 1; candidate++)
+        {
+            int clamped = std::min(std::max(candidate, 0), maxValue);
+            float error = fabsf((float)decodeTexel(unquantize(clamped, bits), 0, 0) - value);
+            if (error < bestError)
+            {
+                best = clamped;
+                bestError = error;
+            }
+        }
+        return best;
+    }
+
+    void clampDelta(const Mode& mode, Block* pBlock)
+    {
+        if (!isTransformed(mode))
+        {
+            return;
+        }
+        int limit = 1 << (mode.deltaBits - 1);
+        for (uint32_t c = 0; c < 3; c++)
+        {
+            int delta = pBlock->endpoints[1][c] - pBlock->endpoints[0][c];
+            pBlock->endpoints[1][c] = pBlock->endpoints[0][c] + std::min(std::max(delta, -limit), limit - 1);
+        }
+    }
+
+    // Picks the closest palette entry for every texel, the first one among firstIndexCount entries.
+    void selectIndices(const Mode& mode, const float (&texels)[TEXEL_COUNT][3], uint32_t firstIndexCount,
+                       Block* pBlock)
+    {
+        int palette[16][3];
+        for (uint32_t c = 0; c < 3; c++)
+        {
+            int low = unquantize(pBlock->endpoints[0][c], mode.endpointBits);
+            int high = unquantize(pBlock->endpoints[1][c], mode.endpointBits);
+            for (uint32_t index = 0; index < 16; index++)
+            {
+                palette[index][c] = decodeTexel(low, high, index);
+            }
+        }
+        pBlock->error = 0.0f;
+        for (uint32_t i = 0; i < TEXEL_COUNT; i++)
+        {
+            float bestError = FLT_MAX;
+            for (uint32_t index = 0; index < (i == 0 ? firstIndexCount : 16u); index++)
+            {
+                float error = 0.0f;
+                for (uint32_t c = 0; c < 3; c++)
+                {
+                    float difference = (float)palette[index][c] - texels[i][c];
+                    error += difference * difference;
+                }
+                if (error < bestError)
+                {
+                    bestError = error;
+                    pBlock->indices[i] = (uint8_t)index;
+                }
+            }
+            pBlock->error += bestError;
+        }
+    }
+
+    // Quantizes a pair of endpoints for the mode and selects the indices. The first texel's index is stored with an
+    // implicit leading zero, so the endpoints swap when it lands in the upper half of the palette.
+    void fitBlock(const Mode& mode, const float (&texels)[TEXEL_COUNT][3], const float (&endpoints)[2][3],
+                  Block* pBlock)
+    {
+        for (uint32_t c = 0; c < 3; c++)
+        {
+            pBlock->endpoints[0][c] = quantize(endpoints[0][c], mode.endpointBits);
+            pBlock->endpoints[1][c] = quantize(endpoints[1][c], mode.endpointBits);
+        }
+        clampDelta(mode, pBlock);
+        selectIndices(mode, texels, 16, pBlock);
+        if (pBlock->indices[0] >= 8)
+        {
+            std::swap(pBlock->endpoints[0], pBlock->endpoints[1]);
+            clampDelta(mode, pBlock);
+            selectIndices(mode, texels, 8, pBlock);
+        }
+    }
+
+    // Least squares endpoints for the interpolation weights the block's indices select.
+    bool refitEndpoints(const float (&texels)[TEXEL_COUNT][3], const Block& block, float (*pEndpoints)[3])
+    {
+        float a = 0.0f, b = 0.0f, c = 0.0f;
+        float lowSum[3] = {}, highSum[3] = {};
+        for (uint32_t i = 0; i < TEXEL_COUNT; i++)
+        {
+            float t = WEIGHTS[block.indices[i]] / 64.0f;
+            a += (1.0f - t) * (1.0f - t);
+            b += t * (1.0f - t);
+            c += t * t;
+            for (uint32_t channel = 0; channel < 3; channel++)
+            {
+                lowSum[channel] += (1.0f - t) * texels[i][channel];
+                highSum[channel] += t * texels[i][channel];
+            }
+        }
+        float determinant = a * c - b * b;
+        if (fabsf(determinant) < 1e-6f)
+        {
+            return false;
+        }
+        for (uint32_t channel = 0; channel < 3; channel++)
+        {
+            float low = (c * lowSum[channel] - b * highSum[channel]) / determinant;
+            float high = (a * highSum[channel] - b * lowSum[channel]) / determinant;
+            pEndpoints[0][channel] = std::min(std::max(low, 0.0f), MAX_HALF_BITS);
+            pEndpoints[1][channel] = std::min(std::max(high, 0.0f), MAX_HALF_BITS);
+        }
+        return true;
+    }
+
+    // Endpoints at the extremes of the texels projected on their principal axis.
+    void principalEndpoints(const float (&texels)[TEXEL_COUNT][3], float (*pEndpoints)[3])
+    {
+        float mean[3] = {};
+        for (uint32_t i = 0; i < TEXEL_COUNT; i++)
+        {
+            for (uint32_t c = 0; c < 3; c++)
+            {
+                mean[c] += texels[i][c] / TEXEL_COUNT;
+            }
+        }
+        float covariance[3][3] = {};
+        for (uint32_t i = 0; i < TEXEL_COUNT; i++)
+        {
+            for (uint32_t row = 0; row < 3; row++)
+            {
+                for (uint32_t column = 0; column < 3; column++)
+                {
+                    covariance[row][column] += (texels[i][row] - mean[row]) * (texels[i][column] - mean[column]);
+                }
+            }
+        }
+        float axis[3] = {1.0f, 1.0f, 1.0f};
+        for (uint32_t iteration = 0; iteration < POWER_ITERATIONS; iteration++)
+        {
+            float next[3];
+            float length = 0.0f;
+            for (uint32_t row = 0; row < 3; row++)
+            {
+                next[row] = covariance[row][0] * axis[0] + covariance[row][1] * axis[1] + covariance[row][2] * axis[2];
+                length = std::max(length, fabsf(next[row]));
+            }
+            if (length == 0.0f)
+            {
+                break;
+            }
+            for (uint32_t row = 0; row < 3; row++)
+            {
+                axis[row] = next[row] / length;
+            }
+        }
+        float lengthSquared = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+        float minimum = FLT_MAX, maximum = -FLT_MAX;
+        for (uint32_t i = 0; i < TEXEL_COUNT; i++)
+        {
+            float projection = 0.0f;
+            for (uint32_t c = 0; c < 3; c++)
+            {
+                projection += (texels[i][c] - mean[c]) * axis[c];
+            }
+            minimum = std::min(minimum, projection / lengthSquared);
+            maximum = std::max(maximum, projection / lengthSquared);
+        }
+        for (uint32_t c = 0; c < 3; c++)
+        {
+            pEndpoints[0][c] = std::min(std::max(mean[c] + axis[c] * minimum, 0.0f), MAX_HALF_BITS);
+            pEndpoints[1][c] = std::min(std::max(mean[c] + axis[c] * maximum, 0.0f), MAX_HALF_BITS);
+        }
+    }
+
+    void packBlock(const Mode& mode, const Block& block, uint8_t* pBlock)
+    {
+        BitWriter writer(pBlock);
+        writer.write(mode.bits, 5);
+        for (uint32_t c = 0; c < 3; c++)
+        {
+            writer.write((uint32_t)block.endpoints[0][c], 10);
+        }
+        for (uint32_t c = 0; c < 3; c++)
+        {
+            int second = block.endpoints[1][c];
+            if (isTransformed(mode))
+            {
+                second -= block.endpoints[0][c];
+            }
+            writer.write((uint32_t)second & ((1u << mode.deltaBits) - 1), mode.deltaBits);
+            // The first endpoint's bits above the tenth follow, most significant first.
+            for (uint32_t bit = mode.endpointBits; bit-- > 10;)
+            {
+                writer.write((uint32_t)block.endpoints[0][c] >> bit, 1);
+            }
+        }
+        writer.write(block.indices[0], 3);
+        for (uint32_t i = 1; i < TEXEL_COUNT; i++)
+        {
+            writer.write(block.indices[i], 4);
+        }
+    }
+
+    float toHalfBits(float value)
+    {
+        if (!(value > 0.0f))
+        {
+            return 0.0f;
+        }
+        return std::min((float)HalfFloat::fromFloat(value), MAX_HALF_BITS);
+    }
+}
+
+void BC6H::encodeBlock(const float* texels, BC6HQuality quality, uint8_t* pBlock)
+{
+    float halfTexels[TEXEL_COUNT][3];
+    for (uint32_t i = 0; i < TEXEL_COUNT; i++)
+    {
+        for (uint32_t c = 0; c < 3; c++)
+        {
+            halfTexels[i][c] = toHalfBits(texels[i * 4 + c]);
+        }
+    }
+    float initialEndpoints[2][3];
+    principalEndpoints(halfTexels, initialEndpoints);
+
+    uint32_t modeCount = quality == BC6H_QUALITY_FAST ? 1 : sizeof(MODES) / sizeof(MODES[0]);
+    uint32_t refitIterations = quality == BC6H_QUALITY_FAST ? 0 : REFIT_ITERATIONS;
+    Block best = {};
+    uint32_t bestMode = 0;
+    best.error = FLT_MAX;
+    for (uint32_t modeIndex = 0; modeIndex < modeCount; modeIndex++)
+    {
+        const Mode& mode = MODES[modeIndex];
+        float endpoints[2][3];
+        memcpy(endpoints, initialEndpoints, sizeof(endpoints));
+        Block block;
+        fitBlock(mode, halfTexels, endpoints, &block);
+        for (uint32_t iteration = 0; iteration < refitIterations && block.error > 0.0f; iteration++)
+        {
+            Block refit;
+            if (!refitEndpoints(halfTexels, block, endpoints))
+            {
+                break;
+            }
+            fitBlock(mode, halfTexels, endpoints, &refit);
+            if (refit.error >= block.error)
+            {
+                break;
+            }
+            block = refit;
+        }
+        if (block.error < best.error)
+        {
+            best = block;
+            bestMode = modeIndex;
+        }
+    }
+    packBlock(MODES[bestMode], best, pBlock);
+}
+
+void BC6H::decodeBlock(const uint8_t* block, float* pTexels)
+{
+    for (uint32_t i = 0; i < TEXEL_COUNT; i++)
+    {
+        pTexels[i * 4 + 0] = pTexels[i * 4 + 1] = pTexels[i * 4 + 2] = 0.0f;
+        pTexels[i * 4 + 3] = 1.0f;
+    }
+    BitReader reader(block);
+    uint32_t modeBits = reader.read(2);
+    if (modeBits < 2)
+    {
+        return;
+    }
+    modeBits |= reader.read(3) << 2;
+    const Mode* mode = std::find_if(std::begin(MODES), std::end(MODES),
+                                    [&](const Mode& candidate) { return candidate.bits == modeBits; });
+    if (mode == std::end(MODES))
+    {
+        return;
+    }
+    int endpoints[2][3];
+    for (uint32_t c = 0; c < 3; c++)
+    {
+        endpoints[0][c] = (int)reader.read(10);
+    }
+    for (uint32_t c = 0; c < 3; c++)
+    {
+        uint32_t second = reader.read(mode->deltaBits);
+        for (uint32_t bit = mode->endpointBits; bit-- > 10;)
+        {
+            endpoints[0][c] |= (int)reader.read(1) << bit;
+        }
+        if (isTransformed(*mode))
+        {
+            // Sign-extend the delta; the sum wraps to the endpoint precision.
+            int delta = (int)(second << (32 - mode->deltaBits)) >> (32 - mode->deltaBits);
+            second = (uint32_t)(endpoints[0][c] + delta) & ((1u << mode->endpointBits) - 1);
+        }
+        endpoints[1][c] = (int)second;
+    }
+    int low[3], high[3];
+    for (uint32_t c = 0; c < 3; c++)
+    {
+        low[c] = unquantize(endpoints[0][c], mode->endpointBits);
+        high[c] = unquantize(endpoints[1][c], mode->endpointBits);
+    }
+    for (uint32_t i = 0; i < TEXEL_COUNT; i++)
+    {
+        uint32_t index = reader.read(i == 0 ? 3 : 4);
+        for (uint32_t c = 0; c < 3; c++)
+        {
+            pTexels[i * 4 + c] = HalfFloat::toFloat((uint16_t)decodeTexel(low[c], high[c], index));
+        }
+    }
+}
+
+size_t BC6H::getImageBytes(uint32_t width, uint32_t height)
+{
+    return (size_t)((width + BLOCK_SIZE - 1) / BLOCK_SIZE) * ((height + BLOCK_SIZE - 1) / BLOCK_SIZE) * BLOCK_BYTES;
+}
+
+void BC6H::encodeImage(const float* pixels, uint32_t width, uint32_t height, BC6HQuality quality,
+                       ThreadPool* threadPool, uint8_t* pOutput)
+{
+    uint32_t blocksX = (width + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    uint32_t blocksY = (height + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    auto encodeRow = [&](uint32_t blockY)
+    {
+        for (uint32_t blockX = 0; blockX < blocksX; blockX++)
+        {
+            float texels[TEXEL_COUNT * 4];
+            for (uint32_t i = 0; i < TEXEL_COUNT; i++)
+            {
+                uint32_t x = std::min(blockX * BLOCK_SIZE + i % BLOCK_SIZE, width - 1);
+                uint32_t y = std::min(blockY * BLOCK_SIZE + i / BLOCK_SIZE, height - 1);
+                memcpy(texels + i * 4, pixels + ((size_t)y * width + x) * 4, 4 * sizeof(float));
+            }
+            encodeBlock(texels, quality, pOutput + ((size_t)blockY * blocksX + blockX) * BLOCK_BYTES);
+        }
+    };
+    if (threadPool)
+    {
+        threadPool->parallelFor(blocksY, encodeRow);
+        return;
+    }
+    for (uint32_t blockY = 0; blockY < blocksY; blockY++)
+    {
+        encodeRow(blockY);
+    }
+}
+
+void BC6H::decodeImage(const uint8_t* blocks, uint32_t width, uint32_t height, float* pOutput)
+{
+    uint32_t blocksX = (width + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    uint32_t blocksY = (height + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    for (uint32_t blockY = 0; blockY < blocksY; blockY++)
+    {
+        for (uint32_t blockX = 0; blockX < blocksX; blockX++)
+        {
+            float texels[TEXEL_COUNT * 4];
+            decodeBlock(blocks + ((size_t)blockY * blocksX + blockX) * BLOCK_BYTES, texels);
+            for (uint32_t i = 0; i < TEXEL_COUNT; i++)
+            {
+                uint32_t x = blockX * BLOCK_SIZE + i % BLOCK_SIZE;
+                uint32_t y = blockY * BLOCK_SIZE + i / BLOCK_SIZE;
+                if (x < width && y < height)
+                {
+                    memcpy(pOutput + ((size_t)y * width + x) * 4, texels + i * 4, 4 * sizeof(float));
+                }
+            }
+        }
+    }
+}
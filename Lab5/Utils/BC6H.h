@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "ThreadPool.h"
+
+enum BC6HQuality
+{
+    // The 10-bit endpoint mode with endpoints from the principal axis of the block.
+    BC6H_QUALITY_FAST,
+    // Every single-region mode, refitting the endpoints to the indices they select a few times.
+    BC6H_QUALITY_HIGH
+};
+
+// BC6H_UF16, the layout of DXGI_FORMAT_BC6H_UF16: 16 bytes per 4x4 block of unsigned half-float RGB. The encoder
+// writes the four single-region modes and fits in half-float bit space, where the hardware interpolates. The decoder
+// reads those modes; two-region blocks, which the encoder never writes, decode to black like reserved modes.
+// Negative and NaN channels encode as zero, values above the largest half clamp to it, and alpha decodes as one.
+namespace BC6H
+{
+    const uint32_t BLOCK_SIZE = 4;
+    const uint32_t BLOCK_BYTES = 16;
+
+    // 16 RGBA32F texels, row by row.
+    void encodeBlock(const float* texels, BC6HQuality quality, uint8_t* pBlock);
+    void decodeBlock(const uint8_t* block, float* pTexels);
+
+    size_t getImageBytes(uint32_t width, uint32_t height);
+    // Blocks past the right or bottom edge repeat the last column or row. The thread pool may be null.
+    void encodeImage(const float* pixels, uint32_t width, uint32_t height, BC6HQuality quality,
+                     ThreadPool* threadPool, uint8_t* pOutput);
+    void decodeImage(const uint8_t* blocks, uint32_t width, uint32_t height, float* pOutput);
+}
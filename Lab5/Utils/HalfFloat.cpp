@@ -0,0 +1,81 @@
+#include "HalfFloat.h"
+
+#include <cstring>
+
+uint16_t HalfFloat::fromFloat(float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    uint32_t sign = (bits >> 16) & 0x8000u;
+    uint32_t exponent = (bits >> 23) & 0xFFu;
+    uint32_t mantissa = bits & 0x7FFFFFu;
+
+    if (exponent == 0xFFu)
+    {
+        return (uint16_t)(sign | 0x7C00u | (mantissa ? 0x200u : 0u));
+    }
+    int halfExponent = (int)exponent - 127 + 15;
+    if (halfExponent >= 0x1F)
+    {
+        return (uint16_t)(sign | 0x7C00u);
+    }
+    if (halfExponent <= 0)
+    {
+        if (halfExponent < -10)
+        {
+            return (uint16_t)sign;
+        }
+        // Denormal half: shift the implicit leading one into the mantissa.
+        mantissa |= 0x800000u;
+        uint32_t shift = (uint32_t)(14 - halfExponent);
+        uint32_t halfMantissa = mantissa >> shift;
+        uint32_t remainder = mantissa & ((1u << shift) - 1u);
+        uint32_t halfway = 1u << (shift - 1);
+        if (remainder > halfway || (remainder == halfway && (halfMantissa & 1u)))
+        {
+            halfMantissa++;
+        }
+        return (uint16_t)(sign | halfMantissa);
+    }
+    uint32_t half = sign | ((uint32_t)halfExponent << 10) | (mantissa >> 13);
+    uint32_t remainder = mantissa & 0x1FFFu;
+    if (remainder > 0x1000u || (remainder == 0x1000u && (half & 1u)))
+    {
+        // Carries into the exponent on overflow, which correctly rounds up to infinity.
+        half++;
+    }
+    return (uint16_t)half;
+}
+
+float HalfFloat::toFloat(uint16_t value)
+{
+    uint32_t sign = (uint32_t)(value & 0x8000u) << 16;
+    uint32_t exponent = (value >> 10) & 0x1Fu;
+    uint32_t mantissa = value & 0x3FFu;
+    uint32_t bits;
+    if (exponent == 0x1Fu)
+    {
+        bits = sign | 0x7F800000u | (mantissa << 13);
+    }
+    else if (exponent != 0)
+    {
+        bits = sign | ((exponent - 15 + 127) << 23) | (mantissa << 13);
+    }
+    else if (mantissa == 0)
+    {
+        bits = sign;
+    }
+    else
+    {
+        exponent = 127 - 15 + 1;
+        while (!(mantissa & 0x400u))
+        {
+            mantissa <<= 1;
+            exponent--;
+        }
+        bits = sign | (exponent << 23) | ((mantissa & 0x3FFu) << 13);
+    }
+    float result;
+    memcpy(&result, &bits, sizeof(result));
+    return result;
+}
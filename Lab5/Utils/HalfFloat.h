@@ -0,0 +1,9 @@
+#pragma once
+
+#include <cstdint>
+
+namespace HalfFloat
+{
+    uint16_t fromFloat(float value);
+    float toFloat(uint16_t value);
+}
@@ -0,0 +1,34 @@
+#include "HashUtils.h"
+
+#include <fstream>
+#include <vector>
+
+uint64_t HashUtils::hashBytes(const void* data, size_t size, uint64_t seed)
+{
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    uint64_t hash = seed;
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+bool HashUtils::hashFile(const std::string& path, uint64_t* pHashOut)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+    {
+        return false;
+    }
+    uint64_t hash = FNV_OFFSET_BASIS;
+    std::vector<char> chunk(1 << 16);
+    while (file)
+    {
+        file.read(chunk.data(), (std::streamsize)chunk.size());
+        hash = hashBytes(chunk.data(), (size_t)file.gcount(), hash);
+    }
+    *pHashOut = hash;
+    return true;
+}
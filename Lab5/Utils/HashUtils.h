@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace HashUtils
+{
+    const uint64_t FNV_OFFSET_BASIS = 14695981039346656037ull;
+
+    uint64_t hashBytes(const void* data, size_t size, uint64_t seed = FNV_OFFSET_BASIS);
+    bool hashFile(const std::string& path, uint64_t* pHashOut);
+}
@@ -0,0 +1,200 @@
+#include "ImageWriter.h"
+
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+#include "HalfFloat.h"
+
+namespace
+{
+    const uint32_t MAX_STORED_BLOCK = 65535;
+
+    void appendBigEndian(std::vector<uint8_t>* pBytes, uint32_t value)
+    {
+        for (int shift = 24; shift >= 0; shift -= 8)
+        {
+            pBytes->push_back((uint8_t)(value >> shift));
+        }
+    }
+
+    template <typename T>
+    void appendLittleEndian(std::vector<uint8_t>* pBytes, T value)
+    {
+        for (size_t i = 0; i < sizeof(T); i++)
+        {
+            pBytes->push_back((uint8_t)((uint64_t)value >> (i * 8)));
+        }
+    }
+
+    void appendString(std::vector<uint8_t>* pBytes, const char* text)
+    {
+        for (; *text; text++)
+        {
+            pBytes->push_back((uint8_t)*text);
+        }
+        pBytes->push_back(0);
+    }
+
+    uint32_t crc32(const uint8_t* data, size_t size)
+    {
+        static uint32_t table[256];
+        static bool tableReady = false;
+        if (!tableReady)
+        {
+            for (uint32_t i = 0; i < 256; i++)
+            {
+                uint32_t value = i;
+                for (int bit = 0; bit < 8; bit++)
+                {
+                    value = value & 1 ? 0xEDB88320u ^ (value >> 1) : value >> 1;
+                }
+                table[i] = value;
+            }
+            tableReady = true;
+        }
+        uint32_t crc = 0xFFFFFFFFu;
+        for (size_t i = 0; i < size; i++)
+        {
+            crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+        }
+        return crc ^ 0xFFFFFFFFu;
+    }
+
+    uint32_t adler32(const std::vector<uint8_t>& data)
+    {
+        uint32_t a = 1;
+        uint32_t b = 0;
+        for (uint8_t byte : data)
+        {
+            a = (a + byte) % 65521;
+            b = (b + a) % 65521;
+        }
+        return (b << 16) | a;
+    }
+
+    void appendChunk(std::vector<uint8_t>* pBytes, const char* type, const std::vector<uint8_t>& data)
+    {
+        appendBigEndian(pBytes, (uint32_t)data.size());
+        size_t start = pBytes->size();
+        pBytes->insert(pBytes->end(), type, type + 4);
+        pBytes->insert(pBytes->end(), data.begin(), data.end());
+        appendBigEndian(pBytes, crc32(pBytes->data() + start, pBytes->size() - start));
+    }
+
+    void writeFile(const std::string& path, const std::vector<uint8_t>& bytes)
+    {
+        std::ofstream file(path, std::ios::binary);
+        file.write((const char*)bytes.data(), bytes.size());
+        if (!file)
+        {
+            throw std::runtime_error("Failed to write image: " + path);
+        }
+    }
+}
+
+void ImageWriter::writePng(const std::string& path, uint32_t width, uint32_t height, const uint8_t* rgba)
+{
+    std::vector<uint8_t> scanlines;
+    scanlines.reserve(((size_t)width * 4 + 1) * height);
+    for (uint32_t y = 0; y < height; y++)
+    {
+        scanlines.push_back(0);
+        const uint8_t* row = rgba + (size_t)y * width * 4;
+        scanlines.insert(scanlines.end(), row, row + (size_t)width * 4);
+    }
+
+    std::vector<uint8_t> compressed = {0x78, 0x01};
+    for (size_t offset = 0; offset < scanlines.size() || offset == 0; offset += MAX_STORED_BLOCK)
+    {
+        uint32_t blockSize = (uint32_t)std::min<size_t>(scanlines.size() - offset, MAX_STORED_BLOCK);
+        compressed.push_back(offset + blockSize >= scanlines.size() ? 1 : 0);
+        appendLittleEndian<uint16_t>(&compressed, (uint16_t)blockSize);
+        appendLittleEndian<uint16_t>(&compressed, (uint16_t)~blockSize);
+        compressed.insert(compressed.end(), scanlines.begin() + offset, scanlines.begin() + offset + blockSize);
+    }
+    appendBigEndian(&compressed, adler32(scanlines));
+
+    std::vector<uint8_t> header;
+    appendBigEndian(&header, width);
+    appendBigEndian(&header, height);
+    // 8 bits per channel, RGBA, deflate, adaptive filtering, no interlace.
+    header.insert(header.end(), {8, 6, 0, 0, 0});
+
+    std::vector<uint8_t> bytes = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    appendChunk(&bytes, "IHDR", header);
+    appendChunk(&bytes, "IDAT", compressed);
+    appendChunk(&bytes, "IEND", std::vector<uint8_t>());
+    writeFile(path, bytes);
+}
+
+void ImageWriter::writeExr(const std::string& path, uint32_t width, uint32_t height, const float* rgba)
+{
+    std::vector<uint8_t> bytes;
+    appendLittleEndian<uint32_t>(&bytes, 20000630);
+    appendLittleEndian<uint32_t>(&bytes, 2);
+
+    // Channels are listed alphabetically, as the format requires; each is HALF with no subsampling.
+    std::vector<uint8_t> channels;
+    const char* names[4] = {"A", "B", "G", "R"};
+    for (const char* name : names)
+    {
+        appendString(&channels, name);
+        appendLittleEndian<uint32_t>(&channels, 1);
+        appendLittleEndian<uint32_t>(&channels, 0);
+        appendLittleEndian<uint32_t>(&channels, 1);
+        appendLittleEndian<uint32_t>(&channels, 1);
+    }
+    channels.push_back(0);
+
+    auto appendAttribute = [&bytes](const char* name, const char* type, const std::vector<uint8_t>& value)
+    {
+        appendString(&bytes, name);
+        appendString(&bytes, type);
+        appendLittleEndian<uint32_t>(&bytes, (uint32_t)value.size());
+        bytes.insert(bytes.end(), value.begin(), value.end());
+    };
+    std::vector<uint8_t> window;
+    appendLittleEndian<int32_t>(&window, 0);
+    appendLittleEndian<int32_t>(&window, 0);
+    appendLittleEndian<int32_t>(&window, (int32_t)width - 1);
+    appendLittleEndian<int32_t>(&window, (int32_t)height - 1);
+    std::vector<uint8_t> pixelAspectRatio;
+    float aspect = 1.0f;
+    const uint8_t* aspectBytes = (const uint8_t*)&aspect;
+    pixelAspectRatio.assign(aspectBytes, aspectBytes + sizeof(aspect));
+    std::vector<uint8_t> screenWindowCenter(8, 0);
+    std::vector<uint8_t> screenWindowWidth = pixelAspectRatio;
+
+    appendAttribute("channels", "chlist", channels);
+    appendAttribute("compression", "compression", std::vector<uint8_t>(1, 0));
+    appendAttribute("dataWindow", "box2i", window);
+    appendAttribute("displayWindow", "box2i", window);
+    appendAttribute("lineOrder", "lineOrder", std::vector<uint8_t>(1, 0));
+    appendAttribute("pixelAspectRatio", "float", pixelAspectRatio);
+    appendAttribute("screenWindowCenter", "v2f", screenWindowCenter);
+    appendAttribute("screenWindowWidth", "float", screenWindowWidth);
+    bytes.push_back(0);
+
+    uint32_t lineBytes = width * 4 * sizeof(uint16_t);
+    uint64_t offset = bytes.size() + (uint64_t)height * sizeof(uint64_t);
+    for (uint32_t y = 0; y < height; y++)
+    {
+        appendLittleEndian<uint64_t>(&bytes, offset + (uint64_t)y * (lineBytes + 8));
+    }
+    const uint32_t channelOrder[4] = {3, 2, 1, 0};
+    for (uint32_t y = 0; y < height; y++)
+    {
+        appendLittleEndian<int32_t>(&bytes, (int32_t)y);
+        appendLittleEndian<uint32_t>(&bytes, lineBytes);
+        for (uint32_t channel : channelOrder)
+        {
+            for (uint32_t x = 0; x < width; x++)
+            {
+                appendLittleEndian<uint16_t>(&bytes, HalfFloat::fromFloat(rgba[((size_t)y * width + x) * 4 + channel]));
+            }
+        }
+    }
+    writeFile(path, bytes);
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// Minimal writers for inspecting rendered frames without extra libraries. Both throw std::runtime_error when the
+// file cannot be written.
+namespace ImageWriter
+{
+    // 8-bit RGBA, rows top to bottom; stored with uncompressed deflate blocks.
+    void writePng(const std::string& path, uint32_t width, uint32_t height, const uint8_t* rgba);
+    // Float RGBA, rows top to bottom; written as uncompressed half-float scanlines.
+    void writeExr(const std::string& path, uint32_t width, uint32_t height, const float* rgba);
+}
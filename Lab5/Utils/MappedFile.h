@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// Read-only view of a whole file through the virtual memory system. Pages are read from the file cache the first
+// time they are touched and the view stays valid until close or destruction, so its bytes can be handed to an
+// upload without copying them first.
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile();
+
+    bool open(const std::string& path);
+    void close();
+
+    const uint8_t* getData() const;
+    uint64_t getSize() const;
+
+private:
+    const uint8_t* data = nullptr;
+    uint64_t size = 0;
+#ifdef _WIN32
+    void* fileHandle = nullptr;
+    void* mappingHandle = nullptr;
+#endif
+};
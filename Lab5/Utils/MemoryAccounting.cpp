@@ -0,0 +1,61 @@
+#include "MemoryAccounting.h"
+
+#include <algorithm>
+#include <mutex>
+
+namespace
+{
+    std::mutex ledgerMutex;
+    MemoryStats ledger;
+
+    MemoryCategoryStats& findCategory(const std::string& category)
+    {
+        for (auto& item : ledger.categories)
+        {
+            if (item.name == category)
+            {
+                return item;
+            }
+        }
+        MemoryCategoryStats item;
+        item.name = category;
+        ledger.categories.push_back(item);
+        return ledger.categories.back();
+    }
+}
+
+void MemoryAccounting::allocate(const std::string& category, uint64_t bytes)
+{
+    std::lock_guard<std::mutex> lock(ledgerMutex);
+    MemoryCategoryStats& item = findCategory(category);
+    item.currentBytes += bytes;
+    item.peakBytes = std::max(item.peakBytes, item.currentBytes);
+    ledger.currentBytes += bytes;
+    ledger.peakBytes = std::max(ledger.peakBytes, ledger.currentBytes);
+}
+
+void MemoryAccounting::release(const std::string& category, uint64_t bytes)
+{
+    std::lock_guard<std::mutex> lock(ledgerMutex);
+    MemoryCategoryStats& item = findCategory(category);
+    // Releases run from destructors, so an unbalanced one is clamped rather than thrown.
+    bytes = std::min(bytes, item.currentBytes);
+    item.currentBytes -= bytes;
+    ledger.currentBytes -= bytes;
+}
+
+MemoryStats MemoryAccounting::getStats()
+{
+    std::lock_guard<std::mutex> lock(ledgerMutex);
+    return ledger;
+}
+
+void MemoryAccounting::resetPeak()
+{
+    std::lock_guard<std::mutex> lock(ledgerMutex);
+    ledger.peakBytes = ledger.currentBytes;
+    for (auto& item : ledger.categories)
+    {
+        item.peakBytes = item.currentBytes;
+    }
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct MemoryCategoryStats
+{
+    std::string name;
+    uint64_t currentBytes = 0;
+    uint64_t peakBytes = 0;
+};
+
+struct MemoryStats
+{
+    uint64_t currentBytes = 0;
+    uint64_t peakBytes = 0;
+    std::vector<MemoryCategoryStats> categories;
+};
+
+// Process-wide ledger of GPU allocations. D3D11 does not report the size of a resource, so owners report the bytes
+// they derive from its description when they create and release it. Safe to call from several threads.
+class MemoryAccounting
+{
+public:
+    static void allocate(const std::string& category, uint64_t bytes);
+    static void release(const std::string& category, uint64_t bytes);
+    static MemoryStats getStats();
+    static void resetPeak();
+};
@@ -0,0 +1,87 @@
+#include "RingAllocator.h"
+
+#include <stdexcept>
+
+RingAllocator::RingAllocator(uint32_t capacity, uint32_t alignment)
+    : capacity(capacity),
+      alignment(alignment)
+{
+    if (alignment == 0 || (alignment & (alignment - 1)) != 0 || capacity % alignment != 0)
+    {
+        throw std::runtime_error("Failed to create ring allocator: alignment must be a power of two dividing capacity");
+    }
+}
+
+void RingAllocator::beginFrame()
+{
+    uint32_t frameSize = offset - frameStart;
+    if (frameSize > peakFrameSize)
+    {
+        peakFrameSize = frameSize;
+    }
+    if (capacity - offset < peakFrameSize)
+    {
+        offset = 0;
+        generation++;
+        discardPending = true;
+    }
+    frameStart = offset;
+}
+
+bool RingAllocator::allocate(uint32_t size, RingAllocation* pAllocation)
+{
+    uint32_t alignedSize = size == 0 ? alignment : (size + alignment - 1) & ~(alignment - 1);
+    if (alignedSize > capacity - offset)
+    {
+        return false;
+    }
+    pAllocation->offset = offset;
+    pAllocation->size = alignedSize;
+    pAllocation->discard = discardPending;
+    discardPending = false;
+    offset += alignedSize;
+    return true;
+}
+
+void RingAllocator::reset(uint32_t newCapacity)
+{
+    if (newCapacity % alignment != 0)
+    {
+        throw std::runtime_error("Failed to reset ring allocator: capacity is not a multiple of the alignment");
+    }
+    uint32_t frameSize = offset - frameStart;
+    if (frameSize > peakFrameSize)
+    {
+        peakFrameSize = frameSize;
+    }
+    capacity = newCapacity;
+    offset = 0;
+    frameStart = 0;
+    generation++;
+    discardPending = true;
+}
+
+uint32_t RingAllocator::getCapacity() const
+{
+    return capacity;
+}
+
+uint32_t RingAllocator::getAlignment() const
+{
+    return alignment;
+}
+
+uint32_t RingAllocator::getOffset() const
+{
+    return offset;
+}
+
+uint32_t RingAllocator::getFrameSize() const
+{
+    return offset - frameStart;
+}
+
+uint64_t RingAllocator::getGeneration() const
+{
+    return generation;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+
+struct RingAllocation
+{
+    uint32_t offset = 0;
+    uint32_t size = 0;
+    // The first allocation after a wrap must map with WRITE_DISCARD, every other one with NO_OVERWRITE.
+    bool discard = false;
+};
+
+// Linear sub-allocator over one upload buffer. It only wraps at a frame boundary, when the space left is smaller
+// than the largest frame seen so far, so ranges handed out earlier in the frame stay valid until it ends. Every wrap
+// or reset bumps the generation: allocations from an older generation no longer hold their data.
+class RingAllocator
+{
+public:
+    RingAllocator(uint32_t capacity, uint32_t alignment);
+
+private:
+    uint32_t capacity;
+    uint32_t alignment;
+    uint32_t offset = 0;
+    uint32_t frameStart = 0;
+    uint32_t peakFrameSize = 0;
+    uint64_t generation = 0;
+    bool discardPending = true;
+
+public:
+    void beginFrame();
+    // Returns false when the request does not fit in what is left of the buffer; the owner then has to replace the
+    // buffer and call reset().
+    bool allocate(uint32_t size, RingAllocation* pAllocation);
+    void reset(uint32_t newCapacity);
+
+    uint32_t getCapacity() const;
+    uint32_t getAlignment() const;
+    uint32_t getOffset() const;
+    uint32_t getFrameSize() const;
+    uint64_t getGeneration() const;
+};
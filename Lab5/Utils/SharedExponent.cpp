@@ -0,0 +1,52 @@
+#include "SharedExponent.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    const int MANTISSA_BITS = 9;
+    const int EXPONENT_BIAS = 15;
+    const int MAX_EXPONENT = 31;
+
+    float clampChannel(float value)
+    {
+        return value > 0.0f ? std::min(value, SharedExponent::MAX_VALUE) : 0.0f;
+    }
+}
+
+uint32_t SharedExponent::fromFloat3(float r, float g, float b)
+{
+    r = clampChannel(r);
+    g = clampChannel(g);
+    b = clampChannel(b);
+    float maxChannel = std::max(r, std::max(g, b));
+    if (maxChannel == 0.0f)
+    {
+        return 0;
+    }
+    // frexp returns maxChannel = fraction * 2^exponent with fraction in [0.5, 1), so exponent - 1 is floor(log2).
+    int exponent;
+    frexpf(maxChannel, &exponent);
+    int sharedExponent = std::max(exponent - 1, -EXPONENT_BIAS - 1) + 1 + EXPONENT_BIAS;
+    float scale = ldexpf(1.0f, EXPONENT_BIAS + MANTISSA_BITS - sharedExponent);
+    if ((uint32_t)floorf(maxChannel * scale + 0.5f) == 1u << MANTISSA_BITS)
+    {
+        // Rounding carried out of the mantissa; the next exponent represents it exactly.
+        sharedExponent++;
+        scale *= 0.5f;
+    }
+    sharedExponent = std::min(sharedExponent, MAX_EXPONENT);
+    uint32_t red = (uint32_t)floorf(r * scale + 0.5f);
+    uint32_t green = (uint32_t)floorf(g * scale + 0.5f);
+    uint32_t blue = (uint32_t)floorf(b * scale + 0.5f);
+    return red | (green << 9) | (blue << 18) | ((uint32_t)sharedExponent << 27);
+}
+
+void SharedExponent::toFloat3(uint32_t value, float* pRgbOut)
+{
+    float scale = ldexpf(1.0f, (int)(value >> 27) - EXPONENT_BIAS - MANTISSA_BITS);
+    pRgbOut[0] = (float)(value & 0x1FFu) * scale;
+    pRgbOut[1] = (float)((value >> 9) & 0x1FFu) * scale;
+    pRgbOut[2] = (float)((value >> 18) & 0x1FFu) * scale;
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstdint>
+
+// RGB9E5: three 9-bit mantissas sharing one 5-bit exponent, the layout of DXGI_FORMAT_R9G9B9E5_SHAREDEXP. Negative
+// and NaN channels encode as zero and values above MAX_VALUE clamp to it.
+namespace SharedExponent
+{
+    const float MAX_VALUE = 65408.0f;
+
+    uint32_t fromFloat3(float r, float g, float b);
+    void toFloat3(uint32_t value, float* pRgbOut);
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <vector>
+#include "ThreadPool.h"
+
+// Runs one task per distinct key on a ThreadPool and hands out handles to the results. Identical keys share a task,
+// so callers can request everything up front and collect results later in any order. Keys are enqueued from a single
+// thread; get() blocks until that result is ready and rethrows whatever the task threw.
+template <typename Key, typename Result>
+class TaskBatch
+{
+public:
+    using Handle = uint32_t;
+
+    TaskBatch(ThreadPool* threadPool, std::function<Result(const Key&)> task)
+        : threadPool(threadPool),
+          task(std::move(task))
+    {
+    }
+
+    TaskBatch(const TaskBatch&) = delete;
+    TaskBatch& operator=(const TaskBatch&) = delete;
+
+    Handle enqueue(const Key& key)
+    {
+        for (Handle handle = 0; handle < keys.size(); handle++)
+        {
+            if (keys[handle] == key)
+            {
+                return handle;
+            }
+        }
+        keys.push_back(key);
+        results.push_back(threadPool->submit([this, key]() { return task(key); }).share());
+        return (Handle)(keys.size() - 1);
+    }
+
+    const Result& get(Handle handle) const
+    {
+        return results[handle].get();
+    }
+
+    bool isReady(Handle handle) const
+    {
+        return results[handle].wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+    }
+
+    const Key& getKey(Handle handle) const
+    {
+        return keys[handle];
+    }
+
+    uint32_t getTaskCount() const
+    {
+        return (uint32_t)keys.size();
+    }
+
+    void wait() const
+    {
+        for (const auto& result : results)
+        {
+            result.wait();
+        }
+    }
+
+    ~TaskBatch()
+    {
+        // Tasks reference this batch, so none may outlive it.
+        wait();
+    }
+
+private:
+    ThreadPool* threadPool;
+    std::function<Result(const Key&)> task;
+    std::vector<Key> keys;
+    std::vector<std::shared_future<Result>> results;
+};
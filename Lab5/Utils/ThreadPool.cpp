@@ -0,0 +1,100 @@
+#include "ThreadPool.h"
+
+#include <atomic>
+
+ThreadPool::ThreadPool(uint32_t threadCount)
+{
+    if (!threadCount)
+    {
+        threadCount = std::thread::hardware_concurrency();
+    }
+    if (!threadCount)
+    {
+        threadCount = 1;
+    }
+    for (uint32_t i = 0; i < threadCount; i++)
+    {
+        workers.emplace_back(&ThreadPool::workerLoop, this);
+    }
+}
+
+void ThreadPool::parallelFor(uint32_t count, const std::function<void(uint32_t)>& body)
+{
+    if (!count)
+    {
+        return;
+    }
+    // The calling thread takes items too, so nested calls from a worker cannot starve the pool.
+    struct SharedState
+    {
+        std::atomic<uint32_t> nextIndex{0};
+        std::atomic<uint32_t> finishedIndices{0};
+        std::mutex doneMutex;
+        std::condition_variable doneCondition;
+    };
+    auto state = std::make_shared<SharedState>();
+    auto runItems = [state, count, &body]()
+    {
+        uint32_t index;
+        while ((index = state->nextIndex.fetch_add(1)) < count)
+        {
+            body(index);
+            if (state->finishedIndices.fetch_add(1) + 1 == count)
+            {
+                std::lock_guard<std::mutex> lock(state->doneMutex);
+                state->doneCondition.notify_all();
+            }
+        }
+    };
+
+    uint32_t helpers = count - 1 < getThreadCount() ? count - 1 : getThreadCount();
+    {
+        std::lock_guard<std::mutex> lock(tasksMutex);
+        for (uint32_t i = 0; i < helpers; i++)
+        {
+            tasks.emplace(runItems);
+        }
+    }
+    tasksCondition.notify_all();
+    runItems();
+
+    std::unique_lock<std::mutex> lock(state->doneMutex);
+    state->doneCondition.wait(lock, [&state, count]() { return state->finishedIndices.load() == count; });
+}
+
+uint32_t ThreadPool::getThreadCount() const
+{
+    return (uint32_t)workers.size();
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(tasksMutex);
+        stopping = true;
+    }
+    tasksCondition.notify_all();
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+}
+
+void ThreadPool::workerLoop()
+{
+    while (true)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(tasksMutex);
+            tasksCondition.wait(lock, [this]() { return stopping || !tasks.empty(); });
+            if (stopping && tasks.empty())
+            {
+                return;
+            }
+            task = std::move(tasks.front());
+            tasks.pop();
+        }
+        task();
+    }
+}
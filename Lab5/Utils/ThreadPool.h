@@ -0,0 +1,46 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+class ThreadPool
+{
+public:
+    explicit ThreadPool(uint32_t threadCount = 0);
+
+private:
+    std::vector<std::thread> workers;
+    std::queue<std::function<void()>> tasks;
+    std::mutex tasksMutex;
+    std::condition_variable tasksCondition;
+    bool stopping = false;
+
+public:
+    template <typename Task>
+    auto submit(Task&& task) -> std::future<decltype(task())>
+    {
+        using Result = decltype(task());
+        auto packagedTask = std::make_shared<std::packaged_task<Result()>>(std::forward<Task>(task));
+        std::future<Result> result = packagedTask->get_future();
+        {
+            std::lock_guard<std::mutex> lock(tasksMutex);
+            tasks.emplace([packagedTask]() { (*packagedTask)(); });
+        }
+        tasksCondition.notify_one();
+        return result;
+    }
+
+    void parallelFor(uint32_t count, const std::function<void(uint32_t)>& body);
+    uint32_t getThreadCount() const;
+    ~ThreadPool();
+
+private:
+    void workerLoop();
+};